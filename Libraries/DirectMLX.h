@@ -15,13 +15,33 @@
 
 #include <cstdint>
 #include <cassert>
+#include <cmath>
+#include <cstring>
 #include <vector>
 #include <array>
-#include <deque>
 #include <memory>
+#include <new>
 #include <utility>
 #include <type_traits>
 #include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <cstdio>
+#include <cstdlib>
+
+#ifndef _WIN32
+    #include <cerrno>
+    #include <system_error>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
 
 #if !DMLX_USE_ABSEIL
     #include <optional>
@@ -194,6 +214,243 @@ namespace dml
             T* m_begin = nullptr;
             T* m_end = nullptr;
         };
+
+        // A vector which stores up to N elements inline, and only allocates when it grows beyond them. Used as the
+        // SmallVector when Abseil isn't available, so that copying small tensor dimensions doesn't touch the heap.
+        // Elements must be trivially copyable.
+        template <typename T, size_t N>
+        class small_vector
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "small_vector requires trivially copyable elements");
+            static_assert(N > 0, "small_vector requires inline capacity");
+
+        public:
+            using value_type = T;
+            using size_type = size_t;
+            using difference_type = ptrdiff_t;
+            using reference = T&;
+            using const_reference = const T&;
+            using pointer = T*;
+            using const_pointer = const T*;
+            using iterator = T*;
+            using const_iterator = const T*;
+
+            small_vector() noexcept = default;
+
+            explicit small_vector(size_t count) : small_vector(count, T()) {}
+            small_vector(size_t count, const T& value) { assign(count, value); }
+            small_vector(std::initializer_list<T> values) { assign(values.begin(), values.end()); }
+
+            template <typename InputIt, typename = std::enable_if_t<!std::is_integral<InputIt>::value>>
+            small_vector(InputIt first, InputIt last) { assign(first, last); }
+
+            small_vector(const small_vector& other) { assign(other.begin(), other.end()); }
+            small_vector(small_vector&& other) noexcept { MoveFrom(other); }
+
+            ~small_vector() { Deallocate(); }
+
+            small_vector& operator=(const small_vector& other)
+            {
+                if (this != &other)
+                {
+                    assign(other.begin(), other.end());
+                }
+                return *this;
+            }
+
+            small_vector& operator=(small_vector&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    Deallocate();
+                    MoveFrom(other);
+                }
+                return *this;
+            }
+
+            small_vector& operator=(std::initializer_list<T> values)
+            {
+                assign(values.begin(), values.end());
+                return *this;
+            }
+
+            void assign(size_t count, const T& value)
+            {
+                m_size = 0;
+                reserve(count);
+                std::fill_n(m_data, count, value);
+                m_size = count;
+            }
+
+            template <typename InputIt, typename = std::enable_if_t<!std::is_integral<InputIt>::value>>
+            void assign(InputIt first, InputIt last)
+            {
+                m_size = 0;
+                reserve(static_cast<size_t>(std::distance(first, last)));
+                for (; first != last; ++first)
+                {
+                    m_data[m_size++] = *first;
+                }
+            }
+
+            void assign(std::initializer_list<T> values) { assign(values.begin(), values.end()); }
+
+            T* data() noexcept { return m_data; }
+            const T* data() const noexcept { return m_data; }
+            T* begin() noexcept { return m_data; }
+            const T* begin() const noexcept { return m_data; }
+            const T* cbegin() const noexcept { return m_data; }
+            T* end() noexcept { return m_data + m_size; }
+            const T* end() const noexcept { return m_data + m_size; }
+            const T* cend() const noexcept { return m_data + m_size; }
+
+            T& operator[](size_t index) noexcept { assert(index < m_size); return m_data[index]; }
+            const T& operator[](size_t index) const noexcept { assert(index < m_size); return m_data[index]; }
+            T& front() noexcept { return (*this)[0]; }
+            const T& front() const noexcept { return (*this)[0]; }
+            T& back() noexcept { return (*this)[m_size - 1]; }
+            const T& back() const noexcept { return (*this)[m_size - 1]; }
+
+            bool empty() const noexcept { return m_size == 0; }
+            size_t size() const noexcept { return m_size; }
+            size_t capacity() const noexcept { return m_capacity; }
+
+            void reserve(size_t capacity)
+            {
+                if (capacity <= m_capacity)
+                {
+                    return;
+                }
+
+                // Grow geometrically so that repeated push_back stays amortized constant time
+                capacity = std::max(capacity, m_capacity * 2);
+                T* data = static_cast<T*>(::operator new(capacity * sizeof(T)));
+                if (m_size > 0)
+                {
+                    memcpy(data, m_data, m_size * sizeof(T));
+                }
+
+                Deallocate();
+                m_data = data;
+                m_capacity = capacity;
+            }
+
+            void resize(size_t count) { resize(count, T()); }
+
+            void resize(size_t count, const T& value)
+            {
+                if (count > m_size)
+                {
+                    reserve(count);
+                    std::fill(m_data + m_size, m_data + count, value);
+                }
+                m_size = count;
+            }
+
+            void clear() noexcept { m_size = 0; }
+
+            void push_back(const T& value)
+            {
+                // Copied first, as value may refer to an element that reserve moves
+                T copy = value;
+                reserve(m_size + 1);
+                m_data[m_size++] = copy;
+            }
+
+            template <typename... Args>
+            T& emplace_back(Args&&... args)
+            {
+                push_back(T(std::forward<Args>(args)...));
+                return back();
+            }
+
+            void pop_back() noexcept { assert(m_size > 0); --m_size; }
+
+            T* insert(const T* position, const T& value)
+            {
+                return insert(position, &value, &value + 1);
+            }
+
+            template <typename InputIt, typename = std::enable_if_t<!std::is_integral<InputIt>::value>>
+            T* insert(const T* position, InputIt first, InputIt last)
+            {
+                // Buffered first, as the range may alias this vector's storage
+                small_vector values(first, last);
+                const size_t index = static_cast<size_t>(position - m_data);
+                const size_t count = values.size();
+
+                reserve(m_size + count);
+                memmove(m_data + index + count, m_data + index, (m_size - index) * sizeof(T));
+                memcpy(m_data + index, values.data(), count * sizeof(T));
+                m_size += count;
+                return m_data + index;
+            }
+
+            T* erase(const T* position) { return erase(position, position + 1); }
+
+            T* erase(const T* first, const T* last)
+            {
+                const size_t index = static_cast<size_t>(first - m_data);
+                const size_t count = static_cast<size_t>(last - first);
+                memmove(m_data + index, m_data + index + count, (m_size - index - count) * sizeof(T));
+                m_size -= count;
+                return m_data + index;
+            }
+
+            friend bool operator==(const small_vector& a, const small_vector& b)
+            {
+                return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+            }
+
+            friend bool operator!=(const small_vector& a, const small_vector& b) { return !(a == b); }
+
+            friend bool operator<(const small_vector& a, const small_vector& b)
+            {
+                return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+            }
+
+        private:
+            bool IsInline() const noexcept { return m_data == m_inline; }
+
+            void Deallocate() noexcept
+            {
+                if (!IsInline())
+                {
+                    ::operator delete(m_data);
+                }
+                m_data = m_inline;
+                m_capacity = N;
+            }
+
+            // Takes other's heap allocation, or copies its inline elements, and leaves other empty
+            void MoveFrom(small_vector& other) noexcept
+            {
+                if (other.IsInline())
+                {
+                    m_data = m_inline;
+                    m_capacity = N;
+                    if (other.m_size > 0)
+                    {
+                        memcpy(m_inline, other.m_inline, other.m_size * sizeof(T));
+                    }
+                }
+                else
+                {
+                    m_data = other.m_data;
+                    m_capacity = other.m_capacity;
+                    other.m_data = other.m_inline;
+                    other.m_capacity = N;
+                }
+
+                m_size = other.m_size;
+                other.m_size = 0;
+            }
+
+            T* m_data = m_inline;
+            size_t m_size = 0;
+            size_t m_capacity = N;
+            T m_inline[N];
+        };
     }
 
 #if DMLX_USE_ABSEIL 
@@ -215,8 +472,15 @@ namespace dml
 
     constexpr std::nullopt_t NullOpt = std::nullopt;
 
-    template <typename T, size_t N>
-    using SmallVector = std::vector<T>;
+    // DMLX_USE_STD_SMALL_VECTOR makes SmallVector a std::vector, as it was before small_vector was added. It only
+    // exists to measure the difference (see Tests/GraphConstructionBenchmark.cpp).
+    #if DMLX_USE_STD_SMALL_VECTOR
+        template <typename T, size_t N>
+        using SmallVector = std::vector<T>;
+    #else
+        template <typename T, size_t N>
+        using SmallVector = dml::detail::small_vector<T, N>;
+    #endif
 
     #if __cpp_lib_span
         template <typename T>
@@ -247,6 +511,10 @@ namespace dml
 
     class Graph;
     class Expression;
+    struct MemoryPlan;
+    struct GraphPartitionOptions;
+    struct GraphPartitionPlan;
+    struct GraphCost;
 
     using TensorDimensions = SmallVector<uint32_t, 4>;
 
@@ -487,2923 +755,11087 @@ namespace dml
         }
     };
 
+    // Operator desc schema. DML operator descs are plain structs which refer to tensor descs, arrays, and nested
+    // activation descs through pointers. The functions below enumerate the fields of each desc supported by DMLX so
+    // that descs can be deep-copied, compared and rewritten without knowing their concrete type.
     namespace detail
     {
-        class GraphBuilder;
-        class NodeOutput;
-
-        // A node in the graph which represents a graph input.
-        struct InputNode
+        inline uint32_t GetDataTypeSizeInBytes(DML_TENSOR_DATA_TYPE dataType)
         {
-            uint32_t inputIndex;
-        };
+            switch (dataType)
+            {
+            case DML_TENSOR_DATA_TYPE_UINT8:
+            case DML_TENSOR_DATA_TYPE_INT8:
+                return 1;
+            case DML_TENSOR_DATA_TYPE_FLOAT16:
+            case DML_TENSOR_DATA_TYPE_UINT16:
+            case DML_TENSOR_DATA_TYPE_INT16:
+                return 2;
+            case DML_TENSOR_DATA_TYPE_FLOAT32:
+            case DML_TENSOR_DATA_TYPE_UINT32:
+            case DML_TENSOR_DATA_TYPE_INT32:
+                return 4;
+            case DML_TENSOR_DATA_TYPE_FLOAT64:
+            case DML_TENSOR_DATA_TYPE_UINT64:
+            case DML_TENSOR_DATA_TYPE_INT64:
+                return 8;
+            default:
+                return 0;
+            }
+        }
 
-        // A node in the graph which represents a DML operator.
-        struct OperatorNode
+        // The number of meaningful bytes in a DML_SCALAR_UNION holding a value of the given type.
+        inline size_t GetScalarSizeInBytes(DML_TENSOR_DATA_TYPE dataType)
         {
-            Microsoft::WRL::ComPtr<IDMLOperator> op;
+            const uint32_t size = GetDataTypeSizeInBytes(dataType);
+            return size != 0 ? size : sizeof(DML_SCALAR_UNION);
+        }
 
-            // The inputs to this node
-            std::vector<NodeOutput*> inputs;
-        };
+        // Invokes `visitor` on each field of the desc, in declaration order. A visitor must provide:
+        //
+        //   InputTensor(const DML_TENSOR_DESC*& tensor)                  (tensor may be null for optional inputs)
+        //   OutputTensor(const DML_TENSOR_DESC*& tensor)                 (tensor may be null for optional outputs)
+        //   InputTensors(const DML_TENSOR_DESC*& tensors, UINT count)
+        //   OutputTensors(const DML_TENSOR_DESC*& tensors, UINT count)
+        //   Attribute(T& value)                                          (scalars, enums and by-value structs)
+        //   Array(const T*& values, UINT count)                          (UINT, INT and FLOAT arrays)
+        //   Scalar(DML_SCALAR_UNION& value, DML_TENSOR_DATA_TYPE type)   (only the first `type`-sized bytes are used)
+        //   ScaleBias(const DML_SCALE_BIAS*& scaleBias)                  (may be null)
+        //   Activation(const DML_OPERATOR_DESC*& activation)             (may be null)
+        //   Activations(const DML_OPERATOR_DESC*& activations, UINT count)
+        //
+        // Array counts are always visited (as attributes) before the arrays they describe.
+
+#define DMLX_UNARY_FIELDS(_name) \
+        template <typename Visitor> \
+        void VisitOperatorFields(DML_##_name##_OPERATOR_DESC& desc, Visitor& visitor) \
+        { \
+            visitor.InputTensor(desc.InputTensor); \
+            visitor.OutputTensor(desc.OutputTensor); \
+        }
 
-        // Used for representing reshapes and type punning
-        struct ReinterpretNode
-        {
-            NodeOutput* input;
-        };
+#define DMLX_UNARY_SCALE_BIAS_FIELDS(_name) \
+        template <typename Visitor> \
+        void VisitOperatorFields(DML_##_name##_OPERATOR_DESC& desc, Visitor& visitor) \
+        { \
+            visitor.InputTensor(desc.InputTensor); \
+            visitor.OutputTensor(desc.OutputTensor); \
+            visitor.ScaleBias(desc.ScaleBias); \
+        }
 
-        enum class NodeType
-        {
-            Invalid,
-            Input,
-            Operator,
-            Reinterpret,
-        };
+#define DMLX_BINARY_FIELDS(_name) \
+        template <typename Visitor> \
+        void VisitOperatorFields(DML_##_name##_OPERATOR_DESC& desc, Visitor& visitor) \
+        { \
+            visitor.InputTensor(desc.ATensor); \
+            visitor.InputTensor(desc.BTensor); \
+            visitor.OutputTensor(desc.OutputTensor); \
+        }
 
-        // Identifies a node in the graph.
-        struct NodeID
+#define DMLX_ACTIVATION_FIELDS_1(_name, _param1Name) \
+        template <typename Visitor> \
+        void VisitOperatorFields(DML_##_name##_OPERATOR_DESC& desc, Visitor& visitor) \
+        { \
+            visitor.InputTensor(desc.InputTensor); \
+            visitor.OutputTensor(desc.OutputTensor); \
+            visitor.Attribute(desc._param1Name); \
+        }
+
+#define DMLX_ACTIVATION_FIELDS_2(_name, _param1Name, _param2Name) \
+        template <typename Visitor> \
+        void VisitOperatorFields(DML_##_name##_OPERATOR_DESC& desc, Visitor& visitor) \
+        { \
+            visitor.InputTensor(desc.InputTensor); \
+            visitor.OutputTensor(desc.OutputTensor); \
+            visitor.Attribute(desc._param1Name); \
+            visitor.Attribute(desc._param2Name); \
+        }
+
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_IDENTITY)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_ABS)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_ACOS)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_ASIN)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_ATAN)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_CEIL)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_COS)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_EXP)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_FLOOR)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_LOG)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_RECIP)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_SIN)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_SQRT)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_TAN)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_ERF)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_SINH)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_COSH)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_TANH)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_ASINH)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_ACOSH)
+        DMLX_UNARY_SCALE_BIAS_FIELDS(ELEMENT_WISE_ATANH)
+
+        DMLX_UNARY_FIELDS(ELEMENT_WISE_LOGICAL_NOT)
+        DMLX_UNARY_FIELDS(ELEMENT_WISE_SIGN)
+        DMLX_UNARY_FIELDS(ELEMENT_WISE_IS_NAN)
+        DMLX_UNARY_FIELDS(ELEMENT_WISE_BIT_NOT)
+        DMLX_UNARY_FIELDS(ELEMENT_WISE_BIT_COUNT)
+        DMLX_UNARY_FIELDS(CAST)
+
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_DIVIDE)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_LOGICAL_AND)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_LOGICAL_EQUALS)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_LOGICAL_GREATER_THAN)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_LOGICAL_GREATER_THAN_OR_EQUAL)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_LOGICAL_LESS_THAN)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_LOGICAL_LESS_THAN_OR_EQUAL)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_LOGICAL_OR)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_LOGICAL_XOR)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_MAX)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_MEAN)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_MIN)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_MULTIPLY)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_SUBTRACT)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_BIT_SHIFT_LEFT)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_BIT_SHIFT_RIGHT)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_BIT_AND)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_BIT_OR)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_BIT_XOR)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_MODULUS_TRUNCATE)
+        DMLX_BINARY_FIELDS(ELEMENT_WISE_MODULUS_FLOOR)
+
+        DMLX_UNARY_FIELDS(ACTIVATION_HARDMAX)
+        DMLX_UNARY_FIELDS(ACTIVATION_IDENTITY)
+        DMLX_UNARY_FIELDS(ACTIVATION_LOG_SOFTMAX)
+        DMLX_UNARY_FIELDS(ACTIVATION_RELU)
+        DMLX_UNARY_FIELDS(ACTIVATION_SIGMOID)
+        DMLX_UNARY_FIELDS(ACTIVATION_SOFTMAX)
+        DMLX_UNARY_FIELDS(ACTIVATION_SOFTSIGN)
+        DMLX_UNARY_FIELDS(ACTIVATION_TANH)
+        DMLX_ACTIVATION_FIELDS_1(ACTIVATION_ELU, Alpha)
+        DMLX_ACTIVATION_FIELDS_1(ACTIVATION_LEAKY_RELU, Alpha)
+        DMLX_ACTIVATION_FIELDS_1(ACTIVATION_SOFTPLUS, Steepness)
+        DMLX_ACTIVATION_FIELDS_1(ACTIVATION_THRESHOLDED_RELU, Alpha)
+        DMLX_ACTIVATION_FIELDS_1(ACTIVATION_CELU, Alpha)
+        DMLX_ACTIVATION_FIELDS_2(ACTIVATION_HARD_SIGMOID, Alpha, Beta)
+        DMLX_ACTIVATION_FIELDS_2(ACTIVATION_LINEAR, Alpha, Beta)
+        DMLX_ACTIVATION_FIELDS_2(ACTIVATION_PARAMETRIC_SOFTPLUS, Alpha, Beta)
+        DMLX_ACTIVATION_FIELDS_2(ACTIVATION_SCALED_ELU, Alpha, Gamma)
+        DMLX_ACTIVATION_FIELDS_2(ACTIVATION_SCALED_TANH, Alpha, Beta)
+        DMLX_ACTIVATION_FIELDS_2(ACTIVATION_SHRINK, Bias, Threshold)
+
+#undef DMLX_UNARY_FIELDS
+#undef DMLX_UNARY_SCALE_BIAS_FIELDS
+#undef DMLX_BINARY_FIELDS
+#undef DMLX_ACTIVATION_FIELDS_1
+#undef DMLX_ACTIVATION_FIELDS_2
+
+        template <typename Visitor>
+        void VisitOperatorFields(DML_ELEMENT_WISE_ADD1_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            NodeType type;
-            uint32_t index; // The index of this node in the GraphBuilder
-        };
+            visitor.InputTensor(desc.ATensor);
+            visitor.InputTensor(desc.BTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Activation(desc.FusedActivation);
+        }
 
-        // Represents one of the outputs of a node.
-        class NodeOutput
+        template <typename Visitor>
+        void VisitOperatorFields(DML_ELEMENT_WISE_CLIP_OPERATOR_DESC& desc, Visitor& visitor)
         {
-        public:
-            NodeOutput(GraphBuilder* owner, NodeID node, uint32_t outputIndex, TensorDesc tensorDesc)
-                : m_owner(owner)
-                , m_node(node)
-                , m_outputIndex(outputIndex)
-                , m_tensorDesc(std::move(tensorDesc))
-            {}
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.ScaleBias(desc.ScaleBias);
+            visitor.Attribute(desc.Min);
+            visitor.Attribute(desc.Max);
+        }
 
-            // Retrieves the GraphBuilder that owns this object.
-            GraphBuilder* GetGraphBuilder() const { return m_owner; }
+        template <typename Visitor>
+        void VisitOperatorFields(DML_ELEMENT_WISE_THRESHOLD_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.ScaleBias(desc.ScaleBias);
+            visitor.Attribute(desc.Min);
+        }
 
-            NodeID GetNode() const { return m_node; }
-            uint32_t GetOutputIndex() const { return m_outputIndex; }
-            const TensorDesc& GetOutputDesc() const { return m_tensorDesc; }
+        template <typename Visitor>
+        void VisitOperatorFields(DML_ELEMENT_WISE_CONSTANT_POW_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.ScaleBias(desc.ScaleBias);
+            visitor.Attribute(desc.Exponent);
+        }
 
-        private:
-            GraphBuilder* m_owner;
-            NodeID m_node;
+        template <typename Visitor>
+        void VisitOperatorFields(DML_ELEMENT_WISE_POW_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.InputTensor(desc.ExponentTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.ScaleBias(desc.ScaleBias);
+        }
 
-            // An operator can have multiple outputs; this index identifies which one of the operator's  outputs this
-            // NodeOutput represents.
-            uint32_t m_outputIndex;
+        template <typename Visitor>
+        void VisitOperatorFields(DML_ELEMENT_WISE_QUANTIZE_LINEAR_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.InputTensor(desc.ScaleTensor);
+            visitor.InputTensor(desc.ZeroPointTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+        }
 
-            TensorDesc m_tensorDesc;
-        };
+        template <typename Visitor>
+        void VisitOperatorFields(DML_ELEMENT_WISE_DEQUANTIZE_LINEAR_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.InputTensor(desc.ScaleTensor);
+            visitor.InputTensor(desc.ZeroPointTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+        }
 
-        struct GraphDesc
+        template <typename Visitor>
+        void VisitOperatorFields(DML_ELEMENT_WISE_IF_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            uint32_t inputCount;
-            uint32_t outputCount;
-            std::vector<DML_OPERATOR_GRAPH_NODE_DESC> nodes;
-            std::vector<DML_INPUT_GRAPH_EDGE_DESC> inputEdges;
-            std::vector<DML_OUTPUT_GRAPH_EDGE_DESC> outputEdges;
-            std::vector<DML_INTERMEDIATE_GRAPH_EDGE_DESC> intermediateEdges;
-        };
+            visitor.InputTensor(desc.ConditionTensor);
+            visitor.InputTensor(desc.ATensor);
+            visitor.InputTensor(desc.BTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+        }
 
-        class GraphBuilder
+        template <typename Visitor>
+        void VisitOperatorFields(DML_ELEMENT_WISE_ROUND_OPERATOR_DESC& desc, Visitor& visitor)
         {
-        public:
-            GraphBuilder(IDMLDevice* device, TensorPolicy tensorPolicy = {})
-                : m_device(device)
-                , m_tensorPolicy(tensorPolicy)
-            {}
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.RoundingMode);
+        }
 
-            IDMLDevice* GetDevice() const
-            {
-                return m_device.Get();
-            }
+        template <typename Visitor>
+        void VisitOperatorFields(DML_ELEMENT_WISE_IS_INFINITY_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.InfinityMode);
+        }
 
-            void SetTensorPolicy(TensorPolicy policy) { m_tensorPolicy = std::move(policy); }
-            const TensorPolicy& GetTensorPolicy() const { return m_tensorPolicy; }
-            TensorPolicy& GetTensorPolicy() { return m_tensorPolicy; }
+        template <typename Visitor>
+        void VisitOperatorFields(DML_ACTIVATION_PARAMETERIZED_RELU_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.InputTensor(desc.SlopeTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+        }
 
-            // Creates a DML operator node owned by this graph builder and returns a NodeInfo identifier. The
-            // inputs to this node must be supplied in the correct order matching the DML operator.
-            NodeID CreateOperatorNode(DML_OPERATOR_TYPE type, const void* desc, Span<NodeOutput* const> inputs);
-            NodeID CreateInputNode(uint32_t inputIndex);
-            NodeID CreateReinterpretNode(NodeOutput* input);
-            NodeOutput* CreateNodeOutput(NodeID node, uint32_t outputIndex, TensorDesc tensorDesc);
-            GraphDesc GetGraphDesc(Span<const Expression> outputs) const;
+        template <typename Visitor>
+        void VisitOperatorFields(DML_CONVOLUTION_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.InputTensor(desc.FilterTensor);
+            visitor.InputTensor(desc.BiasTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.Mode);
+            visitor.Attribute(desc.Direction);
+            visitor.Attribute(desc.DimensionCount);
+            visitor.Array(desc.Strides, desc.DimensionCount);
+            visitor.Array(desc.Dilations, desc.DimensionCount);
+            visitor.Array(desc.StartPadding, desc.DimensionCount);
+            visitor.Array(desc.EndPadding, desc.DimensionCount);
+            visitor.Array(desc.OutputPadding, desc.DimensionCount);
+            visitor.Attribute(desc.GroupCount);
+            visitor.Activation(desc.FusedActivation);
+        }
 
-        private:
-            Microsoft::WRL::ComPtr<IDMLDevice> m_device;
-            TensorPolicy m_tensorPolicy;
-            std::vector<InputNode> m_inputNodes;
-            std::vector<OperatorNode> m_operatorNodes;
-            std::vector<ReinterpretNode> m_reinterpretNodes;
-            std::deque<NodeOutput> m_nodeOutputs; // deque doesn't invalidate references to elements when it resizes
-        };
+        template <typename Visitor>
+        void VisitOperatorFields(DML_GEMM_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.ATensor);
+            visitor.InputTensor(desc.BTensor);
+            visitor.InputTensor(desc.CTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.TransA);
+            visitor.Attribute(desc.TransB);
+            visitor.Attribute(desc.Alpha);
+            visitor.Attribute(desc.Beta);
+            visitor.Activation(desc.FusedActivation);
+        }
 
-    } // namespace detail
+        template <typename Visitor>
+        void VisitOperatorFields(DML_REDUCE_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.Attribute(desc.Function);
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.AxisCount);
+            visitor.Array(desc.Axes, desc.AxisCount);
+        }
 
-    class Expression
-    {
-    public:
-        /*implicit*/ Expression(detail::NodeOutput* nodeOutput = nullptr)
-            : m_nodeOutput(nodeOutput)
-        {}
+        template <typename Visitor>
+        void VisitOperatorFields(DML_AVERAGE_POOLING_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.DimensionCount);
+            visitor.Array(desc.Strides, desc.DimensionCount);
+            visitor.Array(desc.WindowSize, desc.DimensionCount);
+            visitor.Array(desc.StartPadding, desc.DimensionCount);
+            visitor.Array(desc.EndPadding, desc.DimensionCount);
+            visitor.Attribute(desc.IncludePadding);
+        }
 
-        // Returns a struct containing the required properties of the tensor to hold the output of this expression,
-        // once evaluated.
-        const TensorDesc& GetOutputDesc() const { return Impl()->GetOutputDesc(); }
+        template <typename Visitor>
+        void VisitOperatorFields(DML_MAX_POOLING2_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.OutputTensor(desc.OutputIndicesTensor);
+            visitor.Attribute(desc.DimensionCount);
+            visitor.Array(desc.Strides, desc.DimensionCount);
+            visitor.Array(desc.WindowSize, desc.DimensionCount);
+            visitor.Array(desc.StartPadding, desc.DimensionCount);
+            visitor.Array(desc.EndPadding, desc.DimensionCount);
+            visitor.Array(desc.Dilations, desc.DimensionCount);
+        }
 
-        // For internal use only
-        detail::NodeOutput* Impl() const { return m_nodeOutput; }
+        template <typename Visitor>
+        void VisitOperatorFields(DML_SLICE1_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.DimensionCount);
+            visitor.Array(desc.InputWindowOffsets, desc.DimensionCount);
+            visitor.Array(desc.InputWindowSizes, desc.DimensionCount);
+            visitor.Array(desc.InputWindowStrides, desc.DimensionCount);
+        }
 
-    private:
-        detail::NodeOutput* m_nodeOutput; // weak; this is owned by the GraphBuilder
-    };
+        template <typename Visitor>
+        void VisitOperatorFields(DML_SPLIT_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.Attribute(desc.OutputCount);
+            visitor.OutputTensors(desc.OutputTensors, desc.OutputCount);
+            visitor.Attribute(desc.Axis);
+        }
 
-    class Graph
-    {
-    public:
-        explicit Graph(IDMLDevice* device, TensorPolicy tensorPolicy = {})
-            : m_graphBuilder(make_unique<detail::GraphBuilder>(device, tensorPolicy))
-        {}
+        template <typename Visitor>
+        void VisitOperatorFields(DML_JOIN_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.Attribute(desc.InputCount);
+            visitor.InputTensors(desc.InputTensors, desc.InputCount);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.Axis);
+        }
 
-        // For internal use only
-        detail::GraphBuilder* Impl() { return m_graphBuilder.get(); }
+        template <typename Visitor>
+        void VisitOperatorFields(DML_PADDING_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.PaddingMode);
+            visitor.Attribute(desc.PaddingValue);
+            visitor.Attribute(desc.DimensionCount);
+            visitor.Array(desc.StartPadding, desc.DimensionCount);
+            visitor.Array(desc.EndPadding, desc.DimensionCount);
+        }
 
-        // Sets/gets the tensor policy. If not set, defaults to TensorPolicy::Default(). Tensor policies can be used
-        // to control properties (such as strides) on output tensors produced by this Graph.
-        void SetTensorPolicy(TensorPolicy policy) { m_graphBuilder->SetTensorPolicy(std::move(policy)); }
-        const TensorPolicy& GetTensorPolicy() const { return m_graphBuilder->GetTensorPolicy(); }
-        TensorPolicy& GetTensorPolicy() { return m_graphBuilder->GetTensorPolicy(); }
+        template <typename Visitor>
+        void VisitOperatorFields(DML_VALUE_SCALE_2D_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.Scale);
+            visitor.Attribute(desc.ChannelCount);
+            visitor.Array(desc.Bias, desc.ChannelCount);
+        }
 
-        Microsoft::WRL::ComPtr<IDMLCompiledOperator> Compile(
-            DML_EXECUTION_FLAGS flags,
-            Span<const Expression> outputs) const
+        template <typename Visitor>
+        void VisitOperatorFields(DML_UPSAMPLE_2D_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            detail::GraphDesc graph = m_graphBuilder->GetGraphDesc(outputs);
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.ScaleSize);
+            visitor.Attribute(desc.InterpolationMode);
+        }
 
-            std::vector<DML_GRAPH_NODE_DESC> graphNodes(graph.nodes.size());
-            for (size_t i = 0; i < graphNodes.size(); ++i)
-            {
-                graphNodes[i] = { DML_GRAPH_NODE_TYPE_OPERATOR, &graph.nodes[i] };
-            }
-
-            std::vector<DML_GRAPH_EDGE_DESC> inputEdges(graph.inputEdges.size());
-            for (size_t i = 0; i < inputEdges.size(); ++i)
-            {
-                inputEdges[i] = { DML_GRAPH_EDGE_TYPE_INPUT, &graph.inputEdges[i] };
-            }
-
-            std::vector<DML_GRAPH_EDGE_DESC> outputEdges(graph.outputEdges.size());
-            for (size_t i = 0; i < outputEdges.size(); ++i)
-            {
-                outputEdges[i] = { DML_GRAPH_EDGE_TYPE_OUTPUT, &graph.outputEdges[i] };
-            }
-
-            std::vector<DML_GRAPH_EDGE_DESC> intermediateEdges(graph.intermediateEdges.size());
-            for (size_t i = 0; i < intermediateEdges.size(); ++i)
-            {
-                intermediateEdges[i] = { DML_GRAPH_EDGE_TYPE_INTERMEDIATE, &graph.intermediateEdges[i] };
-            }
-
-            DML_GRAPH_DESC graphDesc = {};
-            graphDesc.InputCount = graph.inputCount;
-            graphDesc.OutputCount = graph.outputCount;
-            graphDesc.NodeCount = static_cast<UINT>(graphNodes.size());
-            graphDesc.Nodes = graphNodes.data();
-            graphDesc.InputEdgeCount = static_cast<UINT>(inputEdges.size());
-            graphDesc.InputEdges = inputEdges.data();
-            graphDesc.OutputEdgeCount = static_cast<UINT>(outputEdges.size());
-            graphDesc.OutputEdges = outputEdges.data();
-            graphDesc.IntermediateEdgeCount = static_cast<UINT>(intermediateEdges.size());
-            graphDesc.IntermediateEdges = intermediateEdges.data();
-
-            Microsoft::WRL::ComPtr<IDMLDevice1> device1;
-            DMLX_THROW_IF_FAILED(m_graphBuilder->GetDevice()->QueryInterface(IID_PPV_ARGS(&device1)));
-
-            Microsoft::WRL::ComPtr<IDMLCompiledOperator> compiledGraph;
-            DMLX_THROW_IF_FAILED(device1->CompileGraph(&graphDesc, flags, IID_PPV_ARGS(&compiledGraph)));
-
-            return compiledGraph;
+        template <typename Visitor>
+        void VisitOperatorFields(DML_GATHER_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.InputTensor(desc.IndicesTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.Axis);
+            visitor.Attribute(desc.IndexDimensions);
         }
 
-    private:
-        std::unique_ptr<detail::GraphBuilder> m_graphBuilder;
-    };
-
-    // Represents an activation to be fused with an existing operator. The meaning of param1 and param2 depend on the
-    // activation to be fused.
-    // 
-    // For HARD_SIGMOID, LINEAR, PARAMETRIC_SOFTPLUS, and SCALED_TANH: param1 = Alpha and param2 = Beta
-    // For ELU, LEAKY_RELU, THRESHOLDED_RELU, and CELU: param1 = Alpha. param2 is unused.
-    // For SCALED_ELU, param1 = Alpha and param2 = Gamma.
-    // For SHRINK, param1 = Bias and param2 = Threshold
-    // For SOFTPLUS, param1 = Steepness.
-    // For all other activations, both param1 and param2 are unused.
-    struct FusedActivation
-    {
-        DML_OPERATOR_TYPE activation = DML_OPERATOR_INVALID;
-        float param1 = 0.0f;
-        float param2 = 0.0f;
-
-        FusedActivation() = default;
-
-        explicit FusedActivation(DML_OPERATOR_TYPE activation, float param1 = 0.0f, float param2 = 0.0f)
-            : activation(activation), param1(param1), param2(param2)
-        {}
+        template <typename Visitor>
+        void VisitOperatorFields(DML_GATHER_ELEMENTS_OPERATOR_DESC& desc, Visitor& visitor)
+        {
+            visitor.InputTensor(desc.InputTensor);
+            visitor.InputTensor(desc.IndicesTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.Axis);
+        }
 
-        static FusedActivation None()
+        template <typename Visitor>
+        void VisitOperatorFields(DML_SCATTER_ELEMENTS_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            return FusedActivation();
+            visitor.InputTensor(desc.InputTensor);
+            visitor.InputTensor(desc.IndicesTensor);
+            visitor.InputTensor(desc.UpdatesTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.Axis);
         }
 
-        static FusedActivation Elu(float alpha = 1.0f)
+        template <typename Visitor>
+        void VisitOperatorFields(DML_SCATTER_ND_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_ELU, alpha);
+            visitor.InputTensor(desc.InputTensor);
+            visitor.InputTensor(desc.IndicesTensor);
+            visitor.InputTensor(desc.UpdatesTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.InputDimensionCount);
+            visitor.Attribute(desc.IndicesDimensionCount);
         }
 
-        static FusedActivation HardSigmoid(float alpha = 0.2f, float beta = 0.5f)
+        template <typename Visitor>
+        void VisitOperatorFields(DML_TILE_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_HARD_SIGMOID, alpha, beta);
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.RepeatsCount);
+            visitor.Array(desc.Repeats, desc.RepeatsCount);
         }
 
-        static FusedActivation Identity()
+        template <typename Visitor>
+        void VisitOperatorFields(DML_BATCH_NORMALIZATION_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_IDENTITY);
+            visitor.InputTensor(desc.InputTensor);
+            visitor.InputTensor(desc.MeanTensor);
+            visitor.InputTensor(desc.VarianceTensor);
+            visitor.InputTensor(desc.ScaleTensor);
+            visitor.InputTensor(desc.BiasTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.Spatial);
+            visitor.Attribute(desc.Epsilon);
+            visitor.Activation(desc.FusedActivation);
         }
 
-        static FusedActivation LeakyRelu(float alpha = 0.01f)
+        template <typename Visitor>
+        void VisitOperatorFields(DML_MEAN_VARIANCE_NORMALIZATION1_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_LEAKY_RELU, alpha);
+            visitor.InputTensor(desc.InputTensor);
+            visitor.InputTensor(desc.ScaleTensor);
+            visitor.InputTensor(desc.BiasTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.AxisCount);
+            visitor.Array(desc.Axes, desc.AxisCount);
+            visitor.Attribute(desc.NormalizeVariance);
+            visitor.Attribute(desc.Epsilon);
+            visitor.Activation(desc.FusedActivation);
         }
 
-        static FusedActivation Linear(float alpha, float beta)
+        template <typename Visitor>
+        void VisitOperatorFields(DML_LOCAL_RESPONSE_NORMALIZATION_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_LINEAR, alpha, beta);
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.CrossChannel);
+            visitor.Attribute(desc.LocalSize);
+            visitor.Attribute(desc.Alpha);
+            visitor.Attribute(desc.Beta);
+            visitor.Attribute(desc.Bias);
         }
 
-        static FusedActivation ParametricSoftplus(float alpha, float beta)
+        template <typename Visitor>
+        void VisitOperatorFields(DML_GRU_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_PARAMETRIC_SOFTPLUS, alpha, beta);
+            visitor.InputTensor(desc.InputTensor);
+            visitor.InputTensor(desc.WeightTensor);
+            visitor.InputTensor(desc.RecurrenceTensor);
+            visitor.InputTensor(desc.BiasTensor);
+            visitor.InputTensor(desc.HiddenInitTensor);
+            visitor.InputTensor(desc.SequenceLengthsTensor);
+            visitor.OutputTensor(desc.OutputSequenceTensor);
+            visitor.OutputTensor(desc.OutputSingleTensor);
+            visitor.Attribute(desc.ActivationDescCount);
+            visitor.Activations(desc.ActivationDescs, desc.ActivationDescCount);
+            visitor.Attribute(desc.Direction);
+            visitor.Attribute(desc.LinearBeforeReset);
         }
 
-        static FusedActivation Relu()
+        template <typename Visitor>
+        void VisitOperatorFields(DML_ONE_HOT_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_RELU);
+            visitor.InputTensor(desc.IndicesTensor);
+            visitor.InputTensor(desc.ValuesTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.Axis);
         }
 
-        static FusedActivation ScaledElu(float alpha = 1.67326319217681884765625f, float gamma = 1.05070102214813232421875f)
+        template <typename Visitor>
+        void VisitOperatorFields(DML_RESAMPLE1_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_SCALED_ELU, alpha, gamma);
+            visitor.InputTensor(desc.InputTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.InterpolationMode);
+            visitor.Attribute(desc.DimensionCount);
+            visitor.Array(desc.Scales, desc.DimensionCount);
+            visitor.Array(desc.InputPixelOffsets, desc.DimensionCount);
+            visitor.Array(desc.OutputPixelOffsets, desc.DimensionCount);
         }
 
-        static FusedActivation ScaledTanh(float alpha = 1.0f, float beta = 0.5f)
+        template <typename Visitor>
+        void VisitOperatorFields(DML_FILL_VALUE_CONSTANT_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_SCALED_TANH, alpha, beta);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.ValueDataType);
+            visitor.Scalar(desc.Value, desc.ValueDataType);
         }
 
-        static FusedActivation Sigmoid()
+        template <typename Visitor>
+        void VisitOperatorFields(DML_FILL_VALUE_SEQUENCE_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_SIGMOID);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.ValueDataType);
+            visitor.Scalar(desc.ValueStart, desc.ValueDataType);
+            visitor.Scalar(desc.ValueDelta, desc.ValueDataType);
         }
 
-        static FusedActivation Softplus(float steepness = 1.0f)
+        template <typename Visitor>
+        void VisitOperatorFields(DML_REVERSE_SUBSEQUENCES_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_SOFTPLUS, steepness);
+            visitor.InputTensor(desc.InputTensor);
+            visitor.InputTensor(desc.SequenceLengthsTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.Attribute(desc.Axis);
         }
 
-        static FusedActivation Softsign()
+        template <typename Visitor>
+        void VisitOperatorFields(DML_RANDOM_GENERATOR_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_SOFTSIGN);
+            visitor.InputTensor(desc.InputStateTensor);
+            visitor.OutputTensor(desc.OutputTensor);
+            visitor.OutputTensor(desc.OutputStateTensor);
+            visitor.Attribute(desc.Type);
         }
 
-        static FusedActivation Tanh()
+        template <typename Visitor>
+        void VisitOperatorFields(DML_RESAMPLE_GRAD_OPERATOR_DESC& desc, Visitor& visitor)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_TANH);
+            visitor.InputTensor(desc.InputGradientTensor);
+            visitor.OutputTensor(desc.OutputGradientTensor);
+            visitor.Attribute(desc.InterpolationMode);
+            visitor.Attribute(desc.DimensionCount);
+            visitor.Array(desc.Scales, desc.DimensionCount);
+            visitor.Array(desc.InputPixelOffsets, desc.DimensionCount);
+            visitor.Array(desc.OutputPixelOffsets, desc.DimensionCount);
         }
 
-        static FusedActivation ThresholdedRelu(float alpha = 1.0f)
+        // The operator types with a schema above. Each entry X(name) corresponds to DML_OPERATOR_##name and
+        // DML_##name##_OPERATOR_DESC.
+#define DMLX_SCHEMA_OPERATOR_TYPES(X) \
+        X(ELEMENT_WISE_IDENTITY) X(ELEMENT_WISE_ABS) X(ELEMENT_WISE_ACOS) X(ELEMENT_WISE_ADD1) X(ELEMENT_WISE_ASIN) \
+        X(ELEMENT_WISE_ATAN) X(ELEMENT_WISE_CEIL) X(ELEMENT_WISE_CLIP) X(ELEMENT_WISE_COS) X(ELEMENT_WISE_DIVIDE) \
+        X(ELEMENT_WISE_EXP) X(ELEMENT_WISE_FLOOR) X(ELEMENT_WISE_LOG) X(ELEMENT_WISE_LOGICAL_AND) \
+        X(ELEMENT_WISE_LOGICAL_EQUALS) X(ELEMENT_WISE_LOGICAL_GREATER_THAN) \
+        X(ELEMENT_WISE_LOGICAL_GREATER_THAN_OR_EQUAL) X(ELEMENT_WISE_LOGICAL_LESS_THAN) \
+        X(ELEMENT_WISE_LOGICAL_LESS_THAN_OR_EQUAL) X(ELEMENT_WISE_LOGICAL_NOT) X(ELEMENT_WISE_LOGICAL_OR) \
+        X(ELEMENT_WISE_LOGICAL_XOR) X(ELEMENT_WISE_MAX) X(ELEMENT_WISE_MEAN) X(ELEMENT_WISE_MIN) \
+        X(ELEMENT_WISE_MULTIPLY) X(ELEMENT_WISE_POW) X(ELEMENT_WISE_CONSTANT_POW) X(ELEMENT_WISE_RECIP) \
+        X(ELEMENT_WISE_SIN) X(ELEMENT_WISE_SQRT) X(ELEMENT_WISE_SUBTRACT) X(ELEMENT_WISE_TAN) \
+        X(ELEMENT_WISE_THRESHOLD) X(ELEMENT_WISE_QUANTIZE_LINEAR) X(ELEMENT_WISE_DEQUANTIZE_LINEAR) \
+        X(ELEMENT_WISE_SIGN) X(ELEMENT_WISE_IS_NAN) X(ELEMENT_WISE_ERF) X(ELEMENT_WISE_SINH) X(ELEMENT_WISE_COSH) \
+        X(ELEMENT_WISE_TANH) X(ELEMENT_WISE_ASINH) X(ELEMENT_WISE_ACOSH) X(ELEMENT_WISE_ATANH) X(ELEMENT_WISE_IF) \
+        X(ELEMENT_WISE_BIT_SHIFT_LEFT) X(ELEMENT_WISE_BIT_SHIFT_RIGHT) X(ELEMENT_WISE_BIT_AND) \
+        X(ELEMENT_WISE_BIT_OR) X(ELEMENT_WISE_BIT_XOR) X(ELEMENT_WISE_BIT_NOT) X(ELEMENT_WISE_BIT_COUNT) \
+        X(ELEMENT_WISE_ROUND) X(ELEMENT_WISE_IS_INFINITY) X(ELEMENT_WISE_MODULUS_TRUNCATE) \
+        X(ELEMENT_WISE_MODULUS_FLOOR) \
+        X(ACTIVATION_ELU) X(ACTIVATION_HARDMAX) X(ACTIVATION_HARD_SIGMOID) X(ACTIVATION_IDENTITY) \
+        X(ACTIVATION_LEAKY_RELU) X(ACTIVATION_LINEAR) X(ACTIVATION_LOG_SOFTMAX) X(ACTIVATION_PARAMETERIZED_RELU) \
+        X(ACTIVATION_PARAMETRIC_SOFTPLUS) X(ACTIVATION_RELU) X(ACTIVATION_SCALED_ELU) X(ACTIVATION_SCALED_TANH) \
+        X(ACTIVATION_SIGMOID) X(ACTIVATION_SOFTMAX) X(ACTIVATION_SOFTPLUS) X(ACTIVATION_SOFTSIGN) \
+        X(ACTIVATION_TANH) X(ACTIVATION_THRESHOLDED_RELU) X(ACTIVATION_SHRINK) X(ACTIVATION_CELU) \
+        X(CONVOLUTION) X(GEMM) X(REDUCE) X(AVERAGE_POOLING) X(MAX_POOLING2) X(SLICE1) X(CAST) X(SPLIT) X(JOIN) \
+        X(PADDING) X(VALUE_SCALE_2D) X(UPSAMPLE_2D) X(GATHER) X(GATHER_ELEMENTS) X(SCATTER_ELEMENTS) \
+        X(SCATTER_ND) X(TILE) X(BATCH_NORMALIZATION) X(MEAN_VARIANCE_NORMALIZATION1) \
+        X(LOCAL_RESPONSE_NORMALIZATION) X(GRU) X(ONE_HOT) X(RESAMPLE1) X(FILL_VALUE_CONSTANT) \
+        X(FILL_VALUE_SEQUENCE) X(REVERSE_SUBSEQUENCES) X(RANDOM_GENERATOR) X(RESAMPLE_GRAD)
+
+        // Invokes `func` with a null pointer of the desc struct type that corresponds to `type`. Returns false if
+        // the operator type has no schema.
+        template <typename Func>
+        bool DispatchOperatorType(DML_OPERATOR_TYPE type, Func&& func)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_THRESHOLDED_RELU, alpha);
+            switch (type)
+            {
+#define DMLX_DISPATCH_CASE(_name) \
+            case DML_OPERATOR_##_name: func(static_cast<DML_##_name##_OPERATOR_DESC*>(nullptr)); return true;
+
+            DMLX_SCHEMA_OPERATOR_TYPES(DMLX_DISPATCH_CASE)
+
+#undef DMLX_DISPATCH_CASE
+            default:
+                return false;
+            }
         }
 
-        static FusedActivation Shrink(float bias = 0.0f, float threshold = 0.5f)
+        // Returns the name of an operator type without the DML_OPERATOR_ prefix, e.g. "CONVOLUTION".
+        inline const char* GetOperatorTypeName(DML_OPERATOR_TYPE type)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_SHRINK, bias, threshold);
+            switch (type)
+            {
+#define DMLX_NAME_CASE(_name) \
+            case DML_OPERATOR_##_name: return #_name;
+
+            DMLX_SCHEMA_OPERATOR_TYPES(DMLX_NAME_CASE)
+
+#undef DMLX_NAME_CASE
+            default:
+                return "UNKNOWN";
+            }
         }
 
-        static FusedActivation Celu(float alpha = 1.0f)
+        inline bool HasOperatorSchema(DML_OPERATOR_TYPE type)
         {
-            return FusedActivation(DML_OPERATOR_ACTIVATION_CELU, alpha);
+            return DispatchOperatorType(type, [](auto*) {});
         }
-    };
 
-    // Implementation detail helper for determining if a list of expressions share the same GraphBuilder.
-    namespace detail
-    {
-        inline bool HasSameOwner(Span<const Expression> exprs)
+        // Visits each field of the supplied desc. The operator type must have a schema.
+        template <typename Visitor>
+        void VisitOperatorDesc(DML_OPERATOR_TYPE type, void* desc, Visitor&& visitor)
         {
-            if (exprs.size() == 0)
+            bool hasSchema = DispatchOperatorType(type, [&](auto* typedNull)
             {
-                return true;
-            }
+                using TDesc = std::remove_pointer_t<decltype(typedNull)>;
+                VisitOperatorFields(*static_cast<TDesc*>(desc), visitor);
+            });
 
-            detail::GraphBuilder* owner = exprs.begin()->Impl()->GetGraphBuilder();
-            for (Expression expr : exprs)
+            assert(hasSchema);
+            if (!hasSchema)
             {
-                if (expr.Impl()->GetGraphBuilder() != owner)
-                {
-                    return false;
-                }
+                DMLX_THROW(E_NOTIMPL);
             }
-
-            return true;
         }
 
-        inline bool HasSameOwner(std::initializer_list<Expression> exprs)
+        // A bump allocator for storage that lives as long as a graph. Allocations are never freed individually;
+        // Reset rewinds the arena so that its blocks are reused by the next graph.
+        class Arena
         {
-            Span<const Expression> span(exprs.begin(), exprs.size());
-            return HasSameOwner(span);
-        }
+        public:
+            static constexpr size_t DefaultBlockSize = 64 * 1024;
 
-        inline bool HasSameDataType(Span<const Expression> exprs)
-        {
-            if (exprs.size() == 0)
+            Arena() = default;
+            Arena(const Arena&) = delete;
+            Arena& operator=(const Arena&) = delete;
+
+            // Returns zero-initialized storage. The alignment can't exceed alignof(uint64_t).
+            void* Allocate(size_t size, size_t alignment)
             {
-                return true;
+                assert(alignment > 0 && alignment <= alignof(uint64_t) && (alignment & (alignment - 1)) == 0);
+
+                size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+                while (m_blockIndex >= m_blocks.size() || offset + size > m_blocks[m_blockIndex].size)
+                {
+                    // Move on to the next block that was kept from before the last reset, or add one
+                    if (m_blockIndex < m_blocks.size())
+                    {
+                        m_usedBeforeBlock += m_blocks[m_blockIndex].size;
+                        ++m_blockIndex;
+                    }
+                    if (m_blockIndex == m_blocks.size())
+                    {
+                        AddBlock(std::max(size, DefaultBlockSize));
+                    }
+                    offset = 0;
+                }
+
+                void* data = reinterpret_cast<uint8_t*>(m_blocks[m_blockIndex].data.get()) + offset;
+                memset(data, 0, size);
+                m_offset = offset + size;
+                m_highWaterMark = std::max(m_highWaterMark, GetUsedSize());
+                return data;
             }
 
-            DML_TENSOR_DATA_TYPE dataType = exprs.begin()->Impl()->GetOutputDesc().dataType;
-            for (Expression expr : exprs)
+            template <typename T>
+            T* Allocate(size_t count = 1)
             {
-                if (expr.Impl()->GetOutputDesc().dataType != dataType)
+                static_assert(alignof(T) <= alignof(uint64_t), "Unsupported alignment");
+                return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+            }
+
+            // Makes the arena's capacity at least `size` bytes. Only takes effect while the arena is empty.
+            void Reserve(size_t size)
+            {
+                if (GetUsedSize() == 0 && size > GetCapacity())
                 {
-                    return false;
+                    m_blocks.clear();
+                    AddBlock(size);
                 }
             }
 
-            return true;
-        }
+            // Rewinds the arena. If the last graph needed more than one block, they are replaced by a single block
+            // large enough for all of it.
+            void Reset()
+            {
+                if (m_blocks.size() > 1)
+                {
+                    size_t capacity = GetCapacity();
+                    m_blocks.clear();
+                    AddBlock(capacity);
+                }
 
-        inline bool HasSameDataType(std::initializer_list<Expression> exprs)
-        {
-            Span<const Expression> span(exprs.begin(), exprs.size());
-            return HasSameDataType(span);
-        }
-    } // namespace detail
+                m_blockIndex = 0;
+                m_offset = 0;
+                m_usedBeforeBlock = 0;
+            }
 
-    // Expression implementation helpers
-    namespace detail
-    {
-        template <DML_OPERATOR_TYPE OperatorType, typename TDesc>
-        Expression ElementWiseUnary(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias)
-        {
-            detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+            // Bytes allocated since the last reset, including alignment padding and space skipped at block ends.
+            size_t GetUsedSize() const { return m_usedBeforeBlock + m_offset; }
 
-            TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-            TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
+            // The largest used size the arena has reached.
+            size_t GetHighWaterMark() const { return m_highWaterMark; }
 
-            TDesc desc = {};
-            desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-            desc.ScaleBias = scaleBias ? &scaleBias.value() : nullptr;
+            size_t GetCapacity() const
+            {
+                size_t capacity = 0;
+                for (const Block& block : m_blocks)
+                {
+                    capacity += block.size;
+                }
+                return capacity;
+            }
 
-            detail::NodeOutput* const inputs[] = { input.Impl() };
-            detail::NodeID node = builder->CreateOperatorNode(OperatorType, &desc, inputs);
-            detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        private:
+            struct Block
+            {
+                std::unique_ptr<uint64_t[]> data;
+                size_t size;
+            };
 
-            return output;
-        }
+            void AddBlock(size_t size)
+            {
+                size = (size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+                m_blocks.push_back(Block{ std::unique_ptr<uint64_t[]>(new uint64_t[size / sizeof(uint64_t)]), size });
+            }
 
-        template <DML_OPERATOR_TYPE OperatorType, typename TDesc>
-        Expression ElementWiseUnary(Expression input, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UNKNOWN)
-        {
-            detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+            std::vector<Block> m_blocks;
+            size_t m_blockIndex = 0;
+            size_t m_offset = 0;
+            size_t m_usedBeforeBlock = 0;
+            size_t m_highWaterMark = 0;
+        };
 
-            TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        // A deep copy of a DML_OPERATOR_DESC. The copy owns the desc struct along with every tensor desc, array and
+        // nested activation desc that it points to, so it remains valid after the caller's desc goes out of scope
+        // and doesn't depend on any IDMLDevice.
+        class OwnedOperatorDesc
+        {
+        public:
+            OwnedOperatorDesc() = default;
 
-            if (outputDataType == DML_TENSOR_DATA_TYPE_UNKNOWN)
+            // If an arena is supplied, the copy is stored in it and the arena must outlive this desc. Copies of this
+            // desc are always stored on the heap.
+            OwnedOperatorDesc(DML_OPERATOR_TYPE type, const void* desc, Arena* arena = nullptr)
+                : m_arena(arena)
             {
-                outputDataType = inputTensor.dataType;
+                m_desc = CloneOperatorDesc(DML_OPERATOR_DESC{ type, desc });
             }
-            TensorDesc outputTensor(outputDataType, inputTensor.sizes, builder->GetTensorPolicy());
 
-            TDesc desc = {};
-            desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-
-            detail::NodeOutput* const inputs[] = { input.Impl() };
-            detail::NodeID node = builder->CreateOperatorNode(OperatorType, &desc, inputs);
-            detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            // Creates an empty desc whose storage (see Allocate) comes from the arena.
+            explicit OwnedOperatorDesc(Arena* arena)
+                : m_arena(arena)
+            {}
 
-            return output;
-        }
+            OwnedOperatorDesc(const OwnedOperatorDesc& other)
+                : OwnedOperatorDesc(other.m_desc.Type, other.m_desc.Desc)
+            {}
 
-        template <DML_OPERATOR_TYPE OperatorType, typename TDesc>
-        Expression ElementWiseBinary(Expression a, Expression b)
-        {
-            assert(detail::HasSameOwner({ a, b }));
-            detail::GraphBuilder* builder = a.Impl()->GetGraphBuilder();
+            OwnedOperatorDesc(OwnedOperatorDesc&&) = default;
 
-            TensorDesc aTensor = a.Impl()->GetOutputDesc();
-            TensorDesc bTensor = b.Impl()->GetOutputDesc();
-            TensorDesc outputTensor(aTensor.dataType, aTensor.sizes, builder->GetTensorPolicy()); // Same as input
+            OwnedOperatorDesc& operator=(const OwnedOperatorDesc& other)
+            {
+                OwnedOperatorDesc copy(other);
+                *this = std::move(copy);
+                return *this;
+            }
 
-            TDesc desc = {};
-            desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
-            desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
-            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+            OwnedOperatorDesc& operator=(OwnedOperatorDesc&&) = default;
 
-            detail::NodeOutput* const inputs[] = { a.Impl(), b.Impl() };
-            detail::NodeID node = builder->CreateOperatorNode(OperatorType, &desc, inputs);
-            detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            bool IsValid() const { return m_desc.Desc != nullptr; }
+            DML_OPERATOR_TYPE GetType() const { return m_desc.Type; }
+            const DML_OPERATOR_DESC* Get() const { return &m_desc; }
 
-            return output;
-        }
+            // Returns the desc struct. TDesc must match the operator type.
+            template <typename TDesc>
+            TDesc* As() { return static_cast<TDesc*>(const_cast<void*>(m_desc.Desc)); }
 
-        template <DML_OPERATOR_TYPE OperatorType, typename TDesc>
-        Expression ElementWiseComparison(Expression a, Expression b, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
-        {
-            assert(detail::HasSameOwner({ a, b }));
-            detail::GraphBuilder* builder = a.Impl()->GetGraphBuilder();
+            template <typename TDesc>
+            const TDesc* As() const { return static_cast<const TDesc*>(m_desc.Desc); }
 
-            TensorDesc aTensor = a.Impl()->GetOutputDesc();
-            TensorDesc bTensor = b.Impl()->GetOutputDesc();
-            TensorDesc outputTensor(outputDataType, aTensor.sizes, builder->GetTensorPolicy());
+            // Replaces the desc. All of the storage it refers to must have been allocated from this object.
+            void SetDesc(const DML_OPERATOR_DESC& desc) { m_desc = desc; }
 
-            TDesc desc = {};
-            desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
-            desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
-            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+            template <typename Visitor>
+            void Visit(Visitor&& visitor)
+            {
+                VisitOperatorDesc(m_desc.Type, const_cast<void*>(m_desc.Desc), visitor);
+            }
 
-            detail::NodeOutput* const inputs[] = { a.Impl(), b.Impl() };
-            detail::NodeID node = builder->CreateOperatorNode(OperatorType, &desc, inputs);
-            detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            // Allocates zero-initialized storage which lives as long as this desc. Used when rewriting fields.
+            template <typename T>
+            T* Allocate(size_t count = 1)
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "Desc storage must be trivially copyable");
+                static_assert(alignof(T) <= alignof(uint64_t), "Unsupported alignment");
 
-            return output;
-        }
+                if (m_arena)
+                {
+                    return m_arena->Allocate<T>(count);
+                }
 
-        // Used to reserve some space on the stack for setting up fused activation operator descs.
-        struct FusedActivationStorage
-        {
-            DML_OPERATOR_DESC opDesc;
+                size_t wordCount = (sizeof(T) * count + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+                m_allocations.push_back(std::unique_ptr<uint64_t[]>(new uint64_t[wordCount > 0 ? wordCount : 1]()));
+                return reinterpret_cast<T*>(m_allocations.back().get());
+            }
 
-            // All fuseable activation descs have a common layout: two tensor desc pointers and up to 2 optional
-            // float parameters, so just use LINEAR as an archetype
-            DML_ACTIVATION_LINEAR_OPERATOR_DESC activationDesc;
-        };
-
-        // Returns the correct value for filling out fused activation fields in the DML API, e.g.
-        // DML_CONVOLUTION_OPERATOR_DESC::FusedActivation. The descs themselves are stored in the `storage` outptr.
-        inline const DML_OPERATOR_DESC* GetFusedActivationPtr(
-            FusedActivation fusedActivation,
-            _Out_ FusedActivationStorage* storage)
-        {
-            if (fusedActivation.activation == DML_OPERATOR_INVALID)
+            template <typename T>
+            const T* CopyArray(const T* values, size_t count)
             {
-                // No fused activation
-                return nullptr;
+                if (values == nullptr)
+                {
+                    return nullptr;
+                }
+
+                T* copy = Allocate<T>(count);
+                std::copy(values, values + count, copy);
+                return copy;
             }
 
-            storage->activationDesc.InputTensor = nullptr;
-            storage->activationDesc.OutputTensor = nullptr;
-            storage->activationDesc.Alpha = fusedActivation.param1;
-            storage->activationDesc.Beta = fusedActivation.param2;
+            const DML_TENSOR_DESC* CopyTensor(const DML_TENSOR_DESC* tensor)
+            {
+                if (tensor == nullptr)
+                {
+                    return nullptr;
+                }
 
-            storage->opDesc.Type = fusedActivation.activation;
-            storage->opDesc.Desc = &storage->activationDesc;
+                DML_TENSOR_DESC* copy = Allocate<DML_TENSOR_DESC>();
+                CopyTensorTo(*tensor, copy);
+                return copy;
+            }
 
-            return &storage->opDesc;
-        }
+            const DML_TENSOR_DESC* CopyTensors(const DML_TENSOR_DESC* tensors, size_t count)
+            {
+                if (tensors == nullptr)
+                {
+                    return nullptr;
+                }
 
-    } // namespace detail
+                DML_TENSOR_DESC* copies = Allocate<DML_TENSOR_DESC>(count);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    CopyTensorTo(tensors[i], &copies[i]);
+                }
+                return copies;
+            }
 
-    inline Expression InputTensor(Graph& graph, uint32_t inputIndex, TensorDesc desc)
-    {
-        detail::GraphBuilder* builder = graph.Impl();
+            const DML_OPERATOR_DESC* CopyOperatorDescs(const DML_OPERATOR_DESC* descs, size_t count)
+            {
+                if (descs == nullptr)
+                {
+                    return nullptr;
+                }
 
-        detail::NodeID node = builder->CreateInputNode(inputIndex);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(desc));
-        return output;
-    }
+                DML_OPERATOR_DESC* copies = Allocate<DML_OPERATOR_DESC>(count);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    copies[i] = CloneOperatorDesc(descs[i]);
+                }
+                return copies;
+            }
 
-    inline Expression Identity(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_IDENTITY, DML_ELEMENT_WISE_IDENTITY_OPERATOR_DESC>(input, scaleBias);
-    }
+        private:
+            // Rewrites every pointer in a freshly-copied desc struct to point at storage owned by `owner`.
+            struct DeepCopyVisitor
+            {
+                OwnedOperatorDesc* owner;
+
+                void InputTensor(const DML_TENSOR_DESC*& tensor) { tensor = owner->CopyTensor(tensor); }
+                void OutputTensor(const DML_TENSOR_DESC*& tensor) { tensor = owner->CopyTensor(tensor); }
+                void InputTensors(const DML_TENSOR_DESC*& tensors, UINT count) { tensors = owner->CopyTensors(tensors, count); }
+                void OutputTensors(const DML_TENSOR_DESC*& tensors, UINT count) { tensors = owner->CopyTensors(tensors, count); }
+                template <typename T> void Attribute(T&) {}
+                template <typename T> void Array(const T*& values, UINT count) { values = owner->CopyArray(values, count); }
+                void Scalar(DML_SCALAR_UNION&, DML_TENSOR_DATA_TYPE) {}
+                void ScaleBias(const DML_SCALE_BIAS*& scaleBias) { scaleBias = owner->CopyArray(scaleBias, 1); }
+                void Activation(const DML_OPERATOR_DESC*& activation) { activation = owner->CopyOperatorDescs(activation, 1); }
+                void Activations(const DML_OPERATOR_DESC*& activations, UINT count) { activations = owner->CopyOperatorDescs(activations, count); }
+            };
+
+            DML_OPERATOR_DESC CloneOperatorDesc(const DML_OPERATOR_DESC& desc)
+            {
+                void* copy = nullptr;
+                bool hasSchema = DispatchOperatorType(desc.Type, [&](auto* typedNull)
+                {
+                    using TDesc = std::remove_pointer_t<decltype(typedNull)>;
+                    TDesc* typedCopy = Allocate<TDesc>();
+                    *typedCopy = *static_cast<const TDesc*>(desc.Desc);
+                    copy = typedCopy;
+                });
 
-    inline Expression Abs(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ABS, DML_ELEMENT_WISE_ABS_OPERATOR_DESC>(input, scaleBias);
-    }
+                if (!hasSchema)
+                {
+                    DMLX_THROW(E_NOTIMPL);
+                }
 
-    inline Expression ACos(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ACOS, DML_ELEMENT_WISE_ACOS_OPERATOR_DESC>(input, scaleBias);
-    }
+                VisitOperatorDesc(desc.Type, copy, DeepCopyVisitor{ this });
+                return DML_OPERATOR_DESC{ desc.Type, copy };
+            }
 
-    inline Expression Add(Expression a, Expression b, FusedActivation fusedActivation = FusedActivation::None())
-    {
-        assert(detail::HasSameOwner({ a, b }));
-        detail::GraphBuilder* builder = a.Impl()->GetGraphBuilder();
+            void CopyTensorTo(const DML_TENSOR_DESC& tensor, DML_TENSOR_DESC* copy)
+            {
+                assert(tensor.Type == DML_TENSOR_TYPE_BUFFER);
+                const auto& bufferDesc = *static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor.Desc);
 
-        TensorDesc aTensor = a.Impl()->GetOutputDesc();
-        TensorDesc bTensor = b.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(aTensor.dataType, aTensor.sizes, builder->GetTensorPolicy()); // Same as input
-        detail::FusedActivationStorage storage;
+                DML_BUFFER_TENSOR_DESC* bufferCopy = Allocate<DML_BUFFER_TENSOR_DESC>();
+                *bufferCopy = bufferDesc;
+                bufferCopy->Sizes = CopyArray(bufferDesc.Sizes, bufferDesc.DimensionCount);
+                bufferCopy->Strides = CopyArray(bufferDesc.Strides, bufferDesc.DimensionCount);
 
-        DML_ELEMENT_WISE_ADD1_OPERATOR_DESC desc = {};
-        desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+                *copy = DML_TENSOR_DESC{ tensor.Type, bufferCopy };
+            }
 
-        detail::NodeOutput* const inputs[] = { a.Impl(), b.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_ADD1, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            DML_OPERATOR_DESC m_desc = { DML_OPERATOR_INVALID, nullptr };
+            Arena* m_arena = nullptr;
+            std::vector<std::unique_ptr<uint64_t[]>> m_allocations;
+        };
 
-        return output;
-    }
+        // Appends a canonical byte encoding of operator descs and tensor descs to a string. Pointers are never
+        // encoded, only the values they refer to, so two descs have the same encoding exactly when they describe the
+        // same operator.
+        class OperatorDescEncoder
+        {
+        public:
+            explicit OperatorDescEncoder(std::string& bytes)
+                : m_bytes(bytes)
+            {}
 
-    inline Expression ASin(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ASIN, DML_ELEMENT_WISE_ASIN_OPERATOR_DESC>(input, scaleBias);
-    }
+            void Write(const void* data, size_t size)
+            {
+                m_bytes.append(static_cast<const char*>(data), size);
+            }
 
-    inline Expression ATan(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ATAN, DML_ELEMENT_WISE_ATAN_OPERATOR_DESC>(input, scaleBias);
-    }
+            template <typename T>
+            void WriteValue(const T& value)
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be encoded");
+                Write(&value, sizeof(value));
+            }
 
-    inline Expression Ceil(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_CEIL, DML_ELEMENT_WISE_CEIL_OPERATOR_DESC>(input, scaleBias);
-    }
+            void WriteOperator(const DML_OPERATOR_DESC& desc)
+            {
+                WriteValue(desc.Type);
+                VisitOperatorDesc(desc.Type, const_cast<void*>(desc.Desc), *this);
+            }
 
-    inline Expression Clip(Expression input, float min, float max, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+            void WriteTensor(const DML_TENSOR_DESC* tensor)
+            {
+                WriteValue(tensor != nullptr);
+                if (tensor == nullptr)
+                {
+                    return;
+                }
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
+                assert(tensor->Type == DML_TENSOR_TYPE_BUFFER);
+                const auto& bufferDesc = *static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc);
 
-        DML_ELEMENT_WISE_CLIP_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ScaleBias = scaleBias ? &scaleBias.value() : nullptr;
-        desc.Min = min;
-        desc.Max = max;
+                WriteValue(bufferDesc.DataType);
+                WriteValue(bufferDesc.Flags);
+                WriteValue(bufferDesc.DimensionCount);
+                Write(bufferDesc.Sizes, sizeof(UINT) * bufferDesc.DimensionCount);
+                WriteValue(bufferDesc.Strides != nullptr);
+                if (bufferDesc.Strides)
+                {
+                    Write(bufferDesc.Strides, sizeof(UINT) * bufferDesc.DimensionCount);
+                }
+                WriteValue(bufferDesc.TotalTensorSizeInBytes);
+                WriteValue(bufferDesc.GuaranteedBaseOffsetAlignment);
+            }
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_CLIP, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            // Field visitor
+            void InputTensor(const DML_TENSOR_DESC*& tensor) { WriteTensor(tensor); }
+            void OutputTensor(const DML_TENSOR_DESC*& tensor) { WriteTensor(tensor); }
 
-        return output;
-    }
+            void InputTensors(const DML_TENSOR_DESC*& tensors, UINT count)
+            {
+                for (UINT i = 0; i < count; ++i)
+                {
+                    WriteTensor(&tensors[i]);
+                }
+            }
 
-    inline Expression Cos(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_COS, DML_ELEMENT_WISE_COS_OPERATOR_DESC>(input, scaleBias);
-    }
+            void OutputTensors(const DML_TENSOR_DESC*& tensors, UINT count) { InputTensors(tensors, count); }
 
-    inline Expression Divide(Expression a, Expression b)
-    {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_DIVIDE, DML_ELEMENT_WISE_DIVIDE_OPERATOR_DESC>(a, b);
-    }
+            template <typename T>
+            void Attribute(T& value) { WriteValue(value); }
 
-    inline Expression Exp(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_EXP, DML_ELEMENT_WISE_EXP_OPERATOR_DESC>(input, scaleBias);
-    }
+            template <typename T>
+            void Array(const T*& values, UINT count)
+            {
+                WriteValue(values != nullptr);
+                if (values)
+                {
+                    Write(values, sizeof(T) * count);
+                }
+            }
 
-    inline Expression Floor(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_FLOOR, DML_ELEMENT_WISE_FLOOR_OPERATOR_DESC>(input, scaleBias);
-    }
+            // Only the bytes of the union's active member are written; the rest may be uninitialized.
+            void Scalar(DML_SCALAR_UNION& value, DML_TENSOR_DATA_TYPE dataType)
+            {
+                Write(&value, GetScalarSizeInBytes(dataType));
+            }
 
-    inline Expression Log(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_LOG, DML_ELEMENT_WISE_LOG_OPERATOR_DESC>(input, scaleBias);
-    }
+            void ScaleBias(const DML_SCALE_BIAS*& scaleBias)
+            {
+                WriteValue(scaleBias != nullptr);
+                if (scaleBias)
+                {
+                    WriteValue(*scaleBias);
+                }
+            }
 
-    inline Expression LogicalAnd(Expression a, Expression b)
-    {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_LOGICAL_AND, DML_ELEMENT_WISE_LOGICAL_AND_OPERATOR_DESC>(a, b);
-    }
+            void Activation(const DML_OPERATOR_DESC*& activation)
+            {
+                WriteValue(activation != nullptr);
+                if (activation)
+                {
+                    WriteOperator(*activation);
+                }
+            }
 
-    inline Expression Equals(Expression a, Expression b, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
-    {
-        return detail::ElementWiseComparison<
-            DML_OPERATOR_ELEMENT_WISE_LOGICAL_EQUALS,
-            DML_ELEMENT_WISE_LOGICAL_EQUALS_OPERATOR_DESC>(a, b, outputDataType);
-    }
+            void Activations(const DML_OPERATOR_DESC*& activations, UINT count)
+            {
+                for (UINT i = 0; i < count; ++i)
+                {
+                    WriteOperator(activations[i]);
+                }
+            }
 
-    inline Expression GreaterThan(Expression a, Expression b, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
-    {
-        return detail::ElementWiseComparison<
-            DML_OPERATOR_ELEMENT_WISE_LOGICAL_GREATER_THAN,
-            DML_ELEMENT_WISE_LOGICAL_GREATER_THAN_OPERATOR_DESC>(a, b, outputDataType);
-    }
+        private:
+            std::string& m_bytes;
+        };
 
-    inline Expression GreaterThanOrEqual(Expression a, Expression b, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
-    {
-        return detail::ElementWiseComparison<
-            DML_OPERATOR_ELEMENT_WISE_LOGICAL_GREATER_THAN_OR_EQUAL,
-            DML_ELEMENT_WISE_LOGICAL_GREATER_THAN_OR_EQUAL_OPERATOR_DESC>(a, b, outputDataType);
-    }
+        // Locates the tensor, scale/bias and fused activation fields of a desc so that graph transformations can
+        // inspect and rewrite them without knowing the concrete desc type. Tensor array fields (e.g. JOIN's inputs)
+        // are not located individually; `hasTensorArrays` is set instead.
+        struct OperatorDescFields
+        {
+            std::vector<const DML_TENSOR_DESC**> inputTensors;
+            std::vector<const DML_TENSOR_DESC**> outputTensors;
+            const DML_SCALE_BIAS** scaleBias = nullptr;
+            const DML_OPERATOR_DESC** fusedActivation = nullptr;
+            bool hasTensorArrays = false;
 
-    inline Expression LessThan(Expression a, Expression b, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
-    {
-        return detail::ElementWiseComparison<
-            DML_OPERATOR_ELEMENT_WISE_LOGICAL_LESS_THAN,
-            DML_ELEMENT_WISE_LOGICAL_LESS_THAN_OPERATOR_DESC>(a, b, outputDataType);
-    }
+            static OperatorDescFields Get(OwnedOperatorDesc& desc)
+            {
+                OperatorDescFields fields;
+                desc.Visit(fields);
+                return fields;
+            }
 
-    inline Expression LessThanOrEqual(Expression a, Expression b, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
-    {
-        return detail::ElementWiseComparison<
-            DML_OPERATOR_ELEMENT_WISE_LOGICAL_LESS_THAN_OR_EQUAL,
-            DML_ELEMENT_WISE_LOGICAL_LESS_THAN_OR_EQUAL_OPERATOR_DESC>(a, b, outputDataType);
-    }
+            void InputTensor(const DML_TENSOR_DESC*& tensor) { inputTensors.push_back(&tensor); }
+            void OutputTensor(const DML_TENSOR_DESC*& tensor) { outputTensors.push_back(&tensor); }
+            void InputTensors(const DML_TENSOR_DESC*&, UINT) { hasTensorArrays = true; }
+            void OutputTensors(const DML_TENSOR_DESC*&, UINT) { hasTensorArrays = true; }
+            template <typename T> void Attribute(T&) {}
+            template <typename T> void Array(const T*&, UINT) {}
+            void Scalar(DML_SCALAR_UNION&, DML_TENSOR_DATA_TYPE) {}
+            void ScaleBias(const DML_SCALE_BIAS*& value) { scaleBias = &value; }
+            void Activation(const DML_OPERATOR_DESC*& value) { fusedActivation = &value; }
+            void Activations(const DML_OPERATOR_DESC*&, UINT) {}
+        };
 
-    inline Expression LogicalNot(Expression input)
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        // Lists every input and output tensor of a desc, including the elements of tensor arrays, in the order that
+        // DirectML numbers them. Omitted optional tensors are listed as null. Fused activations, whose tensors are
+        // null, are only counted.
+        struct OperatorDescTensors
+        {
+            std::vector<DML_TENSOR_DESC*> inputTensors;
+            std::vector<DML_TENSOR_DESC*> outputTensors;
+            uint32_t fusedActivationCount = 0;
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
+            static OperatorDescTensors Get(OwnedOperatorDesc& desc)
+            {
+                OperatorDescTensors tensors;
+                desc.Visit(tensors);
+                return tensors;
+            }
 
-        DML_ELEMENT_WISE_LOGICAL_NOT_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+            static OperatorDescTensors Get(const DML_OPERATOR_DESC& desc)
+            {
+                OperatorDescTensors tensors;
+                VisitOperatorDesc(desc.Type, const_cast<void*>(desc.Desc), tensors);
+                return tensors;
+            }
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_LOGICAL_NOT, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            // Returns the operator's output if it has exactly one, counting only the optional outputs that are
+            // present (e.g. MAX_POOLING2 without OutputIndicesTensor), or null otherwise.
+            DML_TENSOR_DESC* GetSingleOutputTensor() const
+            {
+                if (outputTensors.empty() || !outputTensors[0])
+                {
+                    return nullptr;
+                }
+                for (size_t i = 1; i < outputTensors.size(); ++i)
+                {
+                    if (outputTensors[i])
+                    {
+                        return nullptr;
+                    }
+                }
+                return outputTensors[0];
+            }
 
-        return output;
-    }
+            void InputTensor(const DML_TENSOR_DESC*& tensor) { inputTensors.push_back(const_cast<DML_TENSOR_DESC*>(tensor)); }
+            void OutputTensor(const DML_TENSOR_DESC*& tensor) { outputTensors.push_back(const_cast<DML_TENSOR_DESC*>(tensor)); }
+            void InputTensors(const DML_TENSOR_DESC*& tensors, UINT count) { Append(inputTensors, tensors, count); }
+            void OutputTensors(const DML_TENSOR_DESC*& tensors, UINT count) { Append(outputTensors, tensors, count); }
+            template <typename T> void Attribute(T&) {}
+            template <typename T> void Array(const T*&, UINT) {}
+            void Scalar(DML_SCALAR_UNION&, DML_TENSOR_DATA_TYPE) {}
+            void ScaleBias(const DML_SCALE_BIAS*&) {}
+            void Activation(const DML_OPERATOR_DESC*& activation) { fusedActivationCount += activation ? 1 : 0; }
+            void Activations(const DML_OPERATOR_DESC*&, UINT) {}
 
-    inline Expression LogicalOr(Expression a, Expression b)
-    {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_LOGICAL_OR, DML_ELEMENT_WISE_LOGICAL_OR_OPERATOR_DESC>(a, b);
-    }
+        private:
+            static void Append(std::vector<DML_TENSOR_DESC*>& list, const DML_TENSOR_DESC* tensors, UINT count)
+            {
+                for (UINT i = 0; i < count; ++i)
+                {
+                    list.push_back(tensors ? const_cast<DML_TENSOR_DESC*>(&tensors[i]) : nullptr);
+                }
+            }
+        };
 
-    inline Expression LogicalXor(Expression a, Expression b)
-    {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_LOGICAL_XOR, DML_ELEMENT_WISE_LOGICAL_XOR_OPERATOR_DESC>(a, b);
-    }
+        // Returns true if both tensor descs (either of which may be null) have the same encoding.
+        inline bool AreTensorDescsEqual(const DML_TENSOR_DESC* a, const DML_TENSOR_DESC* b)
+        {
+            std::string aBytes;
+            std::string bBytes;
+            OperatorDescEncoder(aBytes).WriteTensor(a);
+            OperatorDescEncoder(bBytes).WriteTensor(b);
+            return aBytes == bBytes;
+        }
 
-    inline Expression Max(Expression a, Expression b)
-    {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_MAX, DML_ELEMENT_WISE_MAX_OPERATOR_DESC>(a, b);
-    }
-
-    inline Expression Mean(Expression a, Expression b)
-    {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_MEAN, DML_ELEMENT_WISE_MEAN_OPERATOR_DESC>(a, b);
-    }
-
-    inline Expression Min(Expression a, Expression b)
-    {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_MIN, DML_ELEMENT_WISE_MIN_OPERATOR_DESC>(a, b);
-    }
-
-    inline Expression Multiply(Expression a, Expression b)
-    {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_MULTIPLY, DML_ELEMENT_WISE_MULTIPLY_OPERATOR_DESC>(a, b);
-    }
-
-    inline Expression Pow(Expression input, Expression exponent, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        assert(detail::HasSameOwner({ input, exponent }));
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc exponentTensor = exponent.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
-
-        DML_ELEMENT_WISE_POW_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ExponentTensor = exponentTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ScaleBias = scaleBias ? &scaleBias.value() : nullptr;
+        // 64-bit FNV-1a. Unlike std::hash, the result is the same across processes and platforms.
+        inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+            }
+            return hash;
+        }
 
-        detail::NodeOutput* const inputs[] = { input.Impl(), exponent.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_POW, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        // Bounds-checked reads from a buffer of serialized data. Malformed data throws E_INVALIDARG.
+        class BinaryReader
+        {
+        public:
+            BinaryReader(const uint8_t* begin, const uint8_t* end)
+                : m_cursor(begin)
+                , m_end(end)
+            {}
 
-        return output;
-    }
+            size_t GetRemainingSize() const { return static_cast<size_t>(m_end - m_cursor); }
 
-    inline Expression Pow(Expression input, float exponent, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+            // Returns a pointer to the next `size` bytes and advances past them.
+            const uint8_t* ReadBytes(uint64_t size)
+            {
+                if (size > GetRemainingSize())
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
+                const uint8_t* bytes = m_cursor;
+                m_cursor += size;
+                return bytes;
+            }
 
-        DML_ELEMENT_WISE_CONSTANT_POW_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ScaleBias = scaleBias ? &scaleBias.value() : nullptr;
-        desc.Exponent = exponent;
+            void Read(void* data, size_t size)
+            {
+                memcpy(data, ReadBytes(size), size);
+            }
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_CONSTANT_POW, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            template <typename T>
+            T ReadValue()
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be decoded");
+                T value;
+                Read(&value, sizeof(value));
+                return value;
+            }
 
-        return output;
-    }
+            // Reads a bool written by OperatorDescEncoder::WriteValue.
+            bool ReadFlag()
+            {
+                static_assert(sizeof(bool) == sizeof(uint8_t), "Unexpected bool size");
+                return ReadValue<uint8_t>() != 0;
+            }
 
-    inline Expression Recip(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_RECIP, DML_ELEMENT_WISE_RECIP_OPERATOR_DESC>(input, scaleBias);
-    }
+            // Reads `count` elements into storage allocated by `owner`. The size is checked before allocating.
+            template <typename T>
+            T* ReadArray(OwnedOperatorDesc& owner, uint64_t count)
+            {
+                if (count > GetRemainingSize() / sizeof(T))
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
 
-    inline Expression Sin(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_SIN, DML_ELEMENT_WISE_SIN_OPERATOR_DESC>(input, scaleBias);
-    }
+                T* values = owner.Allocate<T>(static_cast<size_t>(count));
+                Read(values, sizeof(T) * static_cast<size_t>(count));
+                return values;
+            }
 
-    inline Expression Sqrt(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_SQRT, DML_ELEMENT_WISE_SQRT_OPERATOR_DESC>(input, scaleBias);
-    }
+        private:
+            const uint8_t* m_cursor;
+            const uint8_t* m_end;
+        };
 
-    inline Expression Subtract(Expression a, Expression b)
-    {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_SUBTRACT, DML_ELEMENT_WISE_SUBTRACT_OPERATOR_DESC>(a, b);
-    }
+        // The inverse of OperatorDescEncoder: decodes an operator desc into storage owned by an OwnedOperatorDesc.
+        class OperatorDescDecoder
+        {
+        public:
+            OperatorDescDecoder(BinaryReader& reader, OwnedOperatorDesc& owner)
+                : m_reader(reader)
+                , m_owner(owner)
+            {}
 
-    inline Expression Tan(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_TAN, DML_ELEMENT_WISE_TAN_OPERATOR_DESC>(input, scaleBias);
-    }
+            DML_OPERATOR_DESC ReadOperator()
+            {
+                auto type = m_reader.ReadValue<DML_OPERATOR_TYPE>();
 
-    inline Expression Threshold(Expression input, float min, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+                void* desc = nullptr;
+                bool hasSchema = DispatchOperatorType(type, [&](auto* typedNull)
+                {
+                    using TDesc = std::remove_pointer_t<decltype(typedNull)>;
+                    desc = m_owner.Allocate<TDesc>();
+                });
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
+                if (!hasSchema)
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
 
-        DML_ELEMENT_WISE_THRESHOLD_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ScaleBias = scaleBias ? &scaleBias.value() : nullptr;
-        desc.Min = min;
+                VisitOperatorDesc(type, desc, *this);
+                return DML_OPERATOR_DESC{ type, desc };
+            }
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_THRESHOLD, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            const DML_TENSOR_DESC* ReadTensor()
+            {
+                if (!m_reader.ReadFlag())
+                {
+                    return nullptr;
+                }
 
-        return output;
-    }
+                DML_TENSOR_DESC* tensor = m_owner.Allocate<DML_TENSOR_DESC>();
+                ReadTensorTo(tensor);
+                return tensor;
+            }
 
-    inline Expression QuantizeLinear(Expression input, Expression scale, Expression zeroPoint)
-    {
-        assert(detail::HasSameOwner({ input, scale, zeroPoint }));
+            // Field visitor
+            void InputTensor(const DML_TENSOR_DESC*& tensor) { tensor = ReadTensor(); }
+            void OutputTensor(const DML_TENSOR_DESC*& tensor) { tensor = ReadTensor(); }
 
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+            void InputTensors(const DML_TENSOR_DESC*& tensors, UINT count)
+            {
+                CheckElementCount(count);
+                DML_TENSOR_DESC* values = m_owner.Allocate<DML_TENSOR_DESC>(count);
+                for (UINT i = 0; i < count; ++i)
+                {
+                    if (!m_reader.ReadFlag())
+                    {
+                        DMLX_THROW(E_INVALIDARG);
+                    }
+                    ReadTensorTo(&values[i]);
+                }
+                tensors = values;
+            }
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc scaleTensor = scale.Impl()->GetOutputDesc();
-        TensorDesc zeroPointTensor = zeroPoint.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(DML_TENSOR_DATA_TYPE_UINT8, inputTensor.sizes, builder->GetTensorPolicy());
+            void OutputTensors(const DML_TENSOR_DESC*& tensors, UINT count) { InputTensors(tensors, count); }
 
-        DML_ELEMENT_WISE_QUANTIZE_LINEAR_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ScaleTensor = scaleTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ZeroPointTensor = zeroPointTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+            template <typename T>
+            void Attribute(T& value) { value = m_reader.ReadValue<T>(); }
 
-        detail::NodeOutput* const inputs[] = { input.Impl(), scale.Impl(), zeroPoint.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_QUANTIZE_LINEAR, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            template <typename T>
+            void Array(const T*& values, UINT count)
+            {
+                values = m_reader.ReadFlag() ? m_reader.ReadArray<T>(m_owner, count) : nullptr;
+            }
 
-        return output;
-    }
+            void Scalar(DML_SCALAR_UNION& value, DML_TENSOR_DATA_TYPE dataType)
+            {
+                value = {};
+                m_reader.Read(&value, GetScalarSizeInBytes(dataType));
+            }
 
-    inline Expression DequantizeLinear(Expression input, Expression scale, Expression zeroPoint)
-    {
-        assert(detail::HasSameOwner({ input, scale, zeroPoint }));
+            void ScaleBias(const DML_SCALE_BIAS*& scaleBias)
+            {
+                scaleBias = m_reader.ReadFlag() ? m_reader.ReadArray<DML_SCALE_BIAS>(m_owner, 1) : nullptr;
+            }
 
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+            void Activation(const DML_OPERATOR_DESC*& activation)
+            {
+                activation = nullptr;
+                if (m_reader.ReadFlag())
+                {
+                    DML_OPERATOR_DESC* value = m_owner.Allocate<DML_OPERATOR_DESC>();
+                    *value = ReadOperator();
+                    activation = value;
+                }
+            }
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc scaleTensor = scale.Impl()->GetOutputDesc();
-        TensorDesc zeroPointTensor = zeroPoint.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(DML_TENSOR_DATA_TYPE_FLOAT32, inputTensor.sizes, builder->GetTensorPolicy());
+            void Activations(const DML_OPERATOR_DESC*& activations, UINT count)
+            {
+                CheckElementCount(count);
+                DML_OPERATOR_DESC* values = m_owner.Allocate<DML_OPERATOR_DESC>(count);
+                for (UINT i = 0; i < count; ++i)
+                {
+                    values[i] = ReadOperator();
+                }
+                activations = values;
+            }
 
-        DML_ELEMENT_WISE_DEQUANTIZE_LINEAR_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ScaleTensor = scaleTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ZeroPointTensor = zeroPointTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        private:
+            // Each encoded tensor or operator takes at least one byte, which bounds the count before allocating
+            void CheckElementCount(UINT count)
+            {
+                if (count > m_reader.GetRemainingSize())
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
+            }
 
-        detail::NodeOutput* const inputs[] = { input.Impl(), scale.Impl(), zeroPoint.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_DEQUANTIZE_LINEAR, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            void ReadTensorTo(DML_TENSOR_DESC* tensor)
+            {
+                DML_BUFFER_TENSOR_DESC* bufferDesc = m_owner.Allocate<DML_BUFFER_TENSOR_DESC>();
+                bufferDesc->DataType = m_reader.ReadValue<DML_TENSOR_DATA_TYPE>();
+                bufferDesc->Flags = m_reader.ReadValue<DML_TENSOR_FLAGS>();
+                bufferDesc->DimensionCount = m_reader.ReadValue<UINT>();
+                bufferDesc->Sizes = m_reader.ReadArray<UINT>(m_owner, bufferDesc->DimensionCount);
+                bufferDesc->Strides = m_reader.ReadFlag()
+                    ? m_reader.ReadArray<UINT>(m_owner, bufferDesc->DimensionCount)
+                    : nullptr;
+                bufferDesc->TotalTensorSizeInBytes = m_reader.ReadValue<UINT64>();
+                bufferDesc->GuaranteedBaseOffsetAlignment = m_reader.ReadValue<UINT>();
+
+                *tensor = DML_TENSOR_DESC{ DML_TENSOR_TYPE_BUFFER, bufferDesc };
+            }
 
-        return output;
-    }
+            BinaryReader& m_reader;
+            OwnedOperatorDesc& m_owner;
+        };
+    } // namespace detail
 
-    inline Expression Sign(Expression a)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_SIGN, DML_ELEMENT_WISE_SIGN_OPERATOR_DESC>(a);
-    }
+    // Transformations applied to a graph by Graph::Compile. Transformations never change the result of an
+    // expression; they only change how it is computed. They're applied to a copy of the graph each time it's
+    // compiled, so the graph's own nodes and node numbering are never changed, and changing the optimizations takes
+    // effect on the next compile.
+    enum class GraphOptimizations : uint32_t
+    {
+        None = 0,
+
+        // Folds chains of scalar multiply/add (ELEMENT_WISE_IDENTITY with a DML_SCALE_BIAS) into a single node, or
+        // into the ScaleBias of the unary element-wise operator that consumes them.
+        ScaleBiasFolding = 0x1,
+
+        // Moves a standalone activation into the FusedActivation of the CONVOLUTION, GEMM, BATCH_NORMALIZATION or
+        // MEAN_VARIANCE_NORMALIZATION1 that produces its input.
+        ActivationFusion = 0x2,
+
+        // Folds BATCH_NORMALIZATION into the CONVOLUTION that produces its input, when the filter, bias and all of the
+        // normalization parameters are FLOAT32 constant inputs (see ConstantInputTensor). The folded filter and
+        // bias are computed on the CPU and added to the graph as new constant inputs, which changes the compiled
+        // graph's input count (see Graph::Compile and Graph::GetInputCount).
+        BatchNormalizationFolding = 0x4,
+
+        // Stores the FLOAT32 constant filters of CONVOLUTION and the constant B inputs of GEMM as INT8, with a scale
+        // and zero point per output channel computed on the CPU, and inserts an ELEMENT_WISE_DEQUANTIZE_LINEAR in
+        // front of each consumer. The quantized weights, scales and zero points are new constant inputs; the
+        // original FLOAT32 inputs are no longer read by the graph. This is lossy, so it isn't part of Default (see
+        // cpu::QuantizeWeights for measuring the accuracy impact).
+        WeightQuantization = 0x8,
+
+        // Runs FLOAT32 operators in FLOAT16, except those kept in FLOAT32 by the graph's MixedPrecisionPolicy.
+        // Constant inputs read by a converted operator are converted on the CPU and added as new constant inputs;
+        // other tensors crossing between FLOAT32 and FLOAT16 operators, including graph inputs and outputs, are
+        // converted by CAST operators. Graph inputs and outputs keep their FLOAT32 types. Weights quantized by
+        // WeightQuantization are dequantized straight to FLOAT16. This is lossy, so it isn't part of Default.
+        MixedPrecision = 0x10,
+
+        // Chooses, for each operator with a 3D or higher dimensional output, between the packed layout (e.g. NCHW) and
+        // the interleaved channel layout (e.g. NHWC, see TensorPolicy::InterleavedChannel) for its output. Convolution
+        // and pooling prefer the interleaved layout; JOIN, SPLIT, GATHER and REDUCE prefer the packed layout; and
+        // reading a tensor in another operator's layout has a cost. The layouts are chosen to minimize the total
+        // cost, counted in bytes of memory traffic. Constant inputs read by interleaved operators are rearranged on
+        // the CPU and added as new constant inputs; graph outputs and reshapes of interleaved tensors read a packed
+        // copy made by an identity operator. Graph inputs and outputs keep their layouts. Whether the interleaved
+        // layout is faster depends on the hardware, so this isn't part of Default.
+        LayoutAssignment = 0x20,
+
+        Default = ScaleBiasFolding | ActivationFusion | BatchNormalizationFolding,
+    };
 
-    inline Expression IsNaN(Expression input, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
+    inline GraphOptimizations operator|(GraphOptimizations a, GraphOptimizations b)
     {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_IS_NAN, DML_ELEMENT_WISE_IS_NAN_OPERATOR_DESC>(input, outputDataType);
+        return static_cast<GraphOptimizations>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
     }
 
-    inline Expression Erf(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    inline GraphOptimizations operator&(GraphOptimizations a, GraphOptimizations b)
     {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ERF, DML_ELEMENT_WISE_ERF_OPERATOR_DESC>(input, scaleBias);
+        return static_cast<GraphOptimizations>(static_cast<uint32_t>(a) & static_cast<uint32_t>(b));
     }
 
-    inline Expression Sinh(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    inline GraphOptimizations operator~(GraphOptimizations a)
     {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_SINH, DML_ELEMENT_WISE_SINH_OPERATOR_DESC>(input, scaleBias);
+        return static_cast<GraphOptimizations>(~static_cast<uint32_t>(a));
     }
 
-    inline Expression Cosh(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    // Chooses the operators that GraphOptimizations::MixedPrecision runs in FLOAT16. Only operators with a single,
+    // FLOAT32 output are ever converted.
+    struct MixedPrecisionPolicy
     {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_COSH, DML_ELEMENT_WISE_COSH_OPERATOR_DESC>(input, scaleBias);
-    }
+        // If not empty, only these operator types are converted.
+        std::vector<DML_OPERATOR_TYPE> float16Operators;
 
-    inline Expression Tanh(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_TANH, DML_ELEMENT_WISE_TANH_OPERATOR_DESC>(input, scaleBias);
-    }
+        // Operator types that are never converted. Defaults to the operators that exponentiate or accumulate over
+        // many elements, whose results are most sensitive to FLOAT16's range and precision.
+        std::vector<DML_OPERATOR_TYPE> float32Operators = {
+            DML_OPERATOR_ACTIVATION_SOFTMAX,
+            DML_OPERATOR_ACTIVATION_LOG_SOFTMAX,
+            DML_OPERATOR_REDUCE,
+            DML_OPERATOR_MEAN_VARIANCE_NORMALIZATION1,
+        };
 
-    inline Expression ASinh(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ASINH, DML_ELEMENT_WISE_ASINH_OPERATOR_DESC>(input, scaleBias);
-    }
+        bool IsFloat16Operator(DML_OPERATOR_TYPE type) const
+        {
+            if (!float16Operators.empty() &&
+                std::find(float16Operators.begin(), float16Operators.end(), type) == float16Operators.end())
+            {
+                return false;
+            }
+            return std::find(float32Operators.begin(), float32Operators.end(), type) == float32Operators.end();
+        }
+    };
 
-    inline Expression ACosh(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    // Counters describing the work done by the graph optimizations in DMLX.
+    // Counters other than mergedNodeCount describe the most recently compiled graph (or the graph built by
+    // Graph::FormatDot, EstimateCost and the like).
+    struct GraphStatistics
     {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ACOSH, DML_ELEMENT_WISE_ACOSH_OPERATOR_DESC>(input, scaleBias);
-    }
+        // The number of operator nodes omitted from the most recently compiled graph because none of the requested
+        // outputs depended on them.
+        uint32_t prunedNodeCount = 0;
 
-    inline Expression ATanh(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ATANH, DML_ELEMENT_WISE_ATANH_OPERATOR_DESC>(input, scaleBias);
-    }
+        // The number of nodes that common subexpression elimination resolved to an existing, identical node.
+        uint32_t mergedNodeCount = 0;
 
-    inline Expression If(Expression condition, Expression a, Expression b)
-    {
-        assert(detail::HasSameOwner({ condition, a, b }));
-        assert(detail::HasSameDataType({ a, b }));
+        // The number of scale/bias identity nodes folded into their consumers.
+        uint32_t foldedScaleBiasCount = 0;
 
-        detail::GraphBuilder* builder = condition.Impl()->GetGraphBuilder();
+        // The number of standalone activations fused into the operator producing their input.
+        uint32_t fusedActivationCount = 0;
 
-        TensorDesc conditionTensor = condition.Impl()->GetOutputDesc();
-        assert(conditionTensor.dataType == DML_TENSOR_DATA_TYPE_UINT8);
+        // The number of batch normalizations folded into convolutions.
+        uint32_t foldedBatchNormalizationCount = 0;
 
-        TensorDesc aTensor = a.Impl()->GetOutputDesc();
-        TensorDesc bTensor = b.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(aTensor.dataType, aTensor.sizes, builder->GetTensorPolicy());
+        // The number of views (see Transpose, Broadcast and StridedView) copied through an identity operator
+        // because they were requested as graph outputs.
+        uint32_t materializedViewCount = 0;
 
-        DML_ELEMENT_WISE_IF_OPERATOR_DESC desc = {};
-        desc.ConditionTensor = conditionTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        // The number of constant weight tensors stored as INT8 by weight quantization, and the constant data
+        // this saved: the FLOAT32 weights, less the INT8 weights and their scales and zero points.
+        uint32_t quantizedWeightCount = 0;
+        uint64_t quantizedWeightBytesSaved = 0;
 
-        detail::NodeOutput* const inputs[] = { condition.Impl(), a.Impl(), b.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_IF, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        // The number of operators converted to FLOAT16 by mixed precision, and the constant data saved by
+        // converting the constants they read.
+        uint32_t float16OperatorCount = 0;
+        uint64_t float16ConstantBytesSaved = 0;
 
-        return output;
-    }
+        // The number of operators given the interleaved channel layout by layout assignment, and of the copies
+        // made to convert their outputs back to the packed layout.
+        uint32_t interleavedOperatorCount = 0;
+        uint32_t layoutConversionCount = 0;
+    };
 
-    inline Expression BitShiftLeft(Expression a, Expression b)
+    // A problem found by Graph::Validate.
+    struct GraphDiagnostic
     {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_BIT_SHIFT_LEFT, DML_ELEMENT_WISE_BIT_SHIFT_LEFT_OPERATOR_DESC>(a, b);
-    }
+        // The operator node the problem was found in, or UINT32_MAX for problems with the graph inputs or outputs. Node
+        // indices count every operator expression created in the graph, in creation order.
+        uint32_t nodeIndex;
+        DML_OPERATOR_TYPE operatorType;
+        std::string message;
+    };
 
-    inline Expression BitShiftRight(Expression a, Expression b)
+    // Describes the arena that holds a graph's nodes, node input lists, tensor descs and operator descs.
+    struct GraphArenaStatistics
     {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_BIT_SHIFT_RIGHT, DML_ELEMENT_WISE_BIT_SHIFT_RIGHT_OPERATOR_DESC>(a, b);
-    }
+        // Bytes in use by the current graph.
+        uint64_t usedBytes = 0;
 
-    inline Expression BitAnd(Expression a, Expression b)
-    {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_BIT_AND, DML_ELEMENT_WISE_BIT_AND_OPERATOR_DESC>(a, b);
-    }
-
-    inline Expression BitOr(Expression a, Expression b)
-    {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_BIT_OR, DML_ELEMENT_WISE_BIT_OR_OPERATOR_DESC>(a, b);
-    }
+        // The most bytes the graph has used at once, across calls to Graph::Reset. Passing this to
+        // Graph::ReserveArena before building lets the arena hold the whole graph in a single block.
+        uint64_t highWaterMarkBytes = 0;
 
-    inline Expression BitXor(Expression a, Expression b)
-    {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_BIT_XOR, DML_ELEMENT_WISE_BIT_XOR_OPERATOR_DESC>(a, b);
-    }
+        // Bytes currently allocated by the arena.
+        uint64_t capacityBytes = 0;
+    };
 
-    inline Expression BitNot(Expression a)
+    namespace detail
     {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_BIT_NOT, DML_ELEMENT_WISE_BIT_NOT_OPERATOR_DESC>(a);
-    }
+        class GraphBuilder;
+        class NodeOutput;
 
-    inline Expression BitCount(Expression a, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
-    {
-        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_BIT_COUNT, DML_ELEMENT_WISE_BIT_COUNT_OPERATOR_DESC>(a, outputDataType);
-    }
+        // A node in the graph which represents a graph input.
+        struct InputNode
+        {
+            uint32_t inputIndex;
+        };
 
-    inline Expression Round(Expression input, DML_ROUNDING_MODE roundingMode = DML_ROUNDING_MODE_HALVES_TO_NEAREST_EVEN)
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        // A node in the graph which represents a DML operator. The operator is described by a device-independent
+        // copy of its desc; the IDMLOperator itself isn't created until the graph is compiled.
+        struct OperatorNode
+        {
+            OwnedOperatorDesc desc;
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
+            // Taken from the builder's OperatorCache, or created from `desc`, when the graph is compiled. Operator types
+            // without a schema are created eagerly instead, in which case `desc` is empty.
+            Microsoft::WRL::ComPtr<IDMLOperator> op;
 
-        DML_ELEMENT_WISE_ROUND_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.RoundingMode = roundingMode;
+            // The inputs to this node, stored in the GraphBuilder's arena
+            Span<NodeOutput*> inputs;
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_ROUND, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            // The scoped name given by dml::Scope or dml::Name, stored in the arena. Null if the node is unnamed.
+            const char* name = nullptr;
 
-        return output;
-    }
+            // In a copy made by GraphBuilder::CopyForCompile, the node of the original graph that this node was copied
+            // from or was added by an optimization on behalf of. UINT32_MAX otherwise.
+            uint32_t sourceIndex = UINT32_MAX;
+        };
 
-    inline Expression IsInfinity(
-        Expression input,
-        DML_IS_INFINITY_MODE infinityMode = DML_IS_INFINITY_MODE_EITHER,
-        DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        // Used for representing reshapes and type punning
+        struct ReinterpretNode
+        {
+            NodeOutput* input;
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(outputDataType, inputTensor.sizes, builder->GetTensorPolicy());
+            // The output of the first non-reinterpret node up the chain of inputs. Resolved when the node is created so
+            // that chains of reinterprets never need to be walked.
+            NodeOutput* root;
 
-        DML_ELEMENT_WISE_IS_INFINITY_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.InfinityMode = infinityMode;
+            // Views change the logical layout of their input (e.g. a transpose), rather than just relabeling it. A view
+            // can be consumed in place by other operators, but needs to be copied to be a graph output.
+            bool isView;
+        };
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_IS_INFINITY, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        enum class NodeType
+        {
+            Invalid,
+            Input,
+            Operator,
+            Reinterpret,
+        };
 
-        return output;
-    }
+        // Identifies a node in the graph.
+        struct NodeID
+        {
+            NodeType type;
+            uint32_t index; // The index of this node in the GraphBuilder
+        };
 
-    inline Expression ModulusTruncate(Expression a, Expression b)
-    {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_MODULUS_TRUNCATE, DML_ELEMENT_WISE_MODULUS_TRUNCATE_OPERATOR_DESC>(a, b);
-    }
+        // Represents one of the outputs of a node.
+        class NodeOutput
+        {
+        public:
+            NodeOutput(GraphBuilder* owner, NodeID node, uint32_t outputIndex, TensorDesc tensorDesc)
+                : m_owner(owner)
+                , m_node(node)
+                , m_outputIndex(outputIndex)
+                , m_tensorDesc(std::move(tensorDesc))
+            {}
 
-    inline Expression ModulusFloor(Expression a, Expression b)
-    {
-        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_MODULUS_FLOOR, DML_ELEMENT_WISE_MODULUS_FLOOR_OPERATOR_DESC>(a, b);
-    }
+            // Retrieves the GraphBuilder that owns this object.
+            GraphBuilder* GetGraphBuilder() const { return m_owner; }
 
-#pragma region detail
-#define DMLX_ACTIVATION_IMPL(_name) \
-    do { \
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder(); \
-        \
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc(); \
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); \
-        \
-        DML_##_name##_OPERATOR_DESC desc = {}; \
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>(); \
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>(); \
-        \
-        detail::NodeOutput* const inputs[] = { input.Impl() }; \
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_##_name, &desc, inputs); \
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor)); \
-        \
-        return output; \
-    } while(0)
+            NodeID GetNode() const { return m_node; }
+            uint32_t GetOutputIndex() const { return m_outputIndex; }
+            const TensorDesc& GetOutputDesc() const { return m_tensorDesc; }
 
-#define DMLX_ACTIVATION_IMPL_1(_name, _param1Name, _param1) \
-    do { \
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder(); \
-        \
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc(); \
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); \
-        \
-        DML_##_name##_OPERATOR_DESC desc = {}; \
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>(); \
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>(); \
-        desc._param1Name = _param1; \
-        \
-        detail::NodeOutput* const inputs[] = { input.Impl() }; \
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_##_name, &desc, inputs); \
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor)); \
-        \
-        return output; \
-    } while(0)
+        private:
+            friend class GraphBuilder; // Renumbers nodes when optimizations reorder them
 
-#define DMLX_ACTIVATION_IMPL_2(_name, _param1Name, _param1, _param2Name, _param2) \
-    do { \
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder(); \
-        \
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc(); \
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); \
-        \
-        DML_##_name##_OPERATOR_DESC desc = {}; \
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>(); \
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>(); \
-        desc._param1Name = _param1; \
-        desc._param2Name = _param2; \
-        \
-        detail::NodeOutput* const inputs[] = { input.Impl() }; \
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_##_name, &desc, inputs); \
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor)); \
-        \
-        return output; \
-    } while(0)
-#pragma endregion
+            GraphBuilder* m_owner;
+            NodeID m_node;
 
-    inline Expression ActivationElu(Expression input, float alpha = 1.0f)
-    {
-        DMLX_ACTIVATION_IMPL_1(ACTIVATION_ELU, Alpha, alpha);
-    }
+            // An operator can have multiple outputs; this index identifies which one of the operator's  outputs this
+            // NodeOutput represents.
+            uint32_t m_outputIndex;
 
-    inline Expression ActivationHardmax(Expression input)
-    {
-        DMLX_ACTIVATION_IMPL(ACTIVATION_HARDMAX);
-    }
+            TensorDesc m_tensorDesc;
+        };
 
-    inline Expression ActivationHardSigmoid(Expression input, float alpha = 0.2f, float beta = 0.5f)
-    {
-        DMLX_ACTIVATION_IMPL_2(ACTIVATION_HARD_SIGMOID, Alpha, alpha, Beta, beta);
-    }
+        struct GraphDesc
+        {
+            uint32_t inputCount;
+            uint32_t outputCount;
+            std::vector<uint32_t> nodes; // Indices of the operator nodes in the GraphBuilder
+            uint32_t prunedNodeCount; // Operator nodes omitted because no output depends on them
+            std::vector<DML_INPUT_GRAPH_EDGE_DESC> inputEdges;
+            std::vector<DML_OUTPUT_GRAPH_EDGE_DESC> outputEdges;
+            std::vector<DML_INTERMEDIATE_GRAPH_EDGE_DESC> intermediateEdges;
+        };
 
-    inline Expression ActivationIdentity(Expression input)
-    {
-        DMLX_ACTIVATION_IMPL(ACTIVATION_IDENTITY);
-    }
+        // The IDMLOperators created for a graph and the copies compiled from it, keyed by encoded operator desc.
+        // Operators don't hold any data, so compiling the graph again reuses them instead of creating new ones. Nodes
+        // of one compiled graph with equal descs still get an operator each.
+        struct OperatorCache
+        {
+            std::mutex mutex;
+            std::unordered_map<std::string, std::vector<Microsoft::WRL::ComPtr<IDMLOperator>>> operators;
+        };
 
-    inline Expression ActivationLeakyRelu(Expression input, float alpha = 0.01f)
-    {
-        DMLX_ACTIVATION_IMPL_1(ACTIVATION_LEAKY_RELU, Alpha, alpha);
-    }
+        class GraphBuilder
+        {
+        public:
+            GraphBuilder(IDMLDevice* device, TensorPolicy tensorPolicy = {})
+                : m_device(device)
+                , m_tensorPolicy(tensorPolicy)
+            {}
 
-    inline Expression ActivationLinear(Expression input, float alpha, float beta)
-    {
-        DMLX_ACTIVATION_IMPL_2(ACTIVATION_LINEAR, Alpha, alpha, Beta, beta);
-    }
+            GraphBuilder(const GraphBuilder&) = delete;
+            GraphBuilder& operator=(const GraphBuilder&) = delete;
 
-    inline Expression ActivationLogSoftmax(Expression input)
-    {
-        DMLX_ACTIVATION_IMPL(ACTIVATION_LOG_SOFTMAX);
-    }
+            ~GraphBuilder() { DestroyNodeOutputs(); }
 
-    inline Expression ActivationParameterizedRelu(Expression input, Expression slope)
-    {
-        assert(detail::HasSameOwner({ input, slope }));
+            IDMLDevice* GetDevice() const
+            {
+                return m_device.Get();
+            }
 
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+            void SetTensorPolicy(TensorPolicy policy) { m_tensorPolicy = std::move(policy); }
+            const TensorPolicy& GetTensorPolicy() const { return m_tensorPolicy; }
+            TensorPolicy& GetTensorPolicy() { return m_tensorPolicy; }
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc slopeTensor = slope.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+            // Creates a DML operator node owned by this graph builder and returns a NodeInfo identifier. The
+            // inputs to this node must be supplied in the correct order matching the DML operator.
+            NodeID CreateOperatorNode(DML_OPERATOR_TYPE type, const void* desc, Span<NodeOutput* const> inputs);
+            NodeID CreateInputNode(uint32_t inputIndex);
 
-        DML_ACTIVATION_PARAMETERIZED_RELU_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.SlopeTensor = slopeTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+            // Creates a graph input with a new input index whose contents are known on the host.
+            NodeOutput* CreateConstantInput(TensorDesc tensorDesc, std::vector<uint8_t> data);
+            NodeID CreateReinterpretNode(NodeOutput* input, bool isView = false);
+            NodeOutput* CreateNodeOutput(NodeID node, uint32_t outputIndex, TensorDesc tensorDesc);
+            GraphDesc GetGraphDesc(Span<const Expression> outputs) const;
 
-        detail::NodeOutput* const inputs[] = { input.Impl(), slope.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ACTIVATION_PARAMETERIZED_RELU, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            // Returns the IDMLOperator for an operator node, creating it from the node's desc if necessary. Requires
+            // a device.
+            IDMLOperator* GetOrCreateOperator(uint32_t operatorNodeIndex);
 
-        return output;
-    }
+            // Returns the desc of an operator node, or null if the node's operator was created directly on the device.
+            const DML_OPERATOR_DESC* GetOperatorDesc(uint32_t operatorNodeIndex) const
+            {
+                const OwnedOperatorDesc& desc = m_operatorNodes[operatorNodeIndex].desc;
+                return desc.IsValid() ? desc.Get() : nullptr;
+            }
 
-    inline Expression ActivationParametricSoftplus(Expression input, float alpha, float beta)
-    {
-        DMLX_ACTIVATION_IMPL_2(ACTIVATION_PARAMETRIC_SOFTPLUS, Alpha, alpha, Beta, beta);
-    }
+            const GraphStatistics& GetStatistics() const { return m_statistics; }
+            GraphStatistics& GetStatistics() { return m_statistics; }
 
-    inline Expression ActivationRelu(Expression input)
-    {
-        DMLX_ACTIVATION_IMPL(ACTIVATION_RELU);
-    }
+            uint32_t GetInputCount() const { return static_cast<uint32_t>(m_inputNodes.size()); }
 
-    inline Expression ActivationScaledElu(Expression input, float alpha = 1.67326319217681884765625f, float gamma = 1.05070102214813232421875f)
-    {
-        DMLX_ACTIVATION_IMPL_2(ACTIVATION_SCALED_ELU, Alpha, alpha, Gamma, gamma);
-    }
+            // Host data for constant graph inputs, keyed by graph input index.
+            void SetConstantInputData(uint32_t inputIndex, std::vector<uint8_t> data)
+            {
+                m_constantInputData[inputIndex] = std::make_shared<const std::vector<uint8_t>>(std::move(data));
+            }
 
-    inline Expression ActivationScaledTanh(Expression input, float alpha = 1.0f, float beta = 0.5f)
-    {
-        DMLX_ACTIVATION_IMPL_2(ACTIVATION_SCALED_TANH, Alpha, alpha, Beta, beta);
-    }
-
-    inline Expression ActivationSigmoid(Expression input)
-    {
-        DMLX_ACTIVATION_IMPL(ACTIVATION_SIGMOID);
-    }
-
-    inline Expression ActivationSoftmax(Expression input)
-    {
-        DMLX_ACTIVATION_IMPL(ACTIVATION_SOFTMAX);
-    }
-
-    inline Expression ActivationSoftplus(Expression input, float steepness = 1.0f)
-    {
-        DMLX_ACTIVATION_IMPL_1(ACTIVATION_SOFTPLUS, Steepness, steepness);
-    }
-
-    inline Expression ActivationSoftsign(Expression input)
-    {
-        DMLX_ACTIVATION_IMPL(ACTIVATION_SOFTSIGN);
-    }
+            const std::vector<uint8_t>* GetConstantInputData(uint32_t inputIndex) const
+            {
+                auto it = m_constantInputData.find(inputIndex);
+                return it != m_constantInputData.end() ? it->second.get() : nullptr;
+            }
 
-    inline Expression ActivationTanh(Expression input)
-    {
-        DMLX_ACTIVATION_IMPL(ACTIVATION_TANH);
-    }
+            // Returns the host data behind a node output if it is a (possibly reinterpreted) constant input, or null.
+            const std::vector<uint8_t>* GetConstantData(NodeOutput* output) const;
+
+            // Writes every node in this builder, and which node outputs are the graph outputs, to a versioned binary
+            // blob. Deserialize recreates the nodes in an empty builder and returns the graph outputs.
+            std::vector<uint8_t> Serialize(Span<const Expression> outputs) const;
+            std::vector<NodeOutput*> Deserialize(Span<const uint8_t> data);
+
+            // Recreates the nodes of `source` in this builder, which must be empty, with a batch of `batchSize` items
+            // in the leading dimension of the batched inputs and everything computed from them. Returns the problems
+            // found, numbered as nodes of `source`, and leaves this builder empty if there are any.
+            std::vector<GraphDiagnostic> Rebatch(
+                const GraphBuilder& source,
+                Span<const Expression> outputs,
+                uint32_t batchSize,
+                Span<const uint32_t> batchedInputs,
+                std::vector<NodeOutput*>& rebatchedOutputs);
+
+            // Encodes everything that affects the compiled form of a graph desc: operator descs and tensor layouts,
+            // edges, execution flags and the DirectML target version. Equal encodings compile to interchangeable
+            // operators.
+            std::string EncodeGraphDesc(const GraphDesc& graph, DML_EXECUTION_FLAGS flags) const;
+
+            // Computes a stable hash of EncodeGraphDesc.
+            uint64_t ComputeFingerprint(const GraphDesc& graph, DML_EXECUTION_FLAGS flags) const;
+
+            // When enabled, creating a node identical to an existing one (same operator type, desc and inputs)
+            // returns the existing node instead.
+            void SetCommonSubexpressionElimination(bool enable) { m_commonSubexpressionElimination = enable; }
+            bool GetCommonSubexpressionElimination() const { return m_commonSubexpressionElimination; }
+
+            void SetOptimizations(GraphOptimizations optimizations) { m_optimizations = optimizations; }
+            GraphOptimizations GetOptimizations() const { return m_optimizations; }
+
+            void SetMixedPrecisionPolicy(MixedPrecisionPolicy policy) { m_mixedPrecisionPolicy = std::move(policy); }
+            const MixedPrecisionPolicy& GetMixedPrecisionPolicy() const { return m_mixedPrecisionPolicy; }
+
+            // Copies every node into a new builder with the same settings, and builds the graph desc that Compile
+            // would compile for the given outputs in the copy, after MaterializeViews and Optimize. This builder is left
+            // as it is: operator nodes, constant data and node indices are unchanged. Nodes of the copy record the node
+            // of this builder they were made for (see GetSourceNodeIndex), and its statistics describe the
+            // optimizations applied to it.
+            std::shared_ptr<GraphBuilder> CopyForCompile(Span<const Expression> outputs, GraphDesc& graph) const;
+
+            // Returns the node of the original graph that an operator node of a copy made by CopyForCompile
+            // corresponds to, or UINT32_MAX for nodes that only exist in the copy.
+            uint32_t GetSourceNodeIndex(uint32_t operatorNodeIndex) const { return m_operatorNodes[operatorNodeIndex].sourceIndex; }
+
+            // Applies the enabled graph optimizations ahead of compiling the given outputs. Nodes are rewritten in
+            // place, but the value of every existing NodeOutput is preserved; nodes that are bypassed simply become
+            // unreachable. Only run on copies made by CopyForCompile, since it renumbers operator nodes.
+            void Optimize(Span<const Expression> outputs);
+
+            // Returns the given outputs with every view replaced by a packed copy of it, made with an identity
+            // operator. The copy for each view is created once and reused by later calls.
+            std::vector<Expression> MaterializeViews(Span<const Expression> outputs);
+
+            // Removes every node, constant and statistic, keeping the builder's settings. The arena and node lists
+            // keep their memory for the next graph. Invalidates all NodeOutputs.
+            void Reset();
+
+            GraphArenaStatistics GetArenaStatistics() const;
+            void ReserveArena(size_t size) { m_arena.Reserve(size); }
+
+            // Checks every operator node reachable from the outputs, and the edges between them, without a device.
+            std::vector<GraphDiagnostic> Validate(Span<const Expression> outputs) const;
+
+            // Assigns arena offsets to the operator outputs that the given outputs depend on, other than the outputs
+            // themselves, reusing memory between tensors whose lifetimes don't overlap.
+            MemoryPlan PlanMemory(Span<const Expression> outputs, uint64_t alignment) const;
+
+            // Splits a graph desc into consecutive subgraphs, filling in everything in `plan` except the compiled
+            // operators. Returns one graph desc per partition.
+            std::vector<GraphDesc> PartitionGraphDesc(
+                const GraphDesc& graph,
+                const GraphPartitionOptions& options,
+                GraphPartitionPlan& plan) const;
+
+            // Estimates the cost of each node in a graph desc, in dispatch order.
+            GraphCost EstimateCost(const GraphDesc& graph) const;
+
+            // Follows reinterpret nodes back to the node output that actually produces the tensor. Constant time.
+            NodeOutput* ResolveReinterprets(NodeOutput* output) const;
+
+            // Returns true if the output is a view, or a reinterpret of one, and so must be copied to be a graph output.
+            bool IsView(const NodeOutput* output) const;
+
+            // Operator nodes created while a scope is pushed are named after the scope path, e.g. "backbone/csp3".
+            // SetNodeName names an operator node relative to the current scope path.
+            void PushScope(const char* name);
+            void PopScope();
+            void SetNodeName(NodeID node, const char* name);
+
+            // Returns the name of an operator node, or an empty string if it's unnamed.
+            const char* GetNodeName(uint32_t operatorNodeIndex) const
+            {
+                const char* name = m_operatorNodes[operatorNodeIndex].name;
+                return name ? name : "";
+            }
 
-    inline Expression ActivationThresholdedRelu(Expression input, float alpha = 1.0f)
-    {
-        DMLX_ACTIVATION_IMPL_1(ACTIVATION_THRESHOLDED_RELU, Alpha, alpha);
-    }
+            // Formats a graph desc as a Graphviz digraph or a JSON object, annotated with node names and tensor
+            // types, sizes and byte sizes.
+            std::string FormatGraphDot(const GraphDesc& graph) const;
+            std::string FormatGraphJson(const GraphDesc& graph) const;
 
-    inline Expression ActivationShrink(Expression input, float bias = 0.0f, float threshold = 0.5f)
-    {
-        DMLX_ACTIVATION_IMPL_2(ACTIVATION_SHRINK, Bias, bias, Threshold, threshold);
-    }
+        private:
+            // Copies a list of node inputs into the arena, or allocates a list of null inputs.
+            Span<NodeOutput*> AllocateInputs(Span<NodeOutput* const> inputs);
+            Span<NodeOutput*> AllocateInputs(size_t count);
+
+            // Copies a string into the arena.
+            const char* CopyName(const std::string& name);
+
+            // Returns the key of a node output in m_nodeOutputLookup.
+            std::string GetNodeOutputKey(NodeID node, uint32_t outputIndex, TensorDesc& tensorDesc) const;
+
+            // Creates a node output in the arena without any CSE lookup.
+            NodeOutput* ConstructNodeOutput(NodeID node, uint32_t outputIndex, TensorDesc tensorDesc);
+            void DestroyNodeOutputs();
+
+            std::vector<bool> FindReachableOperatorNodes(Span<const Expression> outputs) const;
+
+            // Counts the consumers of each operator node's outputs among the nodes reachable from `outputs`. Being a
+            // graph output counts as a use.
+            std::vector<uint32_t> CountOperatorNodeUses(
+                Span<const Expression> outputs,
+                const std::vector<bool>& reachable) const;
+
+            void FoldScaleBias(Span<const Expression> outputs);
+            void FuseActivations(Span<const Expression> outputs);
+            void FoldBatchNormalization(Span<const Expression> outputs);
+            void QuantizeWeights(Span<const Expression> outputs);
+            void ConvertToFloat16(Span<const Expression> outputs);
+            void AssignLayouts(Span<const Expression> outputs);
+
+            // Returns a copy of a constant input rearranged into the interleaved channel layout, creating it on first use.
+            NodeOutput* GetInterleavedConstant(NodeOutput* constant);
+
+            // Returns a FLOAT16 copy of a FLOAT32 tensor for the operator node at `consumerIndex`, reusing earlier
+            // copies in `float16Tensors`. Cast nodes created for the copy are added to `moves`, to be moved in front
+            // of the consumer.
+            NodeOutput* GetFloat16Tensor(
+                NodeOutput* input,
+                uint32_t consumerIndex,
+                std::unordered_map<NodeOutput*, NodeOutput*>& float16Tensors,
+                std::vector<std::pair<uint32_t, uint32_t>>& moves);
+
+            // Recreates every node of `source` in this empty builder, with the same node and input indices, and returns
+            // the copies of the given outputs. Operator nodes take their desc from `descs` where it's valid, and node
+            // outputs the desc returned by `getOutputDesc`.
+            std::vector<NodeOutput*> CopyNodes(
+                const GraphBuilder& source,
+                Span<const Expression> outputs,
+                std::vector<OwnedOperatorDesc>& descs,
+                const std::function<const TensorDesc&(const NodeOutput*)>& getOutputDesc);
+
+            // Moves operator nodes in front of other operator nodes, and renumbers every node to match. Creation order
+            // must remain a valid execution order, so the moved nodes can't depend on the nodes they're moved past.
+            // Each pair is (node to move, node to move it in front of), sorted by the second index.
+            void MoveOperatorNodes(const std::vector<std::pair<uint32_t, uint32_t>>& moves);
+
+            // Declared first so that it outlives everything stored in it
+            Arena m_arena;
 
-    inline Expression ActivationCelu(Expression input, float alpha = 1.0f)
-    {
-        DMLX_ACTIVATION_IMPL_1(ACTIVATION_CELU, Alpha, alpha);
-    }
+            Microsoft::WRL::ComPtr<IDMLDevice> m_device;
+            TensorPolicy m_tensorPolicy;
+            GraphOptimizations m_optimizations = GraphOptimizations::Default;
+            MixedPrecisionPolicy m_mixedPrecisionPolicy;
+            std::vector<InputNode> m_inputNodes;
+            std::vector<OperatorNode> m_operatorNodes;
+            std::vector<ReinterpretNode> m_reinterpretNodes;
+            std::vector<NodeOutput*> m_nodeOutputs; // Constructed in the arena, so they never move
+            GraphStatistics m_statistics;
+            // Shared with the copies made by CopyForCompile, which never modify it
+            std::unordered_map<uint32_t, std::shared_ptr<const std::vector<uint8_t>>> m_constantInputData;
+            std::unordered_map<NodeOutput*, NodeOutput*> m_materializedViews;
+
+            // FLOAT16 copies of the constant inputs read by operators converted by mixed precision, and interleaved
+            // copies of those read by operators given the interleaved layout
+            std::unordered_map<NodeOutput*, NodeOutput*> m_float16Constants;
+            std::unordered_map<NodeOutput*, NodeOutput*> m_interleavedConstants;
+
+            // The current scope path, and the length of the path before each pushed scope. The arena copy of the path
+            // is made when the first node in the scope is created.
+            std::string m_scopePath;
+            std::vector<size_t> m_scopePathLengths;
+            const char* m_scopeName = nullptr;
+
+            // Lookup tables for common subexpression elimination, keyed by the encoded node.
+            bool m_commonSubexpressionElimination = false;
+            std::unordered_map<std::string, uint32_t> m_operatorNodeLookup;
+            std::unordered_map<std::string, NodeOutput*> m_nodeOutputLookup;
+
+            // Shared with the copies made on the same device. The number of operators this builder has taken from
+            // each entry of the cache.
+            std::shared_ptr<OperatorCache> m_operatorCache = std::make_shared<OperatorCache>();
+            std::unordered_map<std::string, size_t> m_operatorCacheUses;
+        };
 
-#undef DMLX_ACTIVATION_IMPL
-#undef DMLX_ACTIVATION_IMPL_1
-#undef DMLX_ACTIVATION_IMPL_2
+    } // namespace detail
 
-    // ---------------------------------------------------------------------------------------------------------------
+#ifdef _WIN32
+    using PathChar = wchar_t;
+#else
+    using PathChar = char;
+#endif
 
-    // If not specified, parameters are defaulted to the following values:
-    //   Mode = DML_CONVOLUTION_MODE_CROSS_CORRELATION
-    //   Direction = DML_CONVOLUTION_DIRECTION_FORWARD
-    //   Strides = { 1, 1 } for 2D convolution, { 1, 1, 1 } for 3D convolution
-    //   Dilations = { 1, 1 } for 2D convolution, { 1, 1, 1 } for 3D convolution
-    //   StartPadding = { 0, 0 } for 2D convolution, { 0, 0, 0 } for 3D convolution
-    //   EndPadding = { 0, 0 } for 2D convolution, { 0, 0, 0 } for 3D convolution
-    //   OutputPadding = { 0, 0 } for 2D convolution, { 0, 0, 0 } for 3D convolution
-    //   GroupCount = 1
-    //   FusedActivation = nullptr
-    //   OutputSizes = computed from other parameters
-    inline Expression Convolution(
-        Expression input,
-        Expression filter,
-        Optional<Expression> bias = NullOpt,
-        DML_CONVOLUTION_MODE mode = DML_CONVOLUTION_MODE_CROSS_CORRELATION,
-        DML_CONVOLUTION_DIRECTION direction = DML_CONVOLUTION_DIRECTION_FORWARD,
-        Span<const uint32_t> strides = {},
-        Span<const uint32_t> dilations = {},
-        Span<const uint32_t> startPadding = {},
-        Span<const uint32_t> endPadding = {},
-        Span<const uint32_t> outputPadding = {},
-        uint32_t groupCount = 1,
-        FusedActivation fusedActivation = FusedActivation::None(),
-        TensorDimensions outputSizes = {})
+    namespace detail
     {
-        assert(detail::HasSameOwner({ input, filter }));
-        assert(!bias || detail::HasSameOwner({ input, *bias }));
-
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+#ifndef _WIN32
+        // An errno value as an HRESULT, in the form HRESULT_FROM_WIN32 gives Windows error codes.
+        inline HRESULT HResultFromErrno(int error)
+        {
+            return error > 0 ? static_cast<HRESULT>(0x80070000u | (static_cast<uint32_t>(error) & 0xFFFFu)) : E_FAIL;
+        }
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc filterTensor = filter.Impl()->GetOutputDesc();
-        TensorDesc biasTensor;
-        if (bias)
+        // Throws an errno value: as a std::system_error, which keeps the value and its message, unless errors are
+        // thrown as HRESULTs by WIL.
+        inline void ThrowErrno(int error, const char* operation)
         {
-            biasTensor = bias->Impl()->GetOutputDesc();
+#if __cpp_exceptions && !DMLX_USE_WIL
+            throw std::system_error(error, std::generic_category(), operation);
+#else
+            (void)error;
+            (void)operation;
+            DMLX_THROW(HResultFromErrno(error));
+#endif
         }
+#endif
 
-        uint32_t dimensionCount = static_cast<uint32_t>(inputTensor.sizes.size());
+        // A read-only view of a file mapped into memory.
+        class MappedFile
+        {
+        public:
+            explicit MappedFile(const PathChar* path)
+            {
+#ifdef _WIN32
+                m_file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+                LARGE_INTEGER size = {};
+                if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size))
+                {
+                    HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+                    Close();
+                    DMLX_THROW(hr);
+                }
 
-        assert(dimensionCount == 4 || dimensionCount == 5);
-        uint32_t spatialDimensionCount = dimensionCount - 2;
+                m_size = static_cast<size_t>(size.QuadPart);
+                if (m_size > 0)
+                {
+                    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                    m_view = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+                    if (!m_view)
+                    {
+                        HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+                        Close();
+                        DMLX_THROW(hr);
+                    }
+                }
+#else
+                m_file = open(path, O_RDONLY);
+                struct stat status = {};
+                if (m_file < 0 || fstat(m_file, &status) != 0)
+                {
+                    const int error = errno;
+                    const char* operation = m_file < 0 ? "open" : "fstat";
+                    Close();
+                    ThrowErrno(error, operation);
+                }
 
-        // If the spatial dimension count is 2, we'll just use the first two elements by setting
-        // DimensionCount = 2 in the desc
-        const uint32_t defaultStridesAndDilations[3] = { 1, 1, 1 };
-        const uint32_t defaultPadding[3] = { 0, 0, 0 };
+                m_size = static_cast<size_t>(status.st_size);
+                if (m_size > 0)
+                {
+                    m_view = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+                    if (m_view == MAP_FAILED)
+                    {
+                        const int error = errno;
+                        m_view = nullptr;
+                        Close();
+                        ThrowErrno(error, "mmap");
+                    }
+                }
+#endif
+            }
 
-        assert(strides.empty() || strides.size() == spatialDimensionCount);
-        assert(dilations.empty() || dilations.size() == spatialDimensionCount);
-        assert(startPadding.empty() || startPadding.size() == spatialDimensionCount);
-        assert(endPadding.empty() || endPadding.size() == spatialDimensionCount);
-        assert(outputPadding.empty() || outputPadding.size() == spatialDimensionCount);
-        assert(outputSizes.empty() || outputSizes.size() == inputTensor.sizes.size());
+            ~MappedFile() { Close(); }
 
-        strides = strides.empty() ? Span<const uint32_t>{ defaultStridesAndDilations } : strides;
-        dilations = dilations.empty() ? Span<const uint32_t>{ defaultStridesAndDilations } : dilations;
-        startPadding = startPadding.empty() ? Span<const uint32_t>{ defaultPadding } : startPadding;
-        endPadding = endPadding.empty() ? Span<const uint32_t>{ defaultPadding } : endPadding;
-        outputPadding = outputPadding.empty() ? Span<const uint32_t>{ defaultPadding } : outputPadding;
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
 
-        // Compute the output shapes
+            Span<const uint8_t> GetData() const
+            {
+                return Span<const uint8_t>(static_cast<const uint8_t*>(m_view), m_view ? m_size : 0);
+            }
 
-        if (outputSizes.empty())
+        private:
+            void Close()
+            {
+#ifdef _WIN32
+                if (m_view) { UnmapViewOfFile(m_view); }
+                if (m_mapping) { CloseHandle(m_mapping); }
+                if (m_file != INVALID_HANDLE_VALUE) { CloseHandle(m_file); }
+                m_mapping = nullptr;
+                m_file = INVALID_HANDLE_VALUE;
+#else
+                if (m_view) { munmap(m_view, m_size); }
+                if (m_file >= 0) { close(m_file); }
+                m_file = -1;
+#endif
+                m_view = nullptr;
+            }
+
+#ifdef _WIN32
+            HANDLE m_file = INVALID_HANDLE_VALUE;
+            HANDLE m_mapping = nullptr;
+#else
+            int m_file = -1;
+#endif
+            void* m_view = nullptr;
+            size_t m_size = 0;
+        };
+
+        // Writes a file, replacing any existing file. Returns the error rather than throwing, for callers which can't
+        // throw (such as destructors).
+        inline HRESULT TryWriteBinaryFile(const PathChar* path, Span<const uint8_t> data)
         {
-            if (direction == DML_CONVOLUTION_DIRECTION_FORWARD)
+#ifdef _WIN32
+            HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
             {
-                outputSizes.push_back(inputTensor.sizes[0]); // output[N] = input[N]
-                outputSizes.push_back(filterTensor.sizes[0]); // output[C] = filter[N]
+                return HRESULT_FROM_WIN32(GetLastError());
+            }
 
-                for (uint32_t dim = 0; dim < spatialDimensionCount; ++dim)
+            const uint8_t* bytes = data.data();
+            size_t remaining = data.size();
+            while (remaining > 0)
+            {
+                DWORD chunk = static_cast<DWORD>(std::min<size_t>(remaining, 1u << 30));
+                DWORD written = 0;
+                if (!::WriteFile(file, bytes, chunk, &written, nullptr))
                 {
-                    uint32_t inputSize = inputTensor.sizes[dim + 2];
-                    uint32_t paddedSize = inputSize + startPadding[dim] + endPadding[dim];
-
-                    uint32_t windowSize = filterTensor.sizes[dim + 2];
-                    uint32_t kernelSize = 1 + (windowSize - 1) * dilations[dim];
+                    HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+                    CloseHandle(file);
+                    return hr;
+                }
+                bytes += written;
+                remaining -= written;
+            }
 
-                    assert(kernelSize <= paddedSize);
-                    assert(strides[dim] != 0);
+            CloseHandle(file);
+#else
+            int file = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (file < 0)
+            {
+                return HResultFromErrno(errno);
+            }
 
-                    outputSizes.push_back(1 + (paddedSize - kernelSize) / strides[dim]);
+            const uint8_t* bytes = data.data();
+            size_t remaining = data.size();
+            while (remaining > 0)
+            {
+                ssize_t written = write(file, bytes, remaining);
+                if (written <= 0)
+                {
+                    // write returns 0, without setting errno, if it can't make progress
+                    const HRESULT hr = written < 0 ? HResultFromErrno(errno) : E_FAIL;
+                    close(file);
+                    return hr;
                 }
+                bytes += written;
+                remaining -= static_cast<size_t>(written);
             }
-            else if (direction == DML_CONVOLUTION_DIRECTION_BACKWARD)
+
+            if (close(file) != 0)
             {
-                // TODO: implement me
-                assert(false);
+                return HResultFromErrno(errno);
             }
-            else
+#endif
+            return S_OK;
+        }
+
+        inline void WriteBinaryFile(const PathChar* path, Span<const uint8_t> data)
+        {
+            HRESULT hr = TryWriteBinaryFile(path, data);
+            DMLX_THROW_IF_FAILED(hr);
+        }
+    } // namespace detail
+
+    // Reuses compiled graphs across dml::Graph objects which compile structurally identical graphs (see
+    // Graph::GetFingerprint) on the same device. Attach a cache to graphs with Graph::SetCompilationCache; a cache may
+    // be shared by graphs on different threads. Entries keep the graph encoding that their fingerprint was hashed
+    // from, so a fingerprint collision is a miss rather than a wrong compiled graph.
+    //
+    // If a statistics path is given, per-fingerprint hit and miss counts are loaded from it on construction and
+    // written back, accumulated, by FlushStatistics. A fingerprint that keeps missing across runs identifies a graph
+    // that is redundantly compiled at every process start. The file is text, one fingerprint per line:
+    // "<fingerprint in hex> <hits> <misses>".
+    class GraphCompilationCache
+    {
+    public:
+        struct Counts
+        {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+        };
+
+        GraphCompilationCache() = default;
+
+        explicit GraphCompilationCache(const PathChar* statisticsPath)
+            : m_statisticsPath(statisticsPath)
+        {
+            LoadStatistics();
+        }
+
+        // Writes any unflushed statistics as a last resort; a failure here is ignored, since a destructor can't report
+        // it. Call FlushStatistics first to find out whether the statistics were written.
+        ~GraphCompilationCache()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_statisticsDirty)
             {
-                assert(false);
-                DMLX_THROW(E_UNEXPECTED);
+                (void)WriteStatistics();
             }
         }
 
-        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
-        detail::FusedActivationStorage storage;
-
-        DML_CONVOLUTION_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.FilterTensor = filterTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.BiasTensor = bias ? biasTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.Mode = mode;
-        desc.Direction = direction;
-        desc.DimensionCount = spatialDimensionCount;
-        desc.Strides = strides.data();
-        desc.Dilations = dilations.data();
-        desc.StartPadding = startPadding.data();
-        desc.EndPadding = endPadding.data();
-        desc.OutputPadding = outputPadding.data();
-        desc.GroupCount = groupCount;
-        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+        GraphCompilationCache(const GraphCompilationCache&) = delete;
+        GraphCompilationCache& operator=(const GraphCompilationCache&) = delete;
 
-        SmallVector<detail::NodeOutput*, 3> inputs = { input.Impl(), filter.Impl() };
-        if (bias)
+        // Returns the compiled graph for a fingerprint on a device, or null. Counts a hit or miss. `encoding` is the
+        // graph encoding the fingerprint was hashed from; an entry whose encoding differs is a fingerprint collision,
+        // which counts as a miss.
+        Microsoft::WRL::ComPtr<IDMLCompiledOperator> Find(IDMLDevice* device, uint64_t fingerprint, const std::string& encoding)
         {
-            inputs.push_back(bias->Impl());
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto entry = m_entries.find(Key{ device, fingerprint });
+            Counts& counts = m_counts[fingerprint];
+            m_statisticsDirty = true;
+            if (entry == m_entries.end() || entry->second.encoding != encoding)
+            {
+                ++counts.misses;
+                ++m_totals.misses;
+                return nullptr;
+            }
+
+            ++counts.hits;
+            ++m_totals.hits;
+            return entry->second.compiledGraph;
         }
 
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_CONVOLUTION, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        // Caches a compiled graph, replacing any entry with the same fingerprint on the device.
+        void Insert(IDMLDevice* device, uint64_t fingerprint, std::string encoding, IDMLCompiledOperator* compiledGraph)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_entries[Key{ device, fingerprint }] = Entry{ device, std::move(encoding), compiledGraph };
+        }
 
-        return output;
-    }
+        // Hits and misses in this process.
+        Counts GetCounts() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_totals;
+        }
 
-    // Helper for setting parameters for the Convolution operator. Sample usage:
-    // 
-    //   auto conv = dml::ConvolutionBuilder(...)
-    //        .StartPadding(...)
-    //        .EndPadding(...)
-    //        .Strides(...)
-    //        .Build();
-    // 
-    // Parameters left unspecified will be defaulted with the same values as dml::Convolution().
-    class ConvolutionBuilder
-    {
-    public:
-        ConvolutionBuilder(Expression input, Expression filter, Optional<Expression> bias = NullOpt)
-            : m_input(input), m_filter(filter), m_bias(bias)
-        {}
+        // Hits and misses for one fingerprint, including the counts loaded from the statistics file.
+        Counts GetCounts(uint64_t fingerprint) const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto counts = m_counts.find(fingerprint);
+            return counts != m_counts.end() ? counts->second : Counts{};
+        }
 
-        ConvolutionBuilder& Mode(DML_CONVOLUTION_MODE mode) { m_mode = mode; return *this; }
-        ConvolutionBuilder& Direction(DML_CONVOLUTION_DIRECTION direction) { m_direction = direction; return *this; }
-        ConvolutionBuilder& Strides(Span<const uint32_t> strides) { m_strides.assign(strides.begin(), strides.end()); return *this; }
-        ConvolutionBuilder& Dilations(Span<const uint32_t> dilations) { m_dilations.assign(dilations.begin(), dilations.end()); return *this; }
-        ConvolutionBuilder& StartPadding(Span<const uint32_t> startPadding) { m_startPadding.assign(startPadding.begin(), startPadding.end()); return *this; }
-        ConvolutionBuilder& EndPadding(Span<const uint32_t> endPadding) { m_endPadding.assign(endPadding.begin(), endPadding.end()); return *this; }
-        ConvolutionBuilder& OutputPadding(Span<const uint32_t> outputPadding) { m_outputPadding.assign(outputPadding.begin(), outputPadding.end()); return *this; }
-        ConvolutionBuilder& GroupCount(uint32_t groupCount) { m_groupCount = groupCount; return *this; }
-        ConvolutionBuilder& FusedActivation(FusedActivation fusedActivation) { m_fusedActivation = fusedActivation; return *this; }
-        ConvolutionBuilder& OutputSizes(TensorDimensions outputSizes) { m_outputSizes = std::move(outputSizes); return *this; }
+        // Drops all cached compiled graphs. Statistics are kept.
+        void Clear()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_entries.clear();
+        }
 
-        Expression Build() const
+        // Writes the statistics to the statistics path, if there is one. Throws if the file can't be written; the
+        // statistics stay unflushed, so a later flush (or the destructor) retries.
+        void FlushStatistics()
         {
-            return Convolution(
-                m_input,
-                m_filter,
-                m_bias,
-                m_mode,
-                m_direction,
-                m_strides,
-                m_dilations,
-                m_startPadding,
-                m_endPadding,
-                m_outputPadding,
-                m_groupCount,
-                m_fusedActivation,
-                m_outputSizes);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            HRESULT hr = WriteStatistics();
+            DMLX_THROW_IF_FAILED(hr);
         }
 
     private:
-        Expression m_input;
-        Expression m_filter;
-        Optional<Expression> m_bias;
-        DML_CONVOLUTION_MODE m_mode = DML_CONVOLUTION_MODE_CROSS_CORRELATION;
-        DML_CONVOLUTION_DIRECTION m_direction = DML_CONVOLUTION_DIRECTION_FORWARD;
-        SmallVector<uint32_t, 3> m_strides = {};
-        SmallVector<uint32_t, 3> m_dilations = {};
-        SmallVector<uint32_t, 3> m_startPadding = {};
-        SmallVector<uint32_t, 3> m_endPadding = {};
-        SmallVector<uint32_t, 3> m_outputPadding = {};
-        uint32_t m_groupCount = 1;
-        dml::FusedActivation m_fusedActivation;
-        TensorDimensions m_outputSizes = {};
-    };
-
-    // ---------------------------------------------------------------------------------------------------------------
+        struct Key
+        {
+            IDMLDevice* device;
+            uint64_t fingerprint;
 
-    inline Expression Gemm(
-        Expression a,
-        Expression b,
-        Optional<Expression> c = NullOpt,
-        DML_MATRIX_TRANSFORM transA = DML_MATRIX_TRANSFORM_NONE,
-        DML_MATRIX_TRANSFORM transB = DML_MATRIX_TRANSFORM_NONE,
-        float alpha = 1.0f,
-        float beta = 1.0f,
-        FusedActivation fusedActivation = FusedActivation::None())
-    {
-        assert(detail::HasSameOwner({ a, b }));
-        assert(!c || detail::HasSameOwner({ a, *c }));
+            bool operator==(const Key& other) const
+            {
+                return device == other.device && fingerprint == other.fingerprint;
+            }
+        };
 
-        detail::GraphBuilder* builder = a.Impl()->GetGraphBuilder();
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const
+            {
+                uint64_t hash = detail::HashBytes(&key.fingerprint, sizeof(key.fingerprint));
+                hash = detail::HashBytes(&key.device, sizeof(key.device), hash);
+                return static_cast<size_t>(hash);
+            }
+        };
 
-        TensorDesc aTensor = a.Impl()->GetOutputDesc();
-        TensorDesc bTensor = b.Impl()->GetOutputDesc();
-        TensorDesc cTensor;
-        if (c)
+        struct Entry
         {
-            cTensor = c->Impl()->GetOutputDesc();
-        }
+            // Keeps the device alive so that its address can't be reused by another device
+            Microsoft::WRL::ComPtr<IDMLDevice> device;
+            std::string encoding;
+            Microsoft::WRL::ComPtr<IDMLCompiledOperator> compiledGraph;
+        };
 
-        TensorDimensions outputSizes;
-        outputSizes.push_back(aTensor.sizes[0]); // output[N] = input[N]
-        outputSizes.push_back(aTensor.sizes[1]); // output[C] = input[C]
-        outputSizes.push_back(transA == DML_MATRIX_TRANSFORM_NONE ? aTensor.sizes[2] : aTensor.sizes[3]);
-        outputSizes.push_back(transB == DML_MATRIX_TRANSFORM_NONE ? bTensor.sizes[3] : bTensor.sizes[2]);
+        // Requires m_mutex.
+        HRESULT WriteStatistics()
+        {
+            if (m_statisticsPath.empty())
+            {
+                m_statisticsDirty = false;
+                return S_OK;
+            }
 
-        TensorDesc outputTensor(aTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
-        detail::FusedActivationStorage storage;
+            std::string text;
+            char line[64];
+            for (const auto& counts : m_counts)
+            {
+                snprintf(line, sizeof(line), "%016llx %llu %llu\n",
+                    static_cast<unsigned long long>(counts.first),
+                    static_cast<unsigned long long>(counts.second.hits),
+                    static_cast<unsigned long long>(counts.second.misses));
+                text += line;
+            }
 
-        DML_GEMM_OPERATOR_DESC desc = {};
-        desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.CTensor = c ? cTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.TransA = transA;
-        desc.TransB = transB;
-        desc.Alpha = alpha;
-        desc.Beta = beta;
-        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+            HRESULT hr = detail::TryWriteBinaryFile(
+                m_statisticsPath.c_str(),
+                Span<const uint8_t>(reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+            if (SUCCEEDED(hr))
+            {
+                m_statisticsDirty = false;
+            }
+            return hr;
+        }
 
-        SmallVector<detail::NodeOutput*, 3> inputs = { a.Impl(), b.Impl() };
-        if (c)
+        void LoadStatistics()
         {
-            inputs.push_back(c->Impl());
-        }
+#if __cpp_exceptions
+            // A missing or unreadable file just means there are no previous runs
+            std::string text;
+            try
+            {
+                detail::MappedFile file(m_statisticsPath.c_str());
+                Span<const uint8_t> data = file.GetData();
+                text.assign(data.begin(), data.end());
+            }
+            catch (...)
+            {
+                return;
+            }
 
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_GEMM, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            const char* cursor = text.c_str();
+            while (*cursor)
+            {
+                char* end = nullptr;
+                uint64_t fingerprint = std::strtoull(cursor, &end, 16);
+                Counts counts;
+                counts.hits = std::strtoull(end, &end, 10);
+                counts.misses = std::strtoull(end, &end, 10);
+                if (end == cursor)
+                {
+                    break;
+                }
 
-        return output;
-    }
+                m_counts[fingerprint] = counts;
+                cursor = end;
+                while (*cursor == '\n' || *cursor == '\r')
+                {
+                    ++cursor;
+                }
+            }
+#endif
+        }
 
-    // Helper for setting parameters for the Gemm operator. Parameters left unspecified will be defaulted with the
-    // same values as dml::Gemm().
-    class GemmBuilder
+        std::basic_string<PathChar> m_statisticsPath;
+        mutable std::mutex m_mutex;
+        std::unordered_map<Key, Entry, KeyHash> m_entries;
+        std::unordered_map<uint64_t, Counts> m_counts;
+        Counts m_totals;
+        bool m_statisticsDirty = false;
+    };
+
+    class Expression
     {
     public:
-        GemmBuilder(Expression a, Expression b, Optional<Expression> c = NullOpt)
-            : m_a(a), m_b(b), m_c(c)
+        /*implicit*/ Expression(detail::NodeOutput* nodeOutput = nullptr)
+            : m_nodeOutput(nodeOutput)
         {}
 
-        GemmBuilder& TransA(DML_MATRIX_TRANSFORM transA) { m_transA = transA; return *this; }
-        GemmBuilder& TransB(DML_MATRIX_TRANSFORM transB) { m_transB = transB; return *this; }
-        GemmBuilder& Alpha(float alpha) { m_alpha = alpha; return *this; }
-        GemmBuilder& Beta(float beta) { m_beta = beta; return *this; }
-        GemmBuilder& FusedActivation(FusedActivation fusedActivation) { m_fusedActivation = fusedActivation; return *this; }
+        // Returns a struct containing the required properties of the tensor to hold the output of this expression,
+        // once evaluated.
+        const TensorDesc& GetOutputDesc() const { return Impl()->GetOutputDesc(); }
 
-        Expression Build() const
-        {
-            return Gemm(m_a, m_b, m_c, m_transA, m_transB, m_alpha, m_beta, m_fusedActivation);
-        }
+        // For internal use only
+        detail::NodeOutput* Impl() const { return m_nodeOutput; }
 
     private:
-        Expression m_a;
-        Expression m_b;
-        Optional<Expression> m_c;
-        DML_MATRIX_TRANSFORM m_transA = DML_MATRIX_TRANSFORM_NONE;
-        DML_MATRIX_TRANSFORM m_transB = DML_MATRIX_TRANSFORM_NONE;
-        float m_alpha = 1.0f;
-        float m_beta = 1.0f;
-        dml::FusedActivation m_fusedActivation;
+        detail::NodeOutput* m_nodeOutput; // weak; this is owned by the GraphBuilder
     };
 
-    // ---------------------------------------------------------------------------------------------------------------
+    // The placement of one intermediate tensor in a MemoryPlan.
+    struct MemoryPlanTensor
+    {
+        // The expression whose output is placed. Expressions reinterpreting it (e.g. with Reinterpret or Transpose)
+        // share its placement.
+        Expression expression;
 
-    // If `axes` is not specified, by default this reduces the entire tensor to single element.
-    inline Expression Reduce(Expression input, DML_REDUCE_FUNCTION function, Span<const uint32_t> axes = {})
+        uint64_t offset;
+        uint64_t sizeInBytes;
+
+        // The tensor is live from the operator node producing it to the last operator node reading it, inclusive.
+        // Node indices count every operator expression created in the graph, in creation order, which is also a valid
+        // execution order.
+        uint32_t firstNodeIndex;
+        uint32_t lastNodeIndex;
+    };
+
+    // Assigns every intermediate tensor of a graph an offset in one shared buffer (see Graph::PlanMemory).
+    struct MemoryPlan
     {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        uint32_t dimensionCount = static_cast<uint32_t>(inputTensor.sizes.size());
+        // Ordered by the node index producing each tensor.
+        std::vector<MemoryPlanTensor> tensors;
 
-        SmallVector<uint32_t, 4> defaultAxes;
-        if (axes.empty())
-        {
-            for (uint32_t i = 0; i < dimensionCount; ++i)
-            {
-                defaultAxes.push_back(i);
-            }
-            axes = defaultAxes;
-        }
+        // The size of the buffer holding every tensor in the plan. Tensors that are never live at the same time
+        // share memory, so this is usually much smaller than unsharedSizeInBytes.
+        uint64_t arenaSizeInBytes = 0;
 
-        // Compute the output tensor dimensions
-        TensorDimensions outputSizes;
-        for (uint32_t i = 0; i < dimensionCount; ++i)
+        // The size the tensors would need if each had its own aligned allocation.
+        uint64_t unsharedSizeInBytes = 0;
+
+        uint64_t alignment = 0;
+
+        // Returns the placement of an expression's output, following reinterpreting expressions back to the tensor
+        // they view, or null if that tensor isn't part of the plan (e.g. it's a graph input or output).
+        const MemoryPlanTensor* Find(const Expression& expression) const
         {
-            // If the dimension is to be reduced, this dimension in the output tensor has a size of 1, otherwise
-            // it matches the input tensor.
-            const bool dimensionIsReduced = std::find(axes.begin(), axes.end(), i) != axes.end();
-            if (dimensionIsReduced)
-            {
-                outputSizes.push_back(1);
-            }
-            else
+            detail::NodeOutput* output = expression.Impl();
+            if (!output)
             {
-                outputSizes.push_back(inputTensor.sizes[i]);
+                return nullptr;
             }
-        }
 
-        // ARGMIN and ARGMAX reduction produce a UINT32 output; all other reductions produce an output with the same
-        // type as the input.
-        DML_TENSOR_DATA_TYPE outputDataType;
-        if (function == DML_REDUCE_FUNCTION_ARGMIN || function == DML_REDUCE_FUNCTION_ARGMAX)
-        {
-            outputDataType = DML_TENSOR_DATA_TYPE_UINT32;
-        }
-        else
-        {
-            outputDataType = inputTensor.dataType;
+            auto entry = m_tensorIndices.find(output->GetGraphBuilder()->ResolveReinterprets(output));
+            return entry != m_tensorIndices.end() ? &tensors[entry->second] : nullptr;
         }
 
-        TensorDesc outputTensor(outputDataType, std::move(outputSizes), builder->GetTensorPolicy());
+    private:
+        friend class detail::GraphBuilder;
+        std::unordered_map<const detail::NodeOutput*, size_t> m_tensorIndices;
+    };
 
-        DML_REDUCE_OPERATOR_DESC desc = {};
-        desc.Function = function;
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.AxisCount = static_cast<uint32_t>(axes.size());
-        desc.Axes = axes.data();
+    // Controls how Graph::Partition splits a graph. Partitions are cut from the graph's nodes in execution order;
+    // whichever limit is reached first ends a partition. A node that exceeds a limit on its own gets a partition of
+    // its own. With no limits and no cut points, the whole graph is a single partition.
+    struct GraphPartitionOptions
+    {
+        // The maximum number of operator nodes per partition, or 0 for no limit.
+        uint32_t maxNodeCount = 0;
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_REDUCE, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        // The maximum estimated floating-point operation count per partition, or 0 for no limit.
+        uint64_t maxFlopCount = 0;
 
-        return output;
-    }
+        // A partition ends after the node producing each of these expressions. Cut points on nodes that
+        // optimizations remove from the graph (e.g. an activation fused into its producer) are ignored.
+        std::vector<Expression> cutPoints;
+    };
 
-    inline Expression AveragePooling(
-        Expression input,
-        Span<const uint32_t> strides,
-        Span<const uint32_t> windowSizes,
-        Span<const uint32_t> startPadding,
-        Span<const uint32_t> endPadding,
-        bool includePadding)
+    enum class GraphPartitionBindingType
     {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-
-        assert(strides.size() == windowSizes.size());
-        assert(strides.size() == startPadding.size());
-        assert(strides.size() == endPadding.size());
+        GraphInput,     // index is a graph input index
+        GraphOutput,    // index is a graph output index
+        BoundaryTensor, // index is an index into GraphPartitionPlan::boundaryTensors
+    };
 
-        // Calculate output size
-        TensorDimensions outputSizes;
-        outputSizes.push_back(inputTensor.sizes[0]); // N
-        outputSizes.push_back(inputTensor.sizes[1]); // C
-        for (size_t i = 0; i < windowSizes.size(); ++i)
-        {
-            uint32_t paddedInputSize = inputTensor.sizes[2 + i] + startPadding[i] + endPadding[i];
-            uint32_t outputSize = (paddedInputSize - windowSizes[i]) / strides[i] + 1;
-            outputSizes.push_back(outputSize);
-        }
+    // The buffer bound to one input or output of a partition's compiled operator.
+    struct GraphPartitionBinding
+    {
+        GraphPartitionBindingType type;
+        uint32_t index;
+    };
 
-        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+    // A tensor written by one partition and read by later ones. Its buffer must be allocated by the caller.
+    struct GraphBoundaryTensor
+    {
+        TensorDesc desc;
+        uint32_t producerPartition;
+        uint32_t lastConsumerPartition;
+    };
 
-        DML_AVERAGE_POOLING_OPERATOR_DESC averagePoolDesc = {};
-        averagePoolDesc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        averagePoolDesc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        averagePoolDesc.DimensionCount = static_cast<uint32_t>(windowSizes.size());
-        averagePoolDesc.Strides = strides.data();
-        averagePoolDesc.WindowSize = windowSizes.data();
-        averagePoolDesc.StartPadding = startPadding.data();
-        averagePoolDesc.EndPadding = endPadding.data();
-        averagePoolDesc.IncludePadding = includePadding;
+    struct GraphPartition
+    {
+        Microsoft::WRL::ComPtr<IDMLCompiledOperator> compiledOperator;
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_AVERAGE_POOLING, &averagePoolDesc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        // The structural fingerprint of this partition's graph (see Graph::GetFingerprint). Partitions with the same
+        // fingerprint are interchangeable, so a partition only needs recompiling when its fingerprint changes.
+        uint64_t fingerprint;
 
-        return output;
-    }
+        // The operator nodes in this partition, in the node numbering used by Graph::Validate. Operators added by
+        // optimizations are numbered after the node they were added for, or UINT32_MAX if there's none.
+        std::vector<uint32_t> nodeIndices;
 
-    // 
-    // TODO: LpPooling
-    // 
+        uint64_t estimatedFlopCount;
 
-    // ---------------------------------------------------------------------------------------------------------------
+        // One entry per input and output of compiledOperator, in binding order.
+        std::vector<GraphPartitionBinding> inputs;
+        std::vector<GraphPartitionBinding> outputs;
+    };
 
-    struct MaxPoolingOutputs
+    // A graph split into separately compiled partitions (see Graph::Partition).
+    struct GraphPartitionPlan
     {
-        Expression values;
-        Expression indices; // Only valid if outputIndices = true is supplied to MaxPooling()
+        // In dispatch order. Each partition only reads boundary tensors written by earlier partitions.
+        std::vector<GraphPartition> partitions;
+
+        std::vector<GraphBoundaryTensor> boundaryTensors;
     };
 
-    // If not specified, parameters are defaulted to the following values:
-    //   Strides = 1 for each spatial dimension
-    //   StartPadding = 0 for each spatial dimension
-    //   EndPadding = 0 for each spatial dimension
-    //   Dilations = 1 for each spatial dimension
-    //   OutputIndices = false
-    inline MaxPoolingOutputs MaxPooling(
-        Expression input,
-        Span<const uint32_t> windowSize,
-        Span<const uint32_t> strides = {},
-        Span<const uint32_t> startPadding = {},
-        Span<const uint32_t> endPadding = {},
-        Span<const uint32_t> dilations = {},
-        bool outputIndices = false)
+    // The throughput of the machine a graph is expected to run on. Cost reports use it to estimate each operator's
+    // time as the larger of its compute time and its memory time (a roofline model).
+    struct RooflineModel
     {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        double peakFlopsPerSecond = 0;
+        double memoryBandwidthBytesPerSecond = 0;
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-
-        // If the spatial dimension count is 2, we'll just use the first two elements by setting
-        // DimensionCount = 2 in the desc
-        const uint32_t defaultStridesAndDilations[3] = { 1, 1, 1 };
-        const uint32_t defaultPadding[3] = { 0, 0, 0 };
+        bool IsValid() const { return peakFlopsPerSecond > 0 && memoryBandwidthBytesPerSecond > 0; }
+    };
 
-        assert(windowSize.size() == 2 || windowSize.size() == 3);
-        assert(strides.empty() || strides.size() == windowSize.size());
-        assert(dilations.empty() || dilations.size() == windowSize.size());
-        assert(startPadding.empty() || startPadding.size() == windowSize.size());
-        assert(endPadding.empty() || endPadding.size() == windowSize.size());
+    // Estimated work and memory traffic, derived from operator types and tensor descs (see Graph::EstimateCost).
+    // Bytes count every tensor access by every operator, so tensors read by several operators are counted once per
+    // reader.
+    struct CostEstimate
+    {
+        uint64_t flopCount = 0;
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
 
-        strides = strides.empty() ? Span<const uint32_t>{ defaultStridesAndDilations } : strides;
-        dilations = dilations.empty() ? Span<const uint32_t>{ defaultStridesAndDilations } : dilations;
-        startPadding = startPadding.empty() ? Span<const uint32_t>{ defaultPadding } : startPadding;
-        endPadding = endPadding.empty() ? Span<const uint32_t>{ defaultPadding } : endPadding;
+        uint64_t GetBytesMoved() const { return bytesRead + bytesWritten; }
 
-        // Calculate output size
-        TensorDimensions outputSizes;
-        outputSizes.push_back(inputTensor.sizes[0]); // N
-        outputSizes.push_back(inputTensor.sizes[1]); // C
-        for (size_t i = 0; i < windowSize.size(); i++)
+        // FLOPs per byte moved.
+        double GetArithmeticIntensity() const
         {
-            uint32_t paddedInputSize = inputTensor.sizes[2 + i] + startPadding[i] + endPadding[i];
-            uint32_t dilatedWindowSize = 1 + (windowSize[i] - 1) * dilations[i];
-            uint32_t outputSize = (dilatedWindowSize >= paddedInputSize) ? 1 : (paddedInputSize - dilatedWindowSize) / strides[i] + 1;
-            outputSizes.push_back(outputSize);
+            const uint64_t bytes = GetBytesMoved();
+            return bytes ? static_cast<double>(flopCount) / bytes : 0.0;
         }
 
-        TensorDesc outputTensor(inputTensor.dataType, outputSizes, builder->GetTensorPolicy());
-        TensorDesc outputIndicesTensor(DML_TENSOR_DATA_TYPE_UINT32, std::move(outputSizes), builder->GetTensorPolicy());
-
-        DML_MAX_POOLING2_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputIndicesTensor = outputIndices ? outputIndicesTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
-        desc.DimensionCount = static_cast<uint32_t>(windowSize.size());
-        desc.Strides = strides.data();
-        desc.WindowSize = windowSize.data();
-        desc.StartPadding = startPadding.data();
-        desc.EndPadding = endPadding.data();
-        desc.Dilations = dilations.data();
-
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_MAX_POOLING2, &desc, inputs);
-
-        detail::NodeOutput* outputExpr = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
-        if (outputIndices)
+        // Returns 0 if the model isn't valid.
+        double GetEstimatedSeconds(const RooflineModel& model) const
         {
-            detail::NodeOutput* outputIndicesExpr = builder->CreateNodeOutput(node, 1, std::move(outputIndicesTensor));
-            return { outputExpr, outputIndicesExpr };
+            if (!model.IsValid())
+            {
+                return 0.0;
+            }
+            return std::max(flopCount / model.peakFlopsPerSecond, GetBytesMoved() / model.memoryBandwidthBytesPerSecond);
         }
-        return { outputExpr, Expression() };
-    }
-
-    // Helper for setting parameters for the MaxPooling operator. Sample usage:
-    // 
-    //   auto [out, outIndices] = dml::MaxPoolingBuilder(...)
-    //        .StartPadding(...)
-    //        .EndPadding(...)
-    //        .OutputIndices(...)
-    //        .Build();
-    // 
-    // Parameters left unspecified will be defaulted with the same values as dml::MaxPooling().
-    class MaxPoolingBuilder
-    {
-    public:
-        MaxPoolingBuilder(Expression input, Span<const uint32_t> windowSize)
-            : m_input(input), m_windowSize(windowSize.begin(), windowSize.end())
-        {}
 
-        MaxPoolingBuilder& Strides(Span<const uint32_t> strides) { m_strides.assign(strides.begin(), strides.end()); return *this; }
-        MaxPoolingBuilder& StartPadding(Span<const uint32_t> startPadding) { m_startPadding.assign(startPadding.begin(), startPadding.end()); return *this; }
-        MaxPoolingBuilder& EndPadding(Span<const uint32_t> endPadding) { m_endPadding.assign(endPadding.begin(), endPadding.end()); return *this; }
-        MaxPoolingBuilder& Dilations(Span<const uint32_t> dilations) { m_dilations.assign(dilations.begin(), dilations.end()); return *this; }
-        MaxPoolingBuilder& OutputIndices(bool outputIndices) { m_outputIndices = outputIndices; return *this; }
-
-        MaxPoolingOutputs Build() const
+        // Whether memory traffic, rather than compute, bounds the estimated time under the model.
+        bool IsMemoryBound(const RooflineModel& model) const
         {
-            return MaxPooling(
-                m_input,
-                m_windowSize,
-                m_strides,
-                m_startPadding,
-                m_endPadding,
-                m_dilations,
-                m_outputIndices);
+            return GetBytesMoved() / model.memoryBandwidthBytesPerSecond >= flopCount / model.peakFlopsPerSecond;
         }
 
-    private:
-        Expression m_input;
-        SmallVector<uint32_t, 3> m_windowSize;
-        SmallVector<uint32_t, 3> m_strides = {};
-        SmallVector<uint32_t, 3> m_startPadding = {};
-        SmallVector<uint32_t, 3> m_endPadding = {};
-        SmallVector<uint32_t, 3> m_dilations = {};
-        bool m_outputIndices = false;
+        CostEstimate& operator+=(const CostEstimate& other)
+        {
+            flopCount += other.flopCount;
+            bytesRead += other.bytesRead;
+            bytesWritten += other.bytesWritten;
+            return *this;
+        }
     };
 
-    // ---------------------------------------------------------------------------------------------------------------
-
-    // 
-    // TODO: MaxUnpooling
-    // 
-
-    // 
-    // TODO: ROIPooling
-    // 
-
-    inline Expression Slice(
-        Expression input,
-        Span<const uint32_t> inputWindowOffsets,
-        Span<const uint32_t> inputWindowSizes,
-        Span<const int32_t> inputWindowStrides)
+    struct OperatorCost : CostEstimate
     {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDimensions outputSizes(inputTensor.sizes);
+        // The operator node, in the node numbering used by Graph::Validate. Operators added by optimizations, such as
+        // casts and layout copies, have the number of the node they were added for, or UINT32_MAX if there's none.
+        uint32_t nodeIndex = 0;
 
-        assert(inputWindowOffsets.size() == outputSizes.size());
-        assert(inputWindowOffsets.size() == inputWindowStrides.size());
-        assert(inputWindowOffsets.size() == inputWindowSizes.size());
+        // DML_OPERATOR_INVALID for operators created directly on the device, whose costs are unknown (zero).
+        DML_OPERATOR_TYPE operatorType = DML_OPERATOR_INVALID;
 
-        for (size_t i = 0; i < outputSizes.size(); i++)
-        {
-            uint32_t minimumInputSize = (inputWindowSizes[i] - 1) / abs(inputWindowStrides[i]) + 1;
-            outputSizes[i] = minimumInputSize;
-        }
+        // The operator's name (see dml::Scope and dml::Name), or empty.
+        std::string name;
+    };
 
-        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+    // The estimated cost of the graph that Graph::Compile would build for a set of outputs.
+    struct GraphCost
+    {
+        // In dispatch order.
+        std::vector<OperatorCost> operators;
 
-        DML_SLICE1_OPERATOR_DESC sliceDesc = {};
-        sliceDesc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        sliceDesc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        sliceDesc.DimensionCount = static_cast<uint32_t>(inputWindowOffsets.size());
-        sliceDesc.InputWindowOffsets = inputWindowOffsets.data();
-        sliceDesc.InputWindowSizes = inputWindowSizes.data();
-        sliceDesc.InputWindowStrides = inputWindowStrides.data();
+        CostEstimate total;
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_SLICE1, &sliceDesc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        // Formats a report of the graph's totals, the totals per operator type, and each operator, with arithmetic
+        // intensities. If the model is valid, the report also estimates times and whether each operator is compute
+        // or memory bound, and sorts operator types and operators by estimated time; otherwise they're sorted by
+        // bytes moved, then FLOPs.
+        std::string FormatText(const RooflineModel& model = {}) const;
 
-        return output;
-    }
+        // Formats the same report as a JSON object.
+        std::string FormatJson(const RooflineModel& model = {}) const;
+    };
 
-    inline Expression Cast(Expression input, DML_TENSOR_DATA_TYPE targetDataType)
+    // One node of a compiled graph (see Graph::Compile).
+    struct CompiledGraphNode
     {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(targetDataType, inputTensor.sizes, builder->GetTensorPolicy());
-
-        DML_CAST_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        // The operator node, in the node numbering used by Graph::Validate. Operators added by optimizations, such as
+        // casts and layout copies, have the number of the node they were added for, or UINT32_MAX if there's none.
+        uint32_t nodeIndex;
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_CAST, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        // DML_OPERATOR_INVALID for operators created directly on the device.
+        DML_OPERATOR_TYPE operatorType;
 
-        return output;
-    }
+        // The operator's name (see dml::Scope and dml::Name), or empty.
+        std::string name;
+    };
 
-    inline std::vector<Expression> Split(
-        Expression input,
-        uint32_t axis,
-        Span<const uint32_t> outputAxisSizes)
+    class Graph
     {
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-        uint32_t axisSizeSum = 0;
+    public:
+        explicit Graph(IDMLDevice* device, TensorPolicy tensorPolicy = {})
+            : m_graphBuilder(make_unique<detail::GraphBuilder>(device, tensorPolicy))
+        {}
 
-        std::vector<TensorDesc> outputTensors;
-        outputTensors.reserve(outputAxisSizes.size());
+        // For internal use only
+        detail::GraphBuilder* Impl() { return m_graphBuilder.get(); }
+        const detail::GraphBuilder* Impl() const { return m_graphBuilder.get(); }
 
-        std::vector<DML_TENSOR_DESC> outputDescs;
-        outputDescs.reserve(outputAxisSizes.size());
+        // Sets/gets the tensor policy. If not set, defaults to TensorPolicy::Default(). Tensor policies can be used
+        // to control properties (such as strides) on output tensors produced by this Graph.
+        void SetTensorPolicy(TensorPolicy policy) { m_graphBuilder->SetTensorPolicy(std::move(policy)); }
+        const TensorPolicy& GetTensorPolicy() const { return m_graphBuilder->GetTensorPolicy(); }
+        TensorPolicy& GetTensorPolicy() { return m_graphBuilder->GetTensorPolicy(); }
 
-        for (uint32_t outputAxisSize : outputAxisSizes)
+        // Returns counters describing the optimizations applied by the most recent Compile or Partition, or only the
+        // counters gathered while building the graph (such as mergedNodeCount) if it hasn't been compiled since it was
+        // built or reset. The other const members that build the compiled graph (GetFingerprint, EstimateCost,
+        // FormatDot, FormatJson) don't change these.
+        GraphStatistics GetStatistics() const
         {
-            TensorDimensions outputSizes = inputTensor.sizes;
-            outputSizes[axis] = outputAxisSize;
+            std::lock_guard<std::mutex> lock(m_compiledGraph->mutex);
+            return m_compiledGraph->builder ? m_compiledGraph->builder->GetStatistics() : m_graphBuilder->GetStatistics();
+        }
 
-            TensorDesc tensorDesc(inputTensor.dataType, outputSizes, builder->GetTensorPolicy());
-            outputTensors.push_back(std::move(tensorDesc));
-            outputDescs.push_back(*outputTensors.back().AsPtr<DML_TENSOR_DESC>());
+        // Removes every expression, constant input and statistic from this graph so that it can be rebuilt (e.g.
+        // after a resolution change) without reallocating its storage. Settings such as the tensor policy,
+        // optimizations and compilation cache are kept. Expressions created before the reset must not be used after
+        // it.
+        void Reset()
+        {
+            m_graphBuilder->Reset();
+            SetCompiledGraph(nullptr);
+        }
 
-            axisSizeSum += outputAxisSize;
+        // Describes the arena holding this graph's nodes. Reserving the high-water mark of a previous build lets the
+        // graph be built without further allocations from the arena.
+        GraphArenaStatistics GetArenaStatistics() const { return m_graphBuilder->GetArenaStatistics(); }
+        void ReserveArena(size_t sizeInBytes) { m_graphBuilder->ReserveArena(sizeInBytes); }
+
+        // Checks the shapes, data types and tensor sizes of every operator the outputs depend on, and the edges
+        // between them, without calling into DirectML. Returns an empty list if no problems were found. This checks
+        // the graph as built, before any optimizations are applied.
+        std::vector<GraphDiagnostic> Validate(Span<const Expression> outputs) const { return m_graphBuilder->Validate(outputs); }
+
+        // Runs liveness analysis over the operators the outputs depend on and places every intermediate tensor in a
+        // single buffer, so that an application dispatching the operators one by one (in node index order) can bind
+        // all of their intermediate results from one allocation. Tensors whose lifetimes don't overlap share memory,
+        // and no operator's outputs overlap its inputs. Offsets and sizes are multiples of the given alignment. Graph
+        // inputs and the requested outputs aren't placed; the caller binds those. This plans the graph as built,
+        // before any optimizations are applied.
+        MemoryPlan PlanMemory(
+            Span<const Expression> outputs,
+            uint64_t alignment = DML_MINIMUM_BUFFER_TENSOR_ALIGNMENT) const
+        {
+            return m_graphBuilder->PlanMemory(outputs, alignment);
         }
 
-        assert(axisSizeSum == inputTensor.sizes[axis]);
+        // Splits the graph that Compile would build into several smaller graphs and compiles each of them, consulting
+        // the compilation cache if one is set. Dispatching the partitions in order, with the inputs and outputs bound
+        // as described by the plan, computes the same outputs as the single compiled graph. Smaller graphs compile
+        // faster, can be recompiled independently and can be interleaved with other work on a queue.
+        GraphPartitionPlan Partition(
+            DML_EXECUTION_FLAGS flags,
+            Span<const Expression> outputs,
+            const GraphPartitionOptions& options) const
+        {
+            if (!m_graphBuilder->GetDevice())
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
 
-        DML_SPLIT_OPERATOR_DESC desc = {};
-        desc.Axis = axis;
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensors = outputDescs.data();
-        desc.OutputCount = static_cast<uint32_t>(outputAxisSizes.size());
+            detail::GraphDesc graph;
+            std::shared_ptr<detail::GraphBuilder> builder = BuildGraphDesc(outputs, graph);
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_SPLIT, &desc, inputs);
+            GraphPartitionPlan plan;
+            std::vector<detail::GraphDesc> partitionGraphs = builder->PartitionGraphDesc(graph, options, plan);
+            SetCompiledGraph(builder);
 
-        std::vector<Expression> outputs;
-        outputs.reserve(outputAxisSizes.size());
+            for (size_t i = 0; i < partitionGraphs.size(); ++i)
+            {
+                plan.partitions[i].compiledOperator =
+                    CompileGraphDesc(*builder, partitionGraphs[i], flags, &plan.partitions[i].fingerprint);
+            }
 
-        for (uint32_t i = 0; i < outputAxisSizes.size(); ++i)
+            return plan;
+        }
+
+        // Enables or disables common subexpression elimination for expressions subsequently added to this graph.
+        // When enabled, expressions with the same operator, attributes and inputs resolve to a single node. Disabled
+        // by default. The node keeps the name of the first expression (see dml::Scope): creating it again under
+        // another scope doesn't rename it, but dml::Name on any of the expressions does.
+        void SetCommonSubexpressionElimination(bool enable) { m_graphBuilder->SetCommonSubexpressionElimination(enable); }
+        bool GetCommonSubexpressionElimination() const { return m_graphBuilder->GetCommonSubexpressionElimination(); }
+
+        // Sets/gets the transformations applied to this graph when it is compiled. Defaults to
+        // GraphOptimizations::Default.
+        void SetOptimizations(GraphOptimizations optimizations) { m_graphBuilder->SetOptimizations(optimizations); }
+        GraphOptimizations GetOptimizations() const { return m_graphBuilder->GetOptimizations(); }
+
+        // Sets/gets the operators run in FLOAT16 when GraphOptimizations::MixedPrecision is enabled.
+        void SetMixedPrecisionPolicy(MixedPrecisionPolicy policy) { m_graphBuilder->SetMixedPrecisionPolicy(std::move(policy)); }
+        const MixedPrecisionPolicy& GetMixedPrecisionPolicy() const { return m_graphBuilder->GetMixedPrecisionPolicy(); }
+
+        // Returns the number of graph inputs, which is the number of input bindings of the operator returned by the
+        // most recent Compile (or of the partitions returned by Partition). Optimizations that rewrite constant
+        // inputs append the inputs they create after the caller's: BatchNormalizationFolding, which is part of
+        // GraphOptimizations::Default, adds a folded filter and bias for each folded normalization, and
+        // WeightQuantization, MixedPrecision and LayoutAssignment add inputs too. So this can exceed the number of
+        // inputs created by the caller, and depends on the outputs last compiled. The caller's input indices never
+        // change. Before the first Compile or Partition, returns the number of inputs created by the caller.
+        uint32_t GetInputCount() const
         {
-            outputs.push_back(builder->CreateNodeOutput(node, i, std::move(outputTensors[i])));
+            std::lock_guard<std::mutex> lock(m_compiledGraph->mutex);
+            const uint32_t inputCount = m_graphBuilder->GetInputCount();
+            return m_compiledGraph->builder ? std::max(inputCount, m_compiledGraph->builder->GetInputCount()) : inputCount;
         }
 
-        return outputs;
-    }
+        // Returns the host data of a constant input (see ConstantInputTensor), including those added by optimizations
+        // to the graph built by the most recent Compile or Partition, or an empty span if the input isn't constant.
+        // After compiling, constant inputs should be bound using this data. Data of an added input stays valid until
+        // the next Compile, Partition or Reset.
+        Span<const uint8_t> GetConstantInputData(uint32_t inputIndex) const
+        {
+            std::lock_guard<std::mutex> lock(m_compiledGraph->mutex);
+            const std::vector<uint8_t>* data = m_graphBuilder->GetConstantInputData(inputIndex);
+            if (!data && m_compiledGraph->builder)
+            {
+                data = m_compiledGraph->builder->GetConstantInputData(inputIndex);
+            }
+            return data ? Span<const uint8_t>(data->data(), data->size()) : Span<const uint8_t>();
+        }
 
-    inline Expression Join(
-        Span<const Expression> inputs,
-        uint32_t axis)
-    {
-        assert(!inputs.empty());
+        // Compiles the expressions in outputs into one operator, after applying the graph's optimizations (see
+        // SetOptimizations). The compiled operator's inputs are the graph's inputs by index, followed by any constant
+        // inputs added by the optimizations; with the default optimizations, folding a batch normalization into the
+        // convolution before it adds two. Size the input bindings with GetInputCount after compiling, and bind every
+        // constant input, including the added ones, to the data from GetConstantInputData. To keep the bindings to
+        // the inputs the caller created, disable the optimizations that add inputs.
+        Microsoft::WRL::ComPtr<IDMLCompiledOperator> Compile(
+            DML_EXECUTION_FLAGS flags,
+            Span<const Expression> outputs) const
+        {
+            if (!m_graphBuilder->GetDevice())
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
 
-        detail::GraphBuilder* builder = inputs[0].Impl()->GetGraphBuilder();
-        DML_TENSOR_DATA_TYPE dataType = inputs[0].Impl()->GetOutputDesc().dataType;
+            detail::GraphDesc graph;
+            std::shared_ptr<detail::GraphBuilder> builder = BuildGraphDesc(outputs, graph);
+            SetCompiledGraph(builder);
+            return CompileGraphDesc(*builder, graph, flags);
+        }
 
-        TensorDimensions outputSizes = inputs[0].Impl()->GetOutputDesc().sizes;
-        outputSizes[axis] = 0;
+        // Compiles the graph as above, and also describes each node of the compiled graph, in the compiled graph's
+        // node order. Per-node timings from profiling tools can be matched to expressions through this list. Node
+        // names are also passed to DirectML, but they don't contribute to the graph's fingerprint, so a graph found
+        // in the compilation cache keeps the names it was compiled with.
+        Microsoft::WRL::ComPtr<IDMLCompiledOperator> Compile(
+            DML_EXECUTION_FLAGS flags,
+            Span<const Expression> outputs,
+            std::vector<CompiledGraphNode>& nodes) const
+        {
+            if (!m_graphBuilder->GetDevice())
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
 
-        std::vector<TensorDesc> inputTensors;
-        inputTensors.reserve(inputs.size());
+            detail::GraphDesc graph;
+            std::shared_ptr<detail::GraphBuilder> builder = BuildGraphDesc(outputs, graph);
 
-        std::vector<DML_TENSOR_DESC> inputDescs;
-        inputDescs.reserve(inputs.size());
+            nodes.clear();
+            nodes.reserve(graph.nodes.size());
+            for (uint32_t nodeIndex : graph.nodes)
+            {
+                const DML_OPERATOR_DESC* desc = builder->GetOperatorDesc(nodeIndex);
+                nodes.push_back(CompiledGraphNode{
+                    builder->GetSourceNodeIndex(nodeIndex),
+                    desc ? desc->Type : DML_OPERATOR_INVALID,
+                    builder->GetNodeName(nodeIndex) });
+            }
 
-        std::vector<detail::NodeOutput*> inputNodes;
-        inputNodes.reserve(inputs.size());
+            SetCompiledGraph(builder);
+            return CompileGraphDesc(*builder, graph, flags);
+        }
 
-        for (Expression input : inputs)
+        // Returns the name of an operator node, in the node numbering used by Graph::Validate, or an empty string if
+        // the node is unnamed (see dml::Scope and dml::Name).
+        const char* GetNodeName(uint32_t operatorNodeIndex) const { return m_graphBuilder->GetNodeName(operatorNodeIndex); }
+
+        // Formats the graph that Compile would build for these outputs as a Graphviz digraph, for viewing with e.g.
+        // `dot -Tsvg`. Operators are labeled with their node index, type and name, and edges with the data type,
+        // sizes and byte size of the tensor they carry. Applies this graph's optimizations, as Compile does. Doesn't
+        // need a device.
+        std::string FormatDot(Span<const Expression> outputs) const
         {
-            inputTensors.push_back(input.Impl()->GetOutputDesc());
-            TensorDesc& inputTensor = inputTensors.back();
-            outputSizes[axis] += inputTensor.sizes[axis];
-            inputDescs.push_back(*inputTensor.AsPtr<DML_TENSOR_DESC>());
-            inputNodes.push_back(input.Impl());
+            detail::GraphDesc graph;
+            return BuildGraphDesc(outputs, graph)->FormatGraphDot(graph);
         }
 
-        TensorDesc outputTensor(dataType, std::move(outputSizes), builder->GetTensorPolicy());
-
-        DML_JOIN_OPERATOR_DESC desc = {};
-        desc.Axis = axis;
-        desc.InputCount = static_cast<uint32_t>(inputDescs.size());
-        desc.InputTensors = inputDescs.data();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        // Formats the same graph as FormatDot as a JSON object with "inputs", "nodes", "outputs" and "edges" arrays.
+        std::string FormatJson(Span<const Expression> outputs) const
+        {
+            detail::GraphDesc graph;
+            return BuildGraphDesc(outputs, graph)->FormatGraphJson(graph);
+        }
 
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_JOIN, &desc, inputNodes);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        // For internal use only. Builds the graph that Compile would build for these outputs: a copy of this graph
+        // with its optimizations applied, leaving this graph as it is. Node indices in `graph` refer to the returned
+        // copy, which holds the constant inputs added by optimizations and the optimization statistics. Doesn't
+        // modify this graph, so it may be called concurrently with other const members.
+        std::shared_ptr<detail::GraphBuilder> BuildGraphDesc(Span<const Expression> outputs, detail::GraphDesc& graph) const
+        {
+            return m_graphBuilder->CopyForCompile(outputs, graph);
+        }
 
-        return output;
-    }
+        // Returns the structural fingerprint of the graph that Compile would build for these arguments. Graphs with
+        // the same fingerprint compile to interchangeable operators. Applies this graph's optimizations, as Compile
+        // does.
+        uint64_t GetFingerprint(DML_EXECUTION_FLAGS flags, Span<const Expression> outputs) const
+        {
+            detail::GraphDesc graph;
+            return BuildGraphDesc(outputs, graph)->ComputeFingerprint(graph, flags);
+        }
 
-    inline Expression Padding(
-        Expression input,
-        DML_PADDING_MODE paddingMode,
-        float paddingValue,
-        Span<const uint32_t> startPadding,
-        Span<const uint32_t> endPadding)
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        // Estimates the FLOPs and memory traffic of every operator in the graph that Compile would build for these
+        // outputs, from operator types and tensor descs alone. Applies this graph's optimizations, as Compile does,
+        // so fused operators are costed once. Doesn't need a device.
+        GraphCost EstimateCost(Span<const Expression> outputs) const
+        {
+            detail::GraphDesc graph;
+            return BuildGraphDesc(outputs, graph)->EstimateCost(graph);
+        }
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDimensions outputSizes = inputTensor.sizes;
+        // Sets a cache that Compile consults before compiling and populates afterwards. Null (the default) disables
+        // caching.
+        void SetCompilationCache(std::shared_ptr<GraphCompilationCache> cache) { m_compilationCache = std::move(cache); }
+        const std::shared_ptr<GraphCompilationCache>& GetCompilationCache() const { return m_compilationCache; }
 
-        assert(outputSizes.size() == startPadding.size());
-        assert(outputSizes.size() == endPadding.size());
+        // Serializes every expression in this graph, including constant input data, to a versioned binary blob. The
+        // given outputs are recorded so that they can be recovered by Deserialize. Graph settings such as the tensor
+        // policy and optimizations aren't serialized.
+        std::vector<uint8_t> Serialize(Span<const Expression> outputs) const
+        {
+            return m_graphBuilder->Serialize(outputs);
+        }
 
-        for (size_t i = 0; i < outputSizes.size(); i++)
+        // Recreates the expressions of a serialized graph in this graph, which must be empty. Returns the outputs
+        // that were passed to Serialize.
+        std::vector<Expression> Deserialize(Span<const uint8_t> data)
         {
-            outputSizes[i] += startPadding[i] + endPadding[i];
+            std::vector<detail::NodeOutput*> outputs = m_graphBuilder->Deserialize(data);
+            return std::vector<Expression>(outputs.begin(), outputs.end());
         }
 
-        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+        void Save(const PathChar* path, Span<const Expression> outputs) const
+        {
+            std::vector<uint8_t> data = Serialize(outputs);
+            detail::WriteBinaryFile(path, data);
+        }
 
-        DML_PADDING_OPERATOR_DESC paddingDesc = {};
-        paddingDesc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        paddingDesc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        paddingDesc.PaddingMode = paddingMode;
-        paddingDesc.PaddingValue = paddingValue;
-        paddingDesc.DimensionCount = static_cast<uint32_t>(startPadding.size());
-        paddingDesc.StartPadding = startPadding.data();
-        paddingDesc.EndPadding = endPadding.data();
+        // Loads a graph written by Save. The file is memory-mapped rather than read into a buffer, and is decoded as
+        // by Deserialize: constant input data is copied into the graph, so the file is closed when Load returns.
+        std::vector<Expression> Load(const PathChar* path)
+        {
+            detail::MappedFile file(path);
+            return Deserialize(file.GetData());
+        }
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_PADDING, &paddingDesc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        // Rebuilds a graph with a batch size of 1 in this graph, which must be empty, so that it runs `batchSize`
+        // items at once. The batch is the leading dimension of the listed graph inputs (by default, every input
+        // without constant data whose leading dimension is 1) and of everything computed from them. Other inputs,
+        // such as weights, keep their descs and input indices, so the same resources can be bound to both graphs.
+        // Reshapes that fold the batch into their leading dimension are rewritten to fold all of the items.
+        //
+        // Returns the problems that prevent rebatching, numbered as nodes of the source graph, in which case this
+        // graph is left empty. Otherwise fills `outputs` with the rebatched counterparts of `sourceOutputs`. Graph
+        // settings such as the tensor policy and optimizations aren't copied.
+        std::vector<GraphDiagnostic> Rebatch(
+            const Graph& source,
+            Span<const Expression> sourceOutputs,
+            uint32_t batchSize,
+            std::vector<Expression>& outputs,
+            Span<const uint32_t> batchedInputs = {})
+        {
+            std::vector<detail::NodeOutput*> rebatchedOutputs;
+            std::vector<GraphDiagnostic> diagnostics = m_graphBuilder->Rebatch(
+                *source.m_graphBuilder,
+                sourceOutputs,
+                batchSize,
+                batchedInputs,
+                rebatchedOutputs);
+
+            outputs.assign(rebatchedOutputs.begin(), rebatchedOutputs.end());
+            return diagnostics;
+        }
 
-        return output;
-    }
+    private:
+        // Compiles a graph desc built by BuildGraphDesc, whose node indices refer to `builder`.
+        Microsoft::WRL::ComPtr<IDMLCompiledOperator> CompileGraphDesc(
+            detail::GraphBuilder& builder,
+            const detail::GraphDesc& graph,
+            DML_EXECUTION_FLAGS flags,
+            uint64_t* outFingerprint = nullptr) const
+        {
+            std::string encoding;
+            uint64_t fingerprint = 0;
+            if (m_compilationCache || outFingerprint)
+            {
+                encoding = builder.EncodeGraphDesc(graph, flags);
+                fingerprint = detail::HashBytes(encoding.data(), encoding.size());
+            }
+            if (outFingerprint)
+            {
+                *outFingerprint = fingerprint;
+            }
 
-    inline Expression ValueScale2D(
-        Expression input,
-        float scale,
-        Span<const float> bias)
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+            if (m_compilationCache)
+            {
+                if (auto compiledGraph = m_compilationCache->Find(m_graphBuilder->GetDevice(), fingerprint, encoding))
+                {
+                    return compiledGraph;
+                }
+            }
 
-        DML_VALUE_SCALE_2D_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.Scale = scale;
-        desc.ChannelCount = static_cast<uint32_t>(bias.size());
-        desc.Bias = bias.data();
+            // Operators are only created now, and only for the nodes that make it into the graph.
+            std::vector<DML_OPERATOR_GRAPH_NODE_DESC> operatorNodes(graph.nodes.size());
+            for (size_t i = 0; i < operatorNodes.size(); ++i)
+            {
+                operatorNodes[i] = {};
+                operatorNodes[i].Operator = builder.GetOrCreateOperator(graph.nodes[i]);
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_VALUE_SCALE_2D, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+                const char* name = builder.GetNodeName(graph.nodes[i]);
+                operatorNodes[i].Name = *name ? name : nullptr;
+            }
 
-        return output;
-    }
+            std::vector<DML_GRAPH_NODE_DESC> graphNodes(operatorNodes.size());
+            for (size_t i = 0; i < graphNodes.size(); ++i)
+            {
+                graphNodes[i] = { DML_GRAPH_NODE_TYPE_OPERATOR, &operatorNodes[i] };
+            }
 
-    inline Expression Upsample2D(Expression input, DML_SIZE_2D scaleSize, DML_INTERPOLATION_MODE interpolationMode)
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+            std::vector<DML_GRAPH_EDGE_DESC> inputEdges(graph.inputEdges.size());
+            for (size_t i = 0; i < inputEdges.size(); ++i)
+            {
+                inputEdges[i] = { DML_GRAPH_EDGE_TYPE_INPUT, &graph.inputEdges[i] };
+            }
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        assert(inputTensor.sizes.size() == 4 || inputTensor.sizes.size() == 5);
+            std::vector<DML_GRAPH_EDGE_DESC> outputEdges(graph.outputEdges.size());
+            for (size_t i = 0; i < outputEdges.size(); ++i)
+            {
+                outputEdges[i] = { DML_GRAPH_EDGE_TYPE_OUTPUT, &graph.outputEdges[i] };
+            }
 
-        uint32_t i = 0;
-        TensorDimensions outputSizes;
-        outputSizes.push_back(inputTensor.sizes[i++]);                    // output[N] = input[N]
-        outputSizes.push_back(inputTensor.sizes[i++]);                    // output[C] = input[C]
-        if (inputTensor.sizes.size() == 5)
-        {
-            outputSizes.push_back(inputTensor.sizes[i++]);                // output[D] = input[D]
+            std::vector<DML_GRAPH_EDGE_DESC> intermediateEdges(graph.intermediateEdges.size());
+            for (size_t i = 0; i < intermediateEdges.size(); ++i)
+            {
+                intermediateEdges[i] = { DML_GRAPH_EDGE_TYPE_INTERMEDIATE, &graph.intermediateEdges[i] };
+            }
+
+            DML_GRAPH_DESC graphDesc = {};
+            graphDesc.InputCount = graph.inputCount;
+            graphDesc.OutputCount = graph.outputCount;
+            graphDesc.NodeCount = static_cast<UINT>(graphNodes.size());
+            graphDesc.Nodes = graphNodes.data();
+            graphDesc.InputEdgeCount = static_cast<UINT>(inputEdges.size());
+            graphDesc.InputEdges = inputEdges.data();
+            graphDesc.OutputEdgeCount = static_cast<UINT>(outputEdges.size());
+            graphDesc.OutputEdges = outputEdges.data();
+            graphDesc.IntermediateEdgeCount = static_cast<UINT>(intermediateEdges.size());
+            graphDesc.IntermediateEdges = intermediateEdges.data();
+
+            Microsoft::WRL::ComPtr<IDMLDevice1> device1;
+            DMLX_THROW_IF_FAILED(m_graphBuilder->GetDevice()->QueryInterface(IID_PPV_ARGS(&device1)));
+
+            Microsoft::WRL::ComPtr<IDMLCompiledOperator> compiledGraph;
+            DMLX_THROW_IF_FAILED(device1->CompileGraph(&graphDesc, flags, IID_PPV_ARGS(&compiledGraph)));
+
+            if (m_compilationCache)
+            {
+                m_compilationCache->Insert(m_graphBuilder->GetDevice(), fingerprint, std::move(encoding), compiledGraph.Get());
+            }
+
+            return compiledGraph;
         }
-        outputSizes.push_back(inputTensor.sizes[i++] * scaleSize.Height); // output[H] = input[H] * scaleH
-        outputSizes.push_back(inputTensor.sizes[i++] * scaleSize.Width);  // output[W] = input[W] * scaleW
-        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
 
-        DML_UPSAMPLE_2D_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ScaleSize = scaleSize;
-        desc.InterpolationMode = interpolationMode;
+        // Makes a copy built by BuildGraphDesc the source of GetInputCount, GetConstantInputData and GetStatistics.
+        void SetCompiledGraph(std::shared_ptr<const detail::GraphBuilder> builder) const
+        {
+            std::lock_guard<std::mutex> lock(m_compiledGraph->mutex);
+            m_compiledGraph->builder = std::move(builder);
+        }
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_UPSAMPLE_2D, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        // The copy built by the most recent Compile or Partition, which holds the constant inputs added by
+        // optimizations. Held by pointer so that Graph stays movable.
+        struct CompiledGraph
+        {
+            std::mutex mutex;
+            std::shared_ptr<const detail::GraphBuilder> builder;
+        };
 
-        return output;
-    }
+        std::unique_ptr<detail::GraphBuilder> m_graphBuilder;
+        std::shared_ptr<GraphCompilationCache> m_compilationCache;
+        std::unique_ptr<CompiledGraph> m_compiledGraph = make_unique<CompiledGraph>();
+    };
 
-    inline Expression Gather(
-        Expression input,
-        Expression indices,
-        uint32_t axis,
-        uint32_t indexDimensions)
+    // Represents an activation to be fused with an existing operator. The meaning of param1 and param2 depend on the
+    // activation to be fused.
+    // 
+    // For HARD_SIGMOID, LINEAR, PARAMETRIC_SOFTPLUS, and SCALED_TANH: param1 = Alpha and param2 = Beta
+    // For ELU, LEAKY_RELU, THRESHOLDED_RELU, and CELU: param1 = Alpha. param2 is unused.
+    // For SCALED_ELU, param1 = Alpha and param2 = Gamma.
+    // For SHRINK, param1 = Bias and param2 = Threshold
+    // For SOFTPLUS, param1 = Steepness.
+    // For all other activations, both param1 and param2 are unused.
+    struct FusedActivation
     {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc indicesTensor = indices.Impl()->GetOutputDesc();
+        DML_OPERATOR_TYPE activation = DML_OPERATOR_INVALID;
+        float param1 = 0.0f;
+        float param2 = 0.0f;
 
-        uint32_t dimensionCount = static_cast<uint32_t>(inputTensor.sizes.size());
-        assert(indicesTensor.sizes.size() == dimensionCount);
-        assert(axis < dimensionCount);
-        assert(indexDimensions <= dimensionCount);
+        FusedActivation() = default;
 
-        TensorDimensions outputSizes(dimensionCount, 1);
+        explicit FusedActivation(DML_OPERATOR_TYPE activation, float param1 = 0.0f, float param2 = 0.0f)
+            : activation(activation), param1(param1), param2(param2)
+        {}
 
-        // All dimensions after the axis should be the same as the input
-        int outputDim = static_cast<int>(dimensionCount) - 1;
-        for (; static_cast<uint32_t>(outputDim) > axis; --outputDim)
+        static FusedActivation None()
         {
-            outputSizes[outputDim] = inputTensor.sizes[outputDim];
+            return FusedActivation();
         }
 
-        // All dimensions within the range [axis - indexDimensions, axis] should be the same as the indices
-        int indexDim = static_cast<int>(dimensionCount) - 1;
-        for (; outputDim > static_cast<int>(axis) - static_cast<int>(indexDimensions); --outputDim, --indexDim)
+        static FusedActivation Elu(float alpha = 1.0f)
         {
-            outputSizes[outputDim] = indicesTensor.sizes[indexDim];
+            return FusedActivation(DML_OPERATOR_ACTIVATION_ELU, alpha);
         }
 
-        // All dimensions before (axis - indexDimensions) should be the same as the input
-        int inputDim = axis - 1;
-        for (; outputDim >= 0 && inputDim >= 0; --outputDim, --inputDim)
+        static FusedActivation HardSigmoid(float alpha = 0.2f, float beta = 0.5f)
         {
-            outputSizes[outputDim] = inputTensor.sizes[inputDim];
+            return FusedActivation(DML_OPERATOR_ACTIVATION_HARD_SIGMOID, alpha, beta);
         }
 
-        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+        static FusedActivation Identity()
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_IDENTITY);
+        }
 
-        DML_GATHER_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.IndicesTensor = indicesTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.Axis = axis;
-        desc.IndexDimensions = indexDimensions;
+        static FusedActivation LeakyRelu(float alpha = 0.01f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_LEAKY_RELU, alpha);
+        }
 
-        detail::NodeOutput* const inputs[] = { input.Impl(), indices.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_GATHER, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        static FusedActivation Linear(float alpha, float beta)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_LINEAR, alpha, beta);
+        }
 
-        return output;
-    }
+        static FusedActivation ParametricSoftplus(float alpha, float beta)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_PARAMETRIC_SOFTPLUS, alpha, beta);
+        }
 
-    inline Expression GatherElements(
-        Expression input,
-        Expression indices,
-        uint32_t axis)
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc indicesTensor = indices.Impl()->GetOutputDesc();
+        static FusedActivation Relu()
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_RELU);
+        }
 
-        TensorDesc outputTensor(inputTensor.dataType, indicesTensor.sizes, builder->GetTensorPolicy());
+        static FusedActivation ScaledElu(float alpha = 1.67326319217681884765625f, float gamma = 1.05070102214813232421875f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_SCALED_ELU, alpha, gamma);
+        }
 
-        DML_GATHER_ELEMENTS_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.IndicesTensor = indicesTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.Axis = axis;
+        static FusedActivation ScaledTanh(float alpha = 1.0f, float beta = 0.5f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_SCALED_TANH, alpha, beta);
+        }
 
-        detail::NodeOutput* const inputs[] = { input.Impl(), indices.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_GATHER_ELEMENTS, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        static FusedActivation Sigmoid()
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_SIGMOID);
+        }
 
-        return output;
-    }
+        static FusedActivation Softplus(float steepness = 1.0f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_SOFTPLUS, steepness);
+        }
 
-    // 
-    // TODO: GatherND (DML_OPERATOR_GATHER_ND1)
-    // 
+        static FusedActivation Softsign()
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_SOFTSIGN);
+        }
 
-    inline Expression ScatterElements(
-        Expression input,
-        Expression indices,
-        Expression updates,
-        uint32_t axis)
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc indicesTensor = indices.Impl()->GetOutputDesc();
-        TensorDesc updatesTensor = updates.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+        static FusedActivation Tanh()
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_TANH);
+        }
 
-        DML_SCATTER_ELEMENTS_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.IndicesTensor = indicesTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.UpdatesTensor = updatesTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.Axis = axis;
+        static FusedActivation ThresholdedRelu(float alpha = 1.0f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_THRESHOLDED_RELU, alpha);
+        }
 
-        detail::NodeOutput* const inputs[] = { input.Impl(), indices.Impl(), updates.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_SCATTER_ELEMENTS, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        static FusedActivation Shrink(float bias = 0.0f, float threshold = 0.5f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_SHRINK, bias, threshold);
+        }
 
-        return output;
-    }
+        static FusedActivation Celu(float alpha = 1.0f)
+        {
+            return FusedActivation(DML_OPERATOR_ACTIVATION_CELU, alpha);
+        }
+    };
 
-    inline Expression ScatterND(
-        Expression input,
-        Expression indices,
-        Expression updates,
-        uint32_t inputDimensionCount,
-        uint32_t indicesDimensionCount)
+    // Names the operator expressions created in a graph while it's in scope, so that profiler output, cost reports
+    // and graph dumps can be matched to the model code that built them. Scopes nest: expressions created under
+    // Scope(graph, "csp3") inside Scope(graph, "backbone") are named "backbone/csp3". Optimizations that fuse
+    // operators keep the name of the operator doing the work (e.g. the convolution of a fused convolution and
+    // activation).
+    class Scope
     {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc indicesTensor = indices.Impl()->GetOutputDesc();
-        TensorDesc updatesTensor = updates.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+    public:
+        Scope(Graph& graph, const char* name)
+            : m_graphBuilder(graph.Impl())
+        {
+            m_graphBuilder->PushScope(name);
+        }
 
-        DML_SCATTER_ND_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.IndicesTensor = indicesTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.UpdatesTensor = updatesTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.InputDimensionCount = inputDimensionCount;
-        desc.IndicesDimensionCount = indicesDimensionCount;
-
-        detail::NodeOutput* const inputs[] = { input.Impl(), indices.Impl(), updates.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_SCATTER_ND, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        ~Scope() { m_graphBuilder->PopScope(); }
 
-        return output;
-    }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
 
-    // 
-    // TODO: SpaceToDepth (DML_OPERATOR_SPACE_TO_DEPTH1)
-    // 
+    private:
+        detail::GraphBuilder* m_graphBuilder;
+    };
 
-    // 
-    // TODO: DepthToSpace (DML_OPERATOR_DEPTH_TO_SPACE1)
-    // 
+    // Names the operator producing an expression, under the current scope of its graph (e.g. "backbone/conv1"), and
+    // returns the expression. The expression must be the output of an operator, not a graph input or a reinterpreted
+    // tensor.
+    inline Expression Name(Expression expression, const char* name)
+    {
+        detail::NodeOutput* output = expression.Impl();
+        output->GetGraphBuilder()->SetNodeName(output->GetNode(), name);
+        return expression;
+    }
 
-    inline Expression Tile(Expression input, Span<const uint32_t> repeats)
+    // Implementation detail helper for determining if a list of expressions share the same GraphBuilder.
+    namespace detail
     {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-        TensorDimensions outputSizes = input.GetOutputDesc().sizes;
+        inline bool HasSameOwner(Span<const Expression> exprs)
+        {
+            if (exprs.size() == 0)
+            {
+                return true;
+            }
 
-        assert(repeats.size() == outputSizes.size());
+            detail::GraphBuilder* owner = exprs.begin()->Impl()->GetGraphBuilder();
+            for (Expression expr : exprs)
+            {
+                if (expr.Impl()->GetGraphBuilder() != owner)
+                {
+                    return false;
+                }
+            }
 
-        for (size_t i = 0; i < repeats.size(); ++i)
-        {
-            outputSizes[i] *= repeats[i];
+            return true;
         }
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+        inline bool HasSameOwner(std::initializer_list<Expression> exprs)
+        {
+            Span<const Expression> span(exprs.begin(), exprs.size());
+            return HasSameOwner(span);
+        }
 
-        DML_TILE_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.RepeatsCount = static_cast<uint32_t>(repeats.size());
-        desc.Repeats = repeats.data();
+        inline bool HasSameDataType(Span<const Expression> exprs)
+        {
+            if (exprs.size() == 0)
+            {
+                return true;
+            }
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_TILE, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            DML_TENSOR_DATA_TYPE dataType = exprs.begin()->Impl()->GetOutputDesc().dataType;
+            for (Expression expr : exprs)
+            {
+                if (expr.Impl()->GetOutputDesc().dataType != dataType)
+                {
+                    return false;
+                }
+            }
 
-        return output;
-    }
+            return true;
+        }
 
-    // 
-    // TODO: TopK (DML_OPERATOR_TOP_K1)
-    // 
+        inline bool HasSameDataType(std::initializer_list<Expression> exprs)
+        {
+            Span<const Expression> span(exprs.begin(), exprs.size());
+            return HasSameDataType(span);
+        }
 
-    inline Expression BatchNormalization(
-        Expression input,
-        Expression mean,
-        Expression variance,
-        Expression scale,
-        Expression bias,
-        bool spatial,
-        float epsilon,
-        FusedActivation fusedActivation = FusedActivation::None())
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc meanTensor = mean.Impl()->GetOutputDesc();
-        TensorDesc varianceTensor = variance.Impl()->GetOutputDesc();
-        TensorDesc scaleTensor = scale.Impl()->GetOutputDesc();
-        TensorDesc biasTensor = bias.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+        // Computes the NumPy-style broadcast of the given shapes. Sizes are right-aligned against each other, and
+        // every dimension must either match or be 1.
+        inline TensorDimensions GetBroadcastSizes(std::initializer_list<const TensorDimensions*> shapes)
+        {
+            size_t rank = 0;
+            for (const TensorDimensions* shape : shapes)
+            {
+                rank = std::max(rank, shape->size());
+            }
 
-        detail::FusedActivationStorage storage;
+            TensorDimensions sizes(rank, 1);
+            for (const TensorDimensions* shape : shapes)
+            {
+                const size_t offset = rank - shape->size();
+                for (size_t i = 0; i < shape->size(); ++i)
+                {
+                    uint32_t& size = sizes[offset + i];
+                    const uint32_t inputSize = (*shape)[i];
 
-        DML_BATCH_NORMALIZATION_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.MeanTensor = meanTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.VarianceTensor = varianceTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ScaleTensor = scaleTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.BiasTensor = biasTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.Spatial = spatial;
-        desc.Epsilon = epsilon;
-        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+                    if (size == 1)
+                    {
+                        size = inputSize;
+                    }
+                    else if (inputSize != 1 && inputSize != size)
+                    {
+                        DMLX_THROW(E_INVALIDARG);
+                    }
+                }
+            }
 
-        detail::NodeOutput* const inputs[] = { input.Impl(), mean.Impl(), variance.Impl(), scale.Impl(), bias.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_BATCH_NORMALIZATION, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            return sizes;
+        }
 
-        return output;
-    }
+        // Returns the strides of a tensor in elements, computing packed strides if the tensor has none.
+        inline TensorDimensions GetElementStrides(const TensorDesc& tensor)
+        {
+            if (tensor.strides)
+            {
+                return *tensor.strides;
+            }
 
-    inline Expression MeanVarianceNormalization(
-        Expression input,
-        Optional<Expression> scale,
-        Optional<Expression> bias,
-        Span<const uint32_t> axes,
-        bool normalizeVariance,
-        float epsilon,
-        FusedActivation fusedActivation = FusedActivation::None())
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
-        TensorDesc scaleTensor;
-        TensorDesc biasTensor;
+            const size_t rank = tensor.sizes.size();
+            TensorDimensions strides(rank);
+            uint32_t stride = 1;
+            for (size_t i = rank; i-- > 0;)
+            {
+                strides[i] = stride;
+                stride *= tensor.sizes[i];
+            }
 
-        if (scale)
-        {
-            scaleTensor = scale->Impl()->GetOutputDesc();
+            return strides;
         }
-        if (bias)
+
+        // Returns a view of the tensor with the given broadcast sizes. Leading dimensions are added for lower-rank
+        // tensors, and broadcast dimensions are given a stride of 0 so that no copy of the data is needed. The
+        // tensor's existing strides (or packed strides, if it has none) are kept for all other dimensions.
+        inline TensorDesc BroadcastTensor(const TensorDesc& tensor, const TensorDimensions& sizes)
         {
-            biasTensor = bias->Impl()->GetOutputDesc();
-        }
+            if (tensor.sizes == sizes)
+            {
+                return tensor;
+            }
 
-        detail::FusedActivationStorage storage;
+            const size_t rank = tensor.sizes.size();
+            assert(sizes.size() >= rank);
 
-        DML_MEAN_VARIANCE_NORMALIZATION1_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ScaleTensor = scale ? scaleTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
-        desc.BiasTensor = bias ? biasTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.AxisCount = static_cast<UINT>(axes.size());
-        desc.Axes = axes.data();
-        desc.NormalizeVariance = normalizeVariance;
-        desc.Epsilon = epsilon;
-        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+            const TensorDimensions inputStrides = GetElementStrides(tensor);
 
-        detail::NodeOutput* const inputs[] =
+            const size_t offset = sizes.size() - rank;
+            TensorDimensions strides(sizes.size(), 0);
+            for (size_t i = 0; i < rank; ++i)
+            {
+                const uint32_t inputSize = tensor.sizes[i];
+                assert(inputSize == sizes[offset + i] || inputSize == 1);
+
+                strides[offset + i] = (inputSize == sizes[offset + i]) ? inputStrides[i] : 0;
+            }
+
+            return TensorDesc(
+                tensor.dataType,
+                tensor.flags,
+                sizes,
+                std::move(strides),
+                tensor.totalTensorSizeInBytes,
+                tensor.guaranteedBaseOffsetAlignment);
+        }
+
+        // Returns a desc that reads `newTensor` the way an operator's `view` reads `tensor`, where `newTensor` holds
+        // the same elements as `tensor` in another layout or data type. Operators read their inputs either as they
+        // are or broadcast with zero strides (see BroadcastTensor); returns false for any other view. Whether a view
+        // can be mapped doesn't depend on `newTensor`.
+        inline bool MapTensorView(const TensorDesc& view, const TensorDesc& tensor, const TensorDesc& newTensor, TensorDesc& mapped)
         {
-            input.Impl(),
-            scale ? scale->Impl() : nullptr,
-            bias ? bias->Impl() : nullptr
-        };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_MEAN_VARIANCE_NORMALIZATION1, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            const TensorDimensions viewStrides = GetElementStrides(view);
+            const TensorDimensions tensorStrides = GetElementStrides(tensor);
+            if (view.sizes.size() < tensor.sizes.size() || newTensor.sizes != tensor.sizes)
+            {
+                return false;
+            }
 
-        return output;
-    }
+            if (view.sizes == tensor.sizes && viewStrides == tensorStrides)
+            {
+                mapped = newTensor;
+                return true;
+            }
 
-    inline Expression LocalResponseNormalization(
-        Expression input,
-        bool crossChannel,
-        uint32_t localSize,
-        float alpha,
-        float beta,
-        float bias)
+            const TensorDimensions newStrides = GetElementStrides(newTensor);
+            const size_t offset = view.sizes.size() - tensor.sizes.size();
+            TensorDimensions strides(view.sizes.size(), 0);
+            for (size_t i = 0; i < view.sizes.size(); ++i)
+            {
+                const bool isBroadcast = view.sizes[i] == 1 || viewStrides[i] == 0;
+                if (i < offset || tensor.sizes[i - offset] == 1)
+                {
+                    if (!isBroadcast)
+                    {
+                        return false;
+                    }
+                }
+                else if (view.sizes[i] == tensor.sizes[i - offset] && viewStrides[i] == tensorStrides[i - offset])
+                {
+                    strides[i] = newStrides[i - offset];
+                }
+                else
+                {
+                    return false;
+                }
+            }
+
+            mapped = TensorDesc(
+                newTensor.dataType,
+                newTensor.flags,
+                view.sizes,
+                std::move(strides),
+                newTensor.totalTensorSizeInBytes,
+                newTensor.guaranteedBaseOffsetAlignment);
+            return true;
+        }
+    } // namespace detail
+
+    // Shape and type inference. These functions only look at tensor and operator descs, so graphs can be checked on
+    // machines without a DirectML device.
+    namespace detail
     {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+        inline std::string FormatSizes(Span<const uint32_t> sizes)
+        {
+            std::string text = "[";
+            for (size_t i = 0; i < sizes.size(); ++i)
+            {
+                text += (i > 0 ? "," : "") + std::to_string(sizes[i]);
+            }
+            return text + "]";
+        }
 
-        DML_LOCAL_RESPONSE_NORMALIZATION_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.CrossChannel = crossChannel;
-        desc.LocalSize = localSize;
-        desc.Alpha = alpha;
-        desc.Beta = beta;
-        desc.Bias = bias;
+        inline TensorDimensions GetTensorSizes(const DML_TENSOR_DESC* tensor)
+        {
+            const auto* bufferDesc = static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc);
+            return TensorDimensions(bufferDesc->Sizes, bufferDesc->Sizes + bufferDesc->DimensionCount);
+        }
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_LOCAL_RESPONSE_NORMALIZATION, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        inline DML_TENSOR_DATA_TYPE GetTensorDataType(const DML_TENSOR_DESC* tensor)
+        {
+            return static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc)->DataType;
+        }
 
-        return output;
-    }
+        // Computes the output sizes of a convolution. The spatial parameter arrays have one element per spatial
+        // dimension of the input. In the backward direction (a transposed convolution) the filter has sizes
+        // { input channels, output channels / groupCount, spatial sizes... }, and outputPadding is added to the end
+        // of each spatial dimension of the output.
+        inline bool InferConvolutionOutputSizes(
+            DML_CONVOLUTION_DIRECTION direction,
+            Span<const uint32_t> inputSizes,
+            Span<const uint32_t> filterSizes,
+            const uint32_t* strides,
+            const uint32_t* dilations,
+            const uint32_t* startPadding,
+            const uint32_t* endPadding,
+            const uint32_t* outputPadding,
+            uint32_t groupCount,
+            TensorDimensions& outputSizes,
+            std::string& error)
+        {
+            const size_t dimensionCount = inputSizes.size();
+            if (dimensionCount != 4 && dimensionCount != 5)
+            {
+                error = "convolution input must have 4 or 5 dimensions, not " + std::to_string(dimensionCount);
+                return false;
+            }
+            if (filterSizes.size() != dimensionCount)
+            {
+                error = "convolution filter sizes " + FormatSizes(filterSizes) + " don't have the same rank as the input";
+                return false;
+            }
+            if (groupCount == 0 || filterSizes[0] % groupCount != 0)
+            {
+                error = "convolution filter batch size " + std::to_string(filterSizes[0]) +
+                    " isn't divisible by the group count " + std::to_string(groupCount);
+                return false;
+            }
 
-    // 
-    // TODO: LpNormalization
-    // 
+            const bool backward = (direction == DML_CONVOLUTION_DIRECTION_BACKWARD);
+            if (!backward && direction != DML_CONVOLUTION_DIRECTION_FORWARD)
+            {
+                error = "invalid convolution direction";
+                return false;
+            }
 
-    // 
-    // TODO: RNN
-    // 
+            // Forward filters are { output channels, input channels / groupCount, ... }
+            const uint64_t expectedInputChannels = backward ? filterSizes[0] : uint64_t(filterSizes[1]) * groupCount;
+            if (inputSizes[1] != expectedInputChannels)
+            {
+                error = "convolution input has " + std::to_string(inputSizes[1]) + " channels, but the filter " +
+                    FormatSizes(filterSizes) + " expects " + std::to_string(expectedInputChannels);
+                return false;
+            }
 
-    // 
-    // TODO: LSTM
-    // 
+            outputSizes.clear();
+            outputSizes.push_back(inputSizes[0]); // output[N] = input[N]
+            outputSizes.push_back(backward ? filterSizes[1] * groupCount : filterSizes[0]);
 
-    enum class GRUOutputOptions
-    {
-        Both,
-        Sequence,
-        Single,
-    };
+            for (size_t dim = 0; dim < dimensionCount - 2; ++dim)
+            {
+                if (strides[dim] == 0 || dilations[dim] == 0)
+                {
+                    error = "convolution strides and dilations must be nonzero";
+                    return false;
+                }
 
-    struct GRUOutputs
-    {
-        Expression sequence;
-        Expression single; 
-    };
+                const int64_t inputSize = inputSizes[dim + 2];
+                const int64_t kernelSize = 1 + int64_t(filterSizes[dim + 2] - 1) * dilations[dim];
+                const int64_t padding = int64_t(startPadding[dim]) + endPadding[dim];
 
-    inline GRUOutputs GRU(
-        Expression input,
-        Expression weight,
-        Expression recurrence,
-        Optional<Expression> bias,
-        Optional<Expression> hiddenInit,
-        Optional<Expression> sequenceLengths,
-        Span<const FusedActivation> activationDescs,
-        DML_RECURRENT_NETWORK_DIRECTION direction,
-        bool linearBeforeReset,
-        GRUOutputOptions outputOptions)
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc weightTensor = weight.Impl()->GetOutputDesc();
-        TensorDesc recurrenceTensor = recurrence.Impl()->GetOutputDesc();
-        TensorDesc biasTensor;
-        TensorDesc hiddenInitTensor;
-        TensorDesc sequenceLengthsTensor;
-        TensorDesc outputSequenceTensor;
-        TensorDesc outputSingleTensor;
-        if (bias)
-        {
-            biasTensor = bias->Impl()->GetOutputDesc();
+                int64_t outputSize = 0;
+                if (backward)
+                {
+                    if (outputPadding[dim] >= std::max(strides[dim], dilations[dim]))
+                    {
+                        error = "convolution output padding " + std::to_string(outputPadding[dim]) +
+                            " must be smaller than the stride or dilation";
+                        return false;
+                    }
+                    outputSize = (inputSize - 1) * strides[dim] + kernelSize - padding + outputPadding[dim];
+                }
+                else if (kernelSize <= inputSize + padding)
+                {
+                    outputSize = 1 + (inputSize + padding - kernelSize) / strides[dim];
+                }
+
+                if (outputSize <= 0 || outputSize > UINT32_MAX)
+                {
+                    error = "convolution window doesn't fit spatial dimension " + std::to_string(dim) + " of input " +
+                        FormatSizes(inputSizes);
+                    return false;
+                }
+                outputSizes.push_back(static_cast<uint32_t>(outputSize));
+            }
+
+            return true;
         }
-        if (hiddenInit)
+
+        // Computes the output sizes of a GEMM. Both inputs have the same rank, of at least 2, and are multiplied as
+        // matrices in their last two dimensions; the leading dimensions of the output are those of A.
+        inline bool InferGemmOutputSizes(
+            Span<const uint32_t> aSizes,
+            Span<const uint32_t> bSizes,
+            DML_MATRIX_TRANSFORM transA,
+            DML_MATRIX_TRANSFORM transB,
+            TensorDimensions& outputSizes,
+            std::string& error)
         {
-            hiddenInitTensor = hiddenInit->Impl()->GetOutputDesc();
+            if (aSizes.size() < 2 || aSizes.size() != bSizes.size())
+            {
+                error = "GEMM inputs " + FormatSizes(aSizes) + " and " + FormatSizes(bSizes) +
+                    " must have the same rank, of at least 2";
+                return false;
+            }
+
+            const size_t rows = aSizes.size() - 2;
+            const size_t columns = aSizes.size() - 1;
+            const bool isATransposed = (transA == DML_MATRIX_TRANSFORM_TRANSPOSE);
+            const bool isBTransposed = (transB == DML_MATRIX_TRANSFORM_TRANSPOSE);
+            const uint32_t aK = isATransposed ? aSizes[rows] : aSizes[columns];
+            const uint32_t bK = isBTransposed ? bSizes[columns] : bSizes[rows];
+            if (aK != bK)
+            {
+                error = "GEMM inner dimensions of " + FormatSizes(aSizes) + " and " + FormatSizes(bSizes) + " don't match";
+                return false;
+            }
+
+            outputSizes = TensorDimensions(aSizes.begin(), aSizes.end());
+            outputSizes[rows] = isATransposed ? aSizes[columns] : aSizes[rows];
+            outputSizes[columns] = isBTransposed ? bSizes[rows] : bSizes[columns];
+            return true;
         }
-        if (sequenceLengths)
+
+        // Computes the output sizes of a reduction, which keeps reduced dimensions with a size of 1.
+        inline bool InferReduceOutputSizes(
+            Span<const uint32_t> inputSizes,
+            Span<const uint32_t> axes,
+            TensorDimensions& outputSizes,
+            std::string& error)
         {
-            sequenceLengthsTensor = sequenceLengths->Impl()->GetOutputDesc();
+            outputSizes = TensorDimensions(inputSizes.begin(), inputSizes.end());
+            for (uint32_t axis : axes)
+            {
+                if (axis >= outputSizes.size())
+                {
+                    error = "reduction axis " + std::to_string(axis) + " is out of range";
+                    return false;
+                }
+                outputSizes[axis] = 1;
+            }
+            return true;
         }
 
-        TensorDesc::Dimensions outputSequenceSizes(4);
-        TensorDesc::Dimensions outputSingleSizes(4);
-        uint32_t directionCount = (direction == DML_RECURRENT_NETWORK_DIRECTION_BIDIRECTIONAL) ? 2 : 1;
-        if (outputOptions == GRUOutputOptions::Sequence || outputOptions == GRUOutputOptions::Both)
+        // Computes the output sizes of an average or max pooling. The spatial parameter arrays have `dimensionCount`
+        // elements. `dilations` is null for average pooling, whose windows must fit in the padded input; a max pooling
+        // window larger than the padded input produces a single element.
+        inline bool InferPoolingOutputSizes(
+            Span<const uint32_t> inputSizes,
+            UINT dimensionCount,
+            const uint32_t* strides,
+            const uint32_t* windowSizes,
+            const uint32_t* startPadding,
+            const uint32_t* endPadding,
+            const uint32_t* dilations,
+            TensorDimensions& outputSizes,
+            std::string& error)
         {
-            outputSequenceSizes[0] = inputTensor.sizes[1]; // SequenceLength
-            outputSequenceSizes[1] = directionCount;
-            outputSequenceSizes[2] = inputTensor.sizes[2]; // BatchSize
-            outputSequenceSizes[3] = hiddenInitTensor.sizes[3]; // HiddenSize
-            outputSequenceTensor = TensorDesc(inputTensor.dataType, outputSequenceSizes, builder->GetTensorPolicy());
+            if (inputSizes.size() != size_t(dimensionCount) + 2)
+            {
+                error = "DimensionCount " + std::to_string(dimensionCount) +
+                    " doesn't match the spatial dimensions of input " + FormatSizes(inputSizes);
+                return false;
+            }
+
+            outputSizes = TensorDimensions(inputSizes.begin(), inputSizes.end());
+            for (UINT dim = 0; dim < dimensionCount; ++dim)
+            {
+                const uint32_t dilation = dilations ? dilations[dim] : 1;
+                const int64_t paddedSize = int64_t(inputSizes[dim + 2]) + startPadding[dim] + endPadding[dim];
+                const int64_t kernelSize = 1 + int64_t(windowSizes[dim] - 1) * dilation;
+
+                if (strides[dim] == 0 || dilation == 0 || windowSizes[dim] == 0 || (!dilations && kernelSize > paddedSize))
+                {
+                    error = "pooling window doesn't fit spatial dimension " + std::to_string(dim) + " of input " +
+                        FormatSizes(inputSizes);
+                    return false;
+                }
+
+                outputSizes[dim + 2] = kernelSize >= paddedSize ? 1 : static_cast<uint32_t>((paddedSize - kernelSize) / strides[dim] + 1);
+            }
+            return true;
         }
-        if (outputOptions == GRUOutputOptions::Single || outputOptions == GRUOutputOptions::Both)
+
+        // Computes the output sizes of a slice, which has one element per window stride in each dimension.
+        inline bool InferSliceOutputSizes(
+            Span<const uint32_t> inputSizes,
+            UINT dimensionCount,
+            const uint32_t* inputWindowOffsets,
+            const uint32_t* inputWindowSizes,
+            const int32_t* inputWindowStrides,
+            TensorDimensions& outputSizes,
+            std::string& error)
         {
-            outputSingleSizes[0] = 1;
-            outputSingleSizes[1] = directionCount;
-            outputSingleSizes[2] = inputTensor.sizes[2]; // BatchSize
-            outputSingleSizes[3] = hiddenInitTensor.sizes[3]; // HiddenSize
-            outputSingleTensor = TensorDesc(inputTensor.dataType, outputSingleSizes, builder->GetTensorPolicy());
+            if (dimensionCount != inputSizes.size())
+            {
+                error = "slice DimensionCount doesn't match input " + FormatSizes(inputSizes);
+                return false;
+            }
+
+            outputSizes = TensorDimensions(inputSizes.size());
+            for (size_t i = 0; i < inputSizes.size(); ++i)
+            {
+                const int32_t stride = inputWindowStrides[i];
+                if (stride == 0 || inputWindowSizes[i] == 0 ||
+                    uint64_t(inputWindowOffsets[i]) + inputWindowSizes[i] > inputSizes[i])
+                {
+                    error = "slice window in dimension " + std::to_string(i) + " is outside input " + FormatSizes(inputSizes);
+                    return false;
+                }
+                outputSizes[i] = (inputWindowSizes[i] - 1) / static_cast<uint32_t>(stride < 0 ? -int64_t(stride) : stride) + 1;
+            }
+            return true;
         }
 
-        uint32_t activationCount = static_cast<uint32_t>(activationDescs.size());
-        if (activationCount > 4)
+        // Computes the output sizes of a join, whose parts have the same sizes except along `axis`. A split is checked
+        // by joining its outputs.
+        inline bool InferJoinOutputSizes(
+            const std::vector<TensorDimensions>& partSizes,
+            UINT axis,
+            TensorDimensions& outputSizes,
+            std::string& error)
         {
-            DMLX_THROW(E_INVALIDARG);
+            if (partSizes.empty() || axis >= partSizes[0].size())
+            {
+                error = "split/join axis " + std::to_string(axis) + " is out of range";
+                return false;
+            }
+
+            outputSizes = partSizes[0];
+            uint64_t axisSize = 0;
+            for (const TensorDimensions& sizes : partSizes)
+            {
+                TensorDimensions expected = outputSizes;
+                if (sizes.size() == expected.size())
+                {
+                    expected[axis] = sizes[axis];
+                }
+                if (sizes != expected)
+                {
+                    error = "split/join part sizes " + FormatSizes(sizes) + " don't match " + FormatSizes(outputSizes) +
+                        " outside axis " + std::to_string(axis);
+                    return false;
+                }
+                axisSize += sizes[axis];
+            }
+
+            if (axisSize > UINT32_MAX)
+            {
+                error = "split/join parts add up to " + std::to_string(axisSize) + " elements along axis " + std::to_string(axis);
+                return false;
+            }
+            outputSizes[axis] = static_cast<uint32_t>(axisSize);
+            return true;
         }
 
-        detail::FusedActivationStorage storage[4];
-        DML_OPERATOR_DESC activationDescArray[4];
-        for (uint32_t i = 0; i < activationCount; ++i)
+        // Computes the output sizes of a padding, which adds the start and end padding to each dimension.
+        inline bool InferPaddingOutputSizes(
+            Span<const uint32_t> inputSizes,
+            UINT dimensionCount,
+            const uint32_t* startPadding,
+            const uint32_t* endPadding,
+            TensorDimensions& outputSizes,
+            std::string& error)
         {
-            activationDescArray[i] = *detail::GetFusedActivationPtr(activationDescs[i], &storage[i]);
+            if (dimensionCount != inputSizes.size())
+            {
+                error = "padding DimensionCount doesn't match input " + FormatSizes(inputSizes);
+                return false;
+            }
+
+            outputSizes = TensorDimensions(inputSizes.begin(), inputSizes.end());
+            for (size_t i = 0; i < outputSizes.size(); ++i)
+            {
+                outputSizes[i] += startPadding[i] + endPadding[i];
+            }
+            return true;
         }
 
-        DML_GRU_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.WeightTensor = weightTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.RecurrenceTensor = recurrenceTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.BiasTensor = bias ? biasTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
-        desc.HiddenInitTensor = hiddenInit ? hiddenInitTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
-        desc.SequenceLengthsTensor = sequenceLengths ? sequenceLengthsTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
-        desc.OutputSequenceTensor = outputSequenceTensor.sizes.empty() ? nullptr : outputSequenceTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputSingleTensor = outputSingleTensor.sizes.empty() ? nullptr : outputSingleTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ActivationDescCount = activationCount;
-        desc.ActivationDescs = activationDescArray;
-        desc.Direction = direction;
-        desc.LinearBeforeReset = linearBeforeReset;
+        // Computes the output sizes of a tile, which repeats each dimension of the input.
+        inline bool InferTileOutputSizes(
+            Span<const uint32_t> inputSizes,
+            Span<const uint32_t> repeats,
+            TensorDimensions& outputSizes,
+            std::string& error)
+        {
+            if (repeats.size() != inputSizes.size())
+            {
+                error = "tile RepeatsCount doesn't match input " + FormatSizes(inputSizes);
+                return false;
+            }
 
-        SmallVector<detail::NodeOutput*, 6> inputs = { input.Impl(), weight.Impl(), recurrence.Impl() };
-        if (bias)
+            outputSizes = TensorDimensions(inputSizes.begin(), inputSizes.end());
+            for (size_t i = 0; i < outputSizes.size(); ++i)
+            {
+                outputSizes[i] *= repeats[i];
+            }
+            return true;
+        }
+
+        // Computes the output sizes of a 2D upsample, which scales the last two dimensions of a 4D or 5D input.
+        inline bool InferUpsample2DOutputSizes(
+            Span<const uint32_t> inputSizes,
+            DML_SIZE_2D scaleSize,
+            TensorDimensions& outputSizes,
+            std::string& error)
         {
-            inputs.push_back(bias->Impl());
+            if (inputSizes.size() != 4 && inputSizes.size() != 5)
+            {
+                error = "upsample input must have 4 or 5 dimensions";
+                return false;
+            }
+
+            outputSizes = TensorDimensions(inputSizes.begin(), inputSizes.end());
+            outputSizes[outputSizes.size() - 2] *= scaleSize.Height; // output[H] = input[H] * scaleH
+            outputSizes[outputSizes.size() - 1] *= scaleSize.Width;  // output[W] = input[W] * scaleW
+            return true;
         }
-        if (hiddenInit)
+
+        // Computes the output sizes of a gather. The input and indices have the same rank. Along the output, the
+        // dimensions after `axis` come from the input, the `indexDimensions` dimensions ending at `axis` come from the
+        // trailing dimensions of the indices, and the dimensions before them come from the input.
+        inline bool InferGatherOutputSizes(
+            Span<const uint32_t> inputSizes,
+            Span<const uint32_t> indicesSizes,
+            uint32_t axis,
+            uint32_t indexDimensions,
+            TensorDimensions& outputSizes,
+            std::string& error)
         {
-            inputs.push_back(hiddenInit->Impl());
+            const uint32_t dimensionCount = static_cast<uint32_t>(inputSizes.size());
+            if (indicesSizes.size() != dimensionCount || axis >= dimensionCount || indexDimensions > dimensionCount)
+            {
+                error = "gather axis " + std::to_string(axis) + " and index dimensions " + std::to_string(indexDimensions) +
+                    " don't fit input " + FormatSizes(inputSizes) + " and indices " + FormatSizes(indicesSizes);
+                return false;
+            }
+
+            outputSizes = TensorDimensions(dimensionCount, 1);
+
+            // All dimensions after the axis should be the same as the input
+            int outputDim = static_cast<int>(dimensionCount) - 1;
+            for (; static_cast<uint32_t>(outputDim) > axis; --outputDim)
+            {
+                outputSizes[outputDim] = inputSizes[outputDim];
+            }
+
+            // All dimensions within the range [axis - indexDimensions, axis] should be the same as the indices
+            int indexDim = static_cast<int>(dimensionCount) - 1;
+            for (; outputDim > static_cast<int>(axis) - static_cast<int>(indexDimensions); --outputDim, --indexDim)
+            {
+                outputSizes[outputDim] = indicesSizes[indexDim];
+            }
+
+            // All dimensions before (axis - indexDimensions) should be the same as the input
+            int inputDim = static_cast<int>(axis) - 1;
+            for (; outputDim >= 0 && inputDim >= 0; --outputDim, --inputDim)
+            {
+                outputSizes[outputDim] = inputSizes[inputDim];
+            }
+            return true;
         }
-        if (sequenceLengths)
+
+        // Computes the output sizes of a one-hot, which match the indices except along `axis`, where the indices have
+        // a size of 1 and the output has `outputLength` elements. The values tensor holds the off and on values.
+        inline bool InferOneHotOutputSizes(
+            Span<const uint32_t> indicesSizes,
+            Span<const uint32_t> valuesSizes,
+            uint32_t outputLength,
+            uint32_t axis,
+            TensorDimensions& outputSizes,
+            std::string& error)
         {
-            inputs.push_back(sequenceLengths->Impl());
+            if (axis >= indicesSizes.size() || indicesSizes[axis] != 1)
+            {
+                error = "one-hot indices " + FormatSizes(indicesSizes) + " must have a size of 1 along axis " +
+                    std::to_string(axis);
+                return false;
+            }
+
+            uint64_t valueCount = 1;
+            for (uint32_t size : valuesSizes)
+            {
+                valueCount *= size;
+            }
+            if (valuesSizes.size() != indicesSizes.size() || valueCount != 2)
+            {
+                error = "one-hot values " + FormatSizes(valuesSizes) + " must hold 2 elements, with the rank of the indices";
+                return false;
+            }
+
+            outputSizes = TensorDimensions(indicesSizes.begin(), indicesSizes.end());
+            outputSizes[axis] = outputLength;
+            return true;
         }
 
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_GRU, &desc, inputs);
+        // Checks the sizes and scales of a resample or resample gradient, whose input and output have the same rank
+        // and whose `dimensionCount` scales are positive.
+        inline bool ValidateResampleSizes(
+            Span<const uint32_t> inputSizes,
+            Span<const uint32_t> outputSizes,
+            UINT dimensionCount,
+            const float* scales,
+            std::string& error)
+        {
+            if (outputSizes.size() != inputSizes.size() || dimensionCount != inputSizes.size())
+            {
+                error = "resample input " + FormatSizes(inputSizes) + ", output " + FormatSizes(outputSizes) +
+                    " and DimensionCount " + std::to_string(dimensionCount) + " must have the same rank";
+                return false;
+            }
 
-        detail::NodeOutput* outputSequenceExpr = nullptr;
-        detail::NodeOutput* outputSingleExpr = nullptr;
-        if (outputOptions == GRUOutputOptions::Sequence || outputOptions == GRUOutputOptions::Both)
+            for (UINT i = 0; i < dimensionCount; ++i)
+            {
+                if (!(scales[i] > 0.0f))
+                {
+                    error = "resample scale " + std::to_string(scales[i]) + " of dimension " + std::to_string(i) +
+                        " must be positive";
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Computes the sizes of the sequence and single outputs of a GRU from the input { 1, sequence length, batch
+        // size, input size } and the recurrence weights { 1, direction count, 3 * hidden size, hidden size }.
+        inline bool InferGRUOutputSizes(
+            Span<const uint32_t> inputSizes,
+            Span<const uint32_t> weightSizes,
+            Span<const uint32_t> recurrenceSizes,
+            DML_RECURRENT_NETWORK_DIRECTION direction,
+            TensorDimensions& outputSequenceSizes,
+            TensorDimensions& outputSingleSizes,
+            std::string& error)
         {
-             outputSequenceExpr = builder->CreateNodeOutput(node, 0, std::move(outputSequenceTensor));
+            const uint32_t directionCount = (direction == DML_RECURRENT_NETWORK_DIRECTION_BIDIRECTIONAL) ? 2 : 1;
+            if (inputSizes.size() != 4 || weightSizes.size() != 4 || recurrenceSizes.size() != 4)
+            {
+                error = "GRU input, weight and recurrence tensors must have 4 dimensions";
+                return false;
+            }
+
+            const uint32_t hiddenSize = recurrenceSizes[3];
+            const TensorDimensions expectedWeightSizes = { 1, directionCount, 3 * hiddenSize, inputSizes[3] };
+            const TensorDimensions expectedRecurrenceSizes = { 1, directionCount, 3 * hiddenSize, hiddenSize };
+            if (TensorDimensions(weightSizes.begin(), weightSizes.end()) != expectedWeightSizes ||
+                TensorDimensions(recurrenceSizes.begin(), recurrenceSizes.end()) != expectedRecurrenceSizes)
+            {
+                error = "GRU weight " + FormatSizes(weightSizes) + " and recurrence " + FormatSizes(recurrenceSizes) +
+                    " don't match " + FormatSizes(expectedWeightSizes) + " and " + FormatSizes(expectedRecurrenceSizes);
+                return false;
+            }
+
+            outputSequenceSizes = { inputSizes[1], directionCount, inputSizes[2], hiddenSize };
+            outputSingleSizes = { 1, directionCount, inputSizes[2], hiddenSize };
+            return true;
         }
-        if (outputOptions == GRUOutputOptions::Single || outputOptions == GRUOutputOptions::Both)
+
+        // Checks that a tensor desc is well formed, and that its total size covers every element it addresses.
+        inline bool ValidateTensorDesc(const DML_TENSOR_DESC* tensor, std::string& error)
         {
-             outputSingleExpr = builder->CreateNodeOutput(node, 1, std::move(outputSingleTensor));
+            if (tensor->Type != DML_TENSOR_TYPE_BUFFER || tensor->Desc == nullptr)
+            {
+                error = "isn't a buffer tensor";
+                return false;
+            }
+
+            const auto& bufferDesc = *static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc);
+            if (bufferDesc.DataType == DML_TENSOR_DATA_TYPE_UNKNOWN)
+            {
+                error = "has an unknown data type";
+                return false;
+            }
+            if (bufferDesc.DimensionCount == 0 || bufferDesc.DimensionCount > 8 || bufferDesc.Sizes == nullptr)
+            {
+                error = "has " + std::to_string(bufferDesc.DimensionCount) + " dimensions";
+                return false;
+            }
+
+            Span<const uint32_t> sizes(bufferDesc.Sizes, bufferDesc.DimensionCount);
+            if (std::find(sizes.begin(), sizes.end(), 0u) != sizes.end())
+            {
+                error = "has an empty dimension in sizes " + FormatSizes(sizes);
+                return false;
+            }
+
+            const uint64_t requiredSize =
+                DMLCalcBufferTensorSize(bufferDesc.DataType, bufferDesc.DimensionCount, bufferDesc.Sizes, bufferDesc.Strides);
+            if (bufferDesc.TotalTensorSizeInBytes < requiredSize || bufferDesc.TotalTensorSizeInBytes % 4 != 0)
+            {
+                error = "has a total size of " + std::to_string(bufferDesc.TotalTensorSizeInBytes) +
+                    " bytes, but its sizes and strides require " + std::to_string(requiredSize);
+                return false;
+            }
+
+            return true;
         }
-        return { outputSequenceExpr, outputSingleExpr };
-    }
 
-    // 
-    // TODO: DiagonalMatrix
-    //
+        // Checks the tensors of an operator desc against each other and against the shape and type rules of the
+        // operator. Every operator with a schema gets the tensor checks, and the shape rules are shared with the
+        // operator builders through the Infer*OutputSizes functions. Problems are appended to `errors`.
+        inline void ValidateOperatorDesc(const DML_OPERATOR_DESC& desc, std::vector<std::string>& errors)
+        {
+            const OperatorDescTensors tensors = OperatorDescTensors::Get(desc);
 
-    inline Expression OneHot(
-        Expression indices,
-        Expression values,
-        uint32_t outputLength,
-        uint32_t axis)
-    {
-        detail::GraphBuilder* builder = indices.Impl()->GetGraphBuilder();
-        TensorDesc indicesTensor = indices.Impl()->GetOutputDesc();
-        TensorDesc valuesTensor = values.Impl()->GetOutputDesc();
+            const size_t initialErrorCount = errors.size();
+            auto checkTensors = [&](const std::vector<DML_TENSOR_DESC*>& list, const char* kind)
+            {
+                for (size_t i = 0; i < list.size(); ++i)
+                {
+                    std::string error;
+                    if (list[i] && !ValidateTensorDesc(list[i], error))
+                    {
+                        errors.push_back(kind + std::to_string(i) + " " + error);
+                    }
+                }
+            };
+            checkTensors(tensors.inputTensors, "input ");
+            checkTensors(tensors.outputTensors, "output ");
+
+            // The rules below assume well-formed tensors
+            if (errors.size() != initialErrorCount)
+            {
+                return;
+            }
+
+            auto input = [&](size_t i) -> const DML_TENSOR_DESC* { return i < tensors.inputTensors.size() ? tensors.inputTensors[i] : nullptr; };
+            auto output = [&](size_t i) -> const DML_TENSOR_DESC* { return i < tensors.outputTensors.size() ? tensors.outputTensors[i] : nullptr; };
 
-        assert(axis < static_cast<uint32_t>(indicesTensor.sizes.size()));
+            auto checkSizes = [&](const char* name, const DML_TENSOR_DESC* tensor, const TensorDimensions& expected)
+            {
+                if (tensor && GetTensorSizes(tensor) != expected)
+                {
+                    errors.push_back(std::string(name) + " sizes " + FormatSizes(GetTensorSizes(tensor)) +
+                        " don't match the expected " + FormatSizes(expected));
+                }
+            };
+
+            auto checkDataType = [&](const char* name, const DML_TENSOR_DESC* tensor, DML_TENSOR_DATA_TYPE expected)
+            {
+                if (tensor && GetTensorDataType(tensor) != expected)
+                {
+                    errors.push_back(std::string(name) + " data type " + std::to_string(GetTensorDataType(tensor)) +
+                        " doesn't match the expected " + std::to_string(expected));
+                }
+            };
+
+            // Comparisons, IS_NAN, IS_INFINITY and BIT_COUNT write their results as any integer type
+            auto checkIntegerDataType = [&](const char* name, const DML_TENSOR_DESC* tensor)
+            {
+                switch (tensor ? GetTensorDataType(tensor) : DML_TENSOR_DATA_TYPE_UINT8)
+                {
+                case DML_TENSOR_DATA_TYPE_UINT8:
+                case DML_TENSOR_DATA_TYPE_UINT16:
+                case DML_TENSOR_DATA_TYPE_UINT32:
+                case DML_TENSOR_DATA_TYPE_UINT64:
+                case DML_TENSOR_DATA_TYPE_INT8:
+                case DML_TENSOR_DATA_TYPE_INT16:
+                case DML_TENSOR_DATA_TYPE_INT32:
+                case DML_TENSOR_DATA_TYPE_INT64:
+                    break;
+                default:
+                    errors.push_back(std::string(name) + " data type " + std::to_string(GetTensorDataType(tensor)) +
+                        " isn't an integer type");
+                    break;
+                }
+            };
+
+            // Checks the sizes that an Infer*OutputSizes function computed, or records the error it reported
+            auto checkInferredSizes = [&](bool inferred, const char* name, const DML_TENSOR_DESC* tensor,
+                const TensorDimensions& expected, std::string& error)
+            {
+                if (!inferred)
+                {
+                    errors.push_back(std::move(error));
+                    return false;
+                }
+                checkSizes(name, tensor, expected);
+                return true;
+            };
+
+            // Operators that map each input element to the output element at the same position
+            auto checkSameSizesAsFirstInput = [&]()
+            {
+                if (input(0) && output(0))
+                {
+                    checkSizes("output", output(0), GetTensorSizes(input(0)));
+                    checkDataType("output", output(0), GetTensorDataType(input(0)));
+                }
+            };
+
+            // Parameters that are broadcast to the input: they have the input's rank, and each dimension is 1, or the
+            // input's size where `varying` allows it
+            auto checkParameterSizes = [&](const char* name, const DML_TENSOR_DESC* tensor,
+                const TensorDimensions& inputSizes, const std::vector<bool>& varying)
+            {
+                if (!tensor)
+                {
+                    return;
+                }
+
+                const TensorDimensions sizes = GetTensorSizes(tensor);
+                bool broadcastable = sizes.size() == inputSizes.size();
+                for (size_t i = 0; broadcastable && i < sizes.size(); ++i)
+                {
+                    broadcastable = sizes[i] == 1 || (varying[i] && sizes[i] == inputSizes[i]);
+                }
+                if (!broadcastable)
+                {
+                    errors.push_back(std::string(name) + " sizes " + FormatSizes(sizes) +
+                        " can't be broadcast to the input " + FormatSizes(inputSizes));
+                }
+                checkDataType(name, tensor, GetTensorDataType(input(0)));
+            };
+
+            TensorDimensions outputSizes;
+            std::string error;
+
+            switch (desc.Type)
+            {
+            case DML_OPERATOR_CONVOLUTION:
+            {
+                auto& conv = *static_cast<const DML_CONVOLUTION_OPERATOR_DESC*>(desc.Desc);
+                if (GetTensorSizes(conv.InputTensor).size() != size_t(conv.DimensionCount) + 2)
+                {
+                    errors.push_back("DimensionCount " + std::to_string(conv.DimensionCount) +
+                        " doesn't match the spatial dimensions of input " + FormatSizes(GetTensorSizes(conv.InputTensor)));
+                    break;
+                }
+
+                const bool inferred = InferConvolutionOutputSizes(
+                    conv.Direction,
+                    GetTensorSizes(conv.InputTensor),
+                    GetTensorSizes(conv.FilterTensor),
+                    conv.Strides,
+                    conv.Dilations,
+                    conv.StartPadding,
+                    conv.EndPadding,
+                    conv.OutputPadding,
+                    conv.GroupCount,
+                    outputSizes,
+                    error);
+                if (!checkInferredSizes(inferred, "output", conv.OutputTensor, outputSizes, error))
+                {
+                    break;
+                }
+
+                if (conv.BiasTensor)
+                {
+                    TensorDimensions biasSizes(outputSizes.size(), 1);
+                    biasSizes[1] = outputSizes[1];
+                    checkSizes("bias", conv.BiasTensor, biasSizes);
+                }
+
+                const DML_TENSOR_DATA_TYPE dataType = GetTensorDataType(conv.InputTensor);
+                checkDataType("filter", conv.FilterTensor, dataType);
+                checkDataType("bias", conv.BiasTensor, dataType);
+                checkDataType("output", conv.OutputTensor, dataType);
+                break;
+            }
+
+            case DML_OPERATOR_GEMM:
+            {
+                auto& gemm = *static_cast<const DML_GEMM_OPERATOR_DESC*>(desc.Desc);
+                const bool inferred = InferGemmOutputSizes(
+                    GetTensorSizes(gemm.ATensor), GetTensorSizes(gemm.BTensor), gemm.TransA, gemm.TransB, outputSizes, error);
+                if (!checkInferredSizes(inferred, "output", gemm.OutputTensor, outputSizes, error))
+                {
+                    break;
+                }
+
+                const DML_TENSOR_DATA_TYPE dataType = GetTensorDataType(gemm.ATensor);
+                checkDataType("B", gemm.BTensor, dataType);
+                checkDataType("C", gemm.CTensor, dataType);
+                checkDataType("output", gemm.OutputTensor, dataType);
+                break;
+            }
+
+            case DML_OPERATOR_REDUCE:
+            {
+                auto& reduce = *static_cast<const DML_REDUCE_OPERATOR_DESC*>(desc.Desc);
+                const bool inferred = InferReduceOutputSizes(
+                    GetTensorSizes(reduce.InputTensor), Span<const uint32_t>(reduce.Axes, reduce.AxisCount), outputSizes, error);
+                if (!checkInferredSizes(inferred, "output", reduce.OutputTensor, outputSizes, error))
+                {
+                    break;
+                }
+
+                const bool isArgReduction =
+                    reduce.Function == DML_REDUCE_FUNCTION_ARGMIN || reduce.Function == DML_REDUCE_FUNCTION_ARGMAX;
+                if (!isArgReduction)
+                {
+                    checkDataType("output", reduce.OutputTensor, GetTensorDataType(reduce.InputTensor));
+                }
+                break;
+            }
+
+            case DML_OPERATOR_AVERAGE_POOLING:
+            case DML_OPERATOR_MAX_POOLING2:
+            {
+                const bool isMax = (desc.Type == DML_OPERATOR_MAX_POOLING2);
+                auto& average = *static_cast<const DML_AVERAGE_POOLING_OPERATOR_DESC*>(desc.Desc);
+                auto& max = *static_cast<const DML_MAX_POOLING2_OPERATOR_DESC*>(desc.Desc);
+
+                const DML_TENSOR_DESC* inputTensor = isMax ? max.InputTensor : average.InputTensor;
+                const bool inferred = InferPoolingOutputSizes(
+                    GetTensorSizes(inputTensor),
+                    isMax ? max.DimensionCount : average.DimensionCount,
+                    isMax ? max.Strides : average.Strides,
+                    isMax ? max.WindowSize : average.WindowSize,
+                    isMax ? max.StartPadding : average.StartPadding,
+                    isMax ? max.EndPadding : average.EndPadding,
+                    isMax ? max.Dilations : nullptr,
+                    outputSizes,
+                    error);
+                if (!checkInferredSizes(inferred, "output", output(0), outputSizes, error))
+                {
+                    break;
+                }
+
+                checkSizes("output indices", output(1), outputSizes);
+                checkDataType("output", output(0), GetTensorDataType(inputTensor));
+                break;
+            }
+
+            case DML_OPERATOR_SLICE1:
+            {
+                auto& slice = *static_cast<const DML_SLICE1_OPERATOR_DESC*>(desc.Desc);
+                const bool inferred = InferSliceOutputSizes(
+                    GetTensorSizes(slice.InputTensor),
+                    slice.DimensionCount,
+                    slice.InputWindowOffsets,
+                    slice.InputWindowSizes,
+                    slice.InputWindowStrides,
+                    outputSizes,
+                    error);
+                if (checkInferredSizes(inferred, "output", slice.OutputTensor, outputSizes, error))
+                {
+                    checkDataType("output", slice.OutputTensor, GetTensorDataType(slice.InputTensor));
+                }
+                break;
+            }
+
+            case DML_OPERATOR_SPLIT:
+            case DML_OPERATOR_JOIN:
+            {
+                // A split is checked as the join of its outputs
+                const bool isSplit = (desc.Type == DML_OPERATOR_SPLIT);
+                const UINT axis = isSplit ?
+                    static_cast<const DML_SPLIT_OPERATOR_DESC*>(desc.Desc)->Axis :
+                    static_cast<const DML_JOIN_OPERATOR_DESC*>(desc.Desc)->Axis;
+                const DML_TENSOR_DESC* whole = isSplit ? input(0) : output(0);
+                const std::vector<DML_TENSOR_DESC*>& parts = isSplit ? tensors.outputTensors : tensors.inputTensors;
+                const char* partName = isSplit ? "output" : "input";
+
+                std::vector<TensorDimensions> partSizes;
+                for (const DML_TENSOR_DESC* part : parts)
+                {
+                    partSizes.push_back(GetTensorSizes(part));
+                    checkDataType(partName, part, GetTensorDataType(whole));
+                }
+
+                const bool inferred = InferJoinOutputSizes(partSizes, axis, outputSizes, error);
+                checkInferredSizes(inferred, isSplit ? "input" : "output", whole, outputSizes, error);
+                break;
+            }
+
+            case DML_OPERATOR_PADDING:
+            {
+                auto& padding = *static_cast<const DML_PADDING_OPERATOR_DESC*>(desc.Desc);
+                const bool inferred = InferPaddingOutputSizes(
+                    GetTensorSizes(padding.InputTensor),
+                    padding.DimensionCount,
+                    padding.StartPadding,
+                    padding.EndPadding,
+                    outputSizes,
+                    error);
+                if (checkInferredSizes(inferred, "output", padding.OutputTensor, outputSizes, error))
+                {
+                    checkDataType("output", padding.OutputTensor, GetTensorDataType(padding.InputTensor));
+                }
+                break;
+            }
+
+            case DML_OPERATOR_TILE:
+            {
+                auto& tile = *static_cast<const DML_TILE_OPERATOR_DESC*>(desc.Desc);
+                const bool inferred = InferTileOutputSizes(
+                    GetTensorSizes(tile.InputTensor), Span<const uint32_t>(tile.Repeats, tile.RepeatsCount), outputSizes, error);
+                if (checkInferredSizes(inferred, "output", tile.OutputTensor, outputSizes, error))
+                {
+                    checkDataType("output", tile.OutputTensor, GetTensorDataType(tile.InputTensor));
+                }
+                break;
+            }
+
+            case DML_OPERATOR_UPSAMPLE_2D:
+            {
+                auto& upsample = *static_cast<const DML_UPSAMPLE_2D_OPERATOR_DESC*>(desc.Desc);
+                const bool inferred =
+                    InferUpsample2DOutputSizes(GetTensorSizes(upsample.InputTensor), upsample.ScaleSize, outputSizes, error);
+                if (checkInferredSizes(inferred, "output", upsample.OutputTensor, outputSizes, error))
+                {
+                    checkDataType("output", upsample.OutputTensor, GetTensorDataType(upsample.InputTensor));
+                }
+                break;
+            }
+
+            case DML_OPERATOR_GATHER:
+            {
+                auto& gather = *static_cast<const DML_GATHER_OPERATOR_DESC*>(desc.Desc);
+                const bool inferred = InferGatherOutputSizes(
+                    GetTensorSizes(gather.InputTensor),
+                    GetTensorSizes(gather.IndicesTensor),
+                    gather.Axis,
+                    gather.IndexDimensions,
+                    outputSizes,
+                    error);
+                if (checkInferredSizes(inferred, "output", gather.OutputTensor, outputSizes, error))
+                {
+                    checkIntegerDataType("indices", gather.IndicesTensor);
+                    checkDataType("output", gather.OutputTensor, GetTensorDataType(gather.InputTensor));
+                }
+                break;
+            }
+
+            case DML_OPERATOR_ONE_HOT:
+            {
+                // The output length is only recorded in the output sizes
+                auto& oneHot = *static_cast<const DML_ONE_HOT_OPERATOR_DESC*>(desc.Desc);
+                const TensorDimensions actualOutputSizes = GetTensorSizes(oneHot.OutputTensor);
+                const bool inferred = InferOneHotOutputSizes(
+                    GetTensorSizes(oneHot.IndicesTensor),
+                    GetTensorSizes(oneHot.ValuesTensor),
+                    oneHot.Axis < actualOutputSizes.size() ? actualOutputSizes[oneHot.Axis] : 0,
+                    oneHot.Axis,
+                    outputSizes,
+                    error);
+                if (checkInferredSizes(inferred, "output", oneHot.OutputTensor, outputSizes, error))
+                {
+                    checkIntegerDataType("indices", oneHot.IndicesTensor);
+                    checkDataType("output", oneHot.OutputTensor, GetTensorDataType(oneHot.ValuesTensor));
+                }
+                break;
+            }
+
+            case DML_OPERATOR_RESAMPLE1:
+            case DML_OPERATOR_RESAMPLE_GRAD:
+            {
+                const bool isGrad = (desc.Type == DML_OPERATOR_RESAMPLE_GRAD);
+                auto& resample = *static_cast<const DML_RESAMPLE1_OPERATOR_DESC*>(desc.Desc);
+                auto& resampleGrad = *static_cast<const DML_RESAMPLE_GRAD_OPERATOR_DESC*>(desc.Desc);
+                if (!ValidateResampleSizes(
+                    GetTensorSizes(input(0)),
+                    GetTensorSizes(output(0)),
+                    isGrad ? resampleGrad.DimensionCount : resample.DimensionCount,
+                    isGrad ? resampleGrad.Scales : resample.Scales,
+                    error))
+                {
+                    errors.push_back(std::move(error));
+                    break;
+                }
+                checkDataType("output", output(0), GetTensorDataType(input(0)));
+                break;
+            }
+
+            case DML_OPERATOR_FILL_VALUE_CONSTANT:
+                checkDataType("output", output(0), static_cast<const DML_FILL_VALUE_CONSTANT_OPERATOR_DESC*>(desc.Desc)->ValueDataType);
+                break;
+
+            case DML_OPERATOR_FILL_VALUE_SEQUENCE:
+                checkDataType("output", output(0), static_cast<const DML_FILL_VALUE_SEQUENCE_OPERATOR_DESC*>(desc.Desc)->ValueDataType);
+                break;
+
+            case DML_OPERATOR_GRU:
+            {
+                auto& gru = *static_cast<const DML_GRU_OPERATOR_DESC*>(desc.Desc);
+                TensorDimensions outputSingleSizes;
+                const bool inferred = InferGRUOutputSizes(
+                    GetTensorSizes(gru.InputTensor),
+                    GetTensorSizes(gru.WeightTensor),
+                    GetTensorSizes(gru.RecurrenceTensor),
+                    gru.Direction,
+                    outputSizes,
+                    outputSingleSizes,
+                    error);
+                if (!checkInferredSizes(inferred, "output sequence", gru.OutputSequenceTensor, outputSizes, error))
+                {
+                    break;
+                }
+                checkSizes("output single", gru.OutputSingleTensor, outputSingleSizes);
+
+                // Biases are { 1, 1, direction count, 6 * hidden size }, and the initial hidden state is shaped like
+                // the single output
+                const TensorDimensions biasSizes = { 1, 1, outputSingleSizes[1], 6 * outputSingleSizes[3] };
+                checkSizes("bias", gru.BiasTensor, biasSizes);
+                checkSizes("hidden init", gru.HiddenInitTensor, outputSingleSizes);
+
+                const DML_TENSOR_DATA_TYPE dataType = GetTensorDataType(gru.InputTensor);
+                checkDataType("weight", gru.WeightTensor, dataType);
+                checkDataType("recurrence", gru.RecurrenceTensor, dataType);
+                checkDataType("bias", gru.BiasTensor, dataType);
+                checkDataType("hidden init", gru.HiddenInitTensor, dataType);
+                checkDataType("output sequence", gru.OutputSequenceTensor, dataType);
+                checkDataType("output single", gru.OutputSingleTensor, dataType);
+                break;
+            }
+
+            case DML_OPERATOR_RANDOM_GENERATOR:
+            {
+                // The state is six UINT32 values, which the operator advances into the output state
+                auto& random = *static_cast<const DML_RANDOM_GENERATOR_OPERATOR_DESC*>(desc.Desc);
+                uint64_t stateElementCount = 1;
+                for (uint32_t size : GetTensorSizes(random.InputStateTensor))
+                {
+                    stateElementCount *= size;
+                }
+                if (stateElementCount != 6)
+                {
+                    errors.push_back("random generator state " + FormatSizes(GetTensorSizes(random.InputStateTensor)) +
+                        " must hold 6 elements");
+                }
+                checkSizes("output state", random.OutputStateTensor, GetTensorSizes(random.InputStateTensor));
+                checkDataType("input state", random.InputStateTensor, DML_TENSOR_DATA_TYPE_UINT32);
+                checkDataType("output state", random.OutputStateTensor, DML_TENSOR_DATA_TYPE_UINT32);
+                checkDataType("output", random.OutputTensor, DML_TENSOR_DATA_TYPE_UINT32);
+                break;
+            }
+
+            case DML_OPERATOR_BATCH_NORMALIZATION:
+            {
+                // The statistics, scale and bias are per channel (dimension 1) when Spatial is set, and per element
+                // of an example otherwise; either way they are shared by every example in the batch
+                auto& batchNorm = *static_cast<const DML_BATCH_NORMALIZATION_OPERATOR_DESC*>(desc.Desc);
+                const TensorDimensions inputSizes = GetTensorSizes(batchNorm.InputTensor);
+                std::vector<bool> varying(inputSizes.size(), !batchNorm.Spatial);
+                if (varying.size() > 1)
+                {
+                    varying[0] = false;
+                    varying[1] = true;
+                }
+                checkParameterSizes("mean", batchNorm.MeanTensor, inputSizes, varying);
+                checkParameterSizes("variance", batchNorm.VarianceTensor, inputSizes, varying);
+                checkParameterSizes("scale", batchNorm.ScaleTensor, inputSizes, varying);
+                checkParameterSizes("bias", batchNorm.BiasTensor, inputSizes, varying);
+                checkSameSizesAsFirstInput();
+                break;
+            }
+
+            case DML_OPERATOR_MEAN_VARIANCE_NORMALIZATION1:
+            {
+                // The scale and bias may vary along any dimension: per channel for instance normalization, or along
+                // the normalized axes for layer normalization
+                auto& mvn = *static_cast<const DML_MEAN_VARIANCE_NORMALIZATION1_OPERATOR_DESC*>(desc.Desc);
+                const TensorDimensions inputSizes = GetTensorSizes(mvn.InputTensor);
+                std::vector<bool> normalized(inputSizes.size(), false);
+                for (uint32_t i = 0; i < mvn.AxisCount; ++i)
+                {
+                    const uint32_t axis = mvn.Axes[i];
+                    if (axis >= inputSizes.size() || normalized[axis])
+                    {
+                        errors.push_back("axis " + std::to_string(axis) + " is out of range or repeated for input " +
+                            FormatSizes(inputSizes));
+                        continue;
+                    }
+                    normalized[axis] = true;
+                }
+                const std::vector<bool> varying(inputSizes.size(), true);
+                checkParameterSizes("scale", mvn.ScaleTensor, inputSizes, varying);
+                checkParameterSizes("bias", mvn.BiasTensor, inputSizes, varying);
+                checkSameSizesAsFirstInput();
+                break;
+            }
+
+            case DML_OPERATOR_LOCAL_RESPONSE_NORMALIZATION:
+            {
+                // The window spans channels (dimension 1) or the two spatial dimensions of a 4D input
+                auto& lrn = *static_cast<const DML_LOCAL_RESPONSE_NORMALIZATION_OPERATOR_DESC*>(desc.Desc);
+                if (GetTensorSizes(lrn.InputTensor).size() != 4)
+                {
+                    errors.push_back("input " + FormatSizes(GetTensorSizes(lrn.InputTensor)) + " isn't 4D");
+                }
+                if (lrn.LocalSize == 0)
+                {
+                    errors.push_back("LocalSize must be at least 1");
+                }
+                checkSameSizesAsFirstInput();
+                break;
+            }
+
+            case DML_OPERATOR_VALUE_SCALE_2D:
+            {
+                // Bias holds one value per channel (dimension 1) of a 4D input
+                auto& valueScale = *static_cast<const DML_VALUE_SCALE_2D_OPERATOR_DESC*>(desc.Desc);
+                const TensorDimensions inputSizes = GetTensorSizes(valueScale.InputTensor);
+                if (inputSizes.size() != 4 || valueScale.ChannelCount != inputSizes[1] || !valueScale.Bias)
+                {
+                    errors.push_back("ChannelCount " + std::to_string(valueScale.ChannelCount) +
+                        " doesn't match the channels of input " + FormatSizes(inputSizes) + ", or Bias is null");
+                }
+                checkSameSizesAsFirstInput();
+                break;
+            }
+
+            case DML_OPERATOR_REVERSE_SUBSEQUENCES:
+            case DML_OPERATOR_SCATTER_ELEMENTS:
+            case DML_OPERATOR_SCATTER_ND:
+                checkSameSizesAsFirstInput();
+                break;
+
+            case DML_OPERATOR_GATHER_ELEMENTS:
+                checkSizes("output", output(0), GetTensorSizes(input(1)));
+                checkDataType("output", output(0), GetTensorDataType(input(0)));
+                break;
+
+            case DML_OPERATOR_CAST:
+                checkSizes("output", output(0), GetTensorSizes(input(0)));
+                break;
+
+            default:
+            {
+                // The remaining operators are element-wise operators and activations, whose inputs and outputs all
+                // have the same sizes (broadcasting is expressed through strides).
+                if (!output(0))
+                {
+                    break;
+                }
+
+                const TensorDimensions sizes = GetTensorSizes(output(0));
+                for (size_t i = 0; i < tensors.inputTensors.size(); ++i)
+                {
+                    checkSizes(("input " + std::to_string(i)).c_str(), tensors.inputTensors[i], sizes);
+                }
+
+                switch (desc.Type)
+                {
+                case DML_OPERATOR_ELEMENT_WISE_LOGICAL_AND:
+                case DML_OPERATOR_ELEMENT_WISE_LOGICAL_OR:
+                case DML_OPERATOR_ELEMENT_WISE_LOGICAL_XOR:
+                    checkDataType("input", input(1), GetTensorDataType(input(0)));
+                    checkDataType("output", output(0), DML_TENSOR_DATA_TYPE_UINT8);
+                    break;
+
+                case DML_OPERATOR_ELEMENT_WISE_LOGICAL_EQUALS:
+                case DML_OPERATOR_ELEMENT_WISE_LOGICAL_GREATER_THAN:
+                case DML_OPERATOR_ELEMENT_WISE_LOGICAL_GREATER_THAN_OR_EQUAL:
+                case DML_OPERATOR_ELEMENT_WISE_LOGICAL_LESS_THAN:
+                case DML_OPERATOR_ELEMENT_WISE_LOGICAL_LESS_THAN_OR_EQUAL:
+                    checkDataType("input", input(1), GetTensorDataType(input(0)));
+                    checkIntegerDataType("output", output(0));
+                    break;
+
+                case DML_OPERATOR_ELEMENT_WISE_IS_NAN:
+                case DML_OPERATOR_ELEMENT_WISE_IS_INFINITY:
+                case DML_OPERATOR_ELEMENT_WISE_BIT_COUNT:
+                    checkIntegerDataType("output", output(0));
+                    break;
+
+                case DML_OPERATOR_ELEMENT_WISE_IF:
+                    checkDataType("condition", input(0), DML_TENSOR_DATA_TYPE_UINT8);
+                    checkDataType("B", input(2), GetTensorDataType(input(1)));
+                    checkDataType("output", output(0), GetTensorDataType(input(1)));
+                    break;
+
+                case DML_OPERATOR_ELEMENT_WISE_QUANTIZE_LINEAR:
+                case DML_OPERATOR_ELEMENT_WISE_DEQUANTIZE_LINEAR:
+                    break;
+
+                default:
+                    for (const DML_TENSOR_DESC* tensor : tensors.inputTensors)
+                    {
+                        checkDataType("input", tensor, GetTensorDataType(output(0)));
+                    }
+                    break;
+                }
+                break;
+            }
+            }
+        }
+
+        inline uint64_t GetElementCount(const DML_TENSOR_DESC* tensor)
+        {
+            uint64_t count = 1;
+            for (uint32_t size : GetTensorSizes(tensor))
+            {
+                count *= size;
+            }
+            return count;
+        }
+
+        // Returns the name of a data type without the DML_TENSOR_DATA_TYPE_ prefix, e.g. "FLOAT16".
+        inline const char* GetDataTypeName(DML_TENSOR_DATA_TYPE dataType)
+        {
+            switch (dataType)
+            {
+            case DML_TENSOR_DATA_TYPE_FLOAT32: return "FLOAT32";
+            case DML_TENSOR_DATA_TYPE_FLOAT16: return "FLOAT16";
+            case DML_TENSOR_DATA_TYPE_UINT32: return "UINT32";
+            case DML_TENSOR_DATA_TYPE_UINT16: return "UINT16";
+            case DML_TENSOR_DATA_TYPE_UINT8: return "UINT8";
+            case DML_TENSOR_DATA_TYPE_INT32: return "INT32";
+            case DML_TENSOR_DATA_TYPE_INT16: return "INT16";
+            case DML_TENSOR_DATA_TYPE_INT8: return "INT8";
+            case DML_TENSOR_DATA_TYPE_FLOAT64: return "FLOAT64";
+            case DML_TENSOR_DATA_TYPE_UINT64: return "UINT64";
+            case DML_TENSOR_DATA_TYPE_INT64: return "INT64";
+            default: return "UNKNOWN";
+            }
+        }
+
+        // Quotes a string for a JSON document.
+        inline std::string QuoteJsonString(const char* value)
+        {
+            std::string text = "\"";
+            for (const char* c = value; *c; ++c)
+            {
+                if (*c == '"' || *c == '\\')
+                {
+                    text += '\\';
+                    text += *c;
+                }
+                else if (static_cast<unsigned char>(*c) < 0x20)
+                {
+                    char escape[8];
+                    snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned char>(*c));
+                    text += escape;
+                }
+                else
+                {
+                    text += *c;
+                }
+            }
+            return text + "\"";
+        }
+
+        // Escapes a string for a quoted Graphviz label.
+        inline std::string EscapeDotString(const char* value)
+        {
+            std::string text;
+            for (const char* c = value; *c; ++c)
+            {
+                if (*c == '"' || *c == '\\')
+                {
+                    text += '\\';
+                }
+                text += *c == '\n' ? ' ' : *c;
+            }
+            return text;
+        }
+
+        // Estimates the bytes an operator moves to or from a tensor: every element it addresses, but no more than the
+        // tensor's buffer holds (broadcast tensors are read from a smaller buffer).
+        inline uint64_t EstimateTensorTrafficInBytes(const DML_TENSOR_DESC* tensor)
+        {
+            const auto& bufferDesc = *static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc);
+            const uint64_t addressedBytes = GetElementCount(tensor) * GetDataTypeSizeInBytes(bufferDesc.DataType);
+            const uint64_t bufferBytes = DMLCalcBufferTensorSize(
+                bufferDesc.DataType,
+                bufferDesc.DimensionCount,
+                bufferDesc.Sizes,
+                bufferDesc.Strides);
+            return std::min(addressedBytes, bufferBytes);
+        }
+
+        // Roughly estimates the floating-point operations an operator performs. Multiply-accumulates count as two
+        // operations. Operators that only move data (joins, splits, slices, copies, gathers and the like) perform
+        // none, and the remaining operators count a small constant number per element of their largest input or
+        // output. Fused activations add one operation per output element.
+        inline uint64_t EstimateOperatorFlopCount(const DML_OPERATOR_DESC& desc)
+        {
+            const OperatorDescTensors tensors = OperatorDescTensors::Get(desc);
+
+            auto elements = [](const std::vector<DML_TENSOR_DESC*>& list, size_t i)
+            {
+                return i < list.size() && list[i] ? GetElementCount(list[i]) : 0;
+            };
+
+            uint64_t largestTensor = 0;
+            for (size_t i = 0; i < tensors.inputTensors.size(); ++i)
+            {
+                largestTensor = std::max(largestTensor, elements(tensors.inputTensors, i));
+            }
+            for (size_t i = 0; i < tensors.outputTensors.size(); ++i)
+            {
+                largestTensor = std::max(largestTensor, elements(tensors.outputTensors, i));
+            }
+
+            const uint64_t outputElements = elements(tensors.outputTensors, 0);
+            const uint64_t activationCount = tensors.fusedActivationCount * outputElements;
+
+            auto windowSize = [](UINT dimensionCount, const UINT* sizes)
+            {
+                uint64_t size = 1;
+                for (UINT i = 0; i < dimensionCount; ++i)
+                {
+                    size *= sizes[i];
+                }
+                return size;
+            };
+
+            switch (desc.Type)
+            {
+            case DML_OPERATOR_CONVOLUTION:
+            {
+                // Each element on the "input" side of the filter (the output, or the input of a transposed
+                // convolution) accumulates one filter slice
+                const auto& convDesc = *static_cast<const DML_CONVOLUTION_OPERATOR_DESC*>(desc.Desc);
+                const TensorDimensions filterSizes = GetTensorSizes(convDesc.FilterTensor);
+                const uint64_t filterSliceSize = elements(tensors.inputTensors, 1) / std::max(filterSizes[0], 1u);
+                const uint64_t accumulatingElements = convDesc.Direction == DML_CONVOLUTION_DIRECTION_FORWARD
+                    ? outputElements
+                    : elements(tensors.inputTensors, 0);
+                return 2 * accumulatingElements * filterSliceSize + activationCount;
+            }
+
+            case DML_OPERATOR_GEMM:
+            {
+                const auto& gemmDesc = *static_cast<const DML_GEMM_OPERATOR_DESC*>(desc.Desc);
+                const TensorDimensions aSizes = GetTensorSizes(gemmDesc.ATensor);
+                const uint32_t k = gemmDesc.TransA == DML_MATRIX_TRANSFORM_TRANSPOSE
+                    ? aSizes[aSizes.size() - 2]
+                    : aSizes.back();
+                return 2 * outputElements * k + activationCount;
+            }
+
+            case DML_OPERATOR_AVERAGE_POOLING:
+            {
+                const auto& poolingDesc = *static_cast<const DML_AVERAGE_POOLING_OPERATOR_DESC*>(desc.Desc);
+                return outputElements * (windowSize(poolingDesc.DimensionCount, poolingDesc.WindowSize) + 1);
+            }
+
+            case DML_OPERATOR_MAX_POOLING2:
+            {
+                const auto& poolingDesc = *static_cast<const DML_MAX_POOLING2_OPERATOR_DESC*>(desc.Desc);
+                return outputElements * windowSize(poolingDesc.DimensionCount, poolingDesc.WindowSize);
+            }
+
+            case DML_OPERATOR_REDUCE:
+                return elements(tensors.inputTensors, 0);
+
+            case DML_OPERATOR_RESAMPLE1:
+            {
+                // Linear interpolation blends 2^d neighbours, where d is the number of resized dimensions
+                const auto& resampleDesc = *static_cast<const DML_RESAMPLE1_OPERATOR_DESC*>(desc.Desc);
+                if (resampleDesc.InterpolationMode == DML_INTERPOLATION_MODE_NEAREST_NEIGHBOR)
+                {
+                    return 0;
+                }
+                uint64_t taps = 1;
+                for (UINT i = 0; i < resampleDesc.DimensionCount; ++i)
+                {
+                    taps *= resampleDesc.Scales[i] != 1.0f ? 2 : 1;
+                }
+                return outputElements * 2 * taps;
+            }
+
+            case DML_OPERATOR_ACTIVATION_SOFTMAX:
+            case DML_OPERATOR_ACTIVATION_LOG_SOFTMAX:
+            case DML_OPERATOR_MEAN_VARIANCE_NORMALIZATION1:
+                return 4 * largestTensor + activationCount;
+
+            case DML_OPERATOR_BATCH_NORMALIZATION:
+                return 2 * outputElements + activationCount;
+
+            case DML_OPERATOR_LOCAL_RESPONSE_NORMALIZATION:
+            {
+                const auto& lrnDesc = *static_cast<const DML_LOCAL_RESPONSE_NORMALIZATION_OPERATOR_DESC*>(desc.Desc);
+                return outputElements * (2 * uint64_t(lrnDesc.LocalSize) + 4);
+            }
+
+            case DML_OPERATOR_GRU:
+            {
+                // Input and recurrence GEMMs for three gates per step, plus the gate element-wise math. Input:
+                // [1, sequence, batch, inputSize]; recurrence: [1, directions, 3 * hidden, hidden].
+                const auto& gruDesc = *static_cast<const DML_GRU_OPERATOR_DESC*>(desc.Desc);
+                const TensorDimensions inputSizes = GetTensorSizes(gruDesc.InputTensor);
+                const TensorDimensions recurrenceSizes = GetTensorSizes(gruDesc.RecurrenceTensor);
+                const uint64_t steps = uint64_t(inputSizes[1]) * inputSizes[2] * recurrenceSizes[1];
+                const uint64_t hiddenSize = recurrenceSizes[3];
+                return steps * (2 * 3 * hiddenSize * (inputSizes[3] + hiddenSize) + 10 * hiddenSize);
+            }
+
+            case DML_OPERATOR_SLICE1:
+            case DML_OPERATOR_CAST:
+            case DML_OPERATOR_SPLIT:
+            case DML_OPERATOR_JOIN:
+            case DML_OPERATOR_PADDING:
+            case DML_OPERATOR_UPSAMPLE_2D:
+            case DML_OPERATOR_GATHER:
+            case DML_OPERATOR_GATHER_ELEMENTS:
+            case DML_OPERATOR_SCATTER_ELEMENTS:
+            case DML_OPERATOR_SCATTER_ND:
+            case DML_OPERATOR_TILE:
+            case DML_OPERATOR_ONE_HOT:
+            case DML_OPERATOR_FILL_VALUE_CONSTANT:
+            case DML_OPERATOR_FILL_VALUE_SEQUENCE:
+            case DML_OPERATOR_REVERSE_SUBSEQUENCES:
+            case DML_OPERATOR_ELEMENT_WISE_IDENTITY:
+                return activationCount;
+
+            default:
+                return largestTensor + activationCount;
+            }
+        }
+
+        // Estimates the cost of one operator from its desc.
+        inline void EstimateOperatorCost(const DML_OPERATOR_DESC& desc, CostEstimate& cost)
+        {
+            const OperatorDescTensors tensors = OperatorDescTensors::Get(desc);
+
+            cost.flopCount = EstimateOperatorFlopCount(desc);
+            cost.bytesRead = 0;
+            cost.bytesWritten = 0;
+            for (const DML_TENSOR_DESC* tensor : tensors.inputTensors)
+            {
+                cost.bytesRead += tensor ? EstimateTensorTrafficInBytes(tensor) : 0;
+            }
+            for (const DML_TENSOR_DESC* tensor : tensors.outputTensors)
+            {
+                cost.bytesWritten += tensor ? EstimateTensorTrafficInBytes(tensor) : 0;
+            }
+        }
+    } // namespace detail
+
+    // Expression implementation helpers
+    namespace detail
+    {
+        template <DML_OPERATOR_TYPE OperatorType, typename TDesc>
+        Expression ElementWiseUnary(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias)
+        {
+            detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+            TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+            TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
+
+            TDesc desc = {};
+            desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.ScaleBias = scaleBias ? &scaleBias.value() : nullptr;
+
+            detail::NodeOutput* const inputs[] = { input.Impl() };
+            detail::NodeID node = builder->CreateOperatorNode(OperatorType, &desc, inputs);
+            detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+            return output;
+        }
+
+        template <DML_OPERATOR_TYPE OperatorType, typename TDesc>
+        Expression ElementWiseUnary(Expression input, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UNKNOWN)
+        {
+            detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+            TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+
+            if (outputDataType == DML_TENSOR_DATA_TYPE_UNKNOWN)
+            {
+                outputDataType = inputTensor.dataType;
+            }
+            TensorDesc outputTensor(outputDataType, inputTensor.sizes, builder->GetTensorPolicy());
+
+            TDesc desc = {};
+            desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+            detail::NodeOutput* const inputs[] = { input.Impl() };
+            detail::NodeID node = builder->CreateOperatorNode(OperatorType, &desc, inputs);
+            detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+            return output;
+        }
+
+        template <DML_OPERATOR_TYPE OperatorType, typename TDesc>
+        Expression ElementWiseBinary(Expression a, Expression b)
+        {
+            assert(detail::HasSameOwner({ a, b }));
+            detail::GraphBuilder* builder = a.Impl()->GetGraphBuilder();
+
+            TensorDesc aTensor = a.Impl()->GetOutputDesc();
+            TensorDesc bTensor = b.Impl()->GetOutputDesc();
+            TensorDimensions outputSizes = detail::GetBroadcastSizes({ &aTensor.sizes, &bTensor.sizes });
+            aTensor = detail::BroadcastTensor(aTensor, outputSizes);
+            bTensor = detail::BroadcastTensor(bTensor, outputSizes);
+            TensorDesc outputTensor(aTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+            TDesc desc = {};
+            desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+            detail::NodeOutput* const inputs[] = { a.Impl(), b.Impl() };
+            detail::NodeID node = builder->CreateOperatorNode(OperatorType, &desc, inputs);
+            detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+            return output;
+        }
+
+        template <DML_OPERATOR_TYPE OperatorType, typename TDesc>
+        Expression ElementWiseComparison(Expression a, Expression b, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
+        {
+            assert(detail::HasSameOwner({ a, b }));
+            detail::GraphBuilder* builder = a.Impl()->GetGraphBuilder();
+
+            TensorDesc aTensor = a.Impl()->GetOutputDesc();
+            TensorDesc bTensor = b.Impl()->GetOutputDesc();
+            TensorDimensions outputSizes = detail::GetBroadcastSizes({ &aTensor.sizes, &bTensor.sizes });
+            aTensor = detail::BroadcastTensor(aTensor, outputSizes);
+            bTensor = detail::BroadcastTensor(bTensor, outputSizes);
+            TensorDesc outputTensor(outputDataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+            TDesc desc = {};
+            desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
+            desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+            detail::NodeOutput* const inputs[] = { a.Impl(), b.Impl() };
+            detail::NodeID node = builder->CreateOperatorNode(OperatorType, &desc, inputs);
+            detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+            return output;
+        }
+
+        // Used to reserve some space on the stack for setting up fused activation operator descs.
+        struct FusedActivationStorage
+        {
+            DML_OPERATOR_DESC opDesc;
+
+            // All fuseable activation descs have a common layout: two tensor desc pointers and up to 2 optional
+            // float parameters, so just use LINEAR as an archetype
+            DML_ACTIVATION_LINEAR_OPERATOR_DESC activationDesc;
+        };
+
+        // Returns the correct value for filling out fused activation fields in the DML API, e.g.
+        // DML_CONVOLUTION_OPERATOR_DESC::FusedActivation. The descs themselves are stored in the `storage` outptr.
+        inline const DML_OPERATOR_DESC* GetFusedActivationPtr(
+            FusedActivation fusedActivation,
+            _Out_ FusedActivationStorage* storage)
+        {
+            if (fusedActivation.activation == DML_OPERATOR_INVALID)
+            {
+                // No fused activation
+                return nullptr;
+            }
+
+            storage->activationDesc.InputTensor = nullptr;
+            storage->activationDesc.OutputTensor = nullptr;
+            storage->activationDesc.Alpha = fusedActivation.param1;
+            storage->activationDesc.Beta = fusedActivation.param2;
+
+            storage->opDesc.Type = fusedActivation.activation;
+            storage->opDesc.Desc = &storage->activationDesc;
+
+            return &storage->opDesc;
+        }
+
+    } // namespace detail
+
+    inline Expression InputTensor(Graph& graph, uint32_t inputIndex, TensorDesc desc)
+    {
+        detail::GraphBuilder* builder = graph.Impl();
+
+        detail::NodeID node = builder->CreateInputNode(inputIndex);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(desc));
+        return output;
+    }
+
+    // Creates a graph input whose contents are known when the graph is built, such as weights. The data is copied
+    // into the graph so that optimizations can precompute with it. The input must still be bound when executing the
+    // compiled graph; see Graph::GetConstantInputData.
+    inline Expression ConstantInputTensor(Graph& graph, uint32_t inputIndex, TensorDesc desc, Span<const uint8_t> data)
+    {
+        // Tensor sizes are rounded up to 4 bytes; the padding doesn't need to be supplied.
+        if (data.size() + 3 < desc.totalTensorSizeInBytes)
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        std::vector<uint8_t> hostData(data.begin(), data.end());
+        if (hostData.size() < desc.totalTensorSizeInBytes)
+        {
+            hostData.resize(static_cast<size_t>(desc.totalTensorSizeInBytes), 0);
+        }
+
+        detail::GraphBuilder* builder = graph.Impl();
+        builder->SetConstantInputData(inputIndex, std::move(hostData));
+
+        detail::NodeID node = builder->CreateInputNode(inputIndex);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(desc));
+        return output;
+    }
+
+    inline Expression Identity(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_IDENTITY, DML_ELEMENT_WISE_IDENTITY_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression Abs(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ABS, DML_ELEMENT_WISE_ABS_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression ACos(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ACOS, DML_ELEMENT_WISE_ACOS_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression Add(Expression a, Expression b, FusedActivation fusedActivation = FusedActivation::None())
+    {
+        assert(detail::HasSameOwner({ a, b }));
+        detail::GraphBuilder* builder = a.Impl()->GetGraphBuilder();
+
+        TensorDesc aTensor = a.Impl()->GetOutputDesc();
+        TensorDesc bTensor = b.Impl()->GetOutputDesc();
+        TensorDimensions outputSizes = detail::GetBroadcastSizes({ &aTensor.sizes, &bTensor.sizes });
+        aTensor = detail::BroadcastTensor(aTensor, outputSizes);
+        bTensor = detail::BroadcastTensor(bTensor, outputSizes);
+        TensorDesc outputTensor(aTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+        detail::FusedActivationStorage storage;
+
+        DML_ELEMENT_WISE_ADD1_OPERATOR_DESC desc = {};
+        desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+
+        detail::NodeOutput* const inputs[] = { a.Impl(), b.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_ADD1, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression ASin(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ASIN, DML_ELEMENT_WISE_ASIN_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression ATan(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ATAN, DML_ELEMENT_WISE_ATAN_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression Ceil(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_CEIL, DML_ELEMENT_WISE_CEIL_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression Clip(Expression input, float min, float max, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
+
+        DML_ELEMENT_WISE_CLIP_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ScaleBias = scaleBias ? &scaleBias.value() : nullptr;
+        desc.Min = min;
+        desc.Max = max;
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_CLIP, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression Cos(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_COS, DML_ELEMENT_WISE_COS_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression Divide(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_DIVIDE, DML_ELEMENT_WISE_DIVIDE_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression Exp(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_EXP, DML_ELEMENT_WISE_EXP_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression Floor(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_FLOOR, DML_ELEMENT_WISE_FLOOR_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression Log(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_LOG, DML_ELEMENT_WISE_LOG_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression LogicalAnd(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_LOGICAL_AND, DML_ELEMENT_WISE_LOGICAL_AND_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression Equals(Expression a, Expression b, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
+    {
+        return detail::ElementWiseComparison<
+            DML_OPERATOR_ELEMENT_WISE_LOGICAL_EQUALS,
+            DML_ELEMENT_WISE_LOGICAL_EQUALS_OPERATOR_DESC>(a, b, outputDataType);
+    }
+
+    inline Expression GreaterThan(Expression a, Expression b, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
+    {
+        return detail::ElementWiseComparison<
+            DML_OPERATOR_ELEMENT_WISE_LOGICAL_GREATER_THAN,
+            DML_ELEMENT_WISE_LOGICAL_GREATER_THAN_OPERATOR_DESC>(a, b, outputDataType);
+    }
+
+    inline Expression GreaterThanOrEqual(Expression a, Expression b, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
+    {
+        return detail::ElementWiseComparison<
+            DML_OPERATOR_ELEMENT_WISE_LOGICAL_GREATER_THAN_OR_EQUAL,
+            DML_ELEMENT_WISE_LOGICAL_GREATER_THAN_OR_EQUAL_OPERATOR_DESC>(a, b, outputDataType);
+    }
+
+    inline Expression LessThan(Expression a, Expression b, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
+    {
+        return detail::ElementWiseComparison<
+            DML_OPERATOR_ELEMENT_WISE_LOGICAL_LESS_THAN,
+            DML_ELEMENT_WISE_LOGICAL_LESS_THAN_OPERATOR_DESC>(a, b, outputDataType);
+    }
+
+    inline Expression LessThanOrEqual(Expression a, Expression b, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
+    {
+        return detail::ElementWiseComparison<
+            DML_OPERATOR_ELEMENT_WISE_LOGICAL_LESS_THAN_OR_EQUAL,
+            DML_ELEMENT_WISE_LOGICAL_LESS_THAN_OR_EQUAL_OPERATOR_DESC>(a, b, outputDataType);
+    }
+
+    inline Expression LogicalNot(Expression input)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
+
+        DML_ELEMENT_WISE_LOGICAL_NOT_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_LOGICAL_NOT, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression LogicalOr(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_LOGICAL_OR, DML_ELEMENT_WISE_LOGICAL_OR_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression LogicalXor(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_LOGICAL_XOR, DML_ELEMENT_WISE_LOGICAL_XOR_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression Max(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_MAX, DML_ELEMENT_WISE_MAX_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression Mean(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_MEAN, DML_ELEMENT_WISE_MEAN_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression Min(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_MIN, DML_ELEMENT_WISE_MIN_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression Multiply(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_MULTIPLY, DML_ELEMENT_WISE_MULTIPLY_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression Pow(Expression input, Expression exponent, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        assert(detail::HasSameOwner({ input, exponent }));
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc exponentTensor = exponent.Impl()->GetOutputDesc();
+        TensorDimensions outputSizes = detail::GetBroadcastSizes({ &inputTensor.sizes, &exponentTensor.sizes });
+        inputTensor = detail::BroadcastTensor(inputTensor, outputSizes);
+        exponentTensor = detail::BroadcastTensor(exponentTensor, outputSizes);
+        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_ELEMENT_WISE_POW_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ExponentTensor = exponentTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ScaleBias = scaleBias ? &scaleBias.value() : nullptr;
+
+        detail::NodeOutput* const inputs[] = { input.Impl(), exponent.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_POW, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression Pow(Expression input, float exponent, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
+
+        DML_ELEMENT_WISE_CONSTANT_POW_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ScaleBias = scaleBias ? &scaleBias.value() : nullptr;
+        desc.Exponent = exponent;
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_CONSTANT_POW, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression Recip(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_RECIP, DML_ELEMENT_WISE_RECIP_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression Sin(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_SIN, DML_ELEMENT_WISE_SIN_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression Sqrt(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_SQRT, DML_ELEMENT_WISE_SQRT_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression Subtract(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_SUBTRACT, DML_ELEMENT_WISE_SUBTRACT_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression Tan(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_TAN, DML_ELEMENT_WISE_TAN_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression Threshold(Expression input, float min, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
+
+        DML_ELEMENT_WISE_THRESHOLD_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ScaleBias = scaleBias ? &scaleBias.value() : nullptr;
+        desc.Min = min;
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_THRESHOLD, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression QuantizeLinear(Expression input, Expression scale, Expression zeroPoint)
+    {
+        assert(detail::HasSameOwner({ input, scale, zeroPoint }));
+
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc scaleTensor = scale.Impl()->GetOutputDesc();
+        TensorDesc zeroPointTensor = zeroPoint.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(DML_TENSOR_DATA_TYPE_UINT8, inputTensor.sizes, builder->GetTensorPolicy());
+
+        DML_ELEMENT_WISE_QUANTIZE_LINEAR_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ScaleTensor = scaleTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ZeroPointTensor = zeroPointTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+        detail::NodeOutput* const inputs[] = { input.Impl(), scale.Impl(), zeroPoint.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_QUANTIZE_LINEAR, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression DequantizeLinear(Expression input, Expression scale, Expression zeroPoint)
+    {
+        assert(detail::HasSameOwner({ input, scale, zeroPoint }));
+
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc scaleTensor = scale.Impl()->GetOutputDesc();
+        TensorDesc zeroPointTensor = zeroPoint.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(DML_TENSOR_DATA_TYPE_FLOAT32, inputTensor.sizes, builder->GetTensorPolicy());
+
+        DML_ELEMENT_WISE_DEQUANTIZE_LINEAR_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ScaleTensor = scaleTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ZeroPointTensor = zeroPointTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+        detail::NodeOutput* const inputs[] = { input.Impl(), scale.Impl(), zeroPoint.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_DEQUANTIZE_LINEAR, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression Sign(Expression a)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_SIGN, DML_ELEMENT_WISE_SIGN_OPERATOR_DESC>(a);
+    }
+
+    inline Expression IsNaN(Expression input, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_IS_NAN, DML_ELEMENT_WISE_IS_NAN_OPERATOR_DESC>(input, outputDataType);
+    }
+
+    inline Expression Erf(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ERF, DML_ELEMENT_WISE_ERF_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression Sinh(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_SINH, DML_ELEMENT_WISE_SINH_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression Cosh(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_COSH, DML_ELEMENT_WISE_COSH_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression Tanh(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_TANH, DML_ELEMENT_WISE_TANH_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression ASinh(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ASINH, DML_ELEMENT_WISE_ASINH_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression ACosh(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ACOSH, DML_ELEMENT_WISE_ACOSH_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression ATanh(Expression input, const Optional<DML_SCALE_BIAS>& scaleBias = NullOpt)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_ATANH, DML_ELEMENT_WISE_ATANH_OPERATOR_DESC>(input, scaleBias);
+    }
+
+    inline Expression If(Expression condition, Expression a, Expression b)
+    {
+        assert(detail::HasSameOwner({ condition, a, b }));
+        assert(detail::HasSameDataType({ a, b }));
+
+        detail::GraphBuilder* builder = condition.Impl()->GetGraphBuilder();
+
+        TensorDesc conditionTensor = condition.Impl()->GetOutputDesc();
+        assert(conditionTensor.dataType == DML_TENSOR_DATA_TYPE_UINT8);
+
+        TensorDesc aTensor = a.Impl()->GetOutputDesc();
+        TensorDesc bTensor = b.Impl()->GetOutputDesc();
+        TensorDimensions outputSizes = detail::GetBroadcastSizes({ &conditionTensor.sizes, &aTensor.sizes, &bTensor.sizes });
+        conditionTensor = detail::BroadcastTensor(conditionTensor, outputSizes);
+        aTensor = detail::BroadcastTensor(aTensor, outputSizes);
+        bTensor = detail::BroadcastTensor(bTensor, outputSizes);
+        TensorDesc outputTensor(aTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_ELEMENT_WISE_IF_OPERATOR_DESC desc = {};
+        desc.ConditionTensor = conditionTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+        detail::NodeOutput* const inputs[] = { condition.Impl(), a.Impl(), b.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_IF, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression BitShiftLeft(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_BIT_SHIFT_LEFT, DML_ELEMENT_WISE_BIT_SHIFT_LEFT_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression BitShiftRight(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_BIT_SHIFT_RIGHT, DML_ELEMENT_WISE_BIT_SHIFT_RIGHT_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression BitAnd(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_BIT_AND, DML_ELEMENT_WISE_BIT_AND_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression BitOr(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_BIT_OR, DML_ELEMENT_WISE_BIT_OR_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression BitXor(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_BIT_XOR, DML_ELEMENT_WISE_BIT_XOR_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression BitNot(Expression a)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_BIT_NOT, DML_ELEMENT_WISE_BIT_NOT_OPERATOR_DESC>(a);
+    }
+
+    inline Expression BitCount(Expression a, DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
+    {
+        return detail::ElementWiseUnary<DML_OPERATOR_ELEMENT_WISE_BIT_COUNT, DML_ELEMENT_WISE_BIT_COUNT_OPERATOR_DESC>(a, outputDataType);
+    }
+
+    inline Expression Round(Expression input, DML_ROUNDING_MODE roundingMode = DML_ROUNDING_MODE_HALVES_TO_NEAREST_EVEN)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); // Same as input
+
+        DML_ELEMENT_WISE_ROUND_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.RoundingMode = roundingMode;
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_ROUND, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression IsInfinity(
+        Expression input,
+        DML_IS_INFINITY_MODE infinityMode = DML_IS_INFINITY_MODE_EITHER,
+        DML_TENSOR_DATA_TYPE outputDataType = DML_TENSOR_DATA_TYPE_UINT8)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(outputDataType, inputTensor.sizes, builder->GetTensorPolicy());
+
+        DML_ELEMENT_WISE_IS_INFINITY_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.InfinityMode = infinityMode;
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_IS_INFINITY, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression ModulusTruncate(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_MODULUS_TRUNCATE, DML_ELEMENT_WISE_MODULUS_TRUNCATE_OPERATOR_DESC>(a, b);
+    }
+
+    inline Expression ModulusFloor(Expression a, Expression b)
+    {
+        return detail::ElementWiseBinary<DML_OPERATOR_ELEMENT_WISE_MODULUS_FLOOR, DML_ELEMENT_WISE_MODULUS_FLOOR_OPERATOR_DESC>(a, b);
+    }
+
+#pragma region detail
+#define DMLX_ACTIVATION_IMPL(_name) \
+    do { \
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder(); \
+        \
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc(); \
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); \
+        \
+        DML_##_name##_OPERATOR_DESC desc = {}; \
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>(); \
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>(); \
+        \
+        detail::NodeOutput* const inputs[] = { input.Impl() }; \
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_##_name, &desc, inputs); \
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor)); \
+        \
+        return output; \
+    } while(0)
+
+#define DMLX_ACTIVATION_IMPL_1(_name, _param1Name, _param1) \
+    do { \
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder(); \
+        \
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc(); \
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); \
+        \
+        DML_##_name##_OPERATOR_DESC desc = {}; \
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>(); \
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>(); \
+        desc._param1Name = _param1; \
+        \
+        detail::NodeOutput* const inputs[] = { input.Impl() }; \
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_##_name, &desc, inputs); \
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor)); \
+        \
+        return output; \
+    } while(0)
+
+#define DMLX_ACTIVATION_IMPL_2(_name, _param1Name, _param1, _param2Name, _param2) \
+    do { \
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder(); \
+        \
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc(); \
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy()); \
+        \
+        DML_##_name##_OPERATOR_DESC desc = {}; \
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>(); \
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>(); \
+        desc._param1Name = _param1; \
+        desc._param2Name = _param2; \
+        \
+        detail::NodeOutput* const inputs[] = { input.Impl() }; \
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_##_name, &desc, inputs); \
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor)); \
+        \
+        return output; \
+    } while(0)
+#pragma endregion
+
+    inline Expression ActivationElu(Expression input, float alpha = 1.0f)
+    {
+        DMLX_ACTIVATION_IMPL_1(ACTIVATION_ELU, Alpha, alpha);
+    }
+
+    inline Expression ActivationHardmax(Expression input)
+    {
+        DMLX_ACTIVATION_IMPL(ACTIVATION_HARDMAX);
+    }
+
+    inline Expression ActivationHardSigmoid(Expression input, float alpha = 0.2f, float beta = 0.5f)
+    {
+        DMLX_ACTIVATION_IMPL_2(ACTIVATION_HARD_SIGMOID, Alpha, alpha, Beta, beta);
+    }
+
+    inline Expression ActivationIdentity(Expression input)
+    {
+        DMLX_ACTIVATION_IMPL(ACTIVATION_IDENTITY);
+    }
+
+    inline Expression ActivationLeakyRelu(Expression input, float alpha = 0.01f)
+    {
+        DMLX_ACTIVATION_IMPL_1(ACTIVATION_LEAKY_RELU, Alpha, alpha);
+    }
+
+    inline Expression ActivationLinear(Expression input, float alpha, float beta)
+    {
+        DMLX_ACTIVATION_IMPL_2(ACTIVATION_LINEAR, Alpha, alpha, Beta, beta);
+    }
+
+    inline Expression ActivationLogSoftmax(Expression input)
+    {
+        DMLX_ACTIVATION_IMPL(ACTIVATION_LOG_SOFTMAX);
+    }
+
+    inline Expression ActivationParameterizedRelu(Expression input, Expression slope)
+    {
+        assert(detail::HasSameOwner({ input, slope }));
+
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc slopeTensor = slope.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+
+        DML_ACTIVATION_PARAMETERIZED_RELU_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.SlopeTensor = slopeTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+        detail::NodeOutput* const inputs[] = { input.Impl(), slope.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ACTIVATION_PARAMETERIZED_RELU, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression ActivationParametricSoftplus(Expression input, float alpha, float beta)
+    {
+        DMLX_ACTIVATION_IMPL_2(ACTIVATION_PARAMETRIC_SOFTPLUS, Alpha, alpha, Beta, beta);
+    }
+
+    inline Expression ActivationRelu(Expression input)
+    {
+        DMLX_ACTIVATION_IMPL(ACTIVATION_RELU);
+    }
+
+    inline Expression ActivationScaledElu(Expression input, float alpha = 1.67326319217681884765625f, float gamma = 1.05070102214813232421875f)
+    {
+        DMLX_ACTIVATION_IMPL_2(ACTIVATION_SCALED_ELU, Alpha, alpha, Gamma, gamma);
+    }
+
+    inline Expression ActivationScaledTanh(Expression input, float alpha = 1.0f, float beta = 0.5f)
+    {
+        DMLX_ACTIVATION_IMPL_2(ACTIVATION_SCALED_TANH, Alpha, alpha, Beta, beta);
+    }
+
+    inline Expression ActivationSigmoid(Expression input)
+    {
+        DMLX_ACTIVATION_IMPL(ACTIVATION_SIGMOID);
+    }
+
+    inline Expression ActivationSoftmax(Expression input)
+    {
+        DMLX_ACTIVATION_IMPL(ACTIVATION_SOFTMAX);
+    }
+
+    inline Expression ActivationSoftplus(Expression input, float steepness = 1.0f)
+    {
+        DMLX_ACTIVATION_IMPL_1(ACTIVATION_SOFTPLUS, Steepness, steepness);
+    }
+
+    inline Expression ActivationSoftsign(Expression input)
+    {
+        DMLX_ACTIVATION_IMPL(ACTIVATION_SOFTSIGN);
+    }
+
+    inline Expression ActivationTanh(Expression input)
+    {
+        DMLX_ACTIVATION_IMPL(ACTIVATION_TANH);
+    }
+
+    inline Expression ActivationThresholdedRelu(Expression input, float alpha = 1.0f)
+    {
+        DMLX_ACTIVATION_IMPL_1(ACTIVATION_THRESHOLDED_RELU, Alpha, alpha);
+    }
+
+    inline Expression ActivationShrink(Expression input, float bias = 0.0f, float threshold = 0.5f)
+    {
+        DMLX_ACTIVATION_IMPL_2(ACTIVATION_SHRINK, Bias, bias, Threshold, threshold);
+    }
+
+    inline Expression ActivationCelu(Expression input, float alpha = 1.0f)
+    {
+        DMLX_ACTIVATION_IMPL_1(ACTIVATION_CELU, Alpha, alpha);
+    }
+
+#undef DMLX_ACTIVATION_IMPL
+#undef DMLX_ACTIVATION_IMPL_1
+#undef DMLX_ACTIVATION_IMPL_2
+
+    // ---------------------------------------------------------------------------------------------------------------
+
+    // If not specified, parameters are defaulted to the following values:
+    //   Mode = DML_CONVOLUTION_MODE_CROSS_CORRELATION
+    //   Direction = DML_CONVOLUTION_DIRECTION_FORWARD
+    //   Strides = { 1, 1 } for 2D convolution, { 1, 1, 1 } for 3D convolution
+    //   Dilations = { 1, 1 } for 2D convolution, { 1, 1, 1 } for 3D convolution
+    //   StartPadding = { 0, 0 } for 2D convolution, { 0, 0, 0 } for 3D convolution
+    //   EndPadding = { 0, 0 } for 2D convolution, { 0, 0, 0 } for 3D convolution
+    //   OutputPadding = { 0, 0 } for 2D convolution, { 0, 0, 0 } for 3D convolution
+    //   GroupCount = 1
+    //   FusedActivation = nullptr
+    //   OutputSizes = computed from other parameters
+    inline Expression Convolution(
+        Expression input,
+        Expression filter,
+        Optional<Expression> bias = NullOpt,
+        DML_CONVOLUTION_MODE mode = DML_CONVOLUTION_MODE_CROSS_CORRELATION,
+        DML_CONVOLUTION_DIRECTION direction = DML_CONVOLUTION_DIRECTION_FORWARD,
+        Span<const uint32_t> strides = {},
+        Span<const uint32_t> dilations = {},
+        Span<const uint32_t> startPadding = {},
+        Span<const uint32_t> endPadding = {},
+        Span<const uint32_t> outputPadding = {},
+        uint32_t groupCount = 1,
+        FusedActivation fusedActivation = FusedActivation::None(),
+        TensorDimensions outputSizes = {})
+    {
+        assert(detail::HasSameOwner({ input, filter }));
+        assert(!bias || detail::HasSameOwner({ input, *bias }));
+
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc filterTensor = filter.Impl()->GetOutputDesc();
+        TensorDesc biasTensor;
+        if (bias)
+        {
+            biasTensor = bias->Impl()->GetOutputDesc();
+        }
+
+        uint32_t dimensionCount = static_cast<uint32_t>(inputTensor.sizes.size());
+
+        assert(dimensionCount == 4 || dimensionCount == 5);
+        uint32_t spatialDimensionCount = dimensionCount - 2;
+
+        // If the spatial dimension count is 2, we'll just use the first two elements by setting
+        // DimensionCount = 2 in the desc
+        const uint32_t defaultStridesAndDilations[3] = { 1, 1, 1 };
+        const uint32_t defaultPadding[3] = { 0, 0, 0 };
+
+        assert(strides.empty() || strides.size() == spatialDimensionCount);
+        assert(dilations.empty() || dilations.size() == spatialDimensionCount);
+        assert(startPadding.empty() || startPadding.size() == spatialDimensionCount);
+        assert(endPadding.empty() || endPadding.size() == spatialDimensionCount);
+        assert(outputPadding.empty() || outputPadding.size() == spatialDimensionCount);
+        assert(outputSizes.empty() || outputSizes.size() == inputTensor.sizes.size());
+
+        strides = strides.empty() ? Span<const uint32_t>{ defaultStridesAndDilations } : strides;
+        dilations = dilations.empty() ? Span<const uint32_t>{ defaultStridesAndDilations } : dilations;
+        startPadding = startPadding.empty() ? Span<const uint32_t>{ defaultPadding } : startPadding;
+        endPadding = endPadding.empty() ? Span<const uint32_t>{ defaultPadding } : endPadding;
+        outputPadding = outputPadding.empty() ? Span<const uint32_t>{ defaultPadding } : outputPadding;
+
+        // Compute the output shapes
+
+        if (outputSizes.empty())
+        {
+            std::string error;
+            if (!detail::InferConvolutionOutputSizes(
+                direction,
+                inputTensor.sizes,
+                filterTensor.sizes,
+                strides.data(),
+                dilations.data(),
+                startPadding.data(),
+                endPadding.data(),
+                outputPadding.data(),
+                groupCount,
+                outputSizes,
+                error))
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+        }
+
+        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+        detail::FusedActivationStorage storage;
+
+        DML_CONVOLUTION_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.FilterTensor = filterTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.BiasTensor = bias ? biasTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.Mode = mode;
+        desc.Direction = direction;
+        desc.DimensionCount = spatialDimensionCount;
+        desc.Strides = strides.data();
+        desc.Dilations = dilations.data();
+        desc.StartPadding = startPadding.data();
+        desc.EndPadding = endPadding.data();
+        desc.OutputPadding = outputPadding.data();
+        desc.GroupCount = groupCount;
+        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+
+        SmallVector<detail::NodeOutput*, 3> inputs = { input.Impl(), filter.Impl() };
+        if (bias)
+        {
+            inputs.push_back(bias->Impl());
+        }
+
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_CONVOLUTION, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    // Helper for setting parameters for the Convolution operator. Sample usage:
+    // 
+    //   auto conv = dml::ConvolutionBuilder(...)
+    //        .StartPadding(...)
+    //        .EndPadding(...)
+    //        .Strides(...)
+    //        .Build();
+    // 
+    // Parameters left unspecified will be defaulted with the same values as dml::Convolution().
+    class ConvolutionBuilder
+    {
+    public:
+        ConvolutionBuilder(Expression input, Expression filter, Optional<Expression> bias = NullOpt)
+            : m_input(input), m_filter(filter), m_bias(bias)
+        {}
+
+        ConvolutionBuilder& Mode(DML_CONVOLUTION_MODE mode) { m_mode = mode; return *this; }
+        ConvolutionBuilder& Direction(DML_CONVOLUTION_DIRECTION direction) { m_direction = direction; return *this; }
+        ConvolutionBuilder& Strides(Span<const uint32_t> strides) { m_strides.assign(strides.begin(), strides.end()); return *this; }
+        ConvolutionBuilder& Dilations(Span<const uint32_t> dilations) { m_dilations.assign(dilations.begin(), dilations.end()); return *this; }
+        ConvolutionBuilder& StartPadding(Span<const uint32_t> startPadding) { m_startPadding.assign(startPadding.begin(), startPadding.end()); return *this; }
+        ConvolutionBuilder& EndPadding(Span<const uint32_t> endPadding) { m_endPadding.assign(endPadding.begin(), endPadding.end()); return *this; }
+        ConvolutionBuilder& OutputPadding(Span<const uint32_t> outputPadding) { m_outputPadding.assign(outputPadding.begin(), outputPadding.end()); return *this; }
+        ConvolutionBuilder& GroupCount(uint32_t groupCount) { m_groupCount = groupCount; return *this; }
+        ConvolutionBuilder& FusedActivation(FusedActivation fusedActivation) { m_fusedActivation = fusedActivation; return *this; }
+        ConvolutionBuilder& OutputSizes(TensorDimensions outputSizes) { m_outputSizes = std::move(outputSizes); return *this; }
+
+        Expression Build() const
+        {
+            return Convolution(
+                m_input,
+                m_filter,
+                m_bias,
+                m_mode,
+                m_direction,
+                m_strides,
+                m_dilations,
+                m_startPadding,
+                m_endPadding,
+                m_outputPadding,
+                m_groupCount,
+                m_fusedActivation,
+                m_outputSizes);
+        }
+
+    private:
+        Expression m_input;
+        Expression m_filter;
+        Optional<Expression> m_bias;
+        DML_CONVOLUTION_MODE m_mode = DML_CONVOLUTION_MODE_CROSS_CORRELATION;
+        DML_CONVOLUTION_DIRECTION m_direction = DML_CONVOLUTION_DIRECTION_FORWARD;
+        SmallVector<uint32_t, 3> m_strides = {};
+        SmallVector<uint32_t, 3> m_dilations = {};
+        SmallVector<uint32_t, 3> m_startPadding = {};
+        SmallVector<uint32_t, 3> m_endPadding = {};
+        SmallVector<uint32_t, 3> m_outputPadding = {};
+        uint32_t m_groupCount = 1;
+        dml::FusedActivation m_fusedActivation;
+        TensorDimensions m_outputSizes = {};
+    };
+
+    // ---------------------------------------------------------------------------------------------------------------
+
+    inline Expression Gemm(
+        Expression a,
+        Expression b,
+        Optional<Expression> c = NullOpt,
+        DML_MATRIX_TRANSFORM transA = DML_MATRIX_TRANSFORM_NONE,
+        DML_MATRIX_TRANSFORM transB = DML_MATRIX_TRANSFORM_NONE,
+        float alpha = 1.0f,
+        float beta = 1.0f,
+        FusedActivation fusedActivation = FusedActivation::None())
+    {
+        assert(detail::HasSameOwner({ a, b }));
+        assert(!c || detail::HasSameOwner({ a, *c }));
+
+        detail::GraphBuilder* builder = a.Impl()->GetGraphBuilder();
+
+        TensorDesc aTensor = a.Impl()->GetOutputDesc();
+        TensorDesc bTensor = b.Impl()->GetOutputDesc();
+        TensorDesc cTensor;
+        if (c)
+        {
+            cTensor = c->Impl()->GetOutputDesc();
+        }
+
+        TensorDimensions outputSizes;
+        std::string error;
+        if (!detail::InferGemmOutputSizes(aTensor.sizes, bTensor.sizes, transA, transB, outputSizes, error))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDesc outputTensor(aTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+        detail::FusedActivationStorage storage;
+
+        DML_GEMM_OPERATOR_DESC desc = {};
+        desc.ATensor = aTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.BTensor = bTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.CTensor = c ? cTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.TransA = transA;
+        desc.TransB = transB;
+        desc.Alpha = alpha;
+        desc.Beta = beta;
+        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+
+        SmallVector<detail::NodeOutput*, 3> inputs = { a.Impl(), b.Impl() };
+        if (c)
+        {
+            inputs.push_back(c->Impl());
+        }
+
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_GEMM, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    // Helper for setting parameters for the Gemm operator. Parameters left unspecified will be defaulted with the
+    // same values as dml::Gemm().
+    class GemmBuilder
+    {
+    public:
+        GemmBuilder(Expression a, Expression b, Optional<Expression> c = NullOpt)
+            : m_a(a), m_b(b), m_c(c)
+        {}
+
+        GemmBuilder& TransA(DML_MATRIX_TRANSFORM transA) { m_transA = transA; return *this; }
+        GemmBuilder& TransB(DML_MATRIX_TRANSFORM transB) { m_transB = transB; return *this; }
+        GemmBuilder& Alpha(float alpha) { m_alpha = alpha; return *this; }
+        GemmBuilder& Beta(float beta) { m_beta = beta; return *this; }
+        GemmBuilder& FusedActivation(FusedActivation fusedActivation) { m_fusedActivation = fusedActivation; return *this; }
+
+        Expression Build() const
+        {
+            return Gemm(m_a, m_b, m_c, m_transA, m_transB, m_alpha, m_beta, m_fusedActivation);
+        }
+
+    private:
+        Expression m_a;
+        Expression m_b;
+        Optional<Expression> m_c;
+        DML_MATRIX_TRANSFORM m_transA = DML_MATRIX_TRANSFORM_NONE;
+        DML_MATRIX_TRANSFORM m_transB = DML_MATRIX_TRANSFORM_NONE;
+        float m_alpha = 1.0f;
+        float m_beta = 1.0f;
+        dml::FusedActivation m_fusedActivation;
+    };
+
+    // ---------------------------------------------------------------------------------------------------------------
+
+    // If `axes` is not specified, by default this reduces the entire tensor to single element.
+    inline Expression Reduce(Expression input, DML_REDUCE_FUNCTION function, Span<const uint32_t> axes = {})
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        uint32_t dimensionCount = static_cast<uint32_t>(inputTensor.sizes.size());
+
+        SmallVector<uint32_t, 4> defaultAxes;
+        if (axes.empty())
+        {
+            for (uint32_t i = 0; i < dimensionCount; ++i)
+            {
+                defaultAxes.push_back(i);
+            }
+            axes = defaultAxes;
+        }
+
+        // Compute the output tensor dimensions. Reduced dimensions have a size of 1 in the output tensor; the others
+        // match the input tensor.
+        TensorDimensions outputSizes;
+        std::string error;
+        if (!detail::InferReduceOutputSizes(inputTensor.sizes, axes, outputSizes, error))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        // ARGMIN and ARGMAX reduction produce a UINT32 output; all other reductions produce an output with the same
+        // type as the input.
+        DML_TENSOR_DATA_TYPE outputDataType;
+        if (function == DML_REDUCE_FUNCTION_ARGMIN || function == DML_REDUCE_FUNCTION_ARGMAX)
+        {
+            outputDataType = DML_TENSOR_DATA_TYPE_UINT32;
+        }
+        else
+        {
+            outputDataType = inputTensor.dataType;
+        }
+
+        TensorDesc outputTensor(outputDataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_REDUCE_OPERATOR_DESC desc = {};
+        desc.Function = function;
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.AxisCount = static_cast<uint32_t>(axes.size());
+        desc.Axes = axes.data();
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_REDUCE, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression AveragePooling(
+        Expression input,
+        Span<const uint32_t> strides,
+        Span<const uint32_t> windowSizes,
+        Span<const uint32_t> startPadding,
+        Span<const uint32_t> endPadding,
+        bool includePadding)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+
+        assert(strides.size() == windowSizes.size());
+        assert(strides.size() == startPadding.size());
+        assert(strides.size() == endPadding.size());
+
+        // Calculate output size
+        TensorDimensions outputSizes;
+        std::string error;
+        if (!detail::InferPoolingOutputSizes(
+            inputTensor.sizes,
+            static_cast<uint32_t>(windowSizes.size()),
+            strides.data(),
+            windowSizes.data(),
+            startPadding.data(),
+            endPadding.data(),
+            nullptr, // Average pooling windows aren't dilated
+            outputSizes,
+            error))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_AVERAGE_POOLING_OPERATOR_DESC averagePoolDesc = {};
+        averagePoolDesc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        averagePoolDesc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        averagePoolDesc.DimensionCount = static_cast<uint32_t>(windowSizes.size());
+        averagePoolDesc.Strides = strides.data();
+        averagePoolDesc.WindowSize = windowSizes.data();
+        averagePoolDesc.StartPadding = startPadding.data();
+        averagePoolDesc.EndPadding = endPadding.data();
+        averagePoolDesc.IncludePadding = includePadding;
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_AVERAGE_POOLING, &averagePoolDesc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    // 
+    // TODO: LpPooling
+    // 
+
+    // ---------------------------------------------------------------------------------------------------------------
+
+    struct MaxPoolingOutputs
+    {
+        Expression values;
+        Expression indices; // Only valid if outputIndices = true is supplied to MaxPooling()
+    };
+
+    // If not specified, parameters are defaulted to the following values:
+    //   Strides = 1 for each spatial dimension
+    //   StartPadding = 0 for each spatial dimension
+    //   EndPadding = 0 for each spatial dimension
+    //   Dilations = 1 for each spatial dimension
+    //   OutputIndices = false
+    inline MaxPoolingOutputs MaxPooling(
+        Expression input,
+        Span<const uint32_t> windowSize,
+        Span<const uint32_t> strides = {},
+        Span<const uint32_t> startPadding = {},
+        Span<const uint32_t> endPadding = {},
+        Span<const uint32_t> dilations = {},
+        bool outputIndices = false)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+
+        // If the spatial dimension count is 2, we'll just use the first two elements by setting
+        // DimensionCount = 2 in the desc
+        const uint32_t defaultStridesAndDilations[3] = { 1, 1, 1 };
+        const uint32_t defaultPadding[3] = { 0, 0, 0 };
+
+        assert(windowSize.size() == 2 || windowSize.size() == 3);
+        assert(strides.empty() || strides.size() == windowSize.size());
+        assert(dilations.empty() || dilations.size() == windowSize.size());
+        assert(startPadding.empty() || startPadding.size() == windowSize.size());
+        assert(endPadding.empty() || endPadding.size() == windowSize.size());
+
+        strides = strides.empty() ? Span<const uint32_t>{ defaultStridesAndDilations } : strides;
+        dilations = dilations.empty() ? Span<const uint32_t>{ defaultStridesAndDilations } : dilations;
+        startPadding = startPadding.empty() ? Span<const uint32_t>{ defaultPadding } : startPadding;
+        endPadding = endPadding.empty() ? Span<const uint32_t>{ defaultPadding } : endPadding;
+
+        // Calculate output size
+        TensorDimensions outputSizes;
+        std::string error;
+        if (!detail::InferPoolingOutputSizes(
+            inputTensor.sizes,
+            static_cast<uint32_t>(windowSize.size()),
+            strides.data(),
+            windowSize.data(),
+            startPadding.data(),
+            endPadding.data(),
+            dilations.data(),
+            outputSizes,
+            error))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDesc outputTensor(inputTensor.dataType, outputSizes, builder->GetTensorPolicy());
+        TensorDesc outputIndicesTensor(DML_TENSOR_DATA_TYPE_UINT32, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_MAX_POOLING2_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputIndicesTensor = outputIndices ? outputIndicesTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
+        desc.DimensionCount = static_cast<uint32_t>(windowSize.size());
+        desc.Strides = strides.data();
+        desc.WindowSize = windowSize.data();
+        desc.StartPadding = startPadding.data();
+        desc.EndPadding = endPadding.data();
+        desc.Dilations = dilations.data();
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_MAX_POOLING2, &desc, inputs);
+
+        detail::NodeOutput* outputExpr = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+        if (outputIndices)
+        {
+            detail::NodeOutput* outputIndicesExpr = builder->CreateNodeOutput(node, 1, std::move(outputIndicesTensor));
+            return { outputExpr, outputIndicesExpr };
+        }
+        return { outputExpr, Expression() };
+    }
+
+    // Helper for setting parameters for the MaxPooling operator. Sample usage:
+    // 
+    //   auto [out, outIndices] = dml::MaxPoolingBuilder(...)
+    //        .StartPadding(...)
+    //        .EndPadding(...)
+    //        .OutputIndices(...)
+    //        .Build();
+    // 
+    // Parameters left unspecified will be defaulted with the same values as dml::MaxPooling().
+    class MaxPoolingBuilder
+    {
+    public:
+        MaxPoolingBuilder(Expression input, Span<const uint32_t> windowSize)
+            : m_input(input), m_windowSize(windowSize.begin(), windowSize.end())
+        {}
+
+        MaxPoolingBuilder& Strides(Span<const uint32_t> strides) { m_strides.assign(strides.begin(), strides.end()); return *this; }
+        MaxPoolingBuilder& StartPadding(Span<const uint32_t> startPadding) { m_startPadding.assign(startPadding.begin(), startPadding.end()); return *this; }
+        MaxPoolingBuilder& EndPadding(Span<const uint32_t> endPadding) { m_endPadding.assign(endPadding.begin(), endPadding.end()); return *this; }
+        MaxPoolingBuilder& Dilations(Span<const uint32_t> dilations) { m_dilations.assign(dilations.begin(), dilations.end()); return *this; }
+        MaxPoolingBuilder& OutputIndices(bool outputIndices) { m_outputIndices = outputIndices; return *this; }
+
+        MaxPoolingOutputs Build() const
+        {
+            return MaxPooling(
+                m_input,
+                m_windowSize,
+                m_strides,
+                m_startPadding,
+                m_endPadding,
+                m_dilations,
+                m_outputIndices);
+        }
+
+    private:
+        Expression m_input;
+        SmallVector<uint32_t, 3> m_windowSize;
+        SmallVector<uint32_t, 3> m_strides = {};
+        SmallVector<uint32_t, 3> m_startPadding = {};
+        SmallVector<uint32_t, 3> m_endPadding = {};
+        SmallVector<uint32_t, 3> m_dilations = {};
+        bool m_outputIndices = false;
+    };
+
+    // ---------------------------------------------------------------------------------------------------------------
+
+    // 
+    // TODO: MaxUnpooling
+    // 
+
+    // 
+    // TODO: ROIPooling
+    // 
+
+    inline Expression Slice(
+        Expression input,
+        Span<const uint32_t> inputWindowOffsets,
+        Span<const uint32_t> inputWindowSizes,
+        Span<const int32_t> inputWindowStrides)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+
+        assert(inputWindowOffsets.size() == inputWindowStrides.size());
+        assert(inputWindowOffsets.size() == inputWindowSizes.size());
+
+        TensorDimensions outputSizes;
+        std::string error;
+        if (!detail::InferSliceOutputSizes(
+            inputTensor.sizes,
+            static_cast<uint32_t>(inputWindowOffsets.size()),
+            inputWindowOffsets.data(),
+            inputWindowSizes.data(),
+            inputWindowStrides.data(),
+            outputSizes,
+            error))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_SLICE1_OPERATOR_DESC sliceDesc = {};
+        sliceDesc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        sliceDesc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        sliceDesc.DimensionCount = static_cast<uint32_t>(inputWindowOffsets.size());
+        sliceDesc.InputWindowOffsets = inputWindowOffsets.data();
+        sliceDesc.InputWindowSizes = inputWindowSizes.data();
+        sliceDesc.InputWindowStrides = inputWindowStrides.data();
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_SLICE1, &sliceDesc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression Cast(Expression input, DML_TENSOR_DATA_TYPE targetDataType)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(targetDataType, inputTensor.sizes, builder->GetTensorPolicy());
+
+        DML_CAST_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_CAST, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline std::vector<Expression> Split(
+        Expression input,
+        uint32_t axis,
+        Span<const uint32_t> outputAxisSizes)
+    {
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        if (axis >= inputTensor.sizes.size())
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        std::vector<TensorDesc> outputTensors;
+        outputTensors.reserve(outputAxisSizes.size());
+
+        std::vector<DML_TENSOR_DESC> outputDescs;
+        outputDescs.reserve(outputAxisSizes.size());
+
+        std::vector<TensorDimensions> outputSizes;
+        outputSizes.reserve(outputAxisSizes.size());
+
+        for (uint32_t outputAxisSize : outputAxisSizes)
+        {
+            outputSizes.push_back(inputTensor.sizes);
+            outputSizes.back()[axis] = outputAxisSize;
+
+            TensorDesc tensorDesc(inputTensor.dataType, outputSizes.back(), builder->GetTensorPolicy());
+            outputTensors.push_back(std::move(tensorDesc));
+            outputDescs.push_back(*outputTensors.back().AsPtr<DML_TENSOR_DESC>());
+        }
+
+        // The outputs must join back into the input
+        TensorDimensions joinedSizes;
+        std::string error;
+        if (!detail::InferJoinOutputSizes(outputSizes, axis, joinedSizes, error) || joinedSizes != inputTensor.sizes)
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        DML_SPLIT_OPERATOR_DESC desc = {};
+        desc.Axis = axis;
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensors = outputDescs.data();
+        desc.OutputCount = static_cast<uint32_t>(outputAxisSizes.size());
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_SPLIT, &desc, inputs);
+
+        std::vector<Expression> outputs;
+        outputs.reserve(outputAxisSizes.size());
+
+        for (uint32_t i = 0; i < outputAxisSizes.size(); ++i)
+        {
+            outputs.push_back(builder->CreateNodeOutput(node, i, std::move(outputTensors[i])));
+        }
+
+        return outputs;
+    }
+
+    inline Expression Join(
+        Span<const Expression> inputs,
+        uint32_t axis)
+    {
+        assert(!inputs.empty());
+
+        detail::GraphBuilder* builder = inputs[0].Impl()->GetGraphBuilder();
+        DML_TENSOR_DATA_TYPE dataType = inputs[0].Impl()->GetOutputDesc().dataType;
+
+        std::vector<TensorDimensions> inputSizes;
+        inputSizes.reserve(inputs.size());
+
+        std::vector<TensorDesc> inputTensors;
+        inputTensors.reserve(inputs.size());
+
+        std::vector<DML_TENSOR_DESC> inputDescs;
+        inputDescs.reserve(inputs.size());
+
+        std::vector<detail::NodeOutput*> inputNodes;
+        inputNodes.reserve(inputs.size());
+
+        for (Expression input : inputs)
+        {
+            inputTensors.push_back(input.Impl()->GetOutputDesc());
+            TensorDesc& inputTensor = inputTensors.back();
+            inputSizes.push_back(inputTensor.sizes);
+            inputDescs.push_back(*inputTensor.AsPtr<DML_TENSOR_DESC>());
+            inputNodes.push_back(input.Impl());
+        }
+
+        TensorDimensions outputSizes;
+        std::string error;
+        if (!detail::InferJoinOutputSizes(inputSizes, axis, outputSizes, error))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDesc outputTensor(dataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_JOIN_OPERATOR_DESC desc = {};
+        desc.Axis = axis;
+        desc.InputCount = static_cast<uint32_t>(inputDescs.size());
+        desc.InputTensors = inputDescs.data();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_JOIN, &desc, inputNodes);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression Padding(
+        Expression input,
+        DML_PADDING_MODE paddingMode,
+        float paddingValue,
+        Span<const uint32_t> startPadding,
+        Span<const uint32_t> endPadding)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+
+        assert(startPadding.size() == endPadding.size());
+
+        TensorDimensions outputSizes;
+        std::string error;
+        if (!detail::InferPaddingOutputSizes(
+            inputTensor.sizes,
+            static_cast<uint32_t>(startPadding.size()),
+            startPadding.data(),
+            endPadding.data(),
+            outputSizes,
+            error))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_PADDING_OPERATOR_DESC paddingDesc = {};
+        paddingDesc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        paddingDesc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        paddingDesc.PaddingMode = paddingMode;
+        paddingDesc.PaddingValue = paddingValue;
+        paddingDesc.DimensionCount = static_cast<uint32_t>(startPadding.size());
+        paddingDesc.StartPadding = startPadding.data();
+        paddingDesc.EndPadding = endPadding.data();
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_PADDING, &paddingDesc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression ValueScale2D(
+        Expression input,
+        float scale,
+        Span<const float> bias)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+
+        DML_VALUE_SCALE_2D_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.Scale = scale;
+        desc.ChannelCount = static_cast<uint32_t>(bias.size());
+        desc.Bias = bias.data();
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_VALUE_SCALE_2D, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression Upsample2D(Expression input, DML_SIZE_2D scaleSize, DML_INTERPOLATION_MODE interpolationMode)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+
+        TensorDimensions outputSizes;
+        std::string error;
+        if (!detail::InferUpsample2DOutputSizes(inputTensor.sizes, scaleSize, outputSizes, error))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_UPSAMPLE_2D_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ScaleSize = scaleSize;
+        desc.InterpolationMode = interpolationMode;
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_UPSAMPLE_2D, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression Gather(
+        Expression input,
+        Expression indices,
+        uint32_t axis,
+        uint32_t indexDimensions)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc indicesTensor = indices.Impl()->GetOutputDesc();
+
+        TensorDimensions outputSizes;
+        std::string error;
+        if (!detail::InferGatherOutputSizes(inputTensor.sizes, indicesTensor.sizes, axis, indexDimensions, outputSizes, error))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_GATHER_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.IndicesTensor = indicesTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.Axis = axis;
+        desc.IndexDimensions = indexDimensions;
+
+        detail::NodeOutput* const inputs[] = { input.Impl(), indices.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_GATHER, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression GatherElements(
+        Expression input,
+        Expression indices,
+        uint32_t axis)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc indicesTensor = indices.Impl()->GetOutputDesc();
+
+        TensorDesc outputTensor(inputTensor.dataType, indicesTensor.sizes, builder->GetTensorPolicy());
+
+        DML_GATHER_ELEMENTS_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.IndicesTensor = indicesTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.Axis = axis;
+
+        detail::NodeOutput* const inputs[] = { input.Impl(), indices.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_GATHER_ELEMENTS, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    // 
+    // TODO: GatherND (DML_OPERATOR_GATHER_ND1)
+    // 
+
+    inline Expression ScatterElements(
+        Expression input,
+        Expression indices,
+        Expression updates,
+        uint32_t axis)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc indicesTensor = indices.Impl()->GetOutputDesc();
+        TensorDesc updatesTensor = updates.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+
+        DML_SCATTER_ELEMENTS_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.IndicesTensor = indicesTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.UpdatesTensor = updatesTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.Axis = axis;
+
+        detail::NodeOutput* const inputs[] = { input.Impl(), indices.Impl(), updates.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_SCATTER_ELEMENTS, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression ScatterND(
+        Expression input,
+        Expression indices,
+        Expression updates,
+        uint32_t inputDimensionCount,
+        uint32_t indicesDimensionCount)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc indicesTensor = indices.Impl()->GetOutputDesc();
+        TensorDesc updatesTensor = updates.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+
+        DML_SCATTER_ND_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.IndicesTensor = indicesTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.UpdatesTensor = updatesTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.InputDimensionCount = inputDimensionCount;
+        desc.IndicesDimensionCount = indicesDimensionCount;
+
+        detail::NodeOutput* const inputs[] = { input.Impl(), indices.Impl(), updates.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_SCATTER_ND, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    // 
+    // TODO: SpaceToDepth (DML_OPERATOR_SPACE_TO_DEPTH1)
+    // 
+
+    // 
+    // TODO: DepthToSpace (DML_OPERATOR_DEPTH_TO_SPACE1)
+    // 
+
+    inline Expression Tile(Expression input, Span<const uint32_t> repeats)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+
+        TensorDimensions outputSizes;
+        std::string error;
+        if (!detail::InferTileOutputSizes(inputTensor.sizes, repeats, outputSizes, error))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_TILE_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.RepeatsCount = static_cast<uint32_t>(repeats.size());
+        desc.Repeats = repeats.data();
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_TILE, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    // 
+    // TODO: TopK (DML_OPERATOR_TOP_K1)
+    // 
+
+    inline Expression BatchNormalization(
+        Expression input,
+        Expression mean,
+        Expression variance,
+        Expression scale,
+        Expression bias,
+        bool spatial,
+        float epsilon,
+        FusedActivation fusedActivation = FusedActivation::None())
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc meanTensor = mean.Impl()->GetOutputDesc();
+        TensorDesc varianceTensor = variance.Impl()->GetOutputDesc();
+        TensorDesc scaleTensor = scale.Impl()->GetOutputDesc();
+        TensorDesc biasTensor = bias.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+
+        detail::FusedActivationStorage storage;
+
+        DML_BATCH_NORMALIZATION_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.MeanTensor = meanTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.VarianceTensor = varianceTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ScaleTensor = scaleTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.BiasTensor = biasTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.Spatial = spatial;
+        desc.Epsilon = epsilon;
+        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+
+        detail::NodeOutput* const inputs[] = { input.Impl(), mean.Impl(), variance.Impl(), scale.Impl(), bias.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_BATCH_NORMALIZATION, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression MeanVarianceNormalization(
+        Expression input,
+        Optional<Expression> scale,
+        Optional<Expression> bias,
+        Span<const uint32_t> axes,
+        bool normalizeVariance,
+        float epsilon,
+        FusedActivation fusedActivation = FusedActivation::None())
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+        TensorDesc scaleTensor;
+        TensorDesc biasTensor;
+
+        if (scale)
+        {
+            scaleTensor = scale->Impl()->GetOutputDesc();
+        }
+        if (bias)
+        {
+            biasTensor = bias->Impl()->GetOutputDesc();
+        }
+
+        detail::FusedActivationStorage storage;
+
+        DML_MEAN_VARIANCE_NORMALIZATION1_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ScaleTensor = scale ? scaleTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
+        desc.BiasTensor = bias ? biasTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.AxisCount = static_cast<UINT>(axes.size());
+        desc.Axes = axes.data();
+        desc.NormalizeVariance = normalizeVariance;
+        desc.Epsilon = epsilon;
+        desc.FusedActivation = detail::GetFusedActivationPtr(fusedActivation, &storage);
+
+        detail::NodeOutput* const inputs[] =
+        {
+            input.Impl(),
+            scale ? scale->Impl() : nullptr,
+            bias ? bias->Impl() : nullptr
+        };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_MEAN_VARIANCE_NORMALIZATION1, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression LocalResponseNormalization(
+        Expression input,
+        bool crossChannel,
+        uint32_t localSize,
+        float alpha,
+        float beta,
+        float bias)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+
+        DML_LOCAL_RESPONSE_NORMALIZATION_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.CrossChannel = crossChannel;
+        desc.LocalSize = localSize;
+        desc.Alpha = alpha;
+        desc.Beta = beta;
+        desc.Bias = bias;
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_LOCAL_RESPONSE_NORMALIZATION, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    // 
+    // TODO: LpNormalization
+    // 
+
+    // 
+    // TODO: RNN
+    // 
+
+    // 
+    // TODO: LSTM
+    // 
+
+    enum class GRUOutputOptions
+    {
+        Both,
+        Sequence,
+        Single,
+    };
+
+    struct GRUOutputs
+    {
+        Expression sequence;
+        Expression single; 
+    };
+
+    inline GRUOutputs GRU(
+        Expression input,
+        Expression weight,
+        Expression recurrence,
+        Optional<Expression> bias,
+        Optional<Expression> hiddenInit,
+        Optional<Expression> sequenceLengths,
+        Span<const FusedActivation> activationDescs,
+        DML_RECURRENT_NETWORK_DIRECTION direction,
+        bool linearBeforeReset,
+        GRUOutputOptions outputOptions)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc weightTensor = weight.Impl()->GetOutputDesc();
+        TensorDesc recurrenceTensor = recurrence.Impl()->GetOutputDesc();
+        TensorDesc biasTensor;
+        TensorDesc hiddenInitTensor;
+        TensorDesc sequenceLengthsTensor;
+        TensorDesc outputSequenceTensor;
+        TensorDesc outputSingleTensor;
+        if (bias)
+        {
+            biasTensor = bias->Impl()->GetOutputDesc();
+        }
+        if (hiddenInit)
+        {
+            hiddenInitTensor = hiddenInit->Impl()->GetOutputDesc();
+        }
+        if (sequenceLengths)
+        {
+            sequenceLengthsTensor = sequenceLengths->Impl()->GetOutputDesc();
+        }
+
+        // The hidden size comes from the recurrence weights, since the initial hidden state is optional
+        TensorDesc::Dimensions outputSequenceSizes;
+        TensorDesc::Dimensions outputSingleSizes;
+        std::string error;
+        if (!detail::InferGRUOutputSizes(
+            inputTensor.sizes,
+            weightTensor.sizes,
+            recurrenceTensor.sizes,
+            direction,
+            outputSequenceSizes,
+            outputSingleSizes,
+            error))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+        if (outputOptions == GRUOutputOptions::Sequence || outputOptions == GRUOutputOptions::Both)
+        {
+            outputSequenceTensor = TensorDesc(inputTensor.dataType, outputSequenceSizes, builder->GetTensorPolicy());
+        }
+        if (outputOptions == GRUOutputOptions::Single || outputOptions == GRUOutputOptions::Both)
+        {
+            outputSingleTensor = TensorDesc(inputTensor.dataType, outputSingleSizes, builder->GetTensorPolicy());
+        }
+
+        uint32_t activationCount = static_cast<uint32_t>(activationDescs.size());
+        if (activationCount > 4)
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        detail::FusedActivationStorage storage[4];
+        DML_OPERATOR_DESC activationDescArray[4];
+        for (uint32_t i = 0; i < activationCount; ++i)
+        {
+            activationDescArray[i] = *detail::GetFusedActivationPtr(activationDescs[i], &storage[i]);
+        }
+
+        DML_GRU_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.WeightTensor = weightTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.RecurrenceTensor = recurrenceTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.BiasTensor = bias ? biasTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
+        desc.HiddenInitTensor = hiddenInit ? hiddenInitTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
+        desc.SequenceLengthsTensor = sequenceLengths ? sequenceLengthsTensor.AsPtr<DML_TENSOR_DESC>() : nullptr;
+        desc.OutputSequenceTensor = outputSequenceTensor.sizes.empty() ? nullptr : outputSequenceTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputSingleTensor = outputSingleTensor.sizes.empty() ? nullptr : outputSingleTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ActivationDescCount = activationCount;
+        desc.ActivationDescs = activationDescArray;
+        desc.Direction = direction;
+        desc.LinearBeforeReset = linearBeforeReset;
+
+        // Node inputs are matched to the operator's inputs by position, so absent optional inputs are null
+        SmallVector<detail::NodeOutput*, 6> inputs =
+        {
+            input.Impl(),
+            weight.Impl(),
+            recurrence.Impl(),
+            bias ? bias->Impl() : nullptr,
+            hiddenInit ? hiddenInit->Impl() : nullptr,
+            sequenceLengths ? sequenceLengths->Impl() : nullptr,
+        };
+
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_GRU, &desc, inputs);
+
+        detail::NodeOutput* outputSequenceExpr = nullptr;
+        detail::NodeOutput* outputSingleExpr = nullptr;
+        if (outputOptions == GRUOutputOptions::Sequence || outputOptions == GRUOutputOptions::Both)
+        {
+             outputSequenceExpr = builder->CreateNodeOutput(node, 0, std::move(outputSequenceTensor));
+        }
+        if (outputOptions == GRUOutputOptions::Single || outputOptions == GRUOutputOptions::Both)
+        {
+             outputSingleExpr = builder->CreateNodeOutput(node, 1, std::move(outputSingleTensor));
+        }
+        return { outputSequenceExpr, outputSingleExpr };
+    }
+
+    // 
+    // TODO: DiagonalMatrix
+    //
+
+    inline Expression OneHot(
+        Expression indices,
+        Expression values,
+        uint32_t outputLength,
+        uint32_t axis)
+    {
+        detail::GraphBuilder* builder = indices.Impl()->GetGraphBuilder();
+        TensorDesc indicesTensor = indices.Impl()->GetOutputDesc();
+        TensorDesc valuesTensor = values.Impl()->GetOutputDesc();
+
+        // The output and indices sizes must all match except for the active axis, which is supplied as outputLength.
+        TensorDimensions outputSizes;
+        std::string error;
+        if (!detail::InferOneHotOutputSizes(indicesTensor.sizes, valuesTensor.sizes, outputLength, axis, outputSizes, error))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDesc outputTensor(valuesTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_ONE_HOT_OPERATOR_DESC desc = {};
+        desc.IndicesTensor = indicesTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ValuesTensor = valuesTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.Axis = axis;
+
+        detail::NodeOutput* const inputs[] = { indices.Impl(), values.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ONE_HOT, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    // If not specified, parameters are defaulted to the following values:
+    //   Scales = computed by dividing the output sizes by the input sizes
+    //   InputPixelOffsets = 0.5f for each dimension
+    //   OutputPixelOffsets = -0.5f for each dimension
+    inline Expression Resample(
+        Expression input,
+        TensorDimensions outputSizes,
+        DML_INTERPOLATION_MODE mode,
+        Span<const float> scales = {},
+        Span<const float> inputPixelOffsets = {},
+        Span<const float> outputPixelOffsets = {})
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        uint32_t dimensionCount = static_cast<uint32_t>(inputTensor.sizes.size());
+        assert(outputSizes.size() == dimensionCount);
+
+        SmallVector<float, 4> defaultScales;
+        if (scales.empty())
+        {
+            for (uint32_t i = 0; i < dimensionCount; ++i)
+            {
+                defaultScales.push_back(static_cast<float>(outputSizes[i]) / static_cast<float>(inputTensor.sizes[i]));
+            }
+            scales = defaultScales;
+        }
+
+        SmallVector<float, 4> defaultInputPixelOffsets;
+        if (inputPixelOffsets.empty())
+        {
+            defaultInputPixelOffsets.assign(dimensionCount, 0.5f);
+            inputPixelOffsets = defaultInputPixelOffsets;
+        }
+
+        SmallVector<float, 4> defaultOutputPixelOffsets;
+        if (outputPixelOffsets.empty())
+        {
+            defaultOutputPixelOffsets.assign(dimensionCount, -0.5f);
+            outputPixelOffsets = defaultOutputPixelOffsets;
+        }
+
+        std::string error;
+        if (!detail::ValidateResampleSizes(inputTensor.sizes, outputSizes, static_cast<uint32_t>(scales.size()), scales.data(), error))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_RESAMPLE1_OPERATOR_DESC desc = {};
+        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.InterpolationMode = mode;
+        desc.DimensionCount = static_cast<UINT>(scales.size());
+        desc.Scales = scales.data();
+        desc.InputPixelOffsets = inputPixelOffsets.data();
+        desc.OutputPixelOffsets = outputPixelOffsets.data();
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_RESAMPLE1, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression FillValueConstant(
+        Graph& graph,
+        TensorDimensions outputSizes,
+        DML_TENSOR_DATA_TYPE valueDataType,
+        DML_SCALAR_UNION value)
+    {
+        detail::GraphBuilder* builder = graph.Impl();
+        TensorDesc outputTensor(valueDataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_FILL_VALUE_CONSTANT_OPERATOR_DESC desc = {};
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ValueDataType = valueDataType;
+        desc.Value = value;
+
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_FILL_VALUE_CONSTANT, &desc, {});
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    inline Expression FillValueSequence(
+        Graph& graph,
+        TensorDimensions outputSizes,
+        DML_TENSOR_DATA_TYPE valueDataType,
+        DML_SCALAR_UNION valueStart,
+        DML_SCALAR_UNION valueDelta)
+    {
+        detail::GraphBuilder* builder = graph.Impl();
+        TensorDesc outputTensor(valueDataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_FILL_VALUE_SEQUENCE_OPERATOR_DESC desc = {};
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.ValueDataType = valueDataType;
+        desc.ValueStart = valueStart;
+        desc.ValueDelta = valueDelta;
+
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_FILL_VALUE_SEQUENCE, &desc, {});
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    // 
+    // TODO: CumulativeSummation
+    // 
+
+    inline Expression ReverseSubsequences(
+        Expression input,
+        Expression sequenceLengths,
+        uint32_t axis)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc sequenceLengthsTensor = sequenceLengths.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+
+        DML_REVERSE_SUBSEQUENCES_OPERATOR_DESC reverseDesc = {};
+        reverseDesc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        reverseDesc.SequenceLengthsTensor = sequenceLengthsTensor.AsPtr<DML_TENSOR_DESC>();
+        reverseDesc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        reverseDesc.Axis = axis;
+
+        detail::NodeOutput* const inputs[] = { input.Impl(), sequenceLengths.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_REVERSE_SUBSEQUENCES, &reverseDesc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    // 
+    // TODO: MatrixMultiplyInteger
+    // 
+
+    // 
+    // TODO: QuantizedLinearMatrixMultiply
+    // 
+
+    // 
+    // TODO: ConvolutionInteger
+    // 
+
+    // 
+    // TODO: QuantizedLinearConvolution
+    // 
+
+    // 
+    // TODO: ReluGrad
+    // 
+
+    // 
+    // TODO: AveragePoolingGrad
+    // 
+
+    // 
+    // TODO: MaxPoolingGrad
+    // 
+
+    struct RandomGeneratorOutputs
+    {
+        Expression values;
+        Expression state; // Only valid if outputState = true is supplied to RandomGenerator
+    };
+
+    inline RandomGeneratorOutputs RandomGenerator(
+        Expression inputState,
+        TensorDimensions outputSizes,
+        bool outputState = true,
+        DML_RANDOM_GENERATOR_TYPE type = DML_RANDOM_GENERATOR_TYPE_PHILOX_4X32_10)
+    {
+        detail::GraphBuilder* builder = inputState.Impl()->GetGraphBuilder();
+
+        TensorDesc inputStateTensor = inputState.Impl()->GetOutputDesc();
+        TensorDesc outputTensor(DML_TENSOR_DATA_TYPE_UINT32, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_RANDOM_GENERATOR_OPERATOR_DESC desc = {};
+        desc.Type = type;
+        desc.InputStateTensor = inputStateTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        if (outputState)
+        {
+            // Input and output state have the same TensorDesc.
+            desc.OutputStateTensor = inputStateTensor.AsPtr<DML_TENSOR_DESC>();
+        }
+        
+        RandomGeneratorOutputs out;
+
+        detail::NodeOutput* const inputs[] = { inputState.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_RANDOM_GENERATOR, &desc, inputs);
+        out.values = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        if (outputState)
+        {
+            TensorDesc outputStateTensor = inputStateTensor;
+            out.state = builder->CreateNodeOutput(node, 1, std::move(outputStateTensor));
+        }
+
+        return out;
+    }
+
+    // 
+    // TODO: NonZeroCoordinates
+    // 
+
+    // If not specified, parameters are defaulted to the following values:
+    //   Scales = computed by dividing the input sizes by the output sizes
+    //   InputPixelOffsets = 0.5f for each dimension
+    //   OutputPixelOffsets = -0.5f for each dimension
+    inline Expression ResampleGrad(
+        Expression input,
+        TensorDimensions outputSizes,
+        DML_INTERPOLATION_MODE mode,
+        Span<const float> scales = {},
+        Span<const float> inputPixelOffsets = {},
+        Span<const float> outputPixelOffsets = {})
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        uint32_t dimensionCount = static_cast<uint32_t>(inputTensor.sizes.size());
+        assert(outputSizes.size() == dimensionCount);
+
+        SmallVector<float, 4> defaultScales;
+        if (scales.empty())
+        {
+            for (uint32_t i = 0; i < dimensionCount; ++i)
+            {
+                defaultScales.push_back(static_cast<float>(inputTensor.sizes[i]) / static_cast<float>(outputSizes[i]));
+            }
+            scales = defaultScales;
+        }
+
+        SmallVector<float, 4> defaultInputPixelOffsets;
+        if (inputPixelOffsets.empty())
+        {
+            defaultInputPixelOffsets.assign(dimensionCount, 0.5f);
+            inputPixelOffsets = defaultInputPixelOffsets;
+        }
+
+        SmallVector<float, 4> defaultOutputPixelOffsets;
+        if (outputPixelOffsets.empty())
+        {
+            defaultOutputPixelOffsets.assign(dimensionCount, -0.5f);
+            outputPixelOffsets = defaultOutputPixelOffsets;
+        }
+
+        std::string error;
+        if (!detail::ValidateResampleSizes(inputTensor.sizes, outputSizes, static_cast<uint32_t>(scales.size()), scales.data(), error))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+
+        DML_RESAMPLE_GRAD_OPERATOR_DESC desc = {};
+        desc.InputGradientTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.OutputGradientTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+        desc.InterpolationMode = mode;
+        desc.DimensionCount = static_cast<UINT>(scales.size());
+        desc.Scales = scales.data();
+        desc.InputPixelOffsets = inputPixelOffsets.data();
+        desc.OutputPixelOffsets = outputPixelOffsets.data();
+
+        detail::NodeOutput* const inputs[] = { input.Impl() };
+        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_RESAMPLE_GRAD, &desc, inputs);
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+
+        return output;
+    }
+
+    // 
+    // TODO: SliceGrad
+    // 
+
+    // 
+    // TODO: AdamOptimizer
+    // 
+
+    // 
+    // TODO: Argmin
+    // 
+
+    // 
+    // TODO: Argmax
+    // 
+
+    // 
+    // TODO: ROIAlign
+    // 
+
+    // Reinterprets the memory of a tensor with a different type and dimensions (analogously to using
+    // reinterpret_cast to access raw bits). Note that this is different to the DML Cast operator, which performs
+    // a type cast on the contents of a tensor (analogously to static_cast). The total tensor size of the output
+    // (which depends on the supplied type/sizes/strides) must match the input.
+    inline Expression Reinterpret(
+        Expression input,
+        DML_TENSOR_DATA_TYPE newType,
+        TensorDimensions newSizes,
+        Optional<TensorDimensions> newStrides)
+    {
+        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        TensorDesc newTensor(
+            newType,
+            inputTensor.flags,
+            std::move(newSizes),
+            std::move(newStrides),
+            inputTensor.totalTensorSizeInBytes,
+            inputTensor.guaranteedBaseOffsetAlignment);
+
+        detail::NodeID node = builder->CreateReinterpretNode(input.Impl());
+        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(newTensor));
+
+        return output;
+    }
+
+    // Same as Reinterpret above, but only adjusts tensor dimensions without affecting type.
+    inline Expression Reinterpret(
+        Expression input,
+        TensorDimensions newSizes,
+        Optional<TensorDimensions> newStrides)
+    {
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+
+        return Reinterpret(input, inputTensor.dataType, std::move(newSizes), std::move(newStrides));
+    }
+
+    // Same as Reinterpret above, but only adjusts tensor type without affecting sizes or strides.
+    inline Expression Reinterpret(Expression input, DML_TENSOR_DATA_TYPE newType)
+    {
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+
+        return Reinterpret(input, newType, inputTensor.sizes, inputTensor.strides);
+    }
+
+    namespace detail
+    {
+        // Creates a view of the input with new sizes and strides over the same memory. Operators consuming the view
+        // read it in place; it's only copied if it's used as a graph output.
+        inline Expression CreateView(Expression input, TensorDimensions newSizes, TensorDimensions newStrides)
+        {
+            detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+            TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+            TensorDesc newTensor(
+                inputTensor.dataType,
+                inputTensor.flags,
+                std::move(newSizes),
+                std::move(newStrides),
+                inputTensor.totalTensorSizeInBytes,
+                inputTensor.guaranteedBaseOffsetAlignment);
+
+            detail::NodeID node = builder->CreateReinterpretNode(input.Impl(), /*isView*/ true);
+            detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(newTensor));
+
+            return output;
+        }
+    } // namespace detail
+
+    // Permutes the dimensions of a tensor, such that dimension i of the output is dimension permutation[i] of the
+    // input. No data is moved: the permutation is applied to the tensor's strides.
+    inline Expression Transpose(Expression input, Span<const uint32_t> permutation)
+    {
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        const TensorDimensions inputStrides = detail::GetElementStrides(inputTensor);
+        const size_t rank = inputTensor.sizes.size();
+
+        if (permutation.size() != rank)
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDimensions newSizes(rank);
+        TensorDimensions newStrides(rank);
+        std::vector<bool> used(rank, false);
+        for (size_t i = 0; i < rank; ++i)
+        {
+            const uint32_t dimension = permutation[i];
+            if (dimension >= rank || used[dimension])
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+            used[dimension] = true;
+
+            newSizes[i] = inputTensor.sizes[dimension];
+            newStrides[i] = inputStrides[dimension];
+        }
+
+        return detail::CreateView(input, std::move(newSizes), std::move(newStrides));
+    }
+
+    // Broadcasts a tensor to a larger shape following NumPy rules: dimensions are right-aligned, and each dimension of
+    // the input must either match the new size or be 1. Broadcast dimensions are given a stride of 0, so no data is
+    // replicated.
+    inline Expression Broadcast(Expression input, TensorDimensions newSizes)
+    {
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        if (newSizes.size() < inputTensor.sizes.size() ||
+            detail::GetBroadcastSizes({ &inputTensor.sizes, &newSizes }) != newSizes)
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDesc newTensor = detail::BroadcastTensor(inputTensor, newSizes);
+        return detail::CreateView(input, std::move(newTensor.sizes), detail::GetElementStrides(newTensor));
+    }
+
+    // Selects every steps[i]-th element of dimension i of the input, starting from the first, for newSizes[i]
+    // elements. A step of 0 repeats the first element. Buffer tensor descs have no base offset, so unlike a general
+    // strided slice the view always starts at the first element of the input.
+    inline Expression StridedView(Expression input, TensorDimensions newSizes, Span<const uint32_t> steps)
+    {
+        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+        const TensorDimensions inputStrides = detail::GetElementStrides(inputTensor);
+        const size_t rank = inputTensor.sizes.size();
+
+        if (newSizes.size() != rank || steps.size() != rank)
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+
+        TensorDimensions newStrides(rank);
+        for (size_t i = 0; i < rank; ++i)
+        {
+            // The last selected element must lie within the input
+            if (newSizes[i] == 0 || uint64_t(newSizes[i] - 1) * steps[i] >= inputTensor.sizes[i])
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            newStrides[i] = inputStrides[i] * steps[i];
+        }
+
+        return detail::CreateView(input, std::move(newSizes), std::move(newStrides));
+    }
+
+    // Operator overloads for convenience, which merely map to one of the functions above
+    inline Expression operator+(Expression a, Expression b) { return dml::Add(a, b); }
+    inline Expression operator-(Expression a, Expression b) { return dml::Subtract(a, b); }
+    inline Expression operator*(Expression a, Expression b) { return dml::Multiply(a, b); }
+    inline Expression operator/(Expression a, Expression b) { return dml::Divide(a, b); }
+    inline Expression operator%(Expression a, Expression b) { return dml::ModulusTruncate(a, b); }
+    inline Expression operator&(Expression a, Expression b) { return dml::BitAnd(a, b); }
+    inline Expression operator|(Expression a, Expression b) { return dml::BitOr(a, b); }
+    inline Expression operator^(Expression a, Expression b) { return dml::BitXor(a, b); }
+    inline Expression operator<<(Expression a, Expression b) { return dml::BitShiftLeft(a, b); }
+    inline Expression operator>>(Expression a, Expression b) { return dml::BitShiftRight(a, b); }
+    inline Expression& operator+=(Expression& a, Expression b) { a = a + b; return a; }
+    inline Expression& operator-=(Expression& a, Expression b) { a = a - b; return a; }
+    inline Expression& operator*=(Expression& a, Expression b) { a = a * b; return a; }
+    inline Expression& operator/=(Expression& a, Expression b) { a = a / b; return a; }
+    inline Expression& operator%=(Expression& a, Expression b) { a = a % b; return a; }
+    inline Expression& operator&=(Expression& a, Expression b) { a = a & b; return a; }
+    inline Expression& operator|=(Expression& a, Expression b) { a = a | b; return a; }
+    inline Expression& operator^=(Expression& a, Expression b) { a = a ^ b; return a; }
+    inline Expression& operator<<=(Expression& a, Expression b) { a = a << b; return a; }
+    inline Expression& operator>>=(Expression& a, Expression b) { a = a >> b; return a; }
+
+    // Operations involving scalars can be reduced to elementwise identity
+    inline Expression operator+(Expression a, float b) { return dml::Identity(a, DML_SCALE_BIAS{ 1.0f, b }); }
+    inline Expression operator-(Expression a, float b) { return dml::Identity(a, DML_SCALE_BIAS{ 1.0f, -b }); }
+    inline Expression operator*(Expression a, float b) { return dml::Identity(a, DML_SCALE_BIAS{ b, 0.0f }); }
+    inline Expression operator/(Expression a, float b) { return dml::Identity(a, DML_SCALE_BIAS{ 1.0f / b, 0.0f }); }
+    inline Expression operator+(float a, Expression b) { return dml::Identity(b, DML_SCALE_BIAS{ 1.0f, a }); }
+    inline Expression operator-(float a, Expression b) { return dml::Identity(b, DML_SCALE_BIAS{ -1.0f, a }); }
+    inline Expression operator*(float a, Expression b) { return dml::Identity(b, DML_SCALE_BIAS{ a, 0.0f }); }
+    inline Expression operator/(float a, Expression b) { return dml::Recip(b, DML_SCALE_BIAS{ a, 0.0f }); }
+    inline Expression& operator+=(Expression& a, float b) { a = a + b; return a; }
+    inline Expression& operator-=(Expression& a, float b) { a = a - b; return a; }
+    inline Expression& operator*=(Expression& a, float b) { a = a * b; return a; }
+    inline Expression& operator/=(Expression& a, float b) { a = a / b; return a; }
+
+    // Unary
+    inline Expression operator~(Expression input) { return dml::BitNot(input); }
+    inline Expression operator+(Expression input) { return dml::Identity(input); }
+    inline Expression operator-(Expression input) { return dml::Identity(input, DML_SCALE_BIAS{ -1.0f, 0.0f }); }
+
+    // Logical
+    inline Expression operator!(Expression a) { return dml::LogicalNot(a); }
+    inline Expression operator&&(Expression a, Expression b) { return dml::LogicalAnd(a, b); }
+    inline Expression operator||(Expression a, Expression b) { return dml::LogicalOr(a, b); }
+    inline Expression operator>(Expression a, Expression b) { return dml::GreaterThan(a, b); }
+    inline Expression operator<(Expression a, Expression b) { return dml::LessThan(a, b); }
+    inline Expression operator==(Expression a, Expression b) { return dml::Equals(a, b); }
+    inline Expression operator!=(Expression a, Expression b) { return !(a == b); }
+    inline Expression operator>=(Expression a, Expression b) { return dml::GreaterThanOrEqual(a, b); }
+    inline Expression operator<=(Expression a, Expression b) { return dml::LessThanOrEqual(a, b); }
+
+    // GraphBuilder implementation details
+    namespace detail
+    {
+        inline NodeID GraphBuilder::CreateOperatorNode(
+            DML_OPERATOR_TYPE type,
+            const void* desc,
+            Span<NodeOutput* const> inputs)
+        {
+            OperatorNode node = {};
+            std::string key;
+            if (HasOperatorSchema(type))
+            {
+                if (m_commonSubexpressionElimination)
+                {
+                    OperatorDescEncoder encoder(key);
+                    encoder.WriteOperator(DML_OPERATOR_DESC{ type, desc });
+                    for (NodeOutput* input : inputs)
+                    {
+                        encoder.WriteValue(input);
+                    }
+
+                    // The existing node keeps its name, not the current scope's
+                    auto existing = m_operatorNodeLookup.find(key);
+                    if (existing != m_operatorNodeLookup.end())
+                    {
+                        ++m_statistics.mergedNodeCount;
+                        return { NodeType::Operator, existing->second };
+                    }
+                }
+
+                // Keep a copy of the desc; the operator is created on demand when the graph is compiled.
+                node.desc = OwnedOperatorDesc(type, desc, &m_arena);
+            }
+            else
+            {
+                if (!m_device)
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
+
+                DML_OPERATOR_DESC opDesc = { type, desc };
+                DMLX_THROW_IF_FAILED(m_device->CreateOperator(&opDesc, IID_PPV_ARGS(&node.op)));
+            }
+            node.inputs = AllocateInputs(inputs);
+
+            if (!m_scopePath.empty())
+            {
+                if (!m_scopeName)
+                {
+                    m_scopeName = CopyName(m_scopePath);
+                }
+                node.name = m_scopeName;
+            }
+
+            uint32_t index = static_cast<uint32_t>(m_operatorNodes.size());
+            m_operatorNodes.push_back(std::move(node));
+
+            if (!key.empty())
+            {
+                m_operatorNodeLookup.emplace(std::move(key), index);
+            }
+
+            return { NodeType::Operator, index };
+        }
+
+        inline NodeID GraphBuilder::CreateInputNode(uint32_t inputIndex)
+        {
+            uint32_t index = static_cast<uint32_t>(m_inputNodes.size());
+            m_inputNodes.push_back(InputNode{ inputIndex });
+            return { NodeType::Input, index };
+        }
+
+        inline void GraphBuilder::PushScope(const char* name)
+        {
+            m_scopePathLengths.push_back(m_scopePath.size());
+            if (!m_scopePath.empty())
+            {
+                m_scopePath += '/';
+            }
+            m_scopePath += name;
+            m_scopeName = nullptr;
+        }
+
+        inline void GraphBuilder::PopScope()
+        {
+            assert(!m_scopePathLengths.empty());
+            m_scopePath.resize(m_scopePathLengths.back());
+            m_scopePathLengths.pop_back();
+            m_scopeName = nullptr;
+        }
+
+        inline void GraphBuilder::SetNodeName(NodeID node, const char* name)
+        {
+            // Only operators are named; graph inputs and reinterpreted tensors aren't nodes of the compiled graph
+            if (node.type != NodeType::Operator)
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            m_operatorNodes[node.index].name = CopyName(m_scopePath.empty() ? name : m_scopePath + '/' + name);
+        }
+
+        inline const char* GraphBuilder::CopyName(const std::string& name)
+        {
+            char* copy = m_arena.Allocate<char>(name.size() + 1);
+            memcpy(copy, name.c_str(), name.size() + 1);
+            return copy;
+        }
+
+        inline NodeOutput* GraphBuilder::CreateConstantInput(TensorDesc tensorDesc, std::vector<uint8_t> data)
+        {
+            uint32_t inputIndex = GetInputCount();
+            SetConstantInputData(inputIndex, std::move(data));
+            return CreateNodeOutput(CreateInputNode(inputIndex), 0, std::move(tensorDesc));
+        }
+
+        inline const std::vector<uint8_t>* GraphBuilder::GetConstantData(NodeOutput* output) const
+        {
+            if (output == nullptr)
+            {
+                return nullptr;
+            }
+
+            NodeID node = ResolveReinterprets(output)->GetNode();
+            if (node.type != NodeType::Input)
+            {
+                return nullptr;
+            }
+
+            return GetConstantInputData(m_inputNodes[node.index].inputIndex);
+        }
+
+        inline NodeID GraphBuilder::CreateReinterpretNode(NodeOutput* input, bool isView)
+        {
+            // The input's own chain is already resolved, so this is a single lookup
+            NodeOutput* root = ResolveReinterprets(input);
+
+            // A reinterpret of a view, e.g. Reinterpret(Transpose(x), newType), reads the root through the view's
+            // layout, so it's a view too. Otherwise a graph output would be bound to the root's untransformed data.
+            isView = isView || IsView(input);
+
+            uint32_t index = static_cast<uint32_t>(m_reinterpretNodes.size());
+            m_reinterpretNodes.push_back(ReinterpretNode{ input, root, isView });
+            return { NodeType::Reinterpret, index };
+        }
+
+        inline NodeOutput* GraphBuilder::CreateNodeOutput(NodeID node, uint32_t outputIndex, TensorDesc tensorDesc)
+        {
+            // With CSE enabled, an output of a merged operator node resolves to the NodeOutput created for the
+            // original node, and a reinterpret resolves to an existing reinterpret of the same input to the same
+            // desc. This keeps NodeOutput pointers canonical so that downstream nodes can merge too.
+            std::string key;
+            if (m_commonSubexpressionElimination && node.type != NodeType::Input)
+            {
+                key = GetNodeOutputKey(node, outputIndex, tensorDesc);
+
+                auto existing = m_nodeOutputLookup.find(key);
+                if (existing != m_nodeOutputLookup.end())
+                {
+                    if (node.type == NodeType::Reinterpret)
+                    {
+                        // The new reinterpret node is left unreferenced
+                        ++m_statistics.mergedNodeCount;
+                    }
+                    return existing->second;
+                }
+            }
+
+            NodeOutput* output = ConstructNodeOutput(node, outputIndex, std::move(tensorDesc));
+
+            if (!key.empty())
+            {
+                m_nodeOutputLookup.emplace(std::move(key), output);
+            }
+
+            return output;
+        }
+
+        inline std::string GraphBuilder::GetNodeOutputKey(NodeID node, uint32_t outputIndex, TensorDesc& tensorDesc) const
+        {
+            std::string key;
+            OperatorDescEncoder encoder(key);
+            encoder.WriteValue(node.type);
+            if (node.type == NodeType::Operator)
+            {
+                encoder.WriteValue(node.index);
+            }
+            else
+            {
+                encoder.WriteValue(m_reinterpretNodes[node.index].input);
+                encoder.WriteValue(m_reinterpretNodes[node.index].isView);
+            }
+            encoder.WriteValue(outputIndex);
+            encoder.WriteTensor(tensorDesc.AsPtr<DML_TENSOR_DESC>());
+            return key;
+        }
+
+        inline NodeOutput* GraphBuilder::ConstructNodeOutput(NodeID node, uint32_t outputIndex, TensorDesc tensorDesc)
+        {
+            void* storage = m_arena.Allocate(sizeof(NodeOutput), alignof(NodeOutput));
+            NodeOutput* output = new (storage) NodeOutput(this, node, outputIndex, std::move(tensorDesc));
+            m_nodeOutputs.push_back(output);
+            return output;
+        }
+
+        inline void GraphBuilder::DestroyNodeOutputs()
+        {
+            // The arena only provides storage, so destructors have to be run here
+            for (NodeOutput* output : m_nodeOutputs)
+            {
+                output->~NodeOutput();
+            }
+            m_nodeOutputs.clear();
+        }
+
+        inline Span<NodeOutput*> GraphBuilder::AllocateInputs(Span<NodeOutput* const> inputs)
+        {
+            Span<NodeOutput*> copy = AllocateInputs(inputs.size());
+            std::copy(inputs.begin(), inputs.end(), copy.begin());
+            return copy;
+        }
+
+        inline Span<NodeOutput*> GraphBuilder::AllocateInputs(size_t count)
+        {
+            return Span<NodeOutput*>(m_arena.Allocate<NodeOutput*>(count), count);
+        }
+
+        inline void GraphBuilder::Reset()
+        {
+            DestroyNodeOutputs();
+            m_inputNodes.clear();
+            m_operatorNodes.clear();
+            m_reinterpretNodes.clear();
+            m_constantInputData.clear();
+            m_materializedViews.clear();
+            m_float16Constants.clear();
+            m_interleavedConstants.clear();
+            m_operatorNodeLookup.clear();
+            m_nodeOutputLookup.clear();
+            m_statistics = {};
+            m_scopeName = nullptr;
+
+            // The rebuilt graph likely has other descs, e.g. after a resolution change
+            m_operatorCache = std::make_shared<OperatorCache>();
+            m_operatorCacheUses.clear();
+
+            // Nothing refers to the arena any more
+            m_arena.Reset();
+        }
+
+        inline std::vector<GraphDiagnostic> GraphBuilder::Validate(Span<const Expression> outputs) const
+        {
+            std::vector<GraphDiagnostic> diagnostics;
+            const std::vector<bool> reachable = FindReachableOperatorNodes(outputs);
+
+            auto report = [&](uint32_t nodeIndex, std::string message)
+            {
+                DML_OPERATOR_TYPE type = DML_OPERATOR_INVALID;
+                if (nodeIndex < m_operatorNodes.size() && m_operatorNodes[nodeIndex].desc.IsValid())
+                {
+                    type = m_operatorNodes[nodeIndex].desc.GetType();
+                }
+                diagnostics.push_back(GraphDiagnostic{ nodeIndex, type, std::move(message) });
+            };
+
+            // Operators without a schema were already validated by DirectML when they were created
+            std::vector<OperatorDescTensors> nodeTensors(m_operatorNodes.size());
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_operatorNodes.size()); ++i)
+            {
+                const OperatorNode& node = m_operatorNodes[i];
+                if (!reachable[i] || !node.desc.IsValid())
+                {
+                    continue;
+                }
+
+                std::vector<std::string> errors;
+                ValidateOperatorDesc(*node.desc.Get(), errors);
+                for (std::string& error : errors)
+                {
+                    report(i, std::move(error));
+                }
+
+                nodeTensors[i] = OperatorDescTensors::Get(*node.desc.Get());
+                const std::vector<DML_TENSOR_DESC*>& inputTensors = nodeTensors[i].inputTensors;
+
+                if (node.inputs.size() > inputTensors.size())
+                {
+                    report(i, "has " + std::to_string(node.inputs.size()) + " inputs, but the operator takes " +
+                        std::to_string(inputTensors.size()));
+                    continue;
+                }
+
+                // Each edge must deliver a tensor of the data type the operator expects, holding at least as many
+                // bytes as the operator reads
+                for (size_t inputIndex = 0; inputIndex < inputTensors.size(); ++inputIndex)
+                {
+                    NodeOutput* input = inputIndex < node.inputs.size() ? node.inputs[inputIndex] : nullptr;
+                    const DML_TENSOR_DESC* tensor = inputTensors[inputIndex];
+                    const std::string name = "input " + std::to_string(inputIndex);
+
+                    if (!input || !tensor)
+                    {
+                        if (input || tensor)
+                        {
+                            report(i, name + (input ? " is connected but has no tensor desc" : " isn't connected"));
+                        }
+                        continue;
+                    }
+
+                    const TensorDesc& producedTensor = input->GetOutputDesc();
+                    const auto& bufferDesc = *static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc);
+                    if (bufferDesc.DataType != producedTensor.dataType)
+                    {
+                        report(i, name + " has data type " + std::to_string(bufferDesc.DataType) +
+                            ", but is connected to a tensor of data type " + std::to_string(producedTensor.dataType));
+                    }
+                    if (bufferDesc.TotalTensorSizeInBytes > producedTensor.totalTensorSizeInBytes)
+                    {
+                        report(i, name + " reads " + std::to_string(bufferDesc.TotalTensorSizeInBytes) +
+                            " bytes, but is connected to a tensor of " +
+                            std::to_string(producedTensor.totalTensorSizeInBytes) + " bytes");
+                    }
+                }
+            }
+
+            // Node outputs must describe the tensors their operator writes
+            for (NodeOutput* output : m_nodeOutputs)
+            {
+                NodeID node = output->GetNode();
+                if (node.type != NodeType::Operator || !reachable[node.index] || !m_operatorNodes[node.index].desc.IsValid())
+                {
+                    continue;
+                }
+
+                const std::vector<DML_TENSOR_DESC*>& outputTensors = nodeTensors[node.index].outputTensors;
+                const uint32_t outputIndex = output->GetOutputIndex();
+                TensorDesc tensorDesc = output->GetOutputDesc();
+                if (outputIndex >= outputTensors.size() || !outputTensors[outputIndex])
+                {
+                    report(node.index, "output " + std::to_string(outputIndex) + " is used but isn't produced");
+                }
+                else if (!AreTensorDescsEqual(outputTensors[outputIndex], tensorDesc.AsPtr<DML_TENSOR_DESC>()))
+                {
+                    report(node.index, "output " + std::to_string(outputIndex) + " has sizes " +
+                        FormatSizes(GetTensorSizes(outputTensors[outputIndex])) +
+                        ", which don't match its expression's " + FormatSizes(tensorDesc.sizes));
+                }
+            }
+
+            for (size_t i = 0; i < outputs.size(); ++i)
+            {
+                NodeOutput* output = outputs[i].Impl();
+                const std::string name = "graph output " + std::to_string(i);
+                if (!output)
+                {
+                    report(UINT32_MAX, name + " is null");
+                    continue;
+                }
+
+                // Views, including reinterprets of views, are copied before being written to an output, so they may
+                // refer to graph inputs directly
+                if (!IsView(output) && ResolveReinterprets(output)->GetNode().type == NodeType::Input)
+                {
+                    report(UINT32_MAX, name + " is a graph input");
+                }
+            }
+
+            return diagnostics;
+        }
+
+        inline MemoryPlan GraphBuilder::PlanMemory(Span<const Expression> outputs, uint64_t alignment) const
+        {
+            if (alignment == 0)
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            auto alignUp = [alignment](uint64_t value) { return (value + alignment - 1) / alignment * alignment; };
+
+            const std::vector<bool> reachable = FindReachableOperatorNodes(outputs);
+
+            std::unordered_set<const NodeOutput*> graphOutputs;
+            for (const Expression& output : outputs)
+            {
+                if (output.Impl())
+                {
+                    graphOutputs.insert(ResolveReinterprets(output.Impl()));
+                }
+            }
+
+            // Every output of a reachable operator is written when the operator runs, even if nothing reads it
+            MemoryPlan plan;
+            plan.alignment = alignment;
+            for (NodeOutput* output : m_nodeOutputs)
+            {
+                NodeID node = output->GetNode();
+                if (node.type != NodeType::Operator || !reachable[node.index] || graphOutputs.count(output))
+                {
+                    continue;
+                }
+
+                MemoryPlanTensor tensor = {};
+                tensor.expression = output;
+                tensor.sizeInBytes = alignUp(output->GetOutputDesc().totalTensorSizeInBytes);
+                tensor.firstNodeIndex = node.index;
+                tensor.lastNodeIndex = node.index;
+                plan.tensors.push_back(tensor);
+            }
+
+            std::stable_sort(plan.tensors.begin(), plan.tensors.end(), [](const MemoryPlanTensor& a, const MemoryPlanTensor& b)
+            {
+                return a.firstNodeIndex < b.firstNodeIndex;
+            });
+            for (size_t i = 0; i < plan.tensors.size(); ++i)
+            {
+                plan.m_tensorIndices.emplace(plan.tensors[i].expression.Impl(), i);
+            }
+
+            // A tensor stays live until the last node reading it
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_operatorNodes.size()); ++i)
+            {
+                if (!reachable[i])
+                {
+                    continue;
+                }
+
+                for (NodeOutput* input : m_operatorNodes[i].inputs)
+                {
+                    if (!input)
+                    {
+                        continue;
+                    }
+
+                    auto entry = plan.m_tensorIndices.find(ResolveReinterprets(input));
+                    if (entry != plan.m_tensorIndices.end())
+                    {
+                        MemoryPlanTensor& tensor = plan.tensors[entry->second];
+                        tensor.lastNodeIndex = std::max(tensor.lastNodeIndex, i);
+                    }
+                }
+            }
+
+            // Place the largest tensors first, each at the lowest offset that doesn't overlap a placed tensor with an
+            // overlapping lifetime.
+            std::vector<size_t> placementOrder(plan.tensors.size());
+            for (size_t i = 0; i < placementOrder.size(); ++i)
+            {
+                placementOrder[i] = i;
+            }
+            std::stable_sort(placementOrder.begin(), placementOrder.end(), [&](size_t a, size_t b)
+            {
+                return plan.tensors[a].sizeInBytes > plan.tensors[b].sizeInBytes;
+            });
+
+            std::vector<const MemoryPlanTensor*> placed;
+            std::vector<const MemoryPlanTensor*> conflicts;
+            for (size_t index : placementOrder)
+            {
+                MemoryPlanTensor& tensor = plan.tensors[index];
+
+                conflicts.clear();
+                for (const MemoryPlanTensor* other : placed)
+                {
+                    if (other->firstNodeIndex <= tensor.lastNodeIndex && tensor.firstNodeIndex <= other->lastNodeIndex)
+                    {
+                        conflicts.push_back(other);
+                    }
+                }
+                std::sort(conflicts.begin(), conflicts.end(), [](const MemoryPlanTensor* a, const MemoryPlanTensor* b)
+                {
+                    return a->offset < b->offset;
+                });
+
+                uint64_t offset = 0;
+                for (const MemoryPlanTensor* other : conflicts)
+                {
+                    if (offset + tensor.sizeInBytes <= other->offset)
+                    {
+                        break;
+                    }
+                    offset = std::max(offset, other->offset + other->sizeInBytes);
+                }
+
+                tensor.offset = offset;
+                placed.push_back(&tensor);
+
+                plan.arenaSizeInBytes = std::max(plan.arenaSizeInBytes, offset + tensor.sizeInBytes);
+                plan.unsharedSizeInBytes += tensor.sizeInBytes;
+            }
+
+            return plan;
+        }
+
+        inline std::vector<GraphDesc> GraphBuilder::PartitionGraphDesc(
+            const GraphDesc& graph,
+            const GraphPartitionOptions& options,
+            GraphPartitionPlan& plan) const
+        {
+            const uint32_t nodeCount = static_cast<uint32_t>(graph.nodes.size());
+
+            std::unordered_set<uint32_t> cutNodes;
+            for (const Expression& cutPoint : options.cutPoints)
+            {
+                NodeID node = ResolveReinterprets(cutPoint.Impl())->GetNode();
+                if (node.type == NodeType::Operator)
+                {
+                    cutNodes.insert(node.index);
+                }
+            }
+
+            // Assign consecutive nodes to partitions. Graph desc nodes are topologically sorted, so every edge either
+            // stays within a partition or goes to a later one.
+            std::vector<uint32_t> nodePartitions(nodeCount);
+            uint32_t partitionNodeCount = 0;
+            uint64_t partitionFlopCount = 0;
+            for (uint32_t i = 0; i < nodeCount; ++i)
+            {
+                const OperatorNode& node = m_operatorNodes[graph.nodes[i]];
+                const uint64_t flopCount = node.desc.IsValid() ? EstimateOperatorFlopCount(*node.desc.Get()) : 0;
+
+                const bool overNodeBudget = options.maxNodeCount && partitionNodeCount + 1 > options.maxNodeCount;
+                const bool overFlopBudget = options.maxFlopCount && partitionFlopCount + flopCount > options.maxFlopCount;
+                if (partitionNodeCount > 0 && (overNodeBudget || overFlopBudget))
+                {
+                    plan.partitions.emplace_back();
+                    partitionNodeCount = 0;
+                    partitionFlopCount = 0;
+                }
+                if (plan.partitions.empty())
+                {
+                    plan.partitions.emplace_back();
+                }
+
+                GraphPartition& partition = plan.partitions.back();
+                nodePartitions[i] = static_cast<uint32_t>(plan.partitions.size() - 1);
+                partition.nodeIndices.push_back(GetSourceNodeIndex(graph.nodes[i]));
+                partition.estimatedFlopCount += flopCount;
+                ++partitionNodeCount;
+                partitionFlopCount += flopCount;
+
+                if (cutNodes.count(graph.nodes[i]) && i + 1 < nodeCount)
+                {
+                    plan.partitions.emplace_back();
+                    partitionNodeCount = 0;
+                    partitionFlopCount = 0;
+                }
+            }
+
+            const uint32_t partitionCount = static_cast<uint32_t>(plan.partitions.size());
+            std::vector<GraphDesc> descs(partitionCount);
+            std::vector<uint32_t> localNodeIndices(nodeCount);
+            for (uint32_t i = 0; i < nodeCount; ++i)
+            {
+                GraphDesc& desc = descs[nodePartitions[i]];
+                localNodeIndices[i] = static_cast<uint32_t>(desc.nodes.size());
+                desc.nodes.push_back(graph.nodes[i]);
+            }
+
+            // Node outputs are identified by (graph desc node index, output index)
+            auto outputKey = [](uint32_t nodeIndex, uint32_t outputIndex)
+            {
+                return (static_cast<uint64_t>(nodeIndex) << 32) | outputIndex;
+            };
+
+            std::vector<uint32_t> graphNodeIndices(m_operatorNodes.size(), UINT32_MAX);
+            for (uint32_t i = 0; i < nodeCount; ++i)
+            {
+                graphNodeIndices[graph.nodes[i]] = i;
+            }
+
+            std::unordered_map<uint64_t, const NodeOutput*> nodeOutputs;
+            for (const NodeOutput* output : m_nodeOutputs)
+            {
+                NodeID node = output->GetNode();
+                if (node.type == NodeType::Operator && graphNodeIndices[node.index] != UINT32_MAX)
+                {
+                    nodeOutputs.emplace(outputKey(graphNodeIndices[node.index], output->GetOutputIndex()), output);
+                }
+            }
+
+            std::unordered_map<uint64_t, uint32_t> graphOutputIndices;
+            for (const DML_OUTPUT_GRAPH_EDGE_DESC& edge : graph.outputEdges)
+            {
+                graphOutputIndices.emplace(outputKey(edge.FromNodeIndex, edge.FromNodeOutputIndex), edge.GraphOutputIndex);
+            }
+
+            // Each partition binds a given buffer once, however many of its edges use it
+            auto bindingKey = [](GraphPartitionBinding binding)
+            {
+                return (static_cast<uint64_t>(binding.type) << 32) | binding.index;
+            };
+            std::vector<std::unordered_map<uint64_t, uint32_t>> inputIndices(partitionCount);
+            std::vector<std::unordered_map<uint64_t, uint32_t>> outputIndices(partitionCount);
+
+            auto getPartitionInput = [&](uint32_t partitionIndex, GraphPartitionBinding binding)
+            {
+                auto inserted = inputIndices[partitionIndex].emplace(
+                    bindingKey(binding),
+                    static_cast<uint32_t>(plan.partitions[partitionIndex].inputs.size()));
+                if (inserted.second)
+                {
+                    plan.partitions[partitionIndex].inputs.push_back(binding);
+                }
+                return inserted.first->second;
+            };
+
+            auto addPartitionOutput = [&](uint32_t fromNode, uint32_t fromOutputIndex, GraphPartitionBinding binding)
+            {
+                const uint32_t partitionIndex = nodePartitions[fromNode];
+                auto inserted = outputIndices[partitionIndex].emplace(
+                    bindingKey(binding),
+                    static_cast<uint32_t>(plan.partitions[partitionIndex].outputs.size()));
+                if (inserted.second)
+                {
+                    plan.partitions[partitionIndex].outputs.push_back(binding);
+
+                    DML_OUTPUT_GRAPH_EDGE_DESC edge = {};
+                    edge.FromNodeIndex = localNodeIndices[fromNode];
+                    edge.FromNodeOutputIndex = fromOutputIndex;
+                    edge.GraphOutputIndex = inserted.first->second;
+                    descs[partitionIndex].outputEdges.push_back(edge);
+                }
+            };
+
+            for (const DML_INPUT_GRAPH_EDGE_DESC& edge : graph.inputEdges)
+            {
+                const uint32_t partitionIndex = nodePartitions[edge.ToNodeIndex];
+
+                DML_INPUT_GRAPH_EDGE_DESC localEdge = edge;
+                localEdge.GraphInputIndex = getPartitionInput(
+                    partitionIndex,
+                    GraphPartitionBinding{ GraphPartitionBindingType::GraphInput, edge.GraphInputIndex });
+                localEdge.ToNodeIndex = localNodeIndices[edge.ToNodeIndex];
+                descs[partitionIndex].inputEdges.push_back(localEdge);
+            }
+
+            for (const DML_OUTPUT_GRAPH_EDGE_DESC& edge : graph.outputEdges)
+            {
+                addPartitionOutput(
+                    edge.FromNodeIndex,
+                    edge.FromNodeOutputIndex,
+                    GraphPartitionBinding{ GraphPartitionBindingType::GraphOutput, edge.GraphOutputIndex });
+            }
+
+            // Edges between partitions become an output of the producing partition and an input of the consuming one.
+            // Graph outputs are read back from the graph output buffer; anything else gets a boundary tensor.
+            std::unordered_map<uint64_t, uint32_t> boundaryTensorIndices;
+            for (const DML_INTERMEDIATE_GRAPH_EDGE_DESC& edge : graph.intermediateEdges)
+            {
+                const uint32_t fromPartition = nodePartitions[edge.FromNodeIndex];
+                const uint32_t toPartition = nodePartitions[edge.ToNodeIndex];
+                if (fromPartition == toPartition)
+                {
+                    DML_INTERMEDIATE_GRAPH_EDGE_DESC localEdge = edge;
+                    localEdge.FromNodeIndex = localNodeIndices[edge.FromNodeIndex];
+                    localEdge.ToNodeIndex = localNodeIndices[edge.ToNodeIndex];
+                    descs[toPartition].intermediateEdges.push_back(localEdge);
+                    continue;
+                }
+
+                const uint64_t key = outputKey(edge.FromNodeIndex, edge.FromNodeOutputIndex);
+                GraphPartitionBinding binding = {};
+                auto graphOutput = graphOutputIndices.find(key);
+                if (graphOutput != graphOutputIndices.end())
+                {
+                    binding = { GraphPartitionBindingType::GraphOutput, graphOutput->second };
+                }
+                else
+                {
+                    auto inserted = boundaryTensorIndices.emplace(key, static_cast<uint32_t>(plan.boundaryTensors.size()));
+                    if (inserted.second)
+                    {
+                        GraphBoundaryTensor tensor = {};
+                        tensor.desc = nodeOutputs.at(key)->GetOutputDesc();
+                        tensor.producerPartition = fromPartition;
+                        tensor.lastConsumerPartition = toPartition;
+                        plan.boundaryTensors.push_back(std::move(tensor));
+
+                        addPartitionOutput(
+                            edge.FromNodeIndex,
+                            edge.FromNodeOutputIndex,
+                            GraphPartitionBinding{ GraphPartitionBindingType::BoundaryTensor, inserted.first->second });
+                    }
+
+                    GraphBoundaryTensor& tensor = plan.boundaryTensors[inserted.first->second];
+                    tensor.lastConsumerPartition = std::max(tensor.lastConsumerPartition, toPartition);
+                    binding = { GraphPartitionBindingType::BoundaryTensor, inserted.first->second };
+                }
+
+                DML_INPUT_GRAPH_EDGE_DESC inputEdge = {};
+                inputEdge.GraphInputIndex = getPartitionInput(toPartition, binding);
+                inputEdge.ToNodeIndex = localNodeIndices[edge.ToNodeIndex];
+                inputEdge.ToNodeInputIndex = edge.ToNodeInputIndex;
+                descs[toPartition].inputEdges.push_back(inputEdge);
+            }
+
+            for (uint32_t i = 0; i < partitionCount; ++i)
+            {
+                descs[i].inputCount = static_cast<uint32_t>(plan.partitions[i].inputs.size());
+                descs[i].outputCount = static_cast<uint32_t>(plan.partitions[i].outputs.size());
+            }
+
+            return descs;
+        }
+
+        inline GraphCost GraphBuilder::EstimateCost(const GraphDesc& graph) const
+        {
+            GraphCost cost;
+            cost.operators.resize(graph.nodes.size());
+            for (size_t i = 0; i < graph.nodes.size(); ++i)
+            {
+                OperatorCost& operatorCost = cost.operators[i];
+                operatorCost.nodeIndex = GetSourceNodeIndex(graph.nodes[i]);
+                operatorCost.name = GetNodeName(graph.nodes[i]);
+
+                const OperatorNode& node = m_operatorNodes[graph.nodes[i]];
+                if (node.desc.IsValid())
+                {
+                    operatorCost.operatorType = node.desc.Get()->Type;
+                    EstimateOperatorCost(*node.desc.Get(), operatorCost);
+                }
+                cost.total += operatorCost;
+            }
+            return cost;
+        }
+
+        // Collects the tensors of each node in a graph desc. Operators created directly on the device have none.
+        inline std::vector<OperatorDescTensors> GetGraphTensors(const GraphBuilder& builder, const GraphDesc& graph)
+        {
+            std::vector<OperatorDescTensors> tensors(graph.nodes.size());
+            for (size_t i = 0; i < graph.nodes.size(); ++i)
+            {
+                if (const DML_OPERATOR_DESC* desc = builder.GetOperatorDesc(graph.nodes[i]))
+                {
+                    tensors[i] = OperatorDescTensors::Get(*desc);
+                }
+            }
+            return tensors;
+        }
+
+        inline const DML_TENSOR_DESC* GetListedTensor(const std::vector<DML_TENSOR_DESC*>& tensors, uint32_t index)
+        {
+            return index < tensors.size() ? tensors[index] : nullptr;
+        }
+
+        inline std::string GraphBuilder::FormatGraphDot(const GraphDesc& graph) const
+        {
+            const std::vector<OperatorDescTensors> tensors = GetGraphTensors(*this, graph);
+
+            auto formatTensor = [](const DML_TENSOR_DESC* tensor) -> std::string
+            {
+                if (!tensor)
+                {
+                    return "";
+                }
+                const auto& bufferDesc = *static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc);
+                return std::string(" [label=\"") + GetDataTypeName(bufferDesc.DataType) + " " +
+                    FormatSizes(Span<const uint32_t>(bufferDesc.Sizes, bufferDesc.DimensionCount)) + "\\n" +
+                    std::to_string(bufferDesc.TotalTensorSizeInBytes) + " bytes\"]";
+            };
+
+            auto nodeID = [&](uint32_t graphNodeIndex) { return "node" + std::to_string(graph.nodes[graphNodeIndex]); };
+
+            std::string text = "digraph dml {\n    node [shape=box];\n";
+            for (uint32_t i = 0; i < graph.inputCount; ++i)
+            {
+                text += "    input" + std::to_string(i) + " [shape=ellipse, label=\"input " + std::to_string(i) +
+                    (GetConstantInputData(i) ? " (constant)" : "") + "\"];\n";
+            }
+
+            for (uint32_t i = 0; i < static_cast<uint32_t>(graph.nodes.size()); ++i)
+            {
+                const uint32_t nodeIndex = graph.nodes[i];
+                const DML_OPERATOR_DESC* desc = GetOperatorDesc(nodeIndex);
+                const char* name = GetNodeName(nodeIndex);
+
+                const uint32_t sourceIndex = GetSourceNodeIndex(nodeIndex);
+                text += "    " + nodeID(i) + " [label=\"" +
+                    (sourceIndex != UINT32_MAX ? "node " + std::to_string(sourceIndex) : std::string("added node")) + ": " +
+                    GetOperatorTypeName(desc ? desc->Type : DML_OPERATOR_INVALID);
+                if (*name)
+                {
+                    text += "\\n" + EscapeDotString(name);
+                }
+                text += "\"];\n";
+            }
+
+            for (uint32_t i = 0; i < graph.outputCount; ++i)
+            {
+                text += "    output" + std::to_string(i) + " [shape=ellipse, label=\"output " + std::to_string(i) + "\"];\n";
+            }
+
+            for (const DML_INPUT_GRAPH_EDGE_DESC& edge : graph.inputEdges)
+            {
+                text += "    input" + std::to_string(edge.GraphInputIndex) + " -> " + nodeID(edge.ToNodeIndex) +
+                    formatTensor(GetListedTensor(tensors[edge.ToNodeIndex].inputTensors, edge.ToNodeInputIndex)) + ";\n";
+            }
+
+            for (const DML_INTERMEDIATE_GRAPH_EDGE_DESC& edge : graph.intermediateEdges)
+            {
+                text += "    " + nodeID(edge.FromNodeIndex) + " -> " + nodeID(edge.ToNodeIndex) +
+                    formatTensor(GetListedTensor(tensors[edge.ToNodeIndex].inputTensors, edge.ToNodeInputIndex)) + ";\n";
+            }
+
+            for (const DML_OUTPUT_GRAPH_EDGE_DESC& edge : graph.outputEdges)
+            {
+                text += "    " + nodeID(edge.FromNodeIndex) + " -> output" + std::to_string(edge.GraphOutputIndex) +
+                    formatTensor(GetListedTensor(tensors[edge.FromNodeIndex].outputTensors, edge.FromNodeOutputIndex)) + ";\n";
+            }
+
+            return text + "}\n";
+        }
+
+        inline std::string GraphBuilder::FormatGraphJson(const GraphDesc& graph) const
+        {
+            const std::vector<OperatorDescTensors> tensors = GetGraphTensors(*this, graph);
+
+            auto formatTensor = [](const DML_TENSOR_DESC* tensor) -> std::string
+            {
+                if (!tensor)
+                {
+                    return "null";
+                }
+                const auto& bufferDesc = *static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc);
+                return std::string("{\"dataType\":\"") + GetDataTypeName(bufferDesc.DataType) + "\",\"sizes\":" +
+                    FormatSizes(Span<const uint32_t>(bufferDesc.Sizes, bufferDesc.DimensionCount)) +
+                    ",\"sizeInBytes\":" + std::to_string(bufferDesc.TotalTensorSizeInBytes) + "}";
+            };
+
+            auto nodeID = [&](uint32_t graphNodeIndex) { return "\"node" + std::to_string(graph.nodes[graphNodeIndex]) + "\""; };
+
+            std::string text = "{\"inputs\":[";
+            for (uint32_t i = 0; i < graph.inputCount; ++i)
+            {
+                text += std::string(i > 0 ? "," : "") + "{\"id\":\"input" + std::to_string(i) + "\",\"index\":" +
+                    std::to_string(i) + ",\"constant\":" + (GetConstantInputData(i) ? "true" : "false") + "}";
+            }
+
+            text += "],\"nodes\":[";
+            for (uint32_t i = 0; i < static_cast<uint32_t>(graph.nodes.size()); ++i)
+            {
+                const uint32_t nodeIndex = graph.nodes[i];
+                const DML_OPERATOR_DESC* desc = GetOperatorDesc(nodeIndex);
+
+                const uint32_t sourceIndex = GetSourceNodeIndex(nodeIndex);
+                text += std::string(i > 0 ? "," : "") + "{\"id\":" + nodeID(i) + ",\"node\":" +
+                    (sourceIndex != UINT32_MAX ? std::to_string(sourceIndex) : std::string("null")) +
+                    ",\"type\":\"" + GetOperatorTypeName(desc ? desc->Type : DML_OPERATOR_INVALID) + "\",\"name\":" +
+                    QuoteJsonString(GetNodeName(nodeIndex)) + ",\"outputs\":[";
+                for (size_t j = 0; j < tensors[i].outputTensors.size(); ++j)
+                {
+                    text += std::string(j > 0 ? "," : "") + formatTensor(tensors[i].outputTensors[j]);
+                }
+                text += "]}";
+            }
+
+            text += "],\"outputs\":[";
+            for (uint32_t i = 0; i < graph.outputCount; ++i)
+            {
+                text += std::string(i > 0 ? "," : "") + "{\"id\":\"output" + std::to_string(i) + "\",\"index\":" +
+                    std::to_string(i) + "}";
+            }
+
+            text += "],\"edges\":[";
+            const char* separator = "";
+            for (const DML_INPUT_GRAPH_EDGE_DESC& edge : graph.inputEdges)
+            {
+                text += std::string(separator) + "{\"from\":\"input" + std::to_string(edge.GraphInputIndex) +
+                    "\",\"to\":" + nodeID(edge.ToNodeIndex) + ",\"toInput\":" + std::to_string(edge.ToNodeInputIndex) +
+                    ",\"tensor\":" + formatTensor(GetListedTensor(tensors[edge.ToNodeIndex].inputTensors, edge.ToNodeInputIndex)) + "}";
+                separator = ",";
+            }
+
+            for (const DML_INTERMEDIATE_GRAPH_EDGE_DESC& edge : graph.intermediateEdges)
+            {
+                text += std::string(separator) + "{\"from\":" + nodeID(edge.FromNodeIndex) + ",\"fromOutput\":" +
+                    std::to_string(edge.FromNodeOutputIndex) + ",\"to\":" + nodeID(edge.ToNodeIndex) + ",\"toInput\":" +
+                    std::to_string(edge.ToNodeInputIndex) + ",\"tensor\":" +
+                    formatTensor(GetListedTensor(tensors[edge.ToNodeIndex].inputTensors, edge.ToNodeInputIndex)) + "}";
+                separator = ",";
+            }
+
+            for (const DML_OUTPUT_GRAPH_EDGE_DESC& edge : graph.outputEdges)
+            {
+                text += std::string(separator) + "{\"from\":" + nodeID(edge.FromNodeIndex) + ",\"fromOutput\":" +
+                    std::to_string(edge.FromNodeOutputIndex) + ",\"to\":\"output" + std::to_string(edge.GraphOutputIndex) +
+                    "\",\"tensor\":" +
+                    formatTensor(GetListedTensor(tensors[edge.FromNodeIndex].outputTensors, edge.FromNodeOutputIndex)) + "}";
+                separator = ",";
+            }
+
+            return text + "]}";
+        }
+
+        inline GraphArenaStatistics GraphBuilder::GetArenaStatistics() const
+        {
+            GraphArenaStatistics statistics;
+            statistics.usedBytes = m_arena.GetUsedSize();
+            statistics.highWaterMarkBytes = m_arena.GetHighWaterMark();
+            statistics.capacityBytes = m_arena.GetCapacity();
+            return statistics;
+        }
+
+        inline GraphDesc GraphBuilder::GetGraphDesc(Span<const Expression> outputs) const
+        {
+            GraphDesc desc = {};
+            desc.inputCount = static_cast<uint32_t>(m_inputNodes.size());
+            desc.outputCount = static_cast<uint32_t>(outputs.size());
+
+            // Only operator nodes reachable from the requested outputs are emitted. Nodes are created in topological
+            // order, so numbering the reachable nodes in creation order keeps the graph topologically sorted.
+            const std::vector<bool> reachable = FindReachableOperatorNodes(outputs);
+            constexpr uint32_t unreachable = UINT32_MAX;
+            std::vector<uint32_t> newNodeIndices(m_operatorNodes.size(), unreachable);
+
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_operatorNodes.size()); ++i)
+            {
+                if (reachable[i])
+                {
+                    newNodeIndices[i] = static_cast<uint32_t>(desc.nodes.size());
+                    desc.nodes.push_back(i);
+                }
+            }
+
+            desc.prunedNodeCount = static_cast<uint32_t>(m_operatorNodes.size() - desc.nodes.size());
+
+            for (uint32_t nodeIndex = 0; nodeIndex < static_cast<uint32_t>(desc.nodes.size()); ++nodeIndex)
+            {
+                const OperatorNode& node = m_operatorNodes[desc.nodes[nodeIndex]];
+
+                // Walk through each of this node's inputs and add it as an edge
+                const uint32_t inputCount = static_cast<uint32_t>(node.inputs.size());
+                for (uint32_t inputIndex = 0; inputIndex < inputCount; ++inputIndex)
+                {
+                    NodeOutput* input = node.inputs[inputIndex];
+                    if (input == nullptr)
+                    {
+                        continue;
+                    }
+
+                    // Reinterpret nodes aren't "real" nodes, they're just used to modify TensorDescs across
+                    // edges. So we use the real node the reinterpret chain starts from.
+                    input = ResolveReinterprets(input);
+                    NodeID inputNode = input->GetNode();
+
+                    if (inputNode.type == NodeType::Input)
+                    {
+                        DML_INPUT_GRAPH_EDGE_DESC inputEdge = {};
+                        inputEdge.GraphInputIndex = m_inputNodes[inputNode.index].inputIndex;
+                        inputEdge.ToNodeIndex = nodeIndex;
+                        inputEdge.ToNodeInputIndex = inputIndex;
+
+                        desc.inputEdges.push_back(inputEdge);
+                    }
+                    else if (inputNode.type == NodeType::Operator)
+                    {
+                        DML_INTERMEDIATE_GRAPH_EDGE_DESC intermediateEdge = {};
+                        intermediateEdge.FromNodeIndex = newNodeIndices[inputNode.index];
+                        intermediateEdge.FromNodeOutputIndex = input->GetOutputIndex();
+                        intermediateEdge.ToNodeIndex = nodeIndex;
+                        intermediateEdge.ToNodeInputIndex = inputIndex;
+
+                        desc.intermediateEdges.push_back(intermediateEdge);
+                    }
+                    else
+                    {
+                        assert(false); // Invalid node type
+                        DMLX_THROW(E_UNEXPECTED);
+                    }
+                }
+            }
+
+            // Add output edges
+            for (uint32_t outputIndex = 0; outputIndex < desc.outputCount; ++outputIndex)
+            {
+                NodeOutput* output = outputs[outputIndex].Impl();
+                if (output == nullptr)
+                {
+                    continue;
+                }
+
+                // Reinterpret nodes are meaningless on outputs (they're no-ops), so just use the real operator node
+                // they start from.
+                output = ResolveReinterprets(output);
+                NodeID outputNode = output->GetNode();
+
+                if (outputNode.type == NodeType::Input)
+                {
+                    // It's not valid to connect an output of the graph directly to an input without an intervening
+                    // node. If this behavior is desired, it should instead be accomplished with a copy e.g. using
+                    // the elementwise identity operator.
+                    DMLX_THROW(E_INVALIDARG);
+                }
+
+                assert(outputNode.type == NodeType::Operator);
+
+                DML_OUTPUT_GRAPH_EDGE_DESC outputEdge = {};
+                outputEdge.FromNodeIndex = newNodeIndices[outputNode.index];
+                outputEdge.FromNodeOutputIndex = output->GetOutputIndex();
+                outputEdge.GraphOutputIndex = outputIndex;
+
+                desc.outputEdges.push_back(outputEdge);
+            }
+
+            // Sanity
+            assert(desc.nodes.size() + desc.prunedNodeCount == m_operatorNodes.size());
+            assert(desc.outputEdges.size() == desc.outputCount);
+            assert(desc.outputCount == outputs.size());
+
+            return desc;
+        }
+
+        inline IDMLOperator* GraphBuilder::GetOrCreateOperator(uint32_t operatorNodeIndex)
+        {
+            OperatorNode& node = m_operatorNodes[operatorNodeIndex];
+            if (!node.op)
+            {
+                assert(node.desc.IsValid());
+                if (!m_device)
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
+
+                std::string key;
+                OperatorDescEncoder(key).WriteOperator(*node.desc.Get());
+                size_t& use = m_operatorCacheUses[key];
+
+                std::lock_guard<std::mutex> lock(m_operatorCache->mutex);
+                std::vector<Microsoft::WRL::ComPtr<IDMLOperator>>& operators = m_operatorCache->operators[key];
+                if (use == operators.size())
+                {
+                    Microsoft::WRL::ComPtr<IDMLOperator> op;
+                    DMLX_THROW_IF_FAILED(m_device->CreateOperator(node.desc.Get(), IID_PPV_ARGS(&op)));
+                    operators.push_back(std::move(op));
+                }
+                node.op = operators[use++];
+            }
+
+            return node.op.Get();
+        }
+
+        // Serialized graph layout. All values are in native byte order and unaligned.
+        //
+        //   header:               magic, version, and the counts of input nodes, constant inputs, operator nodes,
+        //                         reinterpret nodes, node outputs and graph outputs (uint32 each)
+        //   input nodes:          graph input index
+        //   constant inputs:      graph input index, uint64 size in bytes, data
+        //   operator nodes:       operator desc (OperatorDescEncoder), input count, node output ID per input, name
+        //                         length and characters (zero length for unnamed nodes)
+        //   reinterpret nodes:    node output ID of the input, view flag (uint32)
+        //   node outputs:         node type, node index, output index, tensor desc (OperatorDescEncoder)
+        //   graph outputs:        node output ID
+        //
+        // Node output IDs are positions in the list of node outputs; InvalidSerializedID represents a null input.
+        constexpr char SerializedGraphMagic[8] = { 'D', 'M', 'L', 'X', 'G', 'R', 'P', 'H' };
+        constexpr uint32_t SerializedGraphVersion = 4;
+        constexpr uint32_t InvalidSerializedID = UINT32_MAX;
+
+        inline std::vector<uint8_t> GraphBuilder::Serialize(Span<const Expression> outputs) const
+        {
+            std::unordered_map<const NodeOutput*, uint32_t> nodeOutputIDs;
+            nodeOutputIDs.reserve(m_nodeOutputs.size());
+            for (const NodeOutput* output : m_nodeOutputs)
+            {
+                nodeOutputIDs.emplace(output, static_cast<uint32_t>(nodeOutputIDs.size()));
+            }
+
+            auto getID = [&](const NodeOutput* output)
+            {
+                return output ? nodeOutputIDs.at(output) : InvalidSerializedID;
+            };
+
+            std::string bytes;
+            OperatorDescEncoder writer(bytes);
+
+            writer.Write(SerializedGraphMagic, sizeof(SerializedGraphMagic));
+            writer.WriteValue(SerializedGraphVersion);
+            writer.WriteValue(static_cast<uint32_t>(m_inputNodes.size()));
+            writer.WriteValue(static_cast<uint32_t>(m_constantInputData.size()));
+            writer.WriteValue(static_cast<uint32_t>(m_operatorNodes.size()));
+            writer.WriteValue(static_cast<uint32_t>(m_reinterpretNodes.size()));
+            writer.WriteValue(static_cast<uint32_t>(m_nodeOutputs.size()));
+            writer.WriteValue(static_cast<uint32_t>(outputs.size()));
+
+            for (const InputNode& node : m_inputNodes)
+            {
+                writer.WriteValue(node.inputIndex);
+            }
+
+            // Constants are written in input index order so that equal graphs serialize identically
+            std::vector<uint32_t> constantInputIndices;
+            for (const auto& constant : m_constantInputData)
+            {
+                constantInputIndices.push_back(constant.first);
+            }
+            std::sort(constantInputIndices.begin(), constantInputIndices.end());
+
+            for (uint32_t inputIndex : constantInputIndices)
+            {
+                const std::vector<uint8_t>& data = *m_constantInputData.at(inputIndex);
+                writer.WriteValue(inputIndex);
+                writer.WriteValue(static_cast<uint64_t>(data.size()));
+                writer.Write(data.data(), data.size());
+            }
+
+            for (const OperatorNode& node : m_operatorNodes)
+            {
+                // Operators without a schema only exist as IDMLOperators and can't be serialized
+                if (!node.desc.IsValid())
+                {
+                    DMLX_THROW(E_NOTIMPL);
+                }
+
+                writer.WriteOperator(*node.desc.Get());
+                writer.WriteValue(static_cast<uint32_t>(node.inputs.size()));
+                for (const NodeOutput* input : node.inputs)
+                {
+                    writer.WriteValue(getID(input));
+                }
+
+                const uint32_t nameLength = node.name ? static_cast<uint32_t>(strlen(node.name)) : 0;
+                writer.WriteValue(nameLength);
+                if (nameLength > 0)
+                {
+                    writer.Write(node.name, nameLength);
+                }
+            }
+
+            for (const ReinterpretNode& node : m_reinterpretNodes)
+            {
+                writer.WriteValue(getID(node.input));
+                writer.WriteValue(static_cast<uint32_t>(node.isView));
+            }
+
+            for (const NodeOutput* output : m_nodeOutputs)
+            {
+                TensorDesc tensorDesc = output->GetOutputDesc();
+                writer.WriteValue(static_cast<uint32_t>(output->GetNode().type));
+                writer.WriteValue(output->GetNode().index);
+                writer.WriteValue(output->GetOutputIndex());
+                writer.WriteTensor(tensorDesc.AsPtr<DML_TENSOR_DESC>());
+            }
+
+            for (const Expression& output : outputs)
+            {
+                writer.WriteValue(getID(output.Impl()));
+            }
+
+            return std::vector<uint8_t>(bytes.begin(), bytes.end());
+        }
+
+        inline uint64_t GraphBuilder::ComputeFingerprint(const GraphDesc& graph, DML_EXECUTION_FLAGS flags) const
+        {
+            const std::string bytes = EncodeGraphDesc(graph, flags);
+            return HashBytes(bytes.data(), bytes.size());
+        }
+
+        inline std::string GraphBuilder::EncodeGraphDesc(const GraphDesc& graph, DML_EXECUTION_FLAGS flags) const
+        {
+            std::string bytes;
+            OperatorDescEncoder writer(bytes);
+
+            writer.WriteValue(SerializedGraphVersion);
+#ifdef DML_TARGET_VERSION
+            writer.WriteValue(static_cast<uint32_t>(DML_TARGET_VERSION));
+#endif
+            writer.WriteValue(flags);
+            writer.WriteValue(graph.inputCount);
+            writer.WriteValue(graph.outputCount);
+
+            writer.WriteValue(static_cast<uint32_t>(graph.nodes.size()));
+            for (uint32_t nodeIndex : graph.nodes)
+            {
+                const OperatorNode& node = m_operatorNodes[nodeIndex];
+                if (node.desc.IsValid())
+                {
+                    writer.WriteOperator(*node.desc.Get());
+                }
+                else
+                {
+                    // Operators without a schema can only be identified by the object itself, which is only stable
+                    // within this process.
+                    writer.WriteValue(DML_OPERATOR_INVALID);
+                    writer.WriteValue(node.op.Get());
+                }
+            }
+
+            // Edge descs are plain structs of indices
+            writer.WriteValue(static_cast<uint32_t>(graph.inputEdges.size()));
+            for (const DML_INPUT_GRAPH_EDGE_DESC& edge : graph.inputEdges)
+            {
+                writer.WriteValue(edge.GraphInputIndex);
+                writer.WriteValue(edge.ToNodeIndex);
+                writer.WriteValue(edge.ToNodeInputIndex);
+            }
+
+            writer.WriteValue(static_cast<uint32_t>(graph.outputEdges.size()));
+            for (const DML_OUTPUT_GRAPH_EDGE_DESC& edge : graph.outputEdges)
+            {
+                writer.WriteValue(edge.FromNodeIndex);
+                writer.WriteValue(edge.FromNodeOutputIndex);
+                writer.WriteValue(edge.GraphOutputIndex);
+            }
+
+            writer.WriteValue(static_cast<uint32_t>(graph.intermediateEdges.size()));
+            for (const DML_INTERMEDIATE_GRAPH_EDGE_DESC& edge : graph.intermediateEdges)
+            {
+                writer.WriteValue(edge.FromNodeIndex);
+                writer.WriteValue(edge.FromNodeOutputIndex);
+                writer.WriteValue(edge.ToNodeIndex);
+                writer.WriteValue(edge.ToNodeInputIndex);
+            }
+
+            return bytes;
+        }
+
+        inline std::vector<NodeOutput*> GraphBuilder::Deserialize(Span<const uint8_t> data)
+        {
+            // Node indices are only meaningful in an empty builder
+            if (!m_inputNodes.empty() || !m_operatorNodes.empty() || !m_reinterpretNodes.empty() || !m_nodeOutputs.empty())
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            BinaryReader reader(data.data(), data.data() + data.size());
+
+            char magic[sizeof(SerializedGraphMagic)];
+            reader.Read(magic, sizeof(magic));
+            if (memcmp(magic, SerializedGraphMagic, sizeof(magic)) != 0 ||
+                reader.ReadValue<uint32_t>() != SerializedGraphVersion)
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            const uint32_t inputNodeCount = reader.ReadValue<uint32_t>();
+            const uint32_t constantCount = reader.ReadValue<uint32_t>();
+            const uint32_t operatorNodeCount = reader.ReadValue<uint32_t>();
+            const uint32_t reinterpretNodeCount = reader.ReadValue<uint32_t>();
+            const uint32_t nodeOutputCount = reader.ReadValue<uint32_t>();
+            const uint32_t outputCount = reader.ReadValue<uint32_t>();
+
+            // Every record takes at least 4 bytes, which bounds the counts before anything is reserved
+            const uint64_t minimumSize = 4ull * inputNodeCount + 12ull * constantCount + 12ull * operatorNodeCount +
+                8ull * reinterpretNodeCount + 12ull * nodeOutputCount + 4ull * outputCount;
+            if (minimumSize > reader.GetRemainingSize())
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            m_inputNodes.reserve(inputNodeCount);
+            for (uint32_t i = 0; i < inputNodeCount; ++i)
+            {
+                m_inputNodes.push_back(InputNode{ reader.ReadValue<uint32_t>() });
+            }
+
+            for (uint32_t i = 0; i < constantCount; ++i)
+            {
+                const uint32_t inputIndex = reader.ReadValue<uint32_t>();
+                const uint64_t size = reader.ReadValue<uint64_t>();
+                const uint8_t* bytes = reader.ReadBytes(size);
+                SetConstantInputData(inputIndex, std::vector<uint8_t>(bytes, bytes + size));
+            }
+
+            // Inputs are recorded as node output IDs until all node outputs exist
+            std::vector<uint32_t> operatorInputIDs;
+            m_operatorNodes.resize(operatorNodeCount);
+            for (OperatorNode& node : m_operatorNodes)
+            {
+                node.desc = OwnedOperatorDesc(&m_arena);
+                OperatorDescDecoder decoder(reader, node.desc);
+                node.desc.SetDesc(decoder.ReadOperator());
+
+                const uint32_t inputCount = reader.ReadValue<uint32_t>();
+                if (inputCount > reader.GetRemainingSize() / sizeof(uint32_t))
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
+
+                node.inputs = AllocateInputs(inputCount);
+                for (uint32_t i = 0; i < inputCount; ++i)
+                {
+                    operatorInputIDs.push_back(reader.ReadValue<uint32_t>());
+                }
+
+                const uint32_t nameLength = reader.ReadValue<uint32_t>();
+                if (nameLength > 0)
+                {
+                    const char* name = reinterpret_cast<const char*>(reader.ReadBytes(nameLength));
+                    node.name = CopyName(std::string(name, nameLength));
+                }
+            }
+
+            std::vector<uint32_t> reinterpretInputIDs(reinterpretNodeCount);
+            m_reinterpretNodes.resize(reinterpretNodeCount);
+            for (uint32_t i = 0; i < reinterpretNodeCount; ++i)
+            {
+                reinterpretInputIDs[i] = reader.ReadValue<uint32_t>();
+                m_reinterpretNodes[i].isView = reader.ReadValue<uint32_t>() != 0;
+            }
+
+            for (uint32_t i = 0; i < nodeOutputCount; ++i)
+            {
+                NodeID node = {};
+                node.type = static_cast<NodeType>(reader.ReadValue<uint32_t>());
+                node.index = reader.ReadValue<uint32_t>();
+                const uint32_t outputIndex = reader.ReadValue<uint32_t>();
+
+                const bool validNode =
+                    (node.type == NodeType::Input && node.index < inputNodeCount) ||
+                    (node.type == NodeType::Operator && node.index < operatorNodeCount) ||
+                    (node.type == NodeType::Reinterpret && node.index < reinterpretNodeCount);
+
+                if (!validNode || !reader.ReadFlag())
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
+
+                TensorDesc tensorDesc;
+                tensorDesc.dataType = reader.ReadValue<DML_TENSOR_DATA_TYPE>();
+                tensorDesc.flags = reader.ReadValue<DML_TENSOR_FLAGS>();
+                const uint32_t dimensionCount = reader.ReadValue<uint32_t>();
+                const uint8_t* sizes = reader.ReadBytes(uint64_t(dimensionCount) * sizeof(uint32_t));
+                tensorDesc.sizes.resize(dimensionCount);
+                memcpy(tensorDesc.sizes.data(), sizes, dimensionCount * sizeof(uint32_t));
+                if (reader.ReadFlag())
+                {
+                    const uint8_t* strides = reader.ReadBytes(uint64_t(dimensionCount) * sizeof(uint32_t));
+                    tensorDesc.strides.emplace(dimensionCount);
+                    memcpy(tensorDesc.strides->data(), strides, dimensionCount * sizeof(uint32_t));
+                }
+                tensorDesc.totalTensorSizeInBytes = reader.ReadValue<uint64_t>();
+                tensorDesc.guaranteedBaseOffsetAlignment = reader.ReadValue<uint32_t>();
+
+                ConstructNodeOutput(node, outputIndex, std::move(tensorDesc));
+            }
+
+            const std::vector<NodeOutput*>& nodeOutputs = m_nodeOutputs;
+
+            auto getNodeOutput = [&](uint32_t id) -> NodeOutput*
+            {
+                if (id == InvalidSerializedID)
+                {
+                    return nullptr;
+                }
+                if (id >= nodeOutputs.size())
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
+                return nodeOutputs[id];
+            };
+
+            size_t operatorInputID = 0;
+            for (OperatorNode& node : m_operatorNodes)
+            {
+                for (NodeOutput*& input : node.inputs)
+                {
+                    input = getNodeOutput(operatorInputIDs[operatorInputID++]);
+                }
+            }
+
+            // Reinterpret nodes only ever refer to earlier nodes, so roots can be resolved in order
+            for (uint32_t i = 0; i < reinterpretNodeCount; ++i)
+            {
+                NodeOutput* input = getNodeOutput(reinterpretInputIDs[i]);
+                NodeID inputNode = input ? input->GetNode() : NodeID{};
+                if (!input || (inputNode.type == NodeType::Reinterpret && inputNode.index >= i))
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
+
+                // As in CreateReinterpretNode; data written before reinterprets inherited the flag lacks it
+                m_reinterpretNodes[i].input = input;
+                m_reinterpretNodes[i].root = ResolveReinterprets(input);
+                m_reinterpretNodes[i].isView = m_reinterpretNodes[i].isView || IsView(input);
+            }
+
+            std::vector<NodeOutput*> outputs(outputCount);
+            for (NodeOutput*& output : outputs)
+            {
+                output = getNodeOutput(reader.ReadValue<uint32_t>());
+            }
+
+            return outputs;
+        }
+
+        inline NodeOutput* GraphBuilder::ResolveReinterprets(NodeOutput* output) const
+        {
+            NodeID node = output->GetNode();
+            return node.type == NodeType::Reinterpret ? m_reinterpretNodes[node.index].root : output;
+        }
+
+        inline bool GraphBuilder::IsView(const NodeOutput* output) const
+        {
+            // Reinterprets inherit the flag from their input when created, so only the output's own node is checked
+            NodeID node = output->GetNode();
+            return node.type == NodeType::Reinterpret && m_reinterpretNodes[node.index].isView;
+        }
+
+        inline std::vector<bool> GraphBuilder::FindReachableOperatorNodes(Span<const Expression> outputs) const
+        {
+            std::vector<bool> reachable(m_operatorNodes.size(), false);
+            std::vector<uint32_t> worklist;
+
+            auto markReachable = [&](NodeOutput* output)
+            {
+                if (output == nullptr)
+                {
+                    return;
+                }
+
+                NodeID node = ResolveReinterprets(output)->GetNode();
+                if (node.type == NodeType::Operator && !reachable[node.index])
+                {
+                    reachable[node.index] = true;
+                    worklist.push_back(node.index);
+                }
+            };
+
+            // Walk the graph backwards from the outputs
+            for (const Expression& output : outputs)
+            {
+                markReachable(output.Impl());
+            }
+
+            while (!worklist.empty())
+            {
+                uint32_t index = worklist.back();
+                worklist.pop_back();
+
+                for (NodeOutput* input : m_operatorNodes[index].inputs)
+                {
+                    markReachable(input);
+                }
+            }
+
+            return reachable;
+        }
+
+        inline std::vector<uint32_t> GraphBuilder::CountOperatorNodeUses(
+            Span<const Expression> outputs,
+            const std::vector<bool>& reachable) const
+        {
+            std::vector<uint32_t> useCounts(m_operatorNodes.size(), 0);
+
+            auto countUse = [&](NodeOutput* output)
+            {
+                if (output == nullptr)
+                {
+                    return;
+                }
+
+                NodeID node = ResolveReinterprets(output)->GetNode();
+                if (node.type == NodeType::Operator)
+                {
+                    ++useCounts[node.index];
+                }
+            };
+
+            for (const Expression& output : outputs)
+            {
+                countUse(output.Impl());
+            }
+
+            for (size_t i = 0; i < m_operatorNodes.size(); ++i)
+            {
+                if (reachable[i])
+                {
+                    for (NodeOutput* input : m_operatorNodes[i].inputs)
+                    {
+                        countUse(input);
+                    }
+                }
+            }
+
+            return useCounts;
+        }
+
+        inline std::vector<Expression> GraphBuilder::MaterializeViews(Span<const Expression> outputs)
+        {
+            std::vector<Expression> materializedOutputs(outputs.begin(), outputs.end());
+            for (Expression& output : materializedOutputs)
+            {
+                NodeOutput* view = output.Impl();
+                if (!view || !IsView(view))
+                {
+                    continue;
+                }
+
+                NodeOutput*& copy = m_materializedViews[view];
+                if (!copy)
+                {
+                    TensorDesc inputTensor = view->GetOutputDesc();
+                    TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, m_tensorPolicy);
+
+                    DML_ELEMENT_WISE_IDENTITY_OPERATOR_DESC desc = {};
+                    desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+                    desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+                    NodeOutput* const inputs[] = { view };
+                    NodeID node = CreateOperatorNode(DML_OPERATOR_ELEMENT_WISE_IDENTITY, &desc, inputs);
+                    copy = CreateNodeOutput(node, 0, std::move(outputTensor));
+
+                    // The copy is named after the operator producing the viewed tensor
+                    NodeID root = ResolveReinterprets(view)->GetNode();
+                    if (root.type == NodeType::Operator)
+                    {
+                        m_operatorNodes[node.index].name = m_operatorNodes[root.index].name;
+                        m_operatorNodes[node.index].sourceIndex = m_operatorNodes[root.index].sourceIndex;
+                    }
+                    ++m_statistics.materializedViewCount;
+                }
+
+                output = copy;
+            }
+
+            return materializedOutputs;
+        }
+
+        inline void GraphBuilder::Optimize(Span<const Expression> outputs)
+        {
+            // Batch normalization is folded first so that an activation following it can then be fused into the
+            // convolution.
+            if ((m_optimizations & GraphOptimizations::BatchNormalizationFolding) != GraphOptimizations::None)
+            {
+                FoldBatchNormalization(outputs);
+            }
+
+            if ((m_optimizations & GraphOptimizations::ScaleBiasFolding) != GraphOptimizations::None)
+            {
+                FoldScaleBias(outputs);
+            }
+
+            if ((m_optimizations & GraphOptimizations::ActivationFusion) != GraphOptimizations::None)
+            {
+                FuseActivations(outputs);
+            }
+
+            // After folding, so that folded filters are quantized rather than the filters they replaced
+            if ((m_optimizations & GraphOptimizations::WeightQuantization) != GraphOptimizations::None)
+            {
+                QuantizeWeights(outputs);
+            }
+
+            // After quantization, so that dequantized weights are produced in FLOAT16 by their dequantize nodes
+            if ((m_optimizations & GraphOptimizations::MixedPrecision) != GraphOptimizations::None)
+            {
+                ConvertToFloat16(outputs);
+            }
+
+            // Last, so that layouts are chosen for the operators that are actually compiled
+            if ((m_optimizations & GraphOptimizations::LayoutAssignment) != GraphOptimizations::None)
+            {
+                AssignLayouts(outputs);
+            }
+        }
+
+        inline void GraphBuilder::FoldScaleBias(Span<const Expression> outputs)
+        {
+            const std::vector<bool> reachable = FindReachableOperatorNodes(outputs);
+            std::vector<uint32_t> useCounts = CountOperatorNodeUses(outputs, reachable);
+
+            // Scalar multiply/add/negate produce ELEMENT_WISE_IDENTITY nodes with a scale and bias. An identity whose
+            // only consumer is an operator that applies its own scale/bias to its single input can be bypassed by
+            // composing the two: s2 * (s1 * x + b1) + b2 == (s2 * s1) * x + (s2 * b1 + b2). Nodes are visited in
+            // topological order, so whole chains collapse into the last node.
+            for (size_t i = 0; i < m_operatorNodes.size(); ++i)
+            {
+                OperatorNode& node = m_operatorNodes[i];
+                if (!reachable[i] || !node.desc.IsValid() || node.inputs.size() != 1 || node.inputs[0] == nullptr)
+                {
+                    continue;
+                }
+
+                // Only direct edges are folded; a reinterpret in between would change how the identity's input
+                // is read.
+                NodeID producerID = node.inputs[0]->GetNode();
+                if (producerID.type != NodeType::Operator || useCounts[producerID.index] != 1)
+                {
+                    continue;
+                }
+
+                OperatorNode& producer = m_operatorNodes[producerID.index];
+                if (!producer.desc.IsValid() || producer.desc.GetType() != DML_OPERATOR_ELEMENT_WISE_IDENTITY)
+                {
+                    continue;
+                }
+
+                OperatorDescFields fields = OperatorDescFields::Get(node.desc);
+                if (fields.scaleBias == nullptr || fields.inputTensors.size() != 1 || fields.hasTensorArrays)
+                {
+                    continue;
+                }
+
+                const auto* identity = producer.desc.As<DML_ELEMENT_WISE_IDENTITY_OPERATOR_DESC>();
+                const auto* identityInput = static_cast<const DML_BUFFER_TENSOR_DESC*>(identity->InputTensor->Desc);
+                const auto* identityOutput = static_cast<const DML_BUFFER_TENSOR_DESC*>(identity->OutputTensor->Desc);
+                if (identityInput->DataType != identityOutput->DataType ||
+                    !AreTensorDescsEqual(*fields.inputTensors[0], identity->OutputTensor))
+                {
+                    continue;
+                }
+
+                const DML_SCALE_BIAS* inner = identity->ScaleBias;
+                const DML_SCALE_BIAS* outer = *fields.scaleBias;
+                if (inner || outer)
+                {
+                    DML_SCALE_BIAS innerValue = inner ? *inner : DML_SCALE_BIAS{ 1.0f, 0.0f };
+                    DML_SCALE_BIAS outerValue = outer ? *outer : DML_SCALE_BIAS{ 1.0f, 0.0f };
+
+                    DML_SCALE_BIAS* combined = node.desc.Allocate<DML_SCALE_BIAS>();
+                    combined->Scale = outerValue.Scale * innerValue.Scale;
+                    combined->Bias = outerValue.Scale * innerValue.Bias + outerValue.Bias;
+                    *fields.scaleBias = combined;
+                }
+
+                *fields.inputTensors[0] = node.desc.CopyTensor(identity->InputTensor);
+                node.inputs[0] = producer.inputs[0];
+                node.op = nullptr;
+                if (!node.name)
+                {
+                    node.name = producer.name;
+                }
+
+                useCounts[producerID.index] = 0;
+                ++m_statistics.foldedScaleBiasCount;
+            }
+        }
+
+        // Reads the elements of a FLOAT32 buffer tensor stored in host memory, in logical (row-major) order and
+        // honoring the tensor's strides. Returns false if the data is too small for the tensor.
+        inline bool ReadFloat32Tensor(const DML_TENSOR_DESC& tensor, const std::vector<uint8_t>& data, std::vector<float>& values)
+        {
+            const auto& bufferDesc = *static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor.Desc);
+            if (bufferDesc.DataType != DML_TENSOR_DATA_TYPE_FLOAT32)
+            {
+                return false;
+            }
+
+            const uint32_t dimensionCount = bufferDesc.DimensionCount;
+            std::vector<uint32_t> strides(dimensionCount);
+            uint64_t elementCount = 1;
+            for (uint32_t i = dimensionCount; i-- > 0;)
+            {
+                strides[i] = bufferDesc.Strides ? bufferDesc.Strides[i] : static_cast<uint32_t>(elementCount);
+                elementCount *= bufferDesc.Sizes[i];
+            }
+
+            values.resize(static_cast<size_t>(elementCount));
+            std::vector<uint32_t> index(dimensionCount, 0);
+            for (size_t element = 0; element < values.size(); ++element)
+            {
+                uint64_t offset = 0;
+                for (uint32_t i = 0; i < dimensionCount; ++i)
+                {
+                    offset += uint64_t(index[i]) * strides[i];
+                }
+
+                if ((offset + 1) * sizeof(float) > data.size())
+                {
+                    return false;
+                }
+                memcpy(&values[element], data.data() + offset * sizeof(float), sizeof(float));
+
+                // Advance to the next element in row-major order
+                for (uint32_t i = dimensionCount; i-- > 0;)
+                {
+                    if (++index[i] < bufferDesc.Sizes[i])
+                    {
+                        break;
+                    }
+                    index[i] = 0;
+                }
+            }
+
+            return true;
+        }
+
+        // Converts FLOAT16 bit patterns to and from single precision.
+        inline float HalfToFloat(uint16_t value)
+        {
+            const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+            const uint32_t exponent = (value >> 10) & 0x1F;
+            uint32_t mantissa = value & 0x3FF;
+
+            uint32_t bits = 0;
+            if (exponent == 0x1F)
+            {
+                bits = sign | 0x7F800000 | (mantissa << 13); // Infinity or NaN
+            }
+            else if (exponent != 0)
+            {
+                bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+            }
+            else if (mantissa != 0)
+            {
+                // Subnormal; normalize it
+                uint32_t normalizedExponent = 113;
+                while ((mantissa & 0x400) == 0)
+                {
+                    mantissa <<= 1;
+                    --normalizedExponent;
+                }
+                bits = sign | (normalizedExponent << 23) | ((mantissa & 0x3FF) << 13);
+            }
+            else
+            {
+                bits = sign;
+            }
+
+            float result;
+            memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+
+        // Rounds to the nearest representable value, ties to even.
+        inline uint16_t FloatToHalf(float value)
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+
+            const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+            const uint32_t exponent = (bits >> 23) & 0xFF;
+            uint32_t mantissa = bits & 0x7FFFFF;
+
+            if (exponent == 0xFF)
+            {
+                return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+            }
+
+            const int32_t halfExponent = static_cast<int32_t>(exponent) - 127 + 15;
+            if (halfExponent >= 0x1F)
+            {
+                return sign | 0x7C00;
+            }
+
+            if (halfExponent <= 0)
+            {
+                if (halfExponent < -10)
+                {
+                    return sign;
+                }
+
+                mantissa |= 0x800000;
+                const uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+                uint32_t half = mantissa >> shift;
+                const uint32_t remainder = mantissa & ((1u << shift) - 1);
+                const uint32_t halfway = 1u << (shift - 1);
+                if (remainder > halfway || (remainder == halfway && (half & 1)))
+                {
+                    ++half;
+                }
+                return static_cast<uint16_t>(sign | half);
+            }
+
+            // Rounding may carry into the exponent, which correctly rounds up to the next power of two (or infinity)
+            uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+            const uint32_t remainder = mantissa & 0x1FFF;
+            if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+            {
+                ++half;
+            }
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        // Returns a FLOAT16 tensor desc with the same sizes and element strides as a FLOAT32 one, so that the same
+        // elements are addressed in a buffer of half the size.
+        inline TensorDesc GetFloat16TensorDesc(const TensorDesc& tensor)
+        {
+            TensorDesc float16Tensor = tensor;
+            float16Tensor.dataType = DML_TENSOR_DATA_TYPE_FLOAT16;
+            float16Tensor.totalTensorSizeInBytes = DMLCalcBufferTensorSize(
+                DML_TENSOR_DATA_TYPE_FLOAT16,
+                static_cast<UINT>(tensor.sizes.size()),
+                tensor.sizes.data(),
+                tensor.strides ? tensor.strides->data() : nullptr);
+            return float16Tensor;
+        }
+
+        inline void GraphBuilder::FoldBatchNormalization(Span<const Expression> outputs)
+        {
+            const std::vector<bool> reachable = FindReachableOperatorNodes(outputs);
+            std::vector<uint32_t> useCounts = CountOperatorNodeUses(outputs, reachable);
+
+            // BatchNormalization(Convolution(x, W, b)) computes, per output channel c:
+            //   (conv(x, W)[c] + b[c] - mean[c]) * scale[c] / sqrt(variance[c] + epsilon) + bias[c]
+            // which is a convolution with filter W[c] * k[c] and bias (b[c] - mean[c]) * k[c] + bias[c], where
+            // k[c] = scale[c] / sqrt(variance[c] + epsilon). The normalization node is rewritten into that convolution;
+            // the folded filter and bias become new constant inputs so the original ones are left untouched.
+            for (size_t i = 0; i < m_operatorNodes.size(); ++i)
+            {
+                OperatorNode& node = m_operatorNodes[i];
+                if (!reachable[i] || !node.desc.IsValid() || node.desc.GetType() != DML_OPERATOR_BATCH_NORMALIZATION)
+                {
+                    continue;
+                }
+
+                NodeID producerID = node.inputs[0]->GetNode();
+                if (producerID.type != NodeType::Operator || useCounts[producerID.index] != 1)
+                {
+                    continue;
+                }
+
+                OperatorNode& producer = m_operatorNodes[producerID.index];
+                if (!producer.desc.IsValid() || producer.desc.GetType() != DML_OPERATOR_CONVOLUTION)
+                {
+                    continue;
+                }
+
+                const auto* batchNorm = node.desc.As<DML_BATCH_NORMALIZATION_OPERATOR_DESC>();
+                const auto* conv = producer.desc.As<DML_CONVOLUTION_OPERATOR_DESC>();
+                if (!batchNorm->Spatial ||
+                    conv->Direction != DML_CONVOLUTION_DIRECTION_FORWARD ||
+                    conv->FusedActivation != nullptr ||
+                    !AreTensorDescsEqual(batchNorm->InputTensor, conv->OutputTensor))
+                {
+                    continue;
+                }
+
+                const bool hasConvBias = producer.inputs.size() > 2 && producer.inputs[2] != nullptr;
+                const std::vector<uint8_t>* filterData = GetConstantData(producer.inputs[1]);
+                const std::vector<uint8_t>* convBiasData = hasConvBias ? GetConstantData(producer.inputs[2]) : nullptr;
+                const std::vector<uint8_t>* meanData = GetConstantData(node.inputs[1]);
+                const std::vector<uint8_t>* varianceData = GetConstantData(node.inputs[2]);
+                const std::vector<uint8_t>* scaleData = GetConstantData(node.inputs[3]);
+                const std::vector<uint8_t>* biasData = GetConstantData(node.inputs[4]);
+                if (!filterData || (hasConvBias && !convBiasData) || !meanData || !varianceData || !scaleData || !biasData)
+                {
+                    continue;
+                }
+
+                std::vector<float> filter, convBias, mean, variance, scale, bias;
+                if (!ReadFloat32Tensor(*conv->FilterTensor, *filterData, filter) ||
+                    (hasConvBias && !ReadFloat32Tensor(*conv->BiasTensor, *convBiasData, convBias)) ||
+                    !ReadFloat32Tensor(*batchNorm->MeanTensor, *meanData, mean) ||
+                    !ReadFloat32Tensor(*batchNorm->VarianceTensor, *varianceData, variance) ||
+                    !ReadFloat32Tensor(*batchNorm->ScaleTensor, *scaleData, scale) ||
+                    !ReadFloat32Tensor(*batchNorm->BiasTensor, *biasData, bias))
+                {
+                    continue;
+                }
+
+                // With spatial normalization every parameter holds one value per output channel
+                const TensorDesc filterTensor(*conv->FilterTensor);
+                const size_t channelCount = filterTensor.sizes[0];
+                if (channelCount == 0 ||
+                    (hasConvBias && convBias.size() != channelCount) ||
+                    mean.size() != channelCount ||
+                    variance.size() != channelCount ||
+                    scale.size() != channelCount ||
+                    bias.size() != channelCount)
+                {
+                    continue;
+                }
+
+                const size_t filterElementsPerChannel = filter.size() / channelCount;
+                std::vector<float> foldedBias(channelCount);
+                for (size_t c = 0; c < channelCount; ++c)
+                {
+                    const double k = scale[c] / std::sqrt(double(variance[c]) + batchNorm->Epsilon);
+                    for (size_t j = 0; j < filterElementsPerChannel; ++j)
+                    {
+                        float& weight = filter[c * filterElementsPerChannel + j];
+                        weight = static_cast<float>(weight * k);
+                    }
+
+                    const double convBiasValue = hasConvBias ? convBias[c] : 0.0;
+                    foldedBias[c] = static_cast<float>((convBiasValue - mean[c]) * k + bias[c]);
+                }
+
+                // The folded constants are packed
+                TensorDesc::Dimensions biasSizes(filterTensor.sizes.size(), 1);
+                biasSizes[1] = static_cast<uint32_t>(channelCount);
+                TensorDesc foldedFilterTensor(DML_TENSOR_DATA_TYPE_FLOAT32, filterTensor.flags, filterTensor.sizes);
+                TensorDesc foldedBiasTensor(DML_TENSOR_DATA_TYPE_FLOAT32, filterTensor.flags, std::move(biasSizes));
+
+                auto toBytes = [](const std::vector<float>& values)
+                {
+                    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values.data());
+                    return std::vector<uint8_t>(bytes, bytes + values.size() * sizeof(float));
+                };
+
+                OwnedOperatorDesc folded(producer.desc.GetType(), producer.desc.Get()->Desc, &m_arena);
+                auto* foldedConv = folded.As<DML_CONVOLUTION_OPERATOR_DESC>();
+                foldedConv->FilterTensor = folded.CopyTensor(foldedFilterTensor.AsPtr<DML_TENSOR_DESC>());
+                foldedConv->BiasTensor = folded.CopyTensor(foldedBiasTensor.AsPtr<DML_TENSOR_DESC>());
+                foldedConv->OutputTensor = folded.CopyTensor(batchNorm->OutputTensor);
+                foldedConv->FusedActivation = folded.CopyOperatorDescs(batchNorm->FusedActivation, 1);
+
+                NodeOutput* convInput = producer.inputs[0];
+                NodeOutput* foldedFilter = CreateConstantInput(std::move(foldedFilterTensor), toBytes(filter));
+                NodeOutput* foldedBiasOutput = CreateConstantInput(std::move(foldedBiasTensor), toBytes(foldedBias));
+
+                node.desc = std::move(folded);
+                NodeOutput* const foldedInputs[] = { convInput, foldedFilter, foldedBiasOutput };
+                node.inputs = AllocateInputs(foldedInputs);
+                node.op = nullptr;
+
+                // The convolution does the work, so the folded node is attributed to it if it's named
+                if (producer.name)
+                {
+                    node.name = producer.name;
+                }
+
+                useCounts[producerID.index] = 0;
+                ++m_statistics.foldedBatchNormalizationCount;
+            }
+        }
+
+        inline bool IsFusableActivation(DML_OPERATOR_TYPE type)
+        {
+            switch (type)
+            {
+            case DML_OPERATOR_ACTIVATION_ELU:
+            case DML_OPERATOR_ACTIVATION_HARD_SIGMOID:
+            case DML_OPERATOR_ACTIVATION_IDENTITY:
+            case DML_OPERATOR_ACTIVATION_LEAKY_RELU:
+            case DML_OPERATOR_ACTIVATION_LINEAR:
+            case DML_OPERATOR_ACTIVATION_PARAMETRIC_SOFTPLUS:
+            case DML_OPERATOR_ACTIVATION_RELU:
+            case DML_OPERATOR_ACTIVATION_SCALED_ELU:
+            case DML_OPERATOR_ACTIVATION_SCALED_TANH:
+            case DML_OPERATOR_ACTIVATION_SIGMOID:
+            case DML_OPERATOR_ACTIVATION_SOFTPLUS:
+            case DML_OPERATOR_ACTIVATION_SOFTSIGN:
+            case DML_OPERATOR_ACTIVATION_TANH:
+            case DML_OPERATOR_ACTIVATION_THRESHOLDED_RELU:
+            case DML_OPERATOR_ACTIVATION_SHRINK:
+            case DML_OPERATOR_ACTIVATION_CELU:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        inline void GraphBuilder::FuseActivations(Span<const Expression> outputs)
+        {
+            const std::vector<bool> reachable = FindReachableOperatorNodes(outputs);
+            std::vector<uint32_t> useCounts = CountOperatorNodeUses(outputs, reachable);
+
+            // An activation whose input comes straight from an operator with an empty FusedActivation, and which is
+            // that operator's only consumer, is rewritten into a copy of the operator with the activation fused. The
+            // original operator node becomes unreachable.
+            for (size_t i = 0; i < m_operatorNodes.size(); ++i)
+            {
+                OperatorNode& node = m_operatorNodes[i];
+                if (!reachable[i] || !node.desc.IsValid() || !IsFusableActivation(node.desc.GetType()) ||
+                    node.inputs.size() != 1 || node.inputs[0] == nullptr)
+                {
+                    continue;
+                }
+
+                NodeID producerID = node.inputs[0]->GetNode();
+                if (producerID.type != NodeType::Operator || useCounts[producerID.index] != 1)
+                {
+                    continue;
+                }
+
+                OperatorNode& producer = m_operatorNodes[producerID.index];
+                if (!producer.desc.IsValid())
+                {
+                    continue;
+                }
+
+                switch (producer.desc.GetType())
+                {
+                case DML_OPERATOR_CONVOLUTION:
+                case DML_OPERATOR_GEMM:
+                case DML_OPERATOR_BATCH_NORMALIZATION:
+                case DML_OPERATOR_MEAN_VARIANCE_NORMALIZATION1:
+                    break;
+                default:
+                    continue;
+                }
+
+                OperatorDescFields producerFields = OperatorDescFields::Get(producer.desc);
+                OperatorDescFields activationFields = OperatorDescFields::Get(node.desc);
+                assert(producerFields.fusedActivation && producerFields.outputTensors.size() == 1);
+                assert(activationFields.inputTensors.size() == 1 && activationFields.outputTensors.size() == 1);
+
+                if (*producerFields.fusedActivation != nullptr ||
+                    !AreTensorDescsEqual(*activationFields.inputTensors[0], *producerFields.outputTensors[0]))
+                {
+                    continue;
+                }
+
+                OwnedOperatorDesc fused(producer.desc.GetType(), producer.desc.Get()->Desc, &m_arena);
+                OperatorDescFields fusedFields = OperatorDescFields::Get(fused);
+
+                // Fused activation descs must not specify tensors
+                const DML_OPERATOR_DESC* activation = fused.CopyOperatorDescs(node.desc.Get(), 1);
+                OperatorDescFields fusedActivationFields;
+                VisitOperatorDesc(activation->Type, const_cast<void*>(activation->Desc), fusedActivationFields);
+                *fusedActivationFields.inputTensors[0] = nullptr;
+                *fusedActivationFields.outputTensors[0] = nullptr;
+
+                *fusedFields.fusedActivation = activation;
+                *fusedFields.outputTensors[0] = fused.CopyTensor(*activationFields.outputTensors[0]);
+
+                node.desc = std::move(fused);
+                node.inputs = AllocateInputs(producer.inputs);
+                node.op = nullptr;
+                if (producer.name)
+                {
+                    node.name = producer.name;
+                }
+
+                useCounts[producerID.index] = 0;
+                ++m_statistics.fusedActivationCount;
+            }
+        }
+
+        inline void GraphBuilder::QuantizeWeights(Span<const Expression> outputs)
+        {
+            const std::vector<bool> reachable = FindReachableOperatorNodes(outputs);
+
+            // Weights shared by several operators are quantized once, unless the operators read them through
+            // different views or along different channel dimensions. Keyed by the constant's node output.
+            struct QuantizedWeights
+            {
+                TensorDesc weightTensor;
+                uint32_t channelDimension;
+                NodeOutput* dequantized;
+            };
+            std::unordered_map<NodeOutput*, std::vector<QuantizedWeights>> quantizedWeights;
+
+            // Dequantize nodes only read constants, and are moved in front of their first consumer afterwards
+            std::vector<std::pair<uint32_t, uint32_t>> dequantizeNodeMoves;
+
+            // Dequantize nodes are added as the loop goes, which can reallocate m_operatorNodes, so nodes are looked
+            // up by index rather than held by reference.
+            for (size_t i = 0; i < reachable.size(); ++i)
+            {
+                if (!reachable[i] || !m_operatorNodes[i].desc.IsValid() || m_operatorNodes[i].inputs.size() < 2)
+                {
+                    continue;
+                }
+
+                // Both operators take the weights as input 1. Each output channel gets its own scale and zero point:
+                // channels are the first dimension of a convolution filter, and the N dimension of GEMM's B.
+                const OwnedOperatorDesc& desc = m_operatorNodes[i].desc;
+                const DML_TENSOR_DESC* weightTensor = nullptr;
+                uint32_t channelDimension = 0;
+                if (desc.GetType() == DML_OPERATOR_CONVOLUTION)
+                {
+                    weightTensor = desc.As<DML_CONVOLUTION_OPERATOR_DESC>()->FilterTensor;
+                }
+                else if (desc.GetType() == DML_OPERATOR_GEMM)
+                {
+                    const auto* gemm = desc.As<DML_GEMM_OPERATOR_DESC>();
+                    weightTensor = gemm->BTensor;
+                    const uint32_t dimensionCount = static_cast<const DML_BUFFER_TENSOR_DESC*>(weightTensor->Desc)->DimensionCount;
+                    channelDimension = gemm->TransB == DML_MATRIX_TRANSFORM_TRANSPOSE ? dimensionCount - 2 : dimensionCount - 1;
+                }
+                else
+                {
+                    continue;
+                }
+
+                NodeOutput* weights = m_operatorNodes[i].inputs[1];
+                const std::vector<uint8_t>* weightData = weights ? GetConstantData(weights) : nullptr;
+                if (!weightData)
+                {
+                    continue;
+                }
+
+                NodeOutput* dequantized = nullptr;
+                std::vector<QuantizedWeights>& quantizedViews = quantizedWeights[ResolveReinterprets(weights)];
+                for (QuantizedWeights& view : quantizedViews)
+                {
+                    if (view.channelDimension == channelDimension &&
+                        AreTensorDescsEqual(view.weightTensor.AsPtr<DML_TENSOR_DESC>(), weightTensor))
+                    {
+                        dequantized = view.dequantized;
+                    }
+                }
+
+                if (!dequantized)
+                {
+                    std::vector<float> values;
+                    if (!ReadFloat32Tensor(*weightTensor, *weightData, values) || values.empty())
+                    {
+                        continue;
+                    }
+
+                    // Asymmetric quantization over each channel's range, widened to include zero so that zero weights
+                    // stay exact: w = (q - zeroPoint) * scale.
+                    const TensorDesc floatTensor(*weightTensor);
+                    const uint32_t channelCount = floatTensor.sizes[channelDimension];
+                    uint64_t innerCount = 1;
+                    for (size_t d = channelDimension + 1; d < floatTensor.sizes.size(); ++d)
+                    {
+                        innerCount *= floatTensor.sizes[d];
+                    }
+
+                    std::vector<float> minimums(channelCount, 0.0f);
+                    std::vector<float> maximums(channelCount, 0.0f);
+                    for (size_t e = 0; e < values.size(); ++e)
+                    {
+                        const size_t c = static_cast<size_t>((e / innerCount) % channelCount);
+                        minimums[c] = std::min(minimums[c], values[e]);
+                        maximums[c] = std::max(maximums[c], values[e]);
+                    }
+
+                    std::vector<float> scales(channelCount);
+                    std::vector<int8_t> zeroPoints(channelCount);
+                    for (uint32_t c = 0; c < channelCount; ++c)
+                    {
+                        const float range = maximums[c] - minimums[c];
+                        scales[c] = range > 0.0f && std::isfinite(range) ? range / 255.0f : 1.0f;
+                        const float zeroPoint = std::nearbyint(-128.0f - minimums[c] / scales[c]);
+                        zeroPoints[c] = static_cast<int8_t>(std::min(std::max(zeroPoint, -128.0f), 127.0f));
+                    }
+
+                    TensorDesc quantizedTensor(DML_TENSOR_DATA_TYPE_INT8, floatTensor.flags, floatTensor.sizes);
+                    TensorDesc::Dimensions channelSizes(floatTensor.sizes.size(), 1);
+                    channelSizes[channelDimension] = channelCount;
+                    TensorDesc scaleTensor(DML_TENSOR_DATA_TYPE_FLOAT32, floatTensor.flags, channelSizes);
+                    TensorDesc zeroPointTensor(DML_TENSOR_DATA_TYPE_INT8, floatTensor.flags, channelSizes);
+
+                    const uint64_t floatBytes = values.size() * sizeof(float);
+                    const uint64_t quantizedBytes = quantizedTensor.totalTensorSizeInBytes +
+                        scaleTensor.totalTensorSizeInBytes + zeroPointTensor.totalTensorSizeInBytes;
+                    if (quantizedBytes >= floatBytes)
+                    {
+                        continue;
+                    }
+
+                    std::vector<uint8_t> quantizedData(static_cast<size_t>(quantizedTensor.totalTensorSizeInBytes));
+                    for (size_t e = 0; e < values.size(); ++e)
+                    {
+                        const size_t c = static_cast<size_t>((e / innerCount) % channelCount);
+                        const float q = std::nearbyint(values[e] / scales[c]) + zeroPoints[c];
+                        quantizedData[e] = static_cast<uint8_t>(static_cast<int8_t>(std::min(std::max(q, -128.0f), 127.0f)));
+                    }
+
+                    std::vector<uint8_t> scaleData(static_cast<size_t>(scaleTensor.totalTensorSizeInBytes));
+                    memcpy(scaleData.data(), scales.data(), scales.size() * sizeof(float));
+                    std::vector<uint8_t> zeroPointData(static_cast<size_t>(zeroPointTensor.totalTensorSizeInBytes));
+                    memcpy(zeroPointData.data(), zeroPoints.data(), zeroPoints.size());
+
+                    // Scales and zero points are broadcast across each channel
+                    TensorDesc::Dimensions channelStrides(floatTensor.sizes.size(), 0);
+                    channelStrides[channelDimension] = 1;
+
+                    Expression quantized = CreateConstantInput(std::move(quantizedTensor), std::move(quantizedData));
+                    Expression scale = CreateConstantInput(std::move(scaleTensor), std::move(scaleData));
+                    Expression zeroPoint = CreateConstantInput(std::move(zeroPointTensor), std::move(zeroPointData));
+                    dequantized = DequantizeLinear(
+                        quantized,
+                        Reinterpret(scale, floatTensor.sizes, channelStrides),
+                        Reinterpret(zeroPoint, floatTensor.sizes, channelStrides)).Impl();
+                    m_operatorNodes[dequantized->GetNode().index].name = m_operatorNodes[i].name;
+                    m_operatorNodes[dequantized->GetNode().index].sourceIndex = m_operatorNodes[i].sourceIndex;
+                    dequantizeNodeMoves.emplace_back(dequantized->GetNode().index, static_cast<uint32_t>(i));
+
+                    quantizedViews.push_back({ floatTensor, channelDimension, dequantized });
+                    ++m_statistics.quantizedWeightCount;
+                    m_statistics.quantizedWeightBytesSaved += floatBytes - quantizedBytes;
+                }
+
+                // The operator reads the dequantized weights, which are an intermediate tensor rather than a constant
+                OperatorNode& node = m_operatorNodes[i];
+                TensorDesc dequantizedTensor = dequantized->GetOutputDesc();
+                OwnedOperatorDesc rewritten(node.desc.GetType(), node.desc.Get()->Desc, &m_arena);
+                if (rewritten.GetType() == DML_OPERATOR_CONVOLUTION)
+                {
+                    auto* conv = rewritten.As<DML_CONVOLUTION_OPERATOR_DESC>();
+                    conv->FilterTensor = rewritten.CopyTensor(dequantizedTensor.AsPtr<DML_TENSOR_DESC>());
+                }
+                else
+                {
+                    auto* gemm = rewritten.As<DML_GEMM_OPERATOR_DESC>();
+                    gemm->BTensor = rewritten.CopyTensor(dequantizedTensor.AsPtr<DML_TENSOR_DESC>());
+                }
+
+                node.desc = std::move(rewritten);
+                node.inputs[1] = dequantized;
+                node.op = nullptr;
+            }
+
+            if (!dequantizeNodeMoves.empty())
+            {
+                MoveOperatorNodes(dequantizeNodeMoves);
+            }
+        }
+
+        inline void GraphBuilder::ConvertToFloat16(Span<const Expression> outputs)
+        {
+            const std::vector<bool> reachable = FindReachableOperatorNodes(outputs);
+
+            auto isFloat32 = [](const DML_TENSOR_DESC* tensor)
+            {
+                return tensor && static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc)->DataType == DML_TENSOR_DATA_TYPE_FLOAT32;
+            };
+
+            // Casts are only reused within a pass; a later pass may convert nodes that come before them.
+            std::unordered_map<NodeOutput*, NodeOutput*> float16Tensors;
+            std::vector<std::pair<uint32_t, uint32_t>> moves;
+
+            // Each converted node is copied into a new FLOAT16 node, and the original node becomes a cast of the copy's
+            // output back to FLOAT32, so every existing NodeOutput keeps its type. Converted consumers bypass the cast
+            // (see GetFloat16Tensor), which leaves it reachable only from FLOAT32 consumers and graph outputs. Nodes
+            // are added as the loop goes, which can reallocate m_operatorNodes, so nodes are looked up by index.
+            for (size_t i = 0; i < reachable.size(); ++i)
+            {
+                if (!reachable[i] || !m_operatorNodes[i].desc.IsValid())
+                {
+                    continue;
+                }
+
+                // Casts and fills have data types of their own
+                const DML_OPERATOR_TYPE type = m_operatorNodes[i].desc.GetType();
+                if (type == DML_OPERATOR_CAST || type == DML_OPERATOR_FILL_VALUE_CONSTANT ||
+                    type == DML_OPERATOR_FILL_VALUE_SEQUENCE || !m_mixedPrecisionPolicy.IsFloat16Operator(type))
+                {
+                    continue;
+                }
+
+                const OperatorDescTensors tensors = OperatorDescTensors::Get(m_operatorNodes[i].desc);
+                if (!isFloat32(tensors.GetSingleOutputTensor()))
+                {
+                    continue;
+                }
+
+                // The desc reads each input as it is or broadcast (see MapTensorView), which is redone for the FLOAT16
+                // copy of the input
+                const Span<NodeOutput*> inputs = m_operatorNodes[i].inputs;
+                bool inputsMatchDesc = inputs.size() <= tensors.inputTensors.size();
+                for (size_t j = 0; inputsMatchDesc && j < inputs.size(); ++j)
+                {
+                    TensorDesc mapped;
+                    inputsMatchDesc = !inputs[j] ||
+                        (isFloat32(tensors.inputTensors[j]) == (inputs[j]->GetOutputDesc().dataType == DML_TENSOR_DATA_TYPE_FLOAT32) &&
+                        MapTensorView(TensorDesc(*tensors.inputTensors[j]), inputs[j]->GetOutputDesc(), inputs[j]->GetOutputDesc(), mapped));
+                }
+                if (!inputsMatchDesc)
+                {
+                    continue;
+                }
+
+                OwnedOperatorDesc float16Desc(type, m_operatorNodes[i].desc.Get()->Desc, &m_arena);
+                const OperatorDescTensors float16DescTensors = OperatorDescTensors::Get(float16Desc);
+                std::vector<NodeOutput*> float16Inputs(inputs.begin(), inputs.end());
+                for (size_t j = 0; j < float16Inputs.size(); ++j)
+                {
+                    if (float16Inputs[j] && float16Inputs[j]->GetOutputDesc().dataType == DML_TENSOR_DATA_TYPE_FLOAT32)
+                    {
+                        float16Inputs[j] = GetFloat16Tensor(float16Inputs[j], static_cast<uint32_t>(i), float16Tensors, moves);
+                        TensorDesc inputTensor;
+                        MapTensorView(
+                            TensorDesc(*tensors.inputTensors[j]),
+                            inputs[j]->GetOutputDesc(),
+                            float16Inputs[j]->GetOutputDesc(),
+                            inputTensor);
+                        *float16DescTensors.inputTensors[j] = *float16Desc.CopyTensor(inputTensor.AsPtr<DML_TENSOR_DESC>());
+                    }
+                }
+
+                TensorDesc outputTensor(*tensors.outputTensors[0]);
+                TensorDesc float16OutputTensor = GetFloat16TensorDesc(outputTensor);
+                *float16DescTensors.outputTensors[0] = *float16Desc.CopyTensor(float16OutputTensor.AsPtr<DML_TENSOR_DESC>());
+
+                OperatorNode float16Node;
+                float16Node.desc = std::move(float16Desc);
+                float16Node.inputs = AllocateInputs(float16Inputs);
+                float16Node.name = m_operatorNodes[i].name;
+                float16Node.sourceIndex = m_operatorNodes[i].sourceIndex;
+                const uint32_t float16NodeIndex = static_cast<uint32_t>(m_operatorNodes.size());
+                m_operatorNodes.push_back(std::move(float16Node));
+                NodeOutput* float16Output = CreateNodeOutput({ NodeType::Operator, float16NodeIndex }, 0, float16OutputTensor);
+
+                DML_CAST_OPERATOR_DESC cast = {};
+                cast.InputTensor = float16OutputTensor.AsPtr<DML_TENSOR_DESC>();
+                cast.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+                OperatorNode& node = m_operatorNodes[i];
+                NodeOutput* const castInputs[] = { float16Output };
+                node.desc = OwnedOperatorDesc(DML_OPERATOR_CAST, &cast, &m_arena);
+                node.inputs = AllocateInputs(castInputs);
+                node.op = nullptr;
+
+                moves.emplace_back(float16NodeIndex, static_cast<uint32_t>(i));
+                ++m_statistics.float16OperatorCount;
+            }
+
+            if (!moves.empty())
+            {
+                MoveOperatorNodes(moves);
+            }
+        }
+
+        inline NodeOutput* GraphBuilder::GetFloat16Tensor(
+            NodeOutput* input,
+            uint32_t consumerIndex,
+            std::unordered_map<NodeOutput*, NodeOutput*>& float16Tensors,
+            std::vector<std::pair<uint32_t, uint32_t>>& moves)
+        {
+            auto cached = float16Tensors.find(input);
+            if (cached != float16Tensors.end())
+            {
+                return cached->second;
+            }
+
+            auto hasSameLayout = [](const TensorDesc& a, const TensorDesc& b)
+            {
+                return a.sizes == b.sizes && a.strides == b.strides;
+            };
+
+            const TensorDesc& tensor = input->GetOutputDesc();
+            NodeOutput* root = ResolveReinterprets(input);
+            NodeOutput* float16 = nullptr;
+            bool canCastInPlace = true;
+            if (root != input)
+            {
+                // Strides count elements, so a reshape or view of a tensor applies unchanged to a FLOAT16 copy of it
+                // with the same layout
+                if (root->GetOutputDesc().dataType == DML_TENSOR_DATA_TYPE_FLOAT32)
+                {
+                    NodeOutput* float16Root = GetFloat16Tensor(root, consumerIndex, float16Tensors, moves);
+                    if (hasSameLayout(float16Root->GetOutputDesc(), root->GetOutputDesc()))
+                    {
+                        const bool isView = m_reinterpretNodes[input->GetNode().index].isView;
+                        float16 = CreateNodeOutput(CreateReinterpretNode(float16Root, isView), 0, GetFloat16TensorDesc(tensor));
+                    }
+                }
+
+                // Otherwise the view is cast as it's read, into a new tensor
+                canCastInPlace = false;
+            }
+            else if (input->GetNode().type == NodeType::Operator)
+            {
+                // A cast from FLOAT16, e.g. a node converted earlier in this pass, is bypassed
+                const OperatorNode& producer = m_operatorNodes[input->GetNode().index];
+                if (producer.desc.IsValid() && producer.desc.GetType() == DML_OPERATOR_CAST)
+                {
+                    NodeOutput* castInput = producer.inputs[0];
+                    const TensorDesc& castInputTensor = castInput->GetOutputDesc();
+                    if (castInputTensor.dataType == DML_TENSOR_DATA_TYPE_FLOAT16 && ResolveReinterprets(castInput) == castInput &&
+                        hasSameLayout(castInputTensor, tensor))
+                    {
+                        float16 = castInput;
+                    }
+                }
+            }
+            else if (const std::vector<uint8_t>* data = GetConstantData(input))
+            {
+                // Constants are converted on the CPU, element by element across the whole buffer so that the strides
+                // still apply. They're kept for the life of the graph, since inputs have no position to respect.
+                NodeOutput*& float16Constant = m_float16Constants[input];
+                if (!float16Constant)
+                {
+                    TensorDesc float16Tensor = GetFloat16TensorDesc(tensor);
+                    std::vector<uint8_t> float16Data(static_cast<size_t>(float16Tensor.totalTensorSizeInBytes));
+                    const size_t elementCount = std::min(data->size() / sizeof(float), float16Data.size() / sizeof(uint16_t));
+                    for (size_t e = 0; e < elementCount; ++e)
+                    {
+                        float value;
+                        memcpy(&value, data->data() + e * sizeof(float), sizeof(float));
+                        const uint16_t bits = FloatToHalf(value);
+                        memcpy(float16Data.data() + e * sizeof(uint16_t), &bits, sizeof(uint16_t));
+                    }
+
+                    if (data->size() > float16Data.size())
+                    {
+                        m_statistics.float16ConstantBytesSaved += data->size() - float16Data.size();
+                    }
+                    float16Constant = CreateConstantInput(std::move(float16Tensor), std::move(float16Data));
+                }
+                float16 = float16Constant;
+            }
+
+            if (!float16)
+            {
+                // Anything else is cast where it's read. The cast keeps the input's layout where it can, so that views
+                // of the input can read the cast's output; broadcast (zero) strides can't be written, though.
+                const bool hasBroadcastStrides = tensor.strides &&
+                    std::find(tensor.strides->begin(), tensor.strides->end(), 0u) != tensor.strides->end();
+
+                TensorDesc inputTensor = tensor;
+                TensorDesc outputTensor = canCastInPlace && !hasBroadcastStrides
+                    ? GetFloat16TensorDesc(tensor)
+                    : TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT16, tensor.sizes, m_tensorPolicy);
+                outputTensor.flags = DML_TENSOR_FLAG_NONE;
+
+                DML_CAST_OPERATOR_DESC cast = {};
+                cast.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
+                cast.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+                OperatorNode castNode;
+                NodeOutput* const castInputs[] = { input };
+                castNode.desc = OwnedOperatorDesc(DML_OPERATOR_CAST, &cast, &m_arena);
+                castNode.inputs = AllocateInputs(castInputs);
+                castNode.name = m_operatorNodes[consumerIndex].name;
+                castNode.sourceIndex = m_operatorNodes[consumerIndex].sourceIndex;
+                const uint32_t castNodeIndex = static_cast<uint32_t>(m_operatorNodes.size());
+                m_operatorNodes.push_back(std::move(castNode));
+
+                float16 = CreateNodeOutput({ NodeType::Operator, castNodeIndex }, 0, std::move(outputTensor));
+                moves.emplace_back(castNodeIndex, consumerIndex);
+            }
+
+            float16Tensors[input] = float16;
+            return float16;
+        }
+
+        // Finds a minimum s-t cut with Dinic's algorithm. Used to choose one of two alternatives for each node of a
+        // graph, when each alternative has a cost of its own and neighbors that choose differently add a cost: the
+        // costs are capacities from the source and to the sink, and between neighbors.
+        class MinimumCut
+        {
+        public:
+            explicit MinimumCut(uint32_t nodeCount)
+                : m_firstEdges(nodeCount, UINT32_MAX)
+            {}
+
+            // Adds an edge with the given capacity, along with the reverse edge.
+            void AddEdge(uint32_t from, uint32_t to, uint64_t capacity, uint64_t reverseCapacity = 0)
+            {
+                if (capacity == 0 && reverseCapacity == 0)
+                {
+                    return;
+                }
+
+                // The two directions are adjacent, so each edge's partner is at index ^ 1
+                AddHalfEdge(from, to, capacity);
+                AddHalfEdge(to, from, reverseCapacity);
+            }
+
+            // Returns, for each node, whether it's on the sink side of a minimum cut. Nodes that could be on either
+            // side are put on the source side.
+            std::vector<bool> Solve(uint32_t source, uint32_t sink)
+            {
+                std::vector<uint32_t> levels(m_firstEdges.size());
+                std::vector<uint32_t> nextEdges;
+                while (BuildLevels(source, sink, levels))
+                {
+                    nextEdges = m_firstEdges;
+                    while (Augment(source, sink, UINT64_MAX, levels, nextEdges) != 0)
+                    {
+                    }
+                }
+
+                // The sink side is every node that can still reach the sink through an edge with spare capacity
+                std::vector<bool> sinkSide(m_firstEdges.size(), false);
+                std::vector<uint32_t> worklist = { sink };
+                sinkSide[sink] = true;
+                while (!worklist.empty())
+                {
+                    const uint32_t node = worklist.back();
+                    worklist.pop_back();
+                    for (uint32_t e = m_firstEdges[node]; e != UINT32_MAX; e = m_edges[e].next)
+                    {
+                        const uint32_t neighbor = m_edges[e].to;
+                        if (!sinkSide[neighbor] && m_edges[e ^ 1].capacity > 0)
+                        {
+                            sinkSide[neighbor] = true;
+                            worklist.push_back(neighbor);
+                        }
+                    }
+                }
+                return sinkSide;
+            }
+
+        private:
+            struct Edge
+            {
+                uint32_t to;
+                uint32_t next;
+                uint64_t capacity;
+            };
+
+            void AddHalfEdge(uint32_t from, uint32_t to, uint64_t capacity)
+            {
+                m_edges.push_back({ to, m_firstEdges[from], capacity });
+                m_firstEdges[from] = static_cast<uint32_t>(m_edges.size() - 1);
+            }
+
+            // Numbers nodes by their distance from the source over edges with spare capacity. Returns false if the
+            // sink can't be reached.
+            bool BuildLevels(uint32_t source, uint32_t sink, std::vector<uint32_t>& levels) const
+            {
+                std::fill(levels.begin(), levels.end(), UINT32_MAX);
+                std::vector<uint32_t> queue = { source };
+                levels[source] = 0;
+                for (size_t i = 0; i < queue.size(); ++i)
+                {
+                    for (uint32_t e = m_firstEdges[queue[i]]; e != UINT32_MAX; e = m_edges[e].next)
+                    {
+                        if (m_edges[e].capacity > 0 && levels[m_edges[e].to] == UINT32_MAX)
+                        {
+                            levels[m_edges[e].to] = levels[queue[i]] + 1;
+                            queue.push_back(m_edges[e].to);
+                        }
+                    }
+                }
+                return levels[sink] != UINT32_MAX;
+            }
+
+            // Pushes flow along one path of increasing levels to the sink. Returns the amount pushed.
+            uint64_t Augment(
+                uint32_t node,
+                uint32_t sink,
+                uint64_t limit,
+                const std::vector<uint32_t>& levels,
+                std::vector<uint32_t>& nextEdges)
+            {
+                if (node == sink)
+                {
+                    return limit;
+                }
+
+                for (uint32_t& e = nextEdges[node]; e != UINT32_MAX; e = m_edges[e].next)
+                {
+                    const uint32_t to = m_edges[e].to;
+                    if (m_edges[e].capacity > 0 && levels[to] == levels[node] + 1)
+                    {
+                        const uint64_t pushed = Augment(to, sink, std::min(limit, m_edges[e].capacity), levels, nextEdges);
+                        if (pushed != 0)
+                        {
+                            m_edges[e].capacity -= pushed;
+                            m_edges[e ^ 1].capacity += pushed;
+                            return pushed;
+                        }
+                    }
+                }
+                return 0;
+            }
 
-        // The output and indices sizes must all match except for the active axis, which is supplied as outputLength.
-        TensorDimensions outputSizes = indicesTensor.sizes;
-        outputSizes[axis] = outputLength;
+            std::vector<Edge> m_edges;
+            std::vector<uint32_t> m_firstEdges;
+        };
 
-        TensorDesc outputTensor(valuesTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+        enum class TensorLayout
+        {
+            Packed,      // e.g. NCHW
+            Interleaved, // e.g. NHWC; see TensorPolicy::InterleavedChannel
+            Other,
+        };
 
-        DML_ONE_HOT_OPERATOR_DESC desc = {};
-        desc.IndicesTensor = indicesTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ValuesTensor = valuesTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.Axis = axis;
+        // Returns true if a tensor has a channel dimension (dimension 1) and spatial dimensions, and the packed and
+        // interleaved layouts would address its elements differently.
+        inline bool IsInterleavable(const TensorDesc& tensor)
+        {
+            if (tensor.sizes.size() < 3 || tensor.sizes[1] == 1)
+            {
+                return false;
+            }
 
-        detail::NodeOutput* const inputs[] = { indices.Impl(), values.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_ONE_HOT, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            uint64_t spatialElementCount = 1;
+            for (size_t i = 2; i < tensor.sizes.size(); ++i)
+            {
+                spatialElementCount *= tensor.sizes[i];
+            }
+            return spatialElementCount > 1;
+        }
 
-        return output;
-    }
+        inline TensorDesc GetInterleavedTensorDesc(const TensorDesc& tensor)
+        {
+            return TensorDesc(tensor.dataType, tensor.flags, tensor.sizes, TensorPolicy::InterleavedChannel());
+        }
 
-    // If not specified, parameters are defaulted to the following values:
-    //   Scales = computed by dividing the output sizes by the input sizes
-    //   InputPixelOffsets = 0.5f for each dimension
-    //   OutputPixelOffsets = -0.5f for each dimension
-    inline Expression Resample(
-        Expression input,
-        TensorDimensions outputSizes,
-        DML_INTERPOLATION_MODE mode,
-        Span<const float> scales = {},
-        Span<const float> inputPixelOffsets = {},
-        Span<const float> outputPixelOffsets = {})
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+        inline TensorLayout GetTensorLayout(const TensorDesc& tensor)
+        {
+            if (!tensor.strides)
+            {
+                return TensorLayout::Packed;
+            }
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        uint32_t dimensionCount = static_cast<uint32_t>(inputTensor.sizes.size());
-        assert(outputSizes.size() == dimensionCount);
+            TensorDimensions packedStrides(tensor.sizes.size());
+            uint32_t stride = 1;
+            for (size_t i = tensor.sizes.size(); i-- > 0;)
+            {
+                packedStrides[i] = stride;
+                stride *= tensor.sizes[i];
+            }
 
-        SmallVector<float, 4> defaultScales;
-        if (scales.empty())
-        {
-            for (uint32_t i = 0; i < dimensionCount; ++i)
+            if (*tensor.strides == packedStrides)
             {
-                defaultScales.push_back(static_cast<float>(outputSizes[i]) / static_cast<float>(inputTensor.sizes[i]));
+                return TensorLayout::Packed;
             }
-            scales = defaultScales;
+            if (tensor.sizes.size() >= 3 && *tensor.strides == *GetInterleavedTensorDesc(tensor).strides)
+            {
+                return TensorLayout::Interleaved;
+            }
+            return TensorLayout::Other;
         }
 
-        SmallVector<float, 4> defaultInputPixelOffsets;
-        if (inputPixelOffsets.empty())
+        // Returns the layout an operator type runs fastest in, or Other if it has no preference.
+        inline TensorLayout GetPreferredLayout(DML_OPERATOR_TYPE type)
         {
-            defaultInputPixelOffsets.assign(dimensionCount, 0.5f);
-            inputPixelOffsets = defaultInputPixelOffsets;
+            switch (type)
+            {
+            case DML_OPERATOR_CONVOLUTION:
+            case DML_OPERATOR_AVERAGE_POOLING:
+            case DML_OPERATOR_MAX_POOLING2:
+                return TensorLayout::Interleaved;
+
+            case DML_OPERATOR_JOIN:
+            case DML_OPERATOR_SPLIT:
+            case DML_OPERATOR_GATHER:
+            case DML_OPERATOR_GATHER_ELEMENTS:
+            case DML_OPERATOR_REDUCE:
+                return TensorLayout::Packed;
+
+            default:
+                return TensorLayout::Other;
+            }
         }
 
-        SmallVector<float, 4> defaultOutputPixelOffsets;
-        if (outputPixelOffsets.empty())
+        inline void GraphBuilder::AssignLayouts(Span<const Expression> outputs)
         {
-            defaultOutputPixelOffsets.assign(dimensionCount, -0.5f);
-            outputPixelOffsets = defaultOutputPixelOffsets;
-        }
+            const std::vector<bool> reachable = FindReachableOperatorNodes(outputs);
+            const uint32_t nodeCount = static_cast<uint32_t>(reachable.size());
+
+            // An operator can be given the interleaved layout if its desc can be rewritten and its only output is
+            // packed. Copies between layouts, such as those made by earlier passes, are left as they are.
+            std::vector<uint32_t> candidateIndices(nodeCount, UINT32_MAX);
+            std::vector<uint32_t> candidates;
+            std::vector<bool> isRewritable(nodeCount, false);
+            for (uint32_t i = 0; i < nodeCount; ++i)
+            {
+                if (!reachable[i] || !m_operatorNodes[i].desc.IsValid())
+                {
+                    continue;
+                }
 
-        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+                const OperatorDescTensors tensors = OperatorDescTensors::Get(m_operatorNodes[i].desc);
+                isRewritable[i] = m_operatorNodes[i].inputs.size() <= tensors.inputTensors.size();
+                if (!isRewritable[i] || !tensors.GetSingleOutputTensor())
+                {
+                    continue;
+                }
 
-        DML_RESAMPLE1_OPERATOR_DESC desc = {};
-        desc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.InterpolationMode = mode;
-        desc.DimensionCount = static_cast<UINT>(scales.size());
-        desc.Scales = scales.data();
-        desc.InputPixelOffsets = inputPixelOffsets.data();
-        desc.OutputPixelOffsets = outputPixelOffsets.data();
+                const TensorDesc outputTensor(*tensors.GetSingleOutputTensor());
+                if (!IsInterleavable(outputTensor) || GetTensorLayout(outputTensor) != TensorLayout::Packed)
+                {
+                    continue;
+                }
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_RESAMPLE1, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+                if (m_operatorNodes[i].desc.GetType() == DML_OPERATOR_ELEMENT_WISE_IDENTITY &&
+                    GetTensorLayout(TensorDesc(*tensors.inputTensors[0])) != TensorLayout::Packed)
+                {
+                    continue;
+                }
 
-        return output;
-    }
+                candidateIndices[i] = static_cast<uint32_t>(candidates.size());
+                candidates.push_back(i);
+            }
 
-    inline Expression FillValueConstant(
-        Graph& graph,
-        TensorDimensions outputSizes,
-        DML_TENSOR_DATA_TYPE valueDataType,
-        DML_SCALAR_UNION value)
-    {
-        detail::GraphBuilder* builder = graph.Impl();
-        TensorDesc outputTensor(valueDataType, std::move(outputSizes), builder->GetTensorPolicy());
+            if (candidates.empty())
+            {
+                return;
+            }
 
-        DML_FILL_VALUE_CONSTANT_OPERATOR_DESC desc = {};
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ValueDataType = valueDataType;
-        desc.Value = value;
+            // The cost of each layout for each candidate, in bytes of memory traffic. The source side of the cut is
+            // the packed layout and the sink side is the interleaved layout.
+            const uint32_t source = static_cast<uint32_t>(candidates.size());
+            const uint32_t sink = source + 1;
+            MinimumCut cut(sink + 1);
+            std::vector<uint64_t> packedCosts(candidates.size(), 0);
+            std::vector<uint64_t> interleavedCosts(candidates.size(), 0);
+            std::vector<bool> needsPackedCopy(candidates.size(), false);
 
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_FILL_VALUE_CONSTANT, &desc, {});
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            for (uint32_t i = 0; i < nodeCount; ++i)
+            {
+                if (!reachable[i])
+                {
+                    continue;
+                }
 
-        return output;
-    }
+                // Operators that keep their layout read their inputs in the layout of their output
+                const uint32_t consumer = candidateIndices[i];
+                TensorLayout consumerLayout = TensorLayout::Packed;
+                OperatorDescTensors consumerTensors;
+                if (isRewritable[i])
+                {
+                    consumerTensors = OperatorDescTensors::Get(m_operatorNodes[i].desc);
+                    if (consumer == UINT32_MAX && consumerTensors.GetSingleOutputTensor() &&
+                        GetTensorLayout(TensorDesc(*consumerTensors.GetSingleOutputTensor())) == TensorLayout::Interleaved)
+                    {
+                        consumerLayout = TensorLayout::Interleaved;
+                    }
+                }
 
-    inline Expression FillValueSequence(
-        Graph& graph,
-        TensorDimensions outputSizes,
-        DML_TENSOR_DATA_TYPE valueDataType,
-        DML_SCALAR_UNION valueStart,
-        DML_SCALAR_UNION valueDelta)
-    {
-        detail::GraphBuilder* builder = graph.Impl();
-        TensorDesc outputTensor(valueDataType, std::move(outputSizes), builder->GetTensorPolicy());
+                const Span<NodeOutput*> inputs = m_operatorNodes[i].inputs;
+                for (size_t j = 0; j < inputs.size(); ++j)
+                {
+                    NodeOutput* input = inputs[j];
+                    NodeOutput* root = input ? ResolveReinterprets(input) : nullptr;
+                    if (!root || !IsInterleavable(root->GetOutputDesc()))
+                    {
+                        continue;
+                    }
 
-        DML_FILL_VALUE_SEQUENCE_OPERATOR_DESC desc = {};
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.ValueDataType = valueDataType;
-        desc.ValueStart = valueStart;
-        desc.ValueDelta = valueDelta;
+                    // The consumer's desc must read the input as it is or broadcast it, to be rewritten for another
+                    // layout of the input
+                    TensorDesc mapped;
+                    const bool isMappable = isRewritable[i] && input == root && consumerTensors.inputTensors[j] &&
+                        MapTensorView(TensorDesc(*consumerTensors.inputTensors[j]), root->GetOutputDesc(), root->GetOutputDesc(), mapped);
 
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_FILL_VALUE_SEQUENCE, &desc, {});
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+                    const uint64_t bytes = root->GetOutputDesc().totalTensorSizeInBytes;
+                    const NodeID producerNode = root->GetNode();
+                    const uint32_t producer = producerNode.type == NodeType::Operator ? candidateIndices[producerNode.index] : UINT32_MAX;
+                    if (producer != UINT32_MAX)
+                    {
+                        // Reshapes and views assume the packed layout, as do operators that can't be rewritten
+                        if (!isMappable)
+                        {
+                            needsPackedCopy[producer] = true;
+                        }
+                        else if (consumer != UINT32_MAX)
+                        {
+                            cut.AddEdge(producer, consumer, bytes, bytes);
+                        }
+                        else if (consumerLayout == TensorLayout::Interleaved)
+                        {
+                            packedCosts[producer] += bytes;
+                        }
+                        else
+                        {
+                            interleavedCosts[producer] += bytes;
+                        }
+                    }
+                    else if (consumer != UINT32_MAX && input == root && (!isMappable || !GetConstantData(root)))
+                    {
+                        // Constants are rearranged to suit the consumer, but other tensors, and constants the consumer
+                        // can't be rewritten to read, are read as they are
+                        const TensorLayout layout = GetTensorLayout(root->GetOutputDesc());
+                        if (layout == TensorLayout::Packed)
+                        {
+                            interleavedCosts[consumer] += bytes;
+                        }
+                        else if (layout == TensorLayout::Interleaved)
+                        {
+                            packedCosts[consumer] += bytes;
+                        }
+                    }
+                }
+            }
 
-        return output;
-    }
+            // Graph outputs keep the layout they were created with
+            for (const Expression& output : outputs)
+            {
+                const NodeID node = output.Impl() ? ResolveReinterprets(output.Impl())->GetNode() : NodeID{};
+                if (node.type == NodeType::Operator && candidateIndices[node.index] != UINT32_MAX)
+                {
+                    needsPackedCopy[candidateIndices[node.index]] = true;
+                }
+            }
 
-    // 
-    // TODO: CumulativeSummation
-    // 
+            for (uint32_t c = 0; c < candidates.size(); ++c)
+            {
+                // An operator outside its preferred layout is charged the memory traffic it would have in that layout
+                OwnedOperatorDesc& desc = m_operatorNodes[candidates[c]].desc;
+                const OperatorDescTensors tensors = OperatorDescTensors::Get(desc);
+                uint64_t readWriteBytes = 0;
+                for (const DML_TENSOR_DESC* tensor : tensors.inputTensors)
+                {
+                    readWriteBytes += tensor ? static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc)->TotalTensorSizeInBytes : 0;
+                }
+                const uint64_t outputBytes = static_cast<const DML_BUFFER_TENSOR_DESC*>(tensors.outputTensors[0]->Desc)->TotalTensorSizeInBytes;
+                readWriteBytes += outputBytes;
 
-    inline Expression ReverseSubsequences(
-        Expression input,
-        Expression sequenceLengths,
-        uint32_t axis)
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc sequenceLengthsTensor = sequenceLengths.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(inputTensor.dataType, inputTensor.sizes, builder->GetTensorPolicy());
+                const TensorLayout preferredLayout = GetPreferredLayout(desc.GetType());
+                if (preferredLayout == TensorLayout::Interleaved)
+                {
+                    packedCosts[c] += readWriteBytes;
+                }
+                else if (preferredLayout == TensorLayout::Packed)
+                {
+                    interleavedCosts[c] += readWriteBytes;
+                }
 
-        DML_REVERSE_SUBSEQUENCES_OPERATOR_DESC reverseDesc = {};
-        reverseDesc.InputTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        reverseDesc.SequenceLengthsTensor = sequenceLengthsTensor.AsPtr<DML_TENSOR_DESC>();
-        reverseDesc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        reverseDesc.Axis = axis;
+                // A packed copy reads and writes the whole output
+                if (needsPackedCopy[c])
+                {
+                    interleavedCosts[c] += 2 * outputBytes;
+                }
 
-        detail::NodeOutput* const inputs[] = { input.Impl(), sequenceLengths.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_REVERSE_SUBSEQUENCES, &reverseDesc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+                cut.AddEdge(source, c, interleavedCosts[c]);
+                cut.AddEdge(c, sink, packedCosts[c]);
+            }
 
-        return output;
-    }
+            const std::vector<bool> isInterleaved = cut.Solve(source, sink);
 
-    // 
-    // TODO: MatrixMultiplyInteger
-    // 
+            // Each interleaved operator is copied into a new node that writes the interleaved layout, and the original
+            // node becomes a copy of its output back to the packed layout, so every existing NodeOutput keeps its
+            // layout. Operators that read the output directly are rewritten to read the new node's output instead,
+            // which leaves the copy reachable only from reshapes, views and graph outputs. Nodes are added as the loop
+            // goes, so they're looked up by index.
+            std::vector<NodeOutput*> interleavedOutputs(nodeCount, nullptr);
+            std::vector<std::pair<uint32_t, uint32_t>> moves;
+            for (uint32_t i = 0; i < nodeCount; ++i)
+            {
+                if (!reachable[i] || !isRewritable[i])
+                {
+                    continue;
+                }
 
-    // 
-    // TODO: QuantizedLinearMatrixMultiply
-    // 
+                const uint32_t candidate = candidateIndices[i];
+                const bool interleaved = candidate != UINT32_MAX && isInterleaved[candidate];
+
+                // Inputs are redirected only where the consumer's desc can be rewritten to read the new layout (see
+                // MapTensorView); other edges were charged for a copy
+                const Span<NodeOutput*> inputs = m_operatorNodes[i].inputs;
+                const OperatorDescTensors oldTensors = OperatorDescTensors::Get(m_operatorNodes[i].desc);
+                std::vector<NodeOutput*> newInputs(inputs.begin(), inputs.end());
+                std::vector<TensorDesc> newInputTensors(inputs.size());
+                bool inputsChanged = false;
+                for (size_t j = 0; j < newInputs.size(); ++j)
+                {
+                    NodeOutput* input = inputs[j];
+                    if (!input || ResolveReinterprets(input) != input || !oldTensors.inputTensors[j])
+                    {
+                        continue;
+                    }
 
-    // 
-    // TODO: ConvolutionInteger
-    // 
+                    NodeOutput* newInput = nullptr;
+                    const NodeID producer = input->GetNode();
+                    if (producer.type == NodeType::Operator && producer.index < nodeCount && interleavedOutputs[producer.index])
+                    {
+                        newInput = interleavedOutputs[producer.index];
+                    }
+                    else if (interleaved && IsInterleavable(input->GetOutputDesc()) &&
+                        GetTensorLayout(input->GetOutputDesc()) == TensorLayout::Packed && GetConstantData(input))
+                    {
+                        TensorDesc mapped;
+                        if (MapTensorView(TensorDesc(*oldTensors.inputTensors[j]), input->GetOutputDesc(), input->GetOutputDesc(), mapped))
+                        {
+                            newInput = GetInterleavedConstant(input);
+                        }
+                    }
 
-    // 
-    // TODO: QuantizedLinearConvolution
-    // 
+                    if (newInput &&
+                        MapTensorView(TensorDesc(*oldTensors.inputTensors[j]), input->GetOutputDesc(), newInput->GetOutputDesc(), newInputTensors[j]))
+                    {
+                        newInputs[j] = newInput;
+                        inputsChanged = true;
+                    }
+                }
 
-    // 
-    // TODO: ReluGrad
-    // 
+                if (!interleaved && !inputsChanged)
+                {
+                    continue;
+                }
 
-    // 
-    // TODO: AveragePoolingGrad
-    // 
+                const DML_OPERATOR_TYPE type = m_operatorNodes[i].desc.GetType();
+                OwnedOperatorDesc desc(type, m_operatorNodes[i].desc.Get()->Desc, &m_arena);
+                const OperatorDescTensors tensors = OperatorDescTensors::Get(desc);
+                for (size_t j = 0; j < newInputs.size(); ++j)
+                {
+                    if (newInputs[j] != inputs[j])
+                    {
+                        *tensors.inputTensors[j] = *desc.CopyTensor(newInputTensors[j].AsPtr<DML_TENSOR_DESC>());
+                    }
+                }
 
-    // 
-    // TODO: MaxPoolingGrad
-    // 
+                if (!interleaved)
+                {
+                    OperatorNode& node = m_operatorNodes[i];
+                    node.desc = std::move(desc);
+                    node.inputs = AllocateInputs(newInputs);
+                    node.op = nullptr;
+                    continue;
+                }
 
-    struct RandomGeneratorOutputs
-    {
-        Expression values;
-        Expression state; // Only valid if outputState = true is supplied to RandomGenerator
-    };
+                TensorDesc outputTensor(*tensors.outputTensors[0]);
+                TensorDesc interleavedTensor = GetInterleavedTensorDesc(outputTensor);
+                *tensors.outputTensors[0] = *desc.CopyTensor(interleavedTensor.AsPtr<DML_TENSOR_DESC>());
+
+                OperatorNode interleavedNode;
+                interleavedNode.desc = std::move(desc);
+                interleavedNode.inputs = AllocateInputs(newInputs);
+                interleavedNode.name = m_operatorNodes[i].name;
+                interleavedNode.sourceIndex = m_operatorNodes[i].sourceIndex;
+                const uint32_t interleavedNodeIndex = static_cast<uint32_t>(m_operatorNodes.size());
+                m_operatorNodes.push_back(std::move(interleavedNode));
+                NodeOutput* interleavedOutput = CreateNodeOutput({ NodeType::Operator, interleavedNodeIndex }, 0, interleavedTensor);
+
+                DML_ELEMENT_WISE_IDENTITY_OPERATOR_DESC copy = {};
+                copy.InputTensor = interleavedTensor.AsPtr<DML_TENSOR_DESC>();
+                copy.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
+
+                OperatorNode& node = m_operatorNodes[i];
+                NodeOutput* const copyInputs[] = { interleavedOutput };
+                node.desc = OwnedOperatorDesc(DML_OPERATOR_ELEMENT_WISE_IDENTITY, &copy, &m_arena);
+                node.inputs = AllocateInputs(copyInputs);
+                node.op = nullptr;
+
+                interleavedOutputs[i] = interleavedOutput;
+                moves.emplace_back(interleavedNodeIndex, i);
+                ++m_statistics.interleavedOperatorCount;
+                if (needsPackedCopy[candidate])
+                {
+                    ++m_statistics.layoutConversionCount;
+                }
+            }
+
+            if (!moves.empty())
+            {
+                MoveOperatorNodes(moves);
+            }
+        }
+
+        inline NodeOutput* GraphBuilder::GetInterleavedConstant(NodeOutput* constant)
+        {
+            NodeOutput*& interleaved = m_interleavedConstants[constant];
+            if (interleaved)
+            {
+                return interleaved;
+            }
+
+            // Elements are copied one at a time, in logical order, from the constant's strides to the interleaved ones
+            const TensorDesc& tensor = constant->GetOutputDesc();
+            const std::vector<uint8_t>& data = *GetConstantData(constant);
+            TensorDesc interleavedTensor = GetInterleavedTensorDesc(tensor);
+            std::vector<uint8_t> interleavedData(static_cast<size_t>(interleavedTensor.totalTensorSizeInBytes));
+
+            const size_t dimensionCount = tensor.sizes.size();
+            const uint32_t elementSize = GetDataTypeSizeInBytes(tensor.dataType);
+            TensorDimensions strides(dimensionCount);
+            uint64_t elementCount = 1;
+            for (size_t i = dimensionCount; i-- > 0;)
+            {
+                strides[i] = tensor.strides ? (*tensor.strides)[i] : static_cast<uint32_t>(elementCount);
+                elementCount *= tensor.sizes[i];
+            }
+
+            std::vector<uint32_t> index(dimensionCount, 0);
+            for (uint64_t element = 0; element < elementCount; ++element)
+            {
+                uint64_t offset = 0;
+                uint64_t interleavedOffset = 0;
+                for (size_t i = 0; i < dimensionCount; ++i)
+                {
+                    offset += uint64_t(index[i]) * strides[i];
+                    interleavedOffset += uint64_t(index[i]) * (*interleavedTensor.strides)[i];
+                }
+
+                if ((offset + 1) * elementSize > data.size())
+                {
+                    // The constant doesn't hold the whole tensor; leave it as it is
+                    return constant;
+                }
+                memcpy(interleavedData.data() + interleavedOffset * elementSize, data.data() + offset * elementSize, elementSize);
 
-    inline RandomGeneratorOutputs RandomGenerator(
-        Expression inputState,
-        TensorDimensions outputSizes,
-        bool outputState = true,
-        DML_RANDOM_GENERATOR_TYPE type = DML_RANDOM_GENERATOR_TYPE_PHILOX_4X32_10)
-    {
-        detail::GraphBuilder* builder = inputState.Impl()->GetGraphBuilder();
+                for (size_t i = dimensionCount; i-- > 0;)
+                {
+                    if (++index[i] < tensor.sizes[i])
+                    {
+                        break;
+                    }
+                    index[i] = 0;
+                }
+            }
 
-        TensorDesc inputStateTensor = inputState.Impl()->GetOutputDesc();
-        TensorDesc outputTensor(DML_TENSOR_DATA_TYPE_UINT32, std::move(outputSizes), builder->GetTensorPolicy());
+            interleaved = CreateConstantInput(std::move(interleavedTensor), std::move(interleavedData));
+            return interleaved;
+        }
 
-        DML_RANDOM_GENERATOR_OPERATOR_DESC desc = {};
-        desc.Type = type;
-        desc.InputStateTensor = inputStateTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        if (outputState)
+        // Returns the number of elements spanned by every dimension of a tensor but the first: the stride its first
+        // dimension needs for consecutive items not to overlap.
+        inline uint64_t GetTrailingElementSpan(const TensorDesc& tensor)
         {
-            // Input and output state have the same TensorDesc.
-            desc.OutputStateTensor = inputStateTensor.AsPtr<DML_TENSOR_DESC>();
+            const TensorDimensions strides = GetElementStrides(tensor);
+            uint64_t span = 1;
+            for (size_t i = 1; i < tensor.sizes.size(); ++i)
+            {
+                span += uint64_t(tensor.sizes[i] - 1) * strides[i];
+            }
+            return span;
         }
-        
-        RandomGeneratorOutputs out;
-
-        detail::NodeOutput* const inputs[] = { inputState.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_RANDOM_GENERATOR, &desc, inputs);
-        out.values = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
 
-        if (outputState)
+        inline bool ScaleLeadingDimension(TensorDimensions& sizes, uint32_t batchSize, std::string& error)
         {
-            TensorDesc outputStateTensor = inputStateTensor;
-            out.state = builder->CreateNodeOutput(node, 1, std::move(outputStateTensor));
+            if (sizes.empty() || uint64_t(sizes[0]) * batchSize > UINT32_MAX)
+            {
+                error = "has sizes " + FormatSizes(sizes) + ", which can't hold a batch of " + std::to_string(batchSize);
+                return false;
+            }
+
+            sizes[0] *= batchSize;
+            return true;
         }
 
-        return out;
-    }
+        // Rebatches a tensor written by an operator. Its leading dimension, which holds the batch, becomes `batchSize`
+        // times larger; a reshape may have folded other dimensions into it, in which case the items of the batch are
+        // outermost. Strided tensors keep their strides, and the items of the batch follow each other.
+        inline bool RebatchTensor(const TensorDesc& tensor, uint32_t batchSize, TensorDesc& rebatched, std::string& error)
+        {
+            TensorDimensions sizes = tensor.sizes;
+            if (!ScaleLeadingDimension(sizes, batchSize, error))
+            {
+                return false;
+            }
 
-    // 
-    // TODO: NonZeroCoordinates
-    // 
+            Optional<TensorDimensions> strides = tensor.strides;
+            if (strides && tensor.sizes[0] == 1)
+            {
+                const uint64_t span = GetTrailingElementSpan(tensor);
+                if (span > UINT32_MAX)
+                {
+                    error = "has strides that can't hold a batch of " + std::to_string(batchSize);
+                    return false;
+                }
+                (*strides)[0] = static_cast<uint32_t>(span);
+            }
+            else if (strides && (*strides)[0] == 0)
+            {
+                error = "broadcasts its leading dimension, which holds the batch";
+                return false;
+            }
 
-    // If not specified, parameters are defaulted to the following values:
-    //   Scales = computed by dividing the input sizes by the output sizes
-    //   InputPixelOffsets = 0.5f for each dimension
-    //   OutputPixelOffsets = -0.5f for each dimension
-    inline Expression ResampleGrad(
-        Expression input,
-        TensorDimensions outputSizes,
-        DML_INTERPOLATION_MODE mode,
-        Span<const float> scales = {},
-        Span<const float> inputPixelOffsets = {},
-        Span<const float> outputPixelOffsets = {})
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
+            const uint64_t totalSize = DMLCalcBufferTensorSize(
+                tensor.dataType,
+                static_cast<UINT>(sizes.size()),
+                sizes.data(),
+                strides ? strides->data() : nullptr);
 
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        uint32_t dimensionCount = static_cast<uint32_t>(inputTensor.sizes.size());
-        assert(outputSizes.size() == dimensionCount);
+            rebatched = TensorDesc(
+                tensor.dataType,
+                tensor.flags,
+                std::move(sizes),
+                std::move(strides),
+                totalSize,
+                tensor.guaranteedBaseOffsetAlignment);
+            return true;
+        }
 
-        SmallVector<float, 4> defaultScales;
-        if (scales.empty())
+        // Rebatches a view of a tensor: a reinterpret of it, or the desc an operator reads it through. `tensor` and
+        // `rebatchedTensor` are the viewed tensor before and after rebatching. Each item of the view's batch must
+        // read the same item of the tensor's batch. Reshapes of packed tensors fold the batch into their leading
+        // dimension; other views must keep a leading dimension of 1 for the batch to replace.
+        inline bool RebatchView(
+            const TensorDesc& view,
+            const TensorDesc& tensor,
+            const TensorDesc& rebatchedTensor,
+            uint32_t batchSize,
+            TensorDesc& rebatchedView,
+            std::string& error)
         {
-            for (uint32_t i = 0; i < dimensionCount; ++i)
+            if (view.dataType == tensor.dataType && view.sizes == tensor.sizes && view.strides == tensor.strides)
             {
-                defaultScales.push_back(static_cast<float>(inputTensor.sizes[i]) / static_cast<float>(outputSizes[i]));
+                rebatchedView = rebatchedTensor;
+                rebatchedView.flags = view.flags;
+                return true;
             }
-            scales = defaultScales;
-        }
 
-        SmallVector<float, 4> defaultInputPixelOffsets;
-        if (inputPixelOffsets.empty())
-        {
-            defaultInputPixelOffsets.assign(dimensionCount, 0.5f);
-            inputPixelOffsets = defaultInputPixelOffsets;
+            // The distance between the items of the tensor's batch
+            const uint64_t batchStride = uint64_t(tensor.sizes[0]) * GetElementStrides(rebatchedTensor)[0] *
+                GetDataTypeSizeInBytes(tensor.dataType);
+            const uint32_t elementSize = GetDataTypeSizeInBytes(view.dataType);
+
+            TensorDimensions sizes = view.sizes;
+            Optional<TensorDimensions> strides = view.strides;
+            if (GetTensorLayout(view) == TensorLayout::Packed && GetTensorLayout(tensor) == TensorLayout::Packed)
+            {
+                uint64_t viewSize = elementSize;
+                for (uint32_t size : view.sizes)
+                {
+                    viewSize *= size;
+                }
+
+                if (viewSize != batchStride)
+                {
+                    error = "reshapes " + FormatSizes(tensor.sizes) + " to " + FormatSizes(view.sizes) +
+                        ", which don't hold the same number of bytes";
+                    return false;
+                }
+                if (!ScaleLeadingDimension(sizes, batchSize, error))
+                {
+                    return false;
+                }
+                if (strides)
+                {
+                    strides = GetElementStrides(TensorDesc(view.dataType, sizes));
+                }
+            }
+            else if (view.sizes[0] == 1)
+            {
+                if (batchStride % elementSize != 0 || batchStride / elementSize > UINT32_MAX ||
+                    GetTrailingElementSpan(view) * elementSize > batchStride)
+                {
+                    error = "is a view with sizes " + FormatSizes(view.sizes) + " that reads across items of the batch";
+                    return false;
+                }
+
+                strides = GetElementStrides(view);
+                (*strides)[0] = static_cast<uint32_t>(batchStride / elementSize);
+                sizes[0] = batchSize;
+            }
+            else
+            {
+                error = "is a view with sizes " + FormatSizes(view.sizes) + " of a tensor with sizes " +
+                    FormatSizes(tensor.sizes) + ", so it's ambiguous which of its dimensions holds the batch";
+                return false;
+            }
+
+            rebatchedView = TensorDesc(
+                view.dataType,
+                view.flags,
+                std::move(sizes),
+                std::move(strides),
+                rebatchedTensor.totalTensorSizeInBytes,
+                view.guaranteedBaseOffsetAlignment);
+            return true;
         }
 
-        SmallVector<float, 4> defaultOutputPixelOffsets;
-        if (outputPixelOffsets.empty())
+        // Checks that an operator computes each item of a batch independently of the others, given which of its
+        // inputs carry the batch, and rewrites the attributes that refer to the leading dimension. Also decides which
+        // of the other inputs are broadcast to every item (`broadcastInputs`), as inputs of element-wise operators
+        // must be; the rest, e.g. convolution filters, are read as they are. Returns false if batching the operator
+        // would be ambiguous.
+        inline bool RebatchOperatorDesc(
+            OwnedOperatorDesc& desc,
+            const std::vector<bool>& batchedInputs,
+            uint32_t batchSize,
+            std::vector<bool>& broadcastInputs,
+            std::string& error)
         {
-            defaultOutputPixelOffsets.assign(dimensionCount, -0.5f);
-            outputPixelOffsets = defaultOutputPixelOffsets;
-        }
+            const OperatorDescTensors tensors = OperatorDescTensors::Get(desc);
+            broadcastInputs.assign(batchedInputs.size(), false);
 
-        TensorDesc outputTensor(inputTensor.dataType, std::move(outputSizes), builder->GetTensorPolicy());
+            auto requireAxis = [&](UINT axis, const char* name)
+            {
+                if (axis == 0)
+                {
+                    error = std::string(name) + " along the leading dimension, which holds the batch";
+                    return false;
+                }
+                return true;
+            };
 
-        DML_RESAMPLE_GRAD_OPERATOR_DESC desc = {};
-        desc.InputGradientTensor = inputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.OutputGradientTensor = outputTensor.AsPtr<DML_TENSOR_DESC>();
-        desc.InterpolationMode = mode;
-        desc.DimensionCount = static_cast<UINT>(scales.size());
-        desc.Scales = scales.data();
-        desc.InputPixelOffsets = inputPixelOffsets.data();
-        desc.OutputPixelOffsets = outputPixelOffsets.data();
+            auto requireAxes = [&](const UINT* axes, UINT axisCount, const char* name)
+            {
+                return std::find(axes, axes + axisCount, 0u) == axes + axisCount || requireAxis(0, name);
+            };
 
-        detail::NodeOutput* const inputs[] = { input.Impl() };
-        detail::NodeID node = builder->CreateOperatorNode(DML_OPERATOR_RESAMPLE_GRAD, &desc, inputs);
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(outputTensor));
+            auto requireShared = [&](size_t inputIndex, const char* name)
+            {
+                if (inputIndex < batchedInputs.size() && batchedInputs[inputIndex])
+                {
+                    error = std::string("computes its ") + name + " from the batched inputs";
+                    return false;
+                }
+                return true;
+            };
 
-        return output;
-    }
+            auto broadcastShared = [&]()
+            {
+                for (size_t i = 0; i < batchedInputs.size(); ++i)
+                {
+                    broadcastInputs[i] = !batchedInputs[i];
+                }
+                return true;
+            };
 
-    // 
-    // TODO: SliceGrad
-    // 
+            switch (desc.GetType())
+            {
+            case DML_OPERATOR_CONVOLUTION:
+                return requireShared(1, "filter") && requireShared(2, "bias");
 
-    // 
-    // TODO: AdamOptimizer
-    // 
+            case DML_OPERATOR_GEMM:
+            {
+                // Beyond two dimensions, GEMM multiplies a batch of matrices. A matrix has no leading dimension to
+                // spare, though, so the batch must be folded into the rows of A, and B must be shared.
+                auto& gemm = *desc.As<DML_GEMM_OPERATOR_DESC>();
+                if (GetTensorSizes(tensors.inputTensors[0]).size() > 2)
+                {
+                    return broadcastShared();
+                }
+                if (!batchedInputs[0] || gemm.TransA != DML_MATRIX_TRANSFORM_NONE)
+                {
+                    error = "is a 2D GEMM whose batch isn't in the rows of A";
+                    return false;
+                }
+                if (!requireShared(1, "B tensor"))
+                {
+                    return false;
+                }
+                broadcastInputs[2] = batchedInputs.size() > 2 && !batchedInputs[2];
+                return true;
+            }
 
-    // 
-    // TODO: Argmin
-    // 
+            case DML_OPERATOR_REDUCE:
+            {
+                auto& reduce = *desc.As<DML_REDUCE_OPERATOR_DESC>();
+                return requireAxes(reduce.Axes, reduce.AxisCount, "reduces");
+            }
 
-    // 
-    // TODO: Argmax
-    // 
+            case DML_OPERATOR_MEAN_VARIANCE_NORMALIZATION1:
+            {
+                auto& mvn = *desc.As<DML_MEAN_VARIANCE_NORMALIZATION1_OPERATOR_DESC>();
+                return requireAxes(mvn.Axes, mvn.AxisCount, "normalizes");
+            }
 
-    // 
-    // TODO: ROIAlign
-    // 
+            case DML_OPERATOR_SLICE1:
+            {
+                // The window must cover the whole leading dimension, and is widened to the whole batch
+                auto& slice = *desc.As<DML_SLICE1_OPERATOR_DESC>();
+                const uint32_t leadingSize = GetTensorSizes(slice.InputTensor)[0];
+                if (slice.InputWindowOffsets[0] != 0 || slice.InputWindowSizes[0] != leadingSize ||
+                    (slice.InputWindowStrides[0] != 1 && leadingSize != 1))
+                {
+                    return requireAxis(0, "slices");
+                }
 
-    // Reinterprets the memory of a tensor with a different type and dimensions (analogously to using
-    // reinterpret_cast to access raw bits). Note that this is different to the DML Cast operator, which performs
-    // a type cast on the contents of a tensor (analogously to static_cast). The total tensor size of the output
-    // (which depends on the supplied type/sizes/strides) must match the input.
-    inline Expression Reinterpret(
-        Expression input,
-        DML_TENSOR_DATA_TYPE newType,
-        TensorDimensions newSizes,
-        Optional<TensorDimensions> newStrides)
-    {
-        detail::GraphBuilder* builder = input.Impl()->GetGraphBuilder();
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
-        TensorDesc newTensor(
-            newType,
-            inputTensor.flags,
-            std::move(newSizes),
-            std::move(newStrides),
-            inputTensor.totalTensorSizeInBytes,
-            inputTensor.guaranteedBaseOffsetAlignment);
+                UINT* windowSizes = desc.Allocate<UINT>(slice.DimensionCount);
+                std::copy(slice.InputWindowSizes, slice.InputWindowSizes + slice.DimensionCount, windowSizes);
+                windowSizes[0] *= batchSize;
+                slice.InputWindowSizes = windowSizes;
 
-        detail::NodeID node = builder->CreateReinterpretNode(input.Impl());
-        detail::NodeOutput* output = builder->CreateNodeOutput(node, 0, std::move(newTensor));
+                INT* windowStrides = desc.Allocate<INT>(slice.DimensionCount);
+                std::copy(slice.InputWindowStrides, slice.InputWindowStrides + slice.DimensionCount, windowStrides);
+                windowStrides[0] = 1;
+                slice.InputWindowStrides = windowStrides;
+                return true;
+            }
 
-        return output;
-    }
+            case DML_OPERATOR_PADDING:
+            {
+                auto& padding = *desc.As<DML_PADDING_OPERATOR_DESC>();
+                return (padding.StartPadding[0] == 0 && padding.EndPadding[0] == 0) || requireAxis(0, "pads");
+            }
 
-    // Same as Reinterpret above, but only adjusts tensor dimensions without affecting type.
-    inline Expression Reinterpret(
-        Expression input,
-        TensorDimensions newSizes,
-        Optional<TensorDimensions> newStrides)
-    {
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+            case DML_OPERATOR_TILE:
+            {
+                auto& tile = *desc.As<DML_TILE_OPERATOR_DESC>();
+                return tile.Repeats[0] == 1 || requireAxis(0, "tiles");
+            }
 
-        return Reinterpret(input, inputTensor.dataType, std::move(newSizes), std::move(newStrides));
-    }
+            case DML_OPERATOR_SPLIT:
+                return requireAxis(desc.As<DML_SPLIT_OPERATOR_DESC>()->Axis, "splits");
 
-    // Same as Reinterpret above, but only adjusts tensor type without affecting sizes or strides.
-    inline Expression Reinterpret(Expression input, DML_TENSOR_DATA_TYPE newType)
-    {
-        TensorDesc inputTensor = input.Impl()->GetOutputDesc();
+            case DML_OPERATOR_JOIN:
+                return requireAxis(desc.As<DML_JOIN_OPERATOR_DESC>()->Axis, "joins") && broadcastShared();
 
-        return Reinterpret(input, newType, inputTensor.sizes, inputTensor.strides);
-    }
+            case DML_OPERATOR_GATHER:
+                return requireAxis(desc.As<DML_GATHER_OPERATOR_DESC>()->Axis, "gathers") && requireShared(1, "indices");
 
-    // Operator overloads for convenience, which merely map to one of the functions above
-    inline Expression operator+(Expression a, Expression b) { return dml::Add(a, b); }
-    inline Expression operator-(Expression a, Expression b) { return dml::Subtract(a, b); }
-    inline Expression operator*(Expression a, Expression b) { return dml::Multiply(a, b); }
-    inline Expression operator/(Expression a, Expression b) { return dml::Divide(a, b); }
-    inline Expression operator%(Expression a, Expression b) { return dml::ModulusTruncate(a, b); }
-    inline Expression operator&(Expression a, Expression b) { return dml::BitAnd(a, b); }
-    inline Expression operator|(Expression a, Expression b) { return dml::BitOr(a, b); }
-    inline Expression operator^(Expression a, Expression b) { return dml::BitXor(a, b); }
-    inline Expression operator<<(Expression a, Expression b) { return dml::BitShiftLeft(a, b); }
-    inline Expression operator>>(Expression a, Expression b) { return dml::BitShiftRight(a, b); }
-    inline Expression& operator+=(Expression& a, Expression b) { a = a + b; return a; }
-    inline Expression& operator-=(Expression& a, Expression b) { a = a - b; return a; }
-    inline Expression& operator*=(Expression& a, Expression b) { a = a * b; return a; }
-    inline Expression& operator/=(Expression& a, Expression b) { a = a / b; return a; }
-    inline Expression& operator%=(Expression& a, Expression b) { a = a % b; return a; }
-    inline Expression& operator&=(Expression& a, Expression b) { a = a & b; return a; }
-    inline Expression& operator|=(Expression& a, Expression b) { a = a | b; return a; }
-    inline Expression& operator^=(Expression& a, Expression b) { a = a ^ b; return a; }
-    inline Expression& operator<<=(Expression& a, Expression b) { a = a << b; return a; }
-    inline Expression& operator>>=(Expression& a, Expression b) { a = a >> b; return a; }
+            case DML_OPERATOR_GATHER_ELEMENTS:
+                return requireAxis(desc.As<DML_GATHER_ELEMENTS_OPERATOR_DESC>()->Axis, "gathers") && broadcastShared();
 
-    // Operations involving scalars can be reduced to elementwise identity
-    inline Expression operator+(Expression a, float b) { return dml::Identity(a, DML_SCALE_BIAS{ 1.0f, b }); }
-    inline Expression operator-(Expression a, float b) { return dml::Identity(a, DML_SCALE_BIAS{ 1.0f, -b }); }
-    inline Expression operator*(Expression a, float b) { return dml::Identity(a, DML_SCALE_BIAS{ b, 0.0f }); }
-    inline Expression operator/(Expression a, float b) { return dml::Identity(a, DML_SCALE_BIAS{ 1.0f / b, 0.0f }); }
-    inline Expression operator+(float a, Expression b) { return dml::Identity(b, DML_SCALE_BIAS{ 1.0f, a }); }
-    inline Expression operator-(float a, Expression b) { return dml::Identity(b, DML_SCALE_BIAS{ -1.0f, a }); }
-    inline Expression operator*(float a, Expression b) { return dml::Identity(b, DML_SCALE_BIAS{ a, 0.0f }); }
-    inline Expression operator/(float a, Expression b) { return dml::Recip(b, DML_SCALE_BIAS{ a, 0.0f }); }
-    inline Expression& operator+=(Expression& a, float b) { a = a + b; return a; }
-    inline Expression& operator-=(Expression& a, float b) { a = a - b; return a; }
-    inline Expression& operator*=(Expression& a, float b) { a = a * b; return a; }
-    inline Expression& operator/=(Expression& a, float b) { a = a / b; return a; }
+            case DML_OPERATOR_SCATTER_ELEMENTS:
+                return requireAxis(desc.As<DML_SCATTER_ELEMENTS_OPERATOR_DESC>()->Axis, "scatters") && broadcastShared();
 
-    // Unary
-    inline Expression operator~(Expression input) { return dml::BitNot(input); }
-    inline Expression operator+(Expression input) { return dml::Identity(input); }
-    inline Expression operator-(Expression input) { return dml::Identity(input, DML_SCALE_BIAS{ -1.0f, 0.0f }); }
+            case DML_OPERATOR_REVERSE_SUBSEQUENCES:
+                return requireAxis(desc.As<DML_REVERSE_SUBSEQUENCES_OPERATOR_DESC>()->Axis, "reverses") &&
+                    broadcastShared();
 
-    // Logical
-    inline Expression operator!(Expression a) { return dml::LogicalNot(a); }
-    inline Expression operator&&(Expression a, Expression b) { return dml::LogicalAnd(a, b); }
-    inline Expression operator||(Expression a, Expression b) { return dml::LogicalOr(a, b); }
-    inline Expression operator>(Expression a, Expression b) { return dml::GreaterThan(a, b); }
-    inline Expression operator<(Expression a, Expression b) { return dml::LessThan(a, b); }
-    inline Expression operator==(Expression a, Expression b) { return dml::Equals(a, b); }
-    inline Expression operator!=(Expression a, Expression b) { return !(a == b); }
-    inline Expression operator>=(Expression a, Expression b) { return dml::GreaterThanOrEqual(a, b); }
-    inline Expression operator<=(Expression a, Expression b) { return dml::LessThanOrEqual(a, b); }
+            case DML_OPERATOR_ONE_HOT:
+                return requireAxis(desc.As<DML_ONE_HOT_OPERATOR_DESC>()->Axis, "encodes") && requireShared(1, "values");
 
-    // GraphBuilder implementation details
-    namespace detail
-    {
-        inline NodeID GraphBuilder::CreateOperatorNode(
-            DML_OPERATOR_TYPE type,
-            const void* desc,
-            Span<NodeOutput* const> inputs)
-        {
-            DML_OPERATOR_DESC opDesc = { type, desc };
+            case DML_OPERATOR_RESAMPLE1:
+            case DML_OPERATOR_RESAMPLE_GRAD:
+            {
+                // The two descs have the same layout after their tensors
+                const FLOAT* scales = desc.GetType() == DML_OPERATOR_RESAMPLE1
+                    ? desc.As<DML_RESAMPLE1_OPERATOR_DESC>()->Scales
+                    : desc.As<DML_RESAMPLE_GRAD_OPERATOR_DESC>()->Scales;
+                return scales[0] == 1.0f || requireAxis(0, "resamples");
+            }
 
-            Microsoft::WRL::ComPtr<IDMLOperator> op;
-            DMLX_THROW_IF_FAILED(m_device->CreateOperator(&opDesc, IID_PPV_ARGS(&op)));
+            case DML_OPERATOR_ACTIVATION_SOFTMAX:
+            case DML_OPERATOR_ACTIVATION_LOG_SOFTMAX:
+            case DML_OPERATOR_ACTIVATION_HARDMAX:
+                return GetTensorSizes(tensors.inputTensors[0]).size() > 1 || requireAxis(0, "normalizes");
+
+            case DML_OPERATOR_BATCH_NORMALIZATION:
+            case DML_OPERATOR_AVERAGE_POOLING:
+            case DML_OPERATOR_MAX_POOLING2:
+            case DML_OPERATOR_LOCAL_RESPONSE_NORMALIZATION:
+            case DML_OPERATOR_VALUE_SCALE_2D:
+            case DML_OPERATOR_UPSAMPLE_2D:
+                return true;
 
-            OperatorNode node = {};
-            node.op = std::move(op);
-            node.inputs.assign(inputs.begin(), inputs.end());
+            case DML_OPERATOR_GRU:
+                error = "is a recurrent operator, whose batch isn't in the leading dimension";
+                return false;
 
-            uint32_t index = static_cast<uint32_t>(m_operatorNodes.size());
-            m_operatorNodes.push_back(std::move(node));
+            case DML_OPERATOR_SCATTER_ND:
+                error = "scatters with indices that address the leading dimension, which holds the batch";
+                return false;
 
-            return { NodeType::Operator, index };
-        }
+            case DML_OPERATOR_FILL_VALUE_CONSTANT:
+            case DML_OPERATOR_FILL_VALUE_SEQUENCE:
+            case DML_OPERATOR_RANDOM_GENERATOR:
+                error = "generates values that can't be batched";
+                return false;
 
-        inline NodeID GraphBuilder::CreateInputNode(uint32_t inputIndex)
-        {
-            uint32_t index = static_cast<uint32_t>(m_inputNodes.size());
-            m_inputNodes.push_back(InputNode{ inputIndex });
-            return { NodeType::Input, index };
+            default:
+                // Element-wise operators and activations, whose inputs have the same sizes as their output
+                return broadcastShared();
+            }
         }
 
-        inline NodeID GraphBuilder::CreateReinterpretNode(NodeOutput* input)
+        inline std::vector<GraphDiagnostic> GraphBuilder::Rebatch(
+            const GraphBuilder& source,
+            Span<const Expression> outputs,
+            uint32_t batchSize,
+            Span<const uint32_t> batchedInputs,
+            std::vector<NodeOutput*>& rebatchedOutputs)
         {
-            uint32_t index = static_cast<uint32_t>(m_reinterpretNodes.size());
-            m_reinterpretNodes.push_back(ReinterpretNode{ input });
-            return { NodeType::Reinterpret, index };
-        }
+            // Node indices are copied from the source, so they're only meaningful in an empty builder
+            if (!m_inputNodes.empty() || !m_operatorNodes.empty() || !m_reinterpretNodes.empty() ||
+                !m_nodeOutputs.empty() || batchSize == 0)
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
 
-        inline NodeOutput* GraphBuilder::CreateNodeOutput(NodeID node, uint32_t outputIndex, TensorDesc tensorDesc)
-        {
-            // Construct the object in the deque, which doesn't invalidate references to elements as it grows
-            m_nodeOutputs.emplace_back(this, node, outputIndex, std::move(tensorDesc));
+            rebatchedOutputs.clear();
+            std::vector<GraphDiagnostic> diagnostics;
+            auto report = [&](uint32_t nodeIndex, std::string message)
+            {
+                DML_OPERATOR_TYPE type = DML_OPERATOR_INVALID;
+                if (nodeIndex < source.m_operatorNodes.size() && source.m_operatorNodes[nodeIndex].desc.IsValid())
+                {
+                    type = source.m_operatorNodes[nodeIndex].desc.GetType();
+                }
+                diagnostics.push_back(GraphDiagnostic{ nodeIndex, type, std::move(message) });
+            };
 
-            return &m_nodeOutputs.back();
-        }
+            // The rebatched desc of each node output that the outputs depend on, and whether it carries the batch. A
+            // node output that can't be rebatched is marked as failed, and isn't reported again by its consumers.
+            struct RebatchedTensor
+            {
+                TensorDesc desc;
+                bool batched = false;
+                bool failed = false;
+            };
+            std::unordered_map<const NodeOutput*, RebatchedTensor> tensors;
+
+            // By default, every input the caller binds whose leading dimension is 1 carries the batch
+            std::unordered_set<uint32_t> batchedInputIndices(batchedInputs.begin(), batchedInputs.end());
+            for (const NodeOutput* output : source.m_nodeOutputs)
+            {
+                const NodeID node = output->GetNode();
+                if (node.type != NodeType::Input)
+                {
+                    continue;
+                }
 
-        inline GraphDesc GraphBuilder::GetGraphDesc(Span<const Expression> outputs) const
-        {
-            GraphDesc desc = {};
-            desc.inputCount = static_cast<uint32_t>(m_inputNodes.size());
-            desc.outputCount = static_cast<uint32_t>(outputs.size());
+                const uint32_t inputIndex = source.m_inputNodes[node.index].inputIndex;
+                const TensorDesc& tensor = output->GetOutputDesc();
+                RebatchedTensor& rebatched = tensors[output];
+                rebatched.desc = tensor;
+                rebatched.batched = batchedInputs.empty()
+                    ? !source.GetConstantInputData(inputIndex) && !tensor.sizes.empty() && tensor.sizes[0] == 1
+                    : batchedInputIndices.erase(inputIndex) != 0;
 
-            for (const OperatorNode& node : m_operatorNodes)
+                std::string error;
+                if (rebatched.batched && (tensor.sizes.empty() || tensor.sizes[0] != 1))
+                {
+                    report(UINT32_MAX, "graph input " + std::to_string(inputIndex) + " has sizes " +
+                        FormatSizes(tensor.sizes) + ", whose leading dimension isn't a batch of 1");
+                    rebatched.failed = true;
+                }
+                else if (rebatched.batched && !RebatchTensor(tensor, batchSize, rebatched.desc, error))
+                {
+                    report(UINT32_MAX, "graph input " + std::to_string(inputIndex) + " " + error);
+                    rebatched.failed = true;
+                }
+            }
+
+            for (uint32_t inputIndex : batchedInputIndices)
             {
-                uint32_t nodeIndex = static_cast<uint32_t>(desc.nodes.size());
-                desc.nodes.push_back(DML_OPERATOR_GRAPH_NODE_DESC{ node.op.Get() });
+                report(UINT32_MAX, "graph input " + std::to_string(inputIndex) + " doesn't exist");
+            }
 
-                // Walk through each of this node's inputs and add it as an edge
-                const uint32_t inputCount = static_cast<uint32_t>(node.inputs.size());
-                for (uint32_t inputIndex = 0; inputIndex < inputCount; ++inputIndex)
+            // Reinterpreted tensors are rebatched when they're first read, walking up the chain to a tensor that's
+            // already been rebatched. Problems are reported against the reader.
+            auto getTensor = [&](const NodeOutput* output, uint32_t nodeIndex, const std::string& name)
+                -> const RebatchedTensor&
+            {
+                std::vector<const NodeOutput*> chain;
+                auto found = tensors.find(output);
+                while (found == tensors.end())
                 {
-                    NodeOutput* input = node.inputs[inputIndex];
-                    if (input == nullptr)
+                    assert(output->GetNode().type == NodeType::Reinterpret);
+                    chain.push_back(output);
+                    output = source.m_reinterpretNodes[output->GetNode().index].input;
+                    found = tensors.find(output);
+                }
+
+                while (!chain.empty())
+                {
+                    const RebatchedTensor& input = found->second;
+                    const NodeOutput* view = chain.back();
+                    chain.pop_back();
+
+                    RebatchedTensor rebatched;
+                    rebatched.desc = view->GetOutputDesc();
+                    rebatched.batched = input.batched;
+                    rebatched.failed = input.failed;
+
+                    std::string error;
+                    if (input.batched && !input.failed && !RebatchView(
+                        view->GetOutputDesc(), output->GetOutputDesc(), input.desc, batchSize, rebatched.desc, error))
                     {
-                        continue;
+                        report(nodeIndex, name + " " + error);
+                        rebatched.failed = true;
                     }
-                    NodeID inputNode = input->GetNode();
 
-                    // Reinterpret nodes aren't "real" nodes, they're just used to modify TensorDescs across
-                    // edges. So we follow this node backwards until it hits a real node.
-                    while (inputNode.type == NodeType::Reinterpret)
+                    output = view;
+                    found = tensors.emplace(view, std::move(rebatched)).first;
+                }
+
+                return found->second;
+            };
+
+            std::vector<std::vector<const NodeOutput*>> operatorOutputs(source.m_operatorNodes.size());
+            for (const NodeOutput* output : source.m_nodeOutputs)
+            {
+                if (output->GetNode().type == NodeType::Operator)
+                {
+                    operatorOutputs[output->GetNode().index].push_back(output);
+                }
+            }
+
+            // Operators are visited in execution order, so their inputs have always been rebatched first. Only the
+            // descs of operators that read the batch are rewritten.
+            const std::vector<bool> reachable = source.FindReachableOperatorNodes(outputs);
+            std::vector<OwnedOperatorDesc> rebatchedDescs(source.m_operatorNodes.size());
+            for (uint32_t i = 0; i < static_cast<uint32_t>(source.m_operatorNodes.size()); ++i)
+            {
+                if (!reachable[i])
+                {
+                    continue;
+                }
+
+                const OperatorNode& node = source.m_operatorNodes[i];
+                std::vector<const RebatchedTensor*> inputs(node.inputs.size(), nullptr);
+                bool anyBatched = false;
+                bool anyFailed = false;
+                for (size_t j = 0; j < node.inputs.size(); ++j)
+                {
+                    if (node.inputs[j])
                     {
-                        input = m_reinterpretNodes[inputNode.index].input;
-                        inputNode = input->GetNode();
+                        inputs[j] = &getTensor(node.inputs[j], i, "input " + std::to_string(j));
+                        anyBatched = anyBatched || inputs[j]->batched;
+                        anyFailed = anyFailed || inputs[j]->failed;
                     }
+                }
 
-                    if (inputNode.type == NodeType::Input)
+                bool failed = anyFailed;
+                if (anyBatched && !failed && !node.desc.IsValid())
+                {
+                    report(i, "was created directly on the device, so it can't be rebatched");
+                    failed = true;
+                }
+                else if (anyBatched && !failed)
+                {
+                    std::string error;
+                    OwnedOperatorDesc desc(node.desc.GetType(), node.desc.Get()->Desc, &m_arena);
+                    const OperatorDescTensors descTensors = OperatorDescTensors::Get(desc);
+                    std::vector<bool> batched(descTensors.inputTensors.size(), false);
+                    std::vector<bool> broadcast;
+                    for (size_t j = 0; j < inputs.size() && j < batched.size(); ++j)
                     {
-                        DML_INPUT_GRAPH_EDGE_DESC inputEdge = {};
-                        inputEdge.GraphInputIndex = m_inputNodes[inputNode.index].inputIndex;
-                        inputEdge.ToNodeIndex = nodeIndex;
-                        inputEdge.ToNodeInputIndex = inputIndex;
-
-                        desc.inputEdges.push_back(inputEdge);
+                        batched[j] = inputs[j] && inputs[j]->batched;
                     }
-                    else if (inputNode.type == NodeType::Operator)
-                    {
-                        DML_INTERMEDIATE_GRAPH_EDGE_DESC intermediateEdge = {};
-                        intermediateEdge.FromNodeIndex = inputNode.index;
-                        intermediateEdge.FromNodeOutputIndex = input->GetOutputIndex();
-                        intermediateEdge.ToNodeIndex = nodeIndex;
-                        intermediateEdge.ToNodeInputIndex = inputIndex;
 
-                        desc.intermediateEdges.push_back(intermediateEdge);
+                    if (!RebatchOperatorDesc(desc, batched, batchSize, broadcast, error))
+                    {
+                        report(i, error);
+                        failed = true;
                     }
                     else
                     {
-                        assert(false); // Invalid node type
-                        DMLX_THROW(E_UNEXPECTED);
+                        for (size_t k = 0; !failed && k < descTensors.outputTensors.size(); ++k)
+                        {
+                            TensorDesc outputTensor;
+                            if (descTensors.outputTensors[k] &&
+                                !RebatchTensor(TensorDesc(*descTensors.outputTensors[k]), batchSize, outputTensor, error))
+                            {
+                                report(i, "output " + std::to_string(k) + " " + error);
+                                failed = true;
+                            }
+                            else if (descTensors.outputTensors[k])
+                            {
+                                *descTensors.outputTensors[k] = *desc.CopyTensor(outputTensor.AsPtr<DML_TENSOR_DESC>());
+                            }
+                        }
+
+                        // Shared inputs are broadcast to the leading dimension of the output
+                        const uint32_t leadingSize = descTensors.outputTensors.empty() || !descTensors.outputTensors[0]
+                            ? batchSize
+                            : GetTensorSizes(descTensors.outputTensors[0])[0];
+
+                        for (size_t j = 0; !failed && j < descTensors.inputTensors.size(); ++j)
+                        {
+                            if (!descTensors.inputTensors[j] || (!batched[j] && !broadcast[j]))
+                            {
+                                continue;
+                            }
+
+                            const TensorDesc inputTensor(*descTensors.inputTensors[j]);
+                            TensorDesc rebatchedInput;
+                            if (batched[j])
+                            {
+                                failed = !RebatchView(
+                                    inputTensor,
+                                    node.inputs[j]->GetOutputDesc(),
+                                    inputs[j]->desc,
+                                    batchSize,
+                                    rebatchedInput,
+                                    error);
+                            }
+                            else if (inputTensor.sizes[0] == 1)
+                            {
+                                TensorDimensions sizes = inputTensor.sizes;
+                                sizes[0] = leadingSize;
+                                rebatchedInput = BroadcastTensor(inputTensor, sizes);
+                            }
+                            else
+                            {
+                                error = "is shared by every item of the batch, but has sizes " +
+                                    FormatSizes(inputTensor.sizes) + ", which can't be broadcast to them";
+                                failed = true;
+                            }
+
+                            if (failed)
+                            {
+                                report(i, "input " + std::to_string(j) + " " + error);
+                            }
+                            else
+                            {
+                                *descTensors.inputTensors[j] = *desc.CopyTensor(rebatchedInput.AsPtr<DML_TENSOR_DESC>());
+                            }
+                        }
+                    }
+
+                    rebatchedDescs[i] = std::move(desc);
+                }
+
+                for (const NodeOutput* output : operatorOutputs[i])
+                {
+                    RebatchedTensor& rebatched = tensors[output];
+                    rebatched.desc = output->GetOutputDesc();
+                    rebatched.batched = anyBatched;
+                    rebatched.failed = failed;
+
+                    std::string error;
+                    if (anyBatched && !failed && !RebatchTensor(output->GetOutputDesc(), batchSize, rebatched.desc, error))
+                    {
+                        report(i, "output " + std::to_string(output->GetOutputIndex()) + " " + error);
+                        rebatched.failed = true;
                     }
                 }
             }
 
-            // Add output edges
-            for (uint32_t outputIndex = 0; outputIndex < desc.outputCount; ++outputIndex)
+            for (size_t i = 0; i < outputs.size(); ++i)
             {
-                NodeOutput* output = outputs[outputIndex].Impl();
-                if (output == nullptr)
+                if (outputs[i].Impl())
                 {
-                    continue;
+                    getTensor(outputs[i].Impl(), UINT32_MAX, "graph output " + std::to_string(i));
                 }
-                NodeID outputNode = output->GetNode();
+            }
+
+            if (!diagnostics.empty())
+            {
+                Reset();
+                return diagnostics;
+            }
+
+            // Constant inputs keep their descs, so they're shared by the whole batch
+            rebatchedOutputs = CopyNodes(source, outputs, rebatchedDescs, [&](const NodeOutput* output) -> const TensorDesc&
+            {
+                auto rebatched = tensors.find(output);
+                return rebatched != tensors.end() ? rebatched->second.desc : output->GetOutputDesc();
+            });
+
+            // Shape rules the rewrite doesn't know about, e.g. of the operators that were copied as they are, are
+            // checked on the result
+            const std::vector<Expression> rebatchedExpressions(rebatchedOutputs.begin(), rebatchedOutputs.end());
+            diagnostics = Validate(rebatchedExpressions);
+            if (!diagnostics.empty())
+            {
+                Reset();
+                rebatchedOutputs.clear();
+            }
+
+            return diagnostics;
+        }
 
-                // Reinterpret nodes are meaningless on outputs (they're no-ops), so just follow them back until we
-                // get to a real operator node.
-                while (outputNode.type == NodeType::Reinterpret)
+        inline std::vector<NodeOutput*> GraphBuilder::CopyNodes(
+            const GraphBuilder& source,
+            Span<const Expression> outputs,
+            std::vector<OwnedOperatorDesc>& descs,
+            const std::function<const TensorDesc&(const NodeOutput*)>& getOutputDesc)
+        {
+            // Every node is copied, in the same order, so that node indices and input indices match the source
+            m_inputNodes = source.m_inputNodes;
+            m_constantInputData = source.m_constantInputData;
+            if (m_device == source.m_device)
+            {
+                m_operatorCache = source.m_operatorCache;
+            }
+
+            m_operatorNodes.resize(source.m_operatorNodes.size());
+            for (size_t i = 0; i < m_operatorNodes.size(); ++i)
+            {
+                const OperatorNode& sourceNode = source.m_operatorNodes[i];
+                OperatorNode& node = m_operatorNodes[i];
+                if (i < descs.size() && descs[i].IsValid())
+                {
+                    node.desc = std::move(descs[i]);
+                }
+                else if (sourceNode.desc.IsValid())
+                {
+                    // The operator comes from the operator cache when it's needed
+                    node.desc = OwnedOperatorDesc(sourceNode.desc.GetType(), sourceNode.desc.Get()->Desc, &m_arena);
+                }
+                else
                 {
-                    output = m_reinterpretNodes[outputNode.index].input;
-                    outputNode = output->GetNode();
+                    // Operators without a schema were created with the node, and can only be shared
+                    node.op = sourceNode.op;
                 }
+                node.inputs = AllocateInputs(sourceNode.inputs.size());
+                node.name = sourceNode.name ? CopyName(sourceNode.name) : nullptr;
+            }
 
-                if (outputNode.type == NodeType::Input)
+            std::unordered_map<const NodeOutput*, NodeOutput*> nodeOutputs;
+            for (const NodeOutput* output : source.m_nodeOutputs)
+            {
+                nodeOutputs[output] = ConstructNodeOutput(output->GetNode(), output->GetOutputIndex(), getOutputDesc(output));
+            }
+
+            auto getNodeOutput = [&](const NodeOutput* output) { return output ? nodeOutputs.at(output) : nullptr; };
+
+            for (size_t i = 0; i < m_operatorNodes.size(); ++i)
+            {
+                const Span<NodeOutput*> sourceInputs = source.m_operatorNodes[i].inputs;
+                std::transform(sourceInputs.begin(), sourceInputs.end(), m_operatorNodes[i].inputs.begin(), getNodeOutput);
+            }
+
+            // Reinterpret nodes only ever refer to earlier nodes, so roots can be resolved in order
+            m_reinterpretNodes.resize(source.m_reinterpretNodes.size());
+            for (size_t i = 0; i < m_reinterpretNodes.size(); ++i)
+            {
+                m_reinterpretNodes[i].input = getNodeOutput(source.m_reinterpretNodes[i].input);
+                m_reinterpretNodes[i].root = ResolveReinterprets(m_reinterpretNodes[i].input);
+                m_reinterpretNodes[i].isView = source.m_reinterpretNodes[i].isView;
+            }
+
+            std::vector<NodeOutput*> copiedOutputs;
+            for (const Expression& output : outputs)
+            {
+                copiedOutputs.push_back(getNodeOutput(output.Impl()));
+            }
+            return copiedOutputs;
+        }
+
+        inline std::shared_ptr<GraphBuilder> GraphBuilder::CopyForCompile(
+            Span<const Expression> outputs,
+            GraphDesc& graph) const
+        {
+            auto copy = std::make_shared<GraphBuilder>(m_device.Get(), m_tensorPolicy);
+            copy->m_optimizations = m_optimizations;
+            copy->m_mixedPrecisionPolicy = m_mixedPrecisionPolicy;
+            copy->m_statistics.mergedNodeCount = m_statistics.mergedNodeCount;
+
+            std::vector<OwnedOperatorDesc> descs;
+            std::vector<NodeOutput*> copiedOutputs = copy->CopyNodes(*this, outputs, descs, [](const NodeOutput* output) -> const TensorDesc&
+            {
+                return output->GetOutputDesc();
+            });
+
+            for (uint32_t i = 0; i < static_cast<uint32_t>(copy->m_operatorNodes.size()); ++i)
+            {
+                copy->m_operatorNodes[i].sourceIndex = i;
+            }
+
+            const std::vector<Expression> copiedExpressions(copiedOutputs.begin(), copiedOutputs.end());
+            const std::vector<Expression> graphOutputs = copy->MaterializeViews(copiedExpressions);
+            copy->Optimize(graphOutputs);
+
+            graph = copy->GetGraphDesc(graphOutputs);
+            copy->m_statistics.prunedNodeCount = graph.prunedNodeCount;
+            return copy;
+        }
+
+        inline void GraphBuilder::MoveOperatorNodes(const std::vector<std::pair<uint32_t, uint32_t>>& moves)
+        {
+            const uint32_t nodeCount = static_cast<uint32_t>(m_operatorNodes.size());
+            std::vector<bool> moved(nodeCount, false);
+            for (const auto& move : moves)
+            {
+                moved[move.first] = true;
+            }
+
+            std::vector<uint32_t> newIndices(nodeCount);
+            std::vector<OperatorNode> nodes;
+            nodes.reserve(nodeCount);
+            size_t nextMove = 0;
+            for (uint32_t i = 0; i < nodeCount; ++i)
+            {
+                for (; nextMove < moves.size() && moves[nextMove].second == i; ++nextMove)
                 {
-                    // It's not valid to connect an output of the graph directly to an input without an intervening
-                    // node. If this behavior is desired, it should instead be accomplished with a copy e.g. using
-                    // the elementwise identity operator.
-                    DMLX_THROW(E_INVALIDARG);
+                    newIndices[moves[nextMove].first] = static_cast<uint32_t>(nodes.size());
+                    nodes.push_back(std::move(m_operatorNodes[moves[nextMove].first]));
                 }
+                if (!moved[i])
+                {
+                    newIndices[i] = static_cast<uint32_t>(nodes.size());
+                    nodes.push_back(std::move(m_operatorNodes[i]));
+                }
+            }
+            assert(nodes.size() == nodeCount);
+            m_operatorNodes = std::move(nodes);
 
-                assert(outputNode.type == NodeType::Operator);
+            // Everything else refers to operator nodes through node outputs
+            for (NodeOutput* output : m_nodeOutputs)
+            {
+                if (output->m_node.type == NodeType::Operator)
+                {
+                    output->m_node.index = newIndices[output->m_node.index];
+                }
+            }
+            for (auto& entry : m_operatorNodeLookup)
+            {
+                entry.second = newIndices[entry.second];
+            }
 
-                DML_OUTPUT_GRAPH_EDGE_DESC outputEdge = {};
-                outputEdge.FromNodeIndex = output->GetNode().index;
-                outputEdge.FromNodeOutputIndex = output->GetOutputIndex();
-                outputEdge.GraphOutputIndex = outputIndex;
+            // Keys of operator outputs contain the node index
+            std::unordered_map<std::string, NodeOutput*> nodeOutputLookup;
+            nodeOutputLookup.reserve(m_nodeOutputLookup.size());
+            for (auto& entry : m_nodeOutputLookup)
+            {
+                NodeOutput* output = entry.second;
+                if (output->m_node.type == NodeType::Operator)
+                {
+                    nodeOutputLookup.emplace(GetNodeOutputKey(output->m_node, output->m_outputIndex, output->m_tensorDesc), output);
+                }
+                else
+                {
+                    nodeOutputLookup.emplace(entry.first, output);
+                }
+            }
+            m_nodeOutputLookup = std::move(nodeOutputLookup);
+        }
 
-                desc.outputEdges.push_back(outputEdge);
+        // Operators in a cost report, in report order, and the totals per operator type.
+        struct CostReport
+        {
+            struct TypeTotal : CostEstimate
+            {
+                DML_OPERATOR_TYPE operatorType;
+                uint32_t operatorCount = 0;
+            };
+
+            std::vector<const OperatorCost*> operators;
+            std::vector<TypeTotal> types;
+        };
+
+        inline CostReport BuildCostReport(const GraphCost& cost, const RooflineModel& model)
+        {
+            auto before = [&](const CostEstimate& a, const CostEstimate& b)
+            {
+                if (model.IsValid() && a.GetEstimatedSeconds(model) != b.GetEstimatedSeconds(model))
+                {
+                    return a.GetEstimatedSeconds(model) > b.GetEstimatedSeconds(model);
+                }
+                if (a.GetBytesMoved() != b.GetBytesMoved())
+                {
+                    return a.GetBytesMoved() > b.GetBytesMoved();
+                }
+                return a.flopCount > b.flopCount;
+            };
+
+            CostReport report;
+            std::unordered_map<uint32_t, size_t> typeIndices;
+            for (const OperatorCost& operatorCost : cost.operators)
+            {
+                report.operators.push_back(&operatorCost);
+
+                auto inserted = typeIndices.emplace(operatorCost.operatorType, report.types.size());
+                if (inserted.second)
+                {
+                    report.types.emplace_back();
+                    report.types.back().operatorType = operatorCost.operatorType;
+                }
+                CostReport::TypeTotal& typeTotal = report.types[inserted.first->second];
+                typeTotal += operatorCost;
+                ++typeTotal.operatorCount;
             }
 
-            // Sanity
-            assert(desc.nodes.size() == m_operatorNodes.size());
-            assert(desc.outputEdges.size() == desc.outputCount);
-            assert(desc.outputCount == outputs.size());
+            std::stable_sort(report.operators.begin(), report.operators.end(),
+                [&](const OperatorCost* a, const OperatorCost* b) { return before(*a, *b); });
+            std::stable_sort(report.types.begin(), report.types.end(), before);
+            return report;
+        }
 
-            return desc;
+        inline std::string FormatCostLine(std::string label, const CostEstimate& cost, const RooflineModel& model)
+        {
+            // Long labels (e.g. deeply scoped names) push the columns right rather than being cut off
+            label.resize(std::max<size_t>(label.size(), 40), ' ');
+
+            char line[128];
+            int length = snprintf(line, sizeof(line), " %12.4f %12.3f %12.3f %10.2f",
+                cost.flopCount * 1e-9,
+                cost.bytesRead / 1048576.0,
+                cost.bytesWritten / 1048576.0,
+                cost.GetArithmeticIntensity());
+
+            if (model.IsValid() && length > 0 && length < static_cast<int>(sizeof(line)))
+            {
+                snprintf(line + length, sizeof(line) - length, " %12.2f  %s",
+                    cost.GetEstimatedSeconds(model) * 1e6,
+                    cost.IsMemoryBound(model) ? "memory" : "compute");
+            }
+            return label + line + "\n";
+        }
+
+        inline std::string FormatCostJson(const CostEstimate& cost, const RooflineModel& model)
+        {
+            char text[256];
+            int length = snprintf(text, sizeof(text),
+                "\"flops\":%llu,\"bytesRead\":%llu,\"bytesWritten\":%llu,\"arithmeticIntensity\":%.6g",
+                static_cast<unsigned long long>(cost.flopCount),
+                static_cast<unsigned long long>(cost.bytesRead),
+                static_cast<unsigned long long>(cost.bytesWritten),
+                cost.GetArithmeticIntensity());
+
+            if (model.IsValid() && length > 0 && length < static_cast<int>(sizeof(text)))
+            {
+                snprintf(text + length, sizeof(text) - length, ",\"estimatedSeconds\":%.6g,\"bound\":\"%s\"",
+                    cost.GetEstimatedSeconds(model),
+                    cost.IsMemoryBound(model) ? "memory" : "compute");
+            }
+            return text;
         }
     } // namespace detail
 
+    inline std::string GraphCost::FormatText(const RooflineModel& model) const
+    {
+        const detail::CostReport report = detail::BuildCostReport(*this, model);
+
+        std::string header = "                                                GFLOP      MiB read  MiB written  FLOP/byte";
+        if (model.IsValid())
+        {
+            header += "     time(us)  bound";
+        }
+        header += "\n";
+
+        std::string text = header;
+        text += detail::FormatCostLine("total (" + std::to_string(operators.size()) + " operators)", total, model);
+
+        text += "\nBy operator type:\n" + header;
+        for (const detail::CostReport::TypeTotal& type : report.types)
+        {
+            const std::string label = std::string(detail::GetOperatorTypeName(type.operatorType)) +
+                " x" + std::to_string(type.operatorCount);
+            text += detail::FormatCostLine(label, type, model);
+        }
+
+        text += "\nBy operator:\n" + header;
+        for (const OperatorCost* operatorCost : report.operators)
+        {
+            std::string label = (operatorCost->nodeIndex != UINT32_MAX ? "node " + std::to_string(operatorCost->nodeIndex)
+                : std::string("added node")) + " " +
+                detail::GetOperatorTypeName(operatorCost->operatorType);
+            if (!operatorCost->name.empty())
+            {
+                label += " " + operatorCost->name;
+            }
+            text += detail::FormatCostLine(std::move(label), *operatorCost, model);
+        }
+        return text;
+    }
+
+    inline std::string GraphCost::FormatJson(const RooflineModel& model) const
+    {
+        const detail::CostReport report = detail::BuildCostReport(*this, model);
+
+        std::string text = "{\"total\":{\"operatorCount\":" + std::to_string(operators.size()) + "," +
+            detail::FormatCostJson(total, model) + "},\"operatorTypes\":[";
+        for (size_t i = 0; i < report.types.size(); ++i)
+        {
+            const detail::CostReport::TypeTotal& type = report.types[i];
+            text += std::string(i > 0 ? "," : "") + "{\"type\":\"" + detail::GetOperatorTypeName(type.operatorType) +
+                "\",\"operatorCount\":" + std::to_string(type.operatorCount) + "," + detail::FormatCostJson(type, model) + "}";
+        }
+
+        text += "],\"operators\":[";
+        for (size_t i = 0; i < report.operators.size(); ++i)
+        {
+            const OperatorCost& operatorCost = *report.operators[i];
+            text += std::string(i > 0 ? "," : "") + "{\"node\":" +
+                (operatorCost.nodeIndex != UINT32_MAX ? std::to_string(operatorCost.nodeIndex) : std::string("null")) +
+                ",\"type\":\"" + detail::GetOperatorTypeName(operatorCost.operatorType) + "\",\"name\":" +
+                detail::QuoteJsonString(operatorCost.name.c_str()) + "," + detail::FormatCostJson(operatorCost, model) + "}";
+        }
+        return text + "]}";
+    }
+
 } // namespace dml
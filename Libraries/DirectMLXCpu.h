@@ -0,0 +1,4065 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+// clang-format off
+
+#pragma once
+#include "DirectMLX.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <thread>
+#include <type_traits>
+
+// The blocked GEMM and convolution kernels and the transcendental functions use AVX2 and FMA when the compiler targets
+// them, and portable loops otherwise. Define DMLX_USE_AVX2 to 0 or 1 to override.
+#ifndef DMLX_USE_AVX2
+    #if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+        #define DMLX_USE_AVX2 1
+    #endif
+#endif
+
+#if DMLX_USE_AVX2
+    #include <immintrin.h>
+#endif
+
+/** A reference executor that runs DirectMLX graphs on the CPU, without a DirectML device.
+
+    dml::cpu::Executor takes the graph that dml::Graph::Compile would build for a set of outputs (after the graph's
+    optimizations are applied) and evaluates it on the host. Operators are evaluated in double precision and converted
+    to each output tensor's data type when stored, so results are suitable for tolerance-based comparisons against
+    DirectML. 64-bit integer tensors are only exact up to 2^53.
+
+    Tensors are read and written through their tensor descs, including strides, exactly as DirectML binds buffers:
+    graph inputs and outputs are host buffers laid out as described by the tensor descs of the operators that use
+    them. Independent operators run in parallel on a pool of worker threads, and intermediate tensors live in a
+    single buffer that is allocated once and reused by every execution.
+
+    Convolutions and GEMMs whose tensors are all FLOAT32 or FLOAT16 are instead computed in single precision by
+    cache-blocked, multithreaded kernels (dml::cpu::Convolution and dml::cpu::Gemm), which can also be called directly
+    with DirectML operator descs. Likewise, FLOAT32 and FLOAT16 exponentials, tanh, sigmoid, softplus and erf use
+    vectorized polynomial approximations (dml::cpu::Evaluate), with the errors documented on dml::cpu::MathFunction.
+
+    dml::cpu::QuantizeWeights uses the executor to measure the accuracy cost of weight quantization (see
+    dml::GraphOptimizations::WeightQuantization) on a set of calibration inputs.
+
+    Operators that were created directly on the device (operator types without a schema in DirectMLX) can't be run.
+    */
+
+namespace dml
+{
+namespace cpu
+{
+    // A fixed set of worker threads. Work is queued as tasks, and threads that wait on the pool (in RunUntil or
+    // ParallelFor) run queued tasks while they wait, so work running on the pool can itself wait on the pool.
+    class ThreadPool
+    {
+    public:
+        // threadCount includes the thread that waits on the pool. 0 uses one thread per hardware thread.
+        explicit ThreadPool(uint32_t threadCount = 0)
+        {
+            if (threadCount == 0)
+            {
+                threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+            }
+            for (uint32_t i = 1; i < threadCount; ++i)
+            {
+                m_threads.emplace_back([this] { RunUntil([this] { return m_stopping; }); });
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            m_condition.notify_all();
+            for (std::thread& thread : m_threads)
+            {
+                thread.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_threads.size()) + 1; }
+
+        // Queues a task. Tasks must not throw.
+        void Enqueue(std::function<void()> task)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tasks.push_back(std::move(task));
+            }
+            m_condition.notify_all();
+        }
+
+        // Wakes threads in RunUntil so that they re-check their conditions. Call after changing state that a
+        // condition depends on.
+        void Notify()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_condition.notify_all();
+        }
+
+        // Runs queued tasks on the calling thread until done() returns true. done() is called with the pool's lock
+        // held, and must not use the pool.
+        void RunUntil(const std::function<bool()>& done)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (!done())
+            {
+                if (m_tasks.empty())
+                {
+                    m_condition.wait(lock);
+                    continue;
+                }
+
+                std::function<void()> task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+                lock.unlock();
+                task();
+                lock.lock();
+            }
+        }
+
+        // Calls fn(i) for every i in [0, count) on the pool's threads and the calling thread, and returns once every
+        // call has returned. Rethrows the first exception thrown by fn. May be called from several threads at once.
+        void ParallelFor(uint64_t count, const std::function<void(uint64_t)>& fn)
+        {
+            if (count <= 1 || m_threads.empty())
+            {
+                for (uint64_t i = 0; i < count; ++i)
+                {
+                    fn(i);
+                }
+                return;
+            }
+
+            // Helper tasks may start after the loop is done, so the loop state is shared with them
+            struct Loop
+            {
+                const std::function<void(uint64_t)>* fn;
+                uint64_t count;
+                std::atomic<uint64_t> next{ 0 };
+                std::atomic<uint64_t> finished{ 0 };
+                std::mutex errorMutex;
+#if __cpp_exceptions
+                std::exception_ptr error;
+#endif
+            };
+
+            auto loop = std::make_shared<Loop>();
+            loop->fn = &fn;
+            loop->count = count;
+
+            auto work = [this, loop]
+            {
+                for (uint64_t i = loop->next++; i < loop->count; i = loop->next++)
+                {
+#if __cpp_exceptions
+                    try
+                    {
+                        (*loop->fn)(i);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(loop->errorMutex);
+                        if (!loop->error)
+                        {
+                            loop->error = std::current_exception();
+                        }
+                    }
+#else
+                    (*loop->fn)(i);
+#endif
+                    if (++loop->finished == loop->count)
+                    {
+                        Notify();
+                    }
+                }
+            };
+
+            const uint64_t helperCount = std::min<uint64_t>(count - 1, m_threads.size());
+            for (uint64_t i = 0; i < helperCount; ++i)
+            {
+                Enqueue(work);
+            }
+            work();
+            RunUntil([&] { return loop->finished == loop->count; });
+
+#if __cpp_exceptions
+            if (loop->error)
+            {
+                std::rethrow_exception(loop->error);
+            }
+#endif
+        }
+
+    private:
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::deque<std::function<void()>> m_tasks;
+        bool m_stopping = false;
+    };
+
+    // Functions that dml::cpu::Evaluate computes with vectorized polynomial approximations. The maximum errors over
+    // all FLOAT32 inputs, in units in the last place (ulp) of the exact result, are:
+    //
+    //   Exp        1.1 ulp
+    //   Tanh       1.4 ulp
+    //   Sigmoid    2.5 ulp
+    //   Softplus   2.0 ulp   log(1 + exp(x))
+    //   Erf        2.4 ulp
+    //   Mish       4.8 ulp   x * tanh(softplus(x))
+    //
+    // Denormal results are produced and infinities and NaNs propagate as in the C library. FLOAT16 values are
+    // computed in single precision and rounded to FLOAT16 once.
+    enum class MathFunction
+    {
+        Exp,
+        Tanh,
+        Sigmoid,
+        Softplus,
+        Erf,
+        Mish,
+    };
+
+    namespace detail
+    {
+        using Strides = SmallVector<uint64_t, 8>;
+
+        using dml::detail::HalfToFloat;
+        using dml::detail::FloatToHalf;
+
+        struct Half
+        {
+            uint16_t bits;
+        };
+
+        template <typename T>
+        double ReadValue(const uint8_t* data)
+        {
+            T value;
+            memcpy(&value, data, sizeof(T));
+            return static_cast<double>(value);
+        }
+
+        template <>
+        inline double ReadValue<Half>(const uint8_t* data)
+        {
+            uint16_t bits;
+            memcpy(&bits, data, sizeof(bits));
+            return HalfToFloat(bits);
+        }
+
+        // Floating-point values are rounded to the nearest representable value. Integers are truncated toward zero
+        // and saturated to the range of the type; NaN becomes 0.
+        template <typename T>
+        void WriteValue(uint8_t* data, double value)
+        {
+            T result;
+            if (std::is_floating_point<T>::value)
+            {
+                result = static_cast<T>(value);
+            }
+            else if (std::isnan(value))
+            {
+                result = 0;
+            }
+            else
+            {
+                value = std::trunc(value);
+                if (value <= static_cast<double>(std::numeric_limits<T>::lowest()))
+                {
+                    result = std::numeric_limits<T>::lowest();
+                }
+                else if (value >= static_cast<double>(std::numeric_limits<T>::max()))
+                {
+                    result = std::numeric_limits<T>::max();
+                }
+                else
+                {
+                    result = static_cast<T>(value);
+                }
+            }
+            memcpy(data, &result, sizeof(T));
+        }
+
+        template <>
+        inline void WriteValue<Half>(uint8_t* data, double value)
+        {
+            const uint16_t bits = FloatToHalf(static_cast<float>(value));
+            memcpy(data, &bits, sizeof(bits));
+        }
+
+        // Calls fn with a null pointer of the C++ type that stores elements of the given data type.
+        template <typename Fn>
+        void DispatchDataType(DML_TENSOR_DATA_TYPE dataType, Fn&& fn)
+        {
+            switch (dataType)
+            {
+            case DML_TENSOR_DATA_TYPE_FLOAT32: fn(static_cast<float*>(nullptr)); break;
+            case DML_TENSOR_DATA_TYPE_FLOAT16: fn(static_cast<Half*>(nullptr)); break;
+            case DML_TENSOR_DATA_TYPE_FLOAT64: fn(static_cast<double*>(nullptr)); break;
+            case DML_TENSOR_DATA_TYPE_UINT8: fn(static_cast<uint8_t*>(nullptr)); break;
+            case DML_TENSOR_DATA_TYPE_UINT16: fn(static_cast<uint16_t*>(nullptr)); break;
+            case DML_TENSOR_DATA_TYPE_UINT32: fn(static_cast<uint32_t*>(nullptr)); break;
+            case DML_TENSOR_DATA_TYPE_UINT64: fn(static_cast<uint64_t*>(nullptr)); break;
+            case DML_TENSOR_DATA_TYPE_INT8: fn(static_cast<int8_t*>(nullptr)); break;
+            case DML_TENSOR_DATA_TYPE_INT16: fn(static_cast<int16_t*>(nullptr)); break;
+            case DML_TENSOR_DATA_TYPE_INT32: fn(static_cast<int32_t*>(nullptr)); break;
+            case DML_TENSOR_DATA_TYPE_INT64: fn(static_cast<int64_t*>(nullptr)); break;
+            default: DMLX_THROW(E_INVALIDARG);
+            }
+        }
+
+        inline bool IsIntegerDataType(DML_TENSOR_DATA_TYPE dataType)
+        {
+            return dataType != DML_TENSOR_DATA_TYPE_FLOAT32 &&
+                dataType != DML_TENSOR_DATA_TYPE_FLOAT16 &&
+                dataType != DML_TENSOR_DATA_TYPE_FLOAT64;
+        }
+
+        inline uint32_t GetElementSizeInBits(DML_TENSOR_DATA_TYPE dataType)
+        {
+            uint32_t size = 0;
+            DispatchDataType(dataType, [&](auto* typedNull)
+            {
+                size = static_cast<uint32_t>(sizeof(*typedNull) * 8);
+            });
+            return size;
+        }
+
+        inline uint64_t GetElementCount(Span<const uint32_t> sizes)
+        {
+            uint64_t count = 1;
+            for (uint32_t size : sizes)
+            {
+                count *= size;
+            }
+            return count;
+        }
+
+        inline Strides GetPackedStrides(Span<const uint32_t> sizes)
+        {
+            Strides strides(sizes.size());
+            uint64_t stride = 1;
+            for (size_t i = sizes.size(); i-- > 0;)
+            {
+                strides[i] = stride;
+                stride *= sizes[i];
+            }
+            return strides;
+        }
+
+        inline uint64_t GetOffset(Span<const uint32_t> index, const Strides& strides)
+        {
+            uint64_t offset = 0;
+            for (size_t i = 0; i < index.size(); ++i)
+            {
+                offset += index[i] * strides[i];
+            }
+            return offset;
+        }
+
+        // Calls fn(index, linearIndex) for every element of a tensor with the given sizes, in row-major order.
+        template <typename Fn>
+        void ForEachIndex(Span<const uint32_t> sizes, Fn&& fn)
+        {
+            const uint64_t count = GetElementCount(sizes);
+            TensorDimensions index(sizes.size(), 0);
+            for (uint64_t i = 0; i < count; ++i)
+            {
+                fn(const_cast<const TensorDimensions&>(index), i);
+
+                for (size_t dim = sizes.size(); dim-- > 0;)
+                {
+                    if (++index[dim] < sizes[dim])
+                    {
+                        break;
+                    }
+                    index[dim] = 0;
+                }
+            }
+        }
+
+        // Calls fn(offset) with the offset of every element of a strided tensor, in row-major order.
+        template <typename Fn>
+        void ForEachOffset(Span<const uint32_t> sizes, const Strides& strides, Fn&& fn)
+        {
+            const uint64_t count = GetElementCount(sizes);
+            if (count == 0)
+            {
+                return;
+            }
+            if (sizes.empty())
+            {
+                fn(uint64_t(0));
+                return;
+            }
+
+            const size_t rank = sizes.size();
+            const uint32_t innerSize = sizes[rank - 1];
+            const uint64_t innerStride = strides[rank - 1];
+            TensorDimensions index(rank, 0);
+            uint64_t base = 0;
+            for (uint64_t outer = 0; outer < count / innerSize; ++outer)
+            {
+                for (uint32_t i = 0; i < innerSize; ++i)
+                {
+                    fn(base + i * innerStride);
+                }
+
+                for (size_t dim = rank - 1; dim-- > 0;)
+                {
+                    base += strides[dim];
+                    if (++index[dim] < sizes[dim])
+                    {
+                        break;
+                    }
+                    base -= strides[dim] * sizes[dim];
+                    index[dim] = 0;
+                }
+            }
+        }
+
+        // A tensor in host memory, described by a buffer tensor desc. Strides are in elements.
+        struct TensorView
+        {
+            DML_TENSOR_DATA_TYPE dataType = DML_TENSOR_DATA_TYPE_UNKNOWN;
+            TensorDimensions sizes;
+            Strides strides;
+            uint8_t* data = nullptr;
+
+            explicit operator bool() const { return data != nullptr; }
+            uint64_t GetElementCount() const { return detail::GetElementCount(sizes); }
+        };
+
+        inline TensorView MakeTensorView(const DML_TENSOR_DESC* tensor, uint8_t* data)
+        {
+            TensorView view;
+            if (!tensor || !data)
+            {
+                return view;
+            }
+
+            const auto& bufferDesc = *static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc);
+            view.dataType = bufferDesc.DataType;
+            view.sizes.assign(bufferDesc.Sizes, bufferDesc.Sizes + bufferDesc.DimensionCount);
+            if (bufferDesc.Strides)
+            {
+                view.strides.assign(bufferDesc.Strides, bufferDesc.Strides + bufferDesc.DimensionCount);
+            }
+            else
+            {
+                view.strides = GetPackedStrides(view.sizes);
+            }
+            view.data = data;
+            return view;
+        }
+
+        // Returns the strides that read a view as if it had the given sizes, following the broadcasting rules used
+        // by DirectML operators: the view's dimensions are aligned to the trailing dimensions, and dimensions of size 1
+        // are repeated.
+        inline Strides GetBroadcastStrides(const TensorView& view, Span<const uint32_t> sizes)
+        {
+            if (view.sizes.size() > sizes.size())
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            const size_t leading = sizes.size() - view.sizes.size();
+            Strides strides(sizes.size(), 0);
+            for (size_t i = 0; i < view.sizes.size(); ++i)
+            {
+                if (view.sizes[i] == sizes[leading + i])
+                {
+                    strides[leading + i] = view.strides[i];
+                }
+                else if (view.sizes[i] != 1)
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
+            }
+            return strides;
+        }
+
+        // Reads the elements of a view, broadcast to the given sizes, in row-major order.
+        template <typename V>
+        void Load(const TensorView& view, Span<const uint32_t> sizes, std::vector<V>& values)
+        {
+            const Strides strides = GetBroadcastStrides(view, sizes);
+            values.resize(static_cast<size_t>(GetElementCount(sizes)));
+
+            DispatchDataType(view.dataType, [&](auto* typedNull)
+            {
+                using T = std::remove_pointer_t<decltype(typedNull)>;
+                V* value = values.data();
+                ForEachOffset(sizes, strides, [&](uint64_t offset)
+                {
+                    *value++ = static_cast<V>(ReadValue<T>(view.data + offset * sizeof(T)));
+                });
+            });
+        }
+
+        template <typename V>
+        void Load(const TensorView& view, std::vector<V>& values)
+        {
+            Load(view, view.sizes, values);
+        }
+
+        // Writes elements, in row-major order, to a view.
+        template <typename V>
+        void Store(const V* values, const TensorView& view)
+        {
+            DispatchDataType(view.dataType, [&](auto* typedNull)
+            {
+                using T = std::remove_pointer_t<decltype(typedNull)>;
+                ForEachOffset(view.sizes, view.strides, [&](uint64_t offset)
+                {
+                    WriteValue<T>(view.data + offset * sizeof(T), *values++);
+                });
+            });
+        }
+
+        template <typename V>
+        void Store(const std::vector<V>& values, const TensorView& view)
+        {
+            assert(values.size() == view.GetElementCount());
+            Store(values.data(), view);
+        }
+
+        inline double ReadScalar(DML_TENSOR_DATA_TYPE dataType, const DML_SCALAR_UNION& value)
+        {
+            double result = 0;
+            DispatchDataType(dataType, [&](auto* typedNull)
+            {
+                using T = std::remove_pointer_t<decltype(typedNull)>;
+                result = ReadValue<T>(value.Bytes);
+            });
+            return result;
+        }
+
+        // Per-thread scratch buffers, reused from one operator to the next. References to buffers stay valid as more
+        // slots are added.
+        class Scratch
+        {
+        public:
+            std::vector<double>& Get(size_t slot)
+            {
+                if (slot >= m_buffers.size())
+                {
+                    m_buffers.resize(slot + 1);
+                }
+                return m_buffers[slot];
+            }
+
+            // Buffers for operators that compute in single precision
+            std::vector<float>& GetFloat(size_t slot)
+            {
+                if (slot >= m_floatBuffers.size())
+                {
+                    m_floatBuffers.resize(slot + 1);
+                }
+                return m_floatBuffers[slot];
+            }
+
+        private:
+            std::deque<std::vector<double>> m_buffers;
+            std::deque<std::vector<float>> m_floatBuffers;
+        };
+
+        // Whether a tensor can be computed in single precision. Absent tensors don't prevent it.
+        inline bool IsFloatTensor(const TensorView& view)
+        {
+            return !view || view.dataType == DML_TENSOR_DATA_TYPE_FLOAT32 || view.dataType == DML_TENSOR_DATA_TYPE_FLOAT16;
+        }
+
+        inline bool IsFloatTensors(const std::vector<TensorView>& inputs, const std::vector<TensorView>& outputs)
+        {
+            return std::all_of(inputs.begin(), inputs.end(), IsFloatTensor) && std::all_of(outputs.begin(), outputs.end(), IsFloatTensor);
+        }
+
+        //
+        // Single-precision transcendentals
+        //
+
+        // Each function has a scalar overload and, with AVX2, an eight-lane overload that follows the same steps.
+        // Coefficients are in decreasing order of degree.
+
+        // exp(r) = 1 + r + r^2 * P(r) for |r| <= ln(2) / 2
+        constexpr float ExpPolynomial[] = { 1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f, 4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f };
+
+        // tanh(x) = x + x^3 * P(x^2) for |x| < 0.625
+        constexpr float TanhPolynomial[] = { -5.70498872745e-3f, 2.06390887954e-2f, -5.37397155531e-2f, 1.33314422036e-1f, -3.33332819422e-1f };
+
+        // log(1 + f) = f - f^2 / 2 + f^3 * P(f) for f in [sqrt(0.5) - 1, sqrt(2) - 1]
+        constexpr float LogPolynomial[] = { 7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f, -1.2420140846e-1f, 1.4249322787e-1f, -1.6668057665e-1f, 2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f };
+
+        // erf(x) = x * P(x^2) for |x| < 1
+        constexpr float ErfSmallPolynomial[] = { -1.525636907e-05f, 1.238867803e-04f, -8.546253440e-04f, 5.221886266e-03f, -2.686621217e-02f, 1.128383356e-01f, -3.761263877e-01f, 1.128379154e+00f };
+
+        // erfc(t) = exp(-t^2) * P(t - 2.5) for t in [1, 4]
+        constexpr float ErfLargePolynomial[] = { 1.030151299e-07f, -4.264734348e-07f, 9.763901572e-07f, -3.747273773e-06f, 1.611410639e-05f, -5.952315703e-05f, 2.109179638e-04f, -7.331529643e-04f, 2.467065761e-03f, -8.001693888e-03f, 2.493799475e-02f, -7.434733674e-02f, 2.108063641e-01f };
+
+        constexpr float Ln2High = 0.693359375f;
+        constexpr float Ln2Low = -2.12194440e-4f;
+
+        template <size_t N>
+        float Polynomial(float x, const float (&coefficients)[N])
+        {
+            float y = coefficients[0];
+            for (size_t i = 1; i < N; ++i)
+            {
+                y = y * x + coefficients[i];
+            }
+            return y;
+        }
+
+        // floor for |x| < 2^31, which compilers inline unlike std::floor without SSE4.1
+        inline float Floor(float x)
+        {
+            const float truncated = static_cast<float>(static_cast<int32_t>(x));
+            return truncated > x ? truncated - 1.0f : truncated;
+        }
+
+        // 2^n for integral n in [-126, 127]
+        inline float Exp2i(float n)
+        {
+            const uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(n) + 127) << 23;
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        inline float ExpApprox(float x)
+        {
+            if (std::isnan(x))
+            {
+                return x;
+            }
+
+            // exp(x) = 2^n * exp(r). Inputs are clamped to where the result rounds to 0 or overflows.
+            x = std::min(std::max(x, -104.0f), 89.0f);
+            const float n = Floor(x * 1.44269504f + 0.5f);
+            const float r = (x - n * Ln2High) - n * Ln2Low;
+            const float y = Polynomial(r, ExpPolynomial) * (r * r) + r + 1.0f;
+
+            // 2^n is applied in two steps so that denormal and overflowing results round once
+            const float n1 = Floor(n * 0.5f);
+            return y * Exp2i(n1) * Exp2i(n - n1);
+        }
+
+        inline float TanhApprox(float x)
+        {
+            const float t = std::abs(x);
+            float y;
+            if (t < 0.625f)
+            {
+                const float z = t * t;
+                y = Polynomial(z, TanhPolynomial) * z * t + t;
+            }
+            else
+            {
+                y = 1.0f - 2.0f / (ExpApprox(2.0f * t) + 1.0f);
+            }
+            return std::copysign(y, x);
+        }
+
+        inline float SigmoidApprox(float x)
+        {
+            // Computed from exp(-|x|) so that neither branch overflows
+            const float e = ExpApprox(-std::abs(x));
+            return (x >= 0 ? 1.0f : e) / (1.0f + e);
+        }
+
+        // log(1 + e) for e in [0, 1]
+        inline float Log1pApprox(float e)
+        {
+            // log(u) where u = 1 + e = 2^k * (1 + f), plus a correction for the rounding of u
+            const float u = 1.0f + e;
+            const bool high = u > 1.41421356f;
+            const float f = high ? u * 0.5f - 1.0f : u - 1.0f;
+            const float k = high ? 1.0f : 0.0f;
+            const float z = f * f;
+            const float y = Polynomial(f, LogPolynomial) * f * z + k * Ln2Low - 0.5f * z;
+            return (f + y) + k * Ln2High + (e - (u - 1.0f)) / u;
+        }
+
+        inline float SoftplusApprox(float x)
+        {
+            // log(1 + exp(x)) = max(x, 0) + log(1 + exp(-|x|))
+            return std::max(x, 0.0f) + Log1pApprox(ExpApprox(-std::abs(x)));
+        }
+
+        inline float ErfApprox(float x)
+        {
+            const float t = std::abs(x);
+            if (t < 1.0f)
+            {
+                return x * Polynomial(x * x, ErfSmallPolynomial);
+            }
+            if (t >= 4.0f)
+            {
+                return std::copysign(1.0f, x);
+            }
+
+            // t^2 is split into a float and its rounding error, and exp(-t^2) ~= exp(-high) * (1 - low)
+            const double square = double(t) * t;
+            const float high = static_cast<float>(square);
+            const float low = static_cast<float>(square - high);
+            const float erfc = ExpApprox(-high) * (1.0f - low) * Polynomial(t - 2.5f, ErfLargePolynomial);
+            return std::copysign(1.0f - erfc, x);
+        }
+
+        inline float MishApprox(float x)
+        {
+            const float bounded = std::max(x, std::numeric_limits<float>::lowest());
+            if (x < -80.0f)
+            {
+                // The quotient below rounds to exp(x), which is computed in halves so that a denormal result rounds
+                // once
+                const float h = ExpApprox(0.5f * x);
+                return bounded * h * h;
+            }
+
+            // tanh(log(1 + e)) = n / (n + 2), where e = exp(x) and n = e * (e + 2). Above 20 the quotient rounds to 1.
+            const float e = ExpApprox(std::min(x, 20.0f));
+            const float n = e * (e + 2.0f);
+            return bounded * (n / (n + 2.0f));
+        }
+
+#if DMLX_USE_AVX2
+        template <size_t N>
+        __m256 Polynomial(__m256 x, const float (&coefficients)[N])
+        {
+            __m256 y = _mm256_set1_ps(coefficients[0]);
+            for (size_t i = 1; i < N; ++i)
+            {
+                y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(coefficients[i]));
+            }
+            return y;
+        }
+
+        inline __m256 Exp2i(__m256 n)
+        {
+            const __m256i exponent = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+            return _mm256_castsi256_ps(_mm256_slli_epi32(exponent, 23));
+        }
+
+        inline __m256 IsNan(__m256 x)
+        {
+            return _mm256_cmp_ps(x, x, _CMP_UNORD_Q);
+        }
+
+        inline __m256 SignBit(__m256 x)
+        {
+            return _mm256_and_ps(x, _mm256_set1_ps(-0.0f));
+        }
+
+        inline __m256 Abs(__m256 x)
+        {
+            return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+        }
+
+        inline __m256 ExpApprox(__m256 x)
+        {
+            const __m256 clamped = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-104.0f)), _mm256_set1_ps(89.0f));
+            const __m256 n = _mm256_floor_ps(_mm256_fmadd_ps(clamped, _mm256_set1_ps(1.44269504f), _mm256_set1_ps(0.5f)));
+            __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(Ln2High), clamped);
+            r = _mm256_fnmadd_ps(n, _mm256_set1_ps(Ln2Low), r);
+            const __m256 y = _mm256_add_ps(_mm256_fmadd_ps(Polynomial(r, ExpPolynomial), _mm256_mul_ps(r, r), r), _mm256_set1_ps(1.0f));
+
+            const __m256 n1 = _mm256_floor_ps(_mm256_mul_ps(n, _mm256_set1_ps(0.5f)));
+            const __m256 result = _mm256_mul_ps(_mm256_mul_ps(y, Exp2i(n1)), Exp2i(_mm256_sub_ps(n, n1)));
+            return _mm256_blendv_ps(result, x, IsNan(x));
+        }
+
+        inline __m256 TanhApprox(__m256 x)
+        {
+            const __m256 t = Abs(x);
+            const __m256 z = _mm256_mul_ps(t, t);
+            const __m256 small = _mm256_fmadd_ps(_mm256_mul_ps(Polynomial(z, TanhPolynomial), z), t, t);
+
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 e = ExpApprox(_mm256_add_ps(t, t));
+            const __m256 large = _mm256_sub_ps(one, _mm256_div_ps(_mm256_set1_ps(2.0f), _mm256_add_ps(e, one)));
+            const __m256 y = _mm256_blendv_ps(large, small, _mm256_cmp_ps(t, _mm256_set1_ps(0.625f), _CMP_LT_OQ));
+            return _mm256_or_ps(y, SignBit(x));
+        }
+
+        inline __m256 SigmoidApprox(__m256 x)
+        {
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 e = ExpApprox(_mm256_or_ps(x, _mm256_set1_ps(-0.0f)));
+            const __m256 numerator = _mm256_blendv_ps(one, e, _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ));
+            return _mm256_div_ps(numerator, _mm256_add_ps(one, e));
+        }
+
+        inline __m256 Log1pApprox(__m256 e)
+        {
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 u = _mm256_add_ps(one, e);
+            const __m256 high = _mm256_cmp_ps(u, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+            const __m256 f = _mm256_sub_ps(_mm256_blendv_ps(u, _mm256_mul_ps(u, _mm256_set1_ps(0.5f)), high), one);
+            const __m256 k = _mm256_and_ps(high, one);
+            const __m256 z = _mm256_mul_ps(f, f);
+
+            __m256 y = _mm256_mul_ps(_mm256_mul_ps(Polynomial(f, LogPolynomial), f), z);
+            y = _mm256_fmadd_ps(k, _mm256_set1_ps(Ln2Low), y);
+            y = _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, y);
+
+            const __m256 correction = _mm256_div_ps(_mm256_sub_ps(e, _mm256_sub_ps(u, one)), u);
+            return _mm256_add_ps(_mm256_fmadd_ps(k, _mm256_set1_ps(Ln2High), _mm256_add_ps(f, y)), correction);
+        }
+
+        inline __m256 SoftplusApprox(__m256 x)
+        {
+            const __m256 result = _mm256_add_ps(
+                _mm256_max_ps(x, _mm256_setzero_ps()),
+                Log1pApprox(ExpApprox(_mm256_or_ps(x, _mm256_set1_ps(-0.0f)))));
+            return _mm256_blendv_ps(result, x, IsNan(x));
+        }
+
+        inline __m256 ErfApprox(__m256 x)
+        {
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 t = Abs(x);
+            const __m256 high = _mm256_mul_ps(t, t);
+            const __m256 low = _mm256_fmsub_ps(t, t, high);
+            const __m256 small = _mm256_mul_ps(x, Polynomial(high, ErfSmallPolynomial));
+
+            __m256 erfc = _mm256_mul_ps(ExpApprox(_mm256_xor_ps(high, _mm256_set1_ps(-0.0f))), _mm256_sub_ps(one, low));
+            erfc = _mm256_mul_ps(erfc, Polynomial(_mm256_sub_ps(t, _mm256_set1_ps(2.5f)), ErfLargePolynomial));
+            const __m256 large = _mm256_blendv_ps(_mm256_sub_ps(one, erfc), one, _mm256_cmp_ps(t, _mm256_set1_ps(4.0f), _CMP_GE_OQ));
+
+            const __m256 result = _mm256_blendv_ps(_mm256_or_ps(large, SignBit(x)), small, _mm256_cmp_ps(t, one, _CMP_LT_OQ));
+            return _mm256_blendv_ps(result, x, IsNan(x));
+        }
+
+        inline __m256 MishApprox(__m256 x)
+        {
+            const __m256 e = ExpApprox(_mm256_min_ps(x, _mm256_set1_ps(20.0f)));
+            const __m256 n = _mm256_mul_ps(e, _mm256_add_ps(e, _mm256_set1_ps(2.0f)));
+            const __m256 bounded = _mm256_max_ps(x, _mm256_set1_ps(std::numeric_limits<float>::lowest()));
+            __m256 result = _mm256_mul_ps(bounded, _mm256_div_ps(n, _mm256_add_ps(n, _mm256_set1_ps(2.0f))));
+
+            const __m256 tiny = _mm256_cmp_ps(x, _mm256_set1_ps(-80.0f), _CMP_LT_OQ);
+            if (_mm256_movemask_ps(tiny))
+            {
+                const __m256 h = ExpApprox(_mm256_mul_ps(x, _mm256_set1_ps(0.5f)));
+                result = _mm256_blendv_ps(result, _mm256_mul_ps(_mm256_mul_ps(bounded, h), h), tiny);
+            }
+            return _mm256_blendv_ps(result, x, IsNan(x));
+        }
+#endif
+
+        // output[i] = fn(input[i] * scale + bias). input and output may alias. The identity scale and bias are
+        // skipped, which keeps the sign of -0.
+        template <typename Fn>
+        void EvaluateFloat(float scale, float bias, const float* input, float* output, size_t count, Fn&& fn)
+        {
+            const bool scaled = scale != 1 || bias != 0;
+            size_t i = 0;
+#if DMLX_USE_AVX2
+            const __m256 scaleVector = _mm256_set1_ps(scale);
+            const __m256 biasVector = _mm256_set1_ps(bias);
+            for (; i + 8 <= count; i += 8)
+            {
+                const __m256 x = _mm256_loadu_ps(input + i);
+                _mm256_storeu_ps(output + i, fn(scaled ? _mm256_fmadd_ps(x, scaleVector, biasVector) : x));
+            }
+#endif
+            for (; i < count; ++i)
+            {
+                output[i] = fn(scaled ? input[i] * scale + bias : input[i]);
+            }
+        }
+
+        inline void EvaluateFloat(MathFunction function, float scale, float bias, const float* input, float* output, size_t count)
+        {
+            switch (function)
+            {
+            case MathFunction::Exp: EvaluateFloat(scale, bias, input, output, count, [](auto x) { return ExpApprox(x); }); break;
+            case MathFunction::Tanh: EvaluateFloat(scale, bias, input, output, count, [](auto x) { return TanhApprox(x); }); break;
+            case MathFunction::Sigmoid: EvaluateFloat(scale, bias, input, output, count, [](auto x) { return SigmoidApprox(x); }); break;
+            case MathFunction::Softplus: EvaluateFloat(scale, bias, input, output, count, [](auto x) { return SoftplusApprox(x); }); break;
+            case MathFunction::Erf: EvaluateFloat(scale, bias, input, output, count, [](auto x) { return ErfApprox(x); }); break;
+            case MathFunction::Mish: EvaluateFloat(scale, bias, input, output, count, [](auto x) { return MishApprox(x); }); break;
+            default: DMLX_THROW(E_INVALIDARG);
+            }
+        }
+
+        // Applies the activations that have a vectorized form: function(scale * x) * outputScale. Returns false for
+        // other activations.
+        inline bool ApplyFloatActivation(const DML_OPERATOR_DESC& activation, float* values, size_t count)
+        {
+            MathFunction function;
+            float scale = 1;
+            float outputScale = 1;
+            switch (activation.Type)
+            {
+            case DML_OPERATOR_ACTIVATION_SIGMOID:
+                function = MathFunction::Sigmoid;
+                break;
+            case DML_OPERATOR_ACTIVATION_TANH:
+                function = MathFunction::Tanh;
+                break;
+            case DML_OPERATOR_ACTIVATION_SCALED_TANH:
+            {
+                const auto& desc = *static_cast<const DML_ACTIVATION_SCALED_TANH_OPERATOR_DESC*>(activation.Desc);
+                function = MathFunction::Tanh;
+                scale = desc.Beta;
+                outputScale = desc.Alpha;
+                break;
+            }
+            case DML_OPERATOR_ACTIVATION_SOFTPLUS:
+            {
+                const float steepness = static_cast<const DML_ACTIVATION_SOFTPLUS_OPERATOR_DESC*>(activation.Desc)->Steepness;
+                function = MathFunction::Softplus;
+                scale = steepness;
+                outputScale = 1 / steepness;
+                break;
+            }
+            case DML_OPERATOR_ACTIVATION_PARAMETRIC_SOFTPLUS:
+            {
+                const auto& desc = *static_cast<const DML_ACTIVATION_PARAMETRIC_SOFTPLUS_OPERATOR_DESC*>(activation.Desc);
+                function = MathFunction::Softplus;
+                scale = desc.Beta;
+                outputScale = desc.Alpha;
+                break;
+            }
+            default:
+                return false;
+            }
+
+            EvaluateFloat(function, scale, 0, values, values, count);
+            if (outputScale != 1)
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    values[i] *= outputScale;
+                }
+            }
+            return true;
+        }
+
+        //
+        // Activations
+        //
+
+        // Applies an element-wise activation in place. Returns false if the activation isn't element-wise (e.g.
+        // softmax), or needs a tensor input (parameterized ReLU).
+        template <typename V>
+        bool ApplyActivation(const DML_OPERATOR_DESC& activation, V* values, size_t count)
+        {
+            if constexpr (std::is_same<V, float>::value)
+            {
+                if (ApplyFloatActivation(activation, values, count))
+                {
+                    return true;
+                }
+            }
+
+            auto apply = [&](auto fn)
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    values[i] = static_cast<V>(fn(values[i]));
+                }
+                return true;
+            };
+
+            switch (activation.Type)
+            {
+            case DML_OPERATOR_ACTIVATION_ELU:
+            {
+                const double alpha = static_cast<const DML_ACTIVATION_ELU_OPERATOR_DESC*>(activation.Desc)->Alpha;
+                return apply([=](double x) { return x > 0 ? x : alpha * (std::exp(x) - 1); });
+            }
+            case DML_OPERATOR_ACTIVATION_CELU:
+            {
+                const double alpha = static_cast<const DML_ACTIVATION_CELU_OPERATOR_DESC*>(activation.Desc)->Alpha;
+                return apply([=](double x) { return std::max(0.0, x) + std::min(0.0, alpha * (std::exp(x / alpha) - 1)); });
+            }
+            case DML_OPERATOR_ACTIVATION_HARD_SIGMOID:
+            {
+                const auto& desc = *static_cast<const DML_ACTIVATION_HARD_SIGMOID_OPERATOR_DESC*>(activation.Desc);
+                const double alpha = desc.Alpha, beta = desc.Beta;
+                return apply([=](double x) { return std::max(0.0, std::min(1.0, alpha * x + beta)); });
+            }
+            case DML_OPERATOR_ACTIVATION_IDENTITY:
+                return true;
+            case DML_OPERATOR_ACTIVATION_LEAKY_RELU:
+            {
+                const double alpha = static_cast<const DML_ACTIVATION_LEAKY_RELU_OPERATOR_DESC*>(activation.Desc)->Alpha;
+                return apply([=](double x) { return x > 0 ? x : alpha * x; });
+            }
+            case DML_OPERATOR_ACTIVATION_LINEAR:
+            {
+                const auto& desc = *static_cast<const DML_ACTIVATION_LINEAR_OPERATOR_DESC*>(activation.Desc);
+                const double alpha = desc.Alpha, beta = desc.Beta;
+                return apply([=](double x) { return alpha * x + beta; });
+            }
+            case DML_OPERATOR_ACTIVATION_PARAMETRIC_SOFTPLUS:
+            {
+                const auto& desc = *static_cast<const DML_ACTIVATION_PARAMETRIC_SOFTPLUS_OPERATOR_DESC*>(activation.Desc);
+                const double alpha = desc.Alpha, beta = desc.Beta;
+                return apply([=](double x) { return alpha * std::log1p(std::exp(beta * x)); });
+            }
+            case DML_OPERATOR_ACTIVATION_RELU:
+                return apply([](double x) { return std::max(0.0, x); });
+            case DML_OPERATOR_ACTIVATION_SCALED_ELU:
+            {
+                const auto& desc = *static_cast<const DML_ACTIVATION_SCALED_ELU_OPERATOR_DESC*>(activation.Desc);
+                const double alpha = desc.Alpha, gamma = desc.Gamma;
+                return apply([=](double x) { return gamma * (x > 0 ? x : alpha * (std::exp(x) - 1)); });
+            }
+            case DML_OPERATOR_ACTIVATION_SCALED_TANH:
+            {
+                const auto& desc = *static_cast<const DML_ACTIVATION_SCALED_TANH_OPERATOR_DESC*>(activation.Desc);
+                const double alpha = desc.Alpha, beta = desc.Beta;
+                return apply([=](double x) { return alpha * std::tanh(beta * x); });
+            }
+            case DML_OPERATOR_ACTIVATION_SIGMOID:
+                return apply([](double x) { return 1 / (1 + std::exp(-x)); });
+            case DML_OPERATOR_ACTIVATION_SOFTPLUS:
+            {
+                const double steepness = static_cast<const DML_ACTIVATION_SOFTPLUS_OPERATOR_DESC*>(activation.Desc)->Steepness;
+                return apply([=](double x) { return std::log1p(std::exp(steepness * x)) / steepness; });
+            }
+            case DML_OPERATOR_ACTIVATION_SOFTSIGN:
+                return apply([](double x) { return x / (1 + std::abs(x)); });
+            case DML_OPERATOR_ACTIVATION_TANH:
+                return apply([](double x) { return std::tanh(x); });
+            case DML_OPERATOR_ACTIVATION_THRESHOLDED_RELU:
+            {
+                const double alpha = static_cast<const DML_ACTIVATION_THRESHOLDED_RELU_OPERATOR_DESC*>(activation.Desc)->Alpha;
+                return apply([=](double x) { return x > alpha ? x : 0.0; });
+            }
+            case DML_OPERATOR_ACTIVATION_SHRINK:
+            {
+                const auto& desc = *static_cast<const DML_ACTIVATION_SHRINK_OPERATOR_DESC*>(activation.Desc);
+                const double bias = desc.Bias, threshold = desc.Threshold;
+                return apply([=](double x) { return x < -threshold ? x + bias : x > threshold ? x - bias : 0.0; });
+            }
+            default:
+                return false;
+            }
+        }
+
+        template <typename V>
+        void ApplyFusedActivation(const DML_OPERATOR_DESC* activation, std::vector<V>& values)
+        {
+            if (activation && !ApplyActivation(*activation, values.data(), values.size()))
+            {
+                DMLX_THROW(E_NOTIMPL);
+            }
+        }
+
+        // Softmax, log-softmax and hardmax normalize each row along the last dimension.
+        inline void RunSoftmax(DML_OPERATOR_TYPE type, const TensorView& input, const TensorView& output, Scratch& scratch)
+        {
+            std::vector<double>& values = scratch.Get(0);
+            Load(input, output.sizes, values);
+
+            const size_t rowSize = output.sizes.empty() ? 1 : output.sizes.back();
+            for (size_t row = 0; rowSize != 0 && row < values.size(); row += rowSize)
+            {
+                double* x = values.data() + row;
+                const double maxValue = *std::max_element(x, x + rowSize);
+
+                if (type == DML_OPERATOR_ACTIVATION_HARDMAX)
+                {
+                    const size_t maxIndex = std::max_element(x, x + rowSize) - x;
+                    for (size_t i = 0; i < rowSize; ++i)
+                    {
+                        x[i] = i == maxIndex ? 1.0 : 0.0;
+                    }
+                    continue;
+                }
+
+                double sum = 0;
+                for (size_t i = 0; i < rowSize; ++i)
+                {
+                    sum += std::exp(x[i] - maxValue);
+                }
+
+                const double logSum = std::log(sum);
+                for (size_t i = 0; i < rowSize; ++i)
+                {
+                    x[i] = type == DML_OPERATOR_ACTIVATION_LOG_SOFTMAX
+                        ? x[i] - maxValue - logSum
+                        : std::exp(x[i] - maxValue) / sum;
+                }
+            }
+
+            Store(values, output);
+        }
+
+        //
+        // Element-wise operators
+        //
+
+        template <typename Fn>
+        void RunUnary(
+            const TensorView& input,
+            const TensorView& output,
+            const DML_SCALE_BIAS* scaleBias,
+            Scratch& scratch,
+            Fn&& fn)
+        {
+            std::vector<double>& values = scratch.Get(0);
+            Load(input, output.sizes, values);
+
+            const double scale = scaleBias ? scaleBias->Scale : 1.0;
+            const double bias = scaleBias ? scaleBias->Bias : 0.0;
+            for (double& value : values)
+            {
+                value = fn(value * scale + bias);
+            }
+
+            Store(values, output);
+        }
+
+        // Single-precision form of RunUnary for the functions that have vectorized approximations
+        inline void RunMathFunction(
+            MathFunction function,
+            const TensorView& input,
+            const TensorView& output,
+            const DML_SCALE_BIAS* scaleBias,
+            Scratch& scratch)
+        {
+            std::vector<float>& values = scratch.GetFloat(0);
+            Load(input, output.sizes, values);
+            EvaluateFloat(function, scaleBias ? scaleBias->Scale : 1.0f, scaleBias ? scaleBias->Bias : 0.0f, values.data(), values.data(), values.size());
+            Store(values, output);
+        }
+
+        template <typename Fn>
+        void RunBinary(
+            const TensorView& a,
+            const TensorView& b,
+            const TensorView& output,
+            const DML_OPERATOR_DESC* fusedActivation,
+            Scratch& scratch,
+            Fn&& fn)
+        {
+            std::vector<double>& aValues = scratch.Get(0);
+            std::vector<double>& bValues = scratch.Get(1);
+            Load(a, output.sizes, aValues);
+            Load(b, output.sizes, bValues);
+
+            for (size_t i = 0; i < aValues.size(); ++i)
+            {
+                aValues[i] = fn(aValues[i], bValues[i]);
+            }
+
+            ApplyFusedActivation(fusedActivation, aValues);
+            Store(aValues, output);
+        }
+
+        // Bitwise operators work on the bits of the input's data type.
+        inline uint64_t ToBits(double value, uint32_t bitCount)
+        {
+            const uint64_t bits = value < 0
+                ? static_cast<uint64_t>(static_cast<int64_t>(value))
+                : static_cast<uint64_t>(value);
+            return bitCount >= 64 ? bits : bits & ((uint64_t(1) << bitCount) - 1);
+        }
+
+        inline double FromBits(uint64_t bits, DML_TENSOR_DATA_TYPE dataType)
+        {
+            const uint32_t bitCount = GetElementSizeInBits(dataType);
+            const bool isSigned =
+                dataType == DML_TENSOR_DATA_TYPE_INT8 ||
+                dataType == DML_TENSOR_DATA_TYPE_INT16 ||
+                dataType == DML_TENSOR_DATA_TYPE_INT32 ||
+                dataType == DML_TENSOR_DATA_TYPE_INT64;
+
+            if (bitCount < 64)
+            {
+                bits &= (uint64_t(1) << bitCount) - 1;
+                if (isSigned && (bits >> (bitCount - 1)) != 0)
+                {
+                    return static_cast<double>(static_cast<int64_t>(bits | ~((uint64_t(1) << bitCount) - 1)));
+                }
+            }
+            return isSigned ? static_cast<double>(static_cast<int64_t>(bits)) : static_cast<double>(bits);
+        }
+
+        inline double RoundHalfToEven(double value)
+        {
+            const double rounded = std::round(value);
+            if (std::abs(value - std::trunc(value)) == 0.5)
+            {
+                return 2.0 * std::round(value / 2.0);
+            }
+            return rounded;
+        }
+
+        inline void RunQuantizeLinear(
+            DML_OPERATOR_TYPE type,
+            const std::vector<TensorView>& inputs,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& values = scratch.Get(0);
+            std::vector<double>& scales = scratch.Get(1);
+            std::vector<double>& zeroPoints = scratch.Get(2);
+            Load(inputs[0], output.sizes, values);
+            Load(inputs[1], output.sizes, scales);
+            Load(inputs[2], output.sizes, zeroPoints);
+
+            for (size_t i = 0; i < values.size(); ++i)
+            {
+                values[i] = type == DML_OPERATOR_ELEMENT_WISE_QUANTIZE_LINEAR
+                    ? RoundHalfToEven(values[i] / scales[i]) + zeroPoints[i]
+                    : (values[i] - zeroPoints[i]) * scales[i];
+            }
+
+            Store(values, output);
+        }
+
+        inline void RunElementWise(
+            const DML_OPERATOR_DESC& desc,
+            const std::vector<TensorView>& inputs,
+            const std::vector<TensorView>& outputs,
+            Scratch& scratch)
+        {
+            const TensorView& output = outputs[0];
+            const bool integerOutput = IsIntegerDataType(output.dataType);
+
+            // Unary operators with a scale and bias share a desc layout
+            const auto& unary = *static_cast<const DML_ELEMENT_WISE_IDENTITY_OPERATOR_DESC*>(desc.Desc);
+            auto runUnary = [&](auto fn) { RunUnary(inputs[0], output, unary.ScaleBias, scratch, fn); };
+            auto runUnaryNoScaleBias = [&](auto fn) { RunUnary(inputs[0], output, nullptr, scratch, fn); };
+            auto runMathFunction = [&](MathFunction function, auto fn)
+            {
+                if (IsFloatTensors(inputs, outputs))
+                {
+                    RunMathFunction(function, inputs[0], output, unary.ScaleBias, scratch);
+                }
+                else
+                {
+                    runUnary(fn);
+                }
+            };
+            auto runBinary = [&](auto fn) { RunBinary(inputs[0], inputs[1], output, nullptr, scratch, fn); };
+            auto runCompare = [&](auto fn) { runBinary([=](double a, double b) { return fn(a, b) ? 1.0 : 0.0; }); };
+
+            const uint32_t inputBits = inputs.empty() || !inputs[0] ? 0 : GetElementSizeInBits(inputs[0].dataType);
+            const DML_TENSOR_DATA_TYPE outputType = output.dataType;
+
+            switch (desc.Type)
+            {
+            case DML_OPERATOR_ELEMENT_WISE_IDENTITY: runUnary([](double x) { return x; }); break;
+            case DML_OPERATOR_ELEMENT_WISE_ABS: runUnary([](double x) { return std::abs(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_ACOS: runUnary([](double x) { return std::acos(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_ASIN: runUnary([](double x) { return std::asin(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_ATAN: runUnary([](double x) { return std::atan(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_CEIL: runUnary([](double x) { return std::ceil(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_COS: runUnary([](double x) { return std::cos(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_EXP: runMathFunction(MathFunction::Exp, [](double x) { return std::exp(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_FLOOR: runUnary([](double x) { return std::floor(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_LOG: runUnary([](double x) { return std::log(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_RECIP: runUnary([](double x) { return 1 / x; }); break;
+            case DML_OPERATOR_ELEMENT_WISE_SIN: runUnary([](double x) { return std::sin(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_SQRT: runUnary([](double x) { return std::sqrt(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_TAN: runUnary([](double x) { return std::tan(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_ERF: runMathFunction(MathFunction::Erf, [](double x) { return std::erf(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_SINH: runUnary([](double x) { return std::sinh(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_COSH: runUnary([](double x) { return std::cosh(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_TANH: runMathFunction(MathFunction::Tanh, [](double x) { return std::tanh(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_ASINH: runUnary([](double x) { return std::asinh(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_ACOSH: runUnary([](double x) { return std::acosh(x); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_ATANH: runUnary([](double x) { return std::atanh(x); }); break;
+
+            case DML_OPERATOR_ELEMENT_WISE_CLIP:
+            {
+                const auto& clip = *static_cast<const DML_ELEMENT_WISE_CLIP_OPERATOR_DESC*>(desc.Desc);
+                const double minValue = clip.Min, maxValue = clip.Max;
+                runUnary([=](double x) { return std::min(std::max(x, minValue), maxValue); });
+                break;
+            }
+            case DML_OPERATOR_ELEMENT_WISE_THRESHOLD:
+            {
+                const double minValue = static_cast<const DML_ELEMENT_WISE_THRESHOLD_OPERATOR_DESC*>(desc.Desc)->Min;
+                runUnary([=](double x) { return std::max(x, minValue); });
+                break;
+            }
+            case DML_OPERATOR_ELEMENT_WISE_CONSTANT_POW:
+            {
+                const double exponent = static_cast<const DML_ELEMENT_WISE_CONSTANT_POW_OPERATOR_DESC*>(desc.Desc)->Exponent;
+                runUnary([=](double x) { return std::pow(x, exponent); });
+                break;
+            }
+
+            case DML_OPERATOR_ELEMENT_WISE_LOGICAL_NOT: runUnaryNoScaleBias([](double x) { return x == 0 ? 1.0 : 0.0; }); break;
+            case DML_OPERATOR_ELEMENT_WISE_SIGN: runUnaryNoScaleBias([](double x) { return double((x > 0) - (x < 0)); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_IS_NAN: runUnaryNoScaleBias([](double x) { return std::isnan(x) ? 1.0 : 0.0; }); break;
+            case DML_OPERATOR_ELEMENT_WISE_BIT_NOT:
+                runUnaryNoScaleBias([=](double x) { return FromBits(~ToBits(x, inputBits), outputType); });
+                break;
+            case DML_OPERATOR_ELEMENT_WISE_BIT_COUNT:
+            {
+                runUnaryNoScaleBias([=](double x)
+                {
+                    uint64_t bits = ToBits(x, inputBits);
+                    uint32_t count = 0;
+                    for (; bits; bits &= bits - 1)
+                    {
+                        ++count;
+                    }
+                    return double(count);
+                });
+                break;
+            }
+            case DML_OPERATOR_ELEMENT_WISE_ROUND:
+            {
+                const DML_ROUNDING_MODE mode = static_cast<const DML_ELEMENT_WISE_ROUND_OPERATOR_DESC*>(desc.Desc)->RoundingMode;
+                runUnaryNoScaleBias([=](double x)
+                {
+                    switch (mode)
+                    {
+                    case DML_ROUNDING_MODE_TOWARD_ZERO: return std::trunc(x);
+                    case DML_ROUNDING_MODE_TOWARD_INFINITY: return std::round(x); // Halves away from zero
+                    default: return RoundHalfToEven(x);
+                    }
+                });
+                break;
+            }
+            case DML_OPERATOR_ELEMENT_WISE_IS_INFINITY:
+            {
+                const DML_IS_INFINITY_MODE mode = static_cast<const DML_ELEMENT_WISE_IS_INFINITY_OPERATOR_DESC*>(desc.Desc)->InfinityMode;
+                runUnaryNoScaleBias([=](double x)
+                {
+                    const bool match = std::isinf(x) &&
+                        (mode == DML_IS_INFINITY_MODE_EITHER ||
+                        (mode == DML_IS_INFINITY_MODE_POSITIVE && x > 0) ||
+                        (mode == DML_IS_INFINITY_MODE_NEGATIVE && x < 0));
+                    return match ? 1.0 : 0.0;
+                });
+                break;
+            }
+
+            case DML_OPERATOR_ELEMENT_WISE_ADD1:
+            {
+                const DML_OPERATOR_DESC* activation = static_cast<const DML_ELEMENT_WISE_ADD1_OPERATOR_DESC*>(desc.Desc)->FusedActivation;
+                RunBinary(inputs[0], inputs[1], output, activation, scratch, [](double a, double b) { return a + b; });
+                break;
+            }
+            case DML_OPERATOR_ELEMENT_WISE_SUBTRACT: runBinary([](double a, double b) { return a - b; }); break;
+            case DML_OPERATOR_ELEMENT_WISE_MULTIPLY: runBinary([](double a, double b) { return a * b; }); break;
+            case DML_OPERATOR_ELEMENT_WISE_DIVIDE:
+                runBinary([=](double a, double b) { return integerOutput ? std::trunc(a / b) : a / b; });
+                break;
+            case DML_OPERATOR_ELEMENT_WISE_MAX: runBinary([](double a, double b) { return std::max(a, b); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_MIN: runBinary([](double a, double b) { return std::min(a, b); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_MEAN: runBinary([](double a, double b) { return (a + b) / 2; }); break;
+            case DML_OPERATOR_ELEMENT_WISE_MODULUS_TRUNCATE: runBinary([](double a, double b) { return std::fmod(a, b); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_MODULUS_FLOOR:
+                runBinary([](double a, double b)
+                {
+                    const double remainder = std::fmod(a, b);
+                    return remainder != 0 && ((remainder < 0) != (b < 0)) ? remainder + b : remainder;
+                });
+                break;
+
+            case DML_OPERATOR_ELEMENT_WISE_POW:
+            {
+                // The scale and bias apply to the input, not the exponent
+                const auto& pow = *static_cast<const DML_ELEMENT_WISE_POW_OPERATOR_DESC*>(desc.Desc);
+                const double scale = pow.ScaleBias ? pow.ScaleBias->Scale : 1.0;
+                const double bias = pow.ScaleBias ? pow.ScaleBias->Bias : 0.0;
+                runBinary([=](double a, double b) { return std::pow(a * scale + bias, b); });
+                break;
+            }
+
+            case DML_OPERATOR_ELEMENT_WISE_LOGICAL_AND: runCompare([](double a, double b) { return a != 0 && b != 0; }); break;
+            case DML_OPERATOR_ELEMENT_WISE_LOGICAL_OR: runCompare([](double a, double b) { return a != 0 || b != 0; }); break;
+            case DML_OPERATOR_ELEMENT_WISE_LOGICAL_XOR: runCompare([](double a, double b) { return (a != 0) != (b != 0); }); break;
+            case DML_OPERATOR_ELEMENT_WISE_LOGICAL_EQUALS: runCompare([](double a, double b) { return a == b; }); break;
+            case DML_OPERATOR_ELEMENT_WISE_LOGICAL_GREATER_THAN: runCompare([](double a, double b) { return a > b; }); break;
+            case DML_OPERATOR_ELEMENT_WISE_LOGICAL_LESS_THAN: runCompare([](double a, double b) { return a < b; }); break;
+            case DML_OPERATOR_ELEMENT_WISE_LOGICAL_GREATER_THAN_OR_EQUAL: runCompare([](double a, double b) { return a >= b; }); break;
+            case DML_OPERATOR_ELEMENT_WISE_LOGICAL_LESS_THAN_OR_EQUAL: runCompare([](double a, double b) { return a <= b; }); break;
+
+            case DML_OPERATOR_ELEMENT_WISE_BIT_AND:
+                runBinary([=](double a, double b) { return FromBits(ToBits(a, inputBits) & ToBits(b, inputBits), outputType); });
+                break;
+            case DML_OPERATOR_ELEMENT_WISE_BIT_OR:
+                runBinary([=](double a, double b) { return FromBits(ToBits(a, inputBits) | ToBits(b, inputBits), outputType); });
+                break;
+            case DML_OPERATOR_ELEMENT_WISE_BIT_XOR:
+                runBinary([=](double a, double b) { return FromBits(ToBits(a, inputBits) ^ ToBits(b, inputBits), outputType); });
+                break;
+            case DML_OPERATOR_ELEMENT_WISE_BIT_SHIFT_LEFT:
+                runBinary([=](double a, double b)
+                {
+                    const uint64_t shift = ToBits(b, 64);
+                    return shift >= inputBits ? 0.0 : FromBits(ToBits(a, inputBits) << shift, outputType);
+                });
+                break;
+            case DML_OPERATOR_ELEMENT_WISE_BIT_SHIFT_RIGHT:
+                runBinary([=](double a, double b)
+                {
+                    const uint64_t shift = ToBits(b, 64);
+                    return shift >= inputBits ? 0.0 : FromBits(ToBits(a, inputBits) >> shift, outputType);
+                });
+                break;
+
+            case DML_OPERATOR_ELEMENT_WISE_IF:
+            {
+                std::vector<double>& condition = scratch.Get(2);
+                Load(inputs[0], output.sizes, condition);
+                RunBinary(inputs[1], inputs[2], output, nullptr, scratch, [&, i = size_t(0)](double a, double b) mutable
+                {
+                    return condition[i++] != 0 ? a : b;
+                });
+                break;
+            }
+
+            case DML_OPERATOR_ELEMENT_WISE_QUANTIZE_LINEAR:
+            case DML_OPERATOR_ELEMENT_WISE_DEQUANTIZE_LINEAR:
+                RunQuantizeLinear(desc.Type, inputs, output, scratch);
+                break;
+
+            default:
+                DMLX_THROW(E_NOTIMPL);
+            }
+        }
+
+        //
+        // Convolution, GEMM, reduction and pooling
+        //
+
+        // Spatial parameters of a convolution or pooling window. Operators with fewer than three spatial dimensions
+        // are treated as having leading spatial dimensions of size 1.
+        struct WindowParameters
+        {
+            uint32_t inputSizes[3] = { 1, 1, 1 };
+            uint32_t outputSizes[3] = { 1, 1, 1 };
+            uint32_t windowSizes[3] = { 1, 1, 1 };
+            uint32_t strides[3] = { 1, 1, 1 };
+            uint32_t dilations[3] = { 1, 1, 1 };
+            int64_t startPadding[3] = { 0, 0, 0 };
+
+            uint64_t GetInputSize() const { return uint64_t(inputSizes[0]) * inputSizes[1] * inputSizes[2]; }
+            uint64_t GetOutputSize() const { return uint64_t(outputSizes[0]) * outputSizes[1] * outputSizes[2]; }
+            uint64_t GetWindowSize() const { return uint64_t(windowSizes[0]) * windowSizes[1] * windowSizes[2]; }
+        };
+
+        inline WindowParameters GetWindowParameters(
+            uint32_t dimensionCount,
+            Span<const uint32_t> inputSizes,
+            Span<const uint32_t> outputSizes,
+            const UINT* windowSizes,
+            const UINT* strides,
+            const UINT* dilations,
+            const UINT* startPadding)
+        {
+            if (dimensionCount > 3 || inputSizes.size() != dimensionCount + 2 || outputSizes.size() != dimensionCount + 2)
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            WindowParameters params;
+            const uint32_t first = 3 - dimensionCount;
+            for (uint32_t i = 0; i < dimensionCount; ++i)
+            {
+                params.inputSizes[first + i] = inputSizes[2 + i];
+                params.outputSizes[first + i] = outputSizes[2 + i];
+                params.windowSizes[first + i] = windowSizes[i];
+                params.strides[first + i] = strides ? strides[i] : 1;
+                params.dilations[first + i] = dilations ? dilations[i] : 1;
+                params.startPadding[first + i] = startPadding ? startPadding[i] : 0;
+            }
+            return params;
+        }
+
+        // Calls fn(windowOffset, inputOffset) for each element of the window at an output position that falls inside
+        // the input. Offsets are relative to the start of a single channel.
+        template <typename Fn>
+        void ForEachWindowElement(const WindowParameters& params, const uint32_t (&outputIndex)[3], bool flipWindow, Fn&& fn)
+        {
+            for (uint32_t w0 = 0; w0 < params.windowSizes[0]; ++w0)
+            {
+                const int64_t i0 = int64_t(outputIndex[0]) * params.strides[0] + int64_t(w0) * params.dilations[0] - params.startPadding[0];
+                if (i0 < 0 || i0 >= params.inputSizes[0]) continue;
+
+                for (uint32_t w1 = 0; w1 < params.windowSizes[1]; ++w1)
+                {
+                    const int64_t i1 = int64_t(outputIndex[1]) * params.strides[1] + int64_t(w1) * params.dilations[1] - params.startPadding[1];
+                    if (i1 < 0 || i1 >= params.inputSizes[1]) continue;
+
+                    for (uint32_t w2 = 0; w2 < params.windowSizes[2]; ++w2)
+                    {
+                        const int64_t i2 = int64_t(outputIndex[2]) * params.strides[2] + int64_t(w2) * params.dilations[2] - params.startPadding[2];
+                        if (i2 < 0 || i2 >= params.inputSizes[2]) continue;
+
+                        uint64_t windowOffset = (uint64_t(w0) * params.windowSizes[1] + w1) * params.windowSizes[2] + w2;
+                        if (flipWindow)
+                        {
+                            windowOffset = params.GetWindowSize() - 1 - windowOffset;
+                        }
+                        const uint64_t inputOffset = (uint64_t(i0) * params.inputSizes[1] + uint64_t(i1)) * params.inputSizes[2] + uint64_t(i2);
+                        fn(windowOffset, inputOffset);
+                    }
+                }
+            }
+        }
+
+        template <typename Fn>
+        void ForEachSpatialIndex(const uint32_t (&sizes)[3], Fn&& fn)
+        {
+            uint32_t index[3];
+            for (index[0] = 0; index[0] < sizes[0]; ++index[0])
+            {
+                for (index[1] = 0; index[1] < sizes[1]; ++index[1])
+                {
+                    for (index[2] = 0; index[2] < sizes[2]; ++index[2])
+                    {
+                        fn(const_cast<const uint32_t (&)[3]>(index));
+                    }
+                }
+            }
+        }
+
+        inline void RunConvolution(
+            const DML_CONVOLUTION_OPERATOR_DESC& desc,
+            const std::vector<TensorView>& inputs,
+            const std::vector<TensorView>& outputs,
+            Scratch& scratch)
+        {
+            const TensorView& input = inputs[0];
+            const TensorView& filter = inputs[1];
+            const TensorView& bias = inputs[2];
+            const TensorView& output = outputs[0];
+
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& w = scratch.Get(1);
+            std::vector<double>& b = scratch.Get(2);
+            std::vector<double>& y = scratch.Get(3);
+            Load(input, x);
+            Load(filter, w);
+            if (bias)
+            {
+                Load(bias, b);
+            }
+
+            const bool forward = desc.Direction == DML_CONVOLUTION_DIRECTION_FORWARD;
+            const bool flip = desc.Mode == DML_CONVOLUTION_MODE_CONVOLUTION;
+
+            // The window is the filter's spatial extent; convolving backward swaps the roles of input and output
+            const Span<const uint32_t> filterSizes = filter.sizes;
+            const WindowParameters params = forward
+                ? GetWindowParameters(desc.DimensionCount, input.sizes, output.sizes, filterSizes.data() + 2, desc.Strides, desc.Dilations, desc.StartPadding)
+                : GetWindowParameters(desc.DimensionCount, output.sizes, input.sizes, filterSizes.data() + 2, desc.Strides, desc.Dilations, desc.StartPadding);
+
+            const uint32_t batchSize = output.sizes[0];
+            const uint32_t outputChannels = output.sizes[1];
+            const uint32_t inputChannels = input.sizes[1];
+            const uint32_t groupCount = std::max(desc.GroupCount, 1u);
+            const uint32_t groupInputChannels = inputChannels / groupCount;
+            const uint32_t groupOutputChannels = outputChannels / groupCount;
+            const uint64_t windowSize = params.GetWindowSize();
+
+            // Forward convolutions read windows of the input; backward convolutions scatter into windows of the output
+            const uint64_t xChannelSize = forward ? params.GetInputSize() : params.GetOutputSize();
+            const uint64_t yChannelSize = forward ? params.GetOutputSize() : params.GetInputSize();
+
+            y.resize(static_cast<size_t>(output.GetElementCount()));
+            for (uint32_t n = 0; n < batchSize; ++n)
+            {
+                for (uint32_t k = 0; k < outputChannels; ++k)
+                {
+                    std::fill_n(y.begin() + (uint64_t(n) * outputChannels + k) * yChannelSize, yChannelSize, bias ? b[k] : 0.0);
+                }
+            }
+
+            if (forward)
+            {
+                // Filter: [outputChannels, groupInputChannels, window...]
+                for (uint32_t n = 0; n < batchSize; ++n)
+                {
+                    for (uint32_t k = 0; k < outputChannels; ++k)
+                    {
+                        const uint32_t group = k / groupOutputChannels;
+                        double* yChannel = y.data() + (uint64_t(n) * outputChannels + k) * yChannelSize;
+                        uint64_t outputOffset = 0;
+                        ForEachSpatialIndex(params.outputSizes, [&](const uint32_t (&outputIndex)[3])
+                        {
+                            double sum = 0;
+                            for (uint32_t c = 0; c < groupInputChannels; ++c)
+                            {
+                                const double* xChannel = x.data() + (uint64_t(n) * inputChannels + group * groupInputChannels + c) * xChannelSize;
+                                const double* wChannel = w.data() + (uint64_t(k) * groupInputChannels + c) * windowSize;
+                                ForEachWindowElement(params, outputIndex, flip, [&](uint64_t windowOffset, uint64_t inputOffset)
+                                {
+                                    sum += xChannel[inputOffset] * wChannel[windowOffset];
+                                });
+                            }
+                            yChannel[outputOffset++] += sum;
+                        });
+                    }
+                }
+            }
+            else
+            {
+                // Filter: [inputChannels, groupOutputChannels, window...]. Each input element is scattered into the
+                // output window that a forward convolution would have read it from.
+                for (uint32_t n = 0; n < batchSize; ++n)
+                {
+                    for (uint32_t c = 0; c < inputChannels; ++c)
+                    {
+                        const uint32_t group = c / groupInputChannels;
+                        const double* xChannel = x.data() + (uint64_t(n) * inputChannels + c) * xChannelSize;
+                        uint64_t inputOffset = 0;
+                        ForEachSpatialIndex(params.outputSizes, [&](const uint32_t (&inputIndex)[3])
+                        {
+                            const double value = xChannel[inputOffset++];
+                            for (uint32_t k = 0; k < groupOutputChannels; ++k)
+                            {
+                                double* yChannel = y.data() + (uint64_t(n) * outputChannels + group * groupOutputChannels + k) * yChannelSize;
+                                const double* wChannel = w.data() + (uint64_t(c) * groupOutputChannels + k) * windowSize;
+                                ForEachWindowElement(params, inputIndex, flip, [&](uint64_t windowOffset, uint64_t outputOffset)
+                                {
+                                    yChannel[outputOffset] += value * wChannel[windowOffset];
+                                });
+                            }
+                        });
+                    }
+                }
+            }
+
+            ApplyFusedActivation(desc.FusedActivation, y);
+            Store(y, output);
+        }
+
+        inline void RunGemm(
+            const DML_GEMM_OPERATOR_DESC& desc,
+            const std::vector<TensorView>& inputs,
+            const std::vector<TensorView>& outputs,
+            Scratch& scratch)
+        {
+            const TensorView& a = inputs[0];
+            const TensorView& b = inputs[1];
+            const TensorView& c = inputs[2];
+            const TensorView& output = outputs[0];
+
+            const size_t rank = output.sizes.size();
+            if (rank < 2 || a.sizes.size() != rank || b.sizes.size() != rank)
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            // A and B are broadcast over the batch dimensions of the output
+            TensorDimensions aSizes = output.sizes;
+            aSizes[rank - 2] = a.sizes[rank - 2];
+            aSizes[rank - 1] = a.sizes[rank - 1];
+            TensorDimensions bSizes = output.sizes;
+            bSizes[rank - 2] = b.sizes[rank - 2];
+            bSizes[rank - 1] = b.sizes[rank - 1];
+
+            std::vector<double>& aValues = scratch.Get(0);
+            std::vector<double>& bValues = scratch.Get(1);
+            std::vector<double>& cValues = scratch.Get(2);
+            std::vector<double>& y = scratch.Get(3);
+            Load(a, aSizes, aValues);
+            Load(b, bSizes, bValues);
+            if (c)
+            {
+                Load(c, output.sizes, cValues);
+            }
+
+            const bool transA = desc.TransA == DML_MATRIX_TRANSFORM_TRANSPOSE;
+            const bool transB = desc.TransB == DML_MATRIX_TRANSFORM_TRANSPOSE;
+            const uint64_t m = output.sizes[rank - 2];
+            const uint64_t n = output.sizes[rank - 1];
+            const uint64_t k = transA ? aSizes[rank - 2] : aSizes[rank - 1];
+            const uint64_t batchCount = m * n == 0 ? 0 : output.GetElementCount() / (m * n);
+
+            y.resize(static_cast<size_t>(output.GetElementCount()));
+            for (uint64_t batch = 0; batch < batchCount; ++batch)
+            {
+                const double* aMatrix = aValues.data() + batch * m * k;
+                const double* bMatrix = bValues.data() + batch * k * n;
+                for (uint64_t row = 0; row < m; ++row)
+                {
+                    for (uint64_t column = 0; column < n; ++column)
+                    {
+                        double sum = 0;
+                        for (uint64_t i = 0; i < k; ++i)
+                        {
+                            const double aValue = transA ? aMatrix[i * m + row] : aMatrix[row * k + i];
+                            const double bValue = transB ? bMatrix[column * k + i] : bMatrix[i * n + column];
+                            sum += aValue * bValue;
+                        }
+
+                        const uint64_t index = (batch * m + row) * n + column;
+                        y[index] = desc.Alpha * sum + (c ? desc.Beta * cValues[index] : 0.0);
+                    }
+                }
+            }
+
+            ApplyFusedActivation(desc.FusedActivation, y);
+            Store(y, output);
+        }
+
+        inline void RunReduce(
+            const DML_REDUCE_OPERATOR_DESC& desc,
+            const std::vector<TensorView>& inputs,
+            const std::vector<TensorView>& outputs,
+            Scratch& scratch)
+        {
+            const TensorView& input = inputs[0];
+            const TensorView& output = outputs[0];
+
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& y = scratch.Get(1);
+            Load(input, x);
+
+            // Maps each input element to its output element, and to its position within the reduced dimensions
+            const size_t rank = input.sizes.size();
+            std::vector<bool> isReduced(rank, false);
+            for (uint32_t i = 0; i < desc.AxisCount; ++i)
+            {
+                if (desc.Axes[i] >= rank)
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
+                isReduced[desc.Axes[i]] = true;
+            }
+
+            Strides outputStrides(rank, 0);
+            Strides reducedStrides(rank, 0);
+            uint64_t outputStride = 1;
+            uint64_t reducedStride = 1;
+            for (size_t i = rank; i-- > 0;)
+            {
+                if (isReduced[i])
+                {
+                    reducedStrides[i] = reducedStride;
+                    reducedStride *= input.sizes[i];
+                }
+                else
+                {
+                    outputStrides[i] = outputStride;
+                    outputStride *= input.sizes[i];
+                }
+            }
+            const uint64_t reducedCount = reducedStride;
+
+            if (output.GetElementCount() != outputStride)
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            std::vector<uint64_t> outputIndices;
+            std::vector<uint64_t> reducedIndices;
+            outputIndices.reserve(x.size());
+            reducedIndices.reserve(x.size());
+            ForEachOffset(input.sizes, outputStrides, [&](uint64_t offset) { outputIndices.push_back(offset); });
+            ForEachOffset(input.sizes, reducedStrides, [&](uint64_t offset) { reducedIndices.push_back(offset); });
+
+            const DML_REDUCE_FUNCTION function = desc.Function;
+            const bool isArg = function == DML_REDUCE_FUNCTION_ARGMAX || function == DML_REDUCE_FUNCTION_ARGMIN;
+
+            double initialValue = 0;
+            switch (function)
+            {
+            case DML_REDUCE_FUNCTION_MULTIPLY: initialValue = 1; break;
+            case DML_REDUCE_FUNCTION_MAX:
+            case DML_REDUCE_FUNCTION_ARGMAX: initialValue = -std::numeric_limits<double>::infinity(); break;
+            case DML_REDUCE_FUNCTION_MIN:
+            case DML_REDUCE_FUNCTION_ARGMIN: initialValue = std::numeric_limits<double>::infinity(); break;
+            default: break;
+            }
+
+            // For ARGMAX/ARGMIN, y holds the extreme values and argIndices their positions
+            y.assign(static_cast<size_t>(outputStride), initialValue);
+            std::vector<double> argIndices(isArg ? y.size() : 0, 0.0);
+            std::vector<bool> argFound(isArg ? y.size() : 0, false);
+
+            for (size_t i = 0; i < x.size(); ++i)
+            {
+                const double value = x[i];
+                double& accumulator = y[outputIndices[i]];
+                switch (function)
+                {
+                case DML_REDUCE_FUNCTION_ARGMAX:
+                case DML_REDUCE_FUNCTION_ARGMIN:
+                {
+                    // The first occurrence of the extreme value wins
+                    const uint64_t o = outputIndices[i];
+                    const bool better = function == DML_REDUCE_FUNCTION_ARGMAX ? value > accumulator : value < accumulator;
+                    if (!argFound[o] || better)
+                    {
+                        accumulator = value;
+                        argIndices[o] = static_cast<double>(reducedIndices[i]);
+                        argFound[o] = true;
+                    }
+                    break;
+                }
+                case DML_REDUCE_FUNCTION_L1: accumulator += std::abs(value); break;
+                case DML_REDUCE_FUNCTION_L2:
+                case DML_REDUCE_FUNCTION_SUM_SQUARE: accumulator += value * value; break;
+                case DML_REDUCE_FUNCTION_LOG_SUM_EXP: accumulator += std::exp(value); break;
+                case DML_REDUCE_FUNCTION_MAX: accumulator = std::max(accumulator, value); break;
+                case DML_REDUCE_FUNCTION_MIN: accumulator = std::min(accumulator, value); break;
+                case DML_REDUCE_FUNCTION_MULTIPLY: accumulator *= value; break;
+                default: accumulator += value; break; // SUM, AVERAGE, LOG_SUM
+                }
+            }
+
+            for (double& value : y)
+            {
+                switch (function)
+                {
+                case DML_REDUCE_FUNCTION_AVERAGE: value /= static_cast<double>(reducedCount); break;
+                case DML_REDUCE_FUNCTION_L2: value = std::sqrt(value); break;
+                case DML_REDUCE_FUNCTION_LOG_SUM:
+                case DML_REDUCE_FUNCTION_LOG_SUM_EXP: value = std::log(value); break;
+                default: break;
+                }
+            }
+
+            Store(isArg ? argIndices : y, output);
+        }
+
+        inline void RunPooling(
+            const WindowParameters& params,
+            bool isMaxPooling,
+            bool includePadding,
+            const TensorView& input,
+            const TensorView& output,
+            const TensorView& outputIndices,
+            Scratch& scratch)
+        {
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& y = scratch.Get(1);
+            std::vector<double>& indices = scratch.Get(2);
+            Load(input, x);
+
+            const uint64_t channelCount = uint64_t(output.sizes[0]) * output.sizes[1];
+            const uint64_t inputChannelSize = params.GetInputSize();
+            const uint64_t outputChannelSize = params.GetOutputSize();
+            y.resize(static_cast<size_t>(channelCount * outputChannelSize));
+            indices.resize(outputIndices ? y.size() : 0);
+
+            for (uint64_t channel = 0; channel < channelCount; ++channel)
+            {
+                const double* xChannel = x.data() + channel * inputChannelSize;
+                uint64_t outputOffset = channel * outputChannelSize;
+                ForEachSpatialIndex(params.outputSizes, [&](const uint32_t (&outputIndex)[3])
+                {
+                    double result = isMaxPooling ? -std::numeric_limits<double>::infinity() : 0.0;
+                    uint64_t resultIndex = 0;
+                    uint64_t count = 0;
+                    ForEachWindowElement(params, outputIndex, false, [&](uint64_t, uint64_t inputOffset)
+                    {
+                        const double value = xChannel[inputOffset];
+                        if (!isMaxPooling)
+                        {
+                            result += value;
+                        }
+                        else if (count == 0 || value > result)
+                        {
+                            result = value;
+                            resultIndex = channel * inputChannelSize + inputOffset;
+                        }
+                        ++count;
+                    });
+
+                    if (!isMaxPooling)
+                    {
+                        const uint64_t divisor = includePadding ? params.GetWindowSize() : count;
+                        result = divisor ? result / static_cast<double>(divisor) : 0.0;
+                    }
+                    if (outputIndices)
+                    {
+                        indices[outputOffset] = static_cast<double>(resultIndex);
+                    }
+                    y[outputOffset++] = result;
+                });
+            }
+
+            Store(y, output);
+            if (outputIndices)
+            {
+                Store(indices, outputIndices);
+            }
+        }
+
+        //
+        // Data movement
+        //
+
+        // Wraps negative indices and checks that an index is in range.
+        inline uint32_t NormalizeIndex(double index, uint32_t size)
+        {
+            int64_t value = static_cast<int64_t>(index);
+            if (value < 0)
+            {
+                value += size;
+            }
+            if (value < 0 || value >= size)
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+            return static_cast<uint32_t>(value);
+        }
+
+        inline void RunSlice(
+            const DML_SLICE1_OPERATOR_DESC& desc,
+            const TensorView& input,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& y = scratch.Get(1);
+            Load(input, x);
+
+            const Strides inputStrides = GetPackedStrides(input.sizes);
+            y.resize(static_cast<size_t>(output.GetElementCount()));
+            ForEachIndex(output.sizes, [&](const TensorDimensions& index, uint64_t i)
+            {
+                uint64_t offset = 0;
+                for (uint32_t dim = 0; dim < desc.DimensionCount; ++dim)
+                {
+                    // Negative strides read the window back to front
+                    const int64_t stride = desc.InputWindowStrides[dim];
+                    const int64_t position = stride >= 0
+                        ? int64_t(index[dim]) * stride
+                        : int64_t(desc.InputWindowSizes[dim]) - 1 + int64_t(index[dim]) * stride;
+                    offset += (desc.InputWindowOffsets[dim] + uint64_t(position)) * inputStrides[dim];
+                }
+                y[i] = x[offset];
+            });
+
+            Store(y, output);
+        }
+
+        inline void RunSplit(
+            const DML_SPLIT_OPERATOR_DESC& desc,
+            const TensorView& input,
+            const std::vector<TensorView>& outputs,
+            Scratch& scratch)
+        {
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& y = scratch.Get(1);
+            Load(input, x);
+
+            const Strides inputStrides = GetPackedStrides(input.sizes);
+            uint64_t axisOffset = 0;
+            for (const TensorView& output : outputs)
+            {
+                y.resize(static_cast<size_t>(output.GetElementCount()));
+                ForEachIndex(output.sizes, [&](const TensorDimensions& index, uint64_t i)
+                {
+                    y[i] = x[GetOffset(index, inputStrides) + axisOffset * inputStrides[desc.Axis]];
+                });
+                if (output)
+                {
+                    Store(y, output);
+                }
+                axisOffset += output.sizes[desc.Axis];
+            }
+        }
+
+        inline void RunJoin(
+            const DML_JOIN_OPERATOR_DESC& desc,
+            const std::vector<TensorView>& inputs,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& y = scratch.Get(1);
+
+            const Strides outputStrides = GetPackedStrides(output.sizes);
+            y.resize(static_cast<size_t>(output.GetElementCount()));
+            uint64_t axisOffset = 0;
+            for (const TensorView& input : inputs)
+            {
+                Load(input, x);
+                ForEachIndex(input.sizes, [&](const TensorDimensions& index, uint64_t i)
+                {
+                    y[GetOffset(index, outputStrides) + axisOffset * outputStrides[desc.Axis]] = x[i];
+                });
+                axisOffset += input.sizes[desc.Axis];
+            }
+
+            Store(y, output);
+        }
+
+        inline void RunPadding(
+            const DML_PADDING_OPERATOR_DESC& desc,
+            const TensorView& input,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& y = scratch.Get(1);
+            Load(input, x);
+
+            const Strides inputStrides = GetPackedStrides(input.sizes);
+            y.resize(static_cast<size_t>(output.GetElementCount()));
+            ForEachIndex(output.sizes, [&](const TensorDimensions& index, uint64_t i)
+            {
+                uint64_t offset = 0;
+                for (uint32_t dim = 0; dim < desc.DimensionCount; ++dim)
+                {
+                    const int64_t size = input.sizes[dim];
+                    int64_t position = int64_t(index[dim]) - desc.StartPadding[dim];
+                    if (position < 0 || position >= size)
+                    {
+                        switch (desc.PaddingMode)
+                        {
+                        case DML_PADDING_MODE_EDGE: position = position < 0 ? 0 : size - 1; break;
+                        case DML_PADDING_MODE_REFLECTION: position = position < 0 ? -position : 2 * (size - 1) - position; break;
+                        case DML_PADDING_MODE_SYMMETRIC: position = position < 0 ? -position - 1 : 2 * size - 1 - position; break;
+                        default: offset = UINT64_MAX; break;
+                        }
+                        if (offset == UINT64_MAX)
+                        {
+                            break;
+                        }
+                        position = std::min(std::max(position, int64_t(0)), size - 1);
+                    }
+                    offset += uint64_t(position) * inputStrides[dim];
+                }
+                y[i] = offset == UINT64_MAX ? desc.PaddingValue : x[offset];
+            });
+
+            Store(y, output);
+        }
+
+        inline void RunTile(
+            const TensorView& input,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& y = scratch.Get(1);
+            Load(input, x);
+
+            const Strides inputStrides = GetPackedStrides(input.sizes);
+            y.resize(static_cast<size_t>(output.GetElementCount()));
+            ForEachIndex(output.sizes, [&](const TensorDimensions& index, uint64_t i)
+            {
+                uint64_t offset = 0;
+                for (size_t dim = 0; dim < index.size(); ++dim)
+                {
+                    offset += (index[dim] % input.sizes[dim]) * inputStrides[dim];
+                }
+                y[i] = x[offset];
+            });
+
+            Store(y, output);
+        }
+
+        // Maps an output coordinate to an input coordinate: input = (output - outputOffset) / scale - inputOffset.
+        // Nearest-neighbor sampling rounds to the nearest input element; linear sampling interpolates between the two
+        // nearest input elements in each dimension. Coordinates are clamped to the input.
+        inline void RunResample(
+            DML_INTERPOLATION_MODE mode,
+            Span<const float> scales,
+            Span<const float> inputPixelOffsets,
+            Span<const float> outputPixelOffsets,
+            const TensorView& input,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& y = scratch.Get(1);
+            Load(input, x);
+
+            const size_t rank = output.sizes.size();
+            const Strides inputStrides = GetPackedStrides(input.sizes);
+            std::vector<uint64_t> lowOffsets(rank);
+            std::vector<uint64_t> highOffsets(rank);
+            std::vector<double> weights(rank);
+
+            y.resize(static_cast<size_t>(output.GetElementCount()));
+            ForEachIndex(output.sizes, [&](const TensorDimensions& index, uint64_t i)
+            {
+                uint64_t nearestOffset = 0;
+                for (size_t dim = 0; dim < rank; ++dim)
+                {
+                    const double maxPosition = double(input.sizes[dim]) - 1;
+                    double position = (double(index[dim]) - outputPixelOffsets[dim]) / scales[dim] - inputPixelOffsets[dim];
+
+                    if (mode == DML_INTERPOLATION_MODE_NEAREST_NEIGHBOR)
+                    {
+                        position = std::min(std::max(std::floor(position + 0.5), 0.0), maxPosition);
+                        nearestOffset += uint64_t(position) * inputStrides[dim];
+                    }
+                    else
+                    {
+                        position = std::min(std::max(position, 0.0), maxPosition);
+                        const double low = std::floor(position);
+                        lowOffsets[dim] = uint64_t(low) * inputStrides[dim];
+                        highOffsets[dim] = uint64_t(std::min(low + 1, maxPosition)) * inputStrides[dim];
+                        weights[dim] = position - low;
+                    }
+                }
+
+                if (mode == DML_INTERPOLATION_MODE_NEAREST_NEIGHBOR)
+                {
+                    y[i] = x[nearestOffset];
+                    return;
+                }
+
+                // Sum over the corners of the interpolation cell, skipping dimensions that don't interpolate
+                uint64_t baseOffset = 0;
+                SmallVector<size_t, 8> interpolatedDims;
+                for (size_t dim = 0; dim < rank; ++dim)
+                {
+                    baseOffset += lowOffsets[dim];
+                    if (weights[dim] != 0)
+                    {
+                        interpolatedDims.push_back(dim);
+                    }
+                }
+
+                double sum = 0;
+                for (uint32_t corner = 0; corner < (1u << interpolatedDims.size()); ++corner)
+                {
+                    uint64_t offset = baseOffset;
+                    double weight = 1;
+                    for (size_t j = 0; j < interpolatedDims.size(); ++j)
+                    {
+                        const size_t dim = interpolatedDims[j];
+                        if (corner & (1u << j))
+                        {
+                            offset += highOffsets[dim] - lowOffsets[dim];
+                            weight *= weights[dim];
+                        }
+                        else
+                        {
+                            weight *= 1 - weights[dim];
+                        }
+                    }
+                    sum += weight * x[offset];
+                }
+                y[i] = sum;
+            });
+
+            Store(y, output);
+        }
+
+        // The output has the input's dimensions before the axis (right-aligned), then the trailing IndexDimensions
+        // dimensions of the indices, then the input's dimensions after the axis.
+        inline void RunGather(
+            const DML_GATHER_OPERATOR_DESC& desc,
+            const TensorView& input,
+            const TensorView& indices,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& indexValues = scratch.Get(1);
+            std::vector<double>& y = scratch.Get(2);
+            Load(input, x);
+            Load(indices, indexValues);
+
+            const int64_t axis = desc.Axis;
+            const int64_t indexDimensions = desc.IndexDimensions;
+            const int64_t rank = static_cast<int64_t>(output.sizes.size());
+            const int64_t indicesRank = static_cast<int64_t>(indices.sizes.size());
+            const Strides inputStrides = GetPackedStrides(input.sizes);
+            const Strides indicesStrides = GetPackedStrides(indices.sizes);
+
+            y.resize(static_cast<size_t>(output.GetElementCount()));
+            ForEachIndex(output.sizes, [&](const TensorDimensions& index, uint64_t i)
+            {
+                uint64_t indicesOffset = 0;
+                for (int64_t j = 0; j < indexDimensions; ++j)
+                {
+                    indicesOffset += index[axis - indexDimensions + 1 + j] * indicesStrides[indicesRank - indexDimensions + j];
+                }
+
+                uint64_t offset = NormalizeIndex(indexValues[indicesOffset], input.sizes[axis]) * inputStrides[axis];
+                for (int64_t outputDim = 0; outputDim <= axis - indexDimensions; ++outputDim)
+                {
+                    const int64_t inputDim = outputDim + indexDimensions - 1;
+                    if (inputDim >= 0 && inputDim < axis)
+                    {
+                        offset += index[outputDim] * inputStrides[inputDim];
+                    }
+                }
+                for (int64_t dim = axis + 1; dim < rank; ++dim)
+                {
+                    offset += index[dim] * inputStrides[dim];
+                }
+                y[i] = x[offset];
+            });
+
+            Store(y, output);
+        }
+
+        inline void RunGatherElements(
+            uint32_t axis,
+            const TensorView& input,
+            const TensorView& indices,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& indexValues = scratch.Get(1);
+            std::vector<double>& y = scratch.Get(2);
+            Load(input, x);
+            Load(indices, output.sizes, indexValues);
+
+            const Strides inputStrides = GetPackedStrides(input.sizes);
+            y.resize(static_cast<size_t>(output.GetElementCount()));
+            ForEachIndex(output.sizes, [&](const TensorDimensions& index, uint64_t i)
+            {
+                TensorDimensions inputIndex = index;
+                inputIndex[axis] = NormalizeIndex(indexValues[i], input.sizes[axis]);
+                y[i] = x[GetOffset(inputIndex, inputStrides)];
+            });
+
+            Store(y, output);
+        }
+
+        inline void RunScatterElements(
+            uint32_t axis,
+            const TensorView& input,
+            const TensorView& indices,
+            const TensorView& updates,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& y = scratch.Get(0);
+            std::vector<double>& indexValues = scratch.Get(1);
+            std::vector<double>& updateValues = scratch.Get(2);
+            Load(input, output.sizes, y);
+            Load(indices, indexValues);
+            Load(updates, indices.sizes, updateValues);
+
+            const Strides outputStrides = GetPackedStrides(output.sizes);
+            ForEachIndex(indices.sizes, [&](const TensorDimensions& index, uint64_t i)
+            {
+                TensorDimensions outputIndex = index;
+                outputIndex[axis] = NormalizeIndex(indexValues[i], output.sizes[axis]);
+                y[GetOffset(outputIndex, outputStrides)] = updateValues[i];
+            });
+
+            Store(y, output);
+        }
+
+        // Tensors are padded with leading 1s; InputDimensionCount and IndicesDimensionCount give their actual ranks.
+        // Each row of the indices addresses a slice of the input, which is replaced by the matching slice of updates.
+        inline void RunScatterND(
+            const DML_SCATTER_ND_OPERATOR_DESC& desc,
+            const TensorView& input,
+            const TensorView& indices,
+            const TensorView& updates,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& y = scratch.Get(0);
+            std::vector<double>& indexValues = scratch.Get(1);
+            std::vector<double>& updateValues = scratch.Get(2);
+            Load(input, output.sizes, y);
+            Load(indices, indexValues);
+            Load(updates, updateValues);
+
+            const size_t inputRank = desc.InputDimensionCount;
+            const size_t outputPadding = output.sizes.size() - inputRank;
+            const uint32_t indexLength = indices.sizes.back();
+            if (indexLength > inputRank)
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            const Strides outputStrides = GetPackedStrides(output.sizes);
+            uint64_t sliceSize = 1;
+            for (size_t dim = outputPadding + indexLength; dim < output.sizes.size(); ++dim)
+            {
+                sliceSize *= output.sizes[dim];
+            }
+
+            const uint64_t rowCount = indexLength ? indexValues.size() / indexLength : 0;
+            for (uint64_t row = 0; row < rowCount; ++row)
+            {
+                uint64_t offset = 0;
+                for (uint32_t j = 0; j < indexLength; ++j)
+                {
+                    const size_t dim = outputPadding + j;
+                    offset += NormalizeIndex(indexValues[row * indexLength + j], output.sizes[dim]) * outputStrides[dim];
+                }
+                std::copy_n(updateValues.begin() + row * sliceSize, sliceSize, y.begin() + offset);
+            }
+
+            Store(y, output);
+        }
+
+        inline void RunOneHot(
+            uint32_t axis,
+            const TensorView& indices,
+            const TensorView& values,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& indexValues = scratch.Get(0);
+            std::vector<double>& onOffValues = scratch.Get(1);
+            std::vector<double>& y = scratch.Get(2);
+            Load(indices, indexValues);
+            Load(values, onOffValues);
+            if (onOffValues.size() < 2)
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            // Indices have the output's sizes with the axis dimension collapsed to 1
+            const Strides indicesStrides = GetPackedStrides(indices.sizes);
+            const uint32_t depth = output.sizes[axis];
+            y.resize(static_cast<size_t>(output.GetElementCount()));
+            ForEachIndex(output.sizes, [&](const TensorDimensions& index, uint64_t i)
+            {
+                TensorDimensions indicesIndex = index;
+                indicesIndex[axis] = 0;
+                int64_t hotIndex = static_cast<int64_t>(indexValues[GetOffset(indicesIndex, indicesStrides)]);
+                if (hotIndex < 0)
+                {
+                    hotIndex += depth;
+                }
+                y[i] = hotIndex == index[axis] ? onOffValues[1] : onOffValues[0];
+            });
+
+            Store(y, output);
+        }
+
+        inline void RunReverseSubsequences(
+            uint32_t axis,
+            const TensorView& input,
+            const TensorView& sequenceLengths,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& lengths = scratch.Get(1);
+            std::vector<double>& y = scratch.Get(2);
+            Load(input, x);
+            Load(sequenceLengths, lengths);
+
+            const Strides inputStrides = GetPackedStrides(input.sizes);
+            const Strides lengthStrides = GetPackedStrides(sequenceLengths.sizes);
+            y.resize(static_cast<size_t>(output.GetElementCount()));
+            ForEachIndex(output.sizes, [&](const TensorDimensions& index, uint64_t i)
+            {
+                TensorDimensions lengthIndex = index;
+                lengthIndex[axis] = 0;
+                const uint64_t length = std::min(static_cast<uint64_t>(lengths[GetOffset(lengthIndex, lengthStrides)]), uint64_t(input.sizes[axis]));
+
+                TensorDimensions inputIndex = index;
+                if (index[axis] < length)
+                {
+                    inputIndex[axis] = static_cast<uint32_t>(length - 1 - index[axis]);
+                }
+                y[i] = x[GetOffset(inputIndex, inputStrides)];
+            });
+
+            Store(y, output);
+        }
+
+        //
+        // Normalization
+        //
+
+        inline void RunBatchNormalization(
+            const DML_BATCH_NORMALIZATION_OPERATOR_DESC& desc,
+            const std::vector<TensorView>& inputs,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& mean = scratch.Get(1);
+            std::vector<double>& variance = scratch.Get(2);
+            std::vector<double>& scale = scratch.Get(3);
+            std::vector<double>& bias = scratch.Get(4);
+            Load(inputs[0], output.sizes, x);
+            Load(inputs[1], output.sizes, mean);
+            Load(inputs[2], output.sizes, variance);
+            Load(inputs[3], output.sizes, scale);
+            Load(inputs[4], output.sizes, bias);
+
+            for (size_t i = 0; i < x.size(); ++i)
+            {
+                x[i] = (x[i] - mean[i]) / std::sqrt(variance[i] + desc.Epsilon) * scale[i] + bias[i];
+            }
+
+            ApplyFusedActivation(desc.FusedActivation, x);
+            Store(x, output);
+        }
+
+        inline void RunMeanVarianceNormalization(
+            const DML_MEAN_VARIANCE_NORMALIZATION1_OPERATOR_DESC& desc,
+            const std::vector<TensorView>& inputs,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& scale = scratch.Get(1);
+            std::vector<double>& bias = scratch.Get(2);
+            std::vector<double>& mean = scratch.Get(3);
+            std::vector<double>& variance = scratch.Get(4);
+            Load(inputs[0], output.sizes, x);
+            if (inputs[1])
+            {
+                Load(inputs[1], output.sizes, scale);
+            }
+            if (inputs[2])
+            {
+                Load(inputs[2], output.sizes, bias);
+            }
+
+            // Statistics are computed over the normalized axes, for each position in the remaining axes
+            const size_t rank = output.sizes.size();
+            std::vector<bool> isNormalized(rank, false);
+            for (uint32_t i = 0; i < desc.AxisCount; ++i)
+            {
+                if (desc.Axes[i] >= rank)
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
+                isNormalized[desc.Axes[i]] = true;
+            }
+
+            Strides groupStrides(rank, 0);
+            uint64_t groupCount = 1;
+            for (size_t i = rank; i-- > 0;)
+            {
+                if (!isNormalized[i])
+                {
+                    groupStrides[i] = groupCount;
+                    groupCount *= output.sizes[i];
+                }
+            }
+            const double groupSize = groupCount ? static_cast<double>(x.size() / groupCount) : 1.0;
+
+            std::vector<uint64_t> groups;
+            groups.reserve(x.size());
+            ForEachOffset(output.sizes, groupStrides, [&](uint64_t offset) { groups.push_back(offset); });
+
+            mean.assign(static_cast<size_t>(groupCount), 0.0);
+            variance.assign(static_cast<size_t>(groupCount), 0.0);
+            for (size_t i = 0; i < x.size(); ++i)
+            {
+                mean[groups[i]] += x[i];
+            }
+            for (double& value : mean)
+            {
+                value /= groupSize;
+            }
+            for (size_t i = 0; i < x.size(); ++i)
+            {
+                const double difference = x[i] - mean[groups[i]];
+                variance[groups[i]] += difference * difference;
+            }
+            for (double& value : variance)
+            {
+                value /= groupSize;
+            }
+
+            for (size_t i = 0; i < x.size(); ++i)
+            {
+                double value = x[i] - mean[groups[i]];
+                if (desc.NormalizeVariance)
+                {
+                    value /= std::sqrt(variance[groups[i]] + desc.Epsilon);
+                }
+                if (inputs[1])
+                {
+                    value *= scale[i];
+                }
+                if (inputs[2])
+                {
+                    value += bias[i];
+                }
+                x[i] = value;
+            }
+
+            ApplyFusedActivation(desc.FusedActivation, x);
+            Store(x, output);
+        }
+
+        // The window is LocalSize channels when CrossChannel is set, or LocalSize x LocalSize spatial elements
+        // otherwise. Alpha is divided by the number of elements in the window.
+        inline void RunLocalResponseNormalization(
+            const DML_LOCAL_RESPONSE_NORMALIZATION_OPERATOR_DESC& desc,
+            const TensorView& input,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& y = scratch.Get(1);
+            Load(input, x);
+            if (input.sizes.size() != 4)
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            const int64_t channels = input.sizes[1];
+            const int64_t height = input.sizes[2];
+            const int64_t width = input.sizes[3];
+            const int64_t before = (int64_t(desc.LocalSize) - 1) / 2;
+            const int64_t after = int64_t(desc.LocalSize) - 1 - before;
+            const double windowSize = desc.CrossChannel ? double(desc.LocalSize) : double(desc.LocalSize) * desc.LocalSize;
+
+            y.resize(x.size());
+            ForEachIndex(input.sizes, [&](const TensorDimensions& index, uint64_t i)
+            {
+                const int64_t c = index[1], h = index[2], w = index[3];
+                const uint64_t batchOffset = uint64_t(index[0]) * channels * height * width;
+
+                double sumOfSquares = 0;
+                if (desc.CrossChannel)
+                {
+                    for (int64_t j = std::max(c - before, int64_t(0)); j <= std::min(c + after, channels - 1); ++j)
+                    {
+                        const double value = x[batchOffset + (j * height + h) * width + w];
+                        sumOfSquares += value * value;
+                    }
+                }
+                else
+                {
+                    for (int64_t j = std::max(h - before, int64_t(0)); j <= std::min(h + after, height - 1); ++j)
+                    {
+                        for (int64_t k = std::max(w - before, int64_t(0)); k <= std::min(w + after, width - 1); ++k)
+                        {
+                            const double value = x[batchOffset + (c * height + j) * width + k];
+                            sumOfSquares += value * value;
+                        }
+                    }
+                }
+
+                y[i] = x[i] / std::pow(desc.Bias + desc.Alpha / windowSize * sumOfSquares, double(desc.Beta));
+            });
+
+            Store(y, output);
+        }
+
+        //
+        // Recurrent networks
+        //
+
+        // Gates are ordered z (update), r (reset), h (hidden) in the weights, recurrence weights and biases. The bias
+        // holds the input biases of the three gates followed by their recurrence biases. Sequence steps past a batch
+        // entry's sequence length leave its hidden state unchanged and output zeros.
+        inline void RunGru(
+            const DML_GRU_OPERATOR_DESC& desc,
+            const std::vector<TensorView>& inputs,
+            const std::vector<TensorView>& outputs,
+            Scratch& scratch)
+        {
+            const TensorView& input = inputs[0];
+            const TensorView& outputSequence = outputs[0];
+            const TensorView& outputSingle = outputs[1];
+
+            std::vector<double>& x = scratch.Get(0);
+            std::vector<double>& weights = scratch.Get(1);
+            std::vector<double>& recurrence = scratch.Get(2);
+            std::vector<double>& bias = scratch.Get(3);
+            std::vector<double>& hidden = scratch.Get(4);
+            std::vector<double>& lengths = scratch.Get(5);
+            std::vector<double>& sequence = scratch.Get(6);
+            Load(input, x);
+            Load(inputs[1], weights);
+            Load(inputs[2], recurrence);
+
+            const uint32_t sequenceLength = input.sizes[1];
+            const uint32_t batchSize = input.sizes[2];
+            const uint32_t inputSize = input.sizes[3];
+            const uint32_t directionCount = inputs[1].sizes[1];
+            const uint32_t hiddenSize = inputs[2].sizes[3];
+
+            if (inputs[3])
+            {
+                Load(inputs[3], bias);
+            }
+            else
+            {
+                bias.assign(size_t(directionCount) * 6 * hiddenSize, 0.0);
+            }
+            if (inputs[4])
+            {
+                Load(inputs[4], hidden);
+            }
+            else
+            {
+                hidden.assign(size_t(directionCount) * batchSize * hiddenSize, 0.0);
+            }
+            if (inputs[5])
+            {
+                Load(inputs[5], lengths);
+            }
+            else
+            {
+                lengths.assign(batchSize, static_cast<double>(sequenceLength));
+            }
+
+            if (desc.ActivationDescCount < 2 * directionCount)
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            sequence.assign(size_t(sequenceLength) * directionCount * batchSize * hiddenSize, 0.0);
+            std::vector<double> gates(3 * size_t(hiddenSize));
+            std::vector<double> recurrenceGates(3 * size_t(hiddenSize));
+
+            for (uint32_t direction = 0; direction < directionCount; ++direction)
+            {
+                const bool reverse = desc.Direction == DML_RECURRENT_NETWORK_DIRECTION_BACKWARD ||
+                    (desc.Direction == DML_RECURRENT_NETWORK_DIRECTION_BIDIRECTIONAL && direction == 1);
+                const DML_OPERATOR_DESC& f = desc.ActivationDescs[direction * 2];
+                const DML_OPERATOR_DESC& g = desc.ActivationDescs[direction * 2 + 1];
+
+                const double* w = weights.data() + size_t(direction) * 3 * hiddenSize * inputSize;
+                const double* r = recurrence.data() + size_t(direction) * 3 * hiddenSize * hiddenSize;
+                const double* wb = bias.data() + size_t(direction) * 6 * hiddenSize;
+                const double* rb = wb + 3 * hiddenSize;
+
+                for (uint32_t batch = 0; batch < batchSize; ++batch)
+                {
+                    double* h = hidden.data() + (size_t(direction) * batchSize + batch) * hiddenSize;
+                    const uint32_t length = std::min(static_cast<uint32_t>(lengths[batch]), sequenceLength);
+
+                    for (uint32_t step = 0; step < length; ++step)
+                    {
+                        const uint32_t t = reverse ? length - 1 - step : step;
+                        const double* xt = x.data() + (size_t(t) * batchSize + batch) * inputSize;
+
+                        // gates = x * W^T + Wb; recurrenceGates = h * R^T + Rb
+                        for (uint32_t j = 0; j < 3 * hiddenSize; ++j)
+                        {
+                            double sum = wb[j];
+                            for (uint32_t i = 0; i < inputSize; ++i)
+                            {
+                                sum += xt[i] * w[size_t(j) * inputSize + i];
+                            }
+                            gates[j] = sum;
+
+                            // The hidden gate's recurrence is applied to r * h unless LinearBeforeReset is set
+                            if (j < 2 * hiddenSize || desc.LinearBeforeReset)
+                            {
+                                double recurrenceSum = rb[j];
+                                for (uint32_t i = 0; i < hiddenSize; ++i)
+                                {
+                                    recurrenceSum += h[i] * r[size_t(j) * hiddenSize + i];
+                                }
+                                recurrenceGates[j] = recurrenceSum;
+                            }
+                        }
+
+                        double* z = gates.data();
+                        double* resetGate = gates.data() + hiddenSize;
+                        double* hiddenGate = gates.data() + 2 * hiddenSize;
+                        for (uint32_t i = 0; i < 2 * hiddenSize; ++i)
+                        {
+                            gates[i] += recurrenceGates[i];
+                        }
+                        if (!ApplyActivation(f, gates.data(), 2 * size_t(hiddenSize)))
+                        {
+                            DMLX_THROW(E_NOTIMPL);
+                        }
+
+                        for (uint32_t j = 0; j < hiddenSize; ++j)
+                        {
+                            if (desc.LinearBeforeReset)
+                            {
+                                hiddenGate[j] += resetGate[j] * recurrenceGates[2 * hiddenSize + j];
+                            }
+                            else
+                            {
+                                double recurrenceSum = rb[2 * hiddenSize + j];
+                                for (uint32_t i = 0; i < hiddenSize; ++i)
+                                {
+                                    recurrenceSum += resetGate[i] * h[i] * r[size_t(2 * hiddenSize + j) * hiddenSize + i];
+                                }
+                                hiddenGate[j] += recurrenceSum;
+                            }
+                        }
+                        if (!ApplyActivation(g, hiddenGate, hiddenSize))
+                        {
+                            DMLX_THROW(E_NOTIMPL);
+                        }
+
+                        double* sequenceOutput = sequence.data() + ((size_t(t) * directionCount + direction) * batchSize + batch) * hiddenSize;
+                        for (uint32_t i = 0; i < hiddenSize; ++i)
+                        {
+                            h[i] = (1 - z[i]) * hiddenGate[i] + z[i] * h[i];
+                            sequenceOutput[i] = h[i];
+                        }
+                    }
+                }
+            }
+
+            if (outputSequence)
+            {
+                Store(sequence, outputSequence);
+            }
+            if (outputSingle)
+            {
+                Store(hidden, outputSingle);
+            }
+        }
+
+        //
+        // Blocked single-precision GEMM and convolution
+        //
+
+        // The micro-kernel computes an MR x NR tile of the output. K and N are blocked so that a packed block of B
+        // stays in cache while every row panel of A is multiplied by it. Tasks cover several row and column panels.
+        constexpr uint32_t GemmMR = 6;
+        constexpr uint32_t GemmNR = 16;
+        constexpr uint32_t GemmKC = 256;
+        constexpr uint32_t GemmNC = 2048;
+        constexpr uint32_t GemmRowPanelsPerTask = 8;
+        constexpr uint32_t GemmColumnPanelsPerTask = 16;
+
+        inline void ParallelFor(ThreadPool* threadPool, uint64_t count, const std::function<void(uint64_t)>& fn)
+        {
+            if (threadPool)
+            {
+                threadPool->ParallelFor(count, fn);
+                return;
+            }
+            for (uint64_t i = 0; i < count; ++i)
+            {
+                fn(i);
+            }
+        }
+
+        // Reads element `offset` of a FLOAT32 or FLOAT16 tensor.
+        inline float ReadFloat(const TensorView& view, uint64_t offset)
+        {
+            if (view.dataType == DML_TENSOR_DATA_TYPE_FLOAT32)
+            {
+                float value;
+                memcpy(&value, view.data + offset * sizeof(float), sizeof(float));
+                return value;
+            }
+
+            uint16_t bits;
+            memcpy(&bits, view.data + offset * sizeof(uint16_t), sizeof(uint16_t));
+            return HalfToFloat(bits);
+        }
+
+        // c (row stride ldc) += a * b for one tile, where a is a packed row panel (MR values per step of k) and b a
+        // packed column panel (NR values per step). Only the first `rows` x `columns` elements of the tile are
+        // written.
+        inline void GemmMicroKernel(uint32_t k, const float* a, const float* b, float* c, size_t ldc, uint32_t rows, uint32_t columns)
+        {
+#if DMLX_USE_AVX2
+            __m256 accumulators[GemmMR][2];
+            for (uint32_t r = 0; r < GemmMR; ++r)
+            {
+                accumulators[r][0] = _mm256_setzero_ps();
+                accumulators[r][1] = _mm256_setzero_ps();
+            }
+
+            for (uint32_t p = 0; p < k; ++p, a += GemmMR, b += GemmNR)
+            {
+                const __m256 b0 = _mm256_loadu_ps(b);
+                const __m256 b1 = _mm256_loadu_ps(b + 8);
+                for (uint32_t r = 0; r < GemmMR; ++r)
+                {
+                    const __m256 aValue = _mm256_broadcast_ss(a + r);
+                    accumulators[r][0] = _mm256_fmadd_ps(aValue, b0, accumulators[r][0]);
+                    accumulators[r][1] = _mm256_fmadd_ps(aValue, b1, accumulators[r][1]);
+                }
+            }
+
+            if (rows == GemmMR && columns == GemmNR)
+            {
+                for (uint32_t r = 0; r < GemmMR; ++r)
+                {
+                    float* row = c + r * ldc;
+                    _mm256_storeu_ps(row, _mm256_add_ps(_mm256_loadu_ps(row), accumulators[r][0]));
+                    _mm256_storeu_ps(row + 8, _mm256_add_ps(_mm256_loadu_ps(row + 8), accumulators[r][1]));
+                }
+                return;
+            }
+
+            float tile[GemmMR * GemmNR];
+            for (uint32_t r = 0; r < GemmMR; ++r)
+            {
+                _mm256_storeu_ps(tile + r * GemmNR, accumulators[r][0]);
+                _mm256_storeu_ps(tile + r * GemmNR + 8, accumulators[r][1]);
+            }
+#else
+            float tile[GemmMR * GemmNR] = {};
+            for (uint32_t p = 0; p < k; ++p, a += GemmMR, b += GemmNR)
+            {
+                for (uint32_t r = 0; r < GemmMR; ++r)
+                {
+                    const float aValue = a[r];
+                    for (uint32_t j = 0; j < GemmNR; ++j)
+                    {
+                        tile[r * GemmNR + j] += aValue * b[j];
+                    }
+                }
+            }
+#endif
+            for (uint32_t r = 0; r < rows; ++r)
+            {
+                for (uint32_t j = 0; j < columns; ++j)
+                {
+                    c[r * ldc + j] += tile[r * GemmNR + j];
+                }
+            }
+        }
+
+        // Packs an m x k matrix, whose elements are returned by get(row, p), into MR-row panels that each span the
+        // full depth. Rows past m are zero.
+        template <typename Get>
+        void PackRowPanels(uint32_t m, uint32_t k, Get&& get, std::vector<float>& packed, ThreadPool* threadPool)
+        {
+            const uint32_t rowPanels = (m + GemmMR - 1) / GemmMR;
+            packed.resize(size_t(rowPanels) * k * GemmMR);
+            ParallelFor(threadPool, rowPanels, [&](uint64_t panel)
+            {
+                float* destination = packed.data() + panel * k * GemmMR;
+                for (uint32_t p = 0; p < k; ++p)
+                {
+                    for (uint32_t r = 0; r < GemmMR; ++r)
+                    {
+                        const uint32_t row = static_cast<uint32_t>(panel) * GemmMR + r;
+                        *destination++ = row < m ? get(row, p) : 0.0f;
+                    }
+                }
+            });
+        }
+
+        // c (m x n, row stride ldc) += A * B. A is packed by PackRowPanels. packB(p0, kc, column0, columns, destination)
+        // packs rows [p0, p0 + kc) of B's columns [column0, column0 + columns) into an NR-wide panel, zero-filling
+        // columns past `columns`.
+        template <typename PackB>
+        void GemmDriver(uint32_t m, uint32_t n, uint32_t k, const float* packedA, PackB&& packB, float* c, size_t ldc, ThreadPool* threadPool)
+        {
+            if (m == 0 || n == 0 || k == 0)
+            {
+                return;
+            }
+
+            const uint32_t rowPanels = (m + GemmMR - 1) / GemmMR;
+            const uint32_t rowTasks = (rowPanels + GemmRowPanelsPerTask - 1) / GemmRowPanelsPerTask;
+            std::vector<float> packedB(size_t(std::min(k, GemmKC)) * ((std::min(n, GemmNC) + GemmNR - 1) / GemmNR) * GemmNR);
+
+            for (uint32_t jc = 0; jc < n; jc += GemmNC)
+            {
+                const uint32_t nc = std::min(GemmNC, n - jc);
+                const uint32_t columnPanels = (nc + GemmNR - 1) / GemmNR;
+                const uint32_t columnTasks = (columnPanels + GemmColumnPanelsPerTask - 1) / GemmColumnPanelsPerTask;
+
+                for (uint32_t pc = 0; pc < k; pc += GemmKC)
+                {
+                    const uint32_t kc = std::min(GemmKC, k - pc);
+
+                    ParallelFor(threadPool, columnPanels, [&](uint64_t panel)
+                    {
+                        const uint32_t column = static_cast<uint32_t>(panel) * GemmNR;
+                        packB(pc, kc, jc + column, std::min(GemmNR, nc - column), packedB.data() + panel * kc * GemmNR);
+                    });
+
+                    ParallelFor(threadPool, uint64_t(rowTasks) * columnTasks, [&](uint64_t task)
+                    {
+                        const uint32_t firstRowPanel = static_cast<uint32_t>(task / columnTasks) * GemmRowPanelsPerTask;
+                        const uint32_t firstColumnPanel = static_cast<uint32_t>(task % columnTasks) * GemmColumnPanelsPerTask;
+                        const uint32_t lastRowPanel = std::min(firstRowPanel + GemmRowPanelsPerTask, rowPanels);
+                        const uint32_t lastColumnPanel = std::min(firstColumnPanel + GemmColumnPanelsPerTask, columnPanels);
+
+                        for (uint32_t i = firstRowPanel; i < lastRowPanel; ++i)
+                        {
+                            const float* aPanel = packedA + (size_t(i) * k + pc) * GemmMR;
+                            for (uint32_t j = firstColumnPanel; j < lastColumnPanel; ++j)
+                            {
+                                GemmMicroKernel(
+                                    kc,
+                                    aPanel,
+                                    packedB.data() + size_t(j) * kc * GemmNR,
+                                    c + size_t(i) * GemmMR * ldc + jc + j * GemmNR,
+                                    ldc,
+                                    std::min(GemmMR, m - i * GemmMR),
+                                    std::min(GemmNR, nc - j * GemmNR));
+                            }
+                        }
+                    });
+                }
+            }
+        }
+
+        // Returns the offsets of a view's first element in each batch of the output, broadcasting the view's leading
+        // dimensions to batchSizes.
+        inline std::vector<uint64_t> GetBatchOffsets(const TensorView& view, Span<const uint32_t> batchSizes)
+        {
+            std::vector<uint64_t> offsets;
+            Strides strides(batchSizes.size(), 0);
+            for (size_t i = 0; i < batchSizes.size(); ++i)
+            {
+                if (view.sizes[i] == batchSizes[i])
+                {
+                    strides[i] = view.strides[i];
+                }
+                else if (view.sizes[i] != 1)
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
+            }
+            ForEachOffset(batchSizes, strides, [&](uint64_t offset) { offsets.push_back(offset); });
+            return offsets;
+        }
+
+        inline void RunGemmFloat(
+            const DML_GEMM_OPERATOR_DESC& desc,
+            const std::vector<TensorView>& inputs,
+            const std::vector<TensorView>& outputs,
+            ThreadPool* threadPool)
+        {
+            const TensorView& a = inputs[0];
+            const TensorView& b = inputs[1];
+            const TensorView& c = inputs[2];
+            const TensorView& output = outputs[0];
+
+            const size_t rank = output.sizes.size();
+            if (rank < 2 || a.sizes.size() != rank || b.sizes.size() != rank)
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            const bool transA = desc.TransA == DML_MATRIX_TRANSFORM_TRANSPOSE;
+            const bool transB = desc.TransB == DML_MATRIX_TRANSFORM_TRANSPOSE;
+            const uint32_t m = output.sizes[rank - 2];
+            const uint32_t n = output.sizes[rank - 1];
+            const uint32_t k = transA ? a.sizes[rank - 2] : a.sizes[rank - 1];
+
+            const Span<const uint32_t> batchSizes(output.sizes.data(), rank - 2);
+            const std::vector<uint64_t> aOffsets = GetBatchOffsets(a, batchSizes);
+            const std::vector<uint64_t> bOffsets = GetBatchOffsets(b, batchSizes);
+
+            // Element (row, p) of op(A) and (p, column) of op(B)
+            const uint64_t aRowStride = transA ? a.strides[rank - 1] : a.strides[rank - 2];
+            const uint64_t aDepthStride = transA ? a.strides[rank - 2] : a.strides[rank - 1];
+            const uint64_t bDepthStride = transB ? b.strides[rank - 1] : b.strides[rank - 2];
+            const uint64_t bColumnStride = transB ? b.strides[rank - 2] : b.strides[rank - 1];
+
+            // The output starts as beta * C, and alpha is folded into the packed A
+            std::vector<float> y(static_cast<size_t>(output.GetElementCount()), 0.0f);
+            if (c && desc.Beta != 0)
+            {
+                const Strides cStrides = GetBroadcastStrides(c, output.sizes);
+                float* value = y.data();
+                ForEachOffset(output.sizes, cStrides, [&](uint64_t offset) { *value++ = desc.Beta * ReadFloat(c, offset); });
+            }
+
+            std::vector<float> packedA;
+            for (size_t batch = 0; batch < aOffsets.size(); ++batch)
+            {
+                if (batch == 0 || aOffsets[batch] != aOffsets[batch - 1])
+                {
+                    const uint64_t aOffset = aOffsets[batch];
+                    PackRowPanels(m, k, [&](uint32_t row, uint32_t p)
+                    {
+                        return desc.Alpha * ReadFloat(a, aOffset + row * aRowStride + p * aDepthStride);
+                    }, packedA, threadPool);
+                }
+
+                const uint64_t bOffset = bOffsets[batch];
+                auto packB = [&](uint32_t p0, uint32_t kc, uint32_t column0, uint32_t columns, float* destination)
+                {
+                    for (uint32_t p = p0; p < p0 + kc; ++p)
+                    {
+                        for (uint32_t j = 0; j < GemmNR; ++j)
+                        {
+                            *destination++ = j < columns ? ReadFloat(b, bOffset + p * bDepthStride + (column0 + j) * bColumnStride) : 0.0f;
+                        }
+                    }
+                };
+
+                GemmDriver(m, n, k, packedA.data(), packB, y.data() + batch * m * n, n, threadPool);
+            }
+
+            ApplyFusedActivation(desc.FusedActivation, y);
+            Store(y, output);
+        }
+
+        // Forward convolutions are computed per batch and group as W (outputChannels x inputChannels * window) times
+        // the input unfolded into windows, which is packed on the fly. Backward convolutions compute W^T times the
+        // input into a column buffer, then add each column into the output windows it covers.
+        inline void RunConvolutionFloat(
+            const DML_CONVOLUTION_OPERATOR_DESC& desc,
+            const std::vector<TensorView>& inputs,
+            const std::vector<TensorView>& outputs,
+            ThreadPool* threadPool)
+        {
+            const TensorView& input = inputs[0];
+            const TensorView& filter = inputs[1];
+            const TensorView& bias = inputs[2];
+            const TensorView& output = outputs[0];
+
+            const bool forward = desc.Direction == DML_CONVOLUTION_DIRECTION_FORWARD;
+            const bool flip = desc.Mode == DML_CONVOLUTION_MODE_CONVOLUTION;
+            const uint32_t dimensionCount = desc.DimensionCount;
+            const Span<const uint32_t> filterSizes = filter.sizes;
+            const WindowParameters params = forward
+                ? GetWindowParameters(dimensionCount, input.sizes, output.sizes, filterSizes.data() + 2, desc.Strides, desc.Dilations, desc.StartPadding)
+                : GetWindowParameters(dimensionCount, output.sizes, input.sizes, filterSizes.data() + 2, desc.Strides, desc.Dilations, desc.StartPadding);
+
+            const uint32_t batchSize = output.sizes[0];
+            const uint32_t outputChannels = output.sizes[1];
+            const uint32_t inputChannels = input.sizes[1];
+            const uint32_t groupCount = std::max(desc.GroupCount, 1u);
+            const uint32_t groupInputChannels = inputChannels / groupCount;
+            const uint32_t groupOutputChannels = outputChannels / groupCount;
+            const uint32_t windowSize = static_cast<uint32_t>(params.GetWindowSize());
+
+            // Spatial strides of the views, padded to three dimensions like the window parameters
+            auto getSpatialStrides = [&](const TensorView& view)
+            {
+                std::array<uint64_t, 3> strides = { 0, 0, 0 };
+                for (uint32_t i = 0; i < dimensionCount; ++i)
+                {
+                    strides[3 - dimensionCount + i] = view.strides[2 + i];
+                }
+                return strides;
+            };
+            const std::array<uint64_t, 3> inputSpatialStrides = getSpatialStrides(input);
+            const std::array<uint64_t, 3> filterSpatialStrides = getSpatialStrides(filter);
+
+            // Offsets of each window element in the filter, and its offset from the window origin in the (forward)
+            // input, in elements of each dimension
+            std::vector<uint64_t> filterWindowOffsets(windowSize);
+            std::vector<std::array<int64_t, 3>> windowDisplacements(windowSize);
+            {
+                uint32_t w = 0;
+                const uint32_t windowIndexSizes[3] = { params.windowSizes[0], params.windowSizes[1], params.windowSizes[2] };
+                ForEachSpatialIndex(windowIndexSizes, [&](const uint32_t (&index)[3])
+                {
+                    filterWindowOffsets[w] = index[0] * filterSpatialStrides[0] + index[1] * filterSpatialStrides[1] + index[2] * filterSpatialStrides[2];
+                    for (uint32_t d = 0; d < 3; ++d)
+                    {
+                        windowDisplacements[w][d] = int64_t(index[d]) * params.dilations[d];
+                    }
+                    ++w;
+                });
+            }
+            auto getFilterWindowOffset = [&](uint32_t w) { return filterWindowOffsets[flip ? windowSize - 1 - w : w]; };
+
+            // Origins of the windows at each position of the smaller (forward: output) side
+            const uint64_t windowPositionCount = params.GetOutputSize();
+            std::vector<std::array<int64_t, 3>> windowOrigins(static_cast<size_t>(windowPositionCount));
+            {
+                size_t position = 0;
+                ForEachSpatialIndex(params.outputSizes, [&](const uint32_t (&index)[3])
+                {
+                    for (uint32_t d = 0; d < 3; ++d)
+                    {
+                        windowOrigins[position][d] = int64_t(index[d]) * params.strides[d] - params.startPadding[d];
+                    }
+                    ++position;
+                });
+            }
+
+            const uint64_t outputChannelSize = forward ? params.GetOutputSize() : params.GetInputSize();
+            std::vector<float> y(static_cast<size_t>(output.GetElementCount()));
+            ParallelFor(threadPool, uint64_t(batchSize) * outputChannels, [&](uint64_t channel)
+            {
+                const float value = bias ? ReadFloat(bias, (channel % outputChannels) * bias.strides[1]) : 0.0f;
+                std::fill_n(y.begin() + channel * outputChannelSize, outputChannelSize, value);
+            });
+
+            std::vector<float> packedA;
+            if (forward)
+            {
+                const uint32_t m = groupOutputChannels;
+                const uint32_t k = groupInputChannels * windowSize;
+                const uint32_t n = static_cast<uint32_t>(windowPositionCount);
+
+                for (uint32_t group = 0; group < groupCount; ++group)
+                {
+                    PackRowPanels(m, k, [&](uint32_t row, uint32_t p)
+                    {
+                        const uint64_t offset = (group * groupOutputChannels + row) * filter.strides[0] +
+                            (p / windowSize) * filter.strides[1] + getFilterWindowOffset(p % windowSize);
+                        return ReadFloat(filter, offset);
+                    }, packedA, threadPool);
+
+                    for (uint32_t batch = 0; batch < batchSize; ++batch)
+                    {
+                        const uint64_t inputBase = batch * input.strides[0] + uint64_t(group) * groupInputChannels * input.strides[1];
+                        auto packB = [&](uint32_t p0, uint32_t kc, uint32_t column0, uint32_t columns, float* destination)
+                        {
+                            for (uint32_t p = p0; p < p0 + kc; ++p, destination += GemmNR)
+                            {
+                                const uint64_t channelBase = inputBase + (p / windowSize) * input.strides[1];
+                                const std::array<int64_t, 3>& displacement = windowDisplacements[p % windowSize];
+                                for (uint32_t j = 0; j < GemmNR; ++j)
+                                {
+                                    float value = 0;
+                                    if (j < columns)
+                                    {
+                                        const std::array<int64_t, 3>& origin = windowOrigins[column0 + j];
+                                        const int64_t i0 = origin[0] + displacement[0];
+                                        const int64_t i1 = origin[1] + displacement[1];
+                                        const int64_t i2 = origin[2] + displacement[2];
+                                        if (i0 >= 0 && i0 < params.inputSizes[0] &&
+                                            i1 >= 0 && i1 < params.inputSizes[1] &&
+                                            i2 >= 0 && i2 < params.inputSizes[2])
+                                        {
+                                            value = ReadFloat(input, channelBase +
+                                                i0 * inputSpatialStrides[0] + i1 * inputSpatialStrides[1] + i2 * inputSpatialStrides[2]);
+                                        }
+                                    }
+                                    destination[j] = value;
+                                }
+                            }
+                        };
+
+                        float* c = y.data() + (uint64_t(batch) * outputChannels + group * groupOutputChannels) * outputChannelSize;
+                        GemmDriver(m, n, k, packedA.data(), packB, c, n, threadPool);
+                    }
+                }
+            }
+            else
+            {
+                // Filter: [inputChannels, groupOutputChannels, window...]. Rows of the column buffer are (output
+                // channel, window element) pairs; columns are input positions.
+                const uint32_t m = groupOutputChannels * windowSize;
+                const uint32_t k = groupInputChannels;
+                const uint32_t n = static_cast<uint32_t>(windowPositionCount);
+                std::vector<float> columnBuffer(size_t(m) * n);
+
+                std::vector<uint64_t> inputPositionOffsets(n);
+                for (uint32_t j = 0; j < n; ++j)
+                {
+                    const std::array<int64_t, 3>& origin = windowOrigins[j];
+                    const uint64_t i0 = (origin[0] + params.startPadding[0]) / params.strides[0];
+                    const uint64_t i1 = (origin[1] + params.startPadding[1]) / params.strides[1];
+                    const uint64_t i2 = (origin[2] + params.startPadding[2]) / params.strides[2];
+                    inputPositionOffsets[j] = i0 * inputSpatialStrides[0] + i1 * inputSpatialStrides[1] + i2 * inputSpatialStrides[2];
+                }
+
+                for (uint32_t group = 0; group < groupCount; ++group)
+                {
+                    PackRowPanels(m, k, [&](uint32_t row, uint32_t p)
+                    {
+                        const uint64_t offset = (group * groupInputChannels + p) * filter.strides[0] +
+                            (row / windowSize) * filter.strides[1] + getFilterWindowOffset(row % windowSize);
+                        return ReadFloat(filter, offset);
+                    }, packedA, threadPool);
+
+                    for (uint32_t batch = 0; batch < batchSize; ++batch)
+                    {
+                        const uint64_t inputBase = batch * input.strides[0] + uint64_t(group) * groupInputChannels * input.strides[1];
+                        auto packB = [&](uint32_t p0, uint32_t kc, uint32_t column0, uint32_t columns, float* destination)
+                        {
+                            for (uint32_t p = p0; p < p0 + kc; ++p, destination += GemmNR)
+                            {
+                                const uint64_t channelBase = inputBase + p * input.strides[1];
+                                for (uint32_t j = 0; j < GemmNR; ++j)
+                                {
+                                    destination[j] = j < columns ? ReadFloat(input, channelBase + inputPositionOffsets[column0 + j]) : 0.0f;
+                                }
+                            }
+                        };
+
+                        std::fill(columnBuffer.begin(), columnBuffer.end(), 0.0f);
+                        GemmDriver(m, n, k, packedA.data(), packB, columnBuffer.data(), n, threadPool);
+
+                        // Each output channel only receives its own rows, so channels are independent
+                        ParallelFor(threadPool, groupOutputChannels, [&](uint64_t channel)
+                        {
+                            float* yChannel = y.data() + (uint64_t(batch) * outputChannels + group * groupOutputChannels + channel) * outputChannelSize;
+                            for (uint32_t w = 0; w < windowSize; ++w)
+                            {
+                                const float* column = columnBuffer.data() + (channel * windowSize + w) * n;
+                                const std::array<int64_t, 3>& displacement = windowDisplacements[w];
+                                for (uint32_t j = 0; j < n; ++j)
+                                {
+                                    const std::array<int64_t, 3>& origin = windowOrigins[j];
+                                    const int64_t o0 = origin[0] + displacement[0];
+                                    const int64_t o1 = origin[1] + displacement[1];
+                                    const int64_t o2 = origin[2] + displacement[2];
+                                    if (o0 >= 0 && o0 < params.inputSizes[0] &&
+                                        o1 >= 0 && o1 < params.inputSizes[1] &&
+                                        o2 >= 0 && o2 < params.inputSizes[2])
+                                    {
+                                        yChannel[(o0 * params.inputSizes[1] + o1) * params.inputSizes[2] + o2] += column[j];
+                                    }
+                                }
+                            }
+                        });
+                    }
+                }
+            }
+
+            ApplyFusedActivation(desc.FusedActivation, y);
+            Store(y, output);
+        }
+
+        //
+        // Dispatch
+        //
+
+        inline void RunActivation(
+            const DML_OPERATOR_DESC& desc,
+            const TensorView& input,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            auto run = [&](auto& values)
+            {
+                Load(input, output.sizes, values);
+                if (!ApplyActivation(desc, values.data(), values.size()))
+                {
+                    DMLX_THROW(E_NOTIMPL);
+                }
+                Store(values, output);
+            };
+
+            // Floating-point activations run in single precision, which vectorizes the transcendental ones
+            if (IsFloatTensor(input) && IsFloatTensor(output))
+            {
+                run(scratch.GetFloat(0));
+            }
+            else
+            {
+                run(scratch.Get(0));
+            }
+        }
+
+        inline void RunFill(
+            DML_TENSOR_DATA_TYPE valueDataType,
+            const DML_SCALAR_UNION& start,
+            const DML_SCALAR_UNION* delta,
+            const TensorView& output,
+            Scratch& scratch)
+        {
+            std::vector<double>& y = scratch.Get(0);
+            y.resize(static_cast<size_t>(output.GetElementCount()));
+
+            const double startValue = ReadScalar(valueDataType, start);
+            const double deltaValue = delta ? ReadScalar(valueDataType, *delta) : 0.0;
+            for (size_t i = 0; i < y.size(); ++i)
+            {
+                y[i] = startValue + static_cast<double>(i) * deltaValue;
+            }
+
+            Store(y, output);
+        }
+
+        // Runs one operator. Inputs and outputs are in the order of the desc's tensors; absent optional tensors are
+        // empty views. Kernels that parallelize internally use the thread pool, if any.
+        inline void RunOperator(
+            const DML_OPERATOR_DESC& desc,
+            const std::vector<TensorView>& inputs,
+            const std::vector<TensorView>& outputs,
+            Scratch& scratch,
+            ThreadPool* threadPool)
+        {
+            switch (desc.Type)
+            {
+            case DML_OPERATOR_ACTIVATION_ELU:
+            case DML_OPERATOR_ACTIVATION_CELU:
+            case DML_OPERATOR_ACTIVATION_HARD_SIGMOID:
+            case DML_OPERATOR_ACTIVATION_IDENTITY:
+            case DML_OPERATOR_ACTIVATION_LEAKY_RELU:
+            case DML_OPERATOR_ACTIVATION_LINEAR:
+            case DML_OPERATOR_ACTIVATION_PARAMETRIC_SOFTPLUS:
+            case DML_OPERATOR_ACTIVATION_RELU:
+            case DML_OPERATOR_ACTIVATION_SCALED_ELU:
+            case DML_OPERATOR_ACTIVATION_SCALED_TANH:
+            case DML_OPERATOR_ACTIVATION_SIGMOID:
+            case DML_OPERATOR_ACTIVATION_SOFTPLUS:
+            case DML_OPERATOR_ACTIVATION_SOFTSIGN:
+            case DML_OPERATOR_ACTIVATION_TANH:
+            case DML_OPERATOR_ACTIVATION_THRESHOLDED_RELU:
+            case DML_OPERATOR_ACTIVATION_SHRINK:
+                RunActivation(desc, inputs[0], outputs[0], scratch);
+                break;
+
+            case DML_OPERATOR_ACTIVATION_SOFTMAX:
+            case DML_OPERATOR_ACTIVATION_LOG_SOFTMAX:
+            case DML_OPERATOR_ACTIVATION_HARDMAX:
+                RunSoftmax(desc.Type, inputs[0], outputs[0], scratch);
+                break;
+
+            case DML_OPERATOR_ACTIVATION_PARAMETERIZED_RELU:
+                RunBinary(inputs[0], inputs[1], outputs[0], nullptr, scratch, [](double x, double slope) { return x >= 0 ? x : slope * x; });
+                break;
+
+            case DML_OPERATOR_CONVOLUTION:
+                if (IsFloatTensors(inputs, outputs))
+                {
+                    RunConvolutionFloat(*static_cast<const DML_CONVOLUTION_OPERATOR_DESC*>(desc.Desc), inputs, outputs, threadPool);
+                }
+                else
+                {
+                    RunConvolution(*static_cast<const DML_CONVOLUTION_OPERATOR_DESC*>(desc.Desc), inputs, outputs, scratch);
+                }
+                break;
+
+            case DML_OPERATOR_GEMM:
+                if (IsFloatTensors(inputs, outputs))
+                {
+                    RunGemmFloat(*static_cast<const DML_GEMM_OPERATOR_DESC*>(desc.Desc), inputs, outputs, threadPool);
+                }
+                else
+                {
+                    RunGemm(*static_cast<const DML_GEMM_OPERATOR_DESC*>(desc.Desc), inputs, outputs, scratch);
+                }
+                break;
+
+            case DML_OPERATOR_REDUCE:
+                RunReduce(*static_cast<const DML_REDUCE_OPERATOR_DESC*>(desc.Desc), inputs, outputs, scratch);
+                break;
+
+            case DML_OPERATOR_AVERAGE_POOLING:
+            {
+                const auto& pooling = *static_cast<const DML_AVERAGE_POOLING_OPERATOR_DESC*>(desc.Desc);
+                const WindowParameters params = GetWindowParameters(pooling.DimensionCount, inputs[0].sizes, outputs[0].sizes,
+                    pooling.WindowSize, pooling.Strides, nullptr, pooling.StartPadding);
+                RunPooling(params, false, !!pooling.IncludePadding, inputs[0], outputs[0], TensorView(), scratch);
+                break;
+            }
+
+            case DML_OPERATOR_MAX_POOLING2:
+            {
+                const auto& pooling = *static_cast<const DML_MAX_POOLING2_OPERATOR_DESC*>(desc.Desc);
+                const WindowParameters params = GetWindowParameters(pooling.DimensionCount, inputs[0].sizes, outputs[0].sizes,
+                    pooling.WindowSize, pooling.Strides, pooling.Dilations, pooling.StartPadding);
+                RunPooling(params, true, false, inputs[0], outputs[0], outputs[1], scratch);
+                break;
+            }
+
+            case DML_OPERATOR_SLICE1:
+                RunSlice(*static_cast<const DML_SLICE1_OPERATOR_DESC*>(desc.Desc), inputs[0], outputs[0], scratch);
+                break;
+
+            case DML_OPERATOR_CAST:
+            {
+                // Conversion to the output's data type happens on store
+                std::vector<double>& values = scratch.Get(0);
+                Load(inputs[0], outputs[0].sizes, values);
+                Store(values, outputs[0]);
+                break;
+            }
+
+            case DML_OPERATOR_SPLIT:
+                RunSplit(*static_cast<const DML_SPLIT_OPERATOR_DESC*>(desc.Desc), inputs[0], outputs, scratch);
+                break;
+
+            case DML_OPERATOR_JOIN:
+                RunJoin(*static_cast<const DML_JOIN_OPERATOR_DESC*>(desc.Desc), inputs, outputs[0], scratch);
+                break;
+
+            case DML_OPERATOR_PADDING:
+                RunPadding(*static_cast<const DML_PADDING_OPERATOR_DESC*>(desc.Desc), inputs[0], outputs[0], scratch);
+                break;
+
+            case DML_OPERATOR_VALUE_SCALE_2D:
+            {
+                const auto& valueScale = *static_cast<const DML_VALUE_SCALE_2D_OPERATOR_DESC*>(desc.Desc);
+                std::vector<double>& values = scratch.Get(0);
+                Load(inputs[0], outputs[0].sizes, values);
+                ForEachIndex(outputs[0].sizes, [&](const TensorDimensions& index, uint64_t i)
+                {
+                    values[i] = values[i] * valueScale.Scale + valueScale.Bias[index[1]];
+                });
+                Store(values, outputs[0]);
+                break;
+            }
+
+            case DML_OPERATOR_UPSAMPLE_2D:
+            {
+                const auto& upsample = *static_cast<const DML_UPSAMPLE_2D_OPERATOR_DESC*>(desc.Desc);
+                const float scales[] = { 1, 1, float(upsample.ScaleSize.Height), float(upsample.ScaleSize.Width) };
+                const float inputPixelOffsets[] = { 0.5f, 0.5f, 0.5f, 0.5f };
+                const float outputPixelOffsets[] = { -0.5f, -0.5f, -0.5f, -0.5f };
+                if (inputs[0].sizes.size() != 4)
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
+                RunResample(upsample.InterpolationMode, scales, inputPixelOffsets, outputPixelOffsets, inputs[0], outputs[0], scratch);
+                break;
+            }
+
+            case DML_OPERATOR_RESAMPLE1:
+            {
+                const auto& resample = *static_cast<const DML_RESAMPLE1_OPERATOR_DESC*>(desc.Desc);
+                const uint32_t count = resample.DimensionCount;
+                RunResample(
+                    resample.InterpolationMode,
+                    Span<const float>(resample.Scales, count),
+                    Span<const float>(resample.InputPixelOffsets, count),
+                    Span<const float>(resample.OutputPixelOffsets, count),
+                    inputs[0],
+                    outputs[0],
+                    scratch);
+                break;
+            }
+
+            case DML_OPERATOR_GATHER:
+                RunGather(*static_cast<const DML_GATHER_OPERATOR_DESC*>(desc.Desc), inputs[0], inputs[1], outputs[0], scratch);
+                break;
+
+            case DML_OPERATOR_GATHER_ELEMENTS:
+            {
+                const uint32_t axis = static_cast<const DML_GATHER_ELEMENTS_OPERATOR_DESC*>(desc.Desc)->Axis;
+                RunGatherElements(axis, inputs[0], inputs[1], outputs[0], scratch);
+                break;
+            }
+
+            case DML_OPERATOR_SCATTER_ELEMENTS:
+            {
+                const uint32_t axis = static_cast<const DML_SCATTER_ELEMENTS_OPERATOR_DESC*>(desc.Desc)->Axis;
+                RunScatterElements(axis, inputs[0], inputs[1], inputs[2], outputs[0], scratch);
+                break;
+            }
+
+            case DML_OPERATOR_SCATTER_ND:
+                RunScatterND(*static_cast<const DML_SCATTER_ND_OPERATOR_DESC*>(desc.Desc), inputs[0], inputs[1], inputs[2], outputs[0], scratch);
+                break;
+
+            case DML_OPERATOR_TILE:
+                RunTile(inputs[0], outputs[0], scratch);
+                break;
+
+            case DML_OPERATOR_BATCH_NORMALIZATION:
+                RunBatchNormalization(*static_cast<const DML_BATCH_NORMALIZATION_OPERATOR_DESC*>(desc.Desc), inputs, outputs[0], scratch);
+                break;
+
+            case DML_OPERATOR_MEAN_VARIANCE_NORMALIZATION1:
+                RunMeanVarianceNormalization(*static_cast<const DML_MEAN_VARIANCE_NORMALIZATION1_OPERATOR_DESC*>(desc.Desc), inputs, outputs[0], scratch);
+                break;
+
+            case DML_OPERATOR_LOCAL_RESPONSE_NORMALIZATION:
+                RunLocalResponseNormalization(*static_cast<const DML_LOCAL_RESPONSE_NORMALIZATION_OPERATOR_DESC*>(desc.Desc), inputs[0], outputs[0], scratch);
+                break;
+
+            case DML_OPERATOR_GRU:
+                RunGru(*static_cast<const DML_GRU_OPERATOR_DESC*>(desc.Desc), inputs, outputs, scratch);
+                break;
+
+            case DML_OPERATOR_ONE_HOT:
+            {
+                const uint32_t axis = static_cast<const DML_ONE_HOT_OPERATOR_DESC*>(desc.Desc)->Axis;
+                RunOneHot(axis, inputs[0], inputs[1], outputs[0], scratch);
+                break;
+            }
+
+            case DML_OPERATOR_FILL_VALUE_CONSTANT:
+            {
+                const auto& fill = *static_cast<const DML_FILL_VALUE_CONSTANT_OPERATOR_DESC*>(desc.Desc);
+                RunFill(fill.ValueDataType, fill.Value, nullptr, outputs[0], scratch);
+                break;
+            }
+
+            case DML_OPERATOR_FILL_VALUE_SEQUENCE:
+            {
+                const auto& fill = *static_cast<const DML_FILL_VALUE_SEQUENCE_OPERATOR_DESC*>(desc.Desc);
+                RunFill(fill.ValueDataType, fill.ValueStart, &fill.ValueDelta, outputs[0], scratch);
+                break;
+            }
+
+            case DML_OPERATOR_REVERSE_SUBSEQUENCES:
+            {
+                const uint32_t axis = static_cast<const DML_REVERSE_SUBSEQUENCES_OPERATOR_DESC*>(desc.Desc)->Axis;
+                RunReverseSubsequences(axis, inputs[0], inputs[1], outputs[0], scratch);
+                break;
+            }
+
+            case DML_OPERATOR_RANDOM_GENERATOR:
+            case DML_OPERATOR_RESAMPLE_GRAD:
+                DMLX_THROW(E_NOTIMPL);
+                break;
+
+            default:
+                RunElementWise(desc, inputs, outputs, scratch);
+                break;
+            }
+        }
+    } // namespace detail
+
+    // Computes a DirectML convolution on the CPU. The tensors must be FLOAT32 or FLOAT16 buffers laid out as their
+    // descs describe; bias may be null if the desc has no bias tensor.
+    inline void Convolution(
+        const DML_CONVOLUTION_OPERATOR_DESC& desc,
+        const void* input,
+        const void* filter,
+        const void* bias,
+        void* output,
+        ThreadPool* threadPool = nullptr)
+    {
+        const std::vector<detail::TensorView> inputs =
+        {
+            detail::MakeTensorView(desc.InputTensor, static_cast<uint8_t*>(const_cast<void*>(input))),
+            detail::MakeTensorView(desc.FilterTensor, static_cast<uint8_t*>(const_cast<void*>(filter))),
+            detail::MakeTensorView(desc.BiasTensor, static_cast<uint8_t*>(const_cast<void*>(bias))),
+        };
+        const std::vector<detail::TensorView> outputs = { detail::MakeTensorView(desc.OutputTensor, static_cast<uint8_t*>(output)) };
+
+        if (!inputs[0] || !inputs[1] || !outputs[0] || !detail::IsFloatTensors(inputs, outputs))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+        detail::RunConvolutionFloat(desc, inputs, outputs, threadPool);
+    }
+
+    // Computes a DirectML GEMM on the CPU. The tensors must be FLOAT32 or FLOAT16 buffers laid out as their descs
+    // describe; c may be null if the desc has no C tensor.
+    inline void Gemm(
+        const DML_GEMM_OPERATOR_DESC& desc,
+        const void* a,
+        const void* b,
+        const void* c,
+        void* output,
+        ThreadPool* threadPool = nullptr)
+    {
+        const std::vector<detail::TensorView> inputs =
+        {
+            detail::MakeTensorView(desc.ATensor, static_cast<uint8_t*>(const_cast<void*>(a))),
+            detail::MakeTensorView(desc.BTensor, static_cast<uint8_t*>(const_cast<void*>(b))),
+            detail::MakeTensorView(desc.CTensor, static_cast<uint8_t*>(const_cast<void*>(c))),
+        };
+        const std::vector<detail::TensorView> outputs = { detail::MakeTensorView(desc.OutputTensor, static_cast<uint8_t*>(output)) };
+
+        if (!inputs[0] || !inputs[1] || !outputs[0] || !detail::IsFloatTensors(inputs, outputs))
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+        detail::RunGemmFloat(desc, inputs, outputs, threadPool);
+    }
+
+    // Computes output[i] = function(input[i] * scale + bias) for packed arrays of FLOAT32 or FLOAT16 elements, where
+    // the scale and bias come from scaleBias if it isn't null. input and output may be the same array.
+    inline void Evaluate(
+        MathFunction function,
+        DML_TENSOR_DATA_TYPE dataType,
+        const void* input,
+        void* output,
+        size_t elementCount,
+        const DML_SCALE_BIAS* scaleBias = nullptr)
+    {
+        const float scale = scaleBias ? scaleBias->Scale : 1.0f;
+        const float bias = scaleBias ? scaleBias->Bias : 0.0f;
+
+        if (dataType == DML_TENSOR_DATA_TYPE_FLOAT32)
+        {
+            detail::EvaluateFloat(function, scale, bias, static_cast<const float*>(input), static_cast<float*>(output), elementCount);
+        }
+        else if (dataType == DML_TENSOR_DATA_TYPE_FLOAT16)
+        {
+            // Converted in blocks that stay in L1
+            const uint16_t* inputHalves = static_cast<const uint16_t*>(input);
+            uint16_t* outputHalves = static_cast<uint16_t*>(output);
+            float values[256];
+            for (size_t start = 0; start < elementCount; start += std::size(values))
+            {
+                const size_t count = std::min(std::size(values), elementCount - start);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    values[i] = detail::HalfToFloat(inputHalves[start + i]);
+                }
+                detail::EvaluateFloat(function, scale, bias, values, values, count);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    outputHalves[start + i] = detail::FloatToHalf(values[i]);
+                }
+            }
+        }
+        else
+        {
+            DMLX_THROW(E_INVALIDARG);
+        }
+    }
+
+    struct ExecutorOptions
+    {
+        // Number of threads that run operators, including the thread that calls Execute. 0 uses one thread per
+        // hardware thread.
+        uint32_t threadCount = 0;
+
+        // Runs operators on an existing pool instead of creating one; threadCount is then ignored.
+        std::shared_ptr<ThreadPool> threadPool;
+    };
+
+    // Runs the graph that dml::Graph::Compile would build for a set of outputs on the CPU. Construction captures the
+    // graph's operators and constant input data, so the dml::Graph may be modified or destroyed afterwards.
+    //
+    // Execute binds inputs and outputs like a compiled DirectML operator: inputs[i] and outputs[i] are host buffers
+    // for graph input and output i. Constant inputs may be bound as null, in which case the graph's constant data is
+    // used. An Executor runs one Execute call at a time, but several executors may share a thread pool.
+    class Executor
+    {
+    public:
+        Executor(const Graph& graph, Span<const Expression> outputs, ExecutorOptions options = {})
+        {
+            dml::detail::GraphDesc graphDesc;
+            const std::shared_ptr<dml::detail::GraphBuilder> builder = graph.BuildGraphDesc(outputs, graphDesc);
+            m_inputCount = graphDesc.inputCount;
+            m_outputCount = graphDesc.outputCount;
+            m_statistics = builder->GetStatistics();
+
+            m_nodes.resize(graphDesc.nodes.size());
+            for (size_t i = 0; i < m_nodes.size(); ++i)
+            {
+                const DML_OPERATOR_DESC* desc = builder->GetOperatorDesc(graphDesc.nodes[i]);
+                if (!desc)
+                {
+                    DMLX_THROW(E_NOTIMPL);
+                }
+
+                Node& node = m_nodes[i];
+                node.desc = dml::detail::OwnedOperatorDesc(desc->Type, desc->Desc);
+
+                const dml::detail::OperatorDescTensors tensors = dml::detail::OperatorDescTensors::Get(node.desc);
+                node.inputTensors.assign(tensors.inputTensors.begin(), tensors.inputTensors.end());
+                node.outputTensors.assign(tensors.outputTensors.begin(), tensors.outputTensors.end());
+                node.inputs.resize(node.inputTensors.size());
+                node.outputs.resize(node.outputTensors.size());
+            }
+
+            for (const DML_INPUT_GRAPH_EDGE_DESC& edge : graphDesc.inputEdges)
+            {
+                m_nodes[edge.ToNodeIndex].inputs[edge.ToNodeInputIndex] = { BindingType::GraphInput, edge.GraphInputIndex };
+            }
+
+            // A node output that is bound to several graph outputs is written to the first and copied to the rest
+            m_outputTensors.resize(m_outputCount);
+            for (const DML_OUTPUT_GRAPH_EDGE_DESC& edge : graphDesc.outputEdges)
+            {
+                Node& node = m_nodes[edge.FromNodeIndex];
+                m_outputTensors[edge.GraphOutputIndex] = node.outputTensors[edge.FromNodeOutputIndex];
+                Binding& binding = node.outputs[edge.FromNodeOutputIndex];
+                if (binding.type == BindingType::None)
+                {
+                    binding = { BindingType::GraphOutput, edge.GraphOutputIndex };
+                }
+                else
+                {
+                    node.outputCopies.push_back({ edge.FromNodeOutputIndex, edge.GraphOutputIndex });
+                }
+            }
+
+            // Every other node output gets its own region of the intermediate buffer. Regions aren't shared, since
+            // independent operators may run at the same time.
+            auto bindIntermediate = [&](uint32_t nodeIndex, uint32_t outputIndex)
+            {
+                Binding& binding = m_nodes[nodeIndex].outputs[outputIndex];
+                const DML_TENSOR_DESC* tensor = m_nodes[nodeIndex].outputTensors[outputIndex];
+                if (binding.type == BindingType::None && tensor)
+                {
+                    const auto& bufferDesc = *static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc);
+                    binding = { BindingType::Intermediate, m_intermediateSizeInBytes };
+                    m_intermediateSizeInBytes += (bufferDesc.TotalTensorSizeInBytes + 15) & ~uint64_t(15);
+                }
+                return binding;
+            };
+
+            for (const DML_INTERMEDIATE_GRAPH_EDGE_DESC& edge : graphDesc.intermediateEdges)
+            {
+                m_nodes[edge.ToNodeIndex].inputs[edge.ToNodeInputIndex] = bindIntermediate(edge.FromNodeIndex, edge.FromNodeOutputIndex);
+                m_nodes[edge.FromNodeIndex].successors.push_back(edge.ToNodeIndex);
+                ++m_nodes[edge.ToNodeIndex].predecessorCount;
+            }
+
+            for (uint32_t i = 0; i < m_nodes.size(); ++i)
+            {
+                for (uint32_t j = 0; j < m_nodes[i].outputs.size(); ++j)
+                {
+                    bindIntermediate(i, j);
+                }
+            }
+            m_intermediateBuffer.resize(static_cast<size_t>(m_intermediateSizeInBytes));
+
+            m_constantInputs.resize(m_inputCount);
+            for (uint32_t i = 0; i < m_inputCount; ++i)
+            {
+                if (const std::vector<uint8_t>* data = builder->GetConstantInputData(i))
+                {
+                    m_constantInputs[i] = *data;
+                }
+            }
+
+            m_threadPool = options.threadPool ? options.threadPool : std::make_shared<ThreadPool>(options.threadCount);
+            m_pendingCounts.resize(m_nodes.size());
+        }
+
+        Executor(const Executor&) = delete;
+        Executor& operator=(const Executor&) = delete;
+
+        uint32_t GetInputCount() const { return m_inputCount; }
+        uint32_t GetOutputCount() const { return m_outputCount; }
+        uint32_t GetThreadCount() const { return m_threadPool->GetThreadCount(); }
+
+        // The optimizations applied to the graph this executor runs (see dml::Graph::GetStatistics).
+        const GraphStatistics& GetStatistics() const { return m_statistics; }
+
+        // Size of the buffer that holds intermediate tensors, allocated once and reused by every Execute call.
+        uint64_t GetIntermediateSizeInBytes() const { return m_intermediateSizeInBytes; }
+
+        // Returns the tensor desc that graph output i is written through. This is the output expression's desc,
+        // except for views, which are written packed (see dml::Graph::Compile).
+        TensorDesc GetOutputDesc(uint32_t outputIndex) const { return TensorDesc(*m_outputTensors[outputIndex]); }
+
+        void Execute(Span<const void* const> inputs, Span<void* const> outputs)
+        {
+            if (inputs.size() != m_inputCount || outputs.size() != m_outputCount)
+            {
+                DMLX_THROW(E_INVALIDARG);
+            }
+
+            for (void* output : outputs)
+            {
+                if (!output)
+                {
+                    DMLX_THROW(E_INVALIDARG);
+                }
+            }
+
+            m_inputs.resize(m_inputCount);
+            for (uint32_t i = 0; i < m_inputCount; ++i)
+            {
+                m_inputs[i] = inputs[i]
+                    ? static_cast<const uint8_t*>(inputs[i])
+                    : (m_constantInputs[i].empty() ? nullptr : m_constantInputs[i].data());
+            }
+            m_outputs.assign(outputs.begin(), outputs.end());
+
+            m_failed = false;
+#if __cpp_exceptions
+            m_error = nullptr;
+#endif
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (uint32_t i = 0; i < m_nodes.size(); ++i)
+                {
+                    m_pendingCounts[i] = m_nodes[i].predecessorCount;
+                    if (m_pendingCounts[i] == 0)
+                    {
+                        EnqueueNode(i);
+                    }
+                }
+            }
+
+            m_threadPool->RunUntil([this] { return m_pendingNodeCount == 0; });
+
+#if __cpp_exceptions
+            if (m_error)
+            {
+                std::rethrow_exception(m_error);
+            }
+#endif
+        }
+
+    private:
+        enum class BindingType
+        {
+            None,
+            GraphInput,
+            GraphOutput,
+            Intermediate,
+        };
+
+        // GraphInput and GraphOutput bindings hold a graph input or output index; Intermediate bindings hold an
+        // offset into the intermediate buffer.
+        struct Binding
+        {
+            BindingType type = BindingType::None;
+            uint64_t index = 0;
+        };
+
+        struct OutputCopy
+        {
+            uint32_t nodeOutputIndex;
+            uint32_t graphOutputIndex;
+        };
+
+        struct Node
+        {
+            dml::detail::OwnedOperatorDesc desc;
+            std::vector<const DML_TENSOR_DESC*> inputTensors; // Point into desc; null for absent optional tensors
+            std::vector<const DML_TENSOR_DESC*> outputTensors;
+            std::vector<Binding> inputs;
+            std::vector<Binding> outputs;
+            std::vector<OutputCopy> outputCopies;
+            std::vector<uint32_t> successors;
+            uint32_t predecessorCount = 0;
+        };
+
+        uint8_t* GetBindingData(const Binding& binding)
+        {
+            switch (binding.type)
+            {
+            case BindingType::GraphInput: return const_cast<uint8_t*>(m_inputs[binding.index]);
+            case BindingType::GraphOutput: return static_cast<uint8_t*>(m_outputs[binding.index]);
+            case BindingType::Intermediate: return m_intermediateBuffer.data() + binding.index;
+            default: return nullptr;
+            }
+        }
+
+        void RunNode(uint32_t nodeIndex, detail::Scratch& scratch)
+        {
+            const Node& node = m_nodes[nodeIndex];
+
+            std::vector<detail::TensorView> inputs(node.inputTensors.size());
+            for (size_t i = 0; i < inputs.size(); ++i)
+            {
+                inputs[i] = detail::MakeTensorView(node.inputTensors[i], GetBindingData(node.inputs[i]));
+                if (node.inputTensors[i] && !inputs[i])
+                {
+                    DMLX_THROW(E_INVALIDARG); // A non-constant graph input was bound as null
+                }
+            }
+
+            std::vector<detail::TensorView> outputs(node.outputTensors.size());
+            for (size_t i = 0; i < outputs.size(); ++i)
+            {
+                outputs[i] = detail::MakeTensorView(node.outputTensors[i], GetBindingData(node.outputs[i]));
+            }
+
+            detail::RunOperator(*node.desc.Get(), inputs, outputs, scratch, m_threadPool.get());
+
+            for (const OutputCopy& copy : node.outputCopies)
+            {
+                const auto& bufferDesc = *static_cast<const DML_BUFFER_TENSOR_DESC*>(node.outputTensors[copy.nodeOutputIndex]->Desc);
+                memcpy(m_outputs[copy.graphOutputIndex], GetBindingData(node.outputs[copy.nodeOutputIndex]), static_cast<size_t>(bufferDesc.TotalTensorSizeInBytes));
+            }
+        }
+
+        // Requires m_mutex.
+        void EnqueueNode(uint32_t nodeIndex)
+        {
+            ++m_pendingNodeCount;
+            m_threadPool->Enqueue([this, nodeIndex] { RunNodeTask(nodeIndex); });
+        }
+
+        // Runs a node on a pool thread, then queues the successors that it makes ready. After a failure, queued
+        // nodes are skipped and no more are queued.
+        void RunNodeTask(uint32_t nodeIndex)
+        {
+            if (!m_failed)
+            {
+                // Threads that wait inside an operator may run other nodes meanwhile, so scratch buffers are taken
+                // from a shared list rather than kept per thread
+                std::unique_ptr<detail::Scratch> scratch;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (m_freeScratch.empty())
+                    {
+                        scratch = std::make_unique<detail::Scratch>();
+                    }
+                    else
+                    {
+                        scratch = std::move(m_freeScratch.back());
+                        m_freeScratch.pop_back();
+                    }
+                }
+
+#if __cpp_exceptions
+                try
+                {
+                    RunNode(nodeIndex, *scratch);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (!m_error)
+                    {
+                        m_error = std::current_exception();
+                    }
+                    m_failed = true;
+                }
+#else
+                RunNode(nodeIndex, *scratch);
+#endif
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_freeScratch.push_back(std::move(scratch));
+                if (!m_failed)
+                {
+                    for (uint32_t successor : m_nodes[nodeIndex].successors)
+                    {
+                        if (--m_pendingCounts[successor] == 0)
+                        {
+                            EnqueueNode(successor);
+                        }
+                    }
+                }
+            }
+
+            --m_pendingNodeCount;
+            m_threadPool->Notify();
+        }
+
+        uint32_t m_inputCount = 0;
+        uint32_t m_outputCount = 0;
+        GraphStatistics m_statistics;
+        std::vector<Node> m_nodes;
+        std::vector<const DML_TENSOR_DESC*> m_outputTensors; // Point into the producing nodes' descs
+        std::vector<std::vector<uint8_t>> m_constantInputs;
+        std::vector<uint8_t> m_intermediateBuffer;
+        uint64_t m_intermediateSizeInBytes = 0;
+        std::shared_ptr<ThreadPool> m_threadPool;
+
+        // Per-execution state
+        std::vector<const uint8_t*> m_inputs;
+        std::vector<void*> m_outputs;
+        std::mutex m_mutex;
+        std::vector<std::unique_ptr<detail::Scratch>> m_freeScratch;
+        std::vector<uint32_t> m_pendingCounts; // Unfinished predecessors of each node
+        std::atomic<uint32_t> m_pendingNodeCount{ 0 }; // Nodes queued or running
+        std::atomic<bool> m_failed{ false };
+#if __cpp_exceptions
+        std::exception_ptr m_error;
+#endif
+    };
+
+    // How much one graph output changed, accumulated over every element of every calibration sample (see
+    // QuantizeWeights).
+    struct OutputError
+    {
+        uint64_t elementCount = 0;
+        double maxAbsoluteError = 0;
+        double meanAbsoluteError = 0;
+        double rmsError = 0;
+
+        // The root mean square of the reference output, for putting the errors in scale.
+        double referenceRms = 0;
+
+        // Returns 0 if the reference output is all zeros.
+        double GetRelativeRmsError() const { return referenceRms > 0 ? rmsError / referenceRms : 0.0; }
+    };
+
+    struct WeightQuantizationReport
+    {
+        // One entry per graph output, comparing the quantized graph against the FLOAT32 graph.
+        std::vector<OutputError> outputs;
+
+        // Weight tensors quantized, and constant data saved, in the quantized graph (see dml::GraphStatistics).
+        uint32_t quantizedWeightCount = 0;
+        uint64_t bytesSaved = 0;
+    };
+
+    // Enables GraphOptimizations::WeightQuantization on a graph, and measures how much it changes the graph's outputs
+    // by running the graph on the CPU with and without quantized weights for each calibration sample. A sample binds
+    // the graph inputs as Executor::Execute does, except that constant inputs may be left out of the end of the list
+    // as well as bound as null. Optimizations apply to a per-compile copy of the graph, so the FLOAT32 reference is
+    // built from the graph as constructed even if it was compiled with weight quantization before. Afterwards,
+    // Compile uses the quantized weights.
+    inline WeightQuantizationReport QuantizeWeights(
+        Graph& graph,
+        Span<const Expression> outputs,
+        Span<const std::vector<const void*>> calibrationInputs,
+        ExecutorOptions options = {})
+    {
+        if (!options.threadPool)
+        {
+            options.threadPool = std::make_shared<ThreadPool>(options.threadCount);
+        }
+
+        const GraphOptimizations optimizations = graph.GetOptimizations();
+
+        // Executors capture the graph, and its optimizations, when they're constructed
+        graph.SetOptimizations(optimizations & ~GraphOptimizations::WeightQuantization);
+        Executor reference(graph, outputs, options);
+        if (reference.GetStatistics().quantizedWeightCount != 0)
+        {
+            // The reference must compute with the original FLOAT32 weights
+            DMLX_THROW(E_UNEXPECTED);
+        }
+
+        graph.SetOptimizations(optimizations | GraphOptimizations::WeightQuantization);
+        Executor quantized(graph, outputs, options);
+
+        WeightQuantizationReport report;
+        report.quantizedWeightCount = quantized.GetStatistics().quantizedWeightCount;
+        report.bytesSaved = quantized.GetStatistics().quantizedWeightBytesSaved;
+        report.outputs.resize(outputs.size());
+
+        const uint32_t outputCount = static_cast<uint32_t>(outputs.size());
+        std::vector<TensorDesc> referenceTensors(outputCount);
+        std::vector<TensorDesc> quantizedTensors(outputCount);
+        std::vector<std::vector<uint8_t>> referenceData(outputCount);
+        std::vector<std::vector<uint8_t>> quantizedData(outputCount);
+        std::vector<void*> referenceOutputs(outputCount);
+        std::vector<void*> quantizedOutputs(outputCount);
+        for (uint32_t i = 0; i < outputCount; ++i)
+        {
+            referenceTensors[i] = reference.GetOutputDesc(i);
+            quantizedTensors[i] = quantized.GetOutputDesc(i);
+            referenceData[i].resize(static_cast<size_t>(referenceTensors[i].totalTensorSizeInBytes));
+            quantizedData[i].resize(static_cast<size_t>(quantizedTensors[i].totalTensorSizeInBytes));
+            referenceOutputs[i] = referenceData[i].data();
+            quantizedOutputs[i] = quantizedData[i].data();
+        }
+
+        std::vector<double> sumSquaredErrors(outputCount);
+        std::vector<double> sumSquaredReferences(outputCount);
+        std::vector<double> referenceValues, quantizedValues;
+        std::vector<const void*> referenceInputs, quantizedInputs;
+        for (const std::vector<const void*>& inputs : calibrationInputs)
+        {
+            // The inputs added for quantized weights, and by other optimizations, are constant
+            referenceInputs.assign(inputs.begin(), inputs.end());
+            referenceInputs.resize(std::max<size_t>(inputs.size(), reference.GetInputCount()), nullptr);
+            quantizedInputs.assign(inputs.begin(), inputs.end());
+            quantizedInputs.resize(std::max<size_t>(inputs.size(), quantized.GetInputCount()), nullptr);
+
+            reference.Execute(referenceInputs, referenceOutputs);
+            quantized.Execute(quantizedInputs, quantizedOutputs);
+
+            for (uint32_t i = 0; i < outputCount; ++i)
+            {
+                detail::Load(detail::MakeTensorView(referenceTensors[i].AsPtr<DML_TENSOR_DESC>(), referenceData[i].data()), referenceValues);
+                detail::Load(detail::MakeTensorView(quantizedTensors[i].AsPtr<DML_TENSOR_DESC>(), quantizedData[i].data()), quantizedValues);
+
+                OutputError& error = report.outputs[i];
+                for (size_t j = 0; j < referenceValues.size(); ++j)
+                {
+                    const double difference = std::abs(quantizedValues[j] - referenceValues[j]);
+                    error.maxAbsoluteError = std::max(error.maxAbsoluteError, difference);
+                    error.meanAbsoluteError += difference;
+                    sumSquaredErrors[i] += difference * difference;
+                    sumSquaredReferences[i] += referenceValues[j] * referenceValues[j];
+                }
+                error.elementCount += referenceValues.size();
+            }
+        }
+
+        for (uint32_t i = 0; i < outputCount; ++i)
+        {
+            OutputError& error = report.outputs[i];
+            if (error.elementCount > 0)
+            {
+                error.meanAbsoluteError /= error.elementCount;
+                error.rmsError = std::sqrt(sumSquaredErrors[i] / error.elementCount);
+                error.referenceRms = std::sqrt(sumSquaredReferences[i] / error.elementCount);
+            }
+        }
+
+        return report;
+    }
+
+} // namespace cpu
+} // namespace dml
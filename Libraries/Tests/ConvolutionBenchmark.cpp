@@ -0,0 +1,146 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+// Measures dml::cpu::Convolution on the convolution layers of the yolov4 graph of Samples/yolov4, at 608x608 (or the
+// size given on the command line). Each distinct layer shape is timed separately and reported in GFLOP/s, counting a
+// multiply-add as two operations; the total is the time for all of the model's convolutions, counting repeated
+// shapes once per layer. The thread count may be given as the second argument; it defaults to one per hardware
+// thread.
+//
+// CMakeLists.txt builds this benchmark once for each path of the kernels, like CpuKernelTests.
+
+#include "Yolov4Model.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <tuple>
+
+using namespace dmlx_test;
+
+namespace
+{
+    struct LayerShape
+    {
+        dml::TensorDimensions inputSizes;
+        dml::TensorDimensions filterSizes;
+        uint32_t stride;
+        uint32_t padding;
+
+        bool operator<(const LayerShape& other) const
+        {
+            auto tie = [](const LayerShape& shape)
+            {
+                return std::make_tuple(
+                    std::vector<uint32_t>(shape.inputSizes.begin(), shape.inputSizes.end()),
+                    std::vector<uint32_t>(shape.filterSizes.begin(), shape.filterSizes.end()),
+                    shape.stride,
+                    shape.padding);
+            };
+            return tie(*this) < tie(other);
+        }
+    };
+
+    // Times the fastest of several runs of one layer, in seconds, and returns its operation count.
+    double TimeLayer(const LayerShape& shape, dml::cpu::ThreadPool* threadPool, double* operationCount)
+    {
+        const uint32_t outputChannels = shape.filterSizes[0];
+        const uint32_t window = shape.filterSizes[2];
+        const uint32_t outputHeight = (shape.inputSizes[2] + 2 * shape.padding - window) / shape.stride + 1;
+        const uint32_t outputWidth = (shape.inputSizes[3] + 2 * shape.padding - window) / shape.stride + 1;
+
+        FloatTensor input({ shape.inputSizes.begin(), shape.inputSizes.end() }, {}, 1);
+        FloatTensor filter({ shape.filterSizes.begin(), shape.filterSizes.end() }, {}, 2);
+        FloatTensor bias({ 1, outputChannels, 1, 1 }, {}, 3);
+        FloatTensor output({ shape.inputSizes[0], outputChannels, outputHeight, outputWidth });
+
+        // As in the model: a leaky ReLU is fused into most of its convolutions
+        DML_ACTIVATION_LEAKY_RELU_OPERATOR_DESC leakyReluDesc = {};
+        leakyReluDesc.Alpha = 0.1f;
+        const DML_OPERATOR_DESC leakyRelu = { DML_OPERATOR_ACTIVATION_LEAKY_RELU, &leakyReluDesc };
+
+        const uint32_t strides[] = { shape.stride, shape.stride };
+        const uint32_t dilations[] = { 1, 1 };
+        const uint32_t padding[] = { shape.padding, shape.padding };
+        const uint32_t outputPadding[] = { 0, 0 };
+
+        DML_CONVOLUTION_OPERATOR_DESC desc = {};
+        desc.InputTensor = input.GetDesc();
+        desc.FilterTensor = filter.GetDesc();
+        desc.BiasTensor = bias.GetDesc();
+        desc.OutputTensor = output.GetDesc();
+        desc.Mode = DML_CONVOLUTION_MODE_CROSS_CORRELATION;
+        desc.Direction = DML_CONVOLUTION_DIRECTION_FORWARD;
+        desc.DimensionCount = 2;
+        desc.Strides = strides;
+        desc.Dilations = dilations;
+        desc.StartPadding = padding;
+        desc.EndPadding = padding;
+        desc.OutputPadding = outputPadding;
+        desc.GroupCount = 1;
+        desc.FusedActivation = &leakyRelu;
+
+        *operationCount = 2.0 * outputChannels * outputHeight * outputWidth * shape.filterSizes[1] * window * window;
+
+        // Small layers are run more often, so that every layer is timed for about as long
+        const uint32_t runCount = std::max(3u, std::min(50u, static_cast<uint32_t>(2e10 / *operationCount)));
+        double fastest = INFINITY;
+        for (uint32_t i = 0; i < runCount; ++i)
+        {
+            Stopwatch stopwatch;
+            dml::cpu::Convolution(desc, input.GetData().data(), filter.GetData().data(), bias.GetData().data(), output.GetData().data(), threadPool);
+            fastest = std::min(fastest, stopwatch.GetElapsedSeconds());
+        }
+        return fastest;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t size = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 608;
+    const uint32_t threadCount = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 0;
+    if (!CheckKernelPath())
+    {
+        return 0;
+    }
+
+    auto device = MakeStub<StubDevice>();
+    dml::Graph graph(device.Get());
+    Yolov4Model model(graph, size, size);
+
+    // Layers with the same shape are timed once, in the order they first appear
+    std::map<LayerShape, uint32_t> layerCounts;
+    std::vector<LayerShape> shapes;
+    for (const ConvolutionLayer& layer : model.GetConvolutionLayers())
+    {
+        LayerShape shape = { layer.inputSizes, layer.filterSizes, layer.stride, layer.padding };
+        if (layerCounts[shape]++ == 0)
+        {
+            shapes.push_back(shape);
+        }
+    }
+
+    dml::cpu::ThreadPool threadPool(threadCount);
+    std::printf("yolov4 %ux%u, %zu convolution layers, %zu distinct shapes\n", size, size, model.GetConvolutionLayers().size(), shapes.size());
+    std::printf("%-18s %-18s %6s %6s %10s %10s %10s\n", "input", "filter", "stride", "layers", "GFLOP", "time (ms)", "GFLOP/s");
+
+    double totalOperations = 0;
+    double totalSeconds = 0;
+    for (const LayerShape& shape : shapes)
+    {
+        double operationCount = 0;
+        const double seconds = TimeLayer(shape, &threadPool, &operationCount);
+        const uint32_t layerCount = layerCounts[shape];
+        totalOperations += operationCount * layerCount;
+        totalSeconds += seconds * layerCount;
+
+        char input[32];
+        char filter[32];
+        std::snprintf(input, sizeof(input), "%ux%ux%u", shape.inputSizes[1], shape.inputSizes[2], shape.inputSizes[3]);
+        std::snprintf(filter, sizeof(filter), "%ux%ux%ux%u", shape.filterSizes[0], shape.filterSizes[1], shape.filterSizes[2], shape.filterSizes[3]);
+        std::printf("%-18s %-18s %6u %6u %10.3f %10.3f %10.1f\n",
+            input, filter, shape.stride, layerCount, operationCount * 1e-9, seconds * 1e3, operationCount * 1e-9 / seconds);
+    }
+
+    std::printf("total: %.1f GFLOP in %.1f ms, %.1f GFLOP/s\n", totalOperations * 1e-9, totalSeconds * 1e3, totalOperations * 1e-9 / totalSeconds);
+    return 0;
+}
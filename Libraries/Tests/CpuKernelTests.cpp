@@ -0,0 +1,246 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+// Compares the single-precision GEMM and convolution kernels of DirectMLXCpu.h (dml::cpu::Gemm and
+// dml::cpu::Convolution, which pack their operands into panels for GemmMicroKernel) against the double-precision
+// reference implementations that the executor uses for other data types. The shapes are chosen so that m, n and k
+// aren't multiples of the panel and block sizes (GemmMR, GemmNR, GemmKC and GemmNC), and the convolutions cover
+// groups, strides, dilations, padding and both directions.
+//
+// CMakeLists.txt builds this test once for each path of the kernels: CpuKernelTestsScalar with the portable loops,
+// and on x86 CpuKernelTestsAvx2 with the AVX2/FMA micro-kernel.
+
+#include "TestHelpers.h"
+
+using namespace dmlx_test;
+using namespace dml::cpu;
+
+namespace
+{
+    // The kernels accumulate in single precision, in a different order than the reference; with operands in [-1, 1]
+    // the error grows with the length of the dot products.
+    void CheckClose(const char* name, const std::vector<float>& actual, const std::vector<float>& expected, uint32_t k)
+    {
+        const double tolerance = 2e-7 * (k + 16);
+        const double difference = MaxAbsoluteDifference(actual, expected);
+        if (!(difference <= tolerance))
+        {
+            std::printf("%s: max difference %g exceeds %g\n", name, difference, tolerance);
+        }
+        CHECK(difference <= tolerance);
+    }
+
+    struct GemmCase
+    {
+        const char* name;
+        uint32_t batchSizes[2];
+        uint32_t m;
+        uint32_t n;
+        uint32_t k;
+        bool transposeA = false;
+        bool transposeB = false;
+        float alpha = 1.0f;
+        float beta = 0.0f;
+        bool hasC = false;
+        bool broadcastC = false; // C is one row, read with a stride of 0
+        bool relu = false;
+    };
+
+    void TestGemm(const GemmCase& test, ThreadPool* threadPool)
+    {
+        const uint32_t b0 = test.batchSizes[0];
+        const uint32_t b1 = test.batchSizes[1];
+        FloatTensor a(test.transposeA ? std::vector<uint32_t>{ b0, b1, test.k, test.m } : std::vector<uint32_t>{ b0, b1, test.m, test.k }, {}, 1);
+        FloatTensor b(test.transposeB ? std::vector<uint32_t>{ b0, b1, test.n, test.k } : std::vector<uint32_t>{ b0, b1, test.k, test.n }, {}, 2);
+        FloatTensor c({ b0, b1, test.m, test.n }, test.broadcastC ? std::vector<uint32_t>{ 0, 0, 0, 1 } : std::vector<uint32_t>{}, 3);
+        FloatTensor output({ b0, b1, test.m, test.n });
+        FloatTensor expected({ b0, b1, test.m, test.n });
+
+        DML_ACTIVATION_RELU_OPERATOR_DESC reluDesc = {};
+        const DML_OPERATOR_DESC relu = { DML_OPERATOR_ACTIVATION_RELU, &reluDesc };
+
+        DML_GEMM_OPERATOR_DESC desc = {};
+        desc.ATensor = a.GetDesc();
+        desc.BTensor = b.GetDesc();
+        desc.CTensor = test.hasC ? c.GetDesc() : nullptr;
+        desc.OutputTensor = output.GetDesc();
+        desc.TransA = test.transposeA ? DML_MATRIX_TRANSFORM_TRANSPOSE : DML_MATRIX_TRANSFORM_NONE;
+        desc.TransB = test.transposeB ? DML_MATRIX_TRANSFORM_TRANSPOSE : DML_MATRIX_TRANSFORM_NONE;
+        desc.Alpha = test.alpha;
+        desc.Beta = test.beta;
+        desc.FusedActivation = test.relu ? &relu : nullptr;
+
+        Gemm(desc, a.GetData().data(), b.GetData().data(), test.hasC ? c.GetData().data() : nullptr, output.GetData().data(), threadPool);
+
+        detail::Scratch scratch;
+        const std::vector<detail::TensorView> inputs = { a.GetView(), b.GetView(), test.hasC ? c.GetView() : detail::TensorView() };
+        const std::vector<detail::TensorView> outputs = { expected.GetView() };
+        detail::RunGemm(desc, inputs, outputs, scratch);
+
+        CheckClose(test.name, output.GetData(), expected.GetData(), test.k);
+    }
+
+    void TestGemms(ThreadPool* threadPool)
+    {
+        GemmCase tests[] =
+        {
+            { "gemm 1x1x1", { 1, 1 }, 1, 1, 1 },
+            { "gemm one tile", { 1, 1 }, 6, 16, 256 },
+            { "gemm partial tile", { 1, 1 }, 5, 15, 7 },
+            { "gemm tile plus one", { 1, 1 }, 7, 17, 257 },
+            { "gemm three k blocks", { 1, 1 }, 13, 33, 600 },
+            { "gemm two n blocks", { 1, 1 }, 3, 2050, 9 },
+            { "gemm tall", { 1, 1 }, 97, 5, 31 },
+            { "gemm batched", { 2, 3 }, 11, 19, 23 },
+            { "gemm transposed a", { 1, 2 }, 14, 21, 70, true, false },
+            { "gemm transposed b", { 1, 2 }, 14, 21, 70, false, true },
+            { "gemm transposed a and b", { 2, 1 }, 9, 35, 300, true, true },
+            { "gemm alpha beta", { 1, 1 }, 8, 40, 17, false, false, 0.5f, -2.0f, true },
+            { "gemm broadcast c", { 2, 1 }, 7, 18, 12, false, true, 1.0f, 1.0f, true, true },
+            { "gemm relu", { 1, 1 }, 12, 29, 65, false, false, 1.5f, 0.25f, true, false, true },
+        };
+
+        for (const GemmCase& test : tests)
+        {
+            TestGemm(test, threadPool);
+        }
+    }
+
+    struct ConvolutionCase
+    {
+        const char* name;
+        std::vector<uint32_t> inputSizes; // {batch, channels, spatial...}
+        uint32_t outputChannels;
+        std::vector<uint32_t> windowSizes;
+        std::vector<uint32_t> strides;
+        std::vector<uint32_t> dilations;
+        std::vector<uint32_t> startPadding;
+        std::vector<uint32_t> endPadding;
+        std::vector<uint32_t> outputPadding;
+        uint32_t groupCount = 1;
+        DML_CONVOLUTION_DIRECTION direction = DML_CONVOLUTION_DIRECTION_FORWARD;
+        DML_CONVOLUTION_MODE mode = DML_CONVOLUTION_MODE_CROSS_CORRELATION;
+        bool hasBias = true;
+        bool leakyRelu = false;
+    };
+
+    void TestConvolution(const ConvolutionCase& test, ThreadPool* threadPool)
+    {
+        const bool forward = test.direction == DML_CONVOLUTION_DIRECTION_FORWARD;
+        const uint32_t dimensionCount = static_cast<uint32_t>(test.windowSizes.size());
+        const uint32_t inputChannels = test.inputSizes[1];
+
+        std::vector<uint32_t> outputSizes = { test.inputSizes[0], test.outputChannels };
+        for (uint32_t i = 0; i < dimensionCount; ++i)
+        {
+            const uint32_t window = (test.windowSizes[i] - 1) * test.dilations[i] + 1;
+            const uint32_t padding = test.startPadding[i] + test.endPadding[i];
+            outputSizes.push_back(forward
+                ? (test.inputSizes[2 + i] + padding - window) / test.strides[i] + 1
+                : (test.inputSizes[2 + i] - 1) * test.strides[i] + window - padding + test.outputPadding[i]);
+        }
+
+        // Forward filters are {outputChannels, groupInputChannels, window...}; backward filters are
+        // {inputChannels, groupOutputChannels, window...}
+        std::vector<uint32_t> filterSizes = forward
+            ? std::vector<uint32_t>{ test.outputChannels, inputChannels / test.groupCount }
+            : std::vector<uint32_t>{ inputChannels, test.outputChannels / test.groupCount };
+        filterSizes.insert(filterSizes.end(), test.windowSizes.begin(), test.windowSizes.end());
+
+        std::vector<uint32_t> biasSizes(2 + dimensionCount, 1);
+        biasSizes[1] = test.outputChannels;
+
+        FloatTensor input(test.inputSizes, {}, 1);
+        FloatTensor filter(filterSizes, {}, 2);
+        FloatTensor bias(biasSizes, {}, 3);
+        FloatTensor output(outputSizes);
+        FloatTensor expected(outputSizes);
+
+        DML_ACTIVATION_LEAKY_RELU_OPERATOR_DESC leakyReluDesc = {};
+        leakyReluDesc.Alpha = 0.1f;
+        const DML_OPERATOR_DESC leakyRelu = { DML_OPERATOR_ACTIVATION_LEAKY_RELU, &leakyReluDesc };
+
+        DML_CONVOLUTION_OPERATOR_DESC desc = {};
+        desc.InputTensor = input.GetDesc();
+        desc.FilterTensor = filter.GetDesc();
+        desc.BiasTensor = test.hasBias ? bias.GetDesc() : nullptr;
+        desc.OutputTensor = output.GetDesc();
+        desc.Mode = test.mode;
+        desc.Direction = test.direction;
+        desc.DimensionCount = dimensionCount;
+        desc.Strides = test.strides.data();
+        desc.Dilations = test.dilations.data();
+        desc.StartPadding = test.startPadding.data();
+        desc.EndPadding = test.endPadding.data();
+        desc.OutputPadding = test.outputPadding.data();
+        desc.GroupCount = test.groupCount;
+        desc.FusedActivation = test.leakyRelu ? &leakyRelu : nullptr;
+
+        Convolution(desc, input.GetData().data(), filter.GetData().data(), test.hasBias ? bias.GetData().data() : nullptr, output.GetData().data(), threadPool);
+
+        detail::Scratch scratch;
+        const std::vector<detail::TensorView> inputs = { input.GetView(), filter.GetView(), test.hasBias ? bias.GetView() : detail::TensorView() };
+        const std::vector<detail::TensorView> outputs = { expected.GetView() };
+        detail::RunConvolution(desc, inputs, outputs, scratch);
+
+        // The longest sum of products an output element has: a group's input channels times the window
+        uint32_t k = inputChannels / test.groupCount;
+        for (uint32_t window : test.windowSizes)
+        {
+            k *= window;
+        }
+        CheckClose(test.name, output.GetData(), expected.GetData(), k);
+    }
+
+    void TestConvolutions(ThreadPool* threadPool)
+    {
+        const auto backward = DML_CONVOLUTION_DIRECTION_BACKWARD;
+        const auto flip = DML_CONVOLUTION_MODE_CONVOLUTION;
+        const auto correlate = DML_CONVOLUTION_MODE_CROSS_CORRELATION;
+        const auto forward = DML_CONVOLUTION_DIRECTION_FORWARD;
+
+        // name, input, output channels, window, strides, dilations, start padding, end padding, output padding, groups
+        const ConvolutionCase tests[] =
+        {
+            { "conv 3x3", { 1, 3, 13, 11 }, 7, { 3, 3 }, { 1, 1 }, { 1, 1 }, { 1, 1 }, { 1, 1 }, { 0, 0 } },
+            { "conv 1x1", { 1, 16, 40, 40 }, 19, { 1, 1 }, { 1, 1 }, { 1, 1 }, { 0, 0 }, { 0, 0 }, { 0, 0 } },
+            { "conv stride 2", { 2, 3, 9, 10 }, 10, { 3, 3 }, { 2, 2 }, { 1, 1 }, { 1, 0 }, { 0, 1 }, { 0, 0 } },
+            { "conv stride 3x2", { 1, 4, 17, 12 }, 5, { 4, 3 }, { 3, 2 }, { 1, 1 }, { 0, 1 }, { 2, 1 }, { 0, 0 } },
+            { "conv dilation 2", { 1, 4, 12, 12 }, 5, { 3, 3 }, { 1, 1 }, { 2, 2 }, { 2, 2 }, { 2, 2 }, { 0, 0 } },
+            { "conv groups 2", { 1, 8, 7, 7 }, 6, { 3, 3 }, { 1, 1 }, { 1, 1 }, { 1, 1 }, { 1, 1 }, { 0, 0 }, 2 },
+            { "conv depthwise", { 2, 6, 9, 9 }, 6, { 5, 5 }, { 2, 2 }, { 1, 1 }, { 2, 2 }, { 2, 2 }, { 0, 0 }, 6 },
+            { "conv k over block", { 1, 33, 6, 7 }, 13, { 3, 3 }, { 1, 1 }, { 1, 1 }, { 1, 1 }, { 1, 1 }, { 0, 0 } },
+            { "conv flipped", { 1, 2, 8, 9 }, 3, { 2, 3 }, { 1, 1 }, { 1, 1 }, { 0, 1 }, { 1, 1 }, { 0, 0 }, 1, forward, flip },
+            { "conv no bias", { 1, 5, 1, 37 }, 9, { 1, 4 }, { 1, 3 }, { 1, 1 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, 1, forward, correlate, false },
+            { "conv leaky relu", { 1, 7, 10, 10 }, 20, { 3, 3 }, { 1, 1 }, { 1, 1 }, { 1, 1 }, { 1, 1 }, { 0, 0 }, 1, forward, correlate, true, true },
+            { "conv 3d", { 1, 3, 5, 6, 7 }, 4, { 3, 3, 3 }, { 1, 2, 1 }, { 1, 1, 1 }, { 1, 1, 1 }, { 1, 1, 1 }, { 0, 0, 0 } },
+            { "backward conv", { 1, 6, 5, 5 }, 4, { 3, 3 }, { 1, 1 }, { 1, 1 }, { 1, 1 }, { 1, 1 }, { 0, 0 }, 1, backward },
+            { "backward conv stride 2", { 2, 6, 5, 4 }, 4, { 3, 3 }, { 2, 2 }, { 1, 1 }, { 1, 1 }, { 1, 1 }, { 1, 0 }, 1, backward },
+            { "backward conv groups 3", { 1, 9, 6, 6 }, 12, { 2, 2 }, { 2, 2 }, { 1, 1 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, 3, backward },
+            { "backward conv dilated flipped", { 1, 5, 7, 3 }, 3, { 3, 2 }, { 1, 1 }, { 2, 1 }, { 1, 0 }, { 0, 0 }, { 0, 0 }, 1, backward, flip },
+            { "backward conv k over block", { 1, 300, 3, 3 }, 17, { 1, 1 }, { 1, 1 }, { 1, 1 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, 1, backward },
+        };
+
+        for (const ConvolutionCase& test : tests)
+        {
+            TestConvolution(test, threadPool);
+        }
+    }
+}
+
+int main()
+{
+    if (!CheckKernelPath())
+    {
+        return 0;
+    }
+
+    // Without a pool the kernels run on the calling thread; with one, the panels are split between threads
+    ThreadPool threadPool(3);
+    ThreadPool* const threadPools[] = { nullptr, &threadPool };
+    for (ThreadPool* pool : threadPools)
+    {
+        TestGemms(pool);
+        TestConvolutions(pool);
+    }
+    return Finish();
+}
@@ -0,0 +1,284 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+// Tests of dml::cpu::Executor: independent operators run concurrently on its thread pool, and the results must not
+// depend on the thread count or on other executors sharing the pool. Results are checked against values computed
+// here.
+
+#include "TestHelpers.h"
+
+#include <thread>
+
+using namespace dmlx_test;
+
+namespace
+{
+    // A graph with many independent branches: the sum of exp(x * scales[i]) over eight scales, and a GEMM and a
+    // convolution that don't depend on it. Outputs 0 and 2 are the same expression.
+    struct WideGraph
+    {
+        static constexpr uint32_t c_branchCount = 8;
+
+        dml::Graph graph;
+        dml::Expression outputs[4];
+
+        explicit WideGraph(IDMLDevice* device)
+            : graph(device)
+        {
+            dml::Expression x = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 1, 16, 16 }));
+            dml::Expression a = dml::InputTensor(graph, 1, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 1, 24, 32 }));
+            dml::Expression b = dml::InputTensor(graph, 2, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 1, 32, 20 }));
+            dml::Expression image = dml::InputTensor(graph, 3, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 8, 20, 20 }));
+            dml::Expression filter = dml::InputTensor(graph, 4, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 16, 8, 3, 3 }));
+
+            dml::Expression sum = dml::Exp(x * Scale(0));
+            for (uint32_t i = 1; i < c_branchCount; ++i)
+            {
+                sum = sum + dml::Exp(x * Scale(i));
+            }
+
+            const uint32_t padding[] = { 1, 1 };
+            outputs[0] = sum;
+            outputs[1] = dml::Gemm(a, b);
+            outputs[2] = sum;
+            outputs[3] = dml::ConvolutionBuilder(image, filter).StartPadding(padding).EndPadding(padding).Build();
+        }
+
+        static float Scale(uint32_t branch) { return 0.25f * (branch + 1); }
+    };
+
+    struct WideGraphData
+    {
+        std::vector<float> x = RandomFloats(16 * 16, 1);
+        std::vector<float> a = RandomFloats(24 * 32, 2);
+        std::vector<float> b = RandomFloats(32 * 20, 3);
+        std::vector<float> image = RandomFloats(8 * 20 * 20, 4);
+        std::vector<float> filter = RandomFloats(16 * 8 * 3 * 3, 5);
+
+        std::vector<float> ExpectedSum() const
+        {
+            std::vector<float> sum(x.size());
+            for (size_t i = 0; i < x.size(); ++i)
+            {
+                double value = 0;
+                for (uint32_t j = 0; j < WideGraph::c_branchCount; ++j)
+                {
+                    value += std::exp(static_cast<double>(x[i]) * WideGraph::Scale(j));
+                }
+                sum[i] = static_cast<float>(value);
+            }
+            return sum;
+        }
+
+        std::vector<float> ExpectedGemm() const
+        {
+            std::vector<float> product(24 * 20);
+            for (uint32_t m = 0; m < 24; ++m)
+            {
+                for (uint32_t n = 0; n < 20; ++n)
+                {
+                    double value = 0;
+                    for (uint32_t k = 0; k < 32; ++k)
+                    {
+                        value += static_cast<double>(a[m * 32 + k]) * b[k * 20 + n];
+                    }
+                    product[m * 20 + n] = static_cast<float>(value);
+                }
+            }
+            return product;
+        }
+
+        std::vector<float> ExpectedConvolution() const
+        {
+            std::vector<float> result(16 * 20 * 20);
+            for (uint32_t k = 0; k < 16; ++k)
+            {
+                for (uint32_t y = 0; y < 20; ++y)
+                {
+                    for (uint32_t x0 = 0; x0 < 20; ++x0)
+                    {
+                        double value = 0;
+                        for (uint32_t c = 0; c < 8; ++c)
+                        {
+                            for (uint32_t i = 0; i < 3; ++i)
+                            {
+                                for (uint32_t j = 0; j < 3; ++j)
+                                {
+                                    const int32_t inputY = static_cast<int32_t>(y + i) - 1;
+                                    const int32_t inputX = static_cast<int32_t>(x0 + j) - 1;
+                                    if (inputY >= 0 && inputY < 20 && inputX >= 0 && inputX < 20)
+                                    {
+                                        value += static_cast<double>(image[(c * 20 + inputY) * 20 + inputX]) * filter[((k * 8 + c) * 3 + i) * 3 + j];
+                                    }
+                                }
+                            }
+                        }
+                        result[(k * 20 + y) * 20 + x0] = static_cast<float>(value);
+                    }
+                }
+            }
+            return result;
+        }
+    };
+
+    // Runs the executor and returns its four outputs.
+    std::vector<std::vector<float>> Execute(dml::cpu::Executor& executor, const WideGraphData& data)
+    {
+        std::vector<std::vector<float>> results(executor.GetOutputCount());
+        std::vector<void*> outputs;
+        for (uint32_t i = 0; i < executor.GetOutputCount(); ++i)
+        {
+            results[i].resize(static_cast<size_t>(executor.GetOutputDesc(i).totalTensorSizeInBytes / sizeof(float)));
+            outputs.push_back(results[i].data());
+        }
+
+        const void* inputs[] = { data.x.data(), data.a.data(), data.b.data(), data.image.data(), data.filter.data() };
+        executor.Execute(inputs, outputs);
+        return results;
+    }
+
+    // Checks outputs against the values computed by WideGraphData. The tolerances allow for float accumulation.
+    void CheckResults(const std::vector<std::vector<float>>& results, const WideGraphData& data)
+    {
+        CHECK(results.size() == 4);
+        if (results.size() == 4)
+        {
+            CHECK(MaxAbsoluteDifference(results[0], data.ExpectedSum()) < 1e-4);
+            CHECK(results[2] == results[0]);
+            CHECK(MaxAbsoluteDifference(results[1], data.ExpectedGemm()) < 1e-5);
+            CHECK(MaxAbsoluteDifference(results[3], data.ExpectedConvolution()) < 1e-5);
+        }
+    }
+
+    void TestThreadCounts()
+    {
+        auto device = MakeStub<StubDevice>();
+        WideGraph wide(device.Get());
+        const WideGraphData data;
+
+        std::vector<std::vector<float>> singleThreaded;
+        for (uint32_t threadCount : { 1u, 2u, 3u, 8u, 0u })
+        {
+            dml::cpu::ExecutorOptions options;
+            options.threadCount = threadCount;
+            dml::cpu::Executor executor(wide.graph, wide.outputs, options);
+            CHECK(threadCount == 0 || executor.GetThreadCount() == threadCount);
+            CHECK(executor.GetInputCount() == 5 && executor.GetOutputCount() == 4);
+
+            // Executing repeatedly reuses the intermediate buffer; every run must give the same results
+            for (uint32_t run = 0; run < 3; ++run)
+            {
+                const std::vector<std::vector<float>> results = Execute(executor, data);
+                CheckResults(results, data);
+                if (singleThreaded.empty())
+                {
+                    singleThreaded = results;
+                }
+
+                // Operators don't split reductions across threads, so the results don't depend on the thread count
+                CHECK(results == singleThreaded);
+            }
+        }
+
+        // New inputs give new results
+        dml::cpu::Executor executor(wide.graph, wide.outputs);
+        WideGraphData otherData;
+        otherData.x = RandomFloats(otherData.x.size(), 11);
+        otherData.image = RandomFloats(otherData.image.size(), 12);
+        Execute(executor, data);
+        CheckResults(Execute(executor, otherData), otherData);
+    }
+
+    void TestSharedThreadPool()
+    {
+        auto device = MakeStub<StubDevice>();
+        WideGraph wide(device.Get());
+        const WideGraphData data;
+
+        dml::cpu::ExecutorOptions options;
+        options.threadPool = std::make_shared<dml::cpu::ThreadPool>(4);
+        dml::cpu::Executor first(wide.graph, wide.outputs, options);
+        dml::cpu::Executor second(wide.graph, wide.outputs, options);
+        CHECK(first.GetThreadCount() == 4 && second.GetThreadCount() == 4);
+
+        // Executors sharing a pool may run at the same time, each from its own thread
+        WideGraphData otherData;
+        otherData.x = RandomFloats(otherData.x.size(), 21);
+        otherData.a = RandomFloats(otherData.a.size(), 22);
+        otherData.filter = RandomFloats(otherData.filter.size(), 23);
+
+        std::vector<std::vector<float>> firstResults[10];
+        std::vector<std::vector<float>> secondResults[10];
+        std::thread thread([&]
+        {
+            for (auto& results : secondResults)
+            {
+                results = Execute(second, otherData);
+            }
+        });
+        for (auto& results : firstResults)
+        {
+            results = Execute(first, data);
+        }
+        thread.join();
+
+        for (uint32_t i = 0; i < 10; ++i)
+        {
+            CheckResults(firstResults[i], data);
+            CheckResults(secondResults[i], otherData);
+        }
+    }
+
+    void TestExecuteErrors()
+    {
+#if __cpp_exceptions
+        auto device = MakeStub<StubDevice>();
+        WideGraph wide(device.Get());
+        const WideGraphData data;
+
+        dml::cpu::ExecutorOptions options;
+        options.threadCount = 4;
+        dml::cpu::Executor executor(wide.graph, wide.outputs, options);
+
+        auto throws = [](auto&& function)
+        {
+            try
+            {
+                function();
+            }
+            catch (const std::exception&)
+            {
+                return true;
+            }
+            return false;
+        };
+
+        // The wrong number of bindings, a null output, and a non-constant input bound as null, which is only found
+        // by the operator that reads it while other operators are running
+        std::vector<std::vector<float>> buffers(4);
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            buffers[i].resize(static_cast<size_t>(executor.GetOutputDesc(i).totalTensorSizeInBytes / sizeof(float)));
+        }
+        void* outputs[] = { buffers[0].data(), buffers[1].data(), buffers[2].data(), buffers[3].data() };
+        const void* inputs[] = { data.x.data(), data.a.data(), data.b.data(), data.image.data(), data.filter.data() };
+        CHECK(throws([&] { executor.Execute(dml::Span<const void* const>(inputs, 4), outputs); }));
+
+        void* nullOutputs[] = { buffers[0].data(), nullptr, buffers[2].data(), buffers[3].data() };
+        CHECK(throws([&] { executor.Execute(inputs, nullOutputs); }));
+
+        const void* nullInputs[] = { data.x.data(), data.a.data(), nullptr, data.image.data(), data.filter.data() };
+        CHECK(throws([&] { executor.Execute(nullInputs, outputs); }));
+
+        // The executor can still be used after a failure
+        CheckResults(Execute(executor, data), data);
+#endif
+    }
+}
+
+int main()
+{
+    TestThreadCounts();
+    TestSharedThreadPool();
+    TestExecuteErrors();
+    return Finish();
+}
@@ -0,0 +1,238 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+// Tests of the tensors the DirectMLX builder functions describe: the output shapes they infer and the input views
+// they pass to DirectML. Results are checked on the CPU executor against values computed here.
+
+#include "TestHelpers.h"
+
+using namespace dmlx_test;
+
+namespace
+{
+    dml::Expression FloatInput(dml::Graph& graph, uint32_t index, dml::TensorDimensions sizes)
+    {
+        return dml::InputTensor(graph, index, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, std::move(sizes)));
+    }
+
+    std::vector<uint32_t> GetSizes(const dml::Expression& expression)
+    {
+        const dml::TensorDimensions sizes = expression.GetOutputDesc().sizes;
+        return std::vector<uint32_t>(sizes.begin(), sizes.end());
+    }
+
+    // The strides of a buffer tensor desc, or none if it is packed.
+    std::vector<uint32_t> GetStrides(const DML_TENSOR_DESC* tensor)
+    {
+        const auto& buffer = *static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc);
+        return buffer.Strides ? std::vector<uint32_t>(buffer.Strides, buffer.Strides + buffer.DimensionCount) : std::vector<uint32_t>();
+    }
+
+    void TestBroadcasting()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph graph(device.Get());
+        graph.SetOptimizations(dml::GraphOptimizations::None);
+
+        // A per-channel operand is read with zero strides in the broadcast dimensions
+        dml::Expression a = FloatInput(graph, 0, { 2, 3, 4, 5 });
+        dml::Expression b = FloatInput(graph, 1, { 1, 3, 1, 5 });
+        const dml::Expression sum[] = { a + b };
+        CHECK(GetSizes(sum[0]) == std::vector<uint32_t>({ 2, 3, 4, 5 }));
+
+        graph.Compile(DML_EXECUTION_FLAG_NONE, sum);
+        const CompiledGraphRecord& sumGraph = device->GetCompiledGraphs().back();
+        CHECK(sumGraph.nodes.size() == 1);
+        if (sumGraph.nodes.size() == 1)
+        {
+            const auto& add = *static_cast<const DML_ELEMENT_WISE_ADD1_OPERATOR_DESC*>(sumGraph.GetNodeDesc(0).Desc);
+            CHECK(GetStrides(add.ATensor).empty());
+            CHECK(GetStrides(add.BTensor) == std::vector<uint32_t>({ 0, 5, 0, 1 }));
+        }
+
+        const std::vector<float> aData = RandomFloats(2 * 3 * 4 * 5, 1);
+        const std::vector<float> bData = RandomFloats(3 * 5, 2);
+        std::vector<float> expectedSum(aData.size());
+        for (uint32_t i = 0; i < aData.size(); ++i)
+        {
+            const uint32_t channel = (i / 20) % 3;
+            const uint32_t x = i % 5;
+            expectedSum[i] = aData[i] + bData[channel * 5 + x];
+        }
+        CHECK(MaxAbsoluteDifference(ExecuteFloat(graph, sum[0], { &aData, &bData }), expectedSum) == 0);
+
+        // Both operands may be broadcast, and a lower-rank operand is aligned to the trailing dimensions
+        dml::Expression column = FloatInput(graph, 2, { 2, 1, 4 });
+        dml::Expression row = FloatInput(graph, 3, { 3, 1 });
+        const dml::Expression product[] = { column * row };
+        CHECK(GetSizes(product[0]) == std::vector<uint32_t>({ 2, 3, 4 }));
+
+        graph.Compile(DML_EXECUTION_FLAG_NONE, product);
+        const CompiledGraphRecord& productGraph = device->GetCompiledGraphs().back();
+        if (productGraph.nodes.size() == 1)
+        {
+            const auto& multiply = *static_cast<const DML_ELEMENT_WISE_MULTIPLY_OPERATOR_DESC*>(productGraph.GetNodeDesc(0).Desc);
+            CHECK(GetStrides(multiply.ATensor) == std::vector<uint32_t>({ 4, 0, 1 }));
+            CHECK(GetStrides(multiply.BTensor) == std::vector<uint32_t>({ 0, 1, 0 }));
+        }
+
+        const std::vector<float> columnData = RandomFloats(2 * 4, 3);
+        const std::vector<float> rowData = RandomFloats(3, 4);
+        std::vector<float> expectedProduct(2 * 3 * 4);
+        for (uint32_t i = 0; i < expectedProduct.size(); ++i)
+        {
+            expectedProduct[i] = columnData[(i / 12) * 4 + i % 4] * rowData[(i / 4) % 3];
+        }
+        CHECK(MaxAbsoluteDifference(ExecuteFloat(graph, product[0], { nullptr, nullptr, &columnData, &rowData }), expectedProduct) == 0);
+
+        // Comparisons and If broadcast all of their inputs the same way
+        CHECK(GetSizes(dml::GreaterThan(column, row)) == std::vector<uint32_t>({ 2, 3, 4 }));
+        dml::Expression condition = dml::InputTensor(graph, 4, dml::TensorDesc(DML_TENSOR_DATA_TYPE_UINT8, { 1, 1, 4 }));
+        CHECK(GetSizes(dml::If(condition, column, row)) == std::vector<uint32_t>({ 2, 3, 4 }));
+        CHECK(GetSizes(dml::Pow(a, FloatInput(graph, 5, { 5 }))) == std::vector<uint32_t>({ 2, 3, 4, 5 }));
+
+#if __cpp_exceptions
+        // Dimensions that differ and aren't 1 can't be broadcast
+        bool threw = false;
+        try
+        {
+            a + FloatInput(graph, 6, { 2, 3, 4, 4 });
+        }
+        catch (const std::exception&)
+        {
+            threw = true;
+        }
+        CHECK(threw);
+#endif
+    }
+
+    void TestViews()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph graph(device.Get());
+        graph.SetOptimizations(dml::GraphOptimizations::None);
+
+        dml::Expression x = FloatInput(graph, 0, { 2, 3, 4 });
+        const std::vector<float> xData = RandomFloats(2 * 3 * 4, 1);
+        const uint32_t permutation[] = { 2, 0, 1 };
+
+        // Element i of the transpose {4, 2, 3} is x[a][b][c] for i = (c * 2 + a) * 3 + b
+        std::vector<float> transposed(xData.size());
+        for (uint32_t i = 0; i < transposed.size(); ++i)
+        {
+            const uint32_t c = i / 6;
+            const uint32_t a = (i / 3) % 2;
+            const uint32_t b = i % 3;
+            transposed[i] = xData[(a * 3 + b) * 4 + c];
+        }
+
+        // A view read by an operator is passed to it as strides; nothing is copied, and the operator producing the
+        // viewed tensor is reachable through the view. The Exp that nothing reads is pruned.
+        dml::Expression exp = dml::Exp(x);
+        dml::Exp(exp);
+        dml::Expression transpose = dml::Transpose(exp, permutation);
+        CHECK(GetSizes(transpose) == std::vector<uint32_t>({ 4, 2, 3 }));
+        const dml::Expression abs[] = { dml::Abs(transpose) };
+        graph.Compile(DML_EXECUTION_FLAG_NONE, abs);
+        {
+            const CompiledGraphRecord& record = device->GetCompiledGraphs().back();
+            CHECK(record.nodes.size() == 2);
+            CHECK(record.CountNodes(DML_OPERATOR_ELEMENT_WISE_ABS) == 1 && record.CountNodes(DML_OPERATOR_ELEMENT_WISE_EXP) == 1);
+            for (size_t i = 0; i < record.nodes.size(); ++i)
+            {
+                if (record.GetNodeDesc(i).Type == DML_OPERATOR_ELEMENT_WISE_ABS)
+                {
+                    const auto& desc = *static_cast<const DML_ELEMENT_WISE_ABS_OPERATOR_DESC*>(record.GetNodeDesc(i).Desc);
+                    CHECK(GetStrides(desc.InputTensor) == std::vector<uint32_t>({ 1, 12, 4 }));
+                }
+            }
+        }
+        CHECK(graph.GetStatistics().prunedNodeCount == 1);
+        CHECK(graph.GetStatistics().materializedViewCount == 0);
+
+        std::vector<float> expected(transposed.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            expected[i] = std::abs(std::exp(transposed[i]));
+        }
+        CHECK(MaxAbsoluteDifference(ExecuteFloat(graph, abs[0], { &xData }), expected) < 1e-6);
+
+        // A view requested as a graph output, even through a reinterpret or more than once, is copied once
+        dml::Expression inputView = dml::Transpose(x, permutation);
+        const dml::Expression viewOutputs[] = { inputView, inputView, dml::Reinterpret(inputView, DML_TENSOR_DATA_TYPE_FLOAT32) };
+        graph.Compile(DML_EXECUTION_FLAG_NONE, viewOutputs);
+        {
+            const CompiledGraphRecord& record = device->GetCompiledGraphs().back();
+            CHECK(record.CountNodes(DML_OPERATOR_ELEMENT_WISE_IDENTITY) == 2);
+            CHECK(record.outputEdges.size() == 3);
+        }
+        CHECK(graph.GetStatistics().materializedViewCount == 2);
+        CHECK(graph.Validate(viewOutputs).empty());
+        CHECK(ExecuteFloat(graph, viewOutputs[0], { &xData }) == transposed);
+        CHECK(ExecuteFloat(graph, viewOutputs[2], { &xData }) == transposed);
+
+        // Broadcast and StridedView give zero and multiplied strides
+        dml::Expression row = FloatInput(graph, 1, { 3, 1 });
+        const std::vector<float> rowData = RandomFloats(3, 2);
+        dml::Expression broadcast = dml::Broadcast(row, { 2, 3, 4 });
+        const dml::Expression sum[] = { x + broadcast };
+        std::vector<float> expectedSum(xData.size());
+        for (uint32_t i = 0; i < expectedSum.size(); ++i)
+        {
+            expectedSum[i] = xData[i] + rowData[(i / 4) % 3];
+        }
+        CHECK(ExecuteFloat(graph, sum[0], { &xData, &rowData }) == expectedSum);
+
+        const uint32_t steps[] = { 1, 2, 3 };
+        dml::Expression strided = dml::StridedView(x, { 2, 2, 2 }, steps);
+        const dml::Expression stridedOutputs[] = { strided };
+        graph.Compile(DML_EXECUTION_FLAG_NONE, stridedOutputs);
+        {
+            const CompiledGraphRecord& record = device->GetCompiledGraphs().back();
+            CHECK(record.nodes.size() == 1);
+            if (record.nodes.size() == 1)
+            {
+                const auto& desc = *static_cast<const DML_ELEMENT_WISE_IDENTITY_OPERATOR_DESC*>(record.GetNodeDesc(0).Desc);
+                CHECK(GetStrides(desc.InputTensor) == std::vector<uint32_t>({ 12, 8, 3 }));
+            }
+        }
+        std::vector<float> expectedStrided;
+        for (uint32_t a = 0; a < 2; ++a)
+        {
+            for (uint32_t b = 0; b < 2; ++b)
+            {
+                for (uint32_t c = 0; c < 2; ++c)
+                {
+                    expectedStrided.push_back(xData[(a * 3 + b * 2) * 4 + c * 3]);
+                }
+            }
+        }
+        CHECK(ExecuteFloat(graph, strided, { &xData }) == expectedStrided);
+
+#if __cpp_exceptions
+        auto throws = [](auto&& function)
+        {
+            try
+            {
+                function();
+            }
+            catch (const std::exception&)
+            {
+                return true;
+            }
+            return false;
+        };
+        const uint32_t repeated[] = { 0, 0, 1 };
+        const uint32_t tooFar[] = { 1, 2, 4 };
+        CHECK(throws([&] { dml::Transpose(x, repeated); }));
+        CHECK(throws([&] { dml::Broadcast(x, { 2, 6, 4 }); }));
+        CHECK(throws([&] { dml::StridedView(x, { 2, 2, 2 }, tooFar); }));
+#endif
+    }
+}
+
+int main()
+{
+    TestBroadcasting();
+    TestViews();
+    return Finish();
+}
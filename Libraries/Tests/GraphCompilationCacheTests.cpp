@@ -0,0 +1,172 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+// Device-free tests of graph fingerprints and dml::GraphCompilationCache. Nothing here calls into DirectML; see
+// TestHelpers.h for the stub device. Built and run by CMakeLists.txt in this directory.
+
+#include "TestHelpers.h"
+
+#include <cstdio>
+
+using namespace dmlx_test;
+
+namespace
+{
+    // A small graph whose fingerprint depends on `alpha`.
+    uint64_t GetTestGraphFingerprint(IDMLDevice* device, float alpha, DML_EXECUTION_FLAGS flags = DML_EXECUTION_FLAG_NONE)
+    {
+        dml::Graph graph(device);
+        dml::Expression input = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 2, 3, 4 }));
+        const dml::Expression outputs[] = { dml::ActivationLeakyRelu(dml::Abs(input), alpha) };
+        return graph.GetFingerprint(flags, outputs);
+    }
+
+    void TestHashBytes()
+    {
+        // FNV-1a test vectors; fingerprints saved by earlier runs depend on these
+        CHECK(dml::detail::HashBytes("", 0) == 0xcbf29ce484222325ull);
+        CHECK(dml::detail::HashBytes("a", 1) == 0xaf63dc4c8601ec8cull);
+        CHECK(dml::detail::HashBytes("foobar", 6) == 0x85944171f73967e8ull);
+    }
+
+    void TestFingerprintStability()
+    {
+        auto device = MakeStub<StubDevice>();
+        auto otherDevice = MakeStub<StubDevice>();
+
+        const uint64_t fingerprint = GetTestGraphFingerprint(device.Get(), 0.1f);
+        CHECK(GetTestGraphFingerprint(device.Get(), 0.1f) == fingerprint);
+
+        // Fingerprints describe the graph, not the device it's built on
+        CHECK(GetTestGraphFingerprint(otherDevice.Get(), 0.1f) == fingerprint);
+
+        CHECK(GetTestGraphFingerprint(device.Get(), 0.2f) != fingerprint);
+        CHECK(GetTestGraphFingerprint(device.Get(), 0.1f, DML_EXECUTION_FLAG_ALLOW_HALF_PRECISION_COMPUTATION) != fingerprint);
+
+        // Computing a fingerprint doesn't modify the graph
+        dml::Graph graph(device.Get());
+        dml::Expression input = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 2, 3, 4 }));
+        const dml::Expression outputs[] = { dml::ActivationLeakyRelu(dml::Abs(input), 0.1f) };
+        CHECK(graph.GetFingerprint(DML_EXECUTION_FLAG_NONE, outputs) == fingerprint);
+        CHECK(graph.GetFingerprint(DML_EXECUTION_FLAG_NONE, outputs) == fingerprint);
+    }
+
+    uint64_t GetFillValueFingerprint(IDMLDevice* device, DML_SCALAR_UNION value)
+    {
+        dml::Graph graph(device);
+        const dml::Expression outputs[] = { dml::FillValueConstant(graph, { 1, 1, 2, 2 }, DML_TENSOR_DATA_TYPE_UINT8, value) };
+        return graph.GetFingerprint(DML_EXECUTION_FLAG_NONE, outputs);
+    }
+
+    void TestScalarFingerprint()
+    {
+        auto device = MakeStub<StubDevice>();
+
+        // Only the UINT8 member of the union is meaningful; the bytes after it must not affect the fingerprint
+        DML_SCALAR_UNION value;
+        value.UInt64 = 0x1111111111111107ull;
+        DML_SCALAR_UNION sameValue;
+        sameValue.UInt64 = 0x2222222222222207ull;
+        DML_SCALAR_UNION otherValue;
+        otherValue.UInt64 = 0x1111111111111108ull;
+
+        CHECK(GetFillValueFingerprint(device.Get(), value) == GetFillValueFingerprint(device.Get(), sameValue));
+        CHECK(GetFillValueFingerprint(device.Get(), value) != GetFillValueFingerprint(device.Get(), otherValue));
+    }
+
+    void TestCacheCounts()
+    {
+        auto device = MakeStub<StubDevice>();
+        auto otherDevice = MakeStub<StubDevice>();
+        auto compiledGraph = MakeStub<StubCompiledOperator>();
+
+        dml::GraphCompilationCache cache;
+        const uint64_t fingerprint = 0x1234;
+        const std::string encoding = "graph";
+
+        CHECK(cache.Find(device.Get(), fingerprint, encoding) == nullptr);
+        cache.Insert(device.Get(), fingerprint, encoding, compiledGraph.Get());
+        CHECK(cache.Find(device.Get(), fingerprint, encoding).Get() == compiledGraph.Get());
+        CHECK(cache.Find(device.Get(), fingerprint, encoding).Get() == compiledGraph.Get());
+
+        // Compiled graphs are only shared on the device they were compiled on
+        CHECK(cache.Find(otherDevice.Get(), fingerprint, encoding) == nullptr);
+
+        // A different graph with the same fingerprint is a collision, not a hit
+        CHECK(cache.Find(device.Get(), fingerprint, "other graph") == nullptr);
+        CHECK(cache.Find(device.Get(), fingerprint + 1, encoding) == nullptr);
+
+        const dml::GraphCompilationCache::Counts totals = cache.GetCounts();
+        CHECK(totals.hits == 2);
+        CHECK(totals.misses == 4);
+
+        const dml::GraphCompilationCache::Counts counts = cache.GetCounts(fingerprint);
+        CHECK(counts.hits == 2);
+        CHECK(counts.misses == 3);
+        CHECK(cache.GetCounts(fingerprint + 1).misses == 1);
+
+        // Clearing drops the entries but keeps the counts
+        cache.Clear();
+        CHECK(cache.Find(device.Get(), fingerprint, encoding) == nullptr);
+        CHECK(cache.GetCounts().hits == 2);
+        CHECK(cache.GetCounts().misses == 5);
+    }
+
+#ifdef _WIN32
+    #define TEST_PATH(_path) L##_path
+#else
+    #define TEST_PATH(_path) _path
+#endif
+
+    void TestStatisticsFlush()
+    {
+        auto device = MakeStub<StubDevice>();
+        const dml::PathChar* path = TEST_PATH("GraphCompilationCacheTests.statistics.txt");
+
+        {
+            dml::GraphCompilationCache cache(path);
+            cache.Find(device.Get(), 0x1234, "graph");
+            cache.Find(device.Get(), 0x1234, "graph");
+            cache.FlushStatistics();
+        }
+
+        // Counts accumulate across runs
+        {
+            dml::GraphCompilationCache cache(path);
+            CHECK(cache.GetCounts(0x1234).misses == 2);
+            cache.Find(device.Get(), 0x1234, "graph");
+            cache.FlushStatistics();
+        }
+        CHECK(dml::GraphCompilationCache(path).GetCounts(0x1234).misses == 3);
+#ifdef _WIN32
+        _wremove(path);
+#else
+        std::remove(path);
+#endif
+
+#if __cpp_exceptions
+        // A flush reports failure, rather than it being lost in the destructor
+        dml::GraphCompilationCache cache(TEST_PATH("missing-directory/statistics.txt"));
+        cache.Find(device.Get(), 0x1234, "graph");
+        bool threw = false;
+        try
+        {
+            cache.FlushStatistics();
+        }
+        catch (...)
+        {
+            threw = true;
+        }
+        CHECK(threw);
+#endif
+    }
+}
+
+int main()
+{
+    TestHashBytes();
+    TestFingerprintStability();
+    TestScalarFingerprint();
+    TestCacheCounts();
+    TestStatisticsFlush();
+    return Finish();
+}
@@ -0,0 +1,174 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+// Measures the heap allocations and time taken to build a graph with the DirectMLX builder functions: the yolov4 graph
+// of Samples/yolov4 at 608x608, and a synthetic graph of 10,000 operators. Each graph is built
+//
+//   - cold: into a new dml::Graph,
+//   - reserved: into a new dml::Graph whose arena was first reserved with the high-water mark of a cold build (see
+//     Graph::ReserveArena, which only takes effect while the arena is empty), and
+//   - reset: into a dml::Graph that was reset after building the same graph, reusing its storage.
+//
+// CMakeLists.txt also builds this benchmark as GraphConstructionBenchmarkStdVector, with DMLX_USE_STD_SMALL_VECTOR,
+// which makes SmallVector (and so TensorDimensions) a std::vector as before small_vector was added. Comparing the
+// two shows the allocations saved by storing tensor dimensions inline.
+
+#include "Yolov4Model.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+#if defined(__GNUC__) && !defined(__clang__)
+    // The replacement operator delete below frees what the replacement operator new allocated with malloc
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace
+{
+    std::atomic<uint64_t> g_allocationCount{ 0 };
+    std::atomic<uint64_t> g_allocationBytes{ 0 };
+}
+
+// Counts every allocation made through the global operator new. The array and nothrow forms forward to these.
+void* operator new(size_t size)
+{
+    ++g_allocationCount;
+    g_allocationBytes += size;
+    if (void* data = std::malloc(size ? size : 1))
+    {
+        return data;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* data) noexcept { std::free(data); }
+void operator delete(void* data, size_t) noexcept { std::free(data); }
+
+using namespace dmlx_test;
+
+namespace
+{
+    struct Measurement
+    {
+        uint64_t allocationCount = 0;
+        uint64_t allocationBytes = 0;
+        double seconds = 0;
+    };
+
+    // Runs `build` several times and keeps the fastest run; allocation counts are the same for every run.
+    template <typename T>
+    Measurement Measure(uint32_t runCount, T&& build)
+    {
+        Measurement fastest;
+        fastest.seconds = INFINITY;
+        for (uint32_t i = 0; i < runCount; ++i)
+        {
+            const uint64_t allocationCount = g_allocationCount;
+            const uint64_t allocationBytes = g_allocationBytes;
+            Stopwatch stopwatch;
+            build(i);
+            const double seconds = stopwatch.GetElapsedSeconds();
+            if (seconds < fastest.seconds)
+            {
+                fastest.allocationCount = g_allocationCount - allocationCount;
+                fastest.allocationBytes = g_allocationBytes - allocationBytes;
+                fastest.seconds = seconds;
+            }
+        }
+        return fastest;
+    }
+
+    void PrintMeasurement(const char* graphName, const char* mode, const Measurement& measurement, uint32_t nodeCount)
+    {
+        std::printf("%-10s %-9s %12llu %14.1f %12.3f %14.1f\n",
+            graphName,
+            mode,
+            static_cast<unsigned long long>(measurement.allocationCount),
+            measurement.allocationBytes / 1024.0,
+            measurement.seconds * 1e3,
+            measurement.seconds * 1e9 / nodeCount);
+    }
+
+    std::vector<dml::Expression> BuildYolov4(dml::Graph& graph)
+    {
+        Yolov4Model model(graph, 608, 608);
+        assert(model.GetConvolutionLayers().size() == 110);
+        const Yolov4Model::Outputs& outputs = model.GetOutputs();
+        return { outputs.smallBoxes, outputs.mediumBoxes, outputs.largeBoxes };
+    }
+
+    // 10,000 operators over tensors of varied ranks and sizes: element-wise chains, reinterprets, joins and splits,
+    // eight operators per block.
+    std::vector<dml::Expression> BuildSynthetic(dml::Graph& graph)
+    {
+        dml::Expression x = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 32, 16, 16 }));
+        const uint32_t splitSizes[] = { 16, 16 };
+        for (uint32_t i = 0; i < 1250; ++i)
+        {
+            dml::Expression a = dml::ActivationSigmoid(dml::Abs(x));
+            dml::Expression b = dml::Reinterpret(a, { 1, 32, 256 }, dml::NullOpt);
+            b = dml::Reinterpret(dml::Exp(b * b), { 1, 32, 16, 16 }, dml::NullOpt);
+            std::vector<dml::Expression> halves = dml::Split(a + b, 1, splitSizes);
+            const dml::Expression joined[] = { halves[1], halves[0] };
+            x = dml::Join(joined, 1) - x;
+        }
+        return { x };
+    }
+
+    void Benchmark(IDMLDevice* device, const char* graphName, std::vector<dml::Expression> (*build)(dml::Graph&))
+    {
+        const uint32_t runCount = 5;
+
+        std::unique_ptr<dml::Graph> graph;
+        std::vector<dml::Expression> outputs;
+        const Measurement cold = Measure(runCount, [&](uint32_t)
+        {
+            outputs.clear();
+            graph = nullptr;
+            graph = std::make_unique<dml::Graph>(device);
+            outputs = build(*graph);
+        });
+
+        const dml::detail::GraphDesc desc = graph->Impl()->GetGraphDesc(outputs);
+        const uint32_t nodeCount = static_cast<uint32_t>(desc.nodes.size()) + desc.prunedNodeCount;
+        const uint64_t highWaterMark = graph->GetArenaStatistics().highWaterMarkBytes;
+
+        // Constructing the graph is part of the measurement, so reserving is too
+        const Measurement reserved = Measure(runCount, [&](uint32_t)
+        {
+            outputs.clear();
+            graph = nullptr;
+            graph = std::make_unique<dml::Graph>(device);
+            graph->ReserveArena(static_cast<size_t>(highWaterMark));
+            outputs = build(*graph);
+        });
+
+        const Measurement reset = Measure(runCount, [&](uint32_t)
+        {
+            outputs.clear();
+            graph->Reset();
+            outputs = build(*graph);
+        });
+
+        PrintMeasurement(graphName, "cold", cold, nodeCount);
+        PrintMeasurement(graphName, "reserved", reserved, nodeCount);
+        PrintMeasurement(graphName, "reset", reset, nodeCount);
+        std::printf("%-10s %u operator nodes, arena high-water mark %.1f KiB\n", graphName, nodeCount, highWaterMark / 1024.0);
+    }
+}
+
+int main()
+{
+    auto device = MakeStub<StubDevice>();
+
+#if DMLX_USE_STD_SMALL_VECTOR
+    std::printf("SmallVector: std::vector\n");
+#else
+    std::printf("SmallVector: dml::detail::small_vector\n");
+#endif
+    std::printf("%-10s %-9s %12s %14s %12s %14s\n", "graph", "build", "allocations", "allocated (KiB)", "time (ms)", "per node (ns)");
+
+    Benchmark(device.Get(), "yolov4", BuildYolov4);
+    Benchmark(device.Get(), "synthetic", BuildSynthetic);
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+// Measures GraphBuilder::GetGraphDesc, which turns the nodes an output depends on into DirectML graph edges, on
+// synthetic graphs of about 50,000 nodes (or the node count given on the command line). Each block of the graph is
+// an operator, a chain of reinterprets of its output and an operator reading the end of the chain twice:
+//
+//   x = Abs(x); r = Reinterpret(...Reinterpret(x)); x = r + r
+//
+// Reinterpret chains are resolved to their root producer when the reinterprets are created, so emitting an edge
+// doesn't walk the chain, and the time per edge should stay flat as the chains get longer. The full compile path
+// (copy, optimizations and GetGraphDesc, through Graph::EstimateCost) is timed as well.
+
+#include "TestHelpers.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace dmlx_test;
+
+namespace
+{
+    struct SyntheticGraph
+    {
+        std::unique_ptr<dml::Graph> graph;
+        dml::Expression output;
+        uint32_t nodeCount = 0;
+    };
+
+    SyntheticGraph BuildSyntheticGraph(IDMLDevice* device, uint32_t nodeCount, uint32_t chainLength)
+    {
+        SyntheticGraph result;
+        result.graph = std::make_unique<dml::Graph>(device);
+
+        // Alternate between two shapes with the same element count, so every reinterpret changes the sizes
+        const dml::TensorDimensions sizes = { 1, 16, 4, 4 };
+        const dml::TensorDimensions flatSizes = { 1, 16, 16, 1 };
+
+        dml::Expression x = dml::InputTensor(*result.graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, sizes));
+        result.nodeCount = 1;
+        while (result.nodeCount + chainLength + 2 <= nodeCount)
+        {
+            x = dml::Abs(x);
+            dml::Expression r = x;
+            for (uint32_t i = 0; i < chainLength; ++i)
+            {
+                r = dml::Reinterpret(r, (i % 2 == 0 && i + 1 < chainLength) ? flatSizes : sizes, dml::NullOpt);
+            }
+            x = r + r;
+            result.nodeCount += chainLength + 2;
+        }
+
+        result.output = x;
+        return result;
+    }
+
+    // The fastest of several runs, in seconds.
+    template <typename T>
+    double TimeFastest(uint32_t runCount, T&& function)
+    {
+        double fastest = INFINITY;
+        for (uint32_t i = 0; i < runCount; ++i)
+        {
+            Stopwatch stopwatch;
+            function();
+            fastest = std::min(fastest, stopwatch.GetElapsedSeconds());
+        }
+        return fastest;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t nodeCount = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 50000;
+    auto device = MakeStub<StubDevice>();
+
+    std::printf("%u nodes\n", nodeCount);
+    std::printf("%8s %10s %10s %12s %12s %14s %14s\n",
+        "chain", "operators", "edges", "build (ms)", "desc (ms)", "desc/edge (ns)", "compile (ms)");
+
+    const uint32_t chainLengths[] = { 0, 1, 4, 16, 64 };
+    for (uint32_t chainLength : chainLengths)
+    {
+        Stopwatch buildStopwatch;
+        SyntheticGraph synthetic = BuildSyntheticGraph(device.Get(), nodeCount, chainLength);
+        const double buildSeconds = buildStopwatch.GetElapsedSeconds();
+
+        const dml::Expression outputs[] = { synthetic.output };
+        dml::detail::GraphDesc desc = synthetic.graph->Impl()->GetGraphDesc(outputs);
+        const size_t edgeCount = desc.inputEdges.size() + desc.outputEdges.size() + desc.intermediateEdges.size();
+
+        const double descSeconds = TimeFastest(5, [&]
+        {
+            desc = synthetic.graph->Impl()->GetGraphDesc(outputs);
+        });
+
+        const double compileSeconds = TimeFastest(3, [&]
+        {
+            synthetic.graph->EstimateCost(outputs);
+        });
+
+        std::printf("%8u %10zu %10zu %12.2f %12.2f %14.1f %14.2f\n",
+            chainLength,
+            desc.nodes.size(),
+            edgeCount,
+            buildSeconds * 1e3,
+            descSeconds * 1e3,
+            descSeconds * 1e9 / edgeCount,
+            compileSeconds * 1e3);
+    }
+
+    return 0;
+}
@@ -0,0 +1,501 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+// Tests of the transformations that Graph::Compile applies (see dml::GraphOptimizations). Each test compiles a small
+// graph on the stub device in TestHelpers.h and checks the graph passed to DirectML, then runs the graph on the CPU
+// executor with and without the transformation and compares the results.
+
+#include "TestHelpers.h"
+
+#include <cstring>
+
+using namespace dmlx_test;
+
+namespace
+{
+    // Compiles outputs with the given optimizations, and returns what the device was asked to compile.
+    CompiledGraphRecord CompileWith(
+        dml::Graph& graph,
+        StubDevice* device,
+        dml::GraphOptimizations optimizations,
+        dml::Span<const dml::Expression> outputs)
+    {
+        graph.SetOptimizations(optimizations);
+        graph.Compile(DML_EXECUTION_FLAG_NONE, outputs);
+        return device->GetCompiledGraphs().back();
+    }
+
+    // Runs the graph on the CPU executor with the given optimizations.
+    std::vector<float> ExecuteWith(
+        dml::Graph& graph,
+        dml::GraphOptimizations optimizations,
+        dml::Expression output,
+        const std::vector<const std::vector<float>*>& inputs)
+    {
+        graph.SetOptimizations(optimizations);
+        return ExecuteFloat(graph, output, inputs);
+    }
+
+    // The fused activation of the first node of the given type, or DML_OPERATOR_INVALID if it has none.
+    template <typename TDesc>
+    DML_OPERATOR_TYPE GetFusedActivationType(const CompiledGraphRecord& record, DML_OPERATOR_TYPE type)
+    {
+        for (size_t i = 0; i < record.nodes.size(); ++i)
+        {
+            if (record.GetNodeDesc(i).Type == type)
+            {
+                const auto& desc = *static_cast<const TDesc*>(record.GetNodeDesc(i).Desc);
+                return desc.FusedActivation ? desc.FusedActivation->Type : DML_OPERATOR_INVALID;
+            }
+        }
+        return DML_OPERATOR_INVALID;
+    }
+
+    void TestScaleBiasFolding()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph graph(device.Get());
+
+        // A chain of scalar operations is composed into the scale and bias of the operator that reads it
+        dml::Expression input = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 2, 3, 4 }));
+        const dml::Expression chain[] = { dml::Exp((input * 2.0f + 1.0f) * 0.5f) };
+
+        const CompiledGraphRecord folded = CompileWith(graph, device.Get(), dml::GraphOptimizations::ScaleBiasFolding, chain);
+        CHECK(graph.GetStatistics().foldedScaleBiasCount == 3);
+        CHECK(folded.nodes.size() == 1);
+        if (folded.nodes.size() == 1)
+        {
+            CHECK(folded.GetNodeDesc(0).Type == DML_OPERATOR_ELEMENT_WISE_EXP);
+            const auto& exp = *static_cast<const DML_ELEMENT_WISE_EXP_OPERATOR_DESC*>(folded.GetNodeDesc(0).Desc);
+            CHECK(exp.ScaleBias && exp.ScaleBias->Scale == 1.0f && exp.ScaleBias->Bias == 0.5f);
+        }
+
+        const std::vector<float> inputData = RandomFloats(24, 1);
+        const std::vector<float> expected = ExecuteWith(graph, dml::GraphOptimizations::None, chain[0], { &inputData });
+        const std::vector<float> actual = ExecuteWith(graph, dml::GraphOptimizations::ScaleBiasFolding, chain[0], { &inputData });
+        CHECK(MaxAbsoluteDifference(actual, expected) < 1e-5);
+
+        // A scaled tensor read by two operators is computed once, and so is one that is also a graph output
+        dml::Expression scaled = input * 3.0f;
+        const dml::Expression shared[] = { dml::Exp(scaled) + dml::Abs(scaled) };
+        const CompiledGraphRecord sharedGraph = CompileWith(graph, device.Get(), dml::GraphOptimizations::ScaleBiasFolding, shared);
+        CHECK(graph.GetStatistics().foldedScaleBiasCount == 0);
+        CHECK(sharedGraph.CountNodes(DML_OPERATOR_ELEMENT_WISE_IDENTITY) == 1);
+
+        const dml::Expression alsoOutput[] = { dml::Exp(scaled), scaled };
+        const CompiledGraphRecord outputGraph = CompileWith(graph, device.Get(), dml::GraphOptimizations::ScaleBiasFolding, alsoOutput);
+        CHECK(graph.GetStatistics().foldedScaleBiasCount == 0);
+        CHECK(outputGraph.CountNodes(DML_OPERATOR_ELEMENT_WISE_IDENTITY) == 1);
+    }
+
+    void TestActivationFusion()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph graph(device.Get());
+
+        auto input = [&](uint32_t index, dml::TensorDimensions sizes)
+        {
+            return dml::InputTensor(graph, index, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, std::move(sizes)));
+        };
+        const uint32_t padding[] = { 1, 1 };
+        const uint32_t axes[] = { 2, 3 };
+        dml::Expression conv = dml::ConvolutionBuilder(input(0, { 1, 3, 5, 5 }), input(1, { 4, 3, 3, 3 }))
+            .StartPadding(padding)
+            .EndPadding(padding)
+            .Build();
+        dml::Expression gemm = dml::Gemm(input(2, { 1, 1, 6, 7 }), input(3, { 1, 1, 7, 5 }));
+        dml::Expression batchNormalization = dml::BatchNormalization(
+            input(4, { 1, 4, 5, 5 }), input(5, { 1, 4, 1, 1 }), input(6, { 1, 4, 1, 1 }), input(7, { 1, 4, 1, 1 }), input(8, { 1, 4, 1, 1 }), true, 1e-5f);
+        dml::Expression meanVarianceNormalization = dml::MeanVarianceNormalization(input(9, { 1, 2, 3, 4 }), dml::NullOpt, dml::NullOpt, axes, true, 1e-5f);
+
+        // Each activation is the only consumer of an operator that can fuse it
+        const dml::Expression outputs[] =
+        {
+            dml::ActivationRelu(conv),
+            dml::ActivationSigmoid(gemm),
+            dml::ActivationLeakyRelu(batchNormalization, 0.2f),
+            dml::ActivationTanh(meanVarianceNormalization),
+        };
+        const CompiledGraphRecord fused = CompileWith(graph, device.Get(), dml::GraphOptimizations::ActivationFusion, outputs);
+        CHECK(graph.GetStatistics().fusedActivationCount == 4);
+        CHECK(fused.nodes.size() == 4);
+        CHECK(GetFusedActivationType<DML_CONVOLUTION_OPERATOR_DESC>(fused, DML_OPERATOR_CONVOLUTION) == DML_OPERATOR_ACTIVATION_RELU);
+        CHECK(GetFusedActivationType<DML_GEMM_OPERATOR_DESC>(fused, DML_OPERATOR_GEMM) == DML_OPERATOR_ACTIVATION_SIGMOID);
+        CHECK(GetFusedActivationType<DML_BATCH_NORMALIZATION_OPERATOR_DESC>(fused, DML_OPERATOR_BATCH_NORMALIZATION) == DML_OPERATOR_ACTIVATION_LEAKY_RELU);
+        CHECK(GetFusedActivationType<DML_MEAN_VARIANCE_NORMALIZATION1_OPERATOR_DESC>(fused, DML_OPERATOR_MEAN_VARIANCE_NORMALIZATION1) == DML_OPERATOR_ACTIVATION_TANH);
+
+        const uint32_t inputSizes[] = { 75, 108, 42, 35, 100, 4, 4, 4, 4, 24 };
+        std::vector<std::vector<float>> inputData;
+        std::vector<const std::vector<float>*> inputPointers;
+        for (uint32_t i = 0; i < std::size(inputSizes); ++i)
+        {
+            // The variance (input 6) must be positive
+            inputData.push_back(i == 6 ? RandomFloats(inputSizes[i], i, 0.5f, 2.0f) : RandomFloats(inputSizes[i], i));
+        }
+        for (const std::vector<float>& data : inputData)
+        {
+            inputPointers.push_back(&data);
+        }
+        for (const dml::Expression& output : outputs)
+        {
+            const std::vector<float> expected = ExecuteWith(graph, dml::GraphOptimizations::None, output, inputPointers);
+            const std::vector<float> actual = ExecuteWith(graph, dml::GraphOptimizations::ActivationFusion, output, inputPointers);
+            CHECK(MaxAbsoluteDifference(actual, expected) < 1e-5);
+        }
+
+        // Not fused: the producer's output is also read elsewhere, or the producer already has an activation
+        const dml::Expression shared[] = { dml::ActivationRelu(conv), conv };
+        const CompiledGraphRecord sharedGraph = CompileWith(graph, device.Get(), dml::GraphOptimizations::ActivationFusion, shared);
+        CHECK(graph.GetStatistics().fusedActivationCount == 0);
+        CHECK(sharedGraph.CountNodes(DML_OPERATOR_ACTIVATION_RELU) == 1);
+
+        dml::Expression gemmRelu = dml::Gemm(input(10, { 1, 1, 6, 7 }), input(11, { 1, 1, 7, 5 }), dml::NullOpt,
+            DML_MATRIX_TRANSFORM_NONE, DML_MATRIX_TRANSFORM_NONE, 1.0f, 1.0f, dml::FusedActivation::Relu());
+        const dml::Expression alreadyFused[] = { dml::ActivationSigmoid(gemmRelu) };
+        const CompiledGraphRecord alreadyFusedGraph = CompileWith(graph, device.Get(), dml::GraphOptimizations::ActivationFusion, alreadyFused);
+        CHECK(graph.GetStatistics().fusedActivationCount == 0);
+        CHECK(alreadyFusedGraph.CountNodes(DML_OPERATOR_ACTIVATION_SIGMOID) == 1);
+        CHECK(GetFusedActivationType<DML_GEMM_OPERATOR_DESC>(alreadyFusedGraph, DML_OPERATOR_GEMM) == DML_OPERATOR_ACTIVATION_RELU);
+    }
+
+    // The constant data bound to an input of a node, or an empty span if the input isn't a constant graph input.
+    dml::Span<const uint8_t> GetNodeInputData(const dml::Graph& graph, const CompiledGraphRecord& record, size_t nodeIndex, uint32_t inputIndex)
+    {
+        for (const DML_INPUT_GRAPH_EDGE_DESC& edge : record.inputEdges)
+        {
+            if (edge.ToNodeIndex == nodeIndex && edge.ToNodeInputIndex == inputIndex)
+            {
+                return graph.GetConstantInputData(edge.GraphInputIndex);
+            }
+        }
+        return {};
+    }
+
+    // Checks that the DEQUANTIZE_LINEAR node reconstructs each weight to within half a step, and zeros exactly. Weight
+    // e belongs to channel (e / innerCount) % channelCount.
+    void CheckDequantizedWeights(
+        const dml::Graph& graph,
+        const CompiledGraphRecord& record,
+        size_t nodeIndex,
+        const std::vector<float>& weights,
+        uint32_t channelCount,
+        uint32_t innerCount)
+    {
+        const dml::Span<const uint8_t> quantized = GetNodeInputData(graph, record, nodeIndex, 0);
+        const dml::Span<const uint8_t> scaleBytes = GetNodeInputData(graph, record, nodeIndex, 1);
+        const dml::Span<const uint8_t> zeroPoints = GetNodeInputData(graph, record, nodeIndex, 2);
+        CHECK(quantized.size() == weights.size());
+        CHECK(scaleBytes.size() == channelCount * sizeof(float) && zeroPoints.size() == channelCount);
+        if (quantized.size() != weights.size() || scaleBytes.size() != channelCount * sizeof(float) || zeroPoints.size() != channelCount)
+        {
+            return;
+        }
+
+        std::vector<float> scales(channelCount);
+        std::memcpy(scales.data(), scaleBytes.data(), scaleBytes.size());
+        for (size_t e = 0; e < weights.size(); ++e)
+        {
+            const size_t c = (e / innerCount) % channelCount;
+            const float dequantized = (static_cast<int8_t>(quantized[e]) - static_cast<int8_t>(zeroPoints[c])) * scales[c];
+            CHECK(std::abs(dequantized - weights[e]) <= scales[c] * 0.5f + 1e-6f);
+            CHECK(weights[e] != 0.0f || dequantized == 0.0f);
+        }
+    }
+
+    void TestWeightQuantization()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph graph(device.Get());
+
+        // A convolution filter with a channel per output feature, with some zero weights, and a GEMM B with a channel
+        // per column. Both convolutions read the same filter, which is quantized once.
+        std::vector<float> filterData = RandomFloats(8 * 4 * 3 * 3, 1);
+        for (size_t i = 0; i < filterData.size(); i += 7)
+        {
+            filterData[i] = 0.0f;
+        }
+        const std::vector<float> weightsData = RandomFloats(16 * 12, 2);
+        const std::vector<float> imageData = RandomFloats(4 * 6 * 6, 3);
+        const std::vector<float> otherImageData = RandomFloats(4 * 6 * 6, 4);
+        const std::vector<float> matrixData = RandomFloats(5 * 16, 5);
+        const std::vector<float> variableFilterData = RandomFloats(8 * 4 * 3 * 3, 6);
+
+        dml::Expression image = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 4, 6, 6 }));
+        dml::Expression otherImage = dml::InputTensor(graph, 1, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 4, 6, 6 }));
+        dml::Expression matrix = dml::InputTensor(graph, 2, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 1, 5, 16 }));
+        dml::Expression filter = FloatConstant(graph, 3, { 8, 4, 3, 3 }, filterData);
+        dml::Expression weights = FloatConstant(graph, 4, { 1, 1, 16, 12 }, weightsData);
+        dml::Expression variableFilter = dml::InputTensor(graph, 5, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 8, 4, 3, 3 }));
+
+        // Filters that aren't constant are left alone
+        const dml::Expression outputs[] =
+        {
+            dml::Convolution(image, filter) + dml::Convolution(otherImage, filter),
+            dml::Gemm(matrix, weights),
+            dml::Convolution(image, variableFilter),
+        };
+        const CompiledGraphRecord quantized = CompileWith(graph, device.Get(), dml::GraphOptimizations::WeightQuantization, outputs);
+        CHECK(quantized.CountNodes(DML_OPERATOR_ELEMENT_WISE_DEQUANTIZE_LINEAR) == 2);
+        CHECK(graph.GetStatistics().quantizedWeightCount == 2);
+
+        // Each tensor saves its FLOAT32 data less one byte per weight and five bytes (a scale and a zero point) per
+        // channel. The quantized data, scales and zero points are added as inputs.
+        const uint64_t filterBytesSaved = filterData.size() * 3 - 8 * 5;
+        const uint64_t weightsBytesSaved = weightsData.size() * 3 - 12 * 5;
+        CHECK(graph.GetStatistics().quantizedWeightBytesSaved == filterBytesSaved + weightsBytesSaved);
+        CHECK(graph.GetInputCount() == 6 + 2 * 3);
+
+        uint32_t convolutionsReadingDequantized = 0;
+        for (size_t i = 0; i < quantized.nodes.size(); ++i)
+        {
+            const DML_OPERATOR_DESC& desc = quantized.GetNodeDesc(i);
+            if (desc.Type == DML_OPERATOR_ELEMENT_WISE_DEQUANTIZE_LINEAR)
+            {
+                const auto& dequantize = *static_cast<const DML_ELEMENT_WISE_DEQUANTIZE_LINEAR_OPERATOR_DESC*>(desc.Desc);
+                const auto& input = *static_cast<const DML_BUFFER_TENSOR_DESC*>(dequantize.InputTensor->Desc);
+                CHECK(input.DataType == DML_TENSOR_DATA_TYPE_INT8);
+                if (input.DimensionCount == 4 && input.Sizes[0] == 8)
+                {
+                    CheckDequantizedWeights(graph, quantized, i, filterData, 8, 4 * 3 * 3);
+                }
+                else
+                {
+                    CheckDequantizedWeights(graph, quantized, i, weightsData, 12, 1);
+                }
+            }
+            else if (desc.Type == DML_OPERATOR_CONVOLUTION)
+            {
+                // The filters are read from a node, not a graph input
+                bool filterFromGraphInput = false;
+                for (const DML_INPUT_GRAPH_EDGE_DESC& edge : quantized.inputEdges)
+                {
+                    filterFromGraphInput |= edge.ToNodeIndex == i && edge.ToNodeInputIndex == 1;
+                }
+                convolutionsReadingDequantized += filterFromGraphInput ? 0 : 1;
+            }
+        }
+        CHECK(convolutionsReadingDequantized == 2);
+
+        // The outputs stay close to the FLOAT32 graph's: each product is off by at most half a quantization step
+        const std::vector<const std::vector<float>*> inputs = { &imageData, &otherImageData, &matrixData, nullptr, nullptr, &variableFilterData };
+        for (const dml::Expression& output : outputs)
+        {
+            const std::vector<float> expected = ExecuteWith(graph, dml::GraphOptimizations::None, output, inputs);
+            const std::vector<float> actual = ExecuteWith(graph, dml::GraphOptimizations::WeightQuantization, output, inputs);
+            CHECK(MaxAbsoluteDifference(actual, expected) < 0.05);
+        }
+        const std::vector<float> unquantized = ExecuteWith(graph, dml::GraphOptimizations::None, outputs[2], inputs);
+        CHECK(ExecuteWith(graph, dml::GraphOptimizations::WeightQuantization, outputs[2], inputs) == unquantized);
+
+        // cpu::QuantizeWeights measures the same difference, and leaves the graph quantizing its weights
+        graph.SetOptimizations(dml::GraphOptimizations::None);
+        const std::vector<const void*> sample = { imageData.data(), otherImageData.data(), matrixData.data(), nullptr, nullptr, variableFilterData.data() };
+        const dml::cpu::WeightQuantizationReport report = dml::cpu::QuantizeWeights(graph, outputs, dml::Span<const std::vector<const void*>>(&sample, 1));
+        CHECK(report.quantizedWeightCount == 2);
+        CHECK(report.bytesSaved == filterBytesSaved + weightsBytesSaved);
+        CHECK(report.outputs.size() == 3);
+        if (report.outputs.size() == 3)
+        {
+            CHECK(report.outputs[0].elementCount == 8 * 4 * 4 && report.outputs[1].elementCount == 5 * 12);
+            CHECK(report.outputs[0].maxAbsoluteError > 0 && report.outputs[0].GetRelativeRmsError() < 0.01);
+            CHECK(report.outputs[1].maxAbsoluteError > 0 && report.outputs[1].GetRelativeRmsError() < 0.01);
+            CHECK(report.outputs[2].maxAbsoluteError == 0);
+        }
+        CHECK(graph.GetOptimizations() == dml::GraphOptimizations::WeightQuantization);
+    }
+
+    // The data type of a tensor in an operator desc.
+    DML_TENSOR_DATA_TYPE GetDataType(const DML_TENSOR_DESC* tensor)
+    {
+        return static_cast<const DML_BUFFER_TENSOR_DESC*>(tensor->Desc)->DataType;
+    }
+
+    void TestMixedPrecision()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph graph(device.Get());
+
+        const std::vector<float> imageData = RandomFloats(4 * 6 * 6, 1);
+        const std::vector<float> filterData = RandomFloats(8 * 4 * 3 * 3, 2);
+        const std::vector<float> biasData = RandomFloats(8, 3);
+        dml::Expression image = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 4, 6, 6 }));
+        dml::Expression filter = FloatConstant(graph, 1, { 8, 4, 3, 3 }, filterData);
+        dml::Expression bias = FloatConstant(graph, 2, { 1, 8, 1, 1 }, biasData);
+
+        // The convolution, ReLU and Abs run in FLOAT16, and the normalization stays in FLOAT32 under the default
+        // policy. Tensors cross between the two through casts, four in all: the graph input, the ReLU's output read
+        // by the normalization, the normalization's output read by the Abs, and the Abs's output to the graph output.
+        const uint32_t axes[] = { 2, 3 };
+        dml::Expression relu = dml::ActivationRelu(dml::Convolution(image, filter, bias));
+        dml::Expression normalized = dml::MeanVarianceNormalization(relu, dml::NullOpt, dml::NullOpt, axes, true, 1e-5f);
+        const dml::Expression outputs[] = { dml::Abs(normalized) };
+
+        const CompiledGraphRecord converted = CompileWith(graph, device.Get(), dml::GraphOptimizations::MixedPrecision, outputs);
+        CHECK(graph.GetStatistics().float16OperatorCount == 3);
+        CHECK(graph.GetStatistics().float16ConstantBytesSaved == (filterData.size() + biasData.size()) * 2);
+        CHECK(converted.CountNodes(DML_OPERATOR_CAST) == 4);
+        CHECK(converted.nodes.size() == 8);
+
+        // The filter and bias are converted on the CPU and added as inputs
+        CHECK(graph.GetInputCount() == 5);
+        CHECK(graph.GetConstantInputData(3).size() * 2 == filterData.size() * sizeof(float));
+        CHECK(graph.GetConstantInputData(4).size() * 2 == biasData.size() * sizeof(float));
+
+        for (size_t i = 0; i < converted.nodes.size(); ++i)
+        {
+            const DML_OPERATOR_DESC& desc = converted.GetNodeDesc(i);
+            if (desc.Type == DML_OPERATOR_CONVOLUTION)
+            {
+                const auto& conv = *static_cast<const DML_CONVOLUTION_OPERATOR_DESC*>(desc.Desc);
+                CHECK(GetDataType(conv.InputTensor) == DML_TENSOR_DATA_TYPE_FLOAT16);
+                CHECK(GetDataType(conv.FilterTensor) == DML_TENSOR_DATA_TYPE_FLOAT16);
+                CHECK(GetDataType(conv.BiasTensor) == DML_TENSOR_DATA_TYPE_FLOAT16);
+                CHECK(GetDataType(conv.OutputTensor) == DML_TENSOR_DATA_TYPE_FLOAT16);
+            }
+            else if (desc.Type == DML_OPERATOR_MEAN_VARIANCE_NORMALIZATION1)
+            {
+                const auto& mvn = *static_cast<const DML_MEAN_VARIANCE_NORMALIZATION1_OPERATOR_DESC*>(desc.Desc);
+                CHECK(GetDataType(mvn.InputTensor) == DML_TENSOR_DATA_TYPE_FLOAT32);
+                CHECK(GetDataType(mvn.OutputTensor) == DML_TENSOR_DATA_TYPE_FLOAT32);
+            }
+        }
+
+        // The graph input and output keep their types
+        for (const DML_INPUT_GRAPH_EDGE_DESC& edge : converted.inputEdges)
+        {
+            if (edge.GraphInputIndex == 0)
+            {
+                CHECK(converted.GetNodeDesc(edge.ToNodeIndex).Type == DML_OPERATOR_CAST);
+            }
+        }
+        CHECK(converted.outputEdges.size() == 1);
+        if (converted.outputEdges.size() == 1)
+        {
+            const DML_OPERATOR_DESC& last = converted.GetNodeDesc(converted.outputEdges[0].FromNodeIndex);
+            CHECK(last.Type == DML_OPERATOR_CAST);
+            if (last.Type == DML_OPERATOR_CAST)
+            {
+                CHECK(GetDataType(static_cast<const DML_CAST_OPERATOR_DESC*>(last.Desc)->OutputTensor) == DML_TENSOR_DATA_TYPE_FLOAT32);
+            }
+        }
+
+        // The normalized outputs are around 1, so FLOAT16's precision allows an error of a few thousandths
+        const std::vector<float> expected = ExecuteWith(graph, dml::GraphOptimizations::None, outputs[0], { &imageData });
+        const std::vector<float> actual = ExecuteWith(graph, dml::GraphOptimizations::MixedPrecision, outputs[0], { &imageData });
+        const double error = MaxAbsoluteDifference(actual, expected);
+        CHECK(error > 0 && error < 2e-2);
+
+        // A policy that only allows convolutions converts nothing else
+        dml::MixedPrecisionPolicy policy;
+        policy.float16Operators = { DML_OPERATOR_CONVOLUTION };
+        graph.SetMixedPrecisionPolicy(policy);
+        const CompiledGraphRecord convolutionOnly = CompileWith(graph, device.Get(), dml::GraphOptimizations::MixedPrecision, outputs);
+        CHECK(graph.GetStatistics().float16OperatorCount == 1);
+        CHECK(convolutionOnly.CountNodes(DML_OPERATOR_CAST) == 2);
+        CHECK(MaxAbsoluteDifference(ExecuteWith(graph, dml::GraphOptimizations::MixedPrecision, outputs[0], { &imageData }), expected) < 2e-2);
+
+        // Optional outputs that are absent don't count: pooling without indices has a single output
+        graph.SetMixedPrecisionPolicy({});
+        const uint32_t window[] = { 2, 2 };
+        const dml::Expression pooled[] = { dml::MaxPoolingBuilder(image, window).Strides(window).Build().values };
+        const CompiledGraphRecord pooledGraph = CompileWith(graph, device.Get(), dml::GraphOptimizations::MixedPrecision, pooled);
+        CHECK(graph.GetStatistics().float16OperatorCount == 1);
+        CHECK(pooledGraph.CountNodes(DML_OPERATOR_CAST) == 2);
+        const std::vector<float> expectedPooled = ExecuteWith(graph, dml::GraphOptimizations::None, pooled[0], { &imageData });
+        CHECK(MaxAbsoluteDifference(ExecuteWith(graph, dml::GraphOptimizations::MixedPrecision, pooled[0], { &imageData }), expectedPooled) < 1e-3);
+    }
+
+    void TestMinimumCut()
+    {
+        // Nodes 0 and 1 each prefer a side, at costs of 10 against 1 and 2 against 10, and disagreeing costs 3: the cut
+        // separates them, at a cost of 1 + 2 + 3. Node 4 has no edges and stays on the source side.
+        const uint32_t source = 2;
+        const uint32_t sink = 3;
+        dml::detail::MinimumCut separated(5);
+        separated.AddEdge(source, 0, 10);
+        separated.AddEdge(0, sink, 1);
+        separated.AddEdge(source, 1, 2);
+        separated.AddEdge(1, sink, 10);
+        separated.AddEdge(0, 1, 3, 3);
+        CHECK(separated.Solve(source, sink) == std::vector<bool>({ false, true, false, true, false }));
+
+        // When disagreeing costs more than either node's preference, both take the cheaper side together: the source
+        // side costs 1 + 10 and the sink side 10 + 2
+        dml::detail::MinimumCut joined(4);
+        joined.AddEdge(source, 0, 10);
+        joined.AddEdge(0, sink, 1);
+        joined.AddEdge(source, 1, 2);
+        joined.AddEdge(1, sink, 10);
+        joined.AddEdge(0, 1, 20, 20);
+        CHECK(joined.Solve(source, sink) == std::vector<bool>({ false, false, false, true }));
+    }
+
+    void TestLayoutAssignment()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph graph(device.Get());
+
+        const std::vector<float> imageData = RandomFloats(4 * 8 * 8, 1);
+        const std::vector<float> filter1Data = RandomFloats(8 * 4 * 3 * 3, 2);
+        const std::vector<float> filter2Data = RandomFloats(8 * 8 * 3 * 3, 3);
+        dml::Expression image = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 4, 8, 8 }));
+        dml::Expression filter1 = FloatConstant(graph, 1, { 8, 4, 3, 3 }, filter1Data);
+        dml::Expression filter2 = FloatConstant(graph, 2, { 8, 8, 3, 3 }, filter2Data);
+
+        // The convolutions and pooling prefer the interleaved layout, and the ReLU between them has no preference, so
+        // all four are interleaved. The packed graph input is read as it is, the filters are rearranged on the CPU,
+        // and the graph output is copied back to the packed layout.
+        const uint32_t padding[] = { 1, 1 };
+        const uint32_t window[] = { 2, 2 };
+        dml::Expression conv1 = dml::ConvolutionBuilder(image, filter1).StartPadding(padding).EndPadding(padding).Build();
+        dml::Expression conv2 = dml::ConvolutionBuilder(dml::ActivationRelu(conv1), filter2).StartPadding(padding).EndPadding(padding).Build();
+        const dml::Expression outputs[] = { dml::MaxPoolingBuilder(conv2, window).Strides(window).Build().values };
+
+        const CompiledGraphRecord assigned = CompileWith(graph, device.Get(), dml::GraphOptimizations::LayoutAssignment, outputs);
+        CHECK(graph.GetStatistics().interleavedOperatorCount == 4);
+        CHECK(graph.GetStatistics().layoutConversionCount == 1);
+        CHECK(assigned.nodes.size() == 5);
+        CHECK(assigned.CountNodes(DML_OPERATOR_ELEMENT_WISE_IDENTITY) == 1);
+        CHECK(graph.GetInputCount() == 5);
+
+        for (size_t i = 0; i < assigned.nodes.size(); ++i)
+        {
+            const DML_OPERATOR_DESC& desc = assigned.GetNodeDesc(i);
+            if (desc.Type == DML_OPERATOR_CONVOLUTION)
+            {
+                // NHWC strides for the interleaved output
+                const auto& conv = *static_cast<const DML_CONVOLUTION_OPERATOR_DESC*>(desc.Desc);
+                const auto& output = *static_cast<const DML_BUFFER_TENSOR_DESC*>(conv.OutputTensor->Desc);
+                CHECK(output.Strides && std::vector<uint32_t>(output.Strides, output.Strides + 4) == std::vector<uint32_t>({ 512, 1, 64, 8 }));
+            }
+        }
+
+        const std::vector<float> expected = ExecuteWith(graph, dml::GraphOptimizations::None, outputs[0], { &imageData });
+        const std::vector<float> actual = ExecuteWith(graph, dml::GraphOptimizations::LayoutAssignment, outputs[0], { &imageData });
+        CHECK(MaxAbsoluteDifference(actual, expected) < 1e-5);
+
+        // Operators with no preference stay packed
+        const dml::Expression elementWise[] = { dml::Abs(dml::Exp(image)) };
+        const CompiledGraphRecord unchanged = CompileWith(graph, device.Get(), dml::GraphOptimizations::LayoutAssignment, elementWise);
+        CHECK(graph.GetStatistics().interleavedOperatorCount == 0);
+        CHECK(unchanged.nodes.size() == 2);
+
+        // A JOIN prefers the packed layout. Reading the interleaved pooling output would cost a copy that outweighs
+        // what pooling gains, so the pooling stays packed too.
+        dml::Expression pooled = dml::MaxPoolingBuilder(image, window).Strides(window).Build().values;
+        const dml::Expression joinInputs[] = { pooled, dml::InputTensor(graph, 3, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 4, 4, 4 })) };
+        const dml::Expression joined[] = { dml::Join(joinInputs, 1) };
+        CompileWith(graph, device.Get(), dml::GraphOptimizations::LayoutAssignment, joined);
+        CHECK(graph.GetStatistics().interleavedOperatorCount == 0);
+    }
+}
+
+int main()
+{
+    TestScaleBiasFolding();
+    TestActivationFusion();
+    TestWeightQuantization();
+    TestMixedPrecision();
+    TestMinimumCut();
+    TestLayoutAssignment();
+    return Finish();
+}
@@ -0,0 +1,700 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+// Tests of dml::Graph compilation on the stub device in TestHelpers.h: which state Compile and the analysis members
+// leave behind, and what is passed to DirectML. Graphs rebuilt by Rebatch and Load are run on the CPU executor and
+// compared with the graphs they came from.
+
+#include "Yolov4Model.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <map>
+#include <system_error>
+#include <tuple>
+
+using namespace dmlx_test;
+
+namespace
+{
+    // Convolution followed by a foldable batch normalization, on the constant inputs 1 to 6. Compiling it with the
+    // default optimizations adds the folded filter and bias as inputs 7 and 8.
+    dml::Expression BuildConvBatchNorm(dml::Graph& graph, dml::Expression input, uint32_t seed)
+    {
+        const uint32_t channelCount = input.GetOutputDesc().sizes[1];
+        const uint32_t kernelElementCount = channelCount * 3 * 3;
+        dml::Expression filter = FloatConstant(graph, 1, { channelCount, channelCount, 3, 3 }, RandomFloats(channelCount * kernelElementCount, seed));
+        dml::Expression bias = FloatConstant(graph, 2, { 1, channelCount, 1, 1 }, RandomFloats(channelCount, seed + 1));
+        dml::Expression mean = FloatConstant(graph, 3, { 1, channelCount, 1, 1 }, RandomFloats(channelCount, seed + 2));
+        dml::Expression variance = FloatConstant(graph, 4, { 1, channelCount, 1, 1 }, RandomFloats(channelCount, seed + 3, 0.5f, 2.0f));
+        dml::Expression scale = FloatConstant(graph, 5, { 1, channelCount, 1, 1 }, RandomFloats(channelCount, seed + 4));
+        dml::Expression shift = FloatConstant(graph, 6, { 1, channelCount, 1, 1 }, RandomFloats(channelCount, seed + 5));
+
+        const uint32_t padding[] = { 1, 1 };
+        dml::Expression conv = dml::ConvolutionBuilder(input, filter, bias).StartPadding(padding).EndPadding(padding).Build();
+        return dml::BatchNormalization(conv, mean, variance, scale, shift, true, 1e-5f);
+    }
+
+    void TestAnalysisDoesNotChangeCompiledState()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph graph(device.Get());
+
+        // An unoptimized expression with no constant inputs, and one whose compiled graph adds two
+        dml::Expression input = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 4, 6, 6 }));
+        const dml::Expression plain[] = { dml::Abs(input) };
+        const dml::Expression folded[] = { BuildConvBatchNorm(graph, input, 1) };
+
+        graph.Compile(DML_EXECUTION_FLAG_NONE, plain);
+        CHECK(graph.GetInputCount() == 7);
+        CHECK(graph.GetStatistics().foldedBatchNormalizationCount == 0);
+
+        // The analysis members build the folded graph, but leave the compiled state alone
+        graph.EstimateCost(folded);
+        graph.GetFingerprint(DML_EXECUTION_FLAG_NONE, folded);
+        graph.FormatDot(folded);
+        graph.FormatJson(folded);
+        CHECK(graph.GetInputCount() == 7);
+        CHECK(graph.GetConstantInputData(7).empty());
+        CHECK(graph.GetStatistics().foldedBatchNormalizationCount == 0);
+
+        graph.Compile(DML_EXECUTION_FLAG_NONE, folded);
+        CHECK(graph.GetInputCount() == 9);
+        CHECK(graph.GetConstantInputData(7).size() == 4 * 4 * 3 * 3 * sizeof(float));
+        CHECK(graph.GetConstantInputData(8).size() == 4 * sizeof(float));
+        CHECK(graph.GetStatistics().foldedBatchNormalizationCount == 1);
+
+        // ...and keep describing the last compile
+        graph.EstimateCost(plain);
+        CHECK(graph.GetInputCount() == 9);
+        CHECK(graph.GetStatistics().foldedBatchNormalizationCount == 1);
+
+        graph.Reset();
+        CHECK(graph.GetInputCount() == 0);
+        CHECK(graph.GetStatistics().foldedBatchNormalizationCount == 0);
+    }
+
+    // Folding is on by default and adds inputs to the compiled graph, but doesn't change its result
+    void TestBatchNormalizationFoldingMatchesUnfolded()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph graph(device.Get());
+
+        dml::Expression input = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 2, 5, 7, 9 }));
+        const dml::Expression outputs[] = { BuildConvBatchNorm(graph, input, 7) };
+        const std::vector<float> inputData = RandomFloats(2 * 5 * 7 * 9, 8);
+
+        graph.Compile(DML_EXECUTION_FLAG_NONE, outputs);
+        CHECK(graph.GetInputCount() == 9);
+        CHECK(device->GetCompiledGraphs().back().inputCount == 9);
+        CHECK(device->GetCompiledGraphs().back().CountNodes(DML_OPERATOR_BATCH_NORMALIZATION) == 0);
+        CHECK(device->GetCompiledGraphs().back().CountNodes(DML_OPERATOR_CONVOLUTION) == 1);
+        const std::vector<float> folded = ExecuteFloat(graph, outputs[0], { &inputData });
+
+        graph.SetOptimizations(dml::GraphOptimizations::Default & ~dml::GraphOptimizations::BatchNormalizationFolding);
+        graph.Compile(DML_EXECUTION_FLAG_NONE, outputs);
+        CHECK(graph.GetInputCount() == 7);
+        CHECK(device->GetCompiledGraphs().back().inputCount == 7);
+        CHECK(device->GetCompiledGraphs().back().CountNodes(DML_OPERATOR_BATCH_NORMALIZATION) == 1);
+        const std::vector<float> unfolded = ExecuteFloat(graph, outputs[0], { &inputData });
+
+        CHECK(folded.size() == 2 * 5 * 7 * 9);
+        CHECK(MaxAbsoluteDifference(folded, unfolded) < 1e-4);
+    }
+
+    void TestOperatorsReusedAcrossCompiles()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph graph(device.Get());
+
+        // The two Abs nodes have equal descs
+        dml::Expression input = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 4, 6, 6 }));
+        dml::Expression abs = dml::Abs(dml::Abs(input));
+        const dml::Expression outputs[] = { abs + input };
+        const dml::Expression otherOutputs[] = { abs * input };
+
+        graph.Compile(DML_EXECUTION_FLAG_NONE, outputs);
+        CHECK(device->GetCreateOperatorCount() == 3);
+
+        graph.Compile(DML_EXECUTION_FLAG_NONE, outputs);
+        CHECK(device->GetCreateOperatorCount() == 3);
+
+        // Only the multiply is new
+        graph.Compile(DML_EXECUTION_FLAG_NONE, otherOutputs);
+        CHECK(device->GetCreateOperatorCount() == 4);
+
+        const std::vector<CompiledGraphRecord>& compiledGraphs = device->GetCompiledGraphs();
+        CHECK(compiledGraphs.size() == 3);
+        if (compiledGraphs.size() == 3)
+        {
+            const CompiledGraphRecord& first = compiledGraphs[0];
+            const CompiledGraphRecord& second = compiledGraphs[1];
+            CHECK(first.nodes.size() == 3 && second.nodes.size() == 3);
+            for (size_t i = 0; i < first.nodes.size() && i < second.nodes.size(); ++i)
+            {
+                CHECK(first.nodes[i].Get() == second.nodes[i].Get());
+            }
+
+            // Nodes of one graph don't share operators
+            CHECK(first.nodes[0].Get() != first.nodes[1].Get());
+        }
+
+        // Fused or rewritten nodes reuse operators too, since their descs are the same every time
+        dml::Graph foldedGraph(device.Get());
+        dml::Expression foldedInput = dml::InputTensor(foldedGraph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 4, 6, 6 }));
+        const dml::Expression folded[] = { dml::ActivationRelu(BuildConvBatchNorm(foldedGraph, foldedInput, 1)) };
+        const uint32_t createOperatorCount = device->GetCreateOperatorCount();
+        foldedGraph.Compile(DML_EXECUTION_FLAG_NONE, folded);
+        CHECK(foldedGraph.GetStatistics().foldedBatchNormalizationCount == 1);
+        CHECK(device->GetCreateOperatorCount() == createOperatorCount + 1);
+        foldedGraph.Compile(DML_EXECUTION_FLAG_NONE, folded);
+        CHECK(device->GetCreateOperatorCount() == createOperatorCount + 1);
+    }
+
+    // Tensors that are live at the same time don't overlap, and every placement is aligned and within the arena.
+    void CheckMemoryPlan(const dml::MemoryPlan& plan)
+    {
+        uint64_t unsharedSize = 0;
+        for (const dml::MemoryPlanTensor& tensor : plan.tensors)
+        {
+            CHECK(tensor.offset % plan.alignment == 0 && tensor.sizeInBytes % plan.alignment == 0);
+            CHECK(tensor.sizeInBytes >= tensor.expression.GetOutputDesc().totalTensorSizeInBytes);
+            CHECK(tensor.offset + tensor.sizeInBytes <= plan.arenaSizeInBytes);
+            CHECK(tensor.firstNodeIndex <= tensor.lastNodeIndex);
+            CHECK(plan.Find(tensor.expression) == &tensor);
+            unsharedSize += tensor.sizeInBytes;
+
+            for (const dml::MemoryPlanTensor& other : plan.tensors)
+            {
+                const bool liveTogether = tensor.firstNodeIndex <= other.lastNodeIndex && other.firstNodeIndex <= tensor.lastNodeIndex;
+                const bool overlap = tensor.offset < other.offset + other.sizeInBytes && other.offset < tensor.offset + tensor.sizeInBytes;
+                CHECK(&tensor == &other || !liveTogether || !overlap);
+            }
+        }
+        CHECK(plan.unsharedSizeInBytes == unsharedSize);
+    }
+
+    void TestMemoryPlan()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph graph(device.Get());
+
+        // In a chain, each intermediate is live from its producer to the next node, so two buffers are enough
+        dml::Expression input = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 4, 8, 8 }));
+        dml::Expression a = dml::Exp(input);
+        dml::Expression b = dml::Abs(a);
+        dml::Expression c = dml::Exp(b);
+        dml::Expression d = dml::Abs(c);
+        const dml::Expression chain[] = { dml::Exp(d) };
+
+        const dml::MemoryPlan chainPlan = graph.PlanMemory(chain, 256);
+        CheckMemoryPlan(chainPlan);
+        CHECK(chainPlan.tensors.size() == 4);
+        CHECK(chainPlan.unsharedSizeInBytes == 4 * 1024);
+        CHECK(chainPlan.arenaSizeInBytes == 2 * 1024);
+        CHECK(chainPlan.Find(a) && chainPlan.Find(a)->firstNodeIndex == 0 && chainPlan.Find(a)->lastNodeIndex == 1);
+        CHECK(chainPlan.Find(dml::Reinterpret(b, { 1, 1, 16, 16 }, dml::NullOpt)) == chainPlan.Find(b));
+
+        // Graph inputs and the requested outputs are bound by the caller
+        CHECK(!chainPlan.Find(input));
+        CHECK(!chainPlan.Find(chain[0]));
+
+        // A tensor read later keeps its memory until then; sizes are rounded up to the alignment
+        dml::Expression small = dml::Abs(dml::InputTensor(graph, 1, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 25 })));
+        const dml::Expression branched[] = { dml::Exp(dml::Abs(dml::Exp(small))) + small };
+        const dml::MemoryPlan branchedPlan = graph.PlanMemory(branched, 256);
+        CheckMemoryPlan(branchedPlan);
+        CHECK(branchedPlan.Find(small) && branchedPlan.Find(small)->sizeInBytes == 256);
+        CHECK(branchedPlan.tensors.size() == 4);
+        CHECK(branchedPlan.arenaSizeInBytes == 3 * 256);
+
+        // A whole model shares far less memory than it would need unshared
+        dml::Graph modelGraph(device.Get());
+        Yolov4Model model(modelGraph, 64, 64);
+        const dml::Expression modelOutputs[] = { model.GetOutputs().smallBoxes, model.GetOutputs().mediumBoxes, model.GetOutputs().largeBoxes };
+        const dml::MemoryPlan modelPlan = modelGraph.PlanMemory(modelOutputs);
+        CheckMemoryPlan(modelPlan);
+        CHECK(modelPlan.alignment == DML_MINIMUM_BUFFER_TENSOR_ALIGNMENT);
+        CHECK(modelPlan.arenaSizeInBytes * 4 < modelPlan.unsharedSizeInBytes);
+
+#if __cpp_exceptions
+        bool threw = false;
+        try
+        {
+            graph.PlanMemory(chain, 0);
+        }
+        catch (const std::exception&)
+        {
+            threw = true;
+        }
+        CHECK(threw);
+#endif
+    }
+
+    // Joins the graphs compiled for a partition plan back into one, numbering nodes in dispatch order, so that it can be
+    // compared with the graph Compile builds. Edges through boundary tensors and graph outputs read back by a later
+    // partition become intermediate edges.
+    CompiledGraphRecord JoinPartitions(const dml::GraphPartitionPlan& plan, const CompiledGraphRecord* partitionGraphs)
+    {
+        CompiledGraphRecord joined;
+        std::vector<uint32_t> firstNodes;
+        std::map<std::pair<dml::GraphPartitionBindingType, uint32_t>, DML_OUTPUT_GRAPH_EDGE_DESC> producers;
+        for (size_t p = 0; p < plan.partitions.size(); ++p)
+        {
+            const dml::GraphPartition& partition = plan.partitions[p];
+            const CompiledGraphRecord& graph = partitionGraphs[p];
+            const uint32_t firstNode = static_cast<uint32_t>(joined.nodes.size());
+            firstNodes.push_back(firstNode);
+            joined.nodes.insert(joined.nodes.end(), graph.nodes.begin(), graph.nodes.end());
+            CHECK(graph.inputCount == partition.inputs.size() && graph.outputCount == partition.outputs.size());
+            CHECK(graph.nodes.size() == partition.nodeIndices.size());
+
+            for (DML_INTERMEDIATE_GRAPH_EDGE_DESC edge : graph.intermediateEdges)
+            {
+                edge.FromNodeIndex += firstNode;
+                edge.ToNodeIndex += firstNode;
+                joined.intermediateEdges.push_back(edge);
+            }
+
+            for (DML_INPUT_GRAPH_EDGE_DESC edge : graph.inputEdges)
+            {
+                const dml::GraphPartitionBinding binding = partition.inputs[edge.GraphInputIndex];
+                if (binding.type == dml::GraphPartitionBindingType::GraphInput)
+                {
+                    edge.GraphInputIndex = binding.index;
+                    edge.ToNodeIndex += firstNode;
+                    joined.inputEdges.push_back(edge);
+                    continue;
+                }
+
+                // Anything else must have been written by an earlier partition
+                auto producer = producers.find({ binding.type, binding.index });
+                CHECK(producer != producers.end());
+                if (producer != producers.end())
+                {
+                    DML_INTERMEDIATE_GRAPH_EDGE_DESC intermediateEdge = {};
+                    intermediateEdge.FromNodeIndex = producer->second.FromNodeIndex;
+                    intermediateEdge.FromNodeOutputIndex = producer->second.FromNodeOutputIndex;
+                    intermediateEdge.ToNodeIndex = edge.ToNodeIndex + firstNode;
+                    intermediateEdge.ToNodeInputIndex = edge.ToNodeInputIndex;
+                    joined.intermediateEdges.push_back(intermediateEdge);
+                }
+                if (binding.type == dml::GraphPartitionBindingType::BoundaryTensor)
+                {
+                    const dml::GraphBoundaryTensor& tensor = plan.boundaryTensors[binding.index];
+                    CHECK(tensor.producerPartition < p && p <= tensor.lastConsumerPartition);
+                }
+            }
+
+            for (DML_OUTPUT_GRAPH_EDGE_DESC edge : graph.outputEdges)
+            {
+                const dml::GraphPartitionBinding binding = partition.outputs[edge.GraphOutputIndex];
+                edge.FromNodeIndex += firstNode;
+                CHECK(producers.emplace(std::make_pair(binding.type, binding.index), edge).second);
+                if (binding.type == dml::GraphPartitionBindingType::GraphOutput)
+                {
+                    edge.GraphOutputIndex = binding.index;
+                    joined.outputEdges.push_back(edge);
+                    joined.outputCount = std::max(joined.outputCount, binding.index + 1);
+                }
+                else
+                {
+                    CHECK(plan.boundaryTensors[binding.index].producerPartition == p);
+                }
+            }
+        }
+        return joined;
+    }
+
+    // Whether two graphs have the same operator types and the same edges, in any order.
+    bool SameGraph(const CompiledGraphRecord& a, const CompiledGraphRecord& b)
+    {
+        auto edges = [](const CompiledGraphRecord& graph)
+        {
+            std::vector<std::tuple<int, uint32_t, uint32_t, uint32_t, uint32_t>> edges;
+            for (const auto& edge : graph.inputEdges)
+            {
+                edges.emplace_back(0, edge.GraphInputIndex, 0, edge.ToNodeIndex, edge.ToNodeInputIndex);
+            }
+            for (const auto& edge : graph.outputEdges)
+            {
+                edges.emplace_back(1, edge.FromNodeIndex, edge.FromNodeOutputIndex, edge.GraphOutputIndex, 0);
+            }
+            for (const auto& edge : graph.intermediateEdges)
+            {
+                edges.emplace_back(2, edge.FromNodeIndex, edge.FromNodeOutputIndex, edge.ToNodeIndex, edge.ToNodeInputIndex);
+            }
+            std::sort(edges.begin(), edges.end());
+            return edges;
+        };
+
+        bool same = a.nodes.size() == b.nodes.size() && a.outputCount == b.outputCount && edges(a) == edges(b);
+        for (size_t i = 0; same && i < a.nodes.size(); ++i)
+        {
+            same = a.GetNodeDesc(i).Type == b.GetNodeDesc(i).Type;
+        }
+        return same;
+    }
+
+    // Partitions the graph and returns the plan and the graphs compiled for it, joined into one.
+    dml::GraphPartitionPlan PartitionAndJoin(
+        dml::Graph& graph,
+        StubDevice* device,
+        dml::Span<const dml::Expression> outputs,
+        const dml::GraphPartitionOptions& options,
+        CompiledGraphRecord* joined)
+    {
+        const size_t firstGraph = device->GetCompiledGraphs().size();
+        dml::GraphPartitionPlan plan = graph.Partition(DML_EXECUTION_FLAG_NONE, outputs, options);
+        CHECK(device->GetCompiledGraphs().size() == firstGraph + plan.partitions.size());
+        *joined = JoinPartitions(plan, device->GetCompiledGraphs().data() + firstGraph);
+        return plan;
+    }
+
+    void TestPartition()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph graph(device.Get());
+        Yolov4Model model(graph, 64, 64);
+        const dml::Expression outputs[] = { model.GetOutputs().smallBoxes, model.GetOutputs().mediumBoxes, model.GetOutputs().largeBoxes };
+
+        graph.Compile(DML_EXECUTION_FLAG_NONE, outputs);
+        const CompiledGraphRecord whole = device->GetCompiledGraphs().back();
+        const uint32_t nodeCount = static_cast<uint32_t>(whole.nodes.size());
+
+        // With no limits the whole graph is one partition
+        CompiledGraphRecord joined;
+        dml::GraphPartitionPlan plan = PartitionAndJoin(graph, device.Get(), outputs, {}, &joined);
+        CHECK(plan.partitions.size() == 1 && plan.boundaryTensors.empty());
+        CHECK(SameGraph(joined, whole));
+
+        // A node limit cuts the graph into consecutive runs of that many nodes
+        dml::GraphPartitionOptions options;
+        options.maxNodeCount = 16;
+        plan = PartitionAndJoin(graph, device.Get(), outputs, options, &joined);
+        CHECK(plan.partitions.size() == (nodeCount + 15) / 16);
+        for (size_t i = 0; i + 1 < plan.partitions.size(); ++i)
+        {
+            CHECK(plan.partitions[i].nodeIndices.size() == 16);
+        }
+        CHECK(!plan.boundaryTensors.empty());
+        CHECK(SameGraph(joined, whole));
+
+        // A FLOP limit smaller than any operator gives each node a partition of its own, except for nodes estimated
+        // to do no arithmetic (e.g. a concatenation), which stay with the nodes before them while the limit allows
+        uint64_t totalFlopCount = 0;
+        options = {};
+        options.maxFlopCount = 1;
+        plan = PartitionAndJoin(graph, device.Get(), outputs, options, &joined);
+        CHECK(plan.partitions.size() > nodeCount / 2);
+        for (const dml::GraphPartition& partition : plan.partitions)
+        {
+            CHECK(partition.nodeIndices.size() == 1 || partition.estimatedFlopCount <= 1);
+            totalFlopCount += partition.estimatedFlopCount;
+        }
+        CHECK(SameGraph(joined, whole));
+
+        // Half the total puts the model in two or three partitions, none over the limit unless it's a single node
+        options.maxFlopCount = totalFlopCount / 2;
+        plan = PartitionAndJoin(graph, device.Get(), outputs, options, &joined);
+        CHECK(plan.partitions.size() >= 2 && plan.partitions.size() <= 3);
+        for (const dml::GraphPartition& partition : plan.partitions)
+        {
+            CHECK(partition.estimatedFlopCount <= options.maxFlopCount || partition.nodeIndices.size() == 1);
+        }
+        CHECK(SameGraph(joined, whole));
+
+        // A cut point ends a partition after its node. A graph output that a later partition reads is bound to it
+        // from the output buffer instead of a boundary tensor.
+        dml::Graph chainGraph(device.Get());
+        dml::Expression input = dml::InputTensor(chainGraph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 4, 8, 8 }));
+        dml::Expression a = dml::Exp(input);
+        dml::Expression b = dml::Abs(a);
+        const dml::Expression chain[] = { dml::Exp(b) + a, b };
+        chainGraph.Compile(DML_EXECUTION_FLAG_NONE, chain);
+        const CompiledGraphRecord wholeChain = device->GetCompiledGraphs().back();
+
+        options = {};
+        options.cutPoints = { b };
+        plan = PartitionAndJoin(chainGraph, device.Get(), chain, options, &joined);
+        CHECK(plan.partitions.size() == 2);
+        CHECK(plan.partitions[0].nodeIndices.size() == 2);
+        CHECK(plan.boundaryTensors.size() == 1);
+        if (plan.partitions.size() == 2 && plan.boundaryTensors.size() == 1)
+        {
+            CHECK(plan.boundaryTensors[0].producerPartition == 0 && plan.boundaryTensors[0].lastConsumerPartition == 1);
+            const std::vector<dml::GraphPartitionBinding>& inputs = plan.partitions[1].inputs;
+            CHECK(inputs.size() == 2);
+            CHECK(std::count_if(inputs.begin(), inputs.end(), [](const dml::GraphPartitionBinding& binding)
+            {
+                return binding.type == dml::GraphPartitionBindingType::GraphOutput && binding.index == 1;
+            }) == 1);
+        }
+        CHECK(SameGraph(joined, wholeChain));
+    }
+
+    void TestRebatch()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph source(device.Get());
+        source.SetOptimizations(dml::GraphOptimizations::None);
+
+        const std::vector<float> filterData = RandomFloats(4 * 3 * 3 * 3, 1);
+        const std::vector<float> biasData = RandomFloats(4, 2);
+        const std::vector<float> offsetData = RandomFloats(4, 3);
+        dml::Expression image = dml::InputTensor(source, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 3, 6, 6 }));
+        dml::Expression filter = FloatConstant(source, 1, { 4, 3, 3, 3 }, filterData);
+        dml::Expression bias = FloatConstant(source, 2, { 1, 4, 1, 1 }, biasData);
+        dml::Expression offset = FloatConstant(source, 3, { 1, 4, 1, 1 }, offsetData);
+
+        // The convolution reads the batch and the filter as it is; the addition broadcasts the shared offset to every
+        // item; the reshape folds the batch into its leading dimension
+        const uint32_t padding[] = { 1, 1 };
+        dml::Expression relu = dml::ActivationRelu(dml::ConvolutionBuilder(image, filter, bias).StartPadding(padding).EndPadding(padding).Build());
+        const dml::Expression sourceOutputs[] =
+        {
+            dml::Exp(relu) + offset,
+            dml::Abs(dml::Reinterpret(relu, { 1, 1, 4, 36 }, dml::NullOpt)),
+        };
+
+        const uint32_t batchSize = 3;
+        dml::Graph batched(device.Get());
+        batched.SetOptimizations(dml::GraphOptimizations::None);
+        std::vector<dml::Expression> outputs;
+        const std::vector<dml::GraphDiagnostic> diagnostics = batched.Rebatch(source, sourceOutputs, batchSize, outputs);
+        CHECK(diagnostics.empty());
+        CHECK(outputs.size() == 2);
+        if (outputs.size() != 2)
+        {
+            return;
+        }
+
+        CHECK(outputs[0].GetOutputDesc().sizes == dml::TensorDimensions({ 3, 4, 6, 6 }));
+        CHECK(outputs[1].GetOutputDesc().sizes == dml::TensorDimensions({ 3, 1, 4, 36 }));
+        CHECK(batched.GetConstantInputData(1).size() == filterData.size() * sizeof(float));
+
+        // Each item of the batch gives the same results as the source graph run on that item alone
+        const std::vector<float> batchData = RandomFloats(batchSize * 3 * 6 * 6, 4);
+        for (uint32_t o = 0; o < 2; ++o)
+        {
+            const std::vector<float> batchedResult = ExecuteFloat(batched, outputs[o], { &batchData });
+            CHECK(batchedResult.size() == batchSize * 4 * 36);
+            for (uint32_t item = 0; item < batchSize && batchedResult.size() == batchSize * 4 * 36; ++item)
+            {
+                const std::vector<float> itemData(batchData.begin() + item * 108, batchData.begin() + (item + 1) * 108);
+                const std::vector<float> itemResult(batchedResult.begin() + item * 144, batchedResult.begin() + (item + 1) * 144);
+                CHECK(MaxAbsoluteDifference(itemResult, ExecuteFloat(source, sourceOutputs[o], { &itemData })) < 1e-5);
+            }
+        }
+
+        // A reduction across the leading dimension mixes the items, so it's reported against its node and nothing is
+        // built
+        const uint32_t leadingAxis[] = { 0 };
+        const dml::Expression reduced[] = { dml::Reduce(relu, DML_REDUCE_FUNCTION_SUM, leadingAxis) };
+        dml::Graph failed(device.Get());
+        std::vector<dml::Expression> failedOutputs;
+        const std::vector<dml::GraphDiagnostic> reduceDiagnostics = failed.Rebatch(source, reduced, batchSize, failedOutputs);
+        CHECK(reduceDiagnostics.size() == 1);
+        if (reduceDiagnostics.size() == 1)
+        {
+            CHECK(reduceDiagnostics[0].operatorType == DML_OPERATOR_REDUCE);
+            CHECK(reduceDiagnostics[0].message.find("leading dimension") != std::string::npos);
+        }
+        CHECK(failedOutputs.empty());
+
+        // Batched inputs that don't exist or don't have a leading dimension of 1 are reported
+        const uint32_t badInputs[] = { 0, 1, 7 };
+        const std::vector<dml::GraphDiagnostic> inputDiagnostics = failed.Rebatch(source, sourceOutputs, batchSize, failedOutputs, badInputs);
+        CHECK(inputDiagnostics.size() == 2);
+        for (const dml::GraphDiagnostic& diagnostic : inputDiagnostics)
+        {
+            CHECK(diagnostic.nodeIndex == UINT32_MAX);
+        }
+
+#if __cpp_exceptions
+        // The destination must be empty
+        bool threw = false;
+        try
+        {
+            batched.Rebatch(source, sourceOutputs, batchSize, outputs);
+        }
+        catch (const std::exception&)
+        {
+            threw = true;
+        }
+        CHECK(threw);
+#endif
+    }
+
+#ifdef _WIN32
+    #define TEST_PATH(_path) L##_path
+#else
+    #define TEST_PATH(_path) _path
+#endif
+
+    void TestSaveLoad()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph graph(device.Get());
+        dml::Expression input = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 2, 3, 4 }));
+        dml::Expression weights = FloatConstant(graph, 1, { 1, 2, 3, 4 }, RandomFloats(24, 1));
+        const dml::Expression outputs[] = { dml::Exp(input) * weights };
+
+        // Constant data is copied out of the mapped file, so the graph outlives it
+        const dml::PathChar* path = TEST_PATH("GraphTests.graph.bin");
+        graph.Save(path, outputs);
+        dml::Graph loaded(device.Get());
+        const std::vector<dml::Expression> loadedOutputs = loaded.Load(path);
+#ifdef _WIN32
+        _wremove(path);
+#else
+        std::remove(path);
+#endif
+        CHECK(loadedOutputs.size() == 1);
+        if (loadedOutputs.size() == 1)
+        {
+            const std::vector<float> inputData = RandomFloats(24, 2);
+            CHECK(ExecuteFloat(loaded, loadedOutputs[0], { &inputData }) == ExecuteFloat(graph, outputs[0], { &inputData }));
+        }
+
+#ifndef _WIN32
+        // File errors carry errno: as an HRESULT in the form HRESULT_FROM_WIN32 gives Windows errors, or in the
+        // std::system_error thrown without WIL
+        const uint8_t byte = 0;
+        CHECK(dml::detail::TryWriteBinaryFile("missing-directory/graph.bin", dml::Span<const uint8_t>(&byte, 1)) ==
+            static_cast<HRESULT>(0x80070000u | ENOENT));
+#if __cpp_exceptions && !DMLX_USE_WIL
+        int error = 0;
+        try
+        {
+            dml::Graph missing(device.Get());
+            missing.Load("missing-directory/graph.bin");
+        }
+        catch (const std::system_error& e)
+        {
+            error = e.code().value();
+        }
+        CHECK(error == ENOENT);
+#endif
+#endif
+    }
+
+    // Validate checks the parameters of the normalization operators against the channels and axes of their input
+    void TestValidateParameters()
+    {
+        auto device = MakeStub<StubDevice>();
+        dml::Graph graph(device.Get());
+        auto input = [&](uint32_t index, dml::TensorDimensions sizes)
+        {
+            return dml::InputTensor(graph, index, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, std::move(sizes)));
+        };
+
+        // The single diagnostic of an operator, or an empty message if there isn't exactly one
+        auto diagnose = [&](const dml::Expression& expression)
+        {
+            const dml::Expression outputs[] = { expression };
+            const std::vector<dml::GraphDiagnostic> diagnostics = graph.Validate(outputs);
+            return diagnostics.size() == 1 ? diagnostics[0].message : std::string();
+        };
+        auto isValid = [&](const dml::Expression& expression)
+        {
+            const dml::Expression outputs[] = { expression };
+            return graph.Validate(outputs).empty();
+        };
+
+        // Spatial batch normalization takes parameters per channel; otherwise they may vary per element, but never
+        // across the batch
+        dml::Expression x = input(0, { 2, 4, 3, 3 });
+        dml::Expression channels = input(1, { 1, 4, 1, 1 });
+        dml::Expression elements = input(2, { 1, 4, 3, 3 });
+        dml::Expression batch = input(3, { 2, 4, 1, 1 });
+        CHECK(isValid(dml::BatchNormalization(x, channels, channels, channels, channels, true, 1e-5f)));
+        CHECK(isValid(dml::BatchNormalization(x, elements, channels, elements, channels, false, 1e-5f)));
+        CHECK(diagnose(dml::BatchNormalization(x, channels, elements, channels, channels, true, 1e-5f)).find("variance") == 0);
+        CHECK(diagnose(dml::BatchNormalization(x, channels, channels, batch, channels, false, 1e-5f)).find("scale") == 0);
+        CHECK(diagnose(dml::BatchNormalization(x, channels, channels, channels, input(4, { 4 }), true, 1e-5f)).find("bias") == 0);
+
+        // Mean-variance normalization scales per channel or along the normalized axes, and its axes must be in range
+        const uint32_t spatialAxes[] = { 2, 3 };
+        const uint32_t badAxes[] = { 1, 4 };
+        const uint32_t repeatedAxes[] = { 2, 2 };
+        CHECK(isValid(dml::MeanVarianceNormalization(x, channels, channels, spatialAxes, true, 1e-5f)));
+        CHECK(isValid(dml::MeanVarianceNormalization(x, input(5, { 1, 1, 3, 3 }), dml::NullOpt, spatialAxes, true, 1e-5f)));
+        CHECK(diagnose(dml::MeanVarianceNormalization(x, dml::NullOpt, input(6, { 1, 2, 1, 1 }), spatialAxes, true, 1e-5f)).find("bias") == 0);
+        CHECK(diagnose(dml::MeanVarianceNormalization(x, dml::NullOpt, dml::NullOpt, badAxes, true, 1e-5f)).find("axis 4") == 0);
+        CHECK(diagnose(dml::MeanVarianceNormalization(x, dml::NullOpt, dml::NullOpt, repeatedAxes, true, 1e-5f)).find("axis 2") == 0);
+
+        // Local response normalization needs a 4D input and a window
+        CHECK(isValid(dml::LocalResponseNormalization(x, true, 3, 1e-4f, 0.75f, 1.0f)));
+        CHECK(diagnose(dml::LocalResponseNormalization(input(7, { 4, 3, 3 }), true, 3, 1e-4f, 0.75f, 1.0f)).find("input") == 0);
+        CHECK(diagnose(dml::LocalResponseNormalization(x, false, 0, 1e-4f, 0.75f, 1.0f)).find("LocalSize") == 0);
+
+        // Value scale takes a bias per channel
+        const float bias[] = { 1, 2, 3, 4 };
+        CHECK(isValid(dml::ValueScale2D(x, 2.0f, bias)));
+        CHECK(diagnose(dml::ValueScale2D(x, 2.0f, dml::Span<const float>(bias, 3))).find("ChannelCount 3") == 0);
+    }
+    // With common subexpression elimination, an expression created again under another scope resolves to the first
+    // node, which keeps the first scope's name until it is renamed
+    void TestCommonSubexpressionNames()
+    {
+        auto device = MakeStub<StubDevice>();
+        auto getExpNames = [](const dml::Graph& graph, const dml::Expression& output)
+        {
+            const dml::Expression outputs[] = { output };
+            std::vector<std::string> names;
+            for (const dml::OperatorCost& cost : graph.EstimateCost(outputs).operators)
+            {
+                if (cost.operatorType == DML_OPERATOR_ELEMENT_WISE_EXP)
+                {
+                    names.push_back(cost.name);
+                }
+            }
+            return names;
+        };
+
+        for (bool merge : { false, true })
+        {
+            dml::Graph graph(device.Get());
+            graph.SetCommonSubexpressionElimination(merge);
+            dml::Expression x = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 2, 3, 4 }));
+
+            dml::Expression first;
+            dml::Expression second;
+            {
+                dml::Scope scope(graph, "first");
+                first = dml::Exp(x);
+            }
+            {
+                dml::Scope scope(graph, "second");
+                second = dml::Exp(x);
+            }
+
+            const dml::Expression sum = first + second;
+            CHECK(graph.GetStatistics().mergedNodeCount == (merge ? 1u : 0u));
+            if (merge)
+            {
+                CHECK(getExpNames(graph, sum) == std::vector<std::string>({ "first" }));
+                dml::Name(second, "renamed");
+                CHECK(getExpNames(graph, sum) == std::vector<std::string>({ "renamed" }));
+            }
+            else
+            {
+                CHECK(getExpNames(graph, sum) == std::vector<std::string>({ "first", "second" }));
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestAnalysisDoesNotChangeCompiledState();
+    TestBatchNormalizationFoldingMatchesUnfolded();
+    TestOperatorsReusedAcrossCompiles();
+    TestMemoryPlan();
+    TestPartition();
+    TestRebatch();
+    TestSaveLoad();
+    TestValidateParameters();
+    TestCommonSubexpressionNames();
+    return Finish();
+}
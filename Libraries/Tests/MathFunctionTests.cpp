@@ -0,0 +1,203 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+// Checks the error bounds documented on dml::cpu::MathFunction. dml::cpu::Evaluate is run on a sweep of FLOAT32
+// inputs and each result is compared with the function computed in double precision, in units in the last place
+// (ulp) of the exact result. The sweep takes every 251st bit pattern, every pattern within 2^16 ulps of the points
+// where the approximations change branches or the results become denormal or overflow, and the special values;
+// pass --all to sweep every FLOAT32 value instead, which takes a few minutes.
+//
+// CMakeLists.txt builds this test once for each path of the approximations, like CpuKernelTests: the scalar
+// functions, and on x86 the __m256 ones, which Evaluate uses for all but the last few elements of an array.
+
+#include "TestHelpers.h"
+
+#include <cfloat>
+#include <cstring>
+
+using namespace dmlx_test;
+using dml::cpu::MathFunction;
+
+namespace
+{
+    double SoftplusReference(double x)
+    {
+        return std::max(x, 0.0) + std::log1p(std::exp(-std::abs(x)));
+    }
+
+    struct FunctionCase
+    {
+        const char* name;
+        MathFunction function;
+        double (*reference)(double);
+        double documentedUlps; // From the table on dml::cpu::MathFunction
+        float branchPoints[6];
+    };
+
+    const FunctionCase c_functions[] =
+    {
+        { "Exp", MathFunction::Exp, [](double x) { return std::exp(x); }, 1.1, { -104.0f, -103.28f, -87.34f, 0.0f, 88.73f, 89.0f } },
+        { "Tanh", MathFunction::Tanh, [](double x) { return std::tanh(x); }, 1.4, { 0.0f, 0.625f, -0.625f, 9.0f, -9.0f, 1e-20f } },
+        {
+            "Sigmoid", MathFunction::Sigmoid,
+            [](double x) { return x >= 0 ? 1 / (1 + std::exp(-x)) : std::exp(x) / (1 + std::exp(x)); },
+            2.5, { 0.0f, -87.34f, -103.28f, -104.0f, 17.0f, 1e-20f }
+        },
+        { "Softplus", MathFunction::Softplus, SoftplusReference, 2.0, { 0.0f, -87.34f, -103.28f, -104.0f, 17.0f, 88.73f } },
+        { "Erf", MathFunction::Erf, [](double x) { return std::erf(x); }, 2.4, { 0.0f, 1.0f, -1.0f, 2.5f, 4.0f, -4.0f } },
+        {
+            "Mish", MathFunction::Mish,
+            [](double x) { return std::isinf(x) && x < 0 ? -0.0 : x * std::tanh(SoftplusReference(x)); },
+            4.8, { 0.0f, -80.0f, -104.0f, -206.0f, 20.0f, 1e-20f }
+        },
+    };
+
+    // The spacing of FLOAT32 values at the magnitude of y, where y is finite and within FLOAT32 range.
+    double FloatUlp(double y)
+    {
+        y = std::abs(y);
+        if (y < FLT_MIN)
+        {
+            return std::ldexp(1.0, -149);
+        }
+        int exponent;
+        std::frexp(y, &exponent);
+        return std::ldexp(1.0, exponent - 24);
+    }
+
+    // The error of an approximation of f(x) in ulps: 0 for matching NaNs and infinities, and infinite if only one of
+    // them is NaN or infinite.
+    double UlpError(float actual, double expected)
+    {
+        if (std::isnan(expected) || std::isnan(actual))
+        {
+            return std::isnan(expected) && std::isnan(actual) ? 0.0 : INFINITY;
+        }
+
+        // Results beyond FLT_MAX must round to infinity
+        const float rounded = static_cast<float>(expected);
+        if (std::isinf(rounded) || std::isinf(actual))
+        {
+            return actual == rounded ? 0.0 : INFINITY;
+        }
+        return std::abs(actual - expected) / FloatUlp(expected);
+    }
+
+    float FromBits(uint32_t bits)
+    {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    uint32_t ToBits(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    struct Measurement
+    {
+        double maxUlps = 0;
+        float worstInput = 0;
+
+        void Add(const Measurement& other)
+        {
+            if (other.maxUlps > maxUlps)
+            {
+                *this = other;
+            }
+        }
+    };
+
+    Measurement Measure(const FunctionCase& function, const std::vector<float>& inputs)
+    {
+        std::vector<float> outputs(inputs.size());
+        dml::cpu::Evaluate(function.function, DML_TENSOR_DATA_TYPE_FLOAT32, inputs.data(), outputs.data(), inputs.size());
+
+        Measurement measurement;
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            const double error = UlpError(outputs[i], function.reference(inputs[i]));
+            if (!(error <= measurement.maxUlps))
+            {
+                measurement.maxUlps = error;
+                measurement.worstInput = inputs[i];
+            }
+        }
+        return measurement;
+    }
+
+    // Every bit pattern that is a multiple of stride, in chunks spread over the pool.
+    Measurement MeasureSweep(const FunctionCase& function, uint32_t stride, dml::cpu::ThreadPool& threadPool)
+    {
+        const uint64_t patternCount = ((1ull << 32) + stride - 1) / stride;
+        const uint64_t chunkSize = 1 << 16;
+        const uint64_t chunkCount = (patternCount + chunkSize - 1) / chunkSize;
+
+        std::vector<Measurement> chunks(static_cast<size_t>(chunkCount));
+        threadPool.ParallelFor(chunkCount, [&](uint64_t chunk)
+        {
+            const uint64_t end = std::min(patternCount, (chunk + 1) * chunkSize);
+            std::vector<float> inputs;
+            inputs.reserve(static_cast<size_t>(chunkSize));
+            for (uint64_t i = chunk * chunkSize; i < end; ++i)
+            {
+                inputs.push_back(FromBits(static_cast<uint32_t>(i * stride)));
+            }
+            chunks[static_cast<size_t>(chunk)] = Measure(function, inputs);
+        });
+
+        Measurement measurement;
+        for (const Measurement& chunk : chunks)
+        {
+            measurement.Add(chunk);
+        }
+        return measurement;
+    }
+
+    // Every value within 2^16 ulps of the function's branch points, and the special values.
+    Measurement MeasureBranchPoints(const FunctionCase& function)
+    {
+        std::vector<float> inputs =
+        {
+            0.0f, -0.0f, INFINITY, -INFINITY, NAN, FLT_MIN, -FLT_MIN, FLT_MAX, -FLT_MAX,
+            FromBits(1), FromBits(0x80000001), FromBits(0x007FFFFF), FromBits(0x807FFFFF),
+        };
+        for (float point : function.branchPoints)
+        {
+            for (float value : { point, -point })
+            {
+                const uint32_t bits = ToBits(value);
+                for (uint32_t i = 0; i <= (1u << 17); ++i)
+                {
+                    // Crossing zero from a tiny value wraps into the opposite sign's patterns, which are tested too
+                    inputs.push_back(FromBits(bits - (1u << 16) + i));
+                }
+            }
+        }
+        return Measure(function, inputs);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const bool all = argc > 1 && std::strcmp(argv[1], "--all") == 0;
+    if (!CheckKernelPath())
+    {
+        return 0;
+    }
+
+    dml::cpu::ThreadPool threadPool;
+    std::printf("%-10s %12s %12s %16s\n", "function", "max (ulp)", "bound (ulp)", "worst input");
+    for (const FunctionCase& function : c_functions)
+    {
+        Measurement measurement = MeasureSweep(function, all ? 1 : 251, threadPool);
+        measurement.Add(MeasureBranchPoints(function));
+
+        std::printf("%-10s %12.3f %12.1f %16.9g\n", function.name, measurement.maxUlps, function.documentedUlps, measurement.worstInput);
+        CHECK(measurement.maxUlps <= function.documentedUlps);
+    }
+
+    return Finish();
+}
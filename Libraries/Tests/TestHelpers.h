@@ -0,0 +1,392 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+// Shared by the DirectMLX tests and benchmarks: a CHECK macro that counts failures instead of stopping, and stub
+// DirectML objects that let graphs be built and compiled without a device. The stub device records the operators it
+// creates and the graphs it compiles, so tests can inspect what Graph::Compile passed to DirectML.
+
+#pragma once
+
+#include <wrl/client.h>
+#include "DirectMLXCpu.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+namespace dmlx_test
+{
+    inline int& FailureCount()
+    {
+        static int failureCount = 0;
+        return failureCount;
+    }
+
+    #define CHECK(_condition) \
+        if (!(_condition)) { std::printf("%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #_condition); ++dmlx_test::FailureCount(); }
+
+    // Prints a summary and returns the process exit code.
+    inline int Finish()
+    {
+        if (FailureCount() > 0)
+        {
+            std::printf("%d checks failed\n", FailureCount());
+            return 1;
+        }
+
+        std::printf("All checks passed\n");
+        return 0;
+    }
+
+    // Reference counting and IDMLObject for the stubs below, which are allocated with new.
+    template <typename TInterface>
+    class StubObject : public TInterface
+    {
+    public:
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+        {
+            if (riid == __uuidof(IUnknown) || riid == __uuidof(IDMLObject) || riid == __uuidof(TInterface))
+            {
+                AddRef();
+                *object = static_cast<TInterface*>(this);
+                return S_OK;
+            }
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        ULONG STDMETHODCALLTYPE AddRef() override { return ++m_refCount; }
+
+        ULONG STDMETHODCALLTYPE Release() override
+        {
+            const ULONG refCount = --m_refCount;
+            if (refCount == 0)
+            {
+                delete this;
+            }
+            return refCount;
+        }
+
+        // IDMLObject
+        HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID, UINT*, void*) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID, UINT, const void*) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID, IUnknown*) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE SetName(PCWSTR) override { return E_NOTIMPL; }
+
+    protected:
+        virtual ~StubObject() = default;
+
+    private:
+        std::atomic<ULONG> m_refCount = 1;
+    };
+
+    template <typename T>
+    Microsoft::WRL::ComPtr<T> MakeStub()
+    {
+        Microsoft::WRL::ComPtr<T> stub;
+        stub.Attach(new T());
+        return stub;
+    }
+
+    // Keeps a copy of the desc it was created from.
+    class StubOperator : public StubObject<IDMLOperator>
+    {
+    public:
+        explicit StubOperator(const DML_OPERATOR_DESC& desc)
+            : m_desc(desc.Type, desc.Desc)
+        {}
+
+        HRESULT STDMETHODCALLTYPE GetDevice(REFIID, void**) override { return E_NOTIMPL; }
+
+        const DML_OPERATOR_DESC& GetDesc() const { return *m_desc.Get(); }
+
+    private:
+        dml::detail::OwnedOperatorDesc m_desc;
+    };
+
+    class StubCompiledOperator : public StubObject<IDMLCompiledOperator>
+    {
+    public:
+        HRESULT STDMETHODCALLTYPE GetDevice(REFIID, void**) override { return E_NOTIMPL; }
+        DML_BINDING_PROPERTIES STDMETHODCALLTYPE GetBindingProperties() override { return {}; }
+    };
+
+    // A copy of a DML_GRAPH_DESC passed to IDMLDevice1::CompileGraph.
+    struct CompiledGraphRecord
+    {
+        uint32_t inputCount = 0;
+        uint32_t outputCount = 0;
+        std::vector<Microsoft::WRL::ComPtr<StubOperator>> nodes;
+        std::vector<DML_INPUT_GRAPH_EDGE_DESC> inputEdges;
+        std::vector<DML_OUTPUT_GRAPH_EDGE_DESC> outputEdges;
+        std::vector<DML_INTERMEDIATE_GRAPH_EDGE_DESC> intermediateEdges;
+
+        const DML_OPERATOR_DESC& GetNodeDesc(size_t nodeIndex) const { return nodes[nodeIndex]->GetDesc(); }
+
+        // The number of nodes of an operator type.
+        size_t CountNodes(DML_OPERATOR_TYPE type) const
+        {
+            size_t count = 0;
+            for (const auto& node : nodes)
+            {
+                count += node->GetDesc().Type == type ? 1 : 0;
+            }
+            return count;
+        }
+    };
+
+    class StubDevice : public StubObject<IDMLDevice1>
+    {
+    public:
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+        {
+            if (riid == __uuidof(IDMLDevice))
+            {
+                AddRef();
+                *object = static_cast<IDMLDevice*>(this);
+                return S_OK;
+            }
+            return StubObject<IDMLDevice1>::QueryInterface(riid, object);
+        }
+
+        HRESULT STDMETHODCALLTYPE CheckFeatureSupport(DML_FEATURE, UINT, const void*, UINT, void*) override { return E_NOTIMPL; }
+
+        HRESULT STDMETHODCALLTYPE CreateOperator(const DML_OPERATOR_DESC* desc, REFIID riid, void** object) override
+        {
+            if (riid != __uuidof(IDMLOperator))
+            {
+                return E_NOINTERFACE;
+            }
+
+            ++m_createOperatorCount;
+            *object = static_cast<IDMLOperator*>(new StubOperator(*desc));
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE CompileOperator(IDMLOperator*, DML_EXECUTION_FLAGS, REFIID, void**) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE CreateOperatorInitializer(UINT, IDMLCompiledOperator* const*, REFIID, void**) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE CreateCommandRecorder(REFIID, void**) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE CreateBindingTable(const DML_BINDING_TABLE_DESC*, REFIID, void**) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE Evict(UINT, IDMLPageable* const*) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE MakeResident(UINT, IDMLPageable* const*) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE GetDeviceRemovedReason() override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE GetParentDevice(REFIID, void**) override { return E_NOTIMPL; }
+
+        HRESULT STDMETHODCALLTYPE CompileGraph(const DML_GRAPH_DESC* desc, DML_EXECUTION_FLAGS, REFIID riid, void** object) override
+        {
+            if (riid != __uuidof(IDMLCompiledOperator))
+            {
+                return E_NOINTERFACE;
+            }
+
+            CompiledGraphRecord record;
+            record.inputCount = desc->InputCount;
+            record.outputCount = desc->OutputCount;
+            for (UINT i = 0; i < desc->NodeCount; ++i)
+            {
+                const auto& node = *static_cast<const DML_OPERATOR_GRAPH_NODE_DESC*>(desc->Nodes[i].Desc);
+                record.nodes.push_back(static_cast<StubOperator*>(node.Operator));
+            }
+            for (UINT i = 0; i < desc->InputEdgeCount; ++i)
+            {
+                record.inputEdges.push_back(*static_cast<const DML_INPUT_GRAPH_EDGE_DESC*>(desc->InputEdges[i].Desc));
+            }
+            for (UINT i = 0; i < desc->OutputEdgeCount; ++i)
+            {
+                record.outputEdges.push_back(*static_cast<const DML_OUTPUT_GRAPH_EDGE_DESC*>(desc->OutputEdges[i].Desc));
+            }
+            for (UINT i = 0; i < desc->IntermediateEdgeCount; ++i)
+            {
+                record.intermediateEdges.push_back(*static_cast<const DML_INTERMEDIATE_GRAPH_EDGE_DESC*>(desc->IntermediateEdges[i].Desc));
+            }
+            m_compiledGraphs.push_back(std::move(record));
+
+            *object = static_cast<IDMLCompiledOperator*>(new StubCompiledOperator());
+            return S_OK;
+        }
+
+        uint32_t GetCreateOperatorCount() const { return m_createOperatorCount; }
+
+        // Every graph compiled on this device, in order.
+        const std::vector<CompiledGraphRecord>& GetCompiledGraphs() const { return m_compiledGraphs; }
+
+    private:
+        uint32_t m_createOperatorCount = 0;
+        std::vector<CompiledGraphRecord> m_compiledGraphs;
+    };
+
+    // Host data for a FLOAT32 tensor, filled with uniformly distributed values.
+    inline std::vector<float> RandomFloats(size_t count, uint32_t seed, float low = -1.0f, float high = 1.0f)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<float> distribution(low, high);
+        std::vector<float> values(count);
+        for (float& value : values)
+        {
+            value = distribution(generator);
+        }
+        return values;
+    }
+
+    // A FLOAT32 constant input (see dml::ConstantInputTensor).
+    inline dml::Expression FloatConstant(
+        dml::Graph& graph,
+        uint32_t inputIndex,
+        dml::TensorDimensions sizes,
+        const std::vector<float>& values)
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values.data());
+        return dml::ConstantInputTensor(
+            graph,
+            inputIndex,
+            dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, std::move(sizes)),
+            dml::Span<const uint8_t>(bytes, values.size() * sizeof(float)));
+    }
+
+    // Returns the largest absolute difference between two arrays of the same size.
+    inline double MaxAbsoluteDifference(const std::vector<float>& a, const std::vector<float>& b)
+    {
+        double difference = a.size() == b.size() ? 0.0 : INFINITY;
+        for (size_t i = 0; i < a.size() && i < b.size(); ++i)
+        {
+            difference = std::max(difference, std::abs(static_cast<double>(a[i]) - b[i]));
+        }
+        return difference;
+    }
+
+    // Runs a graph on the CPU executor with FLOAT32 inputs, and returns its first output. Constant inputs are bound
+    // from the graph's own data.
+    inline std::vector<float> ExecuteFloat(
+        const dml::Graph& graph,
+        dml::Expression output,
+        const std::vector<const std::vector<float>*>& inputs)
+    {
+        const dml::Expression outputs[] = { output };
+        dml::cpu::ExecutorOptions options;
+        options.threadCount = 2;
+        dml::cpu::Executor executor(graph, outputs, options);
+
+        std::vector<const void*> inputData(executor.GetInputCount(), nullptr);
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            inputData[i] = inputs[i] ? inputs[i]->data() : nullptr;
+        }
+
+        const dml::TensorDesc outputDesc = executor.GetOutputDesc(0);
+        std::vector<float> result(static_cast<size_t>(outputDesc.totalTensorSizeInBytes / sizeof(float)));
+        void* outputData[] = { result.data() };
+        executor.Execute(inputData, outputData);
+        return result;
+    }
+
+    // A FLOAT32 buffer tensor and its DML_TENSOR_DESC, for calling the CPU kernels (dml::cpu::Convolution and so on)
+    // directly. Strides may be empty for a packed tensor. The desc points into the object, so it can't be copied.
+    class FloatTensor
+    {
+    public:
+        FloatTensor(std::vector<uint32_t> sizes, std::vector<uint32_t> strides = {}, uint32_t seed = 0)
+            : m_sizes(std::move(sizes))
+            , m_strides(std::move(strides))
+        {
+            // One past the furthest element the sizes and strides reach
+            uint64_t elementCount = 1;
+            for (size_t i = 0; i < m_sizes.size(); ++i)
+            {
+                elementCount = m_strides.empty()
+                    ? elementCount * m_sizes[i]
+                    : elementCount + uint64_t(m_sizes[i] - 1) * m_strides[i];
+            }
+            m_data = RandomFloats(static_cast<size_t>(elementCount), seed);
+
+            m_bufferDesc.DataType = DML_TENSOR_DATA_TYPE_FLOAT32;
+            m_bufferDesc.Flags = DML_TENSOR_FLAG_NONE;
+            m_bufferDesc.DimensionCount = static_cast<uint32_t>(m_sizes.size());
+            m_bufferDesc.Sizes = m_sizes.data();
+            m_bufferDesc.Strides = m_strides.empty() ? nullptr : m_strides.data();
+            m_bufferDesc.TotalTensorSizeInBytes = (elementCount * sizeof(float) + 3) & ~3ull;
+            m_bufferDesc.GuaranteedBaseOffsetAlignment = 0;
+            m_desc = DML_TENSOR_DESC{ DML_TENSOR_TYPE_BUFFER, &m_bufferDesc };
+        }
+
+        FloatTensor(const FloatTensor&) = delete;
+        FloatTensor& operator=(const FloatTensor&) = delete;
+
+        const DML_TENSOR_DESC* GetDesc() const { return &m_desc; }
+        const std::vector<uint32_t>& GetSizes() const { return m_sizes; }
+        std::vector<float>& GetData() { return m_data; }
+        const std::vector<float>& GetData() const { return m_data; }
+
+        // A view of the data for the kernels in dml::cpu::detail.
+        dml::cpu::detail::TensorView GetView()
+        {
+            return dml::cpu::detail::MakeTensorView(&m_desc, reinterpret_cast<uint8_t*>(m_data.data()));
+        }
+
+    private:
+        std::vector<uint32_t> m_sizes;
+        std::vector<uint32_t> m_strides;
+        std::vector<float> m_data;
+        DML_BUFFER_TENSOR_DESC m_bufferDesc = {};
+        DML_TENSOR_DESC m_desc = {};
+    };
+
+    // Whether this processor and OS support the AVX2 and FMA instructions that DirectMLXCpu.h uses when DMLX_USE_AVX2
+    // is set. Kernel tests compiled for AVX2 skip themselves when it returns false.
+    inline bool IsAvx2Supported()
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int info[4];
+        __cpuid(info, 1);
+        const bool fma = (info[2] & (1 << 12)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!fma || !osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+        return false;
+#endif
+    }
+
+    // Prints which path of DirectMLXCpu.h this binary was compiled with. Returns false, after printing why, if the
+    // binary was compiled for instructions this processor doesn't have.
+    inline bool CheckKernelPath()
+    {
+#if DMLX_USE_AVX2
+        if (!IsAvx2Supported())
+        {
+            std::printf("Compiled for AVX2 and FMA, which this processor doesn't support; skipping\n");
+            return false;
+        }
+        std::printf("Kernels: AVX2/FMA\n");
+#else
+        std::printf("Kernels: portable\n");
+#endif
+        return true;
+    }
+
+    // Wall-clock timing for the benchmarks.
+    class Stopwatch
+    {
+    public:
+        Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+
+        double GetElapsedSeconds() const
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point m_start;
+    };
+}
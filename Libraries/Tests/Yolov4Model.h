@@ -0,0 +1,243 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+// The yolov4 graph built by Samples/yolov4 (see yolov4ResourceBuilder.cpp), for the benchmarks. Weights are plain
+// graph inputs without data, as in the sample, so the graph can be built and compiled but not executed. The shape of
+// every convolution is recorded as the graph is built.
+
+#pragma once
+
+#include "TestHelpers.h"
+
+namespace dmlx_test
+{
+    struct ConvolutionLayer
+    {
+        dml::TensorDimensions inputSizes;
+        dml::TensorDimensions filterSizes;
+        uint32_t stride = 1;
+        uint32_t padding = 0;
+    };
+
+    class Yolov4Model
+    {
+    public:
+        struct Outputs
+        {
+            dml::Expression smallBoxes;
+            dml::Expression mediumBoxes;
+            dml::Expression largeBoxes;
+        };
+
+        // Builds the model and its output decoding on an input of {1, 3, height, width}.
+        Yolov4Model(dml::Graph& graph, uint32_t height, uint32_t width, uint32_t classCount = 80)
+            : m_graph(graph)
+        {
+            dml::Expression input = dml::InputTensor(graph, 0, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, 3, height, width }));
+            m_inputCount = 1;
+
+            auto [route1, route2, conv] = CspDarknet53(input);
+
+            auto route = conv;
+            conv = Convolutional(conv, { 256, 512, 1, 1 });
+            conv = Upsample(conv);
+            route2 = Convolutional(route2, { 256, 512, 1, 1 });
+            conv = Join(route2, conv);
+
+            conv = Convolutional(conv, { 256, 512, 1, 1 });
+            conv = Convolutional(conv, { 512, 256, 3, 3 });
+            conv = Convolutional(conv, { 256, 512, 1, 1 });
+            conv = Convolutional(conv, { 512, 256, 3, 3 });
+            conv = Convolutional(conv, { 256, 512, 1, 1 });
+
+            route2 = conv;
+            conv = Convolutional(conv, { 128, 256, 1, 1 });
+            conv = Upsample(conv);
+            route1 = Convolutional(route1, { 128, 256, 1, 1 });
+            conv = Join(route1, conv);
+
+            conv = Convolutional(conv, { 128, 256, 1, 1 });
+            conv = Convolutional(conv, { 256, 128, 3, 3 });
+            conv = Convolutional(conv, { 128, 256, 1, 1 });
+            conv = Convolutional(conv, { 256, 128, 3, 3 });
+            conv = Convolutional(conv, { 128, 256, 1, 1 });
+
+            route1 = conv;
+            conv = Convolutional(conv, { 256, 128, 3, 3 });
+            auto smallBoxes = Convolutional(conv, { 3 * (classCount + 5), 256, 1, 1 }, false, Activation::None);
+
+            conv = Convolutional(route1, { 256, 128, 3, 3 }, true);
+            conv = Join(conv, route2);
+
+            conv = Convolutional(conv, { 256, 512, 1, 1 });
+            conv = Convolutional(conv, { 512, 256, 3, 3 });
+            conv = Convolutional(conv, { 256, 512, 1, 1 });
+            conv = Convolutional(conv, { 512, 256, 3, 3 });
+            conv = Convolutional(conv, { 256, 512, 1, 1 });
+
+            route2 = conv;
+            conv = Convolutional(conv, { 512, 256, 3, 3 });
+            auto mediumBoxes = Convolutional(conv, { 3 * (classCount + 5), 512, 1, 1 }, false, Activation::None);
+
+            conv = Convolutional(route2, { 512, 256, 3, 3 }, true);
+            conv = Join(conv, route);
+
+            conv = Convolutional(conv, { 512, 1024, 1, 1 });
+            conv = Convolutional(conv, { 1024, 512, 3, 3 });
+            conv = Convolutional(conv, { 512, 1024, 1, 1 });
+            conv = Convolutional(conv, { 1024, 512, 3, 3 });
+            conv = Convolutional(conv, { 512, 1024, 1, 1 });
+
+            conv = Convolutional(conv, { 1024, 512, 3, 3 });
+            auto largeBoxes = Convolutional(conv, { 3 * (classCount + 5), 1024, 1, 1 }, false, Activation::None);
+
+            m_outputs.smallBoxes = DecodeOutput(smallBoxes, classCount);
+            m_outputs.mediumBoxes = DecodeOutput(mediumBoxes, classCount);
+            m_outputs.largeBoxes = DecodeOutput(largeBoxes, classCount);
+        }
+
+        const Outputs& GetOutputs() const { return m_outputs; }
+
+        // One entry per convolution, in the order they were built.
+        const std::vector<ConvolutionLayer>& GetConvolutionLayers() const { return m_convolutionLayers; }
+
+    private:
+        struct Backbone
+        {
+            dml::Expression route1;
+            dml::Expression route2;
+            dml::Expression conv;
+        };
+
+        enum class Activation
+        {
+            None,
+            LeakyRelu,
+            Mish,
+        };
+
+        static dml::Expression Mish(dml::Expression x)
+        {
+            return x * dml::ActivationTanh(dml::ActivationSoftplus(x));
+        }
+
+        static dml::Expression Join(dml::Expression a, dml::Expression b)
+        {
+            const dml::Expression inputs[] = { a, b };
+            return dml::Join(inputs, 1);
+        }
+
+        dml::Expression Convolutional(
+            dml::Expression input,
+            dml::TensorDimensions filterSizes,
+            bool downsample = false,
+            Activation activation = Activation::LeakyRelu)
+        {
+            dml::Expression filter = dml::InputTensor(m_graph, m_inputCount++, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, filterSizes));
+            dml::Expression bias = dml::InputTensor(m_graph, m_inputCount++, dml::TensorDesc(DML_TENSOR_DATA_TYPE_FLOAT32, { 1, filterSizes[0], 1, 1 }));
+
+            const uint32_t stride = downsample ? 2 : 1;
+            const uint32_t padding = filterSizes[2] / 2;
+            m_convolutionLayers.push_back(ConvolutionLayer{ input.GetOutputDesc().sizes, filterSizes, stride, padding });
+
+            const uint32_t strides[] = { stride, stride };
+            const uint32_t paddings[] = { padding, padding };
+            auto conv = dml::ConvolutionBuilder(input, filter, bias)
+                .StartPadding(paddings)
+                .EndPadding(paddings)
+                .Strides(strides)
+                .FusedActivation(activation == Activation::LeakyRelu ? dml::FusedActivation::LeakyRelu(0.1f) : dml::FusedActivation::None())
+                .Build();
+
+            return activation == Activation::Mish ? Mish(conv) : conv;
+        }
+
+        dml::Expression ResidualBlock(dml::Expression input, uint32_t inputChannel, uint32_t filterCount1, uint32_t filterCount2)
+        {
+            auto conv = Convolutional(input, { filterCount1, inputChannel, 1, 1 }, false, Activation::Mish);
+            conv = Convolutional(conv, { filterCount2, filterCount1, 3, 3 }, false, Activation::Mish);
+            return input + conv;
+        }
+
+        static dml::Expression MaxPool(dml::Expression input, uint32_t window)
+        {
+            const uint32_t windowSize[] = { window, window };
+            const uint32_t strides[] = { 1, 1 };
+            const uint32_t padding[] = { window / 2, window / 2 };
+            return dml::MaxPoolingBuilder(input, windowSize)
+                .Strides(strides)
+                .StartPadding(padding)
+                .EndPadding(padding)
+                .Build()
+                .values;
+        }
+
+        static dml::Expression Upsample(dml::Expression input)
+        {
+            return dml::Upsample2D(input, DML_SIZE_2D{ 2, 2 }, DML_INTERPOLATION_MODE_NEAREST_NEIGHBOR);
+        }
+
+        // A stage of CSPDarknet53: a downsampling convolution, then a residual path and a shortcut route that are
+        // joined and mixed.
+        dml::Expression CspStage(dml::Expression input, uint32_t inputChannel, uint32_t channel, uint32_t residualCount, bool halfRoute)
+        {
+            const uint32_t routeChannel = halfRoute ? channel / 2 : channel;
+            input = Convolutional(input, { channel, inputChannel, 3, 3 }, true, Activation::Mish);
+            auto route = Convolutional(input, { routeChannel, channel, 1, 1 }, false, Activation::Mish);
+            input = Convolutional(input, { routeChannel, channel, 1, 1 }, false, Activation::Mish);
+            for (uint32_t i = 0; i < residualCount; ++i)
+            {
+                input = ResidualBlock(input, routeChannel, halfRoute ? routeChannel : channel / 2, routeChannel);
+            }
+            input = Convolutional(input, { routeChannel, routeChannel, 1, 1 }, false, Activation::Mish);
+            input = Join(input, route);
+            return Convolutional(input, { channel, routeChannel * 2, 1, 1 }, false, Activation::Mish);
+        }
+
+        Backbone CspDarknet53(dml::Expression input)
+        {
+            input = Convolutional(input, { 32, 3, 3, 3 }, false, Activation::Mish);
+            input = CspStage(input, 32, 64, 1, false);
+            input = CspStage(input, 64, 128, 2, true);
+            input = CspStage(input, 128, 256, 8, true);
+            auto route1 = input;
+            input = CspStage(input, 256, 512, 8, true);
+            auto route2 = input;
+            input = CspStage(input, 512, 1024, 4, true);
+
+            input = Convolutional(input, { 512, 1024, 1, 1 });
+            input = Convolutional(input, { 1024, 512, 3, 3 });
+            input = Convolutional(input, { 512, 1024, 1, 1 });
+
+            const dml::Expression pools[] = { MaxPool(input, 13), MaxPool(input, 9), MaxPool(input, 5), input };
+            input = dml::Join(pools, 1);
+
+            input = Convolutional(input, { 512, 2048, 1, 1 });
+            input = Convolutional(input, { 1024, 512, 3, 3 });
+            input = Convolutional(input, { 512, 1024, 1, 1 });
+
+            return Backbone{ route1, route2, input };
+        }
+
+        // Takes a tensor of size [1, 3 * (5 + classCount), H, W] and returns a tensor of size [3, 5 + classCount, H, W],
+        // with sigmoid applied to the channels that represent probabilities.
+        static dml::Expression DecodeOutput(dml::Expression output, uint32_t classCount)
+        {
+            const dml::TensorDimensions sizes = output.GetOutputDesc().sizes;
+            output = dml::Reinterpret(output, { 3, classCount + 5, sizes[2], sizes[3] }, dml::NullOpt);
+
+            const uint32_t splitSizes[] = { 2, 2, 1 + classCount };
+            std::vector<dml::Expression> split = dml::Split(output, 1, splitSizes);
+
+            const dml::Expression decoded[] = {
+                dml::ActivationSigmoid(split[0]),
+                dml::Exp(split[1]),
+                dml::ActivationSigmoid(split[2]) };
+            return dml::Join(decoded, 1);
+        }
+
+        dml::Graph& m_graph;
+        uint32_t m_inputCount = 0;
+        std::vector<ConvolutionLayer> m_convolutionLayers;
+        Outputs m_outputs;
+    };
+}
@@ -40,6 +40,12 @@ namespace py = pybind11;
 #include <DirectML.h>
 #include <DirectMLX.h>
 
+// Convert Python sequences to and from DirectMLX's inline small vectors, as pybind11/stl.h does for std::vector.
+namespace pybind11 { namespace detail {
+    template <typename T, size_t N>
+    struct type_caster<dml::detail::small_vector<T, N>> : list_caster<dml::detail::small_vector<T, N>, T> {};
+}}
+
 #define IID_GRAPHICS_PPV_ARGS IID_PPV_ARGS
 #include "d3dx12.h"
 #include "util.h"
@@ -183,7 +183,8 @@ void FillGpuBuffer(
 
 void WaitForQueueToComplete(ID3D12CommandQueue* queue);
 
-inline std::string UintVectorToString(std::vector<uint32_t> const& v)
+template <typename Container>
+inline std::string UintVectorToString(Container const& v)
 {
     if (v.empty())
         return std::string();